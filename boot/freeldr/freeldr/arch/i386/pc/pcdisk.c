@@ -76,6 +76,12 @@ typedef struct
 
 #include <poppack.h>
 
+/*
+ * Largest number of blocks a single INT 13h extended read may transfer.
+ * Phoenix EDD limits it to 7Fh and some BIOSes fail larger requests.
+ */
+#define MAX_LBA_BLOCK_COUNT 0x7F
+
 typedef struct _PC_DISK_DRIVE
 {
     /* Disk geometry (legacy BIOS and INT13 extended) */
@@ -554,72 +560,109 @@ PcDiskDriveNumberToDrive(IN UCHAR DriveNumber)
 #endif /* CACHE_MULTI_DRIVES */
 }
 
+static ULONG
+PcDiskGetBytesPerSector(
+    IN PPC_DISK_DRIVE DiskDrive)
+{
+    if (DiskDrive->ExtGeometry.Size == sizeof(DiskDrive->ExtGeometry))
+        return DiskDrive->ExtGeometry.BytesPerSector;
+    else
+        return DiskDrive->Geometry.BytesPerSector;
+}
+
 static BOOLEAN
 PcDiskReadLogicalSectorsLBA(
     IN UCHAR DriveNumber,
+    IN PPC_DISK_DRIVE DiskDrive,
     IN ULONGLONG SectorNumber,
     IN ULONG SectorCount,
     OUT PVOID Buffer)
 {
     REGS RegsIn, RegsOut;
     ULONG RetryCount;
+    ULONG BlockCount, MaxBlockCount;
+    ULONG BytesPerSector;
     PI386_DISK_ADDRESS_PACKET Packet = (PI386_DISK_ADDRESS_PACKET)(BIOSCALLBUFFER);
 
-    /* Setup disk address packet */
-    RtlZeroMemory(Packet, sizeof(*Packet));
-    Packet->PacketSize = sizeof(*Packet);
-    Packet->Reserved = 0;
-    Packet->LBABlockCount = (USHORT)SectorCount;
-    ASSERT(Packet->LBABlockCount == SectorCount);
-    Packet->TransferBufferOffset = ((ULONG_PTR)Buffer) & 0x0F;
-    Packet->TransferBufferSegment = (USHORT)(((ULONG_PTR)Buffer) >> 4);
-    Packet->LBAStartBlock = SectorNumber;
+    BytesPerSector = PcDiskGetBytesPerSector(DiskDrive);
+    if (BytesPerSector == 0)
+        return FALSE;
 
-    /*
-     * BIOS int 0x13, function 42h - IBM/MS INT 13 Extensions - EXTENDED READ
-     * Return:
-     * CF clear if successful
-     * AH = 00h
-     * CF set on error
-     * AH = error code
-     * Disk address packet's block count field set to the
-     * number of blocks successfully transferred.
-     */
-    RegsIn.b.ah = 0x42;                 // Subfunction 42h
-    RegsIn.b.dl = DriveNumber;          // Drive number in DL (0 - floppy, 0x80 - harddisk)
-    RegsIn.x.ds = BIOSCALLBUFSEGMENT;   // DS:SI -> disk address packet
-    RegsIn.w.si = BIOSCALLBUFOFFSET;
+    /* The transfer buffer is addressed as seg:off and must not wrap its segment */
+    MaxBlockCount = min(MAX_LBA_BLOCK_COUNT, MAX_DISKREADBUFFER_SIZE / BytesPerSector);
+    if (MaxBlockCount == 0)
+        MaxBlockCount = 1;
 
-    /* Retry 3 times */
-    for (RetryCount = 0; RetryCount < 3; ++RetryCount)
+    while (SectorCount > 0)
     {
-        Int386(0x13, &RegsIn, &RegsOut);
+        /* Transfer as many blocks as the BIOS allows in one call */
+        BlockCount = min(SectorCount, MaxBlockCount);
+
+        /* Setup disk address packet */
+        RtlZeroMemory(Packet, sizeof(*Packet));
+        Packet->PacketSize = sizeof(*Packet);
+        Packet->Reserved = 0;
+        Packet->LBABlockCount = (USHORT)BlockCount;
+        Packet->TransferBufferOffset = ((ULONG_PTR)Buffer) & 0x0F;
+        Packet->TransferBufferSegment = (USHORT)(((ULONG_PTR)Buffer) >> 4);
+        Packet->LBAStartBlock = SectorNumber;
 
-        /* If it worked return TRUE */
-        if (INT386_SUCCESS(RegsOut))
-        {
-            return TRUE;
-        }
-        /* If it was a corrected ECC error then the data is still good */
-        else if (RegsOut.b.ah == 0x11)
+        /*
+         * BIOS int 0x13, function 42h - IBM/MS INT 13 Extensions - EXTENDED READ
+         * Return:
+         * CF clear if successful
+         * AH = 00h
+         * CF set on error
+         * AH = error code
+         * Disk address packet's block count field set to the
+         * number of blocks successfully transferred.
+         */
+        RegsIn.b.ah = 0x42;                 // Subfunction 42h
+        RegsIn.b.dl = DriveNumber;          // Drive number in DL (0 - floppy, 0x80 - harddisk)
+        RegsIn.x.ds = BIOSCALLBUFSEGMENT;   // DS:SI -> disk address packet
+        RegsIn.w.si = BIOSCALLBUFOFFSET;
+
+        /* Retry 3 times */
+        for (RetryCount = 0; RetryCount < 3; ++RetryCount)
         {
-            return TRUE;
+            Int386(0x13, &RegsIn, &RegsOut);
+
+            /* If it worked break out */
+            if (INT386_SUCCESS(RegsOut))
+            {
+                break;
+            }
+            /* If it was a corrected ECC error then the data is still good */
+            else if (RegsOut.b.ah == 0x11)
+            {
+                break;
+            }
+            /* If it failed then do the next retry */
+            else
+            {
+                /* The packet may have been updated with a partial count */
+                Packet->LBABlockCount = (USHORT)BlockCount;
+                DiskResetController(DriveNumber);
+                continue;
+            }
         }
-        /* If it failed then do the next retry */
-        else
+
+        /* If we retried 3 times then fail */
+        if (RetryCount >= 3)
         {
-            DiskResetController(DriveNumber);
-            continue;
+            DiskError("Disk Read Failed in LBA mode", RegsOut.b.ah);
+            ERR("Disk Read Failed in LBA mode: %x (%s) (DriveNumber: 0x%x SectorNumber: %I64d SectorCount: %d)\n",
+                RegsOut.b.ah, DiskGetErrorCodeString(RegsOut.b.ah),
+                DriveNumber, SectorNumber, BlockCount);
+            return FALSE;
         }
-    }
 
-    /* If we get here then the read failed */
-    DiskError("Disk Read Failed in LBA mode", RegsOut.b.ah);
-    ERR("Disk Read Failed in LBA mode: %x (%s) (DriveNumber: 0x%x SectorNumber: %I64d SectorCount: %d)\n",
-        RegsOut.b.ah, DiskGetErrorCodeString(RegsOut.b.ah),
-        DriveNumber, SectorNumber, SectorCount);
+        Buffer = (PVOID)((ULONG_PTR)Buffer + (BlockCount * BytesPerSector));
+        SectorCount -= BlockCount;
+        SectorNumber += BlockCount;
+    }
 
-    return FALSE;
+    return TRUE;
 }
 
 static BOOLEAN
@@ -777,7 +820,7 @@ PcDiskReadLogicalSectors(
     {
         /* LBA is easy, nothing to calculate. Just do the read. */
         TRACE("--> Using LBA\n");
-        return PcDiskReadLogicalSectorsLBA(DriveNumber, SectorNumber, SectorCount, Buffer);
+        return PcDiskReadLogicalSectorsLBA(DriveNumber, DiskDrive, SectorNumber, SectorCount, Buffer);
     }
     else
     {
@@ -827,19 +870,30 @@ ULONG
 PcDiskGetCacheableBlockCount(UCHAR DriveNumber)
 {
     PPC_DISK_DRIVE DiskDrive;
+    ULONG BytesPerSector;
 
     DiskDrive = PcDiskDriveNumberToDrive(DriveNumber);
     if (!DiskDrive)
         return 1; // Unknown count.
 
     /*
-     * If LBA is supported then the block size will be 64 sectors (32k).
+     * If LBA is supported then the block size will be the largest single
+     * transfer, bounded by the BIOS limit and the disk read buffer every
+     * cached block goes through.
      * If not then the block size is the size of one track.
      */
     if (DiskDrive->Int13ExtensionsSupported)
-        return 64;
+    {
+        BytesPerSector = PcDiskGetBytesPerSector(DiskDrive);
+        if ((BytesPerSector == 0) || (BytesPerSector > DiskReadBufferSize))
+            return 1;
+
+        return min(MAX_LBA_BLOCK_COUNT, DiskReadBufferSize / BytesPerSector);
+    }
     else
+    {
         return DiskDrive->Geometry.Sectors;
+    }
 }
 
 /* EOF */
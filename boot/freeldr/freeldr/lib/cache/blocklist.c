@@ -43,6 +43,10 @@ PCACHE_BLOCK CacheInternalGetBlockPointer(PCACHE_DRIVE CacheDrive, ULONG BlockNu
     TRACE("Cache miss! BlockNumber: %d\n", BlockNumber);
 
     CacheBlock = CacheInternalAddBlockToCache(CacheDrive, BlockNumber);
+    if (CacheBlock == NULL)
+    {
+        return NULL;
+    }
 
     // Optimize the block list so it has a LRU structure
     CacheInternalOptimizeBlockList(CacheDrive, CacheBlock);
@@ -156,7 +160,7 @@ BOOLEAN CacheInternalFreeBlock(PCACHE_DRIVE CacheDrive)
 
     // No blocks left in cache that can be freed
     // so just return
-    if (IsListEmpty(&CacheDrive->CacheBlockHead))
+    if (&CacheBlockToFree->ListEntry == &CacheDrive->CacheBlockHead)
     {
         return FALSE;
     }
@@ -71,6 +71,9 @@ PEXT2_VOLUME_INFO Ext2Volumes[MAX_FDS];
 #define TAG_EXT_GROUP_DESC 'GtxE'
 #define TAG_EXT_VOLUME 'VtxE'
 
+// Largest number of contiguous blocks read at once, keeps the byte count of a read within a ULONG
+#define EXT2_MAX_RUN_LENGTH 0x1000
+
 BOOLEAN Ext2OpenVolume(PEXT2_VOLUME_INFO Volume)
 {
     TRACE("Ext2OpenVolume() DeviceId = %d\n", Volume->DeviceId);
@@ -364,6 +367,7 @@ BOOLEAN Ext2ReadFileBig(PEXT2_FILE_INFO Ext2FileInfo, ULONGLONG BytesToRead, ULO
     ULONG                OffsetInBlock;
     ULONG                LengthInBlock;
     ULONG                NumberOfBlocks;
+    ULONG                RunLength;
 
     TRACE("Ext2ReadFileBig() BytesToRead = %d Buffer = 0x%x\n", (ULONG)BytesToRead, Buffer);
 
@@ -495,21 +499,55 @@ BOOLEAN Ext2ReadFileBig(PEXT2_FILE_INFO Ext2FileInfo, ULONGLONG BytesToRead, ULO
             BlockNumberIndex = (ULONG)(Ext2FileInfo->FilePointer / Volume->BlockSizeInBytes);
             BlockNumber = Ext2FileInfo->FileBlockList[BlockNumberIndex];
 
+            //
+            // Gather the blocks that follow this one on the disk so
+            // that the whole extent is read at once (sparse blocks
+            // are handled one by one by Ext2ReadBlock)
+            //
+            RunLength = 1;
+            if (BlockNumber != 0)
+            {
+                while ((RunLength < NumberOfBlocks) &&
+                       (RunLength < EXT2_MAX_RUN_LENGTH) &&
+                       (Ext2FileInfo->FileBlockList[BlockNumberIndex + RunLength] == BlockNumber + RunLength))
+                {
+                    RunLength++;
+                }
+            }
+
             //
             // Now do the read and update BytesRead, BytesToRead, FilePointer, & Buffer
             //
-            if (!Ext2ReadBlock(Volume, BlockNumber, Buffer))
+            if (RunLength == 1)
             {
-                return FALSE;
+                if (!Ext2ReadBlock(Volume, BlockNumber, Buffer))
+                {
+                    return FALSE;
+                }
+            }
+            else
+            {
+                if ((BlockNumber + RunLength - 1) > Volume->SuperBlock->total_blocks)
+                {
+                    FileSystemError("Error reading blocks - block out of range.");
+                    return FALSE;
+                }
+                if (!Ext2ReadVolumeSectors(Volume,
+                                           (ULONGLONG)BlockNumber * Volume->BlockSizeInSectors,
+                                           RunLength * Volume->BlockSizeInSectors,
+                                           Buffer))
+                {
+                    return FALSE;
+                }
             }
             if (BytesRead != NULL)
             {
-                *BytesRead += Volume->BlockSizeInBytes;
+                *BytesRead += RunLength * Volume->BlockSizeInBytes;
             }
-            BytesToRead -= Volume->BlockSizeInBytes;
-            Ext2FileInfo->FilePointer += Volume->BlockSizeInBytes;
-            Buffer = (PVOID)((ULONG_PTR)Buffer + Volume->BlockSizeInBytes);
-            NumberOfBlocks--;
+            BytesToRead -= RunLength * Volume->BlockSizeInBytes;
+            Ext2FileInfo->FilePointer += RunLength * Volume->BlockSizeInBytes;
+            Buffer = (PVOID)((ULONG_PTR)Buffer + RunLength * Volume->BlockSizeInBytes);
+            NumberOfBlocks -= RunLength;
         }
     }
 
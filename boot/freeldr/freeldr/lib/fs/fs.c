@@ -30,6 +30,11 @@ DBG_DEFAULT_CHANNEL(FILESYSTEM);
 #define TAG_DEVICE_NAME 'NDsF'
 #define TAG_DEVICE 'vDsF'
 
+/* Debug builds log the time spent in every file from open to close (in TSC cycles) */
+#if DBG && !defined(_M_ARM)
+#define FS_LOAD_LOG
+#endif
+
 typedef struct tagFILEDATA
 {
     ULONG DeviceId;
@@ -37,6 +42,12 @@ typedef struct tagFILEDATA
     const DEVVTBL* FuncTable;
     const DEVVTBL* FileFuncTable;
     VOID* Specific;
+#ifdef FS_LOAD_LOG
+    ULONGLONG OpenTime;
+    ULONG BytesRead;
+    ULONG ReadCount;
+    CHAR FileName[32];
+#endif
 } FILEDATA;
 
 typedef struct tagDEVICE
@@ -51,6 +62,11 @@ typedef struct tagDEVICE
 static FILEDATA FileData[MAX_FDS];
 static LIST_ENTRY DeviceListHead;
 
+#ifdef FS_LOAD_LOG
+static ULONGLONG TotalLoadTime;
+static ULONGLONG TotalBytesRead;
+#endif
+
 /* ARC FUNCTIONS **************************************************************/
 
 ARC_STATUS ArcOpen(CHAR* Path, OPENMODE OpenMode, ULONG* FileId)
@@ -203,6 +219,15 @@ ARC_STATUS ArcOpen(CHAR* Path, OPENMODE OpenMode, ULONG* FileId)
         FileName++;
 
     /* Open the file */
+#ifdef FS_LOAD_LOG
+    FileData[i].OpenTime = __rdtsc();
+    FileData[i].BytesRead = 0;
+    FileData[i].ReadCount = 0;
+    p = strrchr(FileName, '\\');
+    p = (p ? p + 1 : FileName);
+    strncpy(FileData[i].FileName, p, sizeof(FileData[i].FileName) - 1);
+    FileData[i].FileName[sizeof(FileData[i].FileName) - 1] = ANSI_NULL;
+#endif
     FileData[i].FuncTable = FileData[DeviceId].FileFuncTable;
     FileData[i].DeviceId = DeviceId;
     *FileId = i;
@@ -210,6 +235,9 @@ ARC_STATUS ArcOpen(CHAR* Path, OPENMODE OpenMode, ULONG* FileId)
     if (Status != ESUCCESS)
     {
         FileData[i].FuncTable = NULL;
+#ifdef FS_LOAD_LOG
+        FileData[i].FileName[0] = ANSI_NULL;
+#endif
         *FileId = MAX_FDS;
     }
     return Status;
@@ -224,6 +252,21 @@ ARC_STATUS ArcClose(ULONG FileId)
 
     Status = FileData[FileId].FuncTable->Close(FileId);
 
+#ifdef FS_LOAD_LOG
+    /* Only files have a name, devices are opened without one */
+    if (FileData[FileId].FileName[0] != ANSI_NULL)
+    {
+        ULONGLONG Time = __rdtsc() - FileData[FileId].OpenTime;
+
+        TotalLoadTime += Time;
+        TotalBytesRead += FileData[FileId].BytesRead;
+        WARN("Load log: %-20s %8lu bytes in %4lu reads, %I64u cycles (total %I64u bytes, %I64u cycles)\n",
+             FileData[FileId].FileName, FileData[FileId].BytesRead, FileData[FileId].ReadCount,
+             Time, TotalBytesRead, TotalLoadTime);
+        FileData[FileId].FileName[0] = ANSI_NULL;
+    }
+#endif
+
     if (Status == ESUCCESS)
     {
         FileData[FileId].FuncTable = NULL;
@@ -235,9 +278,23 @@ ARC_STATUS ArcClose(ULONG FileId)
 
 ARC_STATUS ArcRead(ULONG FileId, VOID* Buffer, ULONG N, ULONG* Count)
 {
+#ifdef FS_LOAD_LOG
+    ARC_STATUS Status;
+#endif
+
     if (FileId >= MAX_FDS || !FileData[FileId].FuncTable)
         return EBADF;
+#ifdef FS_LOAD_LOG
+    Status = FileData[FileId].FuncTable->Read(FileId, Buffer, N, Count);
+    if (Status == ESUCCESS)
+    {
+        FileData[FileId].BytesRead += *Count;
+        FileData[FileId].ReadCount++;
+    }
+    return Status;
+#else
     return FileData[FileId].FuncTable->Read(FileId, Buffer, N, Count);
+#endif
 }
 
 ARC_STATUS ArcSeek(ULONG FileId, LARGE_INTEGER* Position, SEEKMODE SeekMode)
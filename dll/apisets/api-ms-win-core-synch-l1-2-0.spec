@@ -54,8 +54,8 @@
 @ stdcall WaitForMultipleObjectsEx() kernel32.WaitForMultipleObjectsEx
 @ stdcall WaitForSingleObject() kernel32.WaitForSingleObject
 @ stdcall WaitForSingleObjectEx() kernel32.WaitForSingleObjectEx
-@ stub WaitOnAddress
+@ stdcall -version=0x602+ WaitOnAddress() kernel32.WaitOnAddress
 @ stdcall -version=0x600+ WakeAllConditionVariable() kernel32.WakeAllConditionVariable
-@ stub WakeByAddressAll
-@ stub WakeByAddressSingle
+@ stdcall -version=0x602+ WakeByAddressAll() kernel32.WakeByAddressAll
+@ stdcall -version=0x602+ WakeByAddressSingle() kernel32.WakeByAddressSingle
 @ stdcall -version=0x600+ WakeConditionVariable() kernel32.WakeConditionVariable
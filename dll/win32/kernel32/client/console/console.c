@@ -1144,6 +1144,8 @@ CloseConsoleHandle(HANDLE hHandle)
     CONSOLE_API_MESSAGE ApiMessage;
     PCONSOLE_CLOSEHANDLE CloseHandleRequest = &ApiMessage.Data.CloseHandleRequest;
 
+    ForgetConsoleOutputRingHandle(hHandle);
+
     CloseHandleRequest->ConsoleHandle = NtCurrentPeb()->ProcessParameters->ConsoleHandle;
     CloseHandleRequest->Handle        = hHandle;
 
@@ -1460,6 +1462,9 @@ FreeConsole(VOID)
         goto Quit;
     }
 
+    /* The server unmaps the output ring from our address space */
+    ReleaseConsoleOutputRing();
+
     /* Set up the data to send to the Console Server */
     FreeConsoleRequest->ConsoleHandle = ConsoleHandle;
 
@@ -25,6 +25,23 @@
     (((Rect)->Left > (Rect)->Right) ? 0 : ((Rect)->Right - (Rect)->Left + 1))
 
 
+/* GLOBALS ********************************************************************/
+
+extern RTL_CRITICAL_SECTION ConsoleLock;
+
+/*
+ * Shared output ring (see consrv). It is mapped on the first successful
+ * write, and only used for the last output handle the server accepted.
+ */
+static PCONSOLE_OUTPUT_RING OutputRing = NULL;
+static HANDLE OutputRingEvent = NULL;
+static HANDLE OutputRingHandle = NULL;
+static BOOLEAN OutputRingUnavailable = FALSE;
+
+/* Longer strings are sent through the server, where the copy is the main cost anyway */
+#define OUTPUT_RING_MAX_RECORD  (CONSOLE_OUTPUT_RING_SIZE / 4)
+
+
 /* PRIVATE FUNCTIONS **********************************************************/
 
 /******************
@@ -593,6 +610,135 @@ IntReadConsoleOutputCode(IN HANDLE hConsoleOutput,
  * Write functions *
  *******************/
 
+static
+VOID
+IntMapConsoleOutputRing(IN HANDLE hConsoleOutput)
+{
+    CONSOLE_API_MESSAGE ApiMessage;
+    PCONSOLE_MAPOUTPUTRING MapOutputRingRequest = &ApiMessage.Data.MapOutputRingRequest;
+
+    RtlEnterCriticalSection(&ConsoleLock);
+
+    if (OutputRing == NULL && !OutputRingUnavailable)
+    {
+        MapOutputRingRequest->ConsoleHandle = NtCurrentPeb()->ProcessParameters->ConsoleHandle;
+
+        CsrClientCallServer((PCSR_API_MESSAGE)&ApiMessage,
+                            NULL,
+                            CSR_CREATE_API_NUMBER(CONSRV_SERVERDLL_INDEX, ConsolepMapOutputRing),
+                            sizeof(*MapOutputRingRequest));
+        if (NT_SUCCESS(ApiMessage.Status))
+        {
+            OutputRing      = MapOutputRingRequest->Ring;
+            OutputRingEvent = MapOutputRingRequest->Event;
+        }
+        else
+        {
+            /* Do not retry for every write */
+            OutputRingUnavailable = TRUE;
+        }
+    }
+
+    if (OutputRing != NULL) OutputRingHandle = hConsoleOutput;
+
+    RtlLeaveCriticalSection(&ConsoleLock);
+}
+
+static
+BOOLEAN
+IntWriteConsoleRing(IN HANDLE hConsoleOutput,
+                    IN PVOID lpBuffer,
+                    IN ULONG SizeBytes,
+                    IN BOOLEAN bUnicode)
+{
+    BOOLEAN Success = FALSE;
+    PCONSOLE_OUTPUT_RING Ring;
+    PCONSOLE_OUTPUT_RING_RECORD Record;
+    ULONG WriteOffset, Position, Padding, Length;
+
+    if (SizeBytes == 0 || SizeBytes > OUTPUT_RING_MAX_RECORD ||
+        hConsoleOutput != OutputRingHandle)
+    {
+        return FALSE;
+    }
+
+    Length = ALIGN_UP_BY(sizeof(*Record) + SizeBytes, CONSOLE_OUTPUT_RING_ALIGNMENT);
+
+    RtlEnterCriticalSection(&ConsoleLock);
+
+    Ring = OutputRing;
+    if (Ring == NULL || hConsoleOutput != OutputRingHandle)
+        goto Quit;
+
+    /* Records are never split: pad up to the end of the ring if needed */
+    WriteOffset = Ring->WriteOffset;
+    Position = WriteOffset & (CONSOLE_OUTPUT_RING_SIZE - 1);
+    Padding  = (Length > CONSOLE_OUTPUT_RING_SIZE - Position) ? (CONSOLE_OUTPUT_RING_SIZE - Position) : 0;
+
+    /* Fall back to the server if the ring is full */
+    if (Padding + Length > CONSOLE_OUTPUT_RING_SIZE - (WriteOffset - Ring->ReadOffset))
+        goto Quit;
+
+    Record = (PCONSOLE_OUTPUT_RING_RECORD)&Ring->Data[(Position + Padding) & (CONSOLE_OUTPUT_RING_SIZE - 1)];
+
+    _SEH2_TRY
+    {
+        RtlCopyMemory(Record + 1, lpBuffer, SizeBytes);
+        Success = TRUE;
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        /* Let the server path report the error */
+    }
+    _SEH2_END;
+
+    if (!Success) goto Quit;
+
+    if (Padding != 0)
+    {
+        PCONSOLE_OUTPUT_RING_RECORD PadRecord = (PCONSOLE_OUTPUT_RING_RECORD)&Ring->Data[Position];
+        PadRecord->Length   = Padding;
+        PadRecord->NumBytes = 0;
+    }
+
+    Record->Length       = Length;
+    Record->NumBytes     = SizeBytes;
+    Record->OutputHandle = HandleToULong(hConsoleOutput);
+    Record->Unicode      = bUnicode;
+
+    /* Publish the record only once it is complete */
+    MemoryBarrier();
+    Ring->WriteOffset = WriteOffset + Padding + Length;
+
+    /* Wake up the server, unless it was already done and it did not drain the ring yet */
+    if (!InterlockedExchange(&Ring->WakePending, TRUE))
+        NtSetEvent(OutputRingEvent, NULL);
+
+Quit:
+    RtlLeaveCriticalSection(&ConsoleLock);
+    return Success;
+}
+
+VOID
+ForgetConsoleOutputRingHandle(IN HANDLE hConsoleOutput)
+{
+    RtlEnterCriticalSection(&ConsoleLock);
+    if (hConsoleOutput == OutputRingHandle) OutputRingHandle = NULL;
+    RtlLeaveCriticalSection(&ConsoleLock);
+}
+
+/* The console lock must be held; the server unmaps the ring when the console is freed */
+VOID
+ReleaseConsoleOutputRing(VOID)
+{
+    if (OutputRingEvent) NtClose(OutputRingEvent);
+
+    OutputRing = NULL;
+    OutputRingEvent = NULL;
+    OutputRingHandle = NULL;
+    OutputRingUnavailable = FALSE;
+}
+
 static
 BOOL
 IntWriteConsole(IN HANDLE hConsoleOutput,
@@ -625,6 +771,13 @@ IntWriteConsole(IN HANDLE hConsoleOutput,
 
     WriteConsoleRequest->NumBytes = SizeBytes;
 
+    /* Try to append the string to the shared output ring, without calling the server */
+    if (IntWriteConsoleRing(hConsoleOutput, lpBuffer, SizeBytes, bUnicode))
+    {
+        ApiMessage.Status = STATUS_SUCCESS;
+        goto Quit;
+    }
+
     /*
      * For optimization purposes, Windows (and hence ReactOS, too, for
      * compatibility reasons) uses a static buffer if no more than eighty
@@ -675,12 +828,20 @@ IntWriteConsole(IN HANDLE hConsoleOutput,
                         CSR_CREATE_API_NUMBER(CONSRV_SERVERDLL_INDEX, ConsolepWriteConsole),
                         sizeof(*WriteConsoleRequest));
 
-    /* Check for success */
-    Success = NT_SUCCESS(ApiMessage.Status);
-
     /* Release the capture buffer if needed */
     if (CaptureBuffer) CsrFreeCaptureBuffer(CaptureBuffer);
 
+    /* The server accepted this handle, the next writes can go through the ring */
+    if (NT_SUCCESS(ApiMessage.Status) &&
+        hConsoleOutput != OutputRingHandle && !OutputRingUnavailable)
+    {
+        IntMapConsoleOutputRing(hConsoleOutput);
+    }
+
+Quit:
+    /* Check for success */
+    Success = NT_SUCCESS(ApiMessage.Status);
+
     /* Retrieve the results */
     if (Success)
     {
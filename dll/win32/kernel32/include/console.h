@@ -57,6 +57,12 @@ CloseConsoleHandle(HANDLE Handle);
 HANDLE WINAPI
 GetConsoleInputWaitHandle(VOID);
 
+VOID
+ForgetConsoleOutputRingHandle(IN HANDLE hConsoleOutput);
+
+VOID
+ReleaseConsoleOutputRing(VOID);
+
 HANDLE
 TranslateStdHandle(HANDLE hHandle);
 
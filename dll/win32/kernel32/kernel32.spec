@@ -1175,7 +1175,10 @@
 @ stub -version=0x600+ WaitForThreadpoolWorkCallbacks
 @ stdcall WaitNamedPipeA (str long)
 @ stdcall WaitNamedPipeW (wstr long)
+@ stub -version=0x602+ WaitOnAddress
 @ stub -version=0x600+ WakeAllConditionVariable
+@ stub -version=0x602+ WakeByAddressAll
+@ stub -version=0x602+ WakeByAddressSingle
 @ stub -version=0x600+ WakeConditionVariable
 @ stub -version=0x600+ WerGetFlags
 @ stub -version=0x600+ WerRegisterFile
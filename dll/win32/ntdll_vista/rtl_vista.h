@@ -54,4 +54,20 @@
 #define InterlockedBitTestAndSet64 _interlockedbittestandset64
 #endif
 
+/* Address based waits, used by the condition variable and SRW lock code */
+NTSTATUS
+NTAPI
+RtlWaitOnAddress(IN volatile VOID *Address,
+                 IN PVOID CompareAddress,
+                 IN SIZE_T AddressSize,
+                 IN PLARGE_INTEGER Timeout OPTIONAL);
+
+VOID
+NTAPI
+RtlWakeAddressSingle(IN PVOID Address);
+
+VOID
+NTAPI
+RtlWakeAddressAll(IN PVOID Address);
+
 #endif /* RTL_H */
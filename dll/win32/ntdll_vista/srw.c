@@ -44,6 +44,9 @@
                              RTL_SRWLOCK_SHARED | RTL_SRWLOCK_CONTENTION_LOCK)
 #define RTL_SRWLOCK_BITS    4
 
+/* Number of polls of the wake flag before blocking on its address */
+#define RTL_SRWLOCK_SPIN_COUNT  1024
+
 typedef struct _RTLP_SRWLOCK_SHARED_WAKE
 {
     LONG Wake;
@@ -78,6 +81,36 @@ typedef struct _RTLP_SRWLOCK_WAITBLOCK
 } volatile RTLP_SRWLOCK_WAITBLOCK, *PRTLP_SRWLOCK_WAITBLOCK;
 
 
+static VOID
+RtlpWaitForSRWLockWake(IN volatile LONG *Wake,
+                       IN OUT PULONG SpinCount)
+{
+    static const LONG NoWake = 0;
+
+    /* Wait blocks are usually released quickly, so poll for a while
+       before going to sleep until the flag is set */
+    if (++(*SpinCount) < RTL_SRWLOCK_SPIN_COUNT)
+    {
+        YieldProcessor();
+        return;
+    }
+
+    RtlWaitOnAddress(Wake, (PVOID)&NoWake, sizeof(NoWake), NULL);
+}
+
+
+static VOID
+RtlpSetSRWLockWake(IN volatile LONG *Wake)
+{
+    (void)InterlockedOr((PLONG)Wake,
+                        TRUE);
+
+    /* The waiter may have returned already and its wait block is
+       gone. That's fine, the address is only used as a key. */
+    RtlWakeAddressSingle((PVOID)Wake);
+}
+
+
 static VOID
 NTAPI
 RtlpReleaseWaitBlockLockExclusive(IN OUT PRTL_SRWLOCK SRWLock,
@@ -125,8 +158,7 @@ RtlpReleaseWaitBlockLockExclusive(IN OUT PRTL_SRWLOCK SRWLock,
 
     if (FirstWaitBlock->Exclusive)
     {
-        (void)InterlockedOr(&FirstWaitBlock->Wake,
-                            TRUE);
+        RtlpSetSRWLockWake(&FirstWaitBlock->Wake);
     }
     else
     {
@@ -139,8 +171,7 @@ RtlpReleaseWaitBlockLockExclusive(IN OUT PRTL_SRWLOCK SRWLock,
         {
             NextWake = WakeChain->Next;
 
-            (void)InterlockedOr((PLONG)&WakeChain->Wake,
-                                TRUE);
+            RtlpSetSRWLockWake(&WakeChain->Wake);
 
             WakeChain = NextWake;
         } while (WakeChain != NULL);
@@ -178,8 +209,7 @@ RtlpReleaseWaitBlockLockLastShared(IN OUT PRTL_SRWLOCK SRWLock,
 
     (void)InterlockedExchangePointer(&SRWLock->Ptr, (PVOID)NewValue);
 
-    (void)InterlockedOr(&FirstWaitBlock->Wake,
-                        TRUE);
+    RtlpSetSRWLockWake(&FirstWaitBlock->Wake);
 }
 
 
@@ -231,6 +261,7 @@ RtlpAcquireSRWLockExclusiveWait(IN OUT PRTL_SRWLOCK SRWLock,
                                 IN PRTLP_SRWLOCK_WAITBLOCK WaitBlock)
 {
     LONG_PTR CurrentValue;
+    ULONG SpinCount = 0;
 
     while (1)
     {
@@ -255,7 +286,7 @@ RtlpAcquireSRWLockExclusiveWait(IN OUT PRTL_SRWLOCK SRWLock,
             }
         }
 
-        YieldProcessor();
+        RtlpWaitForSRWLockWake(&WaitBlock->Wake, &SpinCount);
     }
 }
 
@@ -266,11 +297,13 @@ RtlpAcquireSRWLockSharedWait(IN OUT PRTL_SRWLOCK SRWLock,
                              IN OUT PRTLP_SRWLOCK_WAITBLOCK FirstWait  OPTIONAL,
                              IN OUT PRTLP_SRWLOCK_SHARED_WAKE WakeChain)
 {
+    ULONG SpinCount = 0;
+
     if (FirstWait != NULL)
     {
         while (WakeChain->Wake == 0)
         {
-            YieldProcessor();
+            RtlpWaitForSRWLockWake(&WakeChain->Wake, &SpinCount);
         }
     }
     else
@@ -304,7 +337,7 @@ RtlpAcquireSRWLockSharedWait(IN OUT PRTL_SRWLOCK SRWLock,
                 }
             }
 
-            YieldProcessor();
+            RtlpWaitForSRWLockWake(&WakeChain->Wake, &SpinCount);
         }
     }
 }
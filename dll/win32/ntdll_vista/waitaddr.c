@@ -0,0 +1,280 @@
+/*
+ * PROJECT:     ReactOS system libraries
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Address based wait and wake routines
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* NOTE: Waiters are queued in FIFO order on a hashed table of wait buckets.
+   Each waiter blocks on the process keyed event, using its own wait block
+   as the key, so that a wake only ever releases the threads it dequeued.
+   The compared value is read with the bucket locked and the waiter already
+   queued, which closes the window against a concurrent change and wake. */
+
+/* INCLUDES ******************************************************************/
+
+#include <rtl_vista.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/* INTERNAL TYPES ************************************************************/
+
+#define RTLP_WAIT_BUCKET_COUNT      128
+#define RTLP_WAIT_BUCKET_SPIN       64
+
+typedef struct _RTLP_ADDRESS_WAIT_BLOCK
+{
+    LIST_ENTRY ListEntry;
+    volatile VOID *Address;
+    BOOLEAN Queued;
+} RTLP_ADDRESS_WAIT_BLOCK, *PRTLP_ADDRESS_WAIT_BLOCK;
+
+typedef struct DECLSPEC_CACHEALIGN _RTLP_ADDRESS_WAIT_BUCKET
+{
+    LONG Lock;
+    LONG WaiterCount;
+    LIST_ENTRY WaitList;
+} RTLP_ADDRESS_WAIT_BUCKET, *PRTLP_ADDRESS_WAIT_BUCKET;
+
+/* GLOBALS *******************************************************************/
+
+static HANDLE WaitOnAddressKeyedEventHandle = NULL;
+static RTLP_ADDRESS_WAIT_BUCKET WaitBuckets[RTLP_WAIT_BUCKET_COUNT];
+
+/* INTERNAL FUNCTIONS ********************************************************/
+
+FORCEINLINE
+PRTLP_ADDRESS_WAIT_BUCKET
+RtlpGetWaitBucket(IN volatile VOID *Address)
+{
+    ULONG_PTR Hash = (ULONG_PTR)Address;
+
+    /* Neighbouring words share a bucket, distinct objects usually don't */
+    Hash = (Hash >> 3) ^ (Hash >> 10) ^ (Hash >> 17);
+    return &WaitBuckets[Hash & (RTLP_WAIT_BUCKET_COUNT - 1)];
+}
+
+static
+VOID
+RtlpAcquireWaitBucketLock(IN PRTLP_ADDRESS_WAIT_BUCKET Bucket)
+{
+    ULONG SpinCount;
+
+    while (InterlockedExchange(&Bucket->Lock, 1) != 0)
+    {
+        /* The lock is only held for a few list operations, so spin on a
+           read first and give up the processor if the owner got preempted */
+        for (SpinCount = 0; *(volatile LONG *)&Bucket->Lock != 0; SpinCount++)
+        {
+            if (SpinCount < RTLP_WAIT_BUCKET_SPIN)
+            {
+                YieldProcessor();
+            }
+            else
+            {
+                NtYieldExecution();
+                SpinCount = 0;
+            }
+        }
+    }
+}
+
+FORCEINLINE
+VOID
+RtlpReleaseWaitBucketLock(IN PRTLP_ADDRESS_WAIT_BUCKET Bucket)
+{
+    InterlockedExchange(&Bucket->Lock, 0);
+}
+
+static
+BOOLEAN
+RtlpIsAddressValueEqual(IN volatile VOID *Address,
+                        IN PVOID CompareAddress,
+                        IN SIZE_T AddressSize)
+{
+    switch (AddressSize)
+    {
+        case sizeof(UCHAR):
+            return *(volatile UCHAR *)Address == *(PUCHAR)CompareAddress;
+
+        case sizeof(USHORT):
+            return *(volatile USHORT *)Address == *(PUSHORT)CompareAddress;
+
+        case sizeof(ULONG):
+            return *(volatile ULONG *)Address == *(PULONG)CompareAddress;
+
+        default:
+            ASSERT(AddressSize == sizeof(ULONGLONG));
+            return *(volatile ULONGLONG *)Address == *(PULONGLONG)CompareAddress;
+    }
+}
+
+static
+VOID
+RtlpWakeAddress(IN PVOID Address,
+                IN BOOLEAN WakeAll)
+{
+    PRTLP_ADDRESS_WAIT_BUCKET Bucket = RtlpGetWaitBucket(Address);
+    PRTLP_ADDRESS_WAIT_BLOCK WaitBlock;
+    PLIST_ENTRY Entry, NextEntry;
+    LIST_ENTRY WakeList;
+
+    /* Order the caller's store to the address before the waiter count
+       check. Waiters increment the count before they read the value,
+       so either they see the new value or we see them. */
+    MemoryBarrier();
+    if (*(volatile LONG *)&Bucket->WaiterCount == 0)
+        return;
+
+    InitializeListHead(&WakeList);
+
+    RtlpAcquireWaitBucketLock(Bucket);
+
+    for (Entry = Bucket->WaitList.Flink;
+         Entry != &Bucket->WaitList;
+         Entry = NextEntry)
+    {
+        NextEntry = Entry->Flink;
+        WaitBlock = CONTAINING_RECORD(Entry, RTLP_ADDRESS_WAIT_BLOCK, ListEntry);
+
+        if (WaitBlock->Address != Address)
+            continue;
+
+        /* The waiter is now committed to receive a release from us */
+        RemoveEntryList(&WaitBlock->ListEntry);
+        WaitBlock->Queued = FALSE;
+        InterlockedDecrement(&Bucket->WaiterCount);
+        InsertTailList(&WakeList, &WaitBlock->ListEntry);
+
+        if (!WakeAll)
+            break;
+    }
+
+    RtlpReleaseWaitBucketLock(Bucket);
+
+    /* Dequeued waiters can't leave before they are released, so their
+       wait blocks remain valid until the release of each one returns */
+    while (!IsListEmpty(&WakeList))
+    {
+        Entry = RemoveHeadList(&WakeList);
+        WaitBlock = CONTAINING_RECORD(Entry, RTLP_ADDRESS_WAIT_BLOCK, ListEntry);
+
+        NtReleaseKeyedEvent(WaitOnAddressKeyedEventHandle,
+                            WaitBlock,
+                            FALSE,
+                            NULL);
+    }
+}
+
+VOID
+RtlpInitializeKeyedEvent(VOID)
+{
+    ULONG i;
+
+    ASSERT(WaitOnAddressKeyedEventHandle == NULL);
+
+    for (i = 0; i < RTLP_WAIT_BUCKET_COUNT; i++)
+        InitializeListHead(&WaitBuckets[i].WaitList);
+
+    /* If this fails, the NULL handle selects the global keyed event */
+    NtCreateKeyedEvent(&WaitOnAddressKeyedEventHandle, EVENT_ALL_ACCESS, NULL, 0);
+}
+
+VOID
+RtlpCloseKeyedEvent(VOID)
+{
+    if (WaitOnAddressKeyedEventHandle != NULL)
+    {
+        NtClose(WaitOnAddressKeyedEventHandle);
+        WaitOnAddressKeyedEventHandle = NULL;
+    }
+}
+
+/* EXPORTED FUNCTIONS ********************************************************/
+
+NTSTATUS
+NTAPI
+RtlWaitOnAddress(IN volatile VOID *Address,
+                 IN PVOID CompareAddress,
+                 IN SIZE_T AddressSize,
+                 IN PLARGE_INTEGER Timeout OPTIONAL)
+{
+    PRTLP_ADDRESS_WAIT_BUCKET Bucket;
+    RTLP_ADDRESS_WAIT_BLOCK WaitBlock;
+    NTSTATUS Status;
+
+    if (AddressSize != sizeof(UCHAR) &&
+        AddressSize != sizeof(USHORT) &&
+        AddressSize != sizeof(ULONG) &&
+        AddressSize != sizeof(ULONGLONG))
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Bucket = RtlpGetWaitBucket(Address);
+    WaitBlock.Address = Address;
+    WaitBlock.Queued = TRUE;
+
+    RtlpAcquireWaitBucketLock(Bucket);
+
+    InsertTailList(&Bucket->WaitList, &WaitBlock.ListEntry);
+    InterlockedIncrement(&Bucket->WaiterCount);
+
+    if (!RtlpIsAddressValueEqual(Address, CompareAddress, AddressSize))
+    {
+        /* The value already changed, don't wait at all */
+        RemoveEntryList(&WaitBlock.ListEntry);
+        InterlockedDecrement(&Bucket->WaiterCount);
+        RtlpReleaseWaitBucketLock(Bucket);
+        return STATUS_SUCCESS;
+    }
+
+    RtlpReleaseWaitBucketLock(Bucket);
+
+    Status = NtWaitForKeyedEvent(WaitOnAddressKeyedEventHandle,
+                                 &WaitBlock,
+                                 FALSE,
+                                 Timeout);
+    if (Status != STATUS_SUCCESS)
+    {
+        RtlpAcquireWaitBucketLock(Bucket);
+
+        if (WaitBlock.Queued)
+        {
+            /* Nobody woke us, leave the queue and report the timeout */
+            RemoveEntryList(&WaitBlock.ListEntry);
+            InterlockedDecrement(&Bucket->WaiterCount);
+            RtlpReleaseWaitBucketLock(Bucket);
+            return Status;
+        }
+
+        RtlpReleaseWaitBucketLock(Bucket);
+
+        /* A waker dequeued us right before the timeout and is about to
+           release our key. Consume that release, it would block forever
+           otherwise. */
+        NtWaitForKeyedEvent(WaitOnAddressKeyedEventHandle,
+                            &WaitBlock,
+                            FALSE,
+                            NULL);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+RtlWakeAddressSingle(IN PVOID Address)
+{
+    RtlpWakeAddress(Address, FALSE);
+}
+
+VOID
+NTAPI
+RtlWakeAddressAll(IN PVOID Address)
+{
+    RtlpWakeAddress(Address, TRUE);
+}
+
+/* EOF */
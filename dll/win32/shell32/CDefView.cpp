@@ -52,6 +52,292 @@ typedef struct
 } LISTVIEW_SORT_INFO, *LPLISTVIEW_SORT_INFO;
 
 #define SHV_CHANGE_NOTIFY WM_USER + 0x1111
+#define SHV_UPDATE_ICON WM_USER + 0x1112
+#define SHV_ENUM_ITEMS WM_USER + 0x1113
+#define SHV_ITEMS_SORTED WM_USER + 0x1114
+
+/* An icon that was looked up in the background, see OnUpdateIcon */
+typedef struct
+{
+    LPARAM lParam;              /* The list view item it was requested for */
+    PITEMID_CHILD pidl;
+    INT iIcon;
+} SHV_ICON_UPDATE;
+
+/* The items of a folder in the order of a column, see CListItemsTask */
+typedef struct
+{
+    LONG lColumn;
+    HDPA hdpaItems;             /* The pidls, sorted ascending */
+    UINT cBuckets;              /* Hash of the pidls to their index in hdpaItems */
+    INT *piBuckets;
+} SHV_SORT_KEYS;
+
+/* Identifies the tasks of CListItemsTask, lParam tells which kind it is */
+static const GUID TOID_DefViewList =
+    { 0x5e5e2b1c, 0x8a4f, 0x4c61, { 0x9d, 0x27, 0x3b, 0x70, 0xe4, 0x1a, 0x6c, 0x92 } };
+
+#define SHV_TASK_ENUM   1
+#define SHV_TASK_SORT   2
+
+/* The first items are handed over quickly to show something soon, later ones
+ * in bigger chunks, but not less often than every SHV_ENUM_CHUNK_TIME ms */
+#define SHV_ENUM_FIRST_CHUNK    64
+#define SHV_ENUM_MAX_CHUNK      4096
+#define SHV_ENUM_CHUNK_TIME     250
+
+static INT CALLBACK SHV_FreePidl(LPVOID ptr, LPVOID arg)
+{
+    SHFree(ptr);
+    return TRUE;
+}
+
+static UINT SortKeys_Hash(PCUITEMID_CHILD pidl)
+{
+    const BYTE *pb = reinterpret_cast<const BYTE *>(pidl);
+    UINT cb = ILGetSize(pidl), uHash = 2166136261U;
+
+    while (cb--)
+        uHash = (uHash ^ *pb++) * 16777619U;
+
+    return uHash;
+}
+
+/* Takes over hdpaItems, which must be sorted by lColumn already */
+static SHV_SORT_KEYS *SortKeys_Create(HDPA hdpaItems, LONG lColumn)
+{
+    SHV_SORT_KEYS *pKeys;
+    INT i, cItems = DPA_GetPtrCount(hdpaItems);
+    UINT iBucket;
+
+    pKeys = static_cast<SHV_SORT_KEYS *>(SHAlloc(sizeof(*pKeys)));
+    if (!pKeys)
+        return NULL;
+
+    /* Keep the table at most half full */
+    pKeys->cBuckets = 16;
+    while (pKeys->cBuckets < (UINT)cItems * 2)
+        pKeys->cBuckets *= 2;
+
+    pKeys->piBuckets = static_cast<INT *>(SHAlloc(pKeys->cBuckets * sizeof(INT)));
+    if (!pKeys->piBuckets)
+    {
+        SHFree(pKeys);
+        return NULL;
+    }
+    FillMemory(pKeys->piBuckets, pKeys->cBuckets * sizeof(INT), 0xFF);
+
+    for (i = 0; i < cItems; i++)
+    {
+        iBucket = SortKeys_Hash(static_cast<PCUITEMID_CHILD>(DPA_GetPtr(hdpaItems, i)));
+        while (pKeys->piBuckets[iBucket & (pKeys->cBuckets - 1)] != -1)
+            iBucket++;
+        pKeys->piBuckets[iBucket & (pKeys->cBuckets - 1)] = i;
+    }
+
+    pKeys->lColumn = lColumn;
+    pKeys->hdpaItems = hdpaItems;
+    return pKeys;
+}
+
+/* Returns the position of the item in the sorted list, -1 if it isn't there */
+static INT SortKeys_Lookup(const SHV_SORT_KEYS *pKeys, PCUITEMID_CHILD pidl)
+{
+    PCUITEMID_CHILD pidlKey;
+    UINT iBucket, cb = ILGetSize(pidl);
+    INT iKey;
+
+    iBucket = SortKeys_Hash(pidl);
+    while ((iKey = pKeys->piBuckets[iBucket & (pKeys->cBuckets - 1)]) != -1)
+    {
+        pidlKey = static_cast<PCUITEMID_CHILD>(DPA_GetPtr(pKeys->hdpaItems, iKey));
+        if (ILGetSize(pidlKey) == cb && !memcmp(pidlKey, pidl, cb))
+            return iKey;
+        iBucket++;
+    }
+
+    return -1;
+}
+
+static void SortKeys_Free(SHV_SORT_KEYS *pKeys)
+{
+    if (!pKeys)
+        return;
+
+    DPA_DestroyCallback(pKeys->hdpaItems, SHV_FreePidl, NULL);
+    SHFree(pKeys->piBuckets);
+    SHFree(pKeys);
+}
+
+/*
+ * Enumerates the items of a folder and/or sorts them on a task scheduler
+ * thread. Enumerated items are posted to the view in chunks as
+ * SHV_ENUM_ITEMS, and the sorted items as SHV_ITEMS_SORTED in the end, so that
+ * the view only has to look up where each of its items goes.
+ */
+class CListItemsTask :
+    public CComObjectRootEx<CComMultiThreadModelNoCS>,
+    public IRunnableTask
+{
+private:
+    CComPtr<IShellFolder> m_psf;
+    HWND m_hwnd;
+    DWORD m_dwGeneration;
+    LONG m_lColumn;             /* -1 if the items are not to be sorted */
+    DWORD m_dwEnumFlags;        /* 0 if the items are known already */
+    HDPA m_hdpaItems;
+    LONG m_lState;
+
+    static INT CALLBACK _CompareItems(LPVOID p1, LPVOID p2, LPARAM lParam)
+    {
+        CListItemsTask *pThis = reinterpret_cast<CListItemsTask *>(lParam);
+        HRESULT hr;
+
+        hr = pThis->m_psf->CompareIDs(pThis->m_lColumn,
+                                      static_cast<PCUIDLIST_RELATIVE>(p1),
+                                      static_cast<PCUIDLIST_RELATIVE>(p2));
+        if (FAILED(hr))
+            return 0;
+
+        return (SHORT)HRESULT_CODE(hr);
+    }
+
+    BOOL _PostChunk(HDPA hdpaChunk)
+    {
+        if (PostMessageW(m_hwnd, SHV_ENUM_ITEMS, m_dwGeneration, reinterpret_cast<LPARAM>(hdpaChunk)))
+            return TRUE;
+
+        DPA_DestroyCallback(hdpaChunk, SHV_FreePidl, NULL);
+        return FALSE;
+    }
+
+    void _Enumerate()
+    {
+        CComPtr<IEnumIDList> pEnumIDList;
+        PITEMID_CHILD pidl, pidlCopy;
+        HDPA hdpaChunk = NULL;
+        DWORD dwFetched, dwLastPost = GetTickCount();
+        INT cChunk = SHV_ENUM_FIRST_CHUNK;
+
+        if (m_psf->EnumObjects(m_hwnd, m_dwEnumFlags, &pEnumIDList) != S_OK)
+            return;
+
+        while (m_lState == IRTIR_TASK_RUNNING &&
+               pEnumIDList->Next(1, &pidl, &dwFetched) == S_OK && dwFetched)
+        {
+            /* The view gets a copy, this one is kept for sorting */
+            if (!hdpaChunk)
+                hdpaChunk = DPA_Create(cChunk);
+            pidlCopy = ILClone(pidl);
+            if (!hdpaChunk || !pidlCopy || DPA_AppendPtr(hdpaChunk, pidlCopy) == -1)
+                SHFree(pidlCopy);
+            if (DPA_AppendPtr(m_hdpaItems, pidl) == -1)
+                SHFree(pidl);
+
+            if (hdpaChunk &&
+                (DPA_GetPtrCount(hdpaChunk) >= cChunk || GetTickCount() - dwLastPost >= SHV_ENUM_CHUNK_TIME))
+            {
+                if (!_PostChunk(hdpaChunk))
+                    return;
+                hdpaChunk = NULL;
+                cChunk = min(cChunk * 4, SHV_ENUM_MAX_CHUNK);
+                dwLastPost = GetTickCount();
+            }
+        }
+
+        if (hdpaChunk)
+            _PostChunk(hdpaChunk);
+    }
+
+public:
+    CListItemsTask() :
+        m_hwnd(NULL),
+        m_dwGeneration(0),
+        m_lColumn(-1),
+        m_dwEnumFlags(0),
+        m_hdpaItems(NULL),
+        m_lState(IRTIR_TASK_NOT_RUNNING)
+    {
+    }
+
+    ~CListItemsTask()
+    {
+        if (m_hdpaItems)
+            DPA_DestroyCallback(m_hdpaItems, SHV_FreePidl, NULL);
+    }
+
+    /* Takes over hdpaItems, which is enumerated with dwEnumFlags if it is NULL */
+    HRESULT WINAPI Initialize(IShellFolder *psf, HWND hwnd, DWORD dwGeneration, LONG lColumn, DWORD dwEnumFlags, HDPA hdpaItems)
+    {
+        m_psf = psf;
+        m_hwnd = hwnd;
+        m_dwGeneration = dwGeneration;
+        m_lColumn = lColumn;
+        m_dwEnumFlags = hdpaItems ? 0 : dwEnumFlags;
+        m_hdpaItems = hdpaItems ? hdpaItems : DPA_Create(SHV_ENUM_MAX_CHUNK);
+        if (!m_hdpaItems)
+            return E_OUTOFMEMORY;
+
+        return S_OK;
+    }
+
+    // *** IRunnableTask methods ***
+    virtual HRESULT STDMETHODCALLTYPE Run()
+    {
+        SHV_SORT_KEYS *pKeys = NULL;
+
+        if (InterlockedCompareExchange(&m_lState, IRTIR_TASK_RUNNING, IRTIR_TASK_NOT_RUNNING) != IRTIR_TASK_NOT_RUNNING)
+            return E_FAIL;
+
+        if (m_dwEnumFlags)
+            _Enumerate();
+
+        if (m_lColumn >= 0 && m_lState == IRTIR_TASK_RUNNING)
+        {
+            DPA_Sort(m_hdpaItems, _CompareItems, reinterpret_cast<LPARAM>(this));
+            pKeys = SortKeys_Create(m_hdpaItems, m_lColumn);
+            if (pKeys)
+                m_hdpaItems = NULL;
+        }
+
+        /* This also tells the view that the enumeration is done */
+        if (InterlockedCompareExchange(&m_lState, IRTIR_TASK_FINISHED, IRTIR_TASK_RUNNING) != IRTIR_TASK_RUNNING ||
+            !PostMessageW(m_hwnd, SHV_ITEMS_SORTED, m_dwGeneration, reinterpret_cast<LPARAM>(pKeys)))
+        {
+            SortKeys_Free(pKeys);
+        }
+
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Kill(BOOL fWait)
+    {
+        InterlockedExchange(&m_lState, IRTIR_TASK_FINISHED);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Suspend()
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Resume()
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE IsRunning()
+    {
+        return m_lState;
+    }
+
+DECLARE_NOT_AGGREGATABLE(CListItemsTask)
+DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+BEGIN_COM_MAP(CListItemsTask)
+    COM_INTERFACE_ENTRY_IID(IID_IRunnableTask, IRunnableTask)
+END_COM_MAP()
+};
 
 /* For the context menu of the def view, the id of the items are based on 1 because we need
    to call TrackPopupMenu and let it use the 0 value as an indication that the menu was canceled */
@@ -105,6 +391,14 @@ class CDefView :
         DWORD                     m_grfKeyState;
         //
         CComPtr<IContextMenu>     m_pCM;
+        CComPtr<IShellTaskScheduler> m_pScheduler;     /* Looks up icons in the background */
+        CComPtr<IShellTaskScheduler> m_pListScheduler; /* Enumerates and sorts the items in the background */
+        DWORD                     m_dwListGeneration;   /* Tells results of earlier enumerations apart */
+        BOOL                      m_bEnumerating;
+        HDPA                      m_hdpaChanged;        /* Items change notifications took care of while enumerating */
+        SHV_SORT_KEYS            *m_pSortKeys;          /* Only set while the list view is sorted by them */
+        CComHeapPtr<ITEMID_CHILD> m_pidlPendingSelect;  /* Selected before it was enumerated */
+        UINT                      m_uPendingSelectFlags;
 
         BOOL                      m_isEditing;
 
@@ -115,6 +409,9 @@ class CDefView :
     private:
         HRESULT _MergeToolbar();
         BOOL _Sort();
+        HRESULT _QueueListTask(DWORD_PTR dwKind, DWORD dwEnumFlags, HDPA hdpaItems);
+        BOOL _IsChangedWhileEnumerating(PCUITEMID_CHILD pidl);
+        void _EndEnumeration();
         HRESULT _DoFolderViewCB(UINT uMsg, WPARAM wParam, LPARAM lParam);
         HRESULT _GetSnapToGrid();
 
@@ -132,11 +429,15 @@ class CDefView :
         BOOL InitList();
         HRESULT DefMessageSFVCB(UINT uMsg, WPARAM wParam, LPARAM lParam);
         static INT CALLBACK ListViewCompareItems(LPARAM lParam1, LPARAM lParam2, LPARAM lpData);
+        static INT CALLBACK ListViewCompareKeys(LPARAM lParam1, LPARAM lParam2, LPARAM lpData);
 
         PCUITEMID_CHILD _PidlByItem(int i);
         PCUITEMID_CHILD _PidlByItem(LVITEM& lvItem);
         int LV_FindItemByPidl(PCUITEMID_CHILD pidl);
+        int LV_FindInsertIndex(PCUITEMID_CHILD pidl);
         int LV_AddItem(PCUITEMID_CHILD pidl);
+        int LV_GetItemIcon(LVITEMW &lvItem);
+        static void CALLBACK LV_IconCallback(LPCITEMIDLIST pidl, LPVOID pvData, LPVOID pvHint, INT iIconIndex, INT iOpenIconIndex);
         BOOLEAN LV_DeleteItem(PCUITEMID_CHILD pidl);
         BOOLEAN LV_RenameItem(PCUITEMID_CHILD pidlOld, PCUITEMID_CHILD pidlNew);
         BOOLEAN LV_ProdItem(PCUITEMID_CHILD pidl);
@@ -273,6 +574,9 @@ class CDefView :
         LRESULT OnCommand(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
         LRESULT OnNotify(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
         LRESULT OnChangeNotify(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
+        LRESULT OnUpdateIcon(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
+        LRESULT OnEnumItems(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
+        LRESULT OnSortKeys(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
         LRESULT OnCustomItem(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
         LRESULT OnSettingChange(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
         LRESULT OnInitMenuPopup(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled);
@@ -319,6 +623,9 @@ class CDefView :
         MESSAGE_HANDLER(WM_NOTIFY, OnNotify)
         MESSAGE_HANDLER(WM_COMMAND, OnCommand)
         MESSAGE_HANDLER(SHV_CHANGE_NOTIFY, OnChangeNotify)
+        MESSAGE_HANDLER(SHV_UPDATE_ICON, OnUpdateIcon)
+        MESSAGE_HANDLER(SHV_ENUM_ITEMS, OnEnumItems)
+        MESSAGE_HANDLER(SHV_ITEMS_SORTED, OnSortKeys)
         MESSAGE_HANDLER(WM_CONTEXTMENU, OnContextMenu)
         MESSAGE_HANDLER(WM_DRAWITEM, OnCustomItem)
         MESSAGE_HANDLER(WM_MEASUREITEM, OnCustomItem)
@@ -381,6 +688,11 @@ CDefView::CDefView() :
     m_dwAdvf(0),
     m_iDragOverItem(0),
     m_cScrollDelay(0),
+    m_dwListGeneration(0),
+    m_bEnumerating(FALSE),
+    m_hdpaChanged(NULL),
+    m_pSortKeys(NULL),
+    m_uPendingSelectFlags(0),
     m_isEditing(FALSE),
     m_Destroyed(FALSE)
 {
@@ -728,6 +1040,29 @@ INT CALLBACK CDefView::ListViewCompareItems(LPARAM lParam1, LPARAM lParam2, LPAR
     return nDiff;
 }
 
+/**********************************************************
+ * ListViewCompareKeys
+ *
+ * Compares two items by their position in m_pSortKeys, which was worked out
+ * in the background. Items the keys don't know about are compared by the
+ * folder.
+ */
+INT CALLBACK CDefView::ListViewCompareKeys(LPARAM lParam1, LPARAM lParam2, LPARAM lpData)
+{
+    CDefView *pThis = reinterpret_cast<CDefView*>(lpData);
+    INT iKey1, iKey2, nDiff;
+
+    iKey1 = SortKeys_Lookup(pThis->m_pSortKeys, reinterpret_cast<PCUITEMID_CHILD>(lParam1));
+    iKey2 = SortKeys_Lookup(pThis->m_pSortKeys, reinterpret_cast<PCUITEMID_CHILD>(lParam2));
+    if (iKey1 < 0 || iKey2 < 0)
+        return ListViewCompareItems(lParam1, lParam2, lpData);
+
+    nDiff = (iKey1 < iKey2) ? -1 : (iKey1 > iKey2);
+    if (!pThis->m_sortInfo.bIsAscending)
+        nDiff = -nDiff;
+    return nDiff;
+}
+
 BOOL CDefView::_Sort()
 {
     HWND hHeader;
@@ -759,6 +1094,14 @@ BOOL CDefView::_Sort()
 
     /* Sort the list, using the current values of nHeaderID and bIsAscending */
     m_sortInfo.nLastHeaderID = m_sortInfo.nHeaderID;
+
+    /* The items are sorted once they have all been enumerated */
+    if (m_bEnumerating)
+        return TRUE;
+
+    if (SUCCEEDED(_QueueListTask(SHV_TASK_SORT, 0, NULL)))
+        return TRUE;
+
     return m_ListView.SortItems(ListViewCompareItems, this);
 }
 
@@ -788,6 +1131,37 @@ int CDefView::LV_FindItemByPidl(PCUITEMID_CHILD pidl)
     return -1;
 }
 
+/**********************************************************
+*  LV_FindInsertIndex()
+*
+* Finds where an item goes in the sorted list. While the folder is being
+* enumerated the list is not sorted yet, so it goes to the end then.
+*/
+int CDefView::LV_FindInsertIndex(PCUITEMID_CHILD pidl)
+{
+    int iLow = 0, iHigh = m_ListView.GetItemCount(), iMid;
+
+    if (m_bEnumerating || (m_ListView.GetStyle() & LVS_NOSORTHEADER))
+        return iHigh;
+
+    while (iLow < iHigh)
+    {
+        iMid = (iLow + iHigh) / 2;
+        if (ListViewCompareItems(reinterpret_cast<LPARAM>(_PidlByItem(iMid)),
+                                 reinterpret_cast<LPARAM>(pidl),
+                                 reinterpret_cast<LPARAM>(this)) <= 0)
+        {
+            iLow = iMid + 1;
+        }
+        else
+        {
+            iHigh = iMid;
+        }
+    }
+
+    return iLow;
+}
+
 /**********************************************************
 * LV_AddItem()
 */
@@ -798,16 +1172,61 @@ int CDefView::LV_AddItem(PCUITEMID_CHILD pidl)
     TRACE("(%p)(pidl=%p)\n", this, pidl);
 
     lvItem.mask = LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;    /*set the mask*/
-    lvItem.iItem = m_ListView.GetItemCount();             /*add the item to the end of the list*/
+    lvItem.iItem = LV_FindInsertIndex(pidl);              /*keep the list sorted*/
     lvItem.iSubItem = 0;
     lvItem.lParam = reinterpret_cast<LPARAM>(ILClone(pidl)); /*set the item's data*/
     lvItem.pszText = LPSTR_TEXTCALLBACKW;                 /*get text on a callback basis*/
-    lvItem.iImage = I_IMAGECALLBACK;                      /*get the image on a callback basis*/
+    lvItem.iImage = I_IMAGECALLBACK;                      /*get the image on a callback basis, see LV_GetItemIcon*/
     lvItem.stateMask = LVIS_CUT;
 
     return m_ListView.InsertItem(&lvItem);
 }
 
+/**********************************************************
+* LV_GetItemIcon()
+*
+* Returns the icon of the item if it is cached and a stand-in otherwise,
+* the real one is set by OnUpdateIcon once it has been extracted.
+*/
+int CDefView::LV_GetItemIcon(LVITEMW &lvItem)
+{
+    PCUITEMID_CHILD pidl = _PidlByItem(lvItem);
+    int iIcon = 0;
+
+    /* On E_PENDING iIcon holds the stand-in */
+    SHMapIDListToImageListIndexAsync(m_pScheduler, m_pSFParent, pidl, 0,
+                                     LV_IconCallback, m_hWnd,
+                                     reinterpret_cast<LPVOID>(lvItem.lParam),
+                                     &iIcon, NULL);
+
+    return iIcon;
+}
+
+/**********************************************************
+* LV_IconCallback()
+*
+* Called on the scheduler thread, so only hand the icon over to the view.
+*/
+void CALLBACK CDefView::LV_IconCallback(LPCITEMIDLIST pidl, LPVOID pvData, LPVOID pvHint, INT iIconIndex, INT iOpenIconIndex)
+{
+    SHV_ICON_UPDATE *pUpdate;
+
+    pUpdate = static_cast<SHV_ICON_UPDATE *>(SHAlloc(sizeof(*pUpdate)));
+    if (!pUpdate)
+        return;
+
+    pUpdate->lParam = reinterpret_cast<LPARAM>(pvHint);
+    pUpdate->pidl = ILClone(pidl);
+    pUpdate->iIcon = iIconIndex;
+
+    if (!pUpdate->pidl ||
+        !::PostMessageW(static_cast<HWND>(pvData), SHV_UPDATE_ICON, 0, reinterpret_cast<LPARAM>(pUpdate)))
+    {
+        ILFree(pUpdate->pidl);
+        SHFree(pUpdate);
+    }
+}
+
 /**********************************************************
 * LV_DeleteItem()
 */
@@ -885,9 +1304,9 @@ BOOLEAN CDefView::LV_ProdItem(PCUITEMID_CHILD pidl)
 /**********************************************************
 * ShellView_FillList()
 *
-* - gets the objectlist from the shellfolder
-* - sorts the list
-* - fills the list into the view
+* - starts enumerating the folder in the background
+* - the items are added in chunks by OnEnumItems
+* - and sorted by OnSortKeys once they are all there
 */
 INT CALLBACK CDefView::fill_list(LPVOID ptr, LPVOID arg)
 {
@@ -895,20 +1314,107 @@ INT CALLBACK CDefView::fill_list(LPVOID ptr, LPVOID arg)
     CDefView *pThis = static_cast<CDefView *>(arg);
 
     /* in a commdlg This works as a filemask*/
-    if (pThis->IncludeObject(pidl) == S_OK)
+    if (pThis->IncludeObject(pidl) == S_OK && !pThis->_IsChangedWhileEnumerating(pidl))
         pThis->LV_AddItem(pidl);
 
     SHFree(pidl);
     return TRUE;
 }
 
+/*
+ * Queues a CListItemsTask for the view's folder. It enumerates the folder
+ * with dwEnumFlags, or sorts hdpaItems if that is given.
+ */
+HRESULT CDefView::_QueueListTask(DWORD_PTR dwKind, DWORD dwEnumFlags, HDPA hdpaItems)
+{
+    CComObject<CListItemsTask> *pTask;
+    LONG lColumn;
+    HRESULT hr;
+    int i;
+
+    if (dwKind == SHV_TASK_SORT)
+    {
+        if (!m_pListScheduler)
+            return E_FAIL;
+
+        /* A sort that is still pending is of no use anymore */
+        m_pListScheduler->RemoveTasks(TOID_DefViewList, SHV_TASK_SORT, FALSE);
+
+        hdpaItems = DPA_Create(m_ListView.GetItemCount());
+        if (!hdpaItems)
+            return E_OUTOFMEMORY;
+
+        for (i = 0; i < m_ListView.GetItemCount(); i++)
+        {
+            PITEMID_CHILD pidl = ILClone(_PidlByItem(i));
+            if (!pidl || DPA_AppendPtr(hdpaItems, pidl) == -1)
+            {
+                SHFree(pidl);
+                DPA_DestroyCallback(hdpaItems, SHV_FreePidl, NULL);
+                return E_OUTOFMEMORY;
+            }
+        }
+    }
+
+    lColumn = (m_ListView.GetStyle() & LVS_NOSORTHEADER) ? -1 : m_sortInfo.nHeaderID;
+
+    hr = CComObject<CListItemsTask>::CreateInstance(&pTask);
+    if (FAILED_UNEXPECTEDLY(hr))
+    {
+        if (hdpaItems)
+            DPA_DestroyCallback(hdpaItems, SHV_FreePidl, NULL);
+        return hr;
+    }
+
+    pTask->AddRef();
+    hr = pTask->Initialize(m_pSFParent, m_hWnd, m_dwListGeneration, lColumn, dwEnumFlags, hdpaItems);
+    if (SUCCEEDED(hr))
+    {
+        hr = m_pListScheduler ? m_pListScheduler->AddTask(pTask, TOID_DefViewList, dwKind, ITSAT_DEFAULT_PRIORITY)
+                              : E_FAIL;
+
+        /* Without a scheduler the folder is enumerated right here */
+        if (FAILED(hr) && dwKind == SHV_TASK_ENUM)
+            hr = pTask->Run();
+    }
+    pTask->Release();
+
+    return hr;
+}
+
+/*
+ * Tells whether a change notification already added or removed the item
+ * while the folder was being enumerated, the enumeration is outdated then.
+ */
+BOOL CDefView::_IsChangedWhileEnumerating(PCUITEMID_CHILD pidl)
+{
+    int i;
+
+    if (!m_hdpaChanged)
+        return FALSE;
+
+    for (i = 0; i < DPA_GetPtrCount(m_hdpaChanged); i++)
+    {
+        if (ILIsEqual(static_cast<PCUITEMID_CHILD>(DPA_GetPtr(m_hdpaChanged, i)), pidl))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+void CDefView::_EndEnumeration()
+{
+    m_bEnumerating = FALSE;
+
+    if (m_hdpaChanged)
+    {
+        DPA_DestroyCallback(m_hdpaChanged, SHV_FreePidl, NULL);
+        m_hdpaChanged = NULL;
+    }
+}
+
 HRESULT CDefView::FillList()
 {
-    CComPtr<IEnumIDList> pEnumIDList;
-    PITEMID_CHILD pidl;
-    DWORD         dwFetched;
-    HRESULT       hRes;
-    HDPA          hdpa;
     DWORD         dFlags = SHCONTF_NONFOLDERS | SHCONTF_FOLDERS;
     DWORD dwValue, cbValue;
 
@@ -937,37 +1443,14 @@ HRESULT CDefView::FillList()
         m_ListView.SendMessageW(LVM_SETCALLBACKMASK, LVIS_CUT, 0);
     }
 
-    /* get the itemlist from the shfolder */
-    hRes = m_pSFParent->EnumObjects(m_hWnd, dFlags, &pEnumIDList);
-    if (hRes != S_OK)
-    {
-        if (hRes == S_FALSE)
-            return(NOERROR);
-        return(hRes);
-    }
-
-    /* create a pointer array */
-    hdpa = DPA_Create(16);
-    if (!hdpa)
-    {
-        return(E_OUTOFMEMORY);
-    }
-
-    /* copy the items into the array*/
-    while((S_OK == pEnumIDList->Next(1, &pidl, &dwFetched)) && dwFetched)
-    {
-        if (DPA_InsertPtr(hdpa, 0x7fff, pidl) == -1)
-        {
-            SHFree(pidl);
-        }
-    }
-
-    /*turn the listview's redrawing off*/
-    m_ListView.SetRedraw(FALSE);
+    /* Whatever an earlier enumeration still sends is dropped */
+    if (m_pListScheduler)
+        m_pListScheduler->RemoveTasks(TOID_DefViewList, ITSAT_DEFAULT_LPARAM, FALSE);
+    m_dwListGeneration++;
+    _EndEnumeration();
+    m_bEnumerating = TRUE;
 
-    DPA_DestroyCallback( hdpa, fill_list, this);
-
-    /* sort the array */
+    /* the items get sorted by this once they are all there */
     if (m_pSF2Parent)
     {
         m_pSF2Parent->GetDefaultColumn(NULL, (ULONG*)&m_sortInfo.nHeaderID, NULL);
@@ -989,20 +1472,95 @@ HRESULT CDefView::FillList()
     m_viewinfo_data.cbSize = sizeof(m_viewinfo_data);
     _DoFolderViewCB(SFVM_GET_CUSTOMVIEWINFO, 0, (LPARAM)&m_viewinfo_data);
 
+    UpdateListColors();
+
+    return _QueueListTask(SHV_TASK_ENUM, dFlags, NULL);
+}
+
+/**********************************************************
+* OnEnumItems()
+*
+* Adds a chunk of items CListItemsTask enumerated.
+*/
+LRESULT CDefView::OnEnumItems(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled)
+{
+    HDPA hdpa = reinterpret_cast<HDPA>(lParam);
+
+    if (wParam != m_dwListGeneration)
+    {
+        DPA_DestroyCallback(hdpa, SHV_FreePidl, NULL);
+        return 0;
+    }
+
+    /*turn the listview's redrawing off*/
+    m_ListView.SetRedraw(FALSE);
+
+    DPA_DestroyCallback(hdpa, fill_list, this);
+
     /*turn the listview's redrawing back on and force it to draw*/
     m_ListView.SetRedraw(TRUE);
 
-    UpdateListColors();
-
     if (!(m_FolderSettings.fFlags & FWF_DESKTOP))
     {
         // redraw now
         m_ListView.InvalidateRect(NULL, TRUE);
     }
 
-    _DoFolderViewCB(SFVM_LISTREFRESHED, NULL, NULL);
+    UpdateStatusbar();
+    return 0;
+}
 
-    return S_OK;
+/**********************************************************
+* OnSortKeys()
+*
+* Sorts the items by the order CListItemsTask worked out. When it comes
+* from the enumeration, the folder is completely listed now.
+*/
+LRESULT CDefView::OnSortKeys(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled)
+{
+    SHV_SORT_KEYS *pKeys = reinterpret_cast<SHV_SORT_KEYS *>(lParam);
+    BOOL bEnumerated = m_bEnumerating;
+
+    if (wParam != m_dwListGeneration)
+    {
+        SortKeys_Free(pKeys);
+        return 0;
+    }
+
+    _EndEnumeration();
+
+    if (pKeys && pKeys->lColumn == m_sortInfo.nHeaderID &&
+        !(m_ListView.GetStyle() & LVS_NOSORTHEADER))
+    {
+        m_pSortKeys = pKeys;
+        m_ListView.SortItems(ListViewCompareKeys, this);
+        m_pSortKeys = NULL;
+    }
+    else if (bEnumerated)
+    {
+        /* The sort order changed meanwhile */
+        _Sort();
+    }
+    else if (!pKeys)
+    {
+        m_ListView.SortItems(ListViewCompareItems, this);
+    }
+
+    SortKeys_Free(pKeys);
+
+    if (!bEnumerated)
+        return 0;
+
+    if (m_pidlPendingSelect)
+    {
+        CComHeapPtr<ITEMID_CHILD> pidl;
+        pidl.Attach(m_pidlPendingSelect.Detach());
+        SelectItem(pidl, m_uPendingSelectFlags);
+    }
+
+    UpdateStatusbar();
+    _DoFolderViewCB(SFVM_LISTREFRESHED, NULL, NULL);
+    return 0;
 }
 
 LRESULT CDefView::OnShowWindow(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled)
@@ -1032,6 +1590,36 @@ LRESULT CDefView::OnDestroy(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHand
         m_hNotify = NULL;
         SHFree(m_pidlParent);
         m_pidlParent = NULL;
+
+        /* Icons and items that were on their way are of no use anymore */
+        if (m_pScheduler)
+            m_pScheduler->RemoveTasks(TOID_NULL, ITSAT_DEFAULT_LPARAM, TRUE);
+        if (m_pListScheduler)
+            m_pListScheduler->RemoveTasks(TOID_NULL, ITSAT_DEFAULT_LPARAM, TRUE);
+
+        MSG msg;
+        while (PeekMessageW(&msg, m_hWnd, SHV_UPDATE_ICON, SHV_ITEMS_SORTED, PM_REMOVE))
+        {
+            if (msg.message == SHV_UPDATE_ICON)
+            {
+                SHV_ICON_UPDATE *pUpdate = reinterpret_cast<SHV_ICON_UPDATE *>(msg.lParam);
+                ILFree(pUpdate->pidl);
+                SHFree(pUpdate);
+            }
+            else if (msg.message == SHV_ENUM_ITEMS)
+            {
+                DPA_DestroyCallback(reinterpret_cast<HDPA>(msg.lParam), SHV_FreePidl, NULL);
+            }
+            else
+            {
+                SortKeys_Free(reinterpret_cast<SHV_SORT_KEYS *>(msg.lParam));
+            }
+        }
+
+        m_pScheduler.Release();
+        m_pListScheduler.Release();
+        _EndEnumeration();
+        m_pidlPendingSelect.Free();
     }
     bHandled = FALSE;
     return 0;
@@ -1140,6 +1728,14 @@ LRESULT CDefView::OnCreate(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandl
             ERR("Registering Drag Drop Failed");
     }
 
+    /* Icons that are not cached yet are extracted in the background */
+    if (SUCCEEDED(ShellObjectCreatorInit<CShellTaskScheduler>(IID_PPV_ARG(IShellTaskScheduler, &m_pScheduler))))
+        m_pScheduler->Status(ITSSFLAG_KILL_ON_DESTROY, ITSS_THREAD_TIMEOUT_NO_CHANGE);
+
+    /* So are the items, on a thread of their own so they don't hold up the icons */
+    if (SUCCEEDED(ShellObjectCreatorInit<CShellTaskScheduler>(IID_PPV_ARG(IShellTaskScheduler, &m_pListScheduler))))
+        m_pListScheduler->Status(ITSSFLAG_KILL_ON_DESTROY, ITSS_THREAD_TIMEOUT_NO_CHANGE);
+
     /* register for receiving notifications */
     m_pSFParent->QueryInterface(IID_PPV_ARG(IPersistFolder2, &ppf2));
     if (ppf2)
@@ -1985,7 +2581,7 @@ LRESULT CDefView::OnNotify(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandl
             }
             if(lpdi->item.mask & LVIF_IMAGE)    /* image requested */
             {
-                lpdi->item.iImage = SHMapPIDLToSystemImageListIndex(m_pSFParent, pidl, 0);
+                lpdi->item.iImage = LV_GetItemIcon(lpdi->item);
             }
             if(lpdi->item.mask & LVIF_STATE)
             {
@@ -2171,6 +2767,37 @@ static BOOL ILIsParentOrSpecialParent(PCIDLIST_ABSOLUTE pidl1, PCIDLIST_ABSOLUTE
     return FALSE;
 }
 
+/**********************************************************
+* OnUpdateIcon()
+*
+* Sets an icon that LV_IconCallback handed over, if the item is still there.
+*/
+LRESULT CDefView::OnUpdateIcon(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &bHandled)
+{
+    SHV_ICON_UPDATE *pUpdate = reinterpret_cast<SHV_ICON_UPDATE *>(lParam);
+    LVFINDINFOW lvfi;
+    LVITEMW lvItem;
+    int nItem;
+
+    lvfi.flags = LVFI_PARAM;
+    lvfi.lParam = pUpdate->lParam;
+    nItem = m_ListView.FindItem(-1, &lvfi);
+
+    /* The pidl may have been freed and reused by another item meanwhile */
+    if (nItem != -1 && ILIsEqual(_PidlByItem(nItem), pUpdate->pidl))
+    {
+        lvItem.mask = LVIF_IMAGE;
+        lvItem.iItem = nItem;
+        lvItem.iSubItem = 0;
+        lvItem.iImage = pUpdate->iIcon;
+        m_ListView.SetItem(&lvItem);
+    }
+
+    ILFree(pUpdate->pidl);
+    SHFree(pUpdate);
+    return TRUE;
+}
+
 /**********************************************************
 * ShellView_OnChange()
 */
@@ -2193,6 +2820,18 @@ LRESULT CDefView::OnChangeNotify(UINT uMsg, WPARAM wParam, LPARAM lParam, BOOL &
     TRACE("(%p)(%p,%p,0x%08x)\n", this, Pidls[0], Pidls[1], lParam);
 
     lEvent &= ~SHCNE_INTERRUPT;
+
+    /* Items that are still to come from the enumeration may be outdated now */
+    if (m_bEnumerating)
+    {
+        if (!m_hdpaChanged)
+            m_hdpaChanged = DPA_Create(16);
+        if (m_hdpaChanged && bParent0)
+            DPA_AppendPtr(m_hdpaChanged, ILClone(ILFindLastID(Pidls[0])));
+        if (m_hdpaChanged && bParent1)
+            DPA_AppendPtr(m_hdpaChanged, ILClone(ILFindLastID(Pidls[1])));
+    }
+
     switch (lEvent)
     {
         case SHCNE_MKDIR:
@@ -2509,7 +3148,16 @@ HRESULT WINAPI CDefView::SelectItem(PCUITEMID_CHILD pidl, UINT uFlags)
 
     i = LV_FindItemByPidl(pidl);
     if (i == -1)
+    {
+        /* Select it once it shows up */
+        if (m_bEnumerating)
+        {
+            m_pidlPendingSelect.Free();
+            m_pidlPendingSelect.Attach(static_cast<PITEMID_CHILD>(ILClone(pidl)));
+            m_uPendingSelectFlags = uFlags;
+        }
         return S_OK;
+    }
 
     LVITEMW lvItem = {0};
     lvItem.mask = LVIF_STATE;
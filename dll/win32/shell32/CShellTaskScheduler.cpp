@@ -0,0 +1,249 @@
+/*
+ * PROJECT:     shell32
+ * LICENSE:     LGPL-2.1+ (https://spdx.org/licenses/LGPL-2.1+)
+ * PURPOSE:     Background task scheduler for the shell views
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(shell);
+
+/*
+ * A single worker thread that runs IRunnableTask objects, highest priority
+ * first and in order of arrival otherwise. The worker is started with the
+ * first task and lives as long as the scheduler.
+ */
+
+CShellTaskScheduler::CShellTaskScheduler() :
+    m_hThread(NULL),
+    m_hWorkEvent(NULL),
+    m_hIdleEvent(NULL),
+    m_dwReleaseStatus(ITSSFLAG_COMPLETE_ON_DESTROY),
+    m_bExit(FALSE)
+{
+    ZeroMemory(&m_Running, sizeof(m_Running));
+    InitializeCriticalSection(&m_cs);
+}
+
+CShellTaskScheduler::~CShellTaskScheduler()
+{
+    if (m_hWorkEvent)
+        CloseHandle(m_hWorkEvent);
+    if (m_hIdleEvent)
+        CloseHandle(m_hIdleEvent);
+    DeleteCriticalSection(&m_cs);
+}
+
+HRESULT WINAPI CShellTaskScheduler::Initialize()
+{
+    m_hWorkEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    m_hIdleEvent = CreateEventW(NULL, TRUE, TRUE, NULL);
+    if (!m_hWorkEvent || !m_hIdleEvent)
+        return E_OUTOFMEMORY;
+
+    return S_OK;
+}
+
+void CShellTaskScheduler::FinalRelease()
+{
+    int i;
+
+    EnterCriticalSection(&m_cs);
+
+    if (m_dwReleaseStatus & ITSSFLAG_KILL_ON_DESTROY)
+    {
+        for (i = 0; i < m_Tasks.GetSize(); i++)
+            m_Tasks[i].pTask->Release();
+        m_Tasks.RemoveAll();
+
+        if (m_Running.pTask)
+            m_Running.pTask->Kill(FALSE);
+    }
+
+    /* The worker finishes the queue before it goes away */
+    m_bExit = TRUE;
+    LeaveCriticalSection(&m_cs);
+
+    if (m_hThread)
+    {
+        SetEvent(m_hWorkEvent);
+        WaitForSingleObject(m_hThread, INFINITE);
+        CloseHandle(m_hThread);
+        m_hThread = NULL;
+    }
+}
+
+BOOL CShellTaskScheduler::_Matches(const TASK &task, REFGUID rtoid, DWORD_PTR lParam)
+{
+    if (!IsEqualGUID(rtoid, TOID_NULL) && !IsEqualGUID(rtoid, task.toid))
+        return FALSE;
+
+    return (lParam == ITSAT_DEFAULT_LPARAM || lParam == task.lParam);
+}
+
+DWORD WINAPI CShellTaskScheduler::_ThreadProc(LPVOID lpParameter)
+{
+    CShellTaskScheduler *pThis = static_cast<CShellTaskScheduler *>(lpParameter);
+    HRESULT hr;
+
+    hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    pThis->_Run();
+    if (SUCCEEDED(hr))
+        CoUninitialize();
+
+    return 0;
+}
+
+void CShellTaskScheduler::_Run()
+{
+    IRunnableTask *pTask;
+    int i, iNext;
+
+    for (;;)
+    {
+        EnterCriticalSection(&m_cs);
+
+        if (m_Tasks.GetSize() == 0)
+        {
+            BOOL bExit = m_bExit;
+            LeaveCriticalSection(&m_cs);
+
+            if (bExit)
+                break;
+
+            WaitForSingleObject(m_hWorkEvent, INFINITE);
+            continue;
+        }
+
+        /* Pick the oldest of the most important tasks */
+        iNext = 0;
+        for (i = 1; i < m_Tasks.GetSize(); i++)
+        {
+            if (m_Tasks[i].dwPriority > m_Tasks[iNext].dwPriority)
+                iNext = i;
+        }
+
+        m_Running = m_Tasks[iNext];
+        m_Tasks.RemoveAt(iNext);
+        ResetEvent(m_hIdleEvent);
+
+        LeaveCriticalSection(&m_cs);
+
+        /* Suspended tasks are not resumed, nobody here suspends them */
+        m_Running.pTask->Run();
+
+        EnterCriticalSection(&m_cs);
+        pTask = m_Running.pTask;
+        m_Running.pTask = NULL;
+        SetEvent(m_hIdleEvent);
+        LeaveCriticalSection(&m_cs);
+
+        pTask->Release();
+    }
+}
+
+HRESULT STDMETHODCALLTYPE CShellTaskScheduler::AddTask(IRunnableTask *pTask, REFGUID rtoid, DWORD_PTR lParam, DWORD dwPriority)
+{
+    TASK task;
+
+    TRACE("(%p, %p, %s, %Ix, %lx)\n", this, pTask, wine_dbgstr_guid(&rtoid), lParam, dwPriority);
+
+    if (!pTask)
+        return E_INVALIDARG;
+
+    task.pTask = pTask;
+    task.toid = rtoid;
+    task.lParam = lParam;
+    task.dwPriority = dwPriority;
+
+    EnterCriticalSection(&m_cs);
+
+    if (!m_hThread)
+    {
+        m_hThread = CreateThread(NULL, 0, _ThreadProc, this, 0, NULL);
+        if (!m_hThread)
+        {
+            LeaveCriticalSection(&m_cs);
+            ERR("Failed to create the worker thread (error %lu)\n", GetLastError());
+            return E_FAIL;
+        }
+    }
+
+    if (!m_Tasks.Add(task))
+    {
+        LeaveCriticalSection(&m_cs);
+        return E_OUTOFMEMORY;
+    }
+
+    pTask->AddRef();
+    SetEvent(m_hWorkEvent);
+
+    LeaveCriticalSection(&m_cs);
+    return S_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CShellTaskScheduler::RemoveTasks(REFGUID rtoid, DWORD_PTR lParam, BOOL fWaitIfRunning)
+{
+    BOOL bWait = FALSE;
+    int i;
+
+    TRACE("(%p, %s, %Ix, %d)\n", this, wine_dbgstr_guid(&rtoid), lParam, fWaitIfRunning);
+
+    EnterCriticalSection(&m_cs);
+
+    for (i = m_Tasks.GetSize() - 1; i >= 0; i--)
+    {
+        if (_Matches(m_Tasks[i], rtoid, lParam))
+        {
+            m_Tasks[i].pTask->Release();
+            m_Tasks.RemoveAt(i);
+        }
+    }
+
+    if (m_Running.pTask && _Matches(m_Running, rtoid, lParam))
+    {
+        m_Running.pTask->Kill(FALSE);
+        bWait = fWaitIfRunning;
+    }
+
+    LeaveCriticalSection(&m_cs);
+
+    /* Tasks post back to their owner instead of sending, so this cannot deadlock */
+    if (bWait)
+        WaitForSingleObject(m_hIdleEvent, INFINITE);
+
+    return S_OK;
+}
+
+UINT STDMETHODCALLTYPE CShellTaskScheduler::CountTasks(REFGUID rtoid)
+{
+    UINT cTasks = 0;
+    int i;
+
+    EnterCriticalSection(&m_cs);
+
+    for (i = 0; i < m_Tasks.GetSize(); i++)
+    {
+        if (_Matches(m_Tasks[i], rtoid, ITSAT_DEFAULT_LPARAM))
+            cTasks++;
+    }
+
+    if (m_Running.pTask && _Matches(m_Running, rtoid, ITSAT_DEFAULT_LPARAM))
+        cTasks++;
+
+    LeaveCriticalSection(&m_cs);
+    return cTasks;
+}
+
+HRESULT STDMETHODCALLTYPE CShellTaskScheduler::Status(DWORD dwReleaseStatus, DWORD dwThreadTimeout)
+{
+    TRACE("(%p, %lx, %lx)\n", this, dwReleaseStatus, dwThreadTimeout);
+
+    /* The worker does not time out, it is bound to the scheduler */
+    EnterCriticalSection(&m_cs);
+    m_dwReleaseStatus = dwReleaseStatus;
+    LeaveCriticalSection(&m_cs);
+
+    return S_OK;
+}
@@ -0,0 +1,58 @@
+/*
+ * PROJECT:     shell32
+ * LICENSE:     LGPL-2.1+ (https://spdx.org/licenses/LGPL-2.1+)
+ * PURPOSE:     Background task scheduler for the shell views
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef _SHELLTASKSCHEDULER_H_
+#define _SHELLTASKSCHEDULER_H_
+
+class CShellTaskScheduler :
+    public CComObjectRootEx<CComMultiThreadModelNoCS>,
+    public IShellTaskScheduler
+{
+private:
+    struct TASK
+    {
+        IRunnableTask *pTask;
+        GUID toid;
+        DWORD_PTR lParam;
+        DWORD dwPriority;
+    };
+
+    CRITICAL_SECTION m_cs;
+    CSimpleArray<TASK> m_Tasks;
+    TASK m_Running;             /* pTask is NULL while the worker is idle */
+    HANDLE m_hThread;
+    HANDLE m_hWorkEvent;        /* Signaled when there is something to do */
+    HANDLE m_hIdleEvent;        /* Signaled when no task is running */
+    DWORD m_dwReleaseStatus;
+    BOOL m_bExit;
+
+    static BOOL _Matches(const TASK &task, REFGUID rtoid, DWORD_PTR lParam);
+    static DWORD WINAPI _ThreadProc(LPVOID lpParameter);
+    void _Run();
+
+public:
+    CShellTaskScheduler();
+    ~CShellTaskScheduler();
+
+    HRESULT WINAPI Initialize();
+    void FinalRelease();
+
+    // *** IShellTaskScheduler methods ***
+    virtual HRESULT STDMETHODCALLTYPE AddTask(IRunnableTask *pTask, REFGUID rtoid, DWORD_PTR lParam, DWORD dwPriority);
+    virtual HRESULT STDMETHODCALLTYPE RemoveTasks(REFGUID rtoid, DWORD_PTR lParam, BOOL fWaitIfRunning);
+    virtual UINT STDMETHODCALLTYPE CountTasks(REFGUID rtoid);
+    virtual HRESULT STDMETHODCALLTYPE Status(DWORD dwReleaseStatus, DWORD dwThreadTimeout);
+
+DECLARE_NOT_AGGREGATABLE(CShellTaskScheduler)
+DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+BEGIN_COM_MAP(CShellTaskScheduler)
+    COM_INTERFACE_ENTRY_IID(IID_IShellTaskScheduler, IShellTaskScheduler)
+END_COM_MAP()
+};
+
+#endif /* _SHELLTASKSCHEDULER_H_ */
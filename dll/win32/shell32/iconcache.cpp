@@ -33,6 +33,7 @@ typedef struct
     DWORD dwListIndex;    /* index within the iconlist */
     DWORD dwFlags;        /* GIL_* flags */
     DWORD dwAccessTime;
+    FILETIME ftLastWrite;    /* of the source file, zero if not to be persisted */
 } SIC_ENTRY, * LPSIC_ENTRY;
 
 static HDPA        sic_hdpa = 0;
@@ -40,6 +41,11 @@ static HDPA        sic_hdpa = 0;
 static HIMAGELIST ShellSmallIconList;
 static HIMAGELIST ShellBigIconList;
 
+/* Image list geometry, the persistent cache is only valid for the same one */
+static INT sic_cxSmall, sic_cySmall;
+static INT sic_cxLarge, sic_cyLarge;
+static DWORD sic_ilMask;
+
 namespace
 {
 extern CRITICAL_SECTION SHELL32_SicCS;
@@ -323,7 +329,7 @@ fail:
  * NOTES
  *  appends an icon pair to the end of the cache
  */
-static INT SIC_IconAppend (LPCWSTR sSourceFile, INT dwSourceIndex, HICON hSmallIcon, HICON hBigIcon, DWORD dwFlags)
+static INT SIC_IconAppend (LPCWSTR sSourceFile, INT dwSourceIndex, HICON hSmallIcon, HICON hBigIcon, DWORD dwFlags, const FILETIME *pftLastWrite)
 {
     LPSIC_ENTRY lpsice;
     INT ret, index, index1, indexDPA;
@@ -338,9 +344,24 @@ static INT SIC_IconAppend (LPCWSTR sSourceFile, INT dwSourceIndex, HICON hSmallI
 
     lpsice->dwSourceIndex = dwSourceIndex;
     lpsice->dwFlags = dwFlags;
+    if (pftLastWrite)
+        lpsice->ftLastWrite = *pftLastWrite;
+    else
+        ZeroMemory(&lpsice->ftLastWrite, sizeof(lpsice->ftLastWrite));
 
     EnterCriticalSection(&SHELL32_SicCS);
 
+    /* Icons are extracted outside of the lock, somebody may have been faster */
+    indexDPA = DPA_Search (sic_hdpa, lpsice, 0, SIC_CompareEntries, 0, DPAS_SORTED);
+    if ( -1 != indexDPA )
+    {
+        ret = ((LPSIC_ENTRY)DPA_GetPtr(sic_hdpa, indexDPA))->dwListIndex;
+        LeaveCriticalSection(&SHELL32_SicCS);
+        HeapFree(GetProcessHeap(), 0, lpsice->sSourceFile);
+        SHFree(lpsice);
+        return ret;
+    }
+
     indexDPA = DPA_Search (sic_hdpa, lpsice, 0, SIC_CompareEntries, 0, DPAS_SORTED|DPAS_INSERTAFTER);
     indexDPA = DPA_InsertPtr(sic_hdpa, indexDPA, lpsice);
     if ( -1 == indexDPA )
@@ -381,13 +402,617 @@ leave:
     LeaveCriticalSection(&SHELL32_SicCS);
     return ret;
 }
+/******************** THE PERSISTENT ICON CACHE ***********************/
+
+/*
+ * Extracted icons are kept in %LOCALAPPDATA%\IconCache.<generation>.db across
+ * sessions. Every process maps the newest complete file read-only, so its
+ * pages are shared, and looks there before extracting an icon again. A record
+ * is only used as long as its source file has the same last write time.
+ * A file is never changed once written. Saving creates the next generation,
+ * which nobody can open before it is complete, and removes the older ones
+ * that are no longer mapped anywhere.
+ */
+
+#define SIC_FILE_NAME_PREFIX    L"IconCache."
+#define SIC_FILE_NAME_FORMAT    SIC_FILE_NAME_PREFIX L"%08lx.db"
+#define SIC_FILE_NAME_PATTERN   SIC_FILE_NAME_PREFIX L"*.db"
+#define SIC_FILE_MAGIC          0x43494853    /* 'SHIC' */
+#define SIC_FILE_VERSION        1
+#define SIC_FILE_MAX_ENTRIES    4096
+
+/* The cache is written once that many icons were extracted, or after
+ * SIC_SAVE_DELAY milliseconds if there is at least one */
+#define SIC_SAVE_COUNT          16
+#define SIC_SAVE_DELAY          5000
+
+typedef struct
+{
+    DWORD dwMagic;
+    DWORD dwVersion;
+    DWORD dwColorMask;      /* ILC_* flags of the image lists */
+    INT cxSmall, cySmall;
+    INT cxLarge, cyLarge;
+    DWORD cEntries;
+} SIC_FILE_HEADER;
+
+typedef struct
+{
+    DWORD dwHash;           /* of the upper case path, records are sorted by it */
+    INT iSourceIndex;
+    DWORD dwFlags;
+    FILETIME ftLastWrite;
+    WCHAR szSourceFile[MAX_PATH];
+    /* followed by the small and the large icon, each as 32bpp colors and a mask */
+} SIC_FILE_ENTRY;
+
+static const SIC_FILE_HEADER *sic_pCacheFile;
+static DWORD sic_dwCacheGeneration;
+static SIZE_T sic_cbCacheRecord;
+static LONG sic_cNewIcons;
+static DWORD sic_dwLastSave;
+static LONG sic_lSaving;
+
+static SIZE_T SIC_ColorSize(INT cx, INT cy)
+{
+    return cx * cy * sizeof(DWORD);
+}
+
+static SIZE_T SIC_IconSize(INT cx, INT cy)
+{
+    /* Monochrome bitmap rows are WORD aligned */
+    return SIC_ColorSize(cx, cy) + ((cx + 15) / 16) * sizeof(WORD) * cy;
+}
+
+static const SIC_FILE_ENTRY *SIC_CacheRecord(DWORD dwIndex)
+{
+    return (const SIC_FILE_ENTRY *)((const BYTE *)(sic_pCacheFile + 1) + dwIndex * sic_cbCacheRecord);
+}
+
+static DWORD SIC_HashPath(LPCWSTR pszPath)
+{
+    DWORD dwHash = 2166136261U;
+
+    while (*pszPath)
+        dwHash = (dwHash ^ towupper(*pszPath++)) * 16777619U;
+
+    return dwHash;
+}
+
+/* Generation 0 gives the pattern matching all of them */
+static BOOL SIC_GetCacheFilePath(LPWSTR pszPath, DWORD dwGeneration)
+{
+    WCHAR szName[32];
+
+    if (FAILED(SHGetFolderPathW(NULL, CSIDL_LOCAL_APPDATA, NULL, SHGFP_TYPE_CURRENT, pszPath)))
+        return FALSE;
+
+    if (dwGeneration)
+        StringCchPrintfW(szName, _countof(szName), SIC_FILE_NAME_FORMAT, dwGeneration);
+    else
+        StringCchCopyW(szName, _countof(szName), SIC_FILE_NAME_PATTERN);
+
+    return PathAppendW(pszPath, szName);
+}
+
+/* Returns the newest generation before dwBelow, 0 if there is none */
+static DWORD SIC_FindCacheGeneration(DWORD dwBelow)
+{
+    WIN32_FIND_DATAW fd;
+    WCHAR szPattern[MAX_PATH];
+    HANDLE hFind;
+    LPWSTR pszEnd;
+    DWORD dwGeneration, dwNewest = 0;
+
+    if (!SIC_GetCacheFilePath(szPattern, 0))
+        return 0;
+
+    hFind = FindFirstFileW(szPattern, &fd);
+    if (hFind == INVALID_HANDLE_VALUE)
+        return 0;
+
+    do
+    {
+        if (_wcsnicmp(fd.cFileName, SIC_FILE_NAME_PREFIX, wcslen(SIC_FILE_NAME_PREFIX)))
+            continue;
+
+        dwGeneration = wcstoul(fd.cFileName + wcslen(SIC_FILE_NAME_PREFIX), &pszEnd, 16);
+        if (!_wcsicmp(pszEnd, L".db") && dwGeneration < dwBelow && dwGeneration > dwNewest)
+            dwNewest = dwGeneration;
+    } while (FindNextFileW(hFind, &fd));
+
+    FindClose(hFind);
+    return dwNewest;
+}
+
+/* Deleting the generations other processes still map fails, a later save retries */
+static void SIC_DeleteOldCacheFiles(DWORD dwGeneration)
+{
+    WCHAR szPath[MAX_PATH];
+
+    while ((dwGeneration = SIC_FindCacheGeneration(dwGeneration)) != 0)
+    {
+        if (SIC_GetCacheFilePath(szPath, dwGeneration))
+            DeleteFileW(szPath);
+    }
+}
+
+static BOOL SIC_GetLastWriteTime(LPCWSTR pszPath, FILETIME *pftLastWrite)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    if (!GetFileAttributesExW(pszPath, GetFileExInfoStandard, &data))
+        return FALSE;
+
+    *pftLastWrite = data.ftLastWriteTime;
+    return TRUE;
+}
+
+static void SIC_FillBitmapInfo(BITMAPINFO *pbmi, INT cx, INT cy)
+{
+    ZeroMemory(pbmi, sizeof(*pbmi));
+    pbmi->bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    pbmi->bmiHeader.biWidth = cx;
+    pbmi->bmiHeader.biHeight = -cy;
+    pbmi->bmiHeader.biPlanes = 1;
+    pbmi->bmiHeader.biBitCount = 32;
+    pbmi->bmiHeader.biCompression = BI_RGB;
+}
+
+static BOOL SIC_GetIconBits(HICON hIcon, INT cx, INT cy, LPBYTE pBits)
+{
+    ICONINFO IconInfo;
+    BITMAPINFO bmi;
+    LONG cbMask;
+    HDC hDC;
+    BOOL ret = FALSE;
+
+    if (!GetIconInfo(hIcon, &IconInfo))
+        return FALSE;
+
+    if (IconInfo.hbmColor)
+    {
+        SIC_FillBitmapInfo(&bmi, cx, cy);
+        cbMask = (LONG)(SIC_IconSize(cx, cy) - SIC_ColorSize(cx, cy));
+
+        hDC = CreateCompatibleDC(NULL);
+        if (hDC)
+        {
+            ret = GetDIBits(hDC, IconInfo.hbmColor, 0, cy, pBits, &bmi, DIB_RGB_COLORS) == cy &&
+                  GetBitmapBits(IconInfo.hbmMask, cbMask, pBits + SIC_ColorSize(cx, cy)) == cbMask;
+            DeleteDC(hDC);
+        }
+
+        DeleteObject(IconInfo.hbmColor);
+    }
+
+    DeleteObject(IconInfo.hbmMask);
+    return ret;
+}
+
+static HICON SIC_CreateIconFromBits(INT cx, INT cy, const BYTE *pBits)
+{
+    ICONINFO IconInfo;
+    BITMAPINFO bmi;
+    PVOID pvColor;
+    HICON hIcon = NULL;
+
+    SIC_FillBitmapInfo(&bmi, cx, cy);
+
+    IconInfo.fIcon = TRUE;
+    IconInfo.xHotspot = 0;
+    IconInfo.yHotspot = 0;
+    IconInfo.hbmColor = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &pvColor, NULL, 0);
+    IconInfo.hbmMask = CreateBitmap(cx, cy, 1, 1, pBits + SIC_ColorSize(cx, cy));
+
+    if (IconInfo.hbmColor && IconInfo.hbmMask)
+    {
+        CopyMemory(pvColor, pBits, SIC_ColorSize(cx, cy));
+        hIcon = CreateIconIndirect(&IconInfo);
+    }
+
+    if (IconInfo.hbmColor) DeleteObject(IconInfo.hbmColor);
+    if (IconInfo.hbmMask) DeleteObject(IconInfo.hbmMask);
+
+    return hIcon;
+}
+
+static const SIC_FILE_HEADER *SIC_OpenCacheFile(DWORD dwGeneration)
+{
+    const SIC_FILE_HEADER *pHeader;
+    WCHAR szPath[MAX_PATH];
+    LARGE_INTEGER liSize;
+    HANDLE hFile, hMapping;
+
+    if (!SIC_GetCacheFilePath(szPath, dwGeneration))
+        return NULL;
+
+    /* Allow older generations to be deleted once nobody maps them */
+    hFile = CreateFileW(szPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                        NULL, OPEN_EXISTING, 0, NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (!GetFileSizeEx(hFile, &liSize) || liSize.HighPart ||
+        liSize.LowPart < sizeof(SIC_FILE_HEADER))
+    {
+        CloseHandle(hFile);
+        return NULL;
+    }
+
+    hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(hFile);
+    if (!hMapping)
+        return NULL;
+
+    pHeader = (const SIC_FILE_HEADER *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping);
+    if (!pHeader)
+        return NULL;
+
+    if (pHeader->dwMagic != SIC_FILE_MAGIC ||
+        pHeader->dwVersion != SIC_FILE_VERSION ||
+        pHeader->dwColorMask != sic_ilMask ||
+        pHeader->cxSmall != sic_cxSmall || pHeader->cySmall != sic_cySmall ||
+        pHeader->cxLarge != sic_cxLarge || pHeader->cyLarge != sic_cyLarge ||
+        pHeader->cEntries > SIC_FILE_MAX_ENTRIES ||
+        sizeof(SIC_FILE_HEADER) + pHeader->cEntries * sic_cbCacheRecord > liSize.LowPart)
+    {
+        TRACE("Ignoring icon cache of another version or display mode\n");
+        UnmapViewOfFile(pHeader);
+        return NULL;
+    }
+
+    return pHeader;
+}
+
+/*****************************************************************************
+ * SIC_MapCacheFile            [internal]
+ *
+ * NOTES
+ *  Maps the newest cache file written for the current image lists, unless
+ *  it is mapped already. The caller holds SHELL32_SicCS.
+ */
+static void SIC_MapCacheFile(void)
+{
+    const SIC_FILE_HEADER *pHeader = NULL;
+    DWORD dwGeneration = MAXDWORD;
+
+    /* A generation that is still being written can't be opened yet,
+     * the one before it is used meanwhile */
+    while (!pHeader &&
+           (dwGeneration = SIC_FindCacheGeneration(dwGeneration)) > sic_dwCacheGeneration)
+    {
+        pHeader = SIC_OpenCacheFile(dwGeneration);
+    }
+
+    if (!pHeader)
+        return;
+
+    TRACE("Mapped icon cache generation %lu with %lu entries\n", dwGeneration, pHeader->cEntries);
+
+    if (sic_pCacheFile) UnmapViewOfFile(sic_pCacheFile);
+    sic_pCacheFile = pHeader;
+    sic_dwCacheGeneration = dwGeneration;
+}
+
+static const SIC_FILE_ENTRY *SIC_FindCacheRecord(LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags)
+{
+    const SIC_FILE_ENTRY *pEntry;
+    DWORD dwHash, iLow, iHigh, iMid;
+
+    if (!sic_pCacheFile)
+        return NULL;
+
+    /* Find the first record with the hash, then the one with the key */
+    dwHash = SIC_HashPath(sSourceFile);
+    iLow = 0;
+    iHigh = sic_pCacheFile->cEntries;
+    while (iLow < iHigh)
+    {
+        iMid = (iLow + iHigh) / 2;
+        if (SIC_CacheRecord(iMid)->dwHash < dwHash)
+            iLow = iMid + 1;
+        else
+            iHigh = iMid;
+    }
+
+    for (; iLow < sic_pCacheFile->cEntries; iLow++)
+    {
+        pEntry = SIC_CacheRecord(iLow);
+        if (pEntry->dwHash != dwHash)
+            break;
+
+        if (pEntry->iSourceIndex == dwSourceIndex &&
+            (pEntry->dwFlags & GIL_FORSHORTCUT) == (dwFlags & GIL_FORSHORTCUT) &&
+            !_wcsnicmp(pEntry->szSourceFile, sSourceFile, MAX_PATH))
+        {
+            return pEntry;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+ * SIC_LoadCachedIcon            [internal]
+ *
+ * NOTES
+ *  Adds an icon from the cache file to the image lists, if the cache has
+ *  it for the current version of the source file.
+ */
+static INT SIC_LoadCachedIcon (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags, const FILETIME *pftLastWrite)
+{
+    const SIC_FILE_ENTRY *pEntry;
+    const BYTE *pBits;
+    HICON hiconLarge = NULL, hiconSmall = NULL;
+    DWORD dwCachedFlags = 0;
+    INT ret = INVALID_INDEX;
+
+    /* Saving the cache maps a new generation, keep the view until we are done */
+    EnterCriticalSection(&SHELL32_SicCS);
+
+    pEntry = SIC_FindCacheRecord(sSourceFile, dwSourceIndex, dwFlags);
+    if (pEntry && CompareFileTime(&pEntry->ftLastWrite, pftLastWrite) == 0)
+    {
+        TRACE("-- found %s %i in the cache file\n", debugstr_w(sSourceFile), dwSourceIndex);
+
+        pBits = (const BYTE *)(pEntry + 1);
+        hiconSmall = SIC_CreateIconFromBits(sic_cxSmall, sic_cySmall, pBits);
+        hiconLarge = SIC_CreateIconFromBits(sic_cxLarge, sic_cyLarge,
+                                            pBits + SIC_IconSize(sic_cxSmall, sic_cySmall));
+        dwCachedFlags = pEntry->dwFlags;
+    }
+
+    LeaveCriticalSection(&SHELL32_SicCS);
+
+    if (hiconSmall && hiconLarge)
+        ret = SIC_IconAppend(sSourceFile, dwSourceIndex, hiconSmall, hiconLarge, dwCachedFlags, pftLastWrite);
+
+    if (hiconSmall) DestroyIcon(hiconSmall);
+    if (hiconLarge) DestroyIcon(hiconLarge);
+
+    return ret;
+}
+
+static int __cdecl SIC_CompareRecords(const void *p1, const void *p2)
+{
+    const SIC_FILE_ENTRY *e1 = *(const SIC_FILE_ENTRY * const *)p1;
+    const SIC_FILE_ENTRY *e2 = *(const SIC_FILE_ENTRY * const *)p2;
+
+    if (e1->dwHash != e2->dwHash)
+        return (e1->dwHash < e2->dwHash) ? -1 : 1;
+
+    return 0;
+}
+
+/*****************************************************************************
+ * SIC_SaveCache            [internal]
+ *
+ * NOTES
+ *  Writes the icons of this process and the ones from the newest cache file
+ *  it did not use to the next generation, then maps that one. The entries
+ *  are only copied under SHELL32_SicCS, the icon bits are read after.
+ */
+static void SIC_SaveCache(void)
+{
+    WCHAR szPath[MAX_PATH];
+    WCHAR szSourceFile[MAX_PATH];
+    SIC_FILE_HEADER header;
+    const SIC_FILE_ENTRY *pCached;
+    SIC_FILE_ENTRY *pRecord;
+    SIC_FILE_ENTRY **ppRecords = NULL;
+    INT *piListIndex = NULL;
+    LPBYTE pBuffer = NULL, pBits;
+    LPSIC_ENTRY lpsice;
+    SIC_ENTRY sice;
+    HICON hIcon;
+    HANDLE hFile;
+    DWORD cRecords = 0, cOwnRecords, cMaxRecords, i, cbWritten, dwGeneration;
+    INT iEntry;
+    BOOL bSuccess;
+
+    EnterCriticalSection(&SHELL32_SicCS);
+
+    if (!sic_hdpa)
+    {
+        LeaveCriticalSection(&SHELL32_SicCS);
+        return;
+    }
+
+    sic_cNewIcons = 0;
+    sic_dwLastSave = GetTickCount();
+
+    /* Keep what other processes saved meanwhile */
+    SIC_MapCacheFile();
+    dwGeneration = sic_dwCacheGeneration;
+
+    cMaxRecords = DPA_GetPtrCount(sic_hdpa);
+    if (sic_pCacheFile)
+        cMaxRecords += sic_pCacheFile->cEntries;
+    cMaxRecords = min(cMaxRecords, SIC_FILE_MAX_ENTRIES);
+
+    pBuffer = (LPBYTE)HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, cMaxRecords * sic_cbCacheRecord);
+    ppRecords = (SIC_FILE_ENTRY **)HeapAlloc(GetProcessHeap(), 0, cMaxRecords * sizeof(*ppRecords));
+    piListIndex = (INT *)HeapAlloc(GetProcessHeap(), 0, cMaxRecords * sizeof(*piListIndex));
+    if (!pBuffer || !ppRecords || !piListIndex)
+    {
+        LeaveCriticalSection(&SHELL32_SicCS);
+        goto cleanup;
+    }
+
+    /* What this process uses comes first */
+    for (iEntry = 0; iEntry < DPA_GetPtrCount(sic_hdpa) && cRecords < cMaxRecords; iEntry++)
+    {
+        lpsice = (LPSIC_ENTRY)DPA_GetPtr(sic_hdpa, iEntry);
+        if (!lpsice->ftLastWrite.dwLowDateTime && !lpsice->ftLastWrite.dwHighDateTime)
+            continue;
+
+        pRecord = (SIC_FILE_ENTRY *)(pBuffer + cRecords * sic_cbCacheRecord);
+        ZeroMemory(pRecord, sic_cbCacheRecord);
+        if (FAILED(StringCchCopyW(pRecord->szSourceFile, MAX_PATH, lpsice->sSourceFile)))
+            continue;
+
+        pRecord->dwHash = SIC_HashPath(lpsice->sSourceFile);
+        pRecord->iSourceIndex = lpsice->dwSourceIndex;
+        pRecord->dwFlags = lpsice->dwFlags;
+        pRecord->ftLastWrite = lpsice->ftLastWrite;
+        piListIndex[cRecords++] = lpsice->dwListIndex;
+    }
+    cOwnRecords = cRecords;
+
+    /* Then what other processes extracted */
+    for (i = 0; sic_pCacheFile && i < sic_pCacheFile->cEntries && cRecords < cMaxRecords; i++)
+    {
+        pCached = SIC_CacheRecord(i);
+
+        StringCchCopyNW(szSourceFile, MAX_PATH, pCached->szSourceFile, MAX_PATH - 1);
+        sice.sSourceFile = szSourceFile;
+        sice.dwSourceIndex = pCached->iSourceIndex;
+        sice.dwFlags = pCached->dwFlags;
+        if (DPA_Search(sic_hdpa, &sice, 0, SIC_CompareEntries, 0, DPAS_SORTED) != -1)
+            continue;
+
+        pRecord = (SIC_FILE_ENTRY *)(pBuffer + cRecords * sic_cbCacheRecord);
+        CopyMemory(pRecord, pCached, sic_cbCacheRecord);
+        cRecords++;
+    }
+
+    LeaveCriticalSection(&SHELL32_SicCS);
+
+    /* Icons are only ever appended to the image lists until the process
+     * detaches, so the indexes stay valid without the lock */
+    cMaxRecords = cRecords;
+    cRecords = 0;
+    for (i = 0; i < cMaxRecords; i++)
+    {
+        pRecord = (SIC_FILE_ENTRY *)(pBuffer + i * sic_cbCacheRecord);
+        if (i < cOwnRecords)
+        {
+            pBits = (LPBYTE)(pRecord + 1);
+
+            hIcon = ImageList_GetIcon(ShellSmallIconList, piListIndex[i], ILD_NORMAL);
+            bSuccess = hIcon && SIC_GetIconBits(hIcon, sic_cxSmall, sic_cySmall, pBits);
+            if (hIcon) DestroyIcon(hIcon);
+
+            hIcon = ImageList_GetIcon(ShellBigIconList, piListIndex[i], ILD_NORMAL);
+            bSuccess = bSuccess && hIcon &&
+                       SIC_GetIconBits(hIcon, sic_cxLarge, sic_cyLarge,
+                                       pBits + SIC_IconSize(sic_cxSmall, sic_cySmall));
+            if (hIcon) DestroyIcon(hIcon);
+
+            if (!bSuccess)
+                continue;
+        }
+
+        ppRecords[cRecords++] = pRecord;
+    }
+
+    qsort(ppRecords, cRecords, sizeof(*ppRecords), SIC_CompareRecords);
+
+    /* The magic is written last, a file that was cut short is never used */
+    header.dwMagic = 0;
+    header.dwVersion = SIC_FILE_VERSION;
+    header.dwColorMask = sic_ilMask;
+    header.cxSmall = sic_cxSmall;
+    header.cySmall = sic_cySmall;
+    header.cxLarge = sic_cxLarge;
+    header.cyLarge = sic_cyLarge;
+    header.cEntries = cRecords;
+
+    /* Nobody can open the new generation while it is being written. If another
+     * process saves at the same time, take the number after its generation */
+    dwGeneration = max(dwGeneration, SIC_FindCacheGeneration(MAXDWORD));
+    do
+    {
+        dwGeneration++;
+        if (!SIC_GetCacheFilePath(szPath, dwGeneration))
+            goto cleanup;
+
+        hFile = CreateFileW(szPath, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_HIDDEN, NULL);
+    } while (hFile == INVALID_HANDLE_VALUE && GetLastError() == ERROR_FILE_EXISTS);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create the icon cache (error %lu)\n", GetLastError());
+        goto cleanup;
+    }
+
+    bSuccess = WriteFile(hFile, &header, sizeof(header), &cbWritten, NULL);
+    for (i = 0; bSuccess && i < cRecords; i++)
+        bSuccess = WriteFile(hFile, ppRecords[i], sic_cbCacheRecord, &cbWritten, NULL);
+
+    if (bSuccess)
+    {
+        header.dwMagic = SIC_FILE_MAGIC;
+        bSuccess = SetFilePointer(hFile, 0, NULL, FILE_BEGIN) == 0 &&
+                   WriteFile(hFile, &header, sizeof(header), &cbWritten, NULL);
+    }
+    CloseHandle(hFile);
+
+    if (!bSuccess)
+    {
+        WARN("Failed to write the icon cache (error %lu)\n", GetLastError());
+        DeleteFileW(szPath);
+        goto cleanup;
+    }
+
+    TRACE("Wrote %lu icons to cache generation %lu\n", cRecords, dwGeneration);
+
+    EnterCriticalSection(&SHELL32_SicCS);
+    SIC_MapCacheFile();
+    LeaveCriticalSection(&SHELL32_SicCS);
+
+    SIC_DeleteOldCacheFiles(dwGeneration);
+
+cleanup:
+    if (piListIndex) HeapFree(GetProcessHeap(), 0, piListIndex);
+    if (ppRecords) HeapFree(GetProcessHeap(), 0, ppRecords);
+    if (pBuffer) HeapFree(GetProcessHeap(), 0, pBuffer);
+}
+
+/* Only one thread of the process saves at a time, sic_lSaving tells which */
+static BOOL SIC_BeginSaveIfNeeded(void)
+{
+    if (sic_cNewIcons < SIC_SAVE_COUNT &&
+        (sic_cNewIcons == 0 || GetTickCount() - sic_dwLastSave < SIC_SAVE_DELAY))
+    {
+        return FALSE;
+    }
+
+    return InterlockedCompareExchange(&sic_lSaving, TRUE, FALSE) == FALSE;
+}
+
+static void SIC_SaveCacheIfNeeded(void)
+{
+    if (SIC_BeginSaveIfNeeded())
+    {
+        SIC_SaveCache();
+        InterlockedExchange(&sic_lSaving, FALSE);
+    }
+}
+
+static DWORD WINAPI SIC_SaveCacheThreadProc(LPVOID lpParameter)
+{
+    SIC_SaveCache();
+    InterlockedExchange(&sic_lSaving, FALSE);
+    return 0;
+}
+
+/* Writing the cache takes a while, the caller may be a UI thread */
+static void SIC_QueueSaveCacheIfNeeded(void)
+{
+    if (SIC_BeginSaveIfNeeded() && !SHCreateThread(SIC_SaveCacheThreadProc, NULL, 0, NULL))
+        InterlockedExchange(&sic_lSaving, FALSE);
+}
+
 /****************************************************************************
  * SIC_LoadIcon                [internal]
  *
  * NOTES
  *  gets small/big icon by number from a file
  */
-static INT SIC_LoadIcon (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags)
+static INT SIC_LoadIcon (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags, const FILETIME *pftLastWrite)
 {
     HICON hiconLarge=0;
     HICON hiconSmall=0;
@@ -424,27 +1049,34 @@ static INT SIC_LoadIcon (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags)
         }
     }
 
-    ret = SIC_IconAppend (sSourceFile, dwSourceIndex, hiconSmall, hiconLarge, dwFlags);
+    ret = SIC_IconAppend (sSourceFile, dwSourceIndex, hiconSmall, hiconLarge, dwFlags, pftLastWrite);
     DestroyIcon(hiconLarge);
     DestroyIcon(hiconSmall);
+
+    if (ret != INVALID_INDEX && pftLastWrite)
+        InterlockedIncrement(&sic_cNewIcons);
+
     return ret;
 }
 /*****************************************************************************
- * SIC_GetIconIndex            [internal]
+ * SIC_GetIconIndexEx            [internal]
  *
  * Parameters
  *    sSourceFile    [IN]    filename of file containing the icon
  *    index        [IN]    index/resID (negated) in this file
+ *    bCacheOnly    [IN]    don't extract the icon if it isn't cached
  *
  * NOTES
  *  look in the cache for a proper icon. if not available the icon is taken
- *  from the file and cached
+ *  from the cache file or from the file itself and cached
  */
-INT SIC_GetIconIndex (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags )
+static INT SIC_GetIconIndexEx (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags, BOOL bCacheOnly)
 {
     SIC_ENTRY sice;
-    INT ret, index = INVALID_INDEX;
+    INT ret = INVALID_INDEX, index = INVALID_INDEX;
     WCHAR path[MAX_PATH];
+    FILETIME ftLastWrite;
+    BOOL bPersist;
 
     TRACE("%s %i\n", debugstr_w(sSourceFile), dwSourceIndex);
 
@@ -464,20 +1096,37 @@ INT SIC_GetIconIndex (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags )
       index = DPA_Search (sic_hdpa, &sice, 0, SIC_CompareEntries, 0, DPAS_SORTED);
     }
 
-    if ( INVALID_INDEX == index )
-    {
-          ret = SIC_LoadIcon (sSourceFile, dwSourceIndex, dwFlags);
-    }
-    else
+    if ( INVALID_INDEX != index )
     {
       TRACE("-- found\n");
       ret = ((LPSIC_ENTRY)DPA_GetPtr(sic_hdpa, index))->dwListIndex;
     }
 
     LeaveCriticalSection(&SHELL32_SicCS);
+
+    if ( INVALID_INDEX != ret )
+        return ret;
+
+    /* The lock is not held from here on, extracting can take long.
+     * Only icons of files that exist can be validated later on */
+    bPersist = SIC_GetLastWriteTime(path, &ftLastWrite);
+    if (bPersist)
+        ret = SIC_LoadCachedIcon(path, dwSourceIndex, dwFlags, &ftLastWrite);
+
+    if ( INVALID_INDEX == ret && !bCacheOnly )
+    {
+        ret = SIC_LoadIcon (sSourceFile, dwSourceIndex, dwFlags, bPersist ? &ftLastWrite : NULL);
+        SIC_QueueSaveCacheIfNeeded();
+    }
+
     return ret;
 }
 
+INT SIC_GetIconIndex (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags )
+{
+    return SIC_GetIconIndexEx(sSourceFile, dwSourceIndex, dwFlags, FALSE);
+}
+
 /*****************************************************************************
  * SIC_Initialize            [internal]
  */
@@ -582,18 +1231,34 @@ BOOL SIC_Initialize(void)
         goto end;
     }
 
-    if(SIC_IconAppend(swShell32Name, IDI_SHELL_DOCUMENT-1, hSm, hLg, 0) == INVALID_INDEX)
+    if(SIC_IconAppend(swShell32Name, IDI_SHELL_DOCUMENT-1, hSm, hLg, 0, NULL) == INVALID_INDEX)
     {
         ERR("Failed to add IDI_SHELL_DOCUMENT icon to cache.\n");
         goto end;
     }
-    if(SIC_IconAppend(swShell32Name, -IDI_SHELL_DOCUMENT, hSm, hLg, 0) == INVALID_INDEX)
+    if(SIC_IconAppend(swShell32Name, -IDI_SHELL_DOCUMENT, hSm, hLg, 0, NULL) == INVALID_INDEX)
     {
         ERR("Failed to add IDI_SHELL_DOCUMENT icon to cache.\n");
         goto end;
     }
     
-    /* Everything went fine */
+    /* Everything went fine, pick up the icons of earlier sessions */
+    sic_cxSmall = cx_small;
+    sic_cySmall = cy_small;
+    sic_cxLarge = cx_large;
+    sic_cyLarge = cy_large;
+    sic_ilMask = ilMask;
+    sic_dwLastSave = GetTickCount();
+
+    sic_cbCacheRecord = sizeof(SIC_FILE_ENTRY) +
+                        SIC_IconSize(cx_small, cy_small) +
+                        SIC_IconSize(cx_large, cy_large);
+    sic_cbCacheRecord = (sic_cbCacheRecord + sizeof(DWORD) - 1) & ~(sizeof(DWORD) - 1);
+
+    EnterCriticalSection(&SHELL32_SicCS);
+    SIC_MapCacheFile();
+    LeaveCriticalSection(&SHELL32_SicCS);
+
     result = TRUE;
     
 end:
@@ -643,6 +1308,10 @@ void SIC_Destroy(void)
     ImageList_Destroy(ShellBigIconList);
     ShellBigIconList = 0;
 
+    if (sic_pCacheFile) UnmapViewOfFile(sic_pCacheFile);
+    sic_pCacheFile = NULL;
+    sic_dwCacheGeneration = 0;
+
     LeaveCriticalSection(&SHELL32_SicCS);
     //DeleteCriticalSection(&SHELL32_SicCS); //static
 }
@@ -693,7 +1362,7 @@ static int SIC_LoadOverlayIcon(int icon_idx)
     if (!sic_hdpa)
         SIC_Initialize();
 
-    return SIC_LoadIcon(iconPath, iconIdx, 0);
+    return SIC_LoadIcon(iconPath, iconIdx, 0, NULL);
 }
 
 /*************************************************************************
@@ -767,7 +1436,7 @@ BOOL PidlToSicIndex (
       {
         if (INVALID_INDEX == iShortcutDefaultIndex)
         {
-          iShortcutDefaultIndex = SIC_LoadIcon(swShell32Name, 0, GIL_FORSHORTCUT);
+          iShortcutDefaultIndex = SIC_LoadIcon(swShell32Name, 0, GIL_FORSHORTCUT, NULL);
         }
         *pIndex = (INVALID_INDEX != iShortcutDefaultIndex ? iShortcutDefaultIndex : 0);
       }
@@ -810,17 +1479,201 @@ int WINAPI SHMapPIDLToSystemImageListIndex(
     return Index;
 }
 
+/*************************************************************************
+ * PidlToCachedSicIndex            [INTERNAL]
+ *
+ * Like PidlToSicIndex, but fails instead of extracting anything.
+ */
+static BOOL PidlToCachedSicIndex (
+    IShellFolder * sh,
+    LPCITEMIDLIST pidl,
+    UINT uFlags,
+    int * pIndex)
+{
+    CComPtr<IExtractIconW>        ei;
+    WCHAR        szIconFile[MAX_PATH];    /* file containing the icon */
+    INT        iSourceIndex;        /* index or resID(negated) in this file */
+    UINT        dwFlags = 0;
+
+    if (FAILED(sh->GetUIObjectOf(0, 1, &pidl, IID_NULL_PPV_ARG(IExtractIconW, &ei))))
+        return FALSE;
+
+    /* Handlers that would have to do real work to tell answer E_PENDING */
+    if (ei->GetIconLocation((uFlags & ~GIL_FORSHORTCUT) | GIL_ASYNC, szIconFile, MAX_PATH, &iSourceIndex, &dwFlags) != S_OK)
+        return FALSE;
+
+    *pIndex = SIC_GetIconIndexEx(szIconFile, iSourceIndex, uFlags, TRUE);
+    return (*pIndex != INVALID_INDEX);
+}
+
+/*************************************************************************
+ * CIconTask
+ *
+ * Looks up the icon of an item on the task scheduler's thread and hands
+ * it to the callback of SHMapIDListToImageListIndexAsync.
+ */
+class CIconTask :
+    public CComObjectRootEx<CComMultiThreadModelNoCS>,
+    public IRunnableTask
+{
+private:
+    CComPtr<IShellFolder> m_psf;
+    CComHeapPtr<ITEMIDLIST> m_pidl;
+    UINT m_uFlags;
+    PFNASYNCICONTASKBALLBACK m_pfn;
+    void *m_pvData;
+    void *m_pvHint;
+    BOOL m_bOpenIcon;
+    LONG m_lState;
+
+public:
+    CIconTask() :
+        m_uFlags(0),
+        m_pfn(NULL),
+        m_pvData(NULL),
+        m_pvHint(NULL),
+        m_bOpenIcon(FALSE),
+        m_lState(IRTIR_TASK_NOT_RUNNING)
+    {
+    }
+
+    HRESULT WINAPI Initialize(IShellFolder *psf, LPCITEMIDLIST pidl, UINT uFlags, PFNASYNCICONTASKBALLBACK pfn, void *pvData)
+    {
+        m_pidl.Attach(ILClone(pidl));
+        if (!m_pidl)
+            return E_OUTOFMEMORY;
+
+        m_psf = psf;
+        m_uFlags = uFlags;
+        m_pfn = pfn;
+        m_pvData = pvData;
+        return S_OK;
+    }
+
+    void SetHint(void *pvHint, BOOL bOpenIcon)
+    {
+        m_pvHint = pvHint;
+        m_bOpenIcon = bOpenIcon;
+    }
+
+    // *** IRunnableTask methods ***
+    virtual HRESULT STDMETHODCALLTYPE Run()
+    {
+        int iIndex = INVALID_INDEX, iIndexSel = INVALID_INDEX;
+
+        if (InterlockedCompareExchange(&m_lState, IRTIR_TASK_RUNNING, IRTIR_TASK_NOT_RUNNING) != IRTIR_TASK_NOT_RUNNING)
+            return E_FAIL;
+
+        PidlToSicIndex(m_psf, m_pidl, FALSE, m_uFlags, &iIndex);
+        if (m_bOpenIcon)
+            PidlToSicIndex(m_psf, m_pidl, FALSE, m_uFlags | GIL_OPENICON, &iIndexSel);
+
+        /* Nobody is waiting for the result if we were killed meanwhile */
+        if (InterlockedCompareExchange(&m_lState, IRTIR_TASK_FINISHED, IRTIR_TASK_RUNNING) == IRTIR_TASK_RUNNING)
+            m_pfn(m_pidl, m_pvData, m_pvHint, iIndex, iIndexSel);
+
+        SIC_SaveCacheIfNeeded();
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Kill(BOOL fWait)
+    {
+        InterlockedExchange(&m_lState, IRTIR_TASK_FINISHED);
+        return S_OK;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Suspend()
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT STDMETHODCALLTYPE Resume()
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual ULONG STDMETHODCALLTYPE IsRunning()
+    {
+        return m_lState;
+    }
+
+DECLARE_NOT_AGGREGATABLE(CIconTask)
+DECLARE_PROTECT_FINAL_CONSTRUCT()
+
+BEGIN_COM_MAP(CIconTask)
+    COM_INTERFACE_ENTRY_IID(IID_IRunnableTask, IRunnableTask)
+END_COM_MAP()
+};
+
 /*************************************************************************
  * SHMapIDListToImageListIndexAsync  [SHELL32.148]
+ *
+ * NOTES
+ *  Returns S_OK if the icon is cached already. Otherwise the icon is looked
+ *  up by a task on pts, E_PENDING is returned with the default icon and pfn
+ *  is called with the right one later on.
  */
 EXTERN_C HRESULT WINAPI SHMapIDListToImageListIndexAsync(IShellTaskScheduler *pts, IShellFolder *psf,
                                                 LPCITEMIDLIST pidl, UINT flags,
                                                 PFNASYNCICONTASKBALLBACK pfn, void *pvData, void *pvHint,
                                                 int *piIndex, int *piIndexSel)
 {
-    FIXME("(%p, %p, %p, 0x%08x, %p, %p, %p, %p, %p)\n",
+    CComObject<CIconTask> *pTask;
+    HRESULT hr;
+
+    TRACE("(%p, %p, %p, 0x%08x, %p, %p, %p, %p, %p)\n",
             pts, psf, pidl, flags, pfn, pvData, pvHint, piIndex, piIndexSel);
-    return E_FAIL;
+
+    if (!psf || !pidl || !piIndex)
+        return E_INVALIDARG;
+
+    if (!sic_hdpa)
+        SIC_Initialize();
+
+    if (SHELL_IsShortcut(pidl))
+        flags |= GIL_FORSHORTCUT;
+
+    if (PidlToCachedSicIndex(psf, pidl, flags, piIndex) &&
+        (!piIndexSel || PidlToCachedSicIndex(psf, pidl, flags | GIL_OPENICON, piIndexSel)))
+    {
+        return S_OK;
+    }
+
+    if (!pts || !pfn)
+    {
+        /* Nowhere to run it, so do it right away */
+        *piIndex = INVALID_INDEX;
+        PidlToSicIndex(psf, pidl, FALSE, flags, piIndex);
+        if (piIndexSel)
+        {
+            *piIndexSel = INVALID_INDEX;
+            PidlToSicIndex(psf, pidl, FALSE, flags | GIL_OPENICON, piIndexSel);
+        }
+        return S_OK;
+    }
+
+    hr = CComObject<CIconTask>::CreateInstance(&pTask);
+    if (FAILED_UNEXPECTEDLY(hr))
+        return hr;
+
+    pTask->AddRef();
+    hr = pTask->Initialize(psf, pidl, flags, pfn, pvData);
+    if (SUCCEEDED(hr))
+    {
+        pTask->SetHint(pvHint, piIndexSel != NULL);
+        hr = pts->AddTask(pTask, TOID_NULL, 0, ITSAT_DEFAULT_PRIORITY);
+    }
+    pTask->Release();
+
+    if (FAILED_UNEXPECTEDLY(hr))
+        return hr;
+
+    /* The document icon stands in until the real one arrives */
+    *piIndex = 0;
+    if (piIndexSel)
+        *piIndexSel = 0;
+
+    return E_PENDING;
 }
 
 /*************************************************************************
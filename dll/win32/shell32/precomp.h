@@ -90,6 +90,7 @@
 #include "shellmenu/CMergedFolder.h"
 #include "shellmenu/shellmenu.h"
 #include "CUserNotification.h"
+#include "CShellTaskScheduler.h"
 #include "dialogs/folder_options.h"
 #include "shelldesktop/CChangeNotifyServer.h"
 
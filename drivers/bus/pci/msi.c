@@ -0,0 +1,420 @@
+/*
+ * PROJECT:     ReactOS PCI Bus driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Message signaled interrupts (MSI and MSI-X)
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "pci.h"
+
+#include <ndk/halfuncs.h>
+
+#define NDEBUG
+#include <debug.h>
+
+/* MSI capability */
+#define PCI_MSI_CONTROL             0x02
+#define PCI_MSI_ADDRESS_LOW         0x04
+#define PCI_MSI_ADDRESS_HIGH        0x08
+#define PCI_MSI_DATA_32             0x08
+#define PCI_MSI_DATA_64             0x0C
+
+#define PCI_MSI_CONTROL_ENABLE      0x0001
+#define PCI_MSI_CONTROL_MME         0x0070
+#define PCI_MSI_CONTROL_64BIT       0x0080
+
+/* MSI-X capability */
+#define PCI_MSIX_CONTROL            0x02
+#define PCI_MSIX_TABLE              0x04
+
+#define PCI_MSIX_CONTROL_SIZE       0x07FF
+#define PCI_MSIX_CONTROL_MASK       0x4000
+#define PCI_MSIX_CONTROL_ENABLE     0x8000
+#define PCI_MSIX_TABLE_BIR          0x00000007
+
+/* MSI-X table entry */
+#define PCI_MSIX_ENTRY_SIZE         16
+#define PCI_MSIX_ENTRY_ADDRESS_LOW  0x00
+#define PCI_MSIX_ENTRY_ADDRESS_HIGH 0x04
+#define PCI_MSIX_ENTRY_DATA         0x08
+#define PCI_MSIX_ENTRY_CONTROL      0x0C
+#define PCI_MSIX_ENTRY_MASKED       0x00000001
+
+/*** PRIVATE *****************************************************************/
+
+static ULONG
+PciReadConfig(
+    IN PPCI_DEVICE Device,
+    IN ULONG Offset,
+    IN ULONG Length)
+{
+    ULONG Value = 0;
+
+    HalGetBusDataByOffset(PCIConfiguration,
+                          Device->BusNumber,
+                          Device->SlotNumber.u.AsULONG,
+                          &Value,
+                          Offset,
+                          Length);
+    return Value;
+}
+
+static VOID
+PciWriteConfig(
+    IN PPCI_DEVICE Device,
+    IN ULONG Offset,
+    IN ULONG Value,
+    IN ULONG Length)
+{
+    HalSetBusDataByOffset(PCIConfiguration,
+                          Device->BusNumber,
+                          Device->SlotNumber.u.AsULONG,
+                          &Value,
+                          Offset,
+                          Length);
+}
+
+static VOID
+PciFindMessageCapabilities(
+    IN PPCI_DEVICE Device,
+    IN PPCI_COMMON_CONFIG PciConfig)
+{
+    PCI_CAPABILITIES_HEADER Header;
+    UCHAR Offset;
+    ULONG Count = 0;
+
+    Device->MsiCapability = 0;
+    Device->MsixCapability = 0;
+
+    if (!(PciConfig->Status & PCI_STATUS_CAPABILITIES_LIST))
+        return;
+
+    /* Walk the list, guarding against loops in broken hardware */
+    Offset = PciConfig->u.type0.CapabilitiesPtr & ~3;
+    while (Offset >= PCI_COMMON_HDR_LENGTH && Count++ < 48)
+    {
+        *(PUSHORT)&Header = (USHORT)PciReadConfig(Device, Offset, sizeof(USHORT));
+
+        if (Header.CapabilityID == PCI_CAPABILITY_ID_MSI)
+            Device->MsiCapability = Offset;
+        else if (Header.CapabilityID == PCI_CAPABILITY_ID_MSIX)
+            Device->MsixCapability = Offset;
+
+        Offset = Header.Next & ~3;
+    }
+}
+
+static ULONG
+PciQueryMessageProperty(
+    IN HANDLE KeyHandle,
+    IN PCWSTR ValueName,
+    IN ULONG DefaultValue)
+{
+    UCHAR Buffer[sizeof(KEY_VALUE_PARTIAL_INFORMATION) + sizeof(ULONG)];
+    PKEY_VALUE_PARTIAL_INFORMATION Information = (PVOID)Buffer;
+    UNICODE_STRING Name;
+    ULONG Length;
+    NTSTATUS Status;
+
+    RtlInitUnicodeString(&Name, ValueName);
+    Status = ZwQueryValueKey(KeyHandle,
+                             &Name,
+                             KeyValuePartialInformation,
+                             Information,
+                             sizeof(Buffer),
+                             &Length);
+    if (!NT_SUCCESS(Status) ||
+        Information->Type != REG_DWORD ||
+        Information->DataLength != sizeof(ULONG))
+    {
+        return DefaultValue;
+    }
+
+    return *(PULONG)Information->Data;
+}
+
+/*
+ * Like Windows, only devices whose driver asks for it in the hardware key
+ * get message interrupts, since plenty of devices and drivers get them
+ * wrong.
+ */
+static BOOLEAN
+PciIsMessageSupported(
+    IN PDEVICE_OBJECT Pdo,
+    OUT PULONG MessageNumberLimit)
+{
+    UNICODE_STRING KeyName = RTL_CONSTANT_STRING(L"Interrupt Management\\MessageSignaledInterruptProperties");
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    HANDLE DeviceKey, KeyHandle;
+    BOOLEAN Supported;
+    NTSTATUS Status;
+
+    Status = IoOpenDeviceRegistryKey(Pdo,
+                                     PLUGPLAY_REGKEY_DEVICE,
+                                     KEY_READ,
+                                     &DeviceKey);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &KeyName,
+                               OBJ_CASE_INSENSITIVE | OBJ_KERNEL_HANDLE,
+                               DeviceKey,
+                               NULL);
+    Status = ZwOpenKey(&KeyHandle, KEY_READ, &ObjectAttributes);
+    ZwClose(DeviceKey);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    Supported = PciQueryMessageProperty(KeyHandle, L"MSISupported", 0) != 0;
+    *MessageNumberLimit = PciQueryMessageProperty(KeyHandle, L"MessageNumberLimit", 0);
+    ZwClose(KeyHandle);
+
+    return Supported;
+}
+
+static BOOLEAN
+PciProgramMsix(
+    IN PPCI_DEVICE Device,
+    IN PCM_PARTIAL_RESOURCE_DESCRIPTOR *Messages,
+    IN ULONG Count)
+{
+    PHYSICAL_ADDRESS TableAddress, MessageAddress;
+    ULONG Table, Bar, Data, i;
+    USHORT Control;
+    PUCHAR Entry, Mapping;
+    NTSTATUS Status;
+
+    Control = (USHORT)PciReadConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, sizeof(USHORT));
+    Table = PciReadConfig(Device, Device->MsixCapability + PCI_MSIX_TABLE, sizeof(ULONG));
+
+    /* The table lives in one of the memory BARs */
+    Bar = Table & PCI_MSIX_TABLE_BIR;
+    if (Bar >= PCI_TYPE0_ADDRESSES)
+        return FALSE;
+
+    TableAddress.QuadPart = PciReadConfig(Device,
+                                          FIELD_OFFSET(PCI_COMMON_CONFIG, u.type0.BaseAddresses[Bar]),
+                                          sizeof(ULONG));
+    if (TableAddress.LowPart & PCI_ADDRESS_IO_SPACE)
+        return FALSE;
+    if (((TableAddress.LowPart & PCI_ADDRESS_MEMORY_TYPE_MASK) == PCI_TYPE_64BIT) &&
+        (Bar + 1 < PCI_TYPE0_ADDRESSES))
+    {
+        TableAddress.HighPart = PciReadConfig(Device,
+                                              FIELD_OFFSET(PCI_COMMON_CONFIG, u.type0.BaseAddresses[Bar + 1]),
+                                              sizeof(ULONG));
+    }
+    TableAddress.LowPart &= ~0xF;
+    TableAddress.QuadPart += Table & ~PCI_MSIX_TABLE_BIR;
+
+    Mapping = MmMapIoSpace(TableAddress,
+                           ((Control & PCI_MSIX_CONTROL_SIZE) + 1) * PCI_MSIX_ENTRY_SIZE,
+                           MmNonCached);
+    if (!Mapping)
+        return FALSE;
+
+    /* Keep the whole function masked while the entries are inconsistent */
+    Control |= PCI_MSIX_CONTROL_ENABLE | PCI_MSIX_CONTROL_MASK;
+    PciWriteConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, Control, sizeof(USHORT));
+
+    for (i = 0; i <= (ULONG)(Control & PCI_MSIX_CONTROL_SIZE); i++)
+    {
+        Entry = Mapping + i * PCI_MSIX_ENTRY_SIZE;
+
+        if (i >= Count)
+        {
+            /* Entries we have no vector for stay masked */
+            WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_CONTROL), PCI_MSIX_ENTRY_MASKED);
+            continue;
+        }
+
+        Status = HalGetMessageRoute(Messages[i]->u.MessageInterrupt.Raw.Vector,
+                                    Messages[i]->u.MessageInterrupt.Raw.Affinity,
+                                    NULL,
+                                    &MessageAddress,
+                                    &Data);
+        if (!NT_SUCCESS(Status))
+        {
+            WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_CONTROL), PCI_MSIX_ENTRY_MASKED);
+            continue;
+        }
+
+        WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_ADDRESS_LOW), MessageAddress.LowPart);
+        WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_ADDRESS_HIGH), MessageAddress.HighPart);
+        WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_DATA), Data);
+        WRITE_REGISTER_ULONG((PULONG)(Entry + PCI_MSIX_ENTRY_CONTROL), 0);
+    }
+
+    MmUnmapIoSpace(Mapping, ((Control & PCI_MSIX_CONTROL_SIZE) + 1) * PCI_MSIX_ENTRY_SIZE);
+
+    Control &= ~PCI_MSIX_CONTROL_MASK;
+    PciWriteConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, Control, sizeof(USHORT));
+    return TRUE;
+}
+
+static BOOLEAN
+PciProgramMsi(
+    IN PPCI_DEVICE Device,
+    IN PCM_PARTIAL_RESOURCE_DESCRIPTOR Message)
+{
+    PHYSICAL_ADDRESS MessageAddress;
+    ULONG Data;
+    USHORT Control;
+    NTSTATUS Status;
+
+    Status = HalGetMessageRoute(Message->u.MessageInterrupt.Raw.Vector,
+                                Message->u.MessageInterrupt.Raw.Affinity,
+                                NULL,
+                                &MessageAddress,
+                                &Data);
+    if (!NT_SUCCESS(Status))
+        return FALSE;
+
+    Control = (USHORT)PciReadConfig(Device, Device->MsiCapability + PCI_MSI_CONTROL, sizeof(USHORT));
+
+    PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_ADDRESS_LOW, MessageAddress.LowPart, sizeof(ULONG));
+    if (Control & PCI_MSI_CONTROL_64BIT)
+    {
+        PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_ADDRESS_HIGH, MessageAddress.HighPart, sizeof(ULONG));
+        PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_DATA_64, Data, sizeof(USHORT));
+    }
+    else
+    {
+        PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_DATA_32, Data, sizeof(USHORT));
+    }
+
+    /* A single message */
+    Control &= ~PCI_MSI_CONTROL_MME;
+    Control |= PCI_MSI_CONTROL_ENABLE;
+    PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_CONTROL, Control, sizeof(USHORT));
+    return TRUE;
+}
+
+static VOID
+PciDisableMessageInterrupts(
+    IN PPCI_DEVICE Device)
+{
+    USHORT Control;
+
+    if (Device->MsiCapability)
+    {
+        Control = (USHORT)PciReadConfig(Device, Device->MsiCapability + PCI_MSI_CONTROL, sizeof(USHORT));
+        if (Control & PCI_MSI_CONTROL_ENABLE)
+        {
+            Control &= ~PCI_MSI_CONTROL_ENABLE;
+            PciWriteConfig(Device, Device->MsiCapability + PCI_MSI_CONTROL, Control, sizeof(USHORT));
+        }
+    }
+
+    if (Device->MsixCapability)
+    {
+        Control = (USHORT)PciReadConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, sizeof(USHORT));
+        if (Control & PCI_MSIX_CONTROL_ENABLE)
+        {
+            Control &= ~PCI_MSIX_CONTROL_ENABLE;
+            PciWriteConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, Control, sizeof(USHORT));
+        }
+    }
+}
+
+/*** PUBLIC ******************************************************************/
+
+ULONG
+PciQueryMessageCount(
+    IN PPDO_DEVICE_EXTENSION DeviceExtension,
+    IN PPCI_COMMON_CONFIG PciConfig)
+{
+    PPCI_DEVICE Device = DeviceExtension->PciDevice;
+    ULONG Count = 0, Limit = 0;
+    USHORT Control;
+
+    Device->MessageCount = 0;
+
+    if (PCI_CONFIGURATION_TYPE(PciConfig) != PCI_DEVICE_TYPE || !HalGetMessageRoute)
+        return 0;
+
+    PciFindMessageCapabilities(Device, PciConfig);
+    if (!Device->MsiCapability && !Device->MsixCapability)
+        return 0;
+
+    if (!PciIsMessageSupported(DeviceExtension->Common.DeviceObject, &Limit))
+        return 0;
+
+    if (Device->MsixCapability)
+    {
+        /* One message per processor is all a driver can make use of */
+        Control = (USHORT)PciReadConfig(Device, Device->MsixCapability + PCI_MSIX_CONTROL, sizeof(USHORT));
+        Count = min((ULONG)(Control & PCI_MSIX_CONTROL_SIZE) + 1, (ULONG)KeNumberProcessors);
+    }
+    else
+    {
+        /* Multiple MSI messages need a contiguous, aligned vector block */
+        Count = 1;
+    }
+
+    if (Limit != 0)
+        Count = min(Count, Limit);
+
+    DPRINT("Offering %lu %s message(s) for PCI device 0x%x on bus 0x%x\n",
+           Count,
+           Device->MsixCapability ? "MSI-X" : "MSI",
+           Device->SlotNumber.u.AsULONG,
+           Device->BusNumber);
+
+    Device->MessageCount = Count;
+    return Count;
+}
+
+BOOLEAN
+PciConfigureMessageInterrupts(
+    IN PPDO_DEVICE_EXTENSION DeviceExtension,
+    IN PCM_RESOURCE_LIST RawResources)
+{
+    PPCI_DEVICE Device = DeviceExtension->PciDevice;
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR Messages[32];
+    PCM_FULL_RESOURCE_DESCRIPTOR FullDescriptor;
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR Descriptor;
+    ULONG i, j, Count = 0;
+    BOOLEAN Programmed = FALSE;
+    USHORT Command;
+
+    if (RawResources)
+    {
+        FullDescriptor = &RawResources->List[0];
+        for (i = 0; i < RawResources->Count; i++, FullDescriptor = CmiGetNextResourceDescriptor(FullDescriptor))
+        {
+            for (j = 0; j < FullDescriptor->PartialResourceList.Count; j++)
+            {
+                Descriptor = &FullDescriptor->PartialResourceList.PartialDescriptors[j];
+                if (Descriptor->Type == CmResourceTypeInterrupt &&
+                    (Descriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE) &&
+                    Count < RTL_NUMBER_OF(Messages))
+                {
+                    Messages[Count++] = Descriptor;
+                }
+            }
+        }
+    }
+
+    if (Count && Device->MsixCapability)
+        Programmed = PciProgramMsix(Device, Messages, Count);
+    else if (Count && Device->MsiCapability)
+        Programmed = PciProgramMsi(Device, Messages[0]);
+
+    if (!Programmed)
+    {
+        /* The device got its line, make sure it isn't talking on the bus */
+        PciDisableMessageInterrupts(Device);
+        return FALSE;
+    }
+
+    /* Messages replace the pin, keep it quiet */
+    Command = (USHORT)PciReadConfig(Device, FIELD_OFFSET(PCI_COMMON_CONFIG, Command), sizeof(USHORT));
+    Command |= PCI_DISABLE_LEVEL_INTERRUPT;
+    PciWriteConfig(Device, FIELD_OFFSET(PCI_COMMON_CONFIG, Command), Command, sizeof(USHORT));
+
+    return TRUE;
+}
+
+/* EOF */
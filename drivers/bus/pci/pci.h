@@ -24,6 +24,12 @@ typedef struct _PCI_DEVICE
     BOOLEAN EnableIoSpace;
     // Enable bus master
     BOOLEAN EnableBusMaster;
+    // Offset of the MSI capability, 0 if none
+    UCHAR MsiCapability;
+    // Offset of the MSI-X capability, 0 if none
+    UCHAR MsixCapability;
+    // Number of message interrupts offered to the PnP manager
+    ULONG MessageCount;
 } PCI_DEVICE, *PPCI_DEVICE;
 
 
@@ -123,6 +129,18 @@ FdoPowerControl(
     PDEVICE_OBJECT DeviceObject,
     PIRP Irp);
 
+/* msi.c */
+
+ULONG
+PciQueryMessageCount(
+    IN PPDO_DEVICE_EXTENSION DeviceExtension,
+    IN PPCI_COMMON_CONFIG PciConfig);
+
+BOOLEAN
+PciConfigureMessageInterrupts(
+    IN PPDO_DEVICE_EXTENSION DeviceExtension,
+    IN PCM_RESOURCE_LIST RawResources);
+
 /* pci.c */
 
 NTSTATUS
@@ -381,9 +381,13 @@ PdoQueryResourceRequirements(
     PCI_COMMON_CONFIG PciConfig;
     PIO_RESOURCE_REQUIREMENTS_LIST ResourceList;
     PIO_RESOURCE_DESCRIPTOR Descriptor;
+    PIO_RESOURCE_LIST LineList;
     ULONG Size;
     ULONG ResCount = 0;
+    ULONG BarCount = 0;
+    ULONG MessageCount = 0;
     ULONG ListSize;
+    ULONG i;
     UCHAR Bar;
     ULONGLONG Base;
     ULONGLONG Length;
@@ -431,6 +435,10 @@ PdoQueryResourceRequirements(
 
         /* FIXME: Check ROM address */
 
+        /* Message interrupts go in a list of their own, ahead of the line */
+        BarCount = ResCount;
+        MessageCount = PciQueryMessageCount(DeviceExtension, &PciConfig);
+
         if (PciConfig.u.type0.InterruptPin != 0)
             ResCount++;
     }
@@ -472,6 +480,11 @@ PdoQueryResourceRequirements(
     /* Calculate the resource list size */
     ListSize = FIELD_OFFSET(IO_RESOURCE_REQUIREMENTS_LIST, List[0].Descriptors) +
                ResCount * sizeof(IO_RESOURCE_DESCRIPTOR);
+    if (MessageCount != 0)
+    {
+        ListSize += FIELD_OFFSET(IO_RESOURCE_LIST, Descriptors) +
+                    (BarCount + MessageCount) * sizeof(IO_RESOURCE_DESCRIPTOR);
+    }
 
     DPRINT("ListSize %lu (0x%lx)\n", ListSize, ListSize);
 
@@ -492,11 +505,19 @@ PdoQueryResourceRequirements(
     ResourceList->SlotNumber = DeviceExtension->PciDevice->SlotNumber.u.AsULONG;
     ResourceList->AlternativeLists = 1;
 
-    ResourceList->List[0].Version = 1;
-    ResourceList->List[0].Revision = 1;
-    ResourceList->List[0].Count = ResCount;
+    /* The line based list comes last when messages are preferred */
+    LineList = &ResourceList->List[0];
+    if (MessageCount != 0)
+    {
+        LineList = (PIO_RESOURCE_LIST)&ResourceList->List[0].Descriptors[BarCount + MessageCount];
+        ResourceList->AlternativeLists = 2;
+    }
+
+    LineList->Version = 1;
+    LineList->Revision = 1;
+    LineList->Count = ResCount;
 
-    Descriptor = &ResourceList->List[0].Descriptors[0];
+    Descriptor = &LineList->Descriptors[0];
     if (PCI_CONFIGURATION_TYPE(&PciConfig) == PCI_DEVICE_TYPE)
     {
         for (Bar = 0; Bar < PCI_TYPE0_ADDRESSES;)
@@ -589,6 +610,41 @@ PdoQueryResourceRequirements(
 
             Descriptor->u.Interrupt.MinimumVector = 0;
             Descriptor->u.Interrupt.MaximumVector = 0xFF;
+
+            /* The boot configuration leaves the line out when we offer
+               messages, so pin it to the one the firmware wired up */
+            if ((MessageCount != 0) &&
+                (PciConfig.u.type0.InterruptLine != 0) &&
+                (PciConfig.u.type0.InterruptLine != 0xFF))
+            {
+                Descriptor->u.Interrupt.MinimumVector =
+                Descriptor->u.Interrupt.MaximumVector = PciConfig.u.type0.InterruptLine;
+            }
+        }
+
+        if (MessageCount != 0)
+        {
+            /* Same ranges, with messages in place of the line */
+            ResourceList->List[0].Version = 1;
+            ResourceList->List[0].Revision = 1;
+            ResourceList->List[0].Count = BarCount + MessageCount;
+
+            RtlCopyMemory(&ResourceList->List[0].Descriptors[0],
+                          &LineList->Descriptors[0],
+                          BarCount * sizeof(IO_RESOURCE_DESCRIPTOR));
+
+            Descriptor = &ResourceList->List[0].Descriptors[BarCount];
+            for (i = 0; i < MessageCount; i++, Descriptor++)
+            {
+                Descriptor->Option = 0; /* Required */
+                Descriptor->Type = CmResourceTypeInterrupt;
+                Descriptor->ShareDisposition = CmResourceShareDeviceExclusive;
+                Descriptor->Flags = CM_RESOURCE_INTERRUPT_LATCHED |
+                                    CM_RESOURCE_INTERRUPT_MESSAGE;
+
+                Descriptor->u.Interrupt.MinimumVector = CM_RESOURCE_INTERRUPT_MESSAGE_TOKEN;
+                Descriptor->u.Interrupt.MaximumVector = CM_RESOURCE_INTERRUPT_MESSAGE_TOKEN;
+            }
         }
     }
     else if (PCI_CONFIGURATION_TYPE(&PciConfig) == PCI_BRIDGE_TYPE)
@@ -709,6 +765,7 @@ PdoQueryResources(
     PCM_PARTIAL_RESOURCE_DESCRIPTOR Descriptor;
     ULONG Size;
     ULONG ResCount = 0;
+    ULONG MessageCount = 0;
     ULONG ListSize;
     UCHAR Bar;
     ULONGLONG Base;
@@ -754,9 +811,13 @@ PdoQueryResources(
                 ResCount++;
         }
 
+        /* The PnP manager assigns the messages, so the line isn't ours to claim */
+        MessageCount = PciQueryMessageCount(DeviceExtension, &PciConfig);
+
         if ((PciConfig.u.type0.InterruptPin != 0) &&
             (PciConfig.u.type0.InterruptLine != 0) &&
-            (PciConfig.u.type0.InterruptLine != 0xFF))
+            (PciConfig.u.type0.InterruptLine != 0xFF) &&
+            (MessageCount == 0))
             ResCount++;
     }
     else if (PCI_CONFIGURATION_TYPE(&PciConfig) == PCI_BRIDGE_TYPE)
@@ -867,7 +928,8 @@ PdoQueryResources(
         /* Add interrupt resource */
         if ((PciConfig.u.type0.InterruptPin != 0) &&
             (PciConfig.u.type0.InterruptLine != 0) &&
-            (PciConfig.u.type0.InterruptLine != 0xFF))
+            (PciConfig.u.type0.InterruptLine != 0xFF) &&
+            (MessageCount == 0))
         {
             Descriptor->Type = CmResourceTypeInterrupt;
             Descriptor->ShareDisposition = CmResourceShareShared;
@@ -1344,7 +1406,8 @@ PdoStartDevice(
                but only one is allowed and it must be the last one in the list! */
             RawPartialDesc = &RawFullDesc->PartialResourceList.PartialDescriptors[ii];
 
-            if (RawPartialDesc->Type == CmResourceTypeInterrupt)
+            if (RawPartialDesc->Type == CmResourceTypeInterrupt &&
+                !(RawPartialDesc->Flags & CM_RESOURCE_INTERRUPT_MESSAGE))
             {
                 DPRINT("Assigning IRQ %u to PCI device 0x%x on bus 0x%x\n",
                         RawPartialDesc->u.Interrupt.Vector,
@@ -1404,6 +1467,9 @@ PdoStartDevice(
         DBGPRINT("None\n");
     }
 
+    /* With memory space on, the MSI-X table can be reached */
+    PciConfigureMessageInterrupts(DeviceExtension, RawResList);
+
     return STATUS_SUCCESS;
 }
 
@@ -353,7 +353,22 @@ static VOID NTAPI ParaNdis5_MiniportISR(OUT PBOOLEAN InterruptRecognized,
     PARANDIS_ADAPTER *pContext = (PARANDIS_ADAPTER *)MiniportAdapterContext;
     BOOLEAN b;
     *QueueMiniportHandleInterrupt = FALSE;
-    b = ParaNdis_OnLegacyInterrupt(pContext, QueueMiniportHandleInterrupt);
+    if (pContext->bUsingMSIX)
+    {
+        /* the message is never shared and the ISR status is not latched,
+           so let the DPC look at every source */
+        b = pContext->powerState == NdisDeviceStateD0;
+        if (b)
+        {
+            ParaNdis_VirtIODisableIrqSynchronized(pContext, isAny);
+            InterlockedOr(&pContext->InterruptStatus, isAny);
+            *QueueMiniportHandleInterrupt = TRUE;
+        }
+    }
+    else
+    {
+        b = ParaNdis_OnLegacyInterrupt(pContext, QueueMiniportHandleInterrupt);
+    }
     *InterruptRecognized = b;
     DEBUG_EXIT_STATUS(7, (ULONG)b);
 }
@@ -11,6 +11,7 @@
 #define __NDISSYS_H
 
 #include <ndis.h>
+#include <iointex.h>
 
 #include "debug.h"
 #include "miniport.h"
@@ -99,6 +99,49 @@ BOOLEAN NTAPI ServiceRoutine(
   return InterruptRecognized;
 }
 
+BOOLEAN NTAPI MessageServiceRoutine(
+    IN  PKINTERRUPT Interrupt,
+    IN  PVOID       ServiceContext,
+    IN  ULONG       MessageId)
+/*
+ * FUNCTION: Message signaled interrupt service routine
+ * ARGUMENTS:
+ *     Interrupt      = Pointer to interrupt object
+ *     ServiceContext = Pointer to context information (PNDIS_MINIPORT_INTERRUPT)
+ *     MessageId      = Index of the message that was signaled
+ * RETURNS
+ *     TRUE if a miniport controlled device generated the interrupt
+ * NOTES
+ *     NDIS 5 miniports have a single ISR, so every message goes there
+ */
+{
+  UNREFERENCED_PARAMETER(MessageId);
+
+  return ServiceRoutine(Interrupt, ServiceContext);
+}
+
+static BOOLEAN
+MiniHasMessageInterrupts(
+    IN  PLOGICAL_ADAPTER Adapter)
+{
+  PCM_RESOURCE_LIST ResourceList = Adapter->NdisMiniportBlock.AllocatedResourcesTranslated;
+  ULONG i;
+
+  if (!ResourceList)
+      return FALSE;
+
+  for (i = 0; i < ResourceList->List[0].PartialResourceList.Count; i++)
+    {
+      PCM_PARTIAL_RESOURCE_DESCRIPTOR Descriptor = &ResourceList->List[0].PartialResourceList.PartialDescriptors[i];
+
+      if (Descriptor->Type == CmResourceTypeInterrupt &&
+          (Descriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE))
+          return TRUE;
+    }
+
+  return FALSE;
+}
+
 /*
  * @implemented
  */
@@ -705,8 +748,23 @@ NdisMDeregisterInterrupt(
  *     Interrupt = Pointer to interrupt object
  */
 {
+    PLOGICAL_ADAPTER Adapter = CONTAINING_RECORD(Interrupt->Miniport, LOGICAL_ADAPTER, NdisMiniportBlock);
+
     NDIS_DbgPrint(MAX_TRACE, ("Called.\n"));
-    IoDisconnectInterrupt(Interrupt->InterruptObject);
+
+    if (Adapter->InterruptMessageTable)
+      {
+        IO_DISCONNECT_INTERRUPT_PARAMETERS Parameters;
+
+        Parameters.Version = CONNECT_MESSAGE_BASED;
+        Parameters.ConnectionContext.InterruptMessageTable = Adapter->InterruptMessageTable;
+        IoDisconnectInterruptEx(&Parameters);
+        Adapter->InterruptMessageTable = NULL;
+      }
+    else
+      {
+        IoDisconnectInterrupt(Interrupt->InterruptObject);
+      }
     Interrupt->Miniport->RegisteredInterrupts--;
 
     if (Interrupt->Miniport->Interrupt == Interrupt)
@@ -982,6 +1040,36 @@ NdisMRegisterInterrupt(
   Interrupt->IsrRequested = RequestIsr;
   Interrupt->Miniport = &Adapter->NdisMiniportBlock;
 
+  /* The PnP manager gave the adapter messages, the vector the miniport passed is meaningless */
+  if (MiniHasMessageInterrupts(Adapter))
+    {
+      IO_CONNECT_INTERRUPT_PARAMETERS Parameters;
+
+      RtlZeroMemory(&Parameters, sizeof(Parameters));
+      Parameters.Version = CONNECT_MESSAGE_BASED;
+      Parameters.MessageBased.PhysicalDeviceObject = Adapter->NdisMiniportBlock.PhysicalDeviceObject;
+      Parameters.MessageBased.ConnectionContext.InterruptMessageTable = &Adapter->InterruptMessageTable;
+      Parameters.MessageBased.MessageServiceRoutine = MessageServiceRoutine;
+      Parameters.MessageBased.ServiceContext = Interrupt;
+      Parameters.MessageBased.SpinLock = &Interrupt->DpcCountLock;
+      Parameters.MessageBased.FloatingSave = FALSE;
+
+      Status = IoConnectInterruptEx(&Parameters);
+
+      NDIS_DbgPrint(MAX_TRACE, ("Leaving. Status (0x%X).\n", Status));
+
+      if (NT_SUCCESS(Status)) {
+          /* All messages share our lock, so any of them synchronizes with the ISR */
+          Interrupt->InterruptObject = Adapter->InterruptMessageTable->MessageInfo[0].InterruptObject;
+          Adapter->NdisMiniportBlock.Interrupt = Interrupt;
+          Adapter->NdisMiniportBlock.RegisteredInterrupts++;
+          return NDIS_STATUS_SUCCESS;
+      }
+
+      NDIS_DbgPrint(MIN_TRACE, ("Failed to connect message interrupts. Status (0x%X).\n", Status));
+      return NDIS_STATUS_FAILURE;
+    }
+
   MappedIRQ = HalGetInterruptVector(Adapter->NdisMiniportBlock.BusType, Adapter->NdisMiniportBlock.BusNumber,
                                     InterruptLevel, InterruptVector, &DIrql,
                                     &Affinity);
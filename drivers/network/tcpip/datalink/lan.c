@@ -313,6 +313,7 @@ VOID LanReceiveWorker( PVOID Context ) {
     IP_PACKET IPPacket;
     BOOLEAN LegacyReceive;
     PIP_INTERFACE Interface;
+    NDIS_TCP_IP_CHECKSUM_PACKET_INFO ChecksumInfo;
 
     TI_DbgPrint(DEBUG_DATALINK, ("Called.\n"));
 
@@ -358,6 +359,16 @@ VOID LanReceiveWorker( PVOID Context ) {
 
         /* Calculate packet size (excluding media header) */
         NdisQueryPacketLength(IPPacket.NdisPacket, &IPPacket.TotalSize);
+
+        /* Checksums the adapter verified need not be computed again */
+        ChecksumInfo.Value = (ULONG)(ULONG_PTR)NDIS_PER_PACKET_INFO_FROM_PACKET(IPPacket.NdisPacket,
+                                                                               TcpIpChecksumPacketInfo);
+        if (ChecksumInfo.Receive.NdisPacketIpChecksumSucceeded)
+            IPPacket.Flags |= IP_PACKET_FLAG_IP_CHECKSUM_OK;
+        if (ChecksumInfo.Receive.NdisPacketTcpChecksumSucceeded)
+            IPPacket.Flags |= IP_PACKET_FLAG_TCP_CHECKSUM_OK;
+        if (ChecksumInfo.Receive.NdisPacketUdpChecksumSucceeded)
+            IPPacket.Flags |= IP_PACKET_FLAG_UDP_CHECKSUM_OK;
     }
 
     TI_DbgPrint
@@ -1006,6 +1017,15 @@ VOID LANTransmit(
 
     RtlCopyMemory(Data + Adapter->HeaderSize, OldData, OldSize);
 
+    /* Carry over the offloads the IP layer asked for */
+    if (Type == LAN_PROTO_IPv4) {
+        NDIS_PER_PACKET_INFO_FROM_PACKET(XmitPacket, TcpIpChecksumPacketInfo) =
+            NDIS_PER_PACKET_INFO_FROM_PACKET(NdisPacket, TcpIpChecksumPacketInfo);
+        NDIS_PER_PACKET_INFO_FROM_PACKET(XmitPacket, TcpLargeSendPacketInfo) =
+            NDIS_PER_PACKET_INFO_FROM_PACKET(NdisPacket, TcpLargeSendPacketInfo);
+        NdisSetPacketFlags(XmitPacket, NDIS_PROTOCOL_ID_TCP_IP);
+    }
+
     (*PC(NdisPacket)->DLComplete)(PC(NdisPacket)->Context, NdisPacket, NDIS_STATUS_SUCCESS);
 
     switch (Adapter->Media) {
@@ -1056,12 +1076,6 @@ VOID LANTransmit(
 		   ((PCHAR)LinkAddress)[5] & 0xff));
 	}
 
-    if (Adapter->MTU < Size) {
-        /* This is NOT a pointer. MSDN explicitly says so. */
-        NDIS_PER_PACKET_INFO_FROM_PACKET(NdisPacket,
-                                         TcpLargeSendPacketInfo) = (PVOID)((ULONG_PTR)Adapter->MTU);
-    }
-
     /* Update interface stats */
     Interface->Stats.OutBytes += Size;
 
@@ -1309,6 +1323,186 @@ VOID GetName( PUNICODE_STRING RegistryKey,
     AppendUnicodeString( OutName, &PartialRegistryKey, FALSE );
 }
 
+static PVOID AppendOffloadTask(
+    PUCHAR Buffer,
+    PULONG Offset,
+    PULONG LastTask,
+    NDIS_TASK Task,
+    ULONG TaskBufferLength)
+/*
+ * FUNCTION: Adds a task to an OID_TCP_TASK_OFFLOAD set request
+ * ARGUMENTS:
+ *     Buffer           = Pointer to the request, starting with its header
+ *     Offset           = Address of offset of the end of the request
+ *     LastTask         = Address of offset of the last task (0 for none)
+ *     Task             = Task to add
+ *     TaskBufferLength = Size of the task specific information
+ * RETURNS:
+ *     Pointer to the task specific information to fill in
+ */
+{
+    PNDIS_TASK_OFFLOAD TaskOffload = (PNDIS_TASK_OFFLOAD)(Buffer + *Offset);
+
+    TaskOffload->Version = NDIS_TASK_OFFLOAD_VERSION;
+    TaskOffload->Size = sizeof(NDIS_TASK_OFFLOAD);
+    TaskOffload->Task = Task;
+    TaskOffload->OffsetNextTask = 0;
+    TaskOffload->TaskBufferLength = TaskBufferLength;
+
+    /* The first task is found from the header, the others from their predecessor */
+    if (*LastTask == 0)
+        ((PNDIS_TASK_OFFLOAD_HEADER)Buffer)->OffsetFirstTask = *Offset;
+    else
+        ((PNDIS_TASK_OFFLOAD)(Buffer + *LastTask))->OffsetNextTask = *Offset - *LastTask;
+
+    *LastTask = *Offset;
+    *Offset += ALIGN_UP_BY(FIELD_OFFSET(NDIS_TASK_OFFLOAD, TaskBuffer) + TaskBufferLength,
+                           sizeof(ULONG));
+
+    return TaskOffload->TaskBuffer;
+}
+
+VOID NegotiateTaskOffload(
+    PLAN_ADAPTER Adapter,
+    PIP_INTERFACE IF)
+/*
+ * FUNCTION: Enables the checksum and large send offloads of an adapter
+ * ARGUMENTS:
+ *     Adapter = Pointer to LAN_ADAPTER structure
+ *     IF      = Pointer to IP interface of the adapter
+ * NOTES:
+ *     Only the IPv4 offloads the stack makes use of are enabled, and
+ *     are recorded in the interface. Miniports which do not know
+ *     OID_TCP_TASK_OFFLOAD leave everything to software.
+ */
+{
+    UCHAR Buffer[256];
+    PNDIS_TASK_OFFLOAD_HEADER Header = (PNDIS_TASK_OFFLOAD_HEADER)Buffer;
+    PNDIS_TASK_OFFLOAD TaskOffload;
+    NDIS_TASK_TCP_IP_CHECKSUM Checksum;
+    NDIS_TASK_TCP_LARGE_SEND LargeSend;
+    BOOLEAN ChecksumFound = FALSE, LargeSendFound = FALSE;
+    PVOID TaskBuffer;
+    ULONG Offset, LastTask, OffloadFlags = 0;
+    NDIS_STATUS NdisStatus;
+
+    IF->OffloadFlags = 0;
+    IF->LargeSendMaxSize = 0;
+
+    if (Adapter->Media != NdisMedium802_3)
+        return;
+
+    RtlZeroMemory(Buffer, sizeof(Buffer));
+    Header->Version = NDIS_TASK_OFFLOAD_VERSION;
+    Header->Size = sizeof(NDIS_TASK_OFFLOAD_HEADER);
+    Header->EncapsulationFormat.Encapsulation = IEEE_802_3_Encapsulation;
+    Header->EncapsulationFormat.Flags.FixedHeaderSize = 1;
+    Header->EncapsulationFormat.EncapsulationHeaderSize = Adapter->HeaderSize;
+
+    NdisStatus = NDISCall(Adapter,
+                          NdisRequestQueryInformation,
+                          OID_TCP_TASK_OFFLOAD,
+                          Buffer,
+                          sizeof(Buffer));
+    if (NdisStatus != NDIS_STATUS_SUCCESS) {
+        TI_DbgPrint(DEBUG_DATALINK, ("No task offload (0x%X).\n", NdisStatus));
+        return;
+    }
+
+    /* Pick the capabilities out of the task list */
+    Offset = Header->OffsetFirstTask;
+    while (Offset != 0 &&
+           Offset + FIELD_OFFSET(NDIS_TASK_OFFLOAD, TaskBuffer) <= sizeof(Buffer)) {
+        TaskOffload = (PNDIS_TASK_OFFLOAD)(Buffer + Offset);
+
+        if (TaskOffload->TaskBufferLength > sizeof(Buffer) - Offset -
+                                            FIELD_OFFSET(NDIS_TASK_OFFLOAD, TaskBuffer))
+            break;
+
+        if (TaskOffload->Task == TcpIpChecksumNdisTask &&
+            TaskOffload->TaskBufferLength >= sizeof(NDIS_TASK_TCP_IP_CHECKSUM)) {
+            RtlCopyMemory(&Checksum, TaskOffload->TaskBuffer, sizeof(Checksum));
+            ChecksumFound = TRUE;
+        } else if (TaskOffload->Task == TcpLargeSendNdisTask &&
+                   TaskOffload->TaskBufferLength >= sizeof(NDIS_TASK_TCP_LARGE_SEND)) {
+            RtlCopyMemory(&LargeSend, TaskOffload->TaskBuffer, sizeof(LargeSend));
+            LargeSendFound = TRUE;
+        }
+
+        if (TaskOffload->OffsetNextTask == 0)
+            break;
+        Offset += TaskOffload->OffsetNextTask;
+    }
+
+    /* Build the set request in place of the answer */
+    RtlZeroMemory(Buffer + sizeof(NDIS_TASK_OFFLOAD_HEADER),
+                  sizeof(Buffer) - sizeof(NDIS_TASK_OFFLOAD_HEADER));
+    Header->OffsetFirstTask = 0;
+    Offset = sizeof(NDIS_TASK_OFFLOAD_HEADER);
+    LastTask = 0;
+
+    if (ChecksumFound) {
+        /* lwIP sends TCP timestamps, and raw sockets may add IP options */
+        if (!Checksum.V4Transmit.IpOptionsSupported)
+            Checksum.V4Transmit.IpChecksum = 0;
+        if (!Checksum.V4Transmit.TcpOptionsSupported)
+            Checksum.V4Transmit.TcpChecksum = 0;
+        RtlZeroMemory(&Checksum.V6Transmit, sizeof(Checksum.V6Transmit));
+        RtlZeroMemory(&Checksum.V6Receive, sizeof(Checksum.V6Receive));
+
+        if (Checksum.V4Transmit.IpChecksum)
+            OffloadFlags |= IP_OFFLOAD_IP_CHECKSUM;
+        if (Checksum.V4Transmit.TcpChecksum)
+            OffloadFlags |= IP_OFFLOAD_TCP_CHECKSUM;
+        if (Checksum.V4Transmit.UdpChecksum)
+            OffloadFlags |= IP_OFFLOAD_UDP_CHECKSUM;
+
+        TaskBuffer = AppendOffloadTask(Buffer,
+                                       &Offset,
+                                       &LastTask,
+                                       TcpIpChecksumNdisTask,
+                                       sizeof(Checksum));
+        RtlCopyMemory(TaskBuffer, &Checksum, sizeof(Checksum));
+    }
+
+    /* lwIP segments carry timestamps and may come out as just two packets */
+    if (LargeSendFound &&
+        LargeSend.Version == NDIS_TASK_TCP_LARGE_SEND_V0 &&
+        LargeSend.TcpOptions &&
+        LargeSend.MinSegmentCount <= 2 &&
+        LargeSend.MaxOffLoadSize > Adapter->MTU) {
+        LargeSend.IpOptions = FALSE;
+        OffloadFlags |= IP_OFFLOAD_LARGE_SEND;
+
+        TaskBuffer = AppendOffloadTask(Buffer,
+                                       &Offset,
+                                       &LastTask,
+                                       TcpLargeSendNdisTask,
+                                       sizeof(LargeSend));
+        RtlCopyMemory(TaskBuffer, &LargeSend, sizeof(LargeSend));
+    }
+
+    if (Header->OffsetFirstTask == 0)
+        return;
+
+    NdisStatus = NDISCall(Adapter,
+                          NdisRequestSetInformation,
+                          OID_TCP_TASK_OFFLOAD,
+                          Buffer,
+                          Offset);
+    if (NdisStatus != NDIS_STATUS_SUCCESS) {
+        TI_DbgPrint(MIN_TRACE, ("Could not enable task offload (0x%X).\n", NdisStatus));
+        return;
+    }
+
+    IF->OffloadFlags = OffloadFlags;
+    if (OffloadFlags & IP_OFFLOAD_LARGE_SEND)
+        IF->LargeSendMaxSize = LargeSend.MaxOffLoadSize;
+
+    TI_DbgPrint(DEBUG_DATALINK, ("Offload flags 0x%X, large send up to %u bytes.\n",
+                                 IF->OffloadFlags, IF->LargeSendMaxSize));
+}
+
 BOOLEAN BindAdapter(
     PLAN_ADAPTER Adapter,
     PNDIS_STRING RegistryPath)
@@ -1410,6 +1604,9 @@ BOOLEAN BindAdapter(
     if (NdisStatus != NDIS_STATUS_SUCCESS)
         return FALSE;
 
+    /* Must be known before the TCP layer sees the interface */
+    NegotiateTaskOffload(Adapter, IF);
+
     /* Register interface with IP layer */
     IPRegisterInterface(IF);
 
@@ -90,7 +90,10 @@ typedef struct _IP_PACKET {
     IP_ADDRESS DstAddr;                 /* Destination address */
 } IP_PACKET, *PIP_PACKET;
 
-#define IP_PACKET_FLAG_RAW      0x01    /* Raw IP packet */
+#define IP_PACKET_FLAG_RAW              0x01    /* Raw IP packet */
+#define IP_PACKET_FLAG_IP_CHECKSUM_OK   0x02    /* Adapter verified the IP header checksum */
+#define IP_PACKET_FLAG_TCP_CHECKSUM_OK  0x04    /* Adapter verified the TCP checksum */
+#define IP_PACKET_FLAG_UDP_CHECKSUM_OK  0x08    /* Adapter verified the UDP checksum */
 
 
 /* Packet context */
@@ -168,8 +171,16 @@ typedef struct _IP_INTERFACE {
     LL_TRANSMIT_ROUTINE Transmit; /* Pointer to transmit function */
     PVOID TCPContext;             /* TCP Content for this interface */
     SEND_RECV_STATS Stats;        /* Send/Receive statistics */
+    ULONG OffloadFlags;           /* Work done by the adapter (see IP_OFFLOAD_xx below) */
+    UINT  LargeSendMaxSize;       /* Largest TCP payload the adapter segments */
 } IP_INTERFACE, *PIP_INTERFACE;
 
+/* Offloads enabled on the adapter of an interface */
+#define IP_OFFLOAD_IP_CHECKSUM  0x01    /* IPv4 header checksum on send */
+#define IP_OFFLOAD_TCP_CHECKSUM 0x02    /* TCP checksum on send */
+#define IP_OFFLOAD_UDP_CHECKSUM 0x04    /* UDP checksum on send */
+#define IP_OFFLOAD_LARGE_SEND   0x08    /* TCP segmentation */
+
 typedef struct _IP_SET_ADDRESS {
     ULONG NteIndex;
     IPv4_RAW_ADDRESS Address;
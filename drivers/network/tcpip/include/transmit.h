@@ -25,6 +25,7 @@ typedef struct IPFRAGMENT_CONTEXT {
     UINT BytesLeft;                     /* Number of bytes left to send */
     UINT PathMTU;                       /* Path Maximum Transmission Unit */
     PNEIGHBOR_CACHE_ENTRY NCE;          /* Pointer to NCE to use */
+    BOOLEAN OffloadIpChecksum;          /* Adapter computes the IP header checksum */
     KEVENT Event;                       /* Signalled when the transmission is complete */
     NDIS_STATUS Status;                 /* Status of the transmission */
 } IPFRAGMENT_CONTEXT, *PIPFRAGMENT_CONTEXT;
@@ -32,4 +33,6 @@ typedef struct IPFRAGMENT_CONTEXT {
 
 NTSTATUS IPSendDatagram(PIP_PACKET IPPacket, PNEIGHBOR_CACHE_ENTRY NCE);
 
+VOID IPSetChecksumOffload(PNDIS_PACKET NdisPacket, UCHAR Protocol);
+
 /* EOF */
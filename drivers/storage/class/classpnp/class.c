@@ -1445,6 +1445,10 @@ NTSTATUS NTAPI ClassPnpStartDevice(IN PDEVICE_OBJECT DeviceObject)
              *  Allocate/initialize TRANSFER_PACKETs and related resources.
              */
             status = InitializeTransferPackets(DeviceObject);
+
+            if (NT_SUCCESS(status)){
+                InitializeRequestQueue(DeviceObject);
+            }
         }
 
         //
@@ -1679,9 +1683,15 @@ NTSTATUS NTAPI ClassReadWrite(IN PDEVICE_OBJECT DeviceObject, IN PIRP Irp)
 
                         /*
                          *  Perform the actual transfer(s) on the hardware
-                         *  to service this request.
+                         *  to service this request, going through the
+                         *  request queue if it is enabled for this disk.
                          */
-                        ServiceTransferRequest(DeviceObject, Irp);
+                        if (commonExtension->PartitionZeroExtension->PrivateFdoData->RequestQueue.Enabled){
+                            EnqueueTransferRequest(DeviceObject, Irp);
+                        }
+                        else {
+                            ServiceTransferRequest(DeviceObject, Irp);
+                        }
                         status = STATUS_PENDING;
                     }
                     else {
@@ -5553,6 +5563,36 @@ ClassDeviceControl(
         break;
     }
 
+    case IOCTL_STORAGE_QUERY_REQUEST_QUEUE_STATISTICS: {
+
+        if(srb) {
+            ExFreePool(srb);
+        }
+
+        if(irpStack->Parameters.DeviceIoControl.OutputBufferLength >=
+           sizeof(CLASS_REQUEST_QUEUE_STATISTICS)) {
+
+            PFUNCTIONAL_DEVICE_EXTENSION fdoExtension =
+                commonExtension->PartitionZeroExtension;
+
+            QueryRequestQueueStatistics(fdoExtension->DeviceObject,
+                                        Irp->AssociatedIrp.SystemBuffer);
+
+            status = STATUS_SUCCESS;
+            Irp->IoStatus.Information = sizeof(CLASS_REQUEST_QUEUE_STATISTICS);
+
+        } else {
+            status = STATUS_BUFFER_TOO_SMALL;
+            Irp->IoStatus.Information = sizeof(CLASS_REQUEST_QUEUE_STATISTICS);
+        }
+
+        Irp->IoStatus.Status = status;
+        ClassReleaseRemoveLock(DeviceObject, Irp);
+        ClassCompleteRequest(DeviceObject, Irp, IO_NO_INCREMENT);
+
+        break;
+    }
+
     default: {
 
         DebugPrint((4, "IoDeviceControl: Unsupported device IOCTL %x for %p\n",
@@ -32,6 +32,7 @@ Revision History:
 #include <classpnp.h>
 #include <ioevent.h>
 #include <pseh/pseh2.h>
+#include <classpnp_undoc.h>
 
 extern CLASSPNP_SCAN_FOR_SPECIAL_INFO ClassBadItems[];
 
@@ -45,6 +46,7 @@ extern GUID ClassGuidQueryRegInfoEx;
 #define CLASSP_REG_WRITE_CACHE_VALUE_NAME       (L"WriteCacheEnableOverride")
 #define CLASSP_REG_PERF_RESTORE_VALUE_NAME      (L"RestorePerfAtCount")
 #define CLASSP_REG_REMOVAL_POLICY_VALUE_NAME    (L"UserRemovalPolicy")
+#define CLASSP_REG_REQUEST_QUEUE_VALUE_NAME     (L"RequestQueueDepth")
 
 #define CLASS_PERF_RESTORE_MINIMUM (0x10)
 #define CLASS_ERROR_LEVEL_1 (0x4)
@@ -78,6 +80,7 @@ extern GUID ClassGuidQueryRegInfoEx;
 
 #define CLASS_FILE_OBJECT_EXTENSION_KEY     'eteP'
 #define CLASSP_VOLUME_VERIFY_CHECKED        0x34
+#define CLASSP_MERGED_REQUEST               0x35
 
 #define CLASS_TAG_PRIVATE_DATA              'CPcS'
 #define CLASS_TAG_PRIVATE_DATA_FDO          'FPcS'
@@ -280,6 +283,31 @@ typedef struct _CLASS_ERROR_LOG_DATA {
 #define NUM_ERROR_LOG_ENTRIES   16
 
 
+/*
+ *  Client read/write irps held in the request queue use the irp's
+ *  "PVOID DriverContext[4]" for this info, so it must always fit there.
+ *  DriverContext[0] is the transfer packet count of ServiceTransferRequest.
+ */
+typedef struct _CLASS_QUEUED_REQUEST {
+    PVOID TransferPacketCount;
+    ULONG_PTR ArrivalTime;          // in microseconds of interrupt time (wraps)
+    LIST_ENTRY ArrivalListEntry;    // for a merged irp, the list of client irps
+} CLASS_QUEUED_REQUEST, *PCLASS_QUEUED_REQUEST;
+
+C_ASSERT(sizeof(CLASS_QUEUED_REQUEST) <= sizeof(((PIRP)0)->Tail.Overlay.DriverContext));
+
+#define CLASSP_QUEUED_REQUEST(Irp) ((PCLASS_QUEUED_REQUEST)(Irp)->Tail.Overlay.DriverContext)
+
+/*
+ *  The largest request queue depth allowed, and how long a request may be
+ *  passed over by the elevator before it is dispatched regardless of its
+ *  position on the disk.
+ */
+#define REQUEST_QUEUE_MAX_DEPTH          256
+#define REQUEST_QUEUE_READ_DEADLINE_US     (500 * 1000)
+#define REQUEST_QUEUE_WRITE_DEADLINE_US   (5000 * 1000)
+
+
 
 typedef struct _TRANSFER_PACKET {
 
@@ -455,6 +483,24 @@ struct _CLASS_PRIVATE_FDO_DATA {
 
     KSPIN_LOCK SpinLock;
 
+    /*
+     *  Optional elevator for client read/write irps (see queue.c).
+     *  Once Depth transfers are outstanding, further irps wait here,
+     *  sorted by disk offset, so that adjacent ones can be merged.
+     *  Everything is protected by the RequestQueue.SpinLock.
+     */
+    struct {
+        BOOLEAN Enabled;
+        ULONG Depth;
+        ULONG NumOutstanding;
+        ULONG NumQueued;
+        LIST_ENTRY SortedList;      // by disk offset, through Tail.Overlay.ListEntry
+        LIST_ENTRY ArrivalList[2];  // reads and writes, oldest first, for the deadlines
+        ULONGLONG HeadPosition;     // disk offset where the last dispatch ended
+        KSPIN_LOCK SpinLock;
+        CLASS_REQUEST_QUEUE_STATISTICS Statistics;
+    } RequestQueue;
+
     /*
      *  Circular array of timestamped logs of errors that occurred on this device.
      */
@@ -866,6 +912,11 @@ PMDL NTAPI BuildDeviceInputMdl(PVOID Buffer, ULONG BufferLen);
 VOID NTAPI FreeDeviceInputMdl(PMDL Mdl);
 NTSTATUS NTAPI InitializeTransferPackets(PDEVICE_OBJECT Fdo);
 VOID NTAPI DestroyAllTransferPackets(PDEVICE_OBJECT Fdo);
+VOID NTAPI InitializeRequestQueue(PDEVICE_OBJECT Fdo);
+VOID NTAPI EnqueueTransferRequest(PDEVICE_OBJECT Fdo, PIRP Irp);
+VOID NTAPI StartQueuedTransferRequests(PDEVICE_OBJECT Fdo);
+VOID NTAPI CompleteQueuedTransferRequest(PDEVICE_OBJECT Fdo, PIRP Irp);
+VOID NTAPI QueryRequestQueueStatistics(PDEVICE_OBJECT Fdo, PCLASS_REQUEST_QUEUE_STATISTICS Statistics);
 
 #include "debug.h"
 
@@ -0,0 +1,519 @@
+/*
+ * PROJECT:     ReactOS Storage Stack / ClassPnP
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Request queue that merges and orders client read/write irps
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "classp.h"
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text(PAGE, InitializeRequestQueue)
+#endif
+
+/*
+ *  The request queue is an elevator in front of ServiceTransferRequest.
+ *  At most RequestQueue.Depth transfers are outstanding at the port driver;
+ *  the irps arriving meanwhile wait here sorted by disk offset. Each
+ *  dispatch takes the first request at or beyond the disk head (C-LOOK),
+ *  unless a request has waited past its deadline, and merges the requests
+ *  that directly follow it on the disk into a single SRB.
+ */
+
+static inline ULONG RequestQueueTime(VOID)
+{
+    /* Microseconds of interrupt time, only ever used for differences */
+    return (ULONG)(KeQueryInterruptTime() / 10);
+}
+
+static inline ULONGLONG RequestOffset(PIRP Irp)
+{
+    return IoGetCurrentIrpStackLocation(Irp)->Parameters.Read.ByteOffset.QuadPart;
+}
+
+static inline ULONG RequestLength(PIRP Irp)
+{
+    return IoGetCurrentIrpStackLocation(Irp)->Parameters.Read.Length;
+}
+
+static inline ULONG RequestDirection(PIRP Irp)
+{
+    return (IoGetCurrentIrpStackLocation(Irp)->MajorFunction == IRP_MJ_WRITE) ? 1 : 0;
+}
+
+/*
+ *  InitializeRequestQueue
+ *
+ *      The queue only helps devices that seek, so it stays off
+ *      unless the RequestQueueDepth value enables it for the disk.
+ *      Drivers with their own StartIo routine are left alone.
+ */
+VOID NTAPI InitializeRequestQueue(PDEVICE_OBJECT Fdo)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    ULONG depth = 0;
+
+    PAGED_CODE();
+
+    KeInitializeSpinLock(&fdoData->RequestQueue.SpinLock);
+    InitializeListHead(&fdoData->RequestQueue.SortedList);
+    InitializeListHead(&fdoData->RequestQueue.ArrivalList[0]);
+    InitializeListHead(&fdoData->RequestQueue.ArrivalList[1]);
+    fdoData->RequestQueue.Statistics.Size = sizeof(CLASS_REQUEST_QUEUE_STATISTICS);
+
+    ClassGetDeviceParameter(fdoExt,
+                            CLASSP_REG_SUBKEY_NAME,
+                            CLASSP_REG_REQUEST_QUEUE_VALUE_NAME,
+                            &depth);
+
+    if (depth && !fdoExt->CommonExtension.DriverExtension->InitData.ClassStartIo){
+        fdoData->RequestQueue.Depth = MIN(depth, REQUEST_QUEUE_MAX_DEPTH);
+        fdoData->RequestQueue.Statistics.QueueDepth = fdoData->RequestQueue.Depth;
+        fdoData->RequestQueue.Enabled = TRUE;
+        DBGTRACE(ClassDebugTrace, ("Request queue enabled for Fdo %p with depth %d.", Fdo, fdoData->RequestQueue.Depth));
+    }
+}
+
+/*
+ *  PickQueuedTransferRequest
+ *
+ *      Chooses the next request to dispatch.
+ *      Must be called with the RequestQueue.SpinLock held.
+ */
+static PIRP PickQueuedTransferRequest(PCLASS_PRIVATE_FDO_DATA FdoData, ULONG Now)
+{
+    static const ULONG deadlines[2] = { REQUEST_QUEUE_READ_DEADLINE_US, REQUEST_QUEUE_WRITE_DEADLINE_US };
+    PCLASS_QUEUED_REQUEST queuedRequest;
+    PLIST_ENTRY listEntry;
+    PIRP irp;
+    ULONG i;
+
+    /*
+     *  The oldest read, then the oldest write, jump the elevator
+     *  once they have waited too long.
+     */
+    for (i = 0; i < 2; i++){
+        if (!IsListEmpty(&FdoData->RequestQueue.ArrivalList[i])){
+            queuedRequest = CONTAINING_RECORD(FdoData->RequestQueue.ArrivalList[i].Flink,
+                                              CLASS_QUEUED_REQUEST,
+                                              ArrivalListEntry);
+            if (Now - (ULONG)queuedRequest->ArrivalTime >= deadlines[i]){
+                FdoData->RequestQueue.Statistics.DeadlineDispatches++;
+                return CONTAINING_RECORD(queuedRequest, IRP, Tail.Overlay.DriverContext);
+            }
+        }
+    }
+
+    for (listEntry = FdoData->RequestQueue.SortedList.Flink;
+         listEntry != &FdoData->RequestQueue.SortedList;
+         listEntry = listEntry->Flink){
+
+        irp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+        if (RequestOffset(irp) >= FdoData->RequestQueue.HeadPosition){
+            return irp;
+        }
+    }
+
+    /*
+     *  Nothing is left ahead of the head, so start the next sweep
+     *  from the lowest offset.
+     */
+    return CONTAINING_RECORD(FdoData->RequestQueue.SortedList.Flink, IRP, Tail.Overlay.ListEntry);
+}
+
+/*
+ *  RemoveQueuedTransferRequest
+ *
+ *      Must be called with the RequestQueue.SpinLock held.
+ */
+static VOID RemoveQueuedTransferRequest(PCLASS_PRIVATE_FDO_DATA FdoData, PIRP Irp, ULONG Now)
+{
+    PCLASS_QUEUED_REQUEST queuedRequest = CLASSP_QUEUED_REQUEST(Irp);
+
+    RemoveEntryList(&Irp->Tail.Overlay.ListEntry);
+    RemoveEntryList(&queuedRequest->ArrivalListEntry);
+    InitializeListHead(&Irp->Tail.Overlay.ListEntry);
+    InitializeListHead(&queuedRequest->ArrivalListEntry);
+
+    ASSERT(FdoData->RequestQueue.NumQueued > 0);
+    FdoData->RequestQueue.NumQueued--;
+    FdoData->RequestQueue.Statistics.TotalQueueTime += Now - (ULONG)queuedRequest->ArrivalTime;
+}
+
+/*
+ *  CanMergeTransferRequests
+ *
+ *      Checks whether NextIrp can be appended to a merged transfer
+ *      that currently ends with PrevIrp and is MergedLength bytes long.
+ */
+static BOOLEAN CanMergeTransferRequests(PIRP PrevIrp, PIRP NextIrp, ULONG MergedLength, ULONG MaxLength)
+{
+    PIO_STACK_LOCATION prevSp = IoGetCurrentIrpStackLocation(PrevIrp);
+    PIO_STACK_LOCATION nextSp = IoGetCurrentIrpStackLocation(NextIrp);
+    PMDL prevMdl = PrevIrp->MdlAddress;
+    PMDL nextMdl = NextIrp->MdlAddress;
+
+    if ((nextSp->MajorFunction != prevSp->MajorFunction) ||
+        (nextSp->Flags != prevSp->Flags) ||
+        ((NextIrp->Flags ^ PrevIrp->Flags) & (IRP_PAGING_IO | IRP_SYNCHRONOUS_PAGING_IO))){
+        return FALSE;
+    }
+
+    if ((RequestOffset(PrevIrp) + RequestLength(PrevIrp) != RequestOffset(NextIrp)) ||
+        (RequestLength(NextIrp) > MaxLength - MergedLength)){
+        return FALSE;
+    }
+
+    /*
+     *  The merged MDL lists the pages of each request one after the other,
+     *  so a request must end on a page boundary to be followed by another,
+     *  which must start on one.
+     */
+    if (prevMdl->Next || nextMdl->Next ||
+        BYTE_OFFSET((PUCHAR)MmGetMdlVirtualAddress(prevMdl) + RequestLength(PrevIrp)) ||
+        MmGetMdlByteOffset(nextMdl)){
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ *  ServiceMergedTransferRequest
+ *
+ *      Sends the client irps in ClientList, adjacent on the disk,
+ *      as a single transfer. The transfer is described by a private irp
+ *      with an MDL listing the pages of all the client MDLs in order.
+ *      The port driver only looks at Irp->MdlAddress, so the client MDLs
+ *      are copied into one rather than chained.
+ */
+static VOID ServiceMergedTransferRequest(PDEVICE_OBJECT Fdo, PLIST_ENTRY ClientList, ULONG Length)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    PIRP firstIrp = CONTAINING_RECORD(ClientList->Flink, IRP, Tail.Overlay.ListEntry);
+    PIO_STACK_LOCATION firstSp = IoGetCurrentIrpStackLocation(firstIrp);
+    PLIST_ENTRY mergedList;
+    PLIST_ENTRY listEntry;
+    PIO_STACK_LOCATION mergedSp;
+    PPFN_NUMBER pfnArray;
+    PIRP mergedIrp;
+    PIRP irp;
+    PMDL mdl = NULL;
+    ULONG numPages;
+    ULONG numIrps = 0;
+    KIRQL oldIrql;
+
+    mergedIrp = IoAllocateIrp(1, FALSE);
+    if (mergedIrp){
+        mdl = IoAllocateMdl(MmGetMdlVirtualAddress(firstIrp->MdlAddress), Length, FALSE, FALSE, NULL);
+        if (!mdl){
+            IoFreeIrp(mergedIrp);
+        }
+    }
+
+    if (!mdl){
+        /*
+         *  We are low on memory, so send the requests one by one instead.
+         */
+        DBGWARN(("ServiceMergedTransferRequest: allocation failed, sending the requests unmerged"));
+
+        for (listEntry = ClientList->Flink; listEntry != ClientList; listEntry = listEntry->Flink){
+            numIrps++;
+        }
+        KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+        fdoData->RequestQueue.NumOutstanding += numIrps - 1;
+        fdoData->RequestQueue.Statistics.MergeFailures++;
+        KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+
+        while (!IsListEmpty(ClientList)){
+            listEntry = RemoveHeadList(ClientList);
+            InitializeListHead(listEntry);
+            irp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+            ServiceTransferRequest(Fdo, irp);
+        }
+        return;
+    }
+
+    /*
+     *  Build the MDL from the pages of the client MDLs.
+     *  These stay locked until the client irps complete.
+     */
+    pfnArray = MmGetMdlPfnArray(mdl);
+    for (listEntry = ClientList->Flink; listEntry != ClientList; listEntry = listEntry->Flink){
+        irp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+        numPages = ADDRESS_AND_SIZE_TO_SPAN_PAGES(MmGetMdlVirtualAddress(irp->MdlAddress), RequestLength(irp));
+        RtlCopyMemory(pfnArray, MmGetMdlPfnArray(irp->MdlAddress), numPages * sizeof(PFN_NUMBER));
+        pfnArray += numPages;
+    }
+    ASSERT(pfnArray == MmGetMdlPfnArray(mdl) +
+                       ADDRESS_AND_SIZE_TO_SPAN_PAGES(MmGetMdlVirtualAddress(mdl), Length));
+
+    /*
+     *  Like a partial MDL, it does not own its pages, and a mapping made
+     *  by the port driver is released when it is freed.
+     */
+    mdl->MdlFlags |= MDL_PARTIAL;
+
+    /*
+     *  Set up the private irp as a read/write request of our own,
+     *  with the client irps hanging off its DriverContext.
+     */
+    IoSetNextIrpStackLocation(mergedIrp);
+    mergedSp = IoGetCurrentIrpStackLocation(mergedIrp);
+    mergedSp->MajorFunction = firstSp->MajorFunction;
+    mergedSp->MinorFunction = CLASSP_MERGED_REQUEST;
+    mergedSp->Flags = firstSp->Flags;
+    mergedSp->DeviceObject = Fdo;
+    mergedSp->Parameters.Read.Length = Length;
+    mergedSp->Parameters.Read.ByteOffset = firstSp->Parameters.Read.ByteOffset;
+    mergedIrp->Flags = firstIrp->Flags & (IRP_PAGING_IO | IRP_SYNCHRONOUS_PAGING_IO);
+    mergedIrp->MdlAddress = mdl;
+
+    CLASSP_QUEUED_REQUEST(mergedIrp)->ArrivalTime = CLASSP_QUEUED_REQUEST(firstIrp)->ArrivalTime;
+    mergedList = &CLASSP_QUEUED_REQUEST(mergedIrp)->ArrivalListEntry;
+    InitializeListHead(mergedList);
+    while (!IsListEmpty(ClientList)){
+        InsertTailList(mergedList, RemoveHeadList(ClientList));
+    }
+
+    ServiceTransferRequest(Fdo, mergedIrp);
+}
+
+/*
+ *  StartQueuedTransferRequests
+ *
+ *      Dispatches queued requests while fewer than
+ *      RequestQueue.Depth transfers are outstanding.
+ */
+VOID NTAPI StartQueuedTransferRequests(PDEVICE_OBJECT Fdo)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    LIST_ENTRY clientList;
+    PLIST_ENTRY nextEntry;
+    PIRP irp, lastIrp, nextIrp;
+    ULONG mergedLength;
+    ULONG numIrps;
+    ULONG now;
+    KIRQL oldIrql;
+
+    while (TRUE){
+        now = RequestQueueTime();
+
+        KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+
+        if ((fdoData->RequestQueue.NumQueued == 0) ||
+            (fdoData->RequestQueue.NumOutstanding >= fdoData->RequestQueue.Depth)){
+            KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+            break;
+        }
+
+        irp = PickQueuedTransferRequest(fdoData, now);
+        nextEntry = irp->Tail.Overlay.ListEntry.Flink;
+        RemoveQueuedTransferRequest(fdoData, irp, now);
+
+        InitializeListHead(&clientList);
+        InsertTailList(&clientList, &irp->Tail.Overlay.ListEntry);
+        mergedLength = RequestLength(irp);
+        numIrps = 1;
+
+        /*
+         *  Pull in the requests that directly follow on the disk,
+         *  as long as they all fit in a single transfer packet.
+         */
+        if (mergedLength <= fdoData->HwMaxXferLen){
+            lastIrp = irp;
+            while (nextEntry != &fdoData->RequestQueue.SortedList){
+                nextIrp = CONTAINING_RECORD(nextEntry, IRP, Tail.Overlay.ListEntry);
+                if (!CanMergeTransferRequests(lastIrp, nextIrp, mergedLength, fdoData->HwMaxXferLen)){
+                    break;
+                }
+
+                nextEntry = nextEntry->Flink;
+                RemoveQueuedTransferRequest(fdoData, nextIrp, now);
+                InsertTailList(&clientList, &nextIrp->Tail.Overlay.ListEntry);
+                mergedLength += RequestLength(nextIrp);
+                numIrps++;
+                lastIrp = nextIrp;
+            }
+        }
+
+        fdoData->RequestQueue.HeadPosition = RequestOffset(irp) + mergedLength;
+        fdoData->RequestQueue.NumOutstanding++;
+        fdoData->RequestQueue.Statistics.Transfers++;
+        if (numIrps > 1){
+            fdoData->RequestQueue.Statistics.MergedRequests += numIrps - 1;
+            fdoData->RequestQueue.Statistics.MergedBytes += mergedLength - RequestLength(irp);
+        }
+
+        KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+
+        if (numIrps == 1){
+            RemoveEntryList(&irp->Tail.Overlay.ListEntry);
+            InitializeListHead(&irp->Tail.Overlay.ListEntry);
+            ServiceTransferRequest(Fdo, irp);
+        }
+        else {
+            ServiceMergedTransferRequest(Fdo, &clientList, mergedLength);
+        }
+    }
+}
+
+/*
+ *  EnqueueTransferRequest
+ *
+ *      Queues a client read/write irp, already relative to the start
+ *      of the disk, and dispatches what the queue depth allows.
+ */
+VOID NTAPI EnqueueTransferRequest(PDEVICE_OBJECT Fdo, PIRP Irp)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    PCLASS_QUEUED_REQUEST queuedRequest = CLASSP_QUEUED_REQUEST(Irp);
+    ULONGLONG offset = RequestOffset(Irp);
+    PLIST_ENTRY listEntry;
+    KIRQL oldIrql;
+
+    queuedRequest->ArrivalTime = RequestQueueTime();
+
+    /*
+     *  Mark the client irp pending since it may complete on another thread.
+     */
+    IoMarkIrpPending(Irp);
+
+    KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+
+    /*
+     *  Insert after the last request that does not start beyond this one.
+     *  Sequential requests arrive in order, so look from the tail.
+     */
+    for (listEntry = fdoData->RequestQueue.SortedList.Blink;
+         listEntry != &fdoData->RequestQueue.SortedList;
+         listEntry = listEntry->Blink){
+
+        if (RequestOffset(CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry)) <= offset){
+            break;
+        }
+    }
+    InsertHeadList(listEntry, &Irp->Tail.Overlay.ListEntry);
+    InsertTailList(&fdoData->RequestQueue.ArrivalList[RequestDirection(Irp)], &queuedRequest->ArrivalListEntry);
+
+    fdoData->RequestQueue.NumQueued++;
+    fdoData->RequestQueue.Statistics.Requests++;
+
+    KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+
+    StartQueuedTransferRequests(Fdo);
+}
+
+/*
+ *  CompleteQueuedTransferRequest
+ *
+ *      Called instead of completing the original irp when the last
+ *      transfer packet of a queued request completes.
+ *      The caller calls StartQueuedTransferRequests once it
+ *      has freed the transfer packet.
+ */
+VOID NTAPI CompleteQueuedTransferRequest(PDEVICE_OBJECT Fdo, PIRP Irp)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    PIO_STACK_LOCATION currentSp = IoGetCurrentIrpStackLocation(Irp);
+    ULONGLONG totalLatency = 0;
+    ULONG maxLatency = 0;
+    ULONG numIrps = 1;
+    ULONG now = RequestQueueTime();
+    ULONG latency;
+    LIST_ENTRY clientList;
+    PLIST_ENTRY listEntry;
+    PIRP clientIrp;
+    KIRQL oldIrql;
+
+    InitializeListHead(&clientList);
+
+    if (currentSp->MinorFunction == CLASSP_MERGED_REQUEST){
+        PLIST_ENTRY mergedList = &CLASSP_QUEUED_REQUEST(Irp)->ArrivalListEntry;
+
+        if (!NT_SUCCESS(Irp->IoStatus.Status)){
+            /*
+             *  Don't let one bad sector fail the unrelated requests
+             *  that were merged with it. Send them again one by one.
+             */
+            DBGWARN(("Merged transfer failed with %xh, sending the requests unmerged.", Irp->IoStatus.Status));
+
+            numIrps = 0;
+            for (listEntry = mergedList->Flink; listEntry != mergedList; listEntry = listEntry->Flink){
+                numIrps++;
+            }
+            KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+            fdoData->RequestQueue.NumOutstanding += numIrps - 1;
+            fdoData->RequestQueue.Statistics.MergeFailures++;
+            KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+
+            while (!IsListEmpty(mergedList)){
+                listEntry = RemoveHeadList(mergedList);
+                InitializeListHead(listEntry);
+                clientIrp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+                ServiceTransferRequest(Fdo, clientIrp);
+            }
+
+            IoFreeMdl(Irp->MdlAddress);
+            IoFreeIrp(Irp);
+            return;
+        }
+
+        while (!IsListEmpty(mergedList)){
+            listEntry = RemoveHeadList(mergedList);
+            clientIrp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+            clientIrp->IoStatus.Status = STATUS_SUCCESS;
+            clientIrp->IoStatus.Information = RequestLength(clientIrp);
+            InsertTailList(&clientList, listEntry);
+        }
+
+        IoFreeMdl(Irp->MdlAddress);
+        IoFreeIrp(Irp);
+    }
+    else {
+        InsertTailList(&clientList, &Irp->Tail.Overlay.ListEntry);
+    }
+
+    while (!IsListEmpty(&clientList)){
+        listEntry = RemoveHeadList(&clientList);
+        InitializeListHead(listEntry);
+        clientIrp = CONTAINING_RECORD(listEntry, IRP, Tail.Overlay.ListEntry);
+
+        latency = now - (ULONG)CLASSP_QUEUED_REQUEST(clientIrp)->ArrivalTime;
+        totalLatency += latency;
+        maxLatency = MAX(maxLatency, latency);
+
+        ClassReleaseRemoveLock(Fdo, clientIrp);
+        ClassCompleteRequest(Fdo, clientIrp, IO_DISK_INCREMENT);
+    }
+
+    KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+    ASSERT(fdoData->RequestQueue.NumOutstanding > 0);
+    fdoData->RequestQueue.NumOutstanding--;
+    fdoData->RequestQueue.Statistics.TotalLatency += totalLatency;
+    fdoData->RequestQueue.Statistics.MaxLatency = MAX(fdoData->RequestQueue.Statistics.MaxLatency, maxLatency);
+    KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+}
+
+/*
+ *  QueryRequestQueueStatistics
+ *
+ *      Snapshot of the counters for IOCTL_STORAGE_QUERY_REQUEST_QUEUE_STATISTICS.
+ */
+VOID NTAPI QueryRequestQueueStatistics(PDEVICE_OBJECT Fdo, PCLASS_REQUEST_QUEUE_STATISTICS Statistics)
+{
+    PFUNCTIONAL_DEVICE_EXTENSION fdoExt = Fdo->DeviceExtension;
+    PCLASS_PRIVATE_FDO_DATA fdoData = fdoExt->PrivateFdoData;
+    KIRQL oldIrql;
+
+    KeAcquireSpinLock(&fdoData->RequestQueue.SpinLock, &oldIrql);
+    *Statistics = fdoData->RequestQueue.Statistics;
+    Statistics->CurrentQueued = fdoData->RequestQueue.NumQueued;
+    Statistics->CurrentOutstanding = fdoData->RequestQueue.NumOutstanding;
+    KeReleaseSpinLock(&fdoData->RequestQueue.SpinLock, oldIrql);
+}
@@ -650,9 +650,18 @@ NTSTATUS NTAPI TransferPktComplete(IN PDEVICE_OBJECT NullFdo, IN PIRP Irp, IN PV
                     ASSERT((ULONG)pkt->OriginalIrp->IoStatus.Information == origCurrentSp->Parameters.Read.Length);
                     ClasspPerfIncrementSuccessfulIo(fdoExt);
                 }
-                ClassReleaseRemoveLock(pkt->Fdo, pkt->OriginalIrp);
+                if (fdoData->RequestQueue.Enabled){
+                    /*
+                     *  The request queue completes the client irp(s),
+                     *  which may have been merged into this one.
+                     */
+                    CompleteQueuedTransferRequest(pkt->Fdo, pkt->OriginalIrp);
+                }
+                else {
+                    ClassReleaseRemoveLock(pkt->Fdo, pkt->OriginalIrp);
 
-                ClassCompleteRequest(pkt->Fdo, pkt->OriginalIrp, IO_DISK_INCREMENT);
+                    ClassCompleteRequest(pkt->Fdo, pkt->OriginalIrp, IO_DISK_INCREMENT);
+                }
 
                 /*
                  *  We may have been called by one of the class drivers (e.g. cdrom)
@@ -702,6 +711,13 @@ NTSTATUS NTAPI TransferPktComplete(IN PDEVICE_OBJECT NullFdo, IN PIRP Irp, IN PV
             ServiceTransferRequest(pkt->Fdo, deferredIrp);
         }
 
+        /*
+         *  Likewise, a request queue slot may have freed up.
+         */
+        if (fdoData->RequestQueue.Enabled){
+            StartQueuedTransferRequests(Fdo);
+        }
+
         ClassReleaseRemoveLock(Fdo, (PIRP)&uniqueAddr);        
     }
 
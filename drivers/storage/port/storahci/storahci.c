@@ -769,6 +769,40 @@ AhciHwInterrupt (
     return FALSE;
 }// -- AhciHwInterrupt();
 
+/**
+ * @name AhciHwMessageInterrupt
+ * @implemented
+ *
+ * The Storport driver calls the HwMSInterruptRoutine routine when the HBA signals a message.
+ * A message is only sent when IS goes from clear to set, so every pending port has to be
+ * serviced before returning.
+ *
+ * @param AdapterExtension
+ * @param MessageId
+ *
+ * @return
+ * return TRUE Indicates that an interrupt was pending on adapter.
+ * return FALSE Indicates the interrupt was not ours.
+ */
+BOOLEAN
+NTAPI
+AhciHwMessageInterrupt (
+    __in PVOID DeviceExtension,
+    __in ULONG MessageId
+    )
+{
+    BOOLEAN handled = FALSE;
+
+    UNREFERENCED_PARAMETER(MessageId);
+
+    while (AhciHwInterrupt(DeviceExtension))
+    {
+        handled = TRUE;
+    }
+
+    return handled;
+}// -- AhciHwMessageInterrupt();
+
 /**
  * @name AhciHwStartIo
  * @not_implemented
@@ -1125,6 +1159,10 @@ AhciHwFindAdapter (
     ConfigInfo->MaximumTransferLength = MAXIMUM_TRANSFER_LENGTH;
     ConfigInfo->SynchronizationModel = StorSynchronizeFullDuplex;
 
+    // Single message MSI, synchronized like the line interrupt
+    ConfigInfo->HwMSInterruptRoutine = AhciHwMessageInterrupt;
+    ConfigInfo->InterruptSynchronizationMode = InterruptSynchronizeAll;
+
     // Turn IE -- Interrupt Enabled
     ghc.Status = StorPortReadRegisterUlong(adapterExtension, &abar->GHC);
     ghc.IE = 1;
@@ -24,7 +24,7 @@ PortFdoInterruptRoutine(
 {
     PFDO_DEVICE_EXTENSION DeviceExtension;
 
-    DPRINT1("PortFdoInterruptRoutine(%p %p)\n",
+    DPRINT("PortFdoInterruptRoutine(%p %p)\n",
             Interrupt, ServiceContext);
 
     DeviceExtension = (PFDO_DEVICE_EXTENSION)ServiceContext;
@@ -33,6 +33,56 @@ PortFdoInterruptRoutine(
 }
 
 
+static
+BOOLEAN
+NTAPI
+PortFdoMessageInterruptRoutine(
+    _In_ PKINTERRUPT Interrupt,
+    _In_ PVOID ServiceContext,
+    _In_ ULONG MessageId)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+
+    DPRINT("PortFdoMessageInterruptRoutine(%p %p %lu)\n",
+            Interrupt, ServiceContext, MessageId);
+
+    DeviceExtension = (PFDO_DEVICE_EXTENSION)ServiceContext;
+
+    return MiniportHwMessageInterrupt(&DeviceExtension->Miniport, MessageId);
+}
+
+
+static
+NTSTATUS
+PortFdoConnectMessageInterrupt(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension)
+{
+    IO_CONNECT_INTERRUPT_PARAMETERS Parameters;
+    NTSTATUS Status;
+
+    RtlZeroMemory(&Parameters, sizeof(Parameters));
+    Parameters.Version = CONNECT_MESSAGE_BASED;
+    Parameters.MessageBased.PhysicalDeviceObject = DeviceExtension->PhysicalDevice;
+    Parameters.MessageBased.ConnectionContext.InterruptMessageTable = &DeviceExtension->InterruptMessageTable;
+    Parameters.MessageBased.MessageServiceRoutine = PortFdoMessageInterruptRoutine;
+    Parameters.MessageBased.ServiceContext = DeviceExtension;
+
+    /* All messages share one lock, which makes InterruptSynchronizeAll the only mode we offer */
+    Status = IoConnectInterruptEx(&Parameters);
+    if (!NT_SUCCESS(Status))
+        return Status;
+
+    DPRINT1("Connected %lu message interrupt(s)\n",
+            DeviceExtension->InterruptMessageTable->MessageCount);
+
+    /* Synchronizing with the first message synchronizes with all of them */
+    DeviceExtension->Interrupt = DeviceExtension->InterruptMessageTable->MessageInfo[0].InterruptObject;
+    DeviceExtension->InterruptIrql = DeviceExtension->InterruptMessageTable->UnifiedIrql;
+
+    return STATUS_SUCCESS;
+}
+
+
 static
 NTSTATUS
 PortFdoConnectInterrupt(
@@ -56,6 +106,14 @@ PortFdoConnectInterrupt(
         return STATUS_SUCCESS;
     }
 
+    /* Prefer messages if the miniport handles them and the device got some */
+    if (DeviceExtension->Miniport.PortConfig.HwMSInterruptRoutine != NULL)
+    {
+        Status = PortFdoConnectMessageInterrupt(DeviceExtension);
+        if (Status != STATUS_NOT_FOUND)
+            return Status;
+    }
+
     /* Get the interrupt data from the resource list */
     Status = GetResourceListInterrupt(DeviceExtension,
                                       &Vector,
@@ -139,6 +197,14 @@ PortFdoStartMiniport(
         return Status;
     }
 
+    /* Allocate the request slots and their SRB extensions */
+    Status = PortAllocateRequests(DeviceExtension);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("PortAllocateRequests() failed (Status 0x%08lx)\n", Status);
+        return Status;
+    }
+
     /* Connect the configured interrupt */
     Status = PortFdoConnectInterrupt(DeviceExtension);
     if (!NT_SUCCESS(Status))
@@ -251,7 +317,6 @@ PortSendInquiry(
     IO_STATUS_BLOCK IoStatusBlock;
     PIO_STACK_LOCATION IrpStack;
     KEVENT Event;
-//    KIRQL Irql;
     PIRP Irp;
     NTSTATUS Status;
     PSENSE_DATA SenseBuffer;
@@ -259,8 +324,6 @@ PortSendInquiry(
     ULONG RetryCount = 0;
     SCSI_REQUEST_BLOCK Srb;
     PCDB Cdb;
-//    PSCSI_PORT_LUN_EXTENSION LunExtension;
-//    PFDO_DEVICE_EXTENSION DeviceExtension;
 
     DPRINT("PortSendInquiry(%p)\n", PdoExtension);
 
@@ -368,25 +431,10 @@ PortSendInquiry(
             /* Something weird happened, deal with it (unfreeze the queue) */
             KeepTrying = FALSE;
 
-            DPRINT("SpiSendInquiry(): the queue is frozen at TargetId %d\n", Srb.TargetId);
-
-//            LunExtension = SpiGetLunExtension(DeviceExtension,
-//                                              LunInfo->PathId,
-//                                              LunInfo->TargetId,
-//                                              LunInfo->Lun);
-
-            /* Clear frozen flag */
-//            LunExtension->Flags &= ~LUNEX_FROZEN_QUEUE;
-
-            /* Acquire the spinlock */
-//            KeAcquireSpinLock(&DeviceExtension->SpinLock, &Irql);
-
-            /* Process the request */
-//            SpiGetNextRequestFromLun(DeviceObject->DeviceExtension, LunExtension);
+            DPRINT("PortSendInquiry(): the queue is frozen at TargetId %d\n", Srb.TargetId);
 
-            /* SpiGetNextRequestFromLun() releases the spinlock,
-                so we just lower irql back to what it was before */
-//            KeLowerIrql(Irql);
+            /* Clear the frozen flag and restart the unit's queue */
+            PortReleaseUnitQueue(PdoExtension);
         }
 
         /* Check if data overrun happened */
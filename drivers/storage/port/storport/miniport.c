@@ -146,6 +146,10 @@ AssignResourcesToConfiguration(
                     break;
 
                 case CmResourceTypeInterrupt:
+                    /* Messages are reported through StorPortGetMSIInfo */
+                    if (PartialDescriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE)
+                        break;
+
                     DPRINT1("Interrupt: Level %lu  Vector %lu\n",
                             PartialDescriptor->u.Interrupt.Level,
                             PartialDescriptor->u.Interrupt.Vector);
@@ -353,11 +357,46 @@ MiniportHwInterrupt(
 {
     BOOLEAN Result;
 
-    DPRINT1("MiniportHwInterrupt(%p)\n",
-            Miniport);
+    DPRINT("MiniportHwInterrupt(%p)\n",
+           Miniport);
 
     Result = Miniport->InitData->HwInterrupt(&Miniport->MiniportExtension->HwDeviceExtension);
-    DPRINT1("HwInterrupt() returned %u\n", Result);
+    DPRINT("HwInterrupt() returned %u\n", Result);
+
+    return Result;
+}
+
+
+BOOLEAN
+MiniportHwMessageInterrupt(
+    _In_ PMINIPORT Miniport,
+    _In_ ULONG MessageId)
+{
+    BOOLEAN Result;
+
+    DPRINT("MiniportHwMessageInterrupt(%p %lu)\n",
+           Miniport, MessageId);
+
+    Result = Miniport->PortConfig.HwMSInterruptRoutine(&Miniport->MiniportExtension->HwDeviceExtension,
+                                                       MessageId);
+    DPRINT("HwMSInterruptRoutine() returned %u\n", Result);
+
+    return Result;
+}
+
+
+BOOLEAN
+MiniportBuildIo(
+    _In_ PMINIPORT Miniport,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    BOOLEAN Result;
+
+    DPRINT("MiniportBuildIo(%p %p)\n",
+           Miniport, Srb);
+
+    Result = Miniport->InitData->HwBuildIo(&Miniport->MiniportExtension->HwDeviceExtension, Srb);
+    DPRINT("HwBuildIo() returned %u\n", Result);
 
     return Result;
 }
@@ -370,11 +409,11 @@ MiniportStartIo(
 {
     BOOLEAN Result;
 
-    DPRINT1("MiniportHwStartIo(%p %p)\n",
-            Miniport, Srb);
+    DPRINT("MiniportHwStartIo(%p %p)\n",
+           Miniport, Srb);
 
     Result = Miniport->InitData->HwStartIo(&Miniport->MiniportExtension->HwDeviceExtension, Srb);
-    DPRINT1("HwStartIo() returned %u\n", Result);
+    DPRINT("HwStartIo() returned %u\n", Result);
 
     return Result;
 }
@@ -304,6 +304,10 @@ GetResourceListInterrupt(
             switch (PartialDescriptor->Type)
             {
                 case CmResourceTypeInterrupt:
+                    /* Messages are connected through IoConnectInterruptEx */
+                    if (PartialDescriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE)
+                        break;
+
                     DPRINT1("Interrupt: Level %lu  Vector %lu\n",
                             PartialDescriptor->u.Interrupt.Level,
                             PartialDescriptor->u.Interrupt.Vector);
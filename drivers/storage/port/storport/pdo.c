@@ -70,6 +70,18 @@ PortCreatePdo(
     DeviceExtension->Target = Target;
     DeviceExtension->Lun = Lun;
 
+    /* Allocate the miniport's logical unit extension */
+    if (FdoDeviceExtension->Miniport.InitData->SpecificLuExtensionSize != 0)
+    {
+        DeviceExtension->LuExtension = ExAllocatePoolWithTag(NonPagedPool,
+                                                             FdoDeviceExtension->Miniport.InitData->SpecificLuExtensionSize,
+                                                             TAG_LU_EXTENSION);
+        if (DeviceExtension->LuExtension != NULL)
+            RtlZeroMemory(DeviceExtension->LuExtension,
+                          FdoDeviceExtension->Miniport.InitData->SpecificLuExtensionSize);
+    }
+
+    PortInitializeUnitQueue(DeviceExtension);
 
     // FIXME: More initialization
 
@@ -104,6 +116,16 @@ PortDeletePdo(
         PdoExtension->InquiryBuffer = NULL;
     }
 
+    if (PdoExtension->LuExtension)
+    {
+        ExFreePoolWithTag(PdoExtension->LuExtension, TAG_LU_EXTENSION);
+        PdoExtension->LuExtension = NULL;
+    }
+
+    DPRINT("Unit %lu:%lu:%lu  Reads %lu  Writes %lu  Max outstanding %lu  Max latency %I64d\n",
+           PdoExtension->Bus, PdoExtension->Target, PdoExtension->Lun,
+           PdoExtension->ReadCount, PdoExtension->WriteCount,
+           PdoExtension->MaxOutstandingCount, PdoExtension->MaxLatency);
 
     // FIXME: More uninitialization
 
@@ -121,12 +143,58 @@ PortPdoScsi(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp)
 {
-    DPRINT1("PortPdoScsi(%p %p)\n", DeviceObject, Irp);
+    PPDO_DEVICE_EXTENSION PdoExtension;
+    PSCSI_REQUEST_BLOCK Srb;
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    DPRINT("PortPdoScsi(%p %p)\n", DeviceObject, Irp);
+
+    PdoExtension = (PPDO_DEVICE_EXTENSION)DeviceObject->DeviceExtension;
+
+    Srb = IoGetCurrentIrpStackLocation(Irp)->Parameters.Scsi.Srb;
+    if (Srb == NULL)
+    {
+        Irp->IoStatus.Information = 0;
+        Irp->IoStatus.Status = STATUS_INVALID_PARAMETER;
+        IoCompleteRequest(Irp, IO_NO_INCREMENT);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    Srb->PathId = (UCHAR)PdoExtension->Bus;
+    Srb->TargetId = (UCHAR)PdoExtension->Target;
+    Srb->Lun = (UCHAR)PdoExtension->Lun;
+
+    switch (Srb->Function)
+    {
+        case SRB_FUNCTION_CLAIM_DEVICE:
+            DPRINT("SRB_FUNCTION_CLAIM_DEVICE\n");
+            Srb->DataBuffer = DeviceObject;
+            break;
+
+        case SRB_FUNCTION_RELEASE_DEVICE:
+            DPRINT("SRB_FUNCTION_RELEASE_DEVICE\n");
+            break;
+
+        case SRB_FUNCTION_RELEASE_QUEUE:
+            DPRINT("SRB_FUNCTION_RELEASE_QUEUE\n");
+            PortReleaseUnitQueue(PdoExtension);
+            break;
+
+        case SRB_FUNCTION_FLUSH_QUEUE:
+            DPRINT("SRB_FUNCTION_FLUSH_QUEUE\n");
+            PortFlushUnitQueue(PdoExtension);
+            break;
+
+        default:
+            return PortQueueRequest(PdoExtension, Irp, Srb);
+    }
+
+    Srb->SrbStatus = SRB_STATUS_SUCCESS;
 
     Irp->IoStatus.Information = 0;
-    Irp->IoStatus.Status = STATUS_SUCCESS;
+    Irp->IoStatus.Status = Status;
     IoCompleteRequest(Irp, IO_NO_INCREMENT);
-    return STATUS_SUCCESS;
+    return Status;
 }
 
 
@@ -21,6 +21,7 @@
 #include <ntdddisk.h>
 #include <mountdev.h>
 #include <wdmguid.h>
+#include <iointex.h>
 
 /* Memory Tags */
 #define TAG_GLOBAL_DATA     'DGtS'
@@ -31,6 +32,15 @@
 #define TAG_ADDRESS_MAPPING 'MAtS'
 #define TAG_INQUIRY_DATA    'QItS'
 #define TAG_SENSE_DATA      'NStS'
+#define TAG_REQUEST         'QRtS'
+#define TAG_LU_EXTENSION    'ELtS'
+#define TAG_SG_LIST         'LGtS'
+
+/* Request queueing */
+#define PORT_MAXIMUM_REQUESTS           128     /* Queue tags, SP_UNTAGGED is never used */
+#define PORT_DEFAULT_UNIT_QUEUE_DEPTH   20
+#define PORT_SRB_EXTENSION_ALIGNMENT    128
+#define PORT_BUSY_TIMEOUT               100     /* Milliseconds */
 
 typedef enum
 {
@@ -81,6 +91,39 @@ typedef struct _MINIPORT
     PMINIPORT_DEVICE_EXTENSION MiniportExtension;
 } MINIPORT, *PMINIPORT;
 
+typedef enum
+{
+    RequestFree,
+    RequestActive,
+    RequestCompleting
+} REQUEST_STATE;
+
+typedef struct _PORT_REQUEST
+{
+    SLIST_ENTRY CompletionEntry;
+    LIST_ENTRY FreeListEntry;
+    volatile LONG State;
+    UCHAR QueueTag;
+    PIRP Irp;
+    PSCSI_REQUEST_BLOCK Srb;
+    struct _PDO_DEVICE_EXTENSION *Unit;
+    PVOID SrbExtension;
+    PSTOR_SCATTER_GATHER_LIST SgList;
+    LARGE_INTEGER StartTime;
+} PORT_REQUEST, *PPORT_REQUEST;
+
+/* Holds back a queue while the miniport is busy or paused. The miniport may
+   change these at any IRQL, so they are only updated with interlocked
+   operations and every hold expires at its deadline (in milliseconds of
+   interrupt time) */
+typedef struct _PORT_QUEUE_HOLD
+{
+    volatile LONG BusyCount;
+    volatile LONG Paused;
+    volatile ULONG BusyDeadline;
+    volatile ULONG PauseDeadline;
+} PORT_QUEUE_HOLD, *PPORT_QUEUE_HOLD;
+
 typedef struct _UNIT_DATA
 {
     LIST_ENTRY ListEntry;
@@ -111,10 +154,31 @@ typedef struct _FDO_DEVICE_EXTENSION
     PHW_PASSIVE_INITIALIZE_ROUTINE HwPassiveInitRoutine;
     PKINTERRUPT Interrupt;
     ULONG InterruptIrql;
+    PIO_INTERRUPT_MESSAGE_INFO InterruptMessageTable;
 
     KSPIN_LOCK PdoListLock;
     LIST_ENTRY PdoListHead;
     ULONG PdoCount;
+
+    /* Request queueing, protected by the queue lock */
+    KSPIN_LOCK QueueLock;
+    LIST_ENTRY ActiveUnitListHead;
+    LIST_ENTRY FreeRequestListHead;
+    ULONG OutstandingCount;
+    PORT_QUEUE_HOLD Hold;
+    KTIMER ResumeTimer;
+    KDPC ResumeDpc;
+
+    /* Request slots, one per queue tag */
+    PPORT_REQUEST Requests;
+    ULONG RequestCount;
+    PVOID SrbExtensionBase;
+    PHYSICAL_ADDRESS SrbExtensionPhysicalBase;
+    ULONG SrbExtensionStride;
+
+    KSPIN_LOCK StartIoLock;
+    SLIST_HEADER CompletionList;
+    KDPC CompletionDpc;
 } FDO_DEVICE_EXTENSION, *PFDO_DEVICE_EXTENSION;
 
 
@@ -131,8 +195,27 @@ typedef struct _PDO_DEVICE_EXTENSION
     ULONG Target;
     ULONG Lun;
     PINQUIRYDATA InquiryBuffer;
-
-
+    PVOID LuExtension;
+
+    /* Request queue, protected by the adapter queue lock */
+    LIST_ENTRY RequestListHead;
+    LIST_ENTRY ActiveUnitListEntry;
+    BOOLEAN Active;
+    BOOLEAN Frozen;
+    volatile ULONG QueueDepth;
+    ULONG QueuedCount;
+    ULONG OutstandingCount;
+    PORT_QUEUE_HOLD Hold;
+
+    /* Counters, protected by the adapter queue lock */
+    ULONG MaxOutstandingCount;
+    ULONG ReadCount;
+    ULONG WriteCount;
+    LARGE_INTEGER BytesRead;
+    LARGE_INTEGER BytesWritten;
+    LARGE_INTEGER ReadTime;
+    LARGE_INTEGER WriteTime;
+    LONGLONG MaxLatency;
 } PDO_DEVICE_EXTENSION, *PPDO_DEVICE_EXTENSION;
 
 
@@ -171,6 +254,16 @@ BOOLEAN
 MiniportHwInterrupt(
     _In_ PMINIPORT Miniport);
 
+BOOLEAN
+MiniportHwMessageInterrupt(
+    _In_ PMINIPORT Miniport,
+    _In_ ULONG MessageId);
+
+BOOLEAN
+MiniportBuildIo(
+    _In_ PMINIPORT Miniport,
+    _In_ PSCSI_REQUEST_BLOCK Srb);
+
 BOOLEAN
 MiniportStartIo(
     _In_ PMINIPORT Miniport,
@@ -260,6 +353,82 @@ PortPdoPnp(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp);
 
+/* queue.c */
+
+VOID
+PortInitializeQueue(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension);
+
+NTSTATUS
+PortAllocateRequests(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension);
+
+VOID
+PortInitializeUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension);
+
+NTSTATUS
+PortQueueRequest(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension,
+    _In_ PIRP Irp,
+    _In_ PSCSI_REQUEST_BLOCK Srb);
+
+VOID
+PortReleaseUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension);
+
+VOID
+PortFlushUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension);
+
+VOID
+PortRequestComplete(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb);
+
+VOID
+PortCompleteActiveRequests(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ UCHAR PathId,
+    _In_ UCHAR TargetId,
+    _In_ UCHAR Lun,
+    _In_ UCHAR SrbStatus);
+
+VOID
+PortKickQueues(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension);
+
+VOID
+PortHoldBusy(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ ULONG RequestsToComplete);
+
+VOID
+PortHoldPause(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ ULONG TimeOut);
+
+VOID
+PortHoldRelease(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ BOOLEAN Resume);
+
+PPDO_DEVICE_EXTENSION
+PortGetUnit(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ UCHAR PathId,
+    _In_ UCHAR TargetId,
+    _In_ UCHAR Lun);
+
+PPORT_REQUEST
+PortGetSrbRequest(
+    _In_ PSCSI_REQUEST_BLOCK Srb);
+
+VOID
+PortQueryUnitPerformance(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension,
+    _Out_ PDISK_PERFORMANCE Performance);
+
 
 /* storport.c */
 
@@ -0,0 +1,961 @@
+/*
+ * PROJECT:     ReactOS Storport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Storport request queueing and completion
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* NOTE: Every unit (PDO) has its own request queue, which may have up to
+   QueueDepth requests outstanding at the miniport. Units with queued requests
+   sit on the adapter's active unit list and are served round-robin, as long
+   as a request slot is free. Every slot owns a queue tag and an SRB extension
+   from one physically contiguous block.
+   The miniport completes requests at any IRQL, so completions are pushed on
+   an interlocked list and processed in batches by the completion DPC, which
+   refills the hardware queues before it completes the IRPs. */
+
+/* INCLUDES *******************************************************************/
+
+#include "precomp.h"
+
+#define NDEBUG
+#include <debug.h>
+
+
+/* FUNCTIONS ******************************************************************/
+
+static
+ULONG
+PortGetTickCount(VOID)
+{
+    /* Interrupt time in milliseconds, the deadlines only need it to be monotonic */
+    return (ULONG)(KeQueryInterruptTime() / 10000);
+}
+
+
+static
+NTSTATUS
+PortSrbStatusToNtStatus(
+    _In_ UCHAR SrbStatus)
+{
+    switch (SRB_STATUS(SrbStatus))
+    {
+        case SRB_STATUS_SUCCESS:
+            return STATUS_SUCCESS;
+
+        case SRB_STATUS_TIMEOUT:
+        case SRB_STATUS_COMMAND_TIMEOUT:
+            return STATUS_IO_TIMEOUT;
+
+        case SRB_STATUS_BAD_SRB_BLOCK_LENGTH:
+        case SRB_STATUS_BAD_FUNCTION:
+        case SRB_STATUS_INVALID_REQUEST:
+            return STATUS_INVALID_DEVICE_REQUEST;
+
+        case SRB_STATUS_NO_DEVICE:
+        case SRB_STATUS_INVALID_LUN:
+        case SRB_STATUS_INVALID_TARGET_ID:
+        case SRB_STATUS_NO_HBA:
+            return STATUS_DEVICE_DOES_NOT_EXIST;
+
+        case SRB_STATUS_DATA_OVERRUN:
+            return STATUS_BUFFER_OVERFLOW;
+
+        case SRB_STATUS_SELECTION_TIMEOUT:
+            return STATUS_DEVICE_NOT_CONNECTED;
+
+        default:
+            return STATUS_IO_DEVICE_ERROR;
+    }
+}
+
+
+VOID
+PortHoldBusy(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ ULONG RequestsToComplete)
+{
+    /* The deadline restarts the queue if fewer requests complete than announced */
+    Hold->BusyDeadline = PortGetTickCount() + PORT_BUSY_TIMEOUT;
+    InterlockedExchange(&Hold->BusyCount, (LONG)max(RequestsToComplete, 1));
+}
+
+
+VOID
+PortHoldPause(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ ULONG TimeOut)
+{
+    Hold->PauseDeadline = PortGetTickCount() + TimeOut * 1000;
+    InterlockedExchange(&Hold->Paused, TRUE);
+}
+
+
+VOID
+PortHoldRelease(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ BOOLEAN Resume)
+{
+    if (Resume)
+        InterlockedExchange(&Hold->Paused, FALSE);
+    else
+        InterlockedExchange(&Hold->BusyCount, 0);
+}
+
+
+static
+VOID
+PortHoldRequestCompleted(
+    _In_ PPORT_QUEUE_HOLD Hold)
+{
+    LONG BusyCount;
+
+    /* Count down without going below zero, StorPortReady may race with us */
+    do
+    {
+        BusyCount = Hold->BusyCount;
+        if (BusyCount <= 0)
+            return;
+    } while (InterlockedCompareExchange(&Hold->BusyCount, BusyCount - 1, BusyCount) != BusyCount);
+}
+
+
+static
+BOOLEAN
+PortIsHeld(
+    _In_ PPORT_QUEUE_HOLD Hold,
+    _In_ ULONG Now,
+    _Inout_ PULONG NextDeadline)
+{
+    BOOLEAN Held = FALSE;
+
+    if (Hold->Paused)
+    {
+        if ((LONG)(Now - Hold->PauseDeadline) >= 0)
+        {
+            InterlockedExchange(&Hold->Paused, FALSE);
+        }
+        else
+        {
+            *NextDeadline = min(*NextDeadline, Hold->PauseDeadline - Now);
+            Held = TRUE;
+        }
+    }
+
+    if (Hold->BusyCount > 0)
+    {
+        if ((LONG)(Now - Hold->BusyDeadline) >= 0)
+        {
+            InterlockedExchange(&Hold->BusyCount, 0);
+        }
+        else
+        {
+            *NextDeadline = min(*NextDeadline, Hold->BusyDeadline - Now);
+            Held = TRUE;
+        }
+    }
+
+    return Held;
+}
+
+
+static
+VOID
+PortActivateUnit(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ PPDO_DEVICE_EXTENSION Unit)
+{
+    if (!Unit->Active)
+    {
+        InsertTailList(&DeviceExtension->ActiveUnitListHead,
+                       &Unit->ActiveUnitListEntry);
+        Unit->Active = TRUE;
+    }
+}
+
+
+static
+PPORT_REQUEST
+PortDequeueRequest(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG Now,
+    _Inout_ PULONG NextDeadline)
+{
+    PPDO_DEVICE_EXTENSION Unit;
+    PPORT_REQUEST Request;
+    PSCSI_REQUEST_BLOCK Srb;
+    PLIST_ENTRY UnitEntry;
+    PIRP Irp;
+
+    if (IsListEmpty(&DeviceExtension->FreeRequestListHead))
+        return NULL;
+
+    if (PortIsHeld(&DeviceExtension->Hold, Now, NextDeadline))
+        return NULL;
+
+    for (UnitEntry = DeviceExtension->ActiveUnitListHead.Flink;
+         UnitEntry != &DeviceExtension->ActiveUnitListHead;
+         UnitEntry = UnitEntry->Flink)
+    {
+        Unit = CONTAINING_RECORD(UnitEntry, PDO_DEVICE_EXTENSION, ActiveUnitListEntry);
+        ASSERT(!IsListEmpty(&Unit->RequestListHead));
+
+        if (Unit->OutstandingCount >= Unit->QueueDepth)
+            continue;
+
+        if (PortIsHeld(&Unit->Hold, Now, NextDeadline))
+            continue;
+
+        Irp = CONTAINING_RECORD(Unit->RequestListHead.Flink, IRP, Tail.Overlay.ListEntry);
+        Srb = IoGetCurrentIrpStackLocation(Irp)->Parameters.Scsi.Srb;
+
+        /* A frozen queue only lets the class driver's recovery requests through */
+        if (Unit->Frozen && !(Srb->SrbFlags & SRB_FLAGS_BYPASS_FROZEN_QUEUE))
+            continue;
+
+        RemoveHeadList(&Unit->RequestListHead);
+        Unit->QueuedCount--;
+
+        /* Serve the units round-robin */
+        RemoveEntryList(&Unit->ActiveUnitListEntry);
+        if (IsListEmpty(&Unit->RequestListHead))
+            Unit->Active = FALSE;
+        else
+            InsertTailList(&DeviceExtension->ActiveUnitListHead, &Unit->ActiveUnitListEntry);
+
+        Request = CONTAINING_RECORD(RemoveHeadList(&DeviceExtension->FreeRequestListHead),
+                                    PORT_REQUEST,
+                                    FreeListEntry);
+        Request->Irp = Irp;
+        Request->Srb = Srb;
+        Request->Unit = Unit;
+        InterlockedExchange(&Request->State, RequestActive);
+
+        Unit->OutstandingCount++;
+        if (Unit->OutstandingCount > Unit->MaxOutstandingCount)
+            Unit->MaxOutstandingCount = Unit->OutstandingCount;
+        DeviceExtension->OutstandingCount++;
+
+        return Request;
+    }
+
+    return NULL;
+}
+
+
+static
+PSTOR_SCATTER_GATHER_LIST
+PortBuildScatterGatherList(
+    _In_ PIRP Irp,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PSTOR_SCATTER_GATHER_LIST SgList;
+    PPFN_NUMBER PfnArray = NULL;
+    PHYSICAL_ADDRESS Address;
+    PUCHAR Buffer, MdlBuffer;
+    ULONG Remaining, Length, Count = 0, Page = 0;
+    PMDL Mdl;
+
+    Buffer = Srb->DataBuffer;
+    Remaining = Srb->DataTransferLength;
+
+    SgList = ExAllocatePoolWithTag(NonPagedPool,
+                                   FIELD_OFFSET(STOR_SCATTER_GATHER_LIST,
+                                                List[ADDRESS_AND_SIZE_TO_SPAN_PAGES(Buffer, Remaining)]),
+                                   TAG_SG_LIST);
+    if (SgList == NULL)
+        return NULL;
+
+    /* Use the MDL if it describes the buffer, otherwise the buffer must be
+       in nonpaged system space, like the port's own requests */
+    Mdl = Irp->MdlAddress;
+    if (Mdl != NULL)
+    {
+        MdlBuffer = MmGetMdlVirtualAddress(Mdl);
+        if ((Buffer >= MdlBuffer) &&
+            (Buffer + Remaining <= MdlBuffer + MmGetMdlByteCount(Mdl)))
+        {
+            PfnArray = MmGetMdlPfnArray(Mdl);
+            Page = (ULONG)(((ULONG_PTR)Buffer - (ULONG_PTR)PAGE_ALIGN(MdlBuffer)) >> PAGE_SHIFT);
+        }
+    }
+
+    while (Remaining != 0)
+    {
+        Length = min(PAGE_SIZE - BYTE_OFFSET(Buffer), Remaining);
+
+        if (PfnArray != NULL)
+            Address.QuadPart = ((ULONGLONG)PfnArray[Page++] << PAGE_SHIFT) + BYTE_OFFSET(Buffer);
+        else
+            Address = MmGetPhysicalAddress(Buffer);
+
+        /* Merge physically contiguous pages */
+        if ((Count != 0) &&
+            (SgList->List[Count - 1].PhysicalAddress.QuadPart + SgList->List[Count - 1].Length == Address.QuadPart))
+        {
+            SgList->List[Count - 1].Length += Length;
+        }
+        else
+        {
+            SgList->List[Count].PhysicalAddress = Address;
+            SgList->List[Count].Length = Length;
+            SgList->List[Count].Reserved = 0;
+            Count++;
+        }
+
+        Buffer += Length;
+        Remaining -= Length;
+    }
+
+    SgList->NumberOfElements = Count;
+    SgList->Reserved = 0;
+
+    return SgList;
+}
+
+
+static
+VOID
+PortStartRequest(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ PPORT_REQUEST Request)
+{
+    PMINIPORT Miniport = &DeviceExtension->Miniport;
+    PSCSI_REQUEST_BLOCK Srb = Request->Srb;
+    KLOCK_QUEUE_HANDLE LockHandle;
+    KIRQL OldIrql;
+
+    DPRINT("PortStartRequest(%p %p)\n", DeviceExtension, Request);
+
+    /* Let the miniport's completion find its way back to the slot */
+    Request->Irp->Tail.Overlay.DriverContext[0] = Request;
+
+    Srb->SrbStatus = SRB_STATUS_PENDING;
+    Srb->SrbExtension = Request->SrbExtension;
+    if (Srb->SrbExtension != NULL)
+        RtlZeroMemory(Srb->SrbExtension, Miniport->InitData->SrbExtensionSize);
+
+    /* The slot number doubles as the queue tag */
+    if (Miniport->InitData->TaggedQueuing)
+    {
+        Srb->QueueTag = Request->QueueTag;
+        if ((Request->Unit->QueueDepth > 1) &&
+            !(Srb->SrbFlags & SRB_FLAGS_QUEUE_ACTION_ENABLE))
+        {
+            Srb->SrbFlags |= SRB_FLAGS_QUEUE_ACTION_ENABLE;
+            Srb->QueueAction = SRB_SIMPLE_TAG_REQUEST;
+        }
+    }
+    else
+    {
+        Srb->QueueTag = SP_UNTAGGED;
+        Srb->SrbFlags &= ~SRB_FLAGS_QUEUE_ACTION_ENABLE;
+    }
+
+    if ((Srb->DataBuffer != NULL) && (Srb->DataTransferLength != 0))
+    {
+        Request->SgList = PortBuildScatterGatherList(Request->Irp, Srb);
+        if (Request->SgList == NULL)
+        {
+            Srb->SrbStatus = SRB_STATUS_INTERNAL_ERROR;
+            PortRequestComplete(DeviceExtension, Srb);
+            return;
+        }
+    }
+
+    Request->StartTime = KeQueryPerformanceCounter(NULL);
+
+    /* A miniport which fails HwBuildIo has completed the request already */
+    if ((Miniport->InitData->HwBuildIo != NULL) &&
+        !MiniportBuildIo(Miniport, Srb))
+    {
+        return;
+    }
+
+    if ((Miniport->PortConfig.SynchronizationModel == StorSynchronizeFullDuplex) ||
+        (DeviceExtension->Interrupt == NULL))
+    {
+        KeAcquireInStackQueuedSpinLock(&DeviceExtension->StartIoLock, &LockHandle);
+        MiniportStartIo(Miniport, Srb);
+        KeReleaseInStackQueuedSpinLock(&LockHandle);
+    }
+    else
+    {
+        /* Half duplex miniports expect HwStartIo to be synchronized with their interrupt */
+        OldIrql = KeAcquireInterruptSpinLock(DeviceExtension->Interrupt);
+        MiniportStartIo(Miniport, Srb);
+        KeReleaseInterruptSpinLock(DeviceExtension->Interrupt, OldIrql);
+    }
+}
+
+
+static
+VOID
+PortStartNextRequests(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension)
+{
+    KLOCK_QUEUE_HANDLE LockHandle;
+    PPORT_REQUEST Request;
+    LARGE_INTEGER DueTime;
+    ULONG NextDeadline;
+
+    for (;;)
+    {
+        NextDeadline = MAXULONG;
+
+        KeAcquireInStackQueuedSpinLock(&DeviceExtension->QueueLock, &LockHandle);
+
+        Request = PortDequeueRequest(DeviceExtension,
+                                     PortGetTickCount(),
+                                     &NextDeadline);
+        if ((Request == NULL) && (NextDeadline != MAXULONG))
+        {
+            /* Something is held back, look again when the earliest hold expires */
+            DueTime.QuadPart = Int32x32To64(NextDeadline + 1, -10000);
+            KeSetTimer(&DeviceExtension->ResumeTimer,
+                       DueTime,
+                       &DeviceExtension->ResumeDpc);
+        }
+
+        KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+        if (Request == NULL)
+            break;
+
+        PortStartRequest(DeviceExtension, Request);
+    }
+}
+
+
+static
+VOID
+PortFinishRequest(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ PPORT_REQUEST Request,
+    _In_ LONGLONG Now,
+    _In_ LONGLONG Frequency,
+    _Inout_ PLIST_ENTRY CompletedListHead)
+{
+    PPDO_DEVICE_EXTENSION Unit = Request->Unit;
+    PSCSI_REQUEST_BLOCK Srb = Request->Srb;
+    PIRP Irp = Request->Irp;
+    LONGLONG Latency;
+
+    /* Give the slot back, most recently used first to keep its SRB extension cached */
+    if (Request->SgList != NULL)
+    {
+        ExFreePoolWithTag(Request->SgList, TAG_SG_LIST);
+        Request->SgList = NULL;
+    }
+
+    Irp->Tail.Overlay.DriverContext[0] = NULL;
+    Request->Irp = NULL;
+    Request->Srb = NULL;
+    Request->Unit = NULL;
+    InterlockedExchange(&Request->State, RequestFree);
+    InsertHeadList(&DeviceExtension->FreeRequestListHead, &Request->FreeListEntry);
+
+    Unit->OutstandingCount--;
+    DeviceExtension->OutstandingCount--;
+    PortHoldRequestCompleted(&DeviceExtension->Hold);
+    PortHoldRequestCompleted(&Unit->Hold);
+
+    if (SRB_STATUS(Srb->SrbStatus) == SRB_STATUS_BUSY)
+    {
+        /* The device could not take it, retry once the unit has settled */
+        DPRINT("Requeueing busy SRB %p\n", Srb);
+        InsertHeadList(&Unit->RequestListHead, &Irp->Tail.Overlay.ListEntry);
+        Unit->QueuedCount++;
+        PortActivateUnit(DeviceExtension, Unit);
+        PortHoldBusy(&Unit->Hold, 1);
+        return;
+    }
+
+    /* Latency in 100ns units, like the disk performance counters */
+    Latency = (Now - Request->StartTime.QuadPart) * 10000000 / Frequency;
+    if (Latency > Unit->MaxLatency)
+        Unit->MaxLatency = Latency;
+
+    if (Srb->SrbFlags & SRB_FLAGS_DATA_IN)
+    {
+        Unit->ReadCount++;
+        Unit->BytesRead.QuadPart += Srb->DataTransferLength;
+        Unit->ReadTime.QuadPart += Latency;
+    }
+    else if (Srb->SrbFlags & SRB_FLAGS_DATA_OUT)
+    {
+        Unit->WriteCount++;
+        Unit->BytesWritten.QuadPart += Srb->DataTransferLength;
+        Unit->WriteTime.QuadPart += Latency;
+    }
+
+    if (SRB_STATUS(Srb->SrbStatus) == SRB_STATUS_SUCCESS)
+    {
+        Irp->IoStatus.Status = STATUS_SUCCESS;
+        Irp->IoStatus.Information = Srb->DataTransferLength;
+    }
+    else
+    {
+        /* Hold the unit until the class driver has dealt with the error */
+        if (!(Srb->SrbFlags & SRB_FLAGS_NO_QUEUE_FREEZE))
+        {
+            Unit->Frozen = TRUE;
+            Srb->SrbStatus |= SRB_STATUS_QUEUE_FROZEN;
+        }
+
+        Irp->IoStatus.Status = PortSrbStatusToNtStatus(Srb->SrbStatus);
+        Irp->IoStatus.Information = 0;
+    }
+
+    InsertTailList(CompletedListHead, &Irp->Tail.Overlay.ListEntry);
+}
+
+
+static
+VOID
+NTAPI
+PortCompletionDpcRoutine(
+    _In_ PKDPC Dpc,
+    _In_opt_ PVOID DeferredContext,
+    _In_opt_ PVOID SystemArgument1,
+    _In_opt_ PVOID SystemArgument2)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension = (PFDO_DEVICE_EXTENSION)DeferredContext;
+    PSLIST_ENTRY Entry, NextEntry, Batch = NULL;
+    LIST_ENTRY CompletedListHead;
+    KLOCK_QUEUE_HANDLE LockHandle;
+    LARGE_INTEGER Now, Frequency;
+    PPORT_REQUEST Request;
+    PIRP Irp;
+
+    /* Take everything the miniport completed since the last run,
+       and put it back in completion order */
+    Entry = InterlockedFlushSList(&DeviceExtension->CompletionList);
+    while (Entry != NULL)
+    {
+        NextEntry = Entry->Next;
+        Entry->Next = Batch;
+        Batch = Entry;
+        Entry = NextEntry;
+    }
+
+    InitializeListHead(&CompletedListHead);
+
+    if (Batch != NULL)
+    {
+        Now = KeQueryPerformanceCounter(&Frequency);
+
+        KeAcquireInStackQueuedSpinLockAtDpcLevel(&DeviceExtension->QueueLock, &LockHandle);
+
+        for (Entry = Batch; Entry != NULL; Entry = NextEntry)
+        {
+            NextEntry = Entry->Next;
+            Request = CONTAINING_RECORD(Entry, PORT_REQUEST, CompletionEntry);
+            PortFinishRequest(DeviceExtension,
+                              Request,
+                              Now.QuadPart,
+                              Frequency.QuadPart,
+                              &CompletedListHead);
+        }
+
+        KeReleaseInStackQueuedSpinLockFromDpcLevel(&LockHandle);
+    }
+
+    /* Refill the hardware queues first, so the device keeps working
+       while the class drivers run their completion routines */
+    PortStartNextRequests(DeviceExtension);
+
+    while (!IsListEmpty(&CompletedListHead))
+    {
+        Irp = CONTAINING_RECORD(RemoveHeadList(&CompletedListHead), IRP, Tail.Overlay.ListEntry);
+        IoCompleteRequest(Irp, IO_DISK_INCREMENT);
+    }
+}
+
+
+static
+VOID
+NTAPI
+PortResumeDpcRoutine(
+    _In_ PKDPC Dpc,
+    _In_opt_ PVOID DeferredContext,
+    _In_opt_ PVOID SystemArgument1,
+    _In_opt_ PVOID SystemArgument2)
+{
+    PortStartNextRequests((PFDO_DEVICE_EXTENSION)DeferredContext);
+}
+
+
+VOID
+PortInitializeQueue(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension)
+{
+    KeInitializeSpinLock(&DeviceExtension->QueueLock);
+    InitializeListHead(&DeviceExtension->ActiveUnitListHead);
+    InitializeListHead(&DeviceExtension->FreeRequestListHead);
+
+    KeInitializeTimer(&DeviceExtension->ResumeTimer);
+    KeInitializeDpc(&DeviceExtension->ResumeDpc,
+                    PortResumeDpcRoutine,
+                    DeviceExtension);
+
+    KeInitializeSpinLock(&DeviceExtension->StartIoLock);
+    InitializeSListHead(&DeviceExtension->CompletionList);
+    KeInitializeDpc(&DeviceExtension->CompletionDpc,
+                    PortCompletionDpcRoutine,
+                    DeviceExtension);
+}
+
+
+NTSTATUS
+PortAllocateRequests(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension)
+{
+    PHW_INITIALIZATION_DATA InitData = DeviceExtension->Miniport.InitData;
+    PHYSICAL_ADDRESS LowestAddress, HighestAddress, Alignment;
+    PPORT_REQUEST Requests = NULL;
+    PUCHAR SrbExtensionBase = NULL;
+    ULONG Stride, Count, i;
+
+    DPRINT1("PortAllocateRequests(%p)\n", DeviceExtension);
+
+    if (DeviceExtension->Requests != NULL)
+        return STATUS_SUCCESS;
+
+    Stride = ALIGN_UP_BY(InitData->SrbExtensionSize, PORT_SRB_EXTENSION_ALIGNMENT);
+
+    Alignment.QuadPart = 0;
+    LowestAddress.QuadPart = 0;
+    HighestAddress.QuadPart = 0x00000000FFFFFFFF;
+
+    /* Ask for a full set of queue tags, settle for fewer if memory is tight */
+    for (Count = PORT_MAXIMUM_REQUESTS; Count != 0; Count /= 2)
+    {
+        Requests = ExAllocatePoolWithTag(NonPagedPool,
+                                         Count * sizeof(PORT_REQUEST),
+                                         TAG_REQUEST);
+        if (Requests == NULL)
+            continue;
+
+        if (Stride == 0)
+            break;
+
+        /* The miniport hands its SRB extensions to the hardware (AHCI command
+           tables for example), so they must be physically contiguous */
+        SrbExtensionBase = MmAllocateContiguousMemorySpecifyCache(Count * Stride,
+                                                                  LowestAddress,
+                                                                  HighestAddress,
+                                                                  Alignment,
+                                                                  MmCached);
+        if (SrbExtensionBase != NULL)
+            break;
+
+        ExFreePoolWithTag(Requests, TAG_REQUEST);
+        Requests = NULL;
+    }
+
+    if (Requests == NULL)
+        return STATUS_INSUFFICIENT_RESOURCES;
+
+    RtlZeroMemory(Requests, Count * sizeof(PORT_REQUEST));
+
+    for (i = 0; i < Count; i++)
+    {
+        Requests[i].State = RequestFree;
+        Requests[i].QueueTag = (UCHAR)i;
+        if (SrbExtensionBase != NULL)
+            Requests[i].SrbExtension = SrbExtensionBase + i * Stride;
+
+        InsertTailList(&DeviceExtension->FreeRequestListHead,
+                       &Requests[i].FreeListEntry);
+    }
+
+    DeviceExtension->Requests = Requests;
+    DeviceExtension->RequestCount = Count;
+    DeviceExtension->SrbExtensionBase = SrbExtensionBase;
+    DeviceExtension->SrbExtensionStride = Stride;
+    if (SrbExtensionBase != NULL)
+        DeviceExtension->SrbExtensionPhysicalBase = MmGetPhysicalAddress(SrbExtensionBase);
+
+    DPRINT1("Request slots: %lu  SRB extension stride: %lu\n", Count, Stride);
+
+    return STATUS_SUCCESS;
+}
+
+
+VOID
+PortInitializeUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension = PdoExtension->FdoExtension;
+
+    InitializeListHead(&PdoExtension->RequestListHead);
+
+    /* Miniports without multiple requests per unit get one at a time, the
+       others get a moderate depth until they tell us what the device takes */
+    if (DeviceExtension->Miniport.InitData->MultipleRequestPerLu)
+        PdoExtension->QueueDepth = max(min(PORT_DEFAULT_UNIT_QUEUE_DEPTH, DeviceExtension->RequestCount), 1);
+    else
+        PdoExtension->QueueDepth = 1;
+}
+
+
+NTSTATUS
+PortQueueRequest(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension,
+    _In_ PIRP Irp,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension = PdoExtension->FdoExtension;
+    KLOCK_QUEUE_HANDLE LockHandle;
+
+    DPRINT("PortQueueRequest(%p %p %p)\n", PdoExtension, Irp, Srb);
+
+    /* No request slots, the miniport was never started */
+    if (DeviceExtension->RequestCount == 0)
+    {
+        Srb->SrbStatus = SRB_STATUS_NO_HBA;
+        Irp->IoStatus.Status = STATUS_DEVICE_NOT_READY;
+        Irp->IoStatus.Information = 0;
+        IoCompleteRequest(Irp, IO_NO_INCREMENT);
+        return STATUS_DEVICE_NOT_READY;
+    }
+
+    Srb->SrbStatus = SRB_STATUS_PENDING;
+    Irp->Tail.Overlay.DriverContext[0] = NULL;
+    IoMarkIrpPending(Irp);
+
+    KeAcquireInStackQueuedSpinLock(&DeviceExtension->QueueLock, &LockHandle);
+
+    /* Requests bypassing a frozen queue are the class driver's error
+       recovery, they go ahead of everything else */
+    if (Srb->SrbFlags & SRB_FLAGS_BYPASS_FROZEN_QUEUE)
+        InsertHeadList(&PdoExtension->RequestListHead, &Irp->Tail.Overlay.ListEntry);
+    else
+        InsertTailList(&PdoExtension->RequestListHead, &Irp->Tail.Overlay.ListEntry);
+
+    PdoExtension->QueuedCount++;
+    PortActivateUnit(DeviceExtension, PdoExtension);
+
+    KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+    PortStartNextRequests(DeviceExtension);
+
+    return STATUS_PENDING;
+}
+
+
+VOID
+PortReleaseUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension = PdoExtension->FdoExtension;
+    KLOCK_QUEUE_HANDLE LockHandle;
+
+    DPRINT("PortReleaseUnitQueue(%p)\n", PdoExtension);
+
+    KeAcquireInStackQueuedSpinLock(&DeviceExtension->QueueLock, &LockHandle);
+    PdoExtension->Frozen = FALSE;
+    KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+    PortStartNextRequests(DeviceExtension);
+}
+
+
+VOID
+PortFlushUnitQueue(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension)
+{
+    PFDO_DEVICE_EXTENSION DeviceExtension = PdoExtension->FdoExtension;
+    KLOCK_QUEUE_HANDLE LockHandle;
+    LIST_ENTRY FlushListHead;
+    PSCSI_REQUEST_BLOCK Srb;
+    PIRP Irp;
+
+    DPRINT("PortFlushUnitQueue(%p)\n", PdoExtension);
+
+    InitializeListHead(&FlushListHead);
+
+    KeAcquireInStackQueuedSpinLock(&DeviceExtension->QueueLock, &LockHandle);
+
+    while (!IsListEmpty(&PdoExtension->RequestListHead))
+    {
+        InsertTailList(&FlushListHead, RemoveHeadList(&PdoExtension->RequestListHead));
+    }
+
+    PdoExtension->QueuedCount = 0;
+    PdoExtension->Frozen = FALSE;
+    if (PdoExtension->Active)
+    {
+        RemoveEntryList(&PdoExtension->ActiveUnitListEntry);
+        PdoExtension->Active = FALSE;
+    }
+
+    KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+    while (!IsListEmpty(&FlushListHead))
+    {
+        Irp = CONTAINING_RECORD(RemoveHeadList(&FlushListHead), IRP, Tail.Overlay.ListEntry);
+        Srb = IoGetCurrentIrpStackLocation(Irp)->Parameters.Scsi.Srb;
+
+        Srb->SrbStatus = SRB_STATUS_REQUEST_FLUSHED;
+        Irp->IoStatus.Status = STATUS_UNSUCCESSFUL;
+        Irp->IoStatus.Information = 0;
+        IoCompleteRequest(Irp, IO_NO_INCREMENT);
+    }
+}
+
+
+PPORT_REQUEST
+PortGetSrbRequest(
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PPORT_REQUEST Request;
+    PIRP Irp;
+
+    Irp = Srb->OriginalRequest;
+    if (Irp == NULL)
+        return NULL;
+
+    Request = Irp->Tail.Overlay.DriverContext[0];
+    if ((Request == NULL) || (Request->Srb != Srb))
+        return NULL;
+
+    return Request;
+}
+
+
+VOID
+PortRequestComplete(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PPORT_REQUEST Request;
+
+    DPRINT("PortRequestComplete(%p %p)\n", DeviceExtension, Srb);
+
+    Request = PortGetSrbRequest(Srb);
+    if (Request == NULL)
+    {
+        DPRINT1("Completing unknown SRB %p\n", Srb);
+        return;
+    }
+
+    /* StorPortCompleteRequest may race with the miniport's own completion */
+    if (InterlockedCompareExchange(&Request->State, RequestCompleting, RequestActive) != RequestActive)
+        return;
+
+    InterlockedPushEntrySList(&DeviceExtension->CompletionList,
+                              &Request->CompletionEntry);
+    KeInsertQueueDpc(&DeviceExtension->CompletionDpc, NULL, NULL);
+}
+
+
+VOID
+PortCompleteActiveRequests(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ UCHAR PathId,
+    _In_ UCHAR TargetId,
+    _In_ UCHAR Lun,
+    _In_ UCHAR SrbStatus)
+{
+    PSCSI_REQUEST_BLOCK Srb;
+    ULONG i;
+
+    for (i = 0; i < DeviceExtension->RequestCount; i++)
+    {
+        if (DeviceExtension->Requests[i].State != RequestActive)
+            continue;
+
+        Srb = DeviceExtension->Requests[i].Srb;
+        if (Srb == NULL)
+            continue;
+
+        /* SP_UNTAGGED is the wildcard */
+        if (((PathId != SP_UNTAGGED) && (Srb->PathId != PathId)) ||
+            ((TargetId != SP_UNTAGGED) && (Srb->TargetId != TargetId)) ||
+            ((Lun != SP_UNTAGGED) && (Srb->Lun != Lun)))
+        {
+            continue;
+        }
+
+        Srb->SrbStatus = SrbStatus;
+        PortRequestComplete(DeviceExtension, Srb);
+    }
+}
+
+
+VOID
+PortKickQueues(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension)
+{
+    /* The miniport may call us at any IRQL, restart the queues from the DPC */
+    KeInsertQueueDpc(&DeviceExtension->CompletionDpc, NULL, NULL);
+}
+
+
+PPDO_DEVICE_EXTENSION
+PortGetUnit(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ UCHAR PathId,
+    _In_ UCHAR TargetId,
+    _In_ UCHAR Lun)
+{
+    PPDO_DEVICE_EXTENSION PdoExtension, Unit = NULL;
+    KLOCK_QUEUE_HANDLE LockHandle;
+    PLIST_ENTRY ListEntry;
+    BOOLEAN Locked;
+
+    /* Units are only unlinked once they have no requests left, so the
+       miniport may look up the unit of its request above dispatch level */
+    Locked = (KeGetCurrentIrql() <= DISPATCH_LEVEL);
+    if (Locked)
+        KeAcquireInStackQueuedSpinLock(&DeviceExtension->PdoListLock, &LockHandle);
+
+    for (ListEntry = DeviceExtension->PdoListHead.Flink;
+         ListEntry != &DeviceExtension->PdoListHead;
+         ListEntry = ListEntry->Flink)
+    {
+        PdoExtension = CONTAINING_RECORD(ListEntry, PDO_DEVICE_EXTENSION, PdoListEntry);
+        if ((PdoExtension->Bus == PathId) &&
+            (PdoExtension->Target == TargetId) &&
+            (PdoExtension->Lun == Lun))
+        {
+            Unit = PdoExtension;
+            break;
+        }
+    }
+
+    if (Locked)
+        KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+    return Unit;
+}
+
+
+VOID
+PortQueryUnitPerformance(
+    _In_ PPDO_DEVICE_EXTENSION PdoExtension,
+    _Out_ PDISK_PERFORMANCE Performance)
+{
+    KLOCK_QUEUE_HANDLE LockHandle;
+
+    RtlZeroMemory(Performance, sizeof(DISK_PERFORMANCE));
+
+    KeAcquireInStackQueuedSpinLock(&PdoExtension->FdoExtension->QueueLock, &LockHandle);
+
+    Performance->BytesRead = PdoExtension->BytesRead;
+    Performance->BytesWritten = PdoExtension->BytesWritten;
+    Performance->ReadTime = PdoExtension->ReadTime;
+    Performance->WriteTime = PdoExtension->WriteTime;
+    Performance->ReadCount = PdoExtension->ReadCount;
+    Performance->WriteCount = PdoExtension->WriteCount;
+    Performance->QueueDepth = PdoExtension->OutstandingCount + PdoExtension->QueuedCount;
+
+    KeReleaseInStackQueuedSpinLock(&LockHandle);
+
+    KeQuerySystemTime(&Performance->QueryTime);
+    RtlCopyMemory(Performance->StorageManagerName, L"StorPort", sizeof(Performance->StorageManagerName));
+}
+
+/* EOF */
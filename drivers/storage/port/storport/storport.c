@@ -108,23 +108,28 @@ PortAcquireSpinLock(
     PVOID LockContext,
     PSTOR_LOCK_HANDLE LockHandle)
 {
-    DPRINT1("PortAcquireSpinLock(%p %lu %p %p)\n",
-            DeviceExtension, SpinLock, LockContext, LockHandle);
+    DPRINT("PortAcquireSpinLock(%p %lu %p %p)\n",
+           DeviceExtension, SpinLock, LockContext, LockHandle);
 
     LockHandle->Lock = SpinLock;
 
+    /* The lock handle context has the layout of a KLOCK_QUEUE_HANDLE */
     switch (SpinLock)
     {
         case DpcLock: /* 1, */
-            DPRINT1("DpcLock\n");
+            DPRINT("DpcLock\n");
+            KeAcquireInStackQueuedSpinLock((PKSPIN_LOCK)&((PSTOR_DPC)LockContext)->Lock,
+                                           (PKLOCK_QUEUE_HANDLE)&LockHandle->Context);
             break;
 
         case StartIoLock: /* 2 */
-            DPRINT1("StartIoLock\n");
+            DPRINT("StartIoLock\n");
+            KeAcquireInStackQueuedSpinLock(&DeviceExtension->StartIoLock,
+                                           (PKLOCK_QUEUE_HANDLE)&LockHandle->Context);
             break;
 
         case InterruptLock: /* 3 */
-            DPRINT1("InterruptLock\n");
+            DPRINT("InterruptLock\n");
             if (DeviceExtension->Interrupt == NULL)
                 LockHandle->Context.OldIrql = 0;
             else
@@ -140,21 +145,19 @@ PortReleaseSpinLock(
     PFDO_DEVICE_EXTENSION DeviceExtension,
     PSTOR_LOCK_HANDLE LockHandle)
 {
-    DPRINT1("PortReleaseSpinLock(%p %p)\n",
-            DeviceExtension, LockHandle);
+    DPRINT("PortReleaseSpinLock(%p %p)\n",
+           DeviceExtension, LockHandle);
 
     switch (LockHandle->Lock)
     {
         case DpcLock: /* 1, */
-            DPRINT1("DpcLock\n");
-            break;
-
         case StartIoLock: /* 2 */
-            DPRINT1("StartIoLock\n");
+            DPRINT("DpcLock or StartIoLock\n");
+            KeReleaseInStackQueuedSpinLock((PKLOCK_QUEUE_HANDLE)&LockHandle->Context);
             break;
 
         case InterruptLock: /* 3 */
-            DPRINT1("InterruptLock\n");
+            DPRINT("InterruptLock\n");
             if (DeviceExtension->Interrupt != NULL)
                 KeReleaseInterruptSpinLock(DeviceExtension->Interrupt,
                                            LockHandle->Context.OldIrql);
@@ -163,6 +166,21 @@ PortReleaseSpinLock(
 }
 
 
+static
+PFDO_DEVICE_EXTENSION
+PortGetAdapterExtension(
+    _In_ PVOID HwDeviceExtension)
+{
+    PMINIPORT_DEVICE_EXTENSION MiniportExtension;
+
+    MiniportExtension = CONTAINING_RECORD(HwDeviceExtension,
+                                          MINIPORT_DEVICE_EXTENSION,
+                                          HwDeviceExtension);
+
+    return MiniportExtension->Miniport->DeviceExtension;
+}
+
+
 static
 NTSTATUS
 NTAPI
@@ -226,6 +244,8 @@ PortAddDevice(
     KeInitializeSpinLock(&DeviceExtension->PdoListLock);
     InitializeListHead(&DeviceExtension->PdoListHead);
 
+    PortInitializeQueue(DeviceExtension);
+
     /* Attach the FDO to the device stack */
     Status = IoAttachDeviceToDeviceStackSafe(Fdo,
                                              PhysicalDeviceObject,
@@ -327,15 +347,39 @@ PortDispatchDeviceControl(
     IN PDEVICE_OBJECT DeviceObject,
     IN PIRP Irp)
 {
-    DPRINT1("PortDispatchDeviceControl(%p %p)\n",
-            DeviceObject, Irp);
+    PPDO_DEVICE_EXTENSION DeviceExtension;
+    PIO_STACK_LOCATION Stack;
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    DPRINT("PortDispatchDeviceControl(%p %p)\n",
+           DeviceObject, Irp);
 
-    Irp->IoStatus.Status = STATUS_SUCCESS;
     Irp->IoStatus.Information = 0;
 
+    Stack = IoGetCurrentIrpStackLocation(Irp);
+    DeviceExtension = (PPDO_DEVICE_EXTENSION)DeviceObject->DeviceExtension;
+
+    /* Report the unit's I/O counters */
+    if ((DeviceExtension->ExtensionType == PdoExtension) &&
+        (Stack->Parameters.DeviceIoControl.IoControlCode == IOCTL_DISK_PERFORMANCE))
+    {
+        if (Stack->Parameters.DeviceIoControl.OutputBufferLength < sizeof(DISK_PERFORMANCE))
+        {
+            Status = STATUS_BUFFER_TOO_SMALL;
+        }
+        else
+        {
+            PortQueryUnitPerformance(DeviceExtension,
+                                     (PDISK_PERFORMANCE)Irp->AssociatedIrp.SystemBuffer);
+            Irp->IoStatus.Information = sizeof(DISK_PERFORMANCE);
+        }
+    }
+
+    Irp->IoStatus.Status = Status;
+
     IoCompleteRequest(Irp, IO_NO_INCREMENT);
 
-    return STATUS_SUCCESS;
+    return Status;
 }
 
 
@@ -348,11 +392,11 @@ PortDispatchScsi(
 {
     PFDO_DEVICE_EXTENSION DeviceExtension;
 
-    DPRINT1("PortDispatchScsi(%p %p)\n",
-            DeviceObject, Irp);
+    DPRINT("PortDispatchScsi(%p %p)\n",
+           DeviceObject, Irp);
 
     DeviceExtension = (PFDO_DEVICE_EXTENSION)DeviceObject->DeviceExtension;
-    DPRINT1("ExtensionType: %u\n", DeviceExtension->ExtensionType);
+    DPRINT("ExtensionType: %u\n", DeviceExtension->ExtensionType);
 
     switch (DeviceExtension->ExtensionType)
     {
@@ -480,7 +524,7 @@ StorPortAllocateRegistryBuffer(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -489,14 +533,17 @@ StorPortBusy(
     _In_ PVOID HwDeviceExtension,
     _In_ ULONG RequestsToComplete)
 {
-    DPRINT1("StorPortBuzy()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    DPRINT("StorPortBusy(%p %lu)\n", HwDeviceExtension, RequestsToComplete);
+
+    PortHoldBusy(&PortGetAdapterExtension(HwDeviceExtension)->Hold,
+                 RequestsToComplete);
+
+    return TRUE;
 }
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 VOID
@@ -508,8 +555,14 @@ StorPortCompleteRequest(
     _In_ UCHAR Lun,
     _In_ UCHAR SrbStatus)
 {
-    DPRINT1("StorPortCompleteRequest()\n");
-    UNIMPLEMENTED;
+    DPRINT1("StorPortCompleteRequest(%p %u %u %u 0x%02x)\n",
+            HwDeviceExtension, PathId, TargetId, Lun, SrbStatus);
+
+    PortCompleteActiveRequests(PortGetAdapterExtension(HwDeviceExtension),
+                               PathId,
+                               TargetId,
+                               Lun,
+                               SrbStatus);
 }
 
 
@@ -565,7 +618,7 @@ StorPortDebugPrint(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -577,14 +630,23 @@ StorPortDeviceBusy(
     _In_ UCHAR Lun,
     _In_ ULONG RequestsToComplete)
 {
-    DPRINT1("StorPortDeviceBusy()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT("StorPortDeviceBusy(%p %u %u %u %lu)\n",
+           HwDeviceExtension, PathId, TargetId, Lun, RequestsToComplete);
+
+    Unit = PortGetUnit(PortGetAdapterExtension(HwDeviceExtension), PathId, TargetId, Lun);
+    if (Unit == NULL)
+        return FALSE;
+
+    PortHoldBusy(&Unit->Hold, RequestsToComplete);
+
+    return TRUE;
 }
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -595,9 +657,38 @@ StorPortDeviceReady(
     _In_ UCHAR TargetId,
     _In_ UCHAR Lun)
 {
-    DPRINT1("StorPortDeviceReady()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT("StorPortDeviceReady(%p %u %u %u)\n",
+           HwDeviceExtension, PathId, TargetId, Lun);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    Unit = PortGetUnit(DeviceExtension, PathId, TargetId, Lun);
+    if (Unit == NULL)
+        return FALSE;
+
+    PortHoldRelease(&Unit->Hold, FALSE);
+    PortKickQueues(DeviceExtension);
+
+    return TRUE;
+}
+
+
+static
+PIO_INTERRUPT_MESSAGE_INFO_ENTRY
+PortGetMessageInfo(
+    _In_ PFDO_DEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG MessageId)
+{
+    if (DeviceExtension->InterruptMessageTable == NULL ||
+        MessageId >= DeviceExtension->InterruptMessageTable->MessageCount)
+    {
+        return NULL;
+    }
+
+    return &DeviceExtension->InterruptMessageTable->MessageInfo[MessageId];
 }
 
 
@@ -611,10 +702,78 @@ StorPortExtendedFunction(
     _In_ PVOID HwDeviceExtension,
     ...)
 {
-    DPRINT1("StorPortExtendedFunction(%d %p ...)\n",
-            FunctionCode, HwDeviceExtension);
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+    PIO_INTERRUPT_MESSAGE_INFO_ENTRY Message;
+    PMESSAGE_INTERRUPT_INFORMATION InterruptInfo;
+    ULONG MessageId, Status;
+    PULONG OldIrql;
+    va_list Arguments;
+
+    DPRINT("StorPortExtendedFunction(%d %p ...)\n",
+           FunctionCode, HwDeviceExtension);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    va_start(Arguments, HwDeviceExtension);
+    switch (FunctionCode)
+    {
+        case ExtFunctionGetMessageInterruptInformation:
+            MessageId = va_arg(Arguments, ULONG);
+            InterruptInfo = va_arg(Arguments, PMESSAGE_INTERRUPT_INFORMATION);
+
+            Message = PortGetMessageInfo(DeviceExtension, MessageId);
+            if (Message == NULL || InterruptInfo == NULL)
+            {
+                Status = STOR_STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            InterruptInfo->MessageId = MessageId;
+            InterruptInfo->MessageData = Message->MessageData;
+            InterruptInfo->MessageAddress = Message->MessageAddress;
+            InterruptInfo->InterruptVector = Message->Vector;
+            InterruptInfo->InterruptLevel = Message->Irql;
+            InterruptInfo->InterruptMode = Message->Mode;
+            Status = STOR_STATUS_SUCCESS;
+            break;
+
+        case ExtFunctionAcquireMSISpinLock:
+            MessageId = va_arg(Arguments, ULONG);
+            OldIrql = va_arg(Arguments, PULONG);
+
+            Message = PortGetMessageInfo(DeviceExtension, MessageId);
+            if (Message == NULL || OldIrql == NULL)
+            {
+                Status = STOR_STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            *OldIrql = KeAcquireInterruptSpinLock(Message->InterruptObject);
+            Status = STOR_STATUS_SUCCESS;
+            break;
+
+        case ExtFunctionReleaseMSISpinLock:
+            MessageId = va_arg(Arguments, ULONG);
+
+            Message = PortGetMessageInfo(DeviceExtension, MessageId);
+            if (Message == NULL)
+            {
+                Status = STOR_STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            KeReleaseInterruptSpinLock(Message->InterruptObject, (KIRQL)va_arg(Arguments, ULONG));
+            Status = STOR_STATUS_SUCCESS;
+            break;
+
+        default:
+            DPRINT1("Unimplemented extended function %d\n", FunctionCode);
+            Status = STOR_STATUS_NOT_IMPLEMENTED;
+            break;
+    }
+    va_end(Arguments);
+
+    return Status;
 }
 
 
@@ -765,7 +924,7 @@ StorPortGetDeviceBase(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 PVOID
@@ -776,9 +935,16 @@ StorPortGetLogicalUnit(
     _In_ UCHAR TargetId,
     _In_ UCHAR Lun)
 {
-    DPRINT1("StorPortGetLogicalUnit()\n");
-    UNIMPLEMENTED;
-    return NULL;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT("StorPortGetLogicalUnit(%p %u %u %u)\n",
+           HwDeviceExtension, PathId, TargetId, Lun);
+
+    Unit = PortGetUnit(PortGetAdapterExtension(HwDeviceExtension), PathId, TargetId, Lun);
+    if (Unit == NULL)
+        return NULL;
+
+    return Unit->LuExtension;
 }
 
 
@@ -799,15 +965,15 @@ StorPortGetPhysicalAddress(
     STOR_PHYSICAL_ADDRESS PhysicalAddress;
     ULONG_PTR Offset;
 
-    DPRINT1("StorPortGetPhysicalAddress(%p %p %p %p)\n",
-            HwDeviceExtension, Srb, VirtualAddress, Length);
+    DPRINT("StorPortGetPhysicalAddress(%p %p %p %p)\n",
+           HwDeviceExtension, Srb, VirtualAddress, Length);
 
     /* Get the miniport extension */
     MiniportExtension = CONTAINING_RECORD(HwDeviceExtension,
                                           MINIPORT_DEVICE_EXTENSION,
                                           HwDeviceExtension);
-    DPRINT1("HwDeviceExtension %p  MiniportExtension %p\n",
-            HwDeviceExtension, MiniportExtension);
+    DPRINT("HwDeviceExtension %p  MiniportExtension %p\n",
+           HwDeviceExtension, MiniportExtension);
 
     DeviceExtension = MiniportExtension->Miniport->DeviceExtension;
 
@@ -823,6 +989,18 @@ StorPortGetPhysicalAddress(
         return PhysicalAddress;
     }
 
+    /* Inside of the SRB extensions? They are physically contiguous, too */
+    if (((ULONG_PTR)VirtualAddress >= (ULONG_PTR)DeviceExtension->SrbExtensionBase) &&
+        ((ULONG_PTR)VirtualAddress < (ULONG_PTR)DeviceExtension->SrbExtensionBase + DeviceExtension->RequestCount * DeviceExtension->SrbExtensionStride))
+    {
+        Offset = (ULONG_PTR)VirtualAddress - (ULONG_PTR)DeviceExtension->SrbExtensionBase;
+
+        PhysicalAddress.QuadPart = DeviceExtension->SrbExtensionPhysicalBase.QuadPart + Offset;
+        *Length = DeviceExtension->SrbExtensionStride - (ULONG)(Offset % DeviceExtension->SrbExtensionStride);
+
+        return PhysicalAddress;
+    }
+
     // FIXME
 
 
@@ -838,7 +1016,7 @@ StorPortGetPhysicalAddress(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 PSTOR_SCATTER_GATHER_LIST
@@ -847,9 +1025,15 @@ StorPortGetScatterGatherList(
     _In_ PVOID DeviceExtension,
     _In_ PSCSI_REQUEST_BLOCK Srb)
 {
-    DPRINT1("StorPortGetScatterGatherList()\n");
-    UNIMPLEMENTED;
-    return NULL;
+    PPORT_REQUEST Request;
+
+    DPRINT("StorPortGetScatterGatherList(%p %p)\n", DeviceExtension, Srb);
+
+    Request = PortGetSrbRequest(Srb);
+    if (Request == NULL)
+        return NULL;
+
+    return Request->SgList;
 }
 
 
@@ -866,8 +1050,30 @@ StorPortGetSrb(
     _In_ UCHAR Lun,
     _In_ LONG QueueTag)
 {
-    DPRINT("StorPortGetSrb()\n");
-    return NULL;
+    PFDO_DEVICE_EXTENSION FdoExtension;
+    PPORT_REQUEST Request;
+
+    DPRINT("StorPortGetSrb(%p %u %u %u %ld)\n",
+           DeviceExtension, PathId, TargetId, Lun, QueueTag);
+
+    FdoExtension = PortGetAdapterExtension(DeviceExtension);
+
+    /* The queue tag is the request slot */
+    if ((QueueTag < 0) || ((ULONG)QueueTag >= FdoExtension->RequestCount))
+        return NULL;
+
+    Request = &FdoExtension->Requests[QueueTag];
+    if ((Request->State != RequestActive) || (Request->Srb == NULL))
+        return NULL;
+
+    if ((Request->Srb->PathId != PathId) ||
+        (Request->Srb->TargetId != TargetId) ||
+        (Request->Srb->Lun != Lun))
+    {
+        return NULL;
+    }
+
+    return Request->Srb;
 }
 
 
@@ -1108,9 +1314,11 @@ StorPortNotification(
     PVOID LockContext;
     PSTOR_LOCK_HANDLE LockHandle;
     PSCSI_REQUEST_BLOCK Srb;
+    PVOID SystemArgument1, SystemArgument2;
+    PLONG Succ;
 
-    DPRINT1("StorPortNotification(%x %p)\n",
-            NotificationType, HwDeviceExtension);
+    DPRINT("StorPortNotification(%x %p)\n",
+           NotificationType, HwDeviceExtension);
 
     /* Get the miniport extension */
     if (HwDeviceExtension != NULL)
@@ -1118,8 +1326,8 @@ StorPortNotification(
         MiniportExtension = CONTAINING_RECORD(HwDeviceExtension,
                                               MINIPORT_DEVICE_EXTENSION,
                                               HwDeviceExtension);
-        DPRINT1("HwDeviceExtension %p  MiniportExtension %p\n",
-                HwDeviceExtension, MiniportExtension);
+        DPRINT("HwDeviceExtension %p  MiniportExtension %p\n",
+               HwDeviceExtension, MiniportExtension);
 
         DeviceExtension = MiniportExtension->Miniport->DeviceExtension;
     }
@@ -1129,14 +1337,16 @@ StorPortNotification(
     switch (NotificationType)
     {
         case RequestComplete:
-            DPRINT1("RequestComplete\n");
+            DPRINT("RequestComplete\n");
             Srb = (PSCSI_REQUEST_BLOCK)va_arg(ap, PSCSI_REQUEST_BLOCK);
-            DPRINT1("Srb %p\n", Srb);
-            if (Srb->OriginalRequest != NULL)
-            {
-                DPRINT1("Need to complete the IRP!\n");
+            DPRINT("Srb %p\n", Srb);
+            if (DeviceExtension != NULL)
+                PortRequestComplete(DeviceExtension, Srb);
+            break;
 
-            }
+        case NextRequest:
+        case NextLuRequest:
+            /* The port starts new requests as soon as slots are free */
             break;
 
         case GetExtendedFunctionTable:
@@ -1169,20 +1379,32 @@ StorPortNotification(
             HwDpcRoutine = (PHW_DPC_ROUTINE)va_arg(ap, PHW_DPC_ROUTINE);
             DPRINT1("HwDpcRoutine %p\n", HwDpcRoutine);
 
+            /* The HW DPC routine gets the STOR_DPC and the HwDeviceExtension */
             KeInitializeDpc((PRKDPC)&Dpc->Dpc,
                             (PKDEFERRED_ROUTINE)HwDpcRoutine,
-                            (PVOID)DeviceExtension);
-            KeInitializeSpinLock(&Dpc->Lock);
+                            HwDeviceExtension);
+            KeInitializeSpinLock((PKSPIN_LOCK)&Dpc->Lock);
+            break;
+
+        case IssueDpc:
+            DPRINT("IssueDpc\n");
+            Dpc = (PSTOR_DPC)va_arg(ap, PSTOR_DPC);
+            SystemArgument1 = (PVOID)va_arg(ap, PVOID);
+            SystemArgument2 = (PVOID)va_arg(ap, PVOID);
+            Succ = (PLONG)va_arg(ap, PLONG);
+            *Succ = KeInsertQueueDpc((PRKDPC)&Dpc->Dpc,
+                                     SystemArgument1,
+                                     SystemArgument2);
             break;
 
         case AcquireSpinLock:
-            DPRINT1("AcquireSpinLock\n");
+            DPRINT("AcquireSpinLock\n");
             SpinLock = (STOR_SPINLOCK)va_arg(ap, STOR_SPINLOCK);
-            DPRINT1("SpinLock %lu\n", SpinLock);
+            DPRINT("SpinLock %lu\n", SpinLock);
             LockContext = (PVOID)va_arg(ap, PVOID);
-            DPRINT1("LockContext %p\n", LockContext);
+            DPRINT("LockContext %p\n", LockContext);
             LockHandle = (PSTOR_LOCK_HANDLE)va_arg(ap, PSTOR_LOCK_HANDLE);
-            DPRINT1("LockHandle %p\n", LockHandle);
+            DPRINT("LockHandle %p\n", LockHandle);
             PortAcquireSpinLock(DeviceExtension,
                                 SpinLock,
                                 LockContext,
@@ -1190,9 +1412,9 @@ StorPortNotification(
             break;
 
         case ReleaseSpinLock:
-            DPRINT1("ReleaseSpinLock\n");
+            DPRINT("ReleaseSpinLock\n");
             LockHandle = (PSTOR_LOCK_HANDLE)va_arg(ap, PSTOR_LOCK_HANDLE);
-            DPRINT1("LockHandle %p\n", LockHandle);
+            DPRINT("LockHandle %p\n", LockHandle);
             PortReleaseSpinLock(DeviceExtension,
                                 LockHandle);
             break;
@@ -1207,7 +1429,7 @@ StorPortNotification(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1216,14 +1438,16 @@ StorPortPause(
     _In_ PVOID HwDeviceExtension,
     _In_ ULONG TimeOut)
 {
-    DPRINT1("StorPortPause()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    DPRINT("StorPortPause(%p %lu)\n", HwDeviceExtension, TimeOut);
+
+    PortHoldPause(&PortGetAdapterExtension(HwDeviceExtension)->Hold, TimeOut);
+
+    return TRUE;
 }
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1235,9 +1459,18 @@ StorPortPauseDevice(
     _In_ UCHAR Lun,
     _In_ ULONG TimeOut)
 {
-    DPRINT1("StorPortPauseDevice()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT("StorPortPauseDevice(%p %u %u %u %lu)\n",
+           HwDeviceExtension, PathId, TargetId, Lun, TimeOut);
+
+    Unit = PortGetUnit(PortGetAdapterExtension(HwDeviceExtension), PathId, TargetId, Lun);
+    if (Unit == NULL)
+        return FALSE;
+
+    PortHoldPause(&Unit->Hold, TimeOut);
+
+    return TRUE;
 }
 
 
@@ -1261,7 +1494,7 @@ StorPortQuerySystemTime(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1269,9 +1502,16 @@ NTAPI
 StorPortReady(
     _In_ PVOID HwDeviceExtension)
 {
-    DPRINT1("StorPortReady()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+
+    DPRINT("StorPortReady(%p)\n", HwDeviceExtension);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    PortHoldRelease(&DeviceExtension->Hold, FALSE);
+    PortKickQueues(DeviceExtension);
+
+    return TRUE;
 }
 
 
@@ -1316,7 +1556,7 @@ StorPortRegistryWrite(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1324,14 +1564,21 @@ NTAPI
 StorPortResume(
     _In_ PVOID HwDeviceExtension)
 {
-    DPRINT1("StorPortResume()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+
+    DPRINT("StorPortResume(%p)\n", HwDeviceExtension);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    PortHoldRelease(&DeviceExtension->Hold, TRUE);
+    PortKickQueues(DeviceExtension);
+
+    return TRUE;
 }
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1342,9 +1589,22 @@ StorPortResumeDevice(
     _In_ UCHAR TargetId,
     _In_ UCHAR Lun)
 {
-    DPRINT1("StorPortResumeDevice()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT("StorPortResumeDevice(%p %u %u %u)\n",
+           HwDeviceExtension, PathId, TargetId, Lun);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    Unit = PortGetUnit(DeviceExtension, PathId, TargetId, Lun);
+    if (Unit == NULL)
+        return FALSE;
+
+    PortHoldRelease(&Unit->Hold, TRUE);
+    PortKickQueues(DeviceExtension);
+
+    return TRUE;
 }
 
 
@@ -1390,7 +1650,7 @@ StorPortSetBusDataByOffset(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 BOOLEAN
@@ -1402,9 +1662,23 @@ StorPortSetDeviceQueueDepth(
     _In_ UCHAR Lun,
     _In_ ULONG Depth)
 {
-    DPRINT1("StorPortSetDeviceQueueDepth()\n");
-    UNIMPLEMENTED;
-    return FALSE;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+    PPDO_DEVICE_EXTENSION Unit;
+
+    DPRINT1("StorPortSetDeviceQueueDepth(%p %u %u %u %lu)\n",
+            HwDeviceExtension, PathId, TargetId, Lun, Depth);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    Unit = PortGetUnit(DeviceExtension, PathId, TargetId, Lun);
+    if ((Unit == NULL) || (Depth == 0))
+        return FALSE;
+
+    /* A unit can't have more requests outstanding than the adapter has slots */
+    Unit->QueueDepth = min(Depth, max(DeviceExtension->RequestCount, 1));
+    PortKickQueues(DeviceExtension);
+
+    return TRUE;
 }
 
 
@@ -1422,7 +1696,7 @@ StorPortStallExecution(
 
 
 /*
- * @unimplemented
+ * @implemented
  */
 STORPORT_API
 VOID
@@ -1432,8 +1706,24 @@ StorPortSynchronizeAccess(
     _In_ PSTOR_SYNCHRONIZED_ACCESS SynchronizedAccessRoutine,
     _In_opt_ PVOID Context)
 {
-    DPRINT1("StorPortSynchronizeAccess()\n");
-    UNIMPLEMENTED;
+    PFDO_DEVICE_EXTENSION DeviceExtension;
+    KIRQL OldIrql;
+
+    DPRINT("StorPortSynchronizeAccess(%p %p %p)\n",
+           HwDeviceExtension, SynchronizedAccessRoutine, Context);
+
+    DeviceExtension = PortGetAdapterExtension(HwDeviceExtension);
+
+    /* Without an interrupt there is nothing to synchronize with */
+    if (DeviceExtension->Interrupt == NULL)
+    {
+        SynchronizedAccessRoutine(HwDeviceExtension, Context);
+        return;
+    }
+
+    OldIrql = KeAcquireInterruptSpinLock(DeviceExtension->Interrupt);
+    SynchronizedAccessRoutine(HwDeviceExtension, Context);
+    KeReleaseInterruptSpinLock(DeviceExtension->Interrupt, OldIrql);
 }
 
 
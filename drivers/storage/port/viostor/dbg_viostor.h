@@ -0,0 +1,36 @@
+/*
+ * PROJECT:     ReactOS VirtIO Block SCSI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     VIOSTOR debugging declarations
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef DBG_VIOSTOR_H__
+#define DBG_VIOSTOR_H__
+
+#if DBG
+
+    #ifndef NDEBUG_VIOSTOR_IO
+        #define DPRINT_IO(fmt, ...) do { \
+            if (DbgPrint("(%s:%d) " fmt, __RELFILE__, __LINE__, ##__VA_ARGS__))  \
+                DbgPrint("(%s:%d) DbgPrint() failed!\n", __RELFILE__, __LINE__); \
+        } while (0)
+    #else
+        #if defined(_MSC_VER)
+            #define DPRINT_IO __noop
+        #else
+            #define DPRINT_IO(...) do {if(0) {DbgPrint(__VA_ARGS__);}} while(0)
+        #endif
+    #endif
+
+#else /* not DBG */
+
+    #if defined(_MSC_VER)
+        #define DPRINT_IO __noop
+    #else
+        #define DPRINT_IO(...) do {if(0) {DbgPrint(__VA_ARGS__);}} while(0)
+    #endif /* _MSC_VER */
+
+#endif /* not DBG */
+
+#endif /* DBG_VIOSTOR_H__ */
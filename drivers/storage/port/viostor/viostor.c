@@ -0,0 +1,1098 @@
+/*
+ * PROJECT:     ReactOS VirtIO Block SCSI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Main file
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "viostor.h"
+
+//#define NDEBUG
+#include <debug.h>
+
+#define NDEBUG_VIOSTOR_IO
+#include "dbg_viostor.h"
+
+static
+VOID
+VioStorCompleteRequest(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb,
+    _In_ UCHAR SrbStatus)
+{
+    DPRINT_IO("VioStorCompleteRequest: Srb %p, SrbStatus %x\n", Srb, SrbStatus);
+
+    Srb->SrbStatus |= SrbStatus;
+    ScsiPortNotification(RequestComplete, AdapterExtension, Srb);
+}
+
+/* Fails the request with a CHECK CONDITION and fixed format sense data */
+static
+VOID
+VioStorCompleteWithSense(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb,
+    _In_ UCHAR SenseKey,
+    _In_ UCHAR AdditionalSenseCode)
+{
+    PSENSE_DATA SenseData = Srb->SenseInfoBuffer;
+
+    Srb->ScsiStatus = SCSISTAT_CHECK_CONDITION;
+    Srb->SrbStatus = 0;
+
+    if ((SenseData != NULL) &&
+        (Srb->SenseInfoBufferLength >= sizeof(SENSE_DATA)) &&
+        !(Srb->SrbFlags & SRB_FLAGS_DISABLE_AUTOSENSE))
+    {
+        RtlZeroMemory(SenseData, Srb->SenseInfoBufferLength);
+        SenseData->ErrorCode = SCSI_SENSE_ERRORCODE_FIXED_CURRENT;
+        SenseData->SenseKey = SenseKey;
+        SenseData->AdditionalSenseLength = sizeof(SENSE_DATA) -
+                                           FIELD_OFFSET(SENSE_DATA, CommandSpecificInformation);
+        SenseData->AdditionalSenseCode = AdditionalSenseCode;
+
+        Srb->SenseInfoBufferLength = sizeof(SENSE_DATA);
+        Srb->SrbStatus = SRB_STATUS_AUTOSENSE_VALID;
+    }
+
+    VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_ERROR);
+}
+
+/* Copies emulated command data, trimmed to what the caller asked for */
+static
+VOID
+VioStorCompleteWithData(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb,
+    _In_ PVOID Data,
+    _In_ ULONG Length,
+    _In_ ULONG AllocationLength)
+{
+    Length = min(Length, AllocationLength);
+
+    if ((Srb->DataBuffer == NULL) || (Srb->DataTransferLength < Length))
+    {
+        Length = (Srb->DataBuffer == NULL) ? 0 : Srb->DataTransferLength;
+    }
+
+    if (Length != 0)
+        ScsiPortMoveMemory(Srb->DataBuffer, Data, Length);
+
+    Srb->DataTransferLength = Length;
+    VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+}
+
+static
+ULONGLONG
+VioStorGetBlockCount(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension)
+{
+    return AdapterExtension->Capacity / (AdapterExtension->BlockSize / VIRTIO_BLK_SECTOR_SIZE);
+}
+
+/* Decodes the LBA and block count of READ, WRITE and VERIFY commands */
+static
+BOOLEAN
+VioStorGetTransfer(
+    _In_ PCDB Cdb,
+    _Out_ PULONGLONG Lba,
+    _Out_ PULONG BlockCount)
+{
+    ULONG Value;
+
+    switch (Cdb->CDB6GENERIC.OperationCode)
+    {
+        case SCSIOP_READ6:
+        case SCSIOP_WRITE6:
+            *Lba = ((ULONG)Cdb->CDB6READWRITE.LogicalBlockMsb1 << 16) |
+                   ((ULONG)Cdb->CDB6READWRITE.LogicalBlockMsb0 << 8) |
+                   Cdb->CDB6READWRITE.LogicalBlockLsb;
+            /* Zero means 256 blocks */
+            *BlockCount = Cdb->CDB6READWRITE.TransferBlocks;
+            if (*BlockCount == 0)
+                *BlockCount = 256;
+            return TRUE;
+
+        case SCSIOP_READ:
+        case SCSIOP_WRITE:
+        case SCSIOP_VERIFY:
+            *Lba = ((ULONG)Cdb->CDB10.LogicalBlockByte0 << 24) |
+                   ((ULONG)Cdb->CDB10.LogicalBlockByte1 << 16) |
+                   ((ULONG)Cdb->CDB10.LogicalBlockByte2 << 8) |
+                   Cdb->CDB10.LogicalBlockByte3;
+            *BlockCount = ((ULONG)Cdb->CDB10.TransferBlocksMsb << 8) |
+                          Cdb->CDB10.TransferBlocksLsb;
+            return TRUE;
+
+        case SCSIOP_READ12:
+        case SCSIOP_WRITE12:
+        case SCSIOP_VERIFY12:
+            REVERSE_BYTES(&Value, Cdb->CDB12.LogicalBlock);
+            *Lba = Value;
+            REVERSE_BYTES(BlockCount, Cdb->CDB12.TransferLength);
+            return TRUE;
+
+        case SCSIOP_READ16:
+        case SCSIOP_WRITE16:
+        case SCSIOP_VERIFY16:
+            REVERSE_BYTES_QUAD(Lba, Cdb->CDB16.LogicalBlock);
+            REVERSE_BYTES(BlockCount, Cdb->CDB16.TransferLength);
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+/* SRB extensions live in the common buffer, no SRB is needed to translate them */
+static
+ULONGLONG
+VioStorGetExtensionAddress(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PVOID VirtualAddress)
+{
+    SCSI_PHYSICAL_ADDRESS PhysicalAddress;
+    ULONG Length;
+
+    PhysicalAddress = ScsiPortGetPhysicalAddress(AdapterExtension,
+                                                 NULL,
+                                                 VirtualAddress,
+                                                 &Length);
+    return PhysicalAddress.QuadPart;
+}
+
+static
+PVOID
+VioStorGetIndirectTable(
+    _In_ PVIOSTOR_SRB_EXTENSION SrbExtension)
+{
+    return ALIGN_UP_POINTER_BY(SrbExtension->IndirectTable, VIOSTOR_TABLE_ALIGNMENT);
+}
+
+/*
+ * Every request is a chain of the header, the data and the status byte.
+ * With VIRTIO_RING_F_INDIRECT_DESC the chain goes to the table in the SRB
+ * extension and takes a single ring slot, so the queue depth does not
+ * shrink with the size of the transfers.
+ */
+static
+VOID
+VioStorPrepareRequest(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb,
+    _In_ ULONG Type,
+    _In_ ULONGLONG Sector)
+{
+    PVIOSTOR_SRB_EXTENSION SrbExtension = Srb->SrbExtension;
+
+    SrbExtension->Header.Type = Type;
+    SrbExtension->Header.IoPriority = 0;
+    SrbExtension->Header.Sector = Sector;
+    SrbExtension->Status = 0xFF;
+
+    SrbExtension->Sg[0].physAddr.QuadPart = VioStorGetExtensionAddress(AdapterExtension,
+                                                                       &SrbExtension->Header);
+    SrbExtension->Sg[0].length = sizeof(VIRTIO_BLK_OUTHDR);
+}
+
+static
+VOID
+VioStorFinishRequest(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb,
+    _In_ ULONG DataCount,
+    _In_ BOOLEAN IsWrite)
+{
+    PVIOSTOR_SRB_EXTENSION SrbExtension = Srb->SrbExtension;
+    ULONG Index = 1 + DataCount;
+
+    SrbExtension->Sg[Index].physAddr.QuadPart = VioStorGetExtensionAddress(AdapterExtension,
+                                                                           &SrbExtension->Status);
+    SrbExtension->Sg[Index].length = sizeof(UCHAR);
+
+    /* The device reads the header and written data, and writes read data and the status */
+    if (IsWrite)
+    {
+        SrbExtension->OutCount = 1 + DataCount;
+        SrbExtension->InCount = 1;
+    }
+    else
+    {
+        SrbExtension->OutCount = 1;
+        SrbExtension->InCount = DataCount + 1;
+    }
+}
+
+static
+BOOLEAN
+VioStorBuildReadWrite(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PVIOSTOR_SRB_EXTENSION SrbExtension = Srb->SrbExtension;
+    PCDB Cdb = (PCDB)Srb->Cdb;
+    struct VirtIOBufferDescriptor *Segment;
+    PUCHAR DataBuffer;
+    ULONGLONG Lba, Address;
+    ULONG BlockCount, Length, Piece, Chunk, DataCount;
+    BOOLEAN IsWrite;
+    UCHAR OperationCode;
+
+    OperationCode = Cdb->CDB6GENERIC.OperationCode;
+    IsWrite = (OperationCode == SCSIOP_WRITE6) ||
+              (OperationCode == SCSIOP_WRITE) ||
+              (OperationCode == SCSIOP_WRITE12) ||
+              (OperationCode == SCSIOP_WRITE16);
+
+    VioStorGetTransfer(Cdb, &Lba, &BlockCount);
+
+    if ((Lba > VioStorGetBlockCount(AdapterExtension)) ||
+        (BlockCount > VioStorGetBlockCount(AdapterExtension) - Lba))
+    {
+        VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_ILLEGAL_BLOCK);
+        return FALSE;
+    }
+
+    if (IsWrite && AdapterExtension->ReadOnly)
+    {
+        VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_DATA_PROTECT, SCSI_ADSENSE_WRITE_PROTECT);
+        return FALSE;
+    }
+
+    Length = BlockCount * AdapterExtension->BlockSize;
+    if ((Length == 0) || (Srb->DataTransferLength == 0))
+    {
+        Srb->DataTransferLength = 0;
+        VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+        return FALSE;
+    }
+
+    if ((Srb->DataTransferLength < Length) ||
+        (Srb->DataTransferLength % AdapterExtension->BlockSize) != 0)
+    {
+        VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_INVALID_REQUEST);
+        return FALSE;
+    }
+
+    VioStorPrepareRequest(AdapterExtension,
+                          Srb,
+                          IsWrite ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN,
+                          Lba * (AdapterExtension->BlockSize / VIRTIO_BLK_SECTOR_SIZE));
+
+    /* Merge physically adjacent pages, split what exceeds the device segment size */
+    Srb->DataTransferLength = Length;
+    DataBuffer = Srb->DataBuffer;
+    DataCount = 0;
+    while (Length != 0)
+    {
+        Address = ScsiPortGetPhysicalAddress(AdapterExtension, Srb, DataBuffer, &Piece).QuadPart;
+        if (Piece == 0)
+        {
+            VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_INTERNAL_ERROR);
+            return FALSE;
+        }
+
+        Piece = min(Piece, Length);
+        DataBuffer += Piece;
+        Length -= Piece;
+
+        while (Piece != 0)
+        {
+            Segment = &SrbExtension->Sg[DataCount];
+            if ((DataCount != 0) &&
+                (Segment->physAddr.QuadPart + Segment->length == Address) &&
+                (Segment->length < AdapterExtension->SegmentSizeMax))
+            {
+                Chunk = min(Piece, AdapterExtension->SegmentSizeMax - Segment->length);
+                Segment->length += Chunk;
+            }
+            else
+            {
+                if (DataCount == AdapterExtension->SegmentsMax)
+                {
+                    DPRINT1("VioStorBuildReadWrite: Too many segments, Srb %p\n", Srb);
+                    VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_INVALID_REQUEST);
+                    return FALSE;
+                }
+
+                Chunk = min(Piece, AdapterExtension->SegmentSizeMax);
+
+                DataCount++;
+                SrbExtension->Sg[DataCount].physAddr.QuadPart = Address;
+                SrbExtension->Sg[DataCount].length = Chunk;
+            }
+
+            Address += Chunk;
+            Piece -= Chunk;
+        }
+    }
+
+    VioStorFinishRequest(AdapterExtension, Srb, DataCount, IsWrite);
+
+    DPRINT_IO("VioStorBuildReadWrite: Srb %p, Lba %I64x, BlockCount %lx, Segments %lu\n",
+              Srb,
+              Lba,
+              BlockCount,
+              DataCount);
+
+    return TRUE;
+}
+
+static
+BOOLEAN
+VioStorBuildFlush(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    /* Without VIRTIO_BLK_F_FLUSH the device writes through */
+    if (!AdapterExtension->FlushSupported)
+    {
+        VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+        return FALSE;
+    }
+
+    VioStorPrepareRequest(AdapterExtension, Srb, VIRTIO_BLK_T_FLUSH, 0);
+    VioStorFinishRequest(AdapterExtension, Srb, 0, FALSE);
+
+    return TRUE;
+}
+
+static
+VOID
+VioStorInquiry(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PCDB Cdb = (PCDB)Srb->Cdb;
+    INQUIRYDATA InquiryData;
+    UCHAR Buffer[sizeof(VPD_SUPPORTED_PAGES_PAGE) + 1];
+    PVPD_SUPPORTED_PAGES_PAGE SupportedPages;
+
+    if (Cdb->CDB6INQUIRY3.EnableVitalProductData)
+    {
+        if (Cdb->CDB6INQUIRY3.PageCode != VPD_SUPPORTED_PAGES)
+        {
+            VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_INVALID_CDB);
+            return;
+        }
+
+        RtlZeroMemory(Buffer, sizeof(Buffer));
+        SupportedPages = (PVPD_SUPPORTED_PAGES_PAGE)Buffer;
+        SupportedPages->DeviceType = DIRECT_ACCESS_DEVICE;
+        SupportedPages->PageCode = VPD_SUPPORTED_PAGES;
+        SupportedPages->PageLength = 1;
+        SupportedPages->SupportedPageList[0] = VPD_SUPPORTED_PAGES;
+
+        VioStorCompleteWithData(AdapterExtension,
+                                Srb,
+                                Buffer,
+                                sizeof(Buffer),
+                                Cdb->CDB6INQUIRY3.AllocationLength);
+        return;
+    }
+
+    if (Cdb->CDB6INQUIRY3.PageCode != 0)
+    {
+        VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_INVALID_CDB);
+        return;
+    }
+
+    RtlZeroMemory(&InquiryData, sizeof(InquiryData));
+    InquiryData.DeviceType = DIRECT_ACCESS_DEVICE;
+    InquiryData.DeviceTypeQualifier = DEVICE_CONNECTED;
+    InquiryData.Versions = 5; // SPC-3
+    InquiryData.ResponseDataFormat = 2;
+    InquiryData.AdditionalLength = INQUIRYDATABUFFERSIZE - 5;
+    InquiryData.CommandQueue = 1;
+    RtlCopyMemory(InquiryData.VendorId, "VirtIO  ", sizeof(InquiryData.VendorId));
+    RtlCopyMemory(InquiryData.ProductId, "Block Device    ", sizeof(InquiryData.ProductId));
+    RtlCopyMemory(InquiryData.ProductRevisionLevel, "1.0 ", sizeof(InquiryData.ProductRevisionLevel));
+
+    VioStorCompleteWithData(AdapterExtension,
+                            Srb,
+                            &InquiryData,
+                            INQUIRYDATABUFFERSIZE,
+                            Cdb->CDB6INQUIRY3.AllocationLength);
+}
+
+static
+VOID
+VioStorReadCapacity(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PCDB Cdb = (PCDB)Srb->Cdb;
+    READ_CAPACITY_DATA CapacityData;
+    READ_CAPACITY_DATA_EX CapacityDataEx;
+    ULONGLONG LastLba;
+    ULONG Value, AllocationLength;
+
+    /* The capacity changes when the host resizes the image */
+    virtio_get_config(&AdapterExtension->VirtIoDevice,
+                      FIELD_OFFSET(VIRTIO_BLK_CONFIG, Capacity),
+                      &AdapterExtension->Capacity,
+                      sizeof(AdapterExtension->Capacity));
+
+    LastLba = VioStorGetBlockCount(AdapterExtension) - 1;
+
+    if (Cdb->CDB6GENERIC.OperationCode == SCSIOP_READ_CAPACITY)
+    {
+        Value = (LastLba > MAXULONG) ? MAXULONG : (ULONG)LastLba;
+        REVERSE_BYTES(&CapacityData.LogicalBlockAddress, &Value);
+        REVERSE_BYTES(&CapacityData.BytesPerBlock, &AdapterExtension->BlockSize);
+
+        VioStorCompleteWithData(AdapterExtension,
+                                Srb,
+                                &CapacityData,
+                                sizeof(CapacityData),
+                                sizeof(CapacityData));
+        return;
+    }
+
+    if (Cdb->READ_CAPACITY16.ServiceAction != SERVICE_ACTION_READ_CAPACITY16)
+    {
+        VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_INVALID_CDB);
+        return;
+    }
+
+    REVERSE_BYTES_QUAD(&CapacityDataEx.LogicalBlockAddress.QuadPart, &LastLba);
+    REVERSE_BYTES(&CapacityDataEx.BytesPerBlock, &AdapterExtension->BlockSize);
+    REVERSE_BYTES(&AllocationLength, Cdb->READ_CAPACITY16.BlockCount);
+
+    VioStorCompleteWithData(AdapterExtension,
+                            Srb,
+                            &CapacityDataEx,
+                            sizeof(CapacityDataEx),
+                            AllocationLength);
+}
+
+/* Reports the write protection and the write cache through the caching page */
+static
+VOID
+VioStorModeSense(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PCDB Cdb = (PCDB)Srb->Cdb;
+    UCHAR Buffer[sizeof(MODE_PARAMETER_HEADER10) + sizeof(MODE_CACHING_PAGE)];
+    PMODE_PARAMETER_HEADER Header;
+    PMODE_PARAMETER_HEADER10 Header10;
+    PMODE_CACHING_PAGE CachingPage;
+    ULONG HeaderLength, Length, AllocationLength;
+    UCHAR PageCode, DeviceSpecificParameter;
+
+    RtlZeroMemory(Buffer, sizeof(Buffer));
+
+    if (Cdb->CDB6GENERIC.OperationCode == SCSIOP_MODE_SENSE)
+    {
+        PageCode = Cdb->MODE_SENSE.PageCode;
+        AllocationLength = Cdb->MODE_SENSE.AllocationLength;
+        HeaderLength = sizeof(MODE_PARAMETER_HEADER);
+    }
+    else
+    {
+        PageCode = Cdb->MODE_SENSE10.PageCode;
+        AllocationLength = ((ULONG)Cdb->MODE_SENSE10.AllocationLength[0] << 8) |
+                           Cdb->MODE_SENSE10.AllocationLength[1];
+        HeaderLength = sizeof(MODE_PARAMETER_HEADER10);
+    }
+
+    Length = HeaderLength;
+
+    if ((PageCode == MODE_PAGE_CACHING) || (PageCode == MODE_SENSE_RETURN_ALL))
+    {
+        CachingPage = (PMODE_CACHING_PAGE)&Buffer[HeaderLength];
+        CachingPage->PageCode = MODE_PAGE_CACHING;
+        CachingPage->PageLength = sizeof(MODE_CACHING_PAGE) - 2;
+        CachingPage->WriteCacheEnable = AdapterExtension->FlushSupported;
+        Length += sizeof(MODE_CACHING_PAGE);
+    }
+    else if (PageCode != 0)
+    {
+        VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_INVALID_CDB);
+        return;
+    }
+
+    DeviceSpecificParameter = AdapterExtension->ReadOnly ? MODE_DSP_WRITE_PROTECT : 0;
+
+    if (HeaderLength == sizeof(MODE_PARAMETER_HEADER))
+    {
+        Header = (PMODE_PARAMETER_HEADER)Buffer;
+        Header->ModeDataLength = (UCHAR)(Length - 1);
+        Header->DeviceSpecificParameter = DeviceSpecificParameter;
+    }
+    else
+    {
+        Header10 = (PMODE_PARAMETER_HEADER10)Buffer;
+        Header10->ModeDataLength[1] = (UCHAR)(Length - 2);
+        Header10->DeviceSpecificParameter = DeviceSpecificParameter;
+    }
+
+    VioStorCompleteWithData(AdapterExtension, Srb, Buffer, Length, AllocationLength);
+}
+
+static
+VOID
+VioStorRequestSense(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PCDB Cdb = (PCDB)Srb->Cdb;
+    SENSE_DATA SenseData;
+
+    /* Errors are reported through autosense, nothing is ever pending */
+    RtlZeroMemory(&SenseData, sizeof(SenseData));
+    SenseData.ErrorCode = SCSI_SENSE_ERRORCODE_FIXED_CURRENT;
+    SenseData.SenseKey = SCSI_SENSE_NO_SENSE;
+    SenseData.AdditionalSenseLength = sizeof(SENSE_DATA) -
+                                      FIELD_OFFSET(SENSE_DATA, CommandSpecificInformation);
+
+    VioStorCompleteWithData(AdapterExtension,
+                            Srb,
+                            &SenseData,
+                            sizeof(SenseData),
+                            Cdb->CDB6GENERIC.CommandUniqueBytes[2]);
+}
+
+/* Returns TRUE if the request goes to the device, FALSE if it was completed */
+static
+BOOLEAN
+VioStorExecuteScsi(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PCDB Cdb = (PCDB)Srb->Cdb;
+
+    switch (Cdb->CDB6GENERIC.OperationCode)
+    {
+        case SCSIOP_READ6:
+        case SCSIOP_READ:
+        case SCSIOP_READ12:
+        case SCSIOP_READ16:
+        case SCSIOP_WRITE6:
+        case SCSIOP_WRITE:
+        case SCSIOP_WRITE12:
+        case SCSIOP_WRITE16:
+            return VioStorBuildReadWrite(AdapterExtension, Srb);
+
+        case SCSIOP_SYNCHRONIZE_CACHE:
+        case SCSIOP_SYNCHRONIZE_CACHE16:
+            return VioStorBuildFlush(AdapterExtension, Srb);
+
+        case SCSIOP_INQUIRY:
+            VioStorInquiry(AdapterExtension, Srb);
+            return FALSE;
+
+        case SCSIOP_READ_CAPACITY:
+        case SCSIOP_READ_CAPACITY16:
+            VioStorReadCapacity(AdapterExtension, Srb);
+            return FALSE;
+
+        case SCSIOP_MODE_SENSE:
+        case SCSIOP_MODE_SENSE10:
+            VioStorModeSense(AdapterExtension, Srb);
+            return FALSE;
+
+        case SCSIOP_REQUEST_SENSE:
+            VioStorRequestSense(AdapterExtension, Srb);
+            return FALSE;
+
+        /* The backing store is always ready and verified */
+        case SCSIOP_TEST_UNIT_READY:
+        case SCSIOP_START_STOP_UNIT:
+        case SCSIOP_MEDIUM_REMOVAL:
+        case SCSIOP_RESERVE_UNIT:
+        case SCSIOP_RESERVE_UNIT10:
+        case SCSIOP_RELEASE_UNIT:
+        case SCSIOP_RELEASE_UNIT10:
+        case SCSIOP_VERIFY:
+        case SCSIOP_VERIFY12:
+        case SCSIOP_VERIFY16:
+            Srb->DataTransferLength = 0;
+            VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+            return FALSE;
+
+        default:
+            DPRINT("VioStorExecuteScsi: Unsupported operation code %x\n", Cdb->CDB6GENERIC.OperationCode);
+            VioStorCompleteWithSense(AdapterExtension, Srb, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_ADSENSE_ILLEGAL_COMMAND);
+            return FALSE;
+    }
+}
+
+/*
+ * Runs at DIRQL with the interrupt lock held. Interrupts stay off while the
+ * used ring is drained. With VIRTIO_RING_F_EVENT_IDX re-enabling them only
+ * moves the used event index, and the device raises the next interrupt once
+ * it completes past that index, however many requests finish meanwhile.
+ */
+static
+VOID
+VioStorProcessQueue(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension)
+{
+    struct virtqueue *Queue = AdapterExtension->RequestQueue;
+    PVIOSTOR_SRB_EXTENSION SrbExtension;
+    PSCSI_REQUEST_BLOCK Srb;
+    unsigned int Length;
+
+    do
+    {
+        virtqueue_disable_cb(Queue);
+
+        while ((Srb = virtqueue_get_buf(Queue, &Length)) != NULL)
+        {
+            SrbExtension = Srb->SrbExtension;
+
+            switch (SrbExtension->Status)
+            {
+                case VIRTIO_BLK_S_OK:
+                    VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+                    break;
+
+                case VIRTIO_BLK_S_UNSUPP:
+                    VioStorCompleteWithSense(AdapterExtension,
+                                             Srb,
+                                             SCSI_SENSE_ILLEGAL_REQUEST,
+                                             SCSI_ADSENSE_ILLEGAL_COMMAND);
+                    break;
+
+                default:
+                    DPRINT1("VioStorProcessQueue: Srb %p failed, Status %x\n", Srb, SrbExtension->Status);
+                    VioStorCompleteWithSense(AdapterExtension,
+                                             Srb,
+                                             SCSI_SENSE_MEDIUM_ERROR,
+                                             (SrbExtension->Header.Type == VIRTIO_BLK_T_OUT) ?
+                                                 SCSI_ADSENSE_WRITE_ERROR :
+                                                 SCSI_ADSENSE_UNRECOVERED_ERROR);
+                    break;
+            }
+        }
+    }
+    while (!virtqueue_enable_cb(Queue));
+}
+
+/**
+ * The SCSI port driver calls HwFindAdapter for every virtio-blk function
+ * it finds on the PCI bus. It maps the BARs, negotiates the features and
+ * reserves the memory for the request queue.
+ */
+ULONG
+NTAPI
+VioStorHwFindAdapter(
+    _In_ PVOID DeviceExtension,
+    _In_ PVOID HwContext,
+    _In_ PVOID BusInformation,
+    _In_ PCHAR ArgumentString,
+    _Inout_ PPORT_CONFIGURATION_INFORMATION ConfigInfo,
+    _Out_ PBOOLEAN Again)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = DeviceExtension;
+    VirtIODevice *VirtIoDevice = &AdapterExtension->VirtIoDevice;
+    PACCESS_RANGE AccessRange;
+    ULONGLONG HostFeatures, GuestFeatures;
+    ULONG Index, Length, Value;
+    unsigned long RingSize, HeapSize;
+    unsigned short QueueSize;
+    SCSI_PHYSICAL_ADDRESS PhysicalAddress;
+    NTSTATUS Status;
+    INT Bar;
+
+    UNREFERENCED_PARAMETER(HwContext);
+    UNREFERENCED_PARAMETER(BusInformation);
+    UNREFERENCED_PARAMETER(ArgumentString);
+
+    DPRINT("VioStorHwFindAdapter: AdapterExtension %p\n", AdapterExtension);
+
+    /* Keep scanning the bus for more devices */
+    *Again = TRUE;
+
+    AdapterExtension->SystemIoBusNumber = ConfigInfo->SystemIoBusNumber;
+    AdapterExtension->SlotNumber = ConfigInfo->SlotNumber;
+
+    Length = ScsiPortGetBusData(AdapterExtension,
+                                PCIConfiguration,
+                                ConfigInfo->SystemIoBusNumber,
+                                ConfigInfo->SlotNumber,
+                                AdapterExtension->PciConfig,
+                                VIOSTOR_PCI_CONFIG_SIZE);
+    if (Length != VIOSTOR_PCI_CONFIG_SIZE)
+    {
+        DPRINT1("VioStorHwFindAdapter: Failed to read the configuration space\n");
+        return SP_RETURN_NOT_FOUND;
+    }
+
+    /* The VirtIO library addresses registers by BAR, access ranges come in resource order */
+    for (Index = 0; Index < ConfigInfo->NumberOfAccessRanges; Index++)
+    {
+        AccessRange = &(*ConfigInfo->AccessRanges)[Index];
+        if (AccessRange->RangeLength == 0)
+            continue;
+
+        Bar = virtio_get_bar_index((PPCI_COMMON_HEADER)AdapterExtension->PciConfig,
+                                   AccessRange->RangeStart);
+        if (Bar < 0)
+            continue;
+
+        AdapterExtension->PciBars[Bar].BasePA = AccessRange->RangeStart;
+        AdapterExtension->PciBars[Bar].Length = AccessRange->RangeLength;
+        AdapterExtension->PciBars[Bar].IsPortSpace = !AccessRange->RangeInMemory;
+    }
+
+    /* The SCSI port driver only connects the line interrupt */
+    Status = virtio_device_initialize(VirtIoDevice,
+                                      &VioStorSystemOps,
+                                      AdapterExtension,
+                                      FALSE);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("VioStorHwFindAdapter: virtio_device_initialize() failed, Status %lx\n", Status);
+        return SP_RETURN_NOT_FOUND;
+    }
+
+    /* Features */
+    HostFeatures = virtio_get_features(VirtIoDevice);
+    GuestFeatures = 0;
+
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_F_VERSION_1))
+        virtio_feature_enable(GuestFeatures, VIRTIO_F_VERSION_1);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_RING_F_INDIRECT_DESC))
+        virtio_feature_enable(GuestFeatures, VIRTIO_RING_F_INDIRECT_DESC);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_RING_F_EVENT_IDX))
+        virtio_feature_enable(GuestFeatures, VIRTIO_RING_F_EVENT_IDX);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_BLK_F_SIZE_MAX))
+        virtio_feature_enable(GuestFeatures, VIRTIO_BLK_F_SIZE_MAX);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_BLK_F_SEG_MAX))
+        virtio_feature_enable(GuestFeatures, VIRTIO_BLK_F_SEG_MAX);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_BLK_F_RO))
+        virtio_feature_enable(GuestFeatures, VIRTIO_BLK_F_RO);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_BLK_F_BLK_SIZE))
+        virtio_feature_enable(GuestFeatures, VIRTIO_BLK_F_BLK_SIZE);
+    if (virtio_is_feature_enabled(HostFeatures, VIRTIO_BLK_F_FLUSH))
+        virtio_feature_enable(GuestFeatures, VIRTIO_BLK_F_FLUSH);
+
+    Status = virtio_set_features(VirtIoDevice, GuestFeatures);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("VioStorHwFindAdapter: Features %I64x refused, Status %lx\n", GuestFeatures, Status);
+        virtio_add_status(VirtIoDevice, VIRTIO_CONFIG_S_FAILED);
+        return SP_RETURN_ERROR;
+    }
+
+    AdapterExtension->GuestFeatures = GuestFeatures;
+    AdapterExtension->IndirectEnabled = virtio_is_feature_enabled(GuestFeatures, VIRTIO_RING_F_INDIRECT_DESC);
+    AdapterExtension->ReadOnly = virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_RO);
+    AdapterExtension->FlushSupported = virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_FLUSH);
+
+    /* Geometry */
+    virtio_get_config(VirtIoDevice,
+                      FIELD_OFFSET(VIRTIO_BLK_CONFIG, Capacity),
+                      &AdapterExtension->Capacity,
+                      sizeof(AdapterExtension->Capacity));
+
+    AdapterExtension->BlockSize = VIRTIO_BLK_SECTOR_SIZE;
+    if (AdapterExtension->ReadOnly || virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_BLK_SIZE))
+    {
+        virtio_get_config(VirtIoDevice, FIELD_OFFSET(VIRTIO_BLK_CONFIG, BlkSize), &Value, sizeof(Value));
+
+        /* Anything but a power of two sector multiple up to a page is ignored */
+        if (virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_BLK_SIZE) &&
+            (Value >= VIRTIO_BLK_SECTOR_SIZE) &&
+            (Value <= PAGE_SIZE) &&
+            ((Value & (Value - 1)) == 0))
+        {
+            AdapterExtension->BlockSize = Value;
+        }
+    }
+
+    AdapterExtension->SegmentSizeMax = MAXULONG;
+    if (virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_SIZE_MAX))
+    {
+        virtio_get_config(VirtIoDevice, FIELD_OFFSET(VIRTIO_BLK_CONFIG, SizeMax), &Value, sizeof(Value));
+        if (Value != 0)
+            AdapterExtension->SegmentSizeMax = Value;
+    }
+
+    AdapterExtension->SegmentsMax = VIOSTOR_MAX_PHYS_SEGMENTS;
+    if (virtio_is_feature_enabled(GuestFeatures, VIRTIO_BLK_F_SEG_MAX))
+    {
+        virtio_get_config(VirtIoDevice, FIELD_OFFSET(VIRTIO_BLK_CONFIG, SegMax), &Value, sizeof(Value));
+        if ((Value != 0) && (Value < AdapterExtension->SegmentsMax))
+            AdapterExtension->SegmentsMax = Value;
+    }
+
+    /* Request queue */
+    Status = virtio_query_queue_allocation(VirtIoDevice, 0, &QueueSize, &RingSize, &HeapSize);
+    if (!NT_SUCCESS(Status) || (QueueSize < 3))
+    {
+        DPRINT1("VioStorHwFindAdapter: No request queue, Status %lx\n", Status);
+        virtio_add_status(VirtIoDevice, VIRTIO_CONFIG_S_FAILED);
+        return SP_RETURN_ERROR;
+    }
+
+    /* A chain, direct or indirect, may not be longer than the queue */
+    AdapterExtension->QueueSize = QueueSize;
+    AdapterExtension->SegmentsMax = min(AdapterExtension->SegmentsMax, (ULONG)QueueSize - 2);
+
+    DPRINT1("VioStorHwFindAdapter: Capacity %I64u, BlockSize %lu, QueueSize %u, Segments %lu, Features %I64x\n",
+            AdapterExtension->Capacity,
+            AdapterExtension->BlockSize,
+            QueueSize,
+            AdapterExtension->SegmentsMax,
+            GuestFeatures);
+
+    ConfigInfo->Master = TRUE;
+    ConfigInfo->ScatterGather = TRUE;
+    ConfigInfo->Dma32BitAddresses = TRUE;
+    ConfigInfo->AlignmentMask = 0;
+    ConfigInfo->CachesData = AdapterExtension->FlushSupported;
+    ConfigInfo->WmiDataProvider = FALSE;
+    ConfigInfo->NumberOfBuses = 1;
+    ConfigInfo->MaximumNumberOfTargets = 1;
+    ConfigInfo->MaximumNumberOfLogicalUnits = 1;
+    ConfigInfo->NumberOfPhysicalBreaks = AdapterExtension->SegmentsMax - 1;
+    ConfigInfo->MaximumTransferLength = min((AdapterExtension->SegmentsMax - 1) * PAGE_SIZE,
+                                            VIOSTOR_MAX_TRANSFER_LENGTH);
+
+    /*
+     * The ring must be page aligned for legacy devices, the control block
+     * follows it. The uncached extension ends the common buffer, so it only
+     * starts on a page boundary if its size is a multiple of the page size.
+     */
+    AdapterExtension->RingSize = ROUND_TO_PAGES(RingSize);
+    AdapterExtension->PoolSize = ROUND_TO_PAGES(HeapSize);
+    AdapterExtension->UncachedSize = AdapterExtension->RingSize + AdapterExtension->PoolSize;
+
+    AdapterExtension->UncachedVA = ScsiPortGetUncachedExtension(AdapterExtension,
+                                                                ConfigInfo,
+                                                                AdapterExtension->UncachedSize);
+    if (AdapterExtension->UncachedVA == NULL)
+    {
+        DPRINT1("VioStorHwFindAdapter: No uncached extension\n");
+        virtio_add_status(VirtIoDevice, VIRTIO_CONFIG_S_FAILED);
+        return SP_RETURN_ERROR;
+    }
+
+    PhysicalAddress = ScsiPortGetPhysicalAddress(AdapterExtension,
+                                                 NULL,
+                                                 AdapterExtension->UncachedVA,
+                                                 &Length);
+    AdapterExtension->UncachedPA = PhysicalAddress;
+    AdapterExtension->RingVA = AdapterExtension->UncachedVA;
+    AdapterExtension->PoolVA = AdapterExtension->UncachedVA + AdapterExtension->RingSize;
+
+    return SP_RETURN_FOUND;
+}
+
+/* Called after the interrupt is connected, the device may start raising it */
+BOOLEAN
+NTAPI
+VioStorHwInitialize(
+    _In_ PVOID DeviceExtension)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = DeviceExtension;
+    NTSTATUS Status;
+
+    DPRINT("VioStorHwInitialize: AdapterExtension %p\n", AdapterExtension);
+
+    AdapterExtension->RingAllocated = FALSE;
+    AdapterExtension->PoolOffset = 0;
+
+    Status = virtio_find_queues(&AdapterExtension->VirtIoDevice,
+                                1,
+                                &AdapterExtension->RequestQueue);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("VioStorHwInitialize: virtio_find_queues() failed, Status %lx\n", Status);
+        AdapterExtension->RequestQueue = NULL;
+        virtio_add_status(&AdapterExtension->VirtIoDevice, VIRTIO_CONFIG_S_FAILED);
+        return FALSE;
+    }
+
+    virtio_device_ready(&AdapterExtension->VirtIoDevice);
+
+    return TRUE;
+}
+
+/* Returns TRUE if the request goes to the device, FALSE if it was completed */
+static
+BOOLEAN
+VioStorBuildRequest(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    if ((Srb->PathId != 0) || (Srb->TargetId != 0) || (Srb->Lun != 0))
+    {
+        VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_NO_DEVICE);
+        return FALSE;
+    }
+
+    switch (Srb->Function)
+    {
+        case SRB_FUNCTION_EXECUTE_SCSI:
+            return VioStorExecuteScsi(AdapterExtension, Srb);
+
+        case SRB_FUNCTION_FLUSH:
+        case SRB_FUNCTION_SHUTDOWN:
+            return VioStorBuildFlush(AdapterExtension, Srb);
+
+        /* Requests cannot be aborted, the device completes them all */
+        case SRB_FUNCTION_RESET_BUS:
+        case SRB_FUNCTION_RESET_DEVICE:
+        case SRB_FUNCTION_RESET_LOGICAL_UNIT:
+            VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_SUCCESS);
+            return FALSE;
+
+        default:
+            VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_INVALID_REQUEST);
+            return FALSE;
+    }
+}
+
+/**
+ * The SCSI port driver calls HwStartIo synchronized with the interrupt.
+ * Emulated commands complete right away, reads, writes and flushes get
+ * their chain built in the SRB extension and added to the ring. The device
+ * is only notified if the event index says it is not still busy with
+ * earlier requests.
+ */
+BOOLEAN
+NTAPI
+VioStorHwStartIo(
+    _In_ PVOID DeviceExtension,
+    _In_ PSCSI_REQUEST_BLOCK Srb)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = DeviceExtension;
+    PVIOSTOR_SRB_EXTENSION SrbExtension = Srb->SrbExtension;
+    PVOID IndirectTable = NULL;
+    ULONGLONG IndirectTablePA = 0;
+    int Result;
+
+    if (AdapterExtension->RequestQueue == NULL)
+    {
+        VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_NO_HBA);
+    }
+    else if (VioStorBuildRequest(AdapterExtension, Srb))
+    {
+        if (AdapterExtension->IndirectEnabled)
+        {
+            IndirectTable = VioStorGetIndirectTable(SrbExtension);
+            IndirectTablePA = VioStorGetExtensionAddress(AdapterExtension, IndirectTable);
+        }
+
+        Result = virtqueue_add_buf(AdapterExtension->RequestQueue,
+                                   SrbExtension->Sg,
+                                   SrbExtension->OutCount,
+                                   SrbExtension->InCount,
+                                   Srb,
+                                   IndirectTable,
+                                   IndirectTablePA);
+        if (Result != 0)
+        {
+            /* The ring is full, the port driver retries the request later */
+            DPRINT_IO("VioStorHwStartIo: Ring full, Srb %p\n", Srb);
+            VioStorCompleteRequest(AdapterExtension, Srb, SRB_STATUS_BUSY);
+        }
+        else if (virtqueue_kick_prepare(AdapterExtension->RequestQueue))
+        {
+            virtqueue_notify(AdapterExtension->RequestQueue);
+        }
+    }
+
+    /* The device queues requests itself, accept the next one right away */
+    ScsiPortNotification(NextLuRequest, AdapterExtension, Srb->PathId, Srb->TargetId, Srb->Lun);
+
+    return TRUE;
+}
+
+BOOLEAN
+NTAPI
+VioStorHwInterrupt(
+    _In_ PVOID DeviceExtension)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = DeviceExtension;
+    UCHAR IsrStatus;
+
+    if (AdapterExtension->RequestQueue == NULL)
+        return FALSE;
+
+    /* Reading the ISR acknowledges the line interrupt */
+    IsrStatus = virtio_read_isr_status(&AdapterExtension->VirtIoDevice);
+    if (IsrStatus == 0)
+        return FALSE;
+
+    VioStorProcessQueue(AdapterExtension);
+
+    return TRUE;
+}
+
+BOOLEAN
+NTAPI
+VioStorHwResetBus(
+    _In_ PVOID DeviceExtension,
+    _In_ ULONG PathId)
+{
+    UNREFERENCED_PARAMETER(DeviceExtension);
+    UNREFERENCED_PARAMETER(PathId);
+
+    /* Nothing to reset, outstanding requests still complete normally */
+    return TRUE;
+}
+
+ULONG
+NTAPI
+DriverEntry(
+    _In_ PVOID DriverObject,
+    _In_ PVOID RegistryPath)
+{
+    HW_INITIALIZATION_DATA HwInitializationData;
+    ULONG Status, Status2;
+
+    DPRINT("DriverEntry: DriverObject %p, RegistryPath %p\n", DriverObject, RegistryPath);
+
+    RtlZeroMemory(&HwInitializationData, sizeof(HwInitializationData));
+
+    HwInitializationData.HwInitializationDataSize = sizeof(HW_INITIALIZATION_DATA);
+
+    HwInitializationData.HwFindAdapter = VioStorHwFindAdapter;
+    HwInitializationData.HwInitialize = VioStorHwInitialize;
+    HwInitializationData.HwStartIo = VioStorHwStartIo;
+    HwInitializationData.HwInterrupt = VioStorHwInterrupt;
+    HwInitializationData.HwResetBus = VioStorHwResetBus;
+
+    HwInitializationData.AdapterInterfaceType = PCIBus;
+    HwInitializationData.NumberOfAccessRanges = PCI_TYPE0_ADDRESSES;
+    HwInitializationData.MapBuffers = TRUE;
+
+    HwInitializationData.TaggedQueuing = TRUE;
+    HwInitializationData.AutoRequestSense = TRUE;
+    HwInitializationData.MultipleRequestPerLu = TRUE;
+    HwInitializationData.NeedPhysicalAddresses = TRUE;
+
+    HwInitializationData.DeviceExtensionSize = sizeof(VIOSTOR_ADAPTER_EXTENSION);
+    HwInitializationData.SrbExtensionSize = sizeof(VIOSTOR_SRB_EXTENSION);
+
+    HwInitializationData.VendorId = "1AF4";
+    HwInitializationData.VendorIdLength = 4;
+    HwInitializationData.DeviceIdLength = 4;
+
+    /* Transitional device */
+    HwInitializationData.DeviceId = "1001";
+    Status = ScsiPortInitialize(DriverObject,
+                                RegistryPath,
+                                &HwInitializationData,
+                                NULL);
+
+    DPRINT("DriverEntry: ScsiPortInitialize() returned %lx\n", Status);
+
+    /* VirtIO 1.0 device */
+    HwInitializationData.DeviceId = "1042";
+    Status2 = ScsiPortInitialize(DriverObject,
+                                 RegistryPath,
+                                 &HwInitializationData,
+                                 NULL);
+
+    DPRINT("DriverEntry: ScsiPortInitialize() returned %lx\n", Status2);
+
+    /* Succeed if either kind of device was found */
+    return min(Status, Status2);
+}
@@ -0,0 +1,143 @@
+/*
+ * PROJECT:     ReactOS VirtIO Block SCSI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     VIOSTOR declarations
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef VIOSTOR_H__
+#define VIOSTOR_H__
+
+#include <ntddk.h>
+#include <srb.h>
+#include <scsi.h>
+
+#include "osdep.h"
+#include "virtio_pci.h"
+#include "VirtIO.h"
+
+/* Device features, see the VirtIO 1.0 specification, section 5.2.3 */
+#define VIRTIO_BLK_F_SIZE_MAX     1
+#define VIRTIO_BLK_F_SEG_MAX      2
+#define VIRTIO_BLK_F_GEOMETRY     4
+#define VIRTIO_BLK_F_RO           5
+#define VIRTIO_BLK_F_BLK_SIZE     6
+#define VIRTIO_BLK_F_FLUSH        9
+#define VIRTIO_BLK_F_TOPOLOGY     10
+
+/* Request types */
+#define VIRTIO_BLK_T_IN           0
+#define VIRTIO_BLK_T_OUT          1
+#define VIRTIO_BLK_T_FLUSH        4
+
+/* Request status */
+#define VIRTIO_BLK_S_OK           0
+#define VIRTIO_BLK_S_IOERR        1
+#define VIRTIO_BLK_S_UNSUPP       2
+
+/* The device always counts in 512 byte sectors, whatever the logical block size */
+#define VIRTIO_BLK_SECTOR_SHIFT   9
+#define VIRTIO_BLK_SECTOR_SIZE    (1 << VIRTIO_BLK_SECTOR_SHIFT)
+
+/* Missing from scsi.h */
+#define SERVICE_ACTION_READ_CAPACITY16      0x10
+#define SCSI_ADSENSE_UNRECOVERED_ERROR      0x11
+#define SCSI_SENSE_ERRORCODE_FIXED_CURRENT  0x70
+
+#include <pshpack1.h>
+typedef struct _VIRTIO_BLK_GEOMETRY {
+  USHORT Cylinders;
+  UCHAR Heads;
+  UCHAR Sectors;
+} VIRTIO_BLK_GEOMETRY;
+
+typedef struct _VIRTIO_BLK_CONFIG {
+  ULONGLONG Capacity; // In 512 byte sectors
+  ULONG SizeMax;
+  ULONG SegMax;
+  VIRTIO_BLK_GEOMETRY Geometry;
+  ULONG BlkSize;
+  UCHAR PhysicalBlockExp;
+  UCHAR AlignmentOffset;
+  USHORT MinIoSize;
+  ULONG OptIoSize;
+} VIRTIO_BLK_CONFIG, *PVIRTIO_BLK_CONFIG;
+#include <poppack.h>
+
+/* Header of every request, read by the device */
+typedef struct _VIRTIO_BLK_OUTHDR {
+  ULONG Type;
+  ULONG IoPriority;
+  ULONGLONG Sector;
+} VIRTIO_BLK_OUTHDR, *PVIRTIO_BLK_OUTHDR;
+
+/* A transfer of this many pages may start in the middle of a page */
+#define VIOSTOR_MAX_TRANSFER_PAGES    64
+#define VIOSTOR_MAX_PHYS_SEGMENTS     (VIOSTOR_MAX_TRANSFER_PAGES + 1)
+#define VIOSTOR_MAX_TRANSFER_LENGTH   (VIOSTOR_MAX_TRANSFER_PAGES * PAGE_SIZE)
+
+/* The header, the data segments and the status byte */
+#define VIOSTOR_MAX_DESCRIPTORS       (VIOSTOR_MAX_PHYS_SEGMENTS + 2)
+
+/* Size of a split ring descriptor (struct vring_desc) */
+#define VIRTIO_RING_DESC_SIZE         16
+
+#define VIOSTOR_PCI_CONFIG_SIZE       256
+
+typedef struct _VIOSTOR_PCI_BAR {
+  PHYSICAL_ADDRESS BasePA;
+  ULONG Length;
+  PVOID BaseVA;
+  BOOLEAN IsPortSpace;
+} VIOSTOR_PCI_BAR, *PVIOSTOR_PCI_BAR;
+
+#define VIOSTOR_TABLE_ALIGNMENT       16
+
+/* The descriptor chain of a request, built by HwStartIo */
+typedef struct _VIOSTOR_SRB_EXTENSION {
+  /* Scsiport only aligns SRB extensions to 8 bytes, the indirect
+   * descriptor table starts at the next 16 byte boundary in here */
+  UCHAR IndirectTable[(VIOSTOR_MAX_DESCRIPTORS * VIRTIO_RING_DESC_SIZE) + VIOSTOR_TABLE_ALIGNMENT];
+  VIRTIO_BLK_OUTHDR Header;
+  UCHAR Status;
+  UCHAR Padded[3];
+  ULONG OutCount;
+  ULONG InCount;
+  struct VirtIOBufferDescriptor Sg[VIOSTOR_MAX_DESCRIPTORS];
+} VIOSTOR_SRB_EXTENSION, *PVIOSTOR_SRB_EXTENSION;
+
+typedef struct _VIOSTOR_ADAPTER_EXTENSION {
+  VirtIODevice VirtIoDevice;
+  struct virtqueue * RequestQueue;
+  ULONG SystemIoBusNumber;
+  ULONG SlotNumber;
+  UCHAR PciConfig[VIOSTOR_PCI_CONFIG_SIZE];
+  VIOSTOR_PCI_BAR PciBars[PCI_TYPE0_ADDRESSES];
+  BOOLEAN IndirectEnabled;
+  BOOLEAN ReadOnly;
+  BOOLEAN FlushSupported;
+  ULONGLONG GuestFeatures;
+  /* Geometry */
+  ULONGLONG Capacity; // In 512 byte sectors
+  ULONG BlockSize;
+  ULONG SegmentSizeMax;
+  ULONG SegmentsMax;
+  /* Ring and control block memory, carved from the uncached extension */
+  PUCHAR RingVA;
+  ULONG RingSize;
+  BOOLEAN RingAllocated;
+  UCHAR Padded[3];
+  PUCHAR PoolVA;
+  ULONG PoolSize;
+  ULONG PoolOffset;
+  PHYSICAL_ADDRESS UncachedPA;
+  PUCHAR UncachedVA;
+  ULONG UncachedSize;
+  USHORT QueueSize;
+  USHORT Padded2;
+} VIOSTOR_ADAPTER_EXTENSION, *PVIOSTOR_ADAPTER_EXTENSION;
+
+/* virtio.c */
+extern VirtIOSystemOps VioStorSystemOps;
+
+#endif /* VIOSTOR_H__ */
@@ -0,0 +1,340 @@
+/*
+ * PROJECT:     ReactOS VirtIO Block SCSI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     SCSI port glue for the shared VirtIO library
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "viostor.h"
+#include "kdebugprint.h"
+
+//#define NDEBUG
+#include <debug.h>
+
+/* Used by the VirtIO library for its DPrintf */
+int virtioDebugLevel = 0;
+int bDebugPrint = 1;
+
+static
+VOID
+VioStorDebugPrint(
+    _In_ const char *Format,
+    ...)
+{
+    va_list Arguments;
+
+    va_start(Arguments, Format);
+    vDbgPrintEx(DPFLTR_IHVDRIVER_ID, DPFLTR_ERROR_LEVEL, Format, Arguments);
+    va_end(Arguments);
+}
+
+tDebugPrintFunc VirtioDebugPrintProc = VioStorDebugPrint;
+
+/*
+ * The lower 64k of memory is never mapped, so the address alone tells
+ * port I/O from memory mapped registers. The SCSI port driver maps I/O
+ * space BARs to their port numbers.
+ */
+#define PORT_MASK 0xFFFF
+
+static
+u8
+VioStorReadByte(
+    _In_ ULONG_PTR Register)
+{
+    if (Register & ~PORT_MASK)
+        return ScsiPortReadRegisterUchar((PUCHAR)Register);
+    else
+        return ScsiPortReadPortUchar((PUCHAR)Register);
+}
+
+static
+u16
+VioStorReadWord(
+    _In_ ULONG_PTR Register)
+{
+    if (Register & ~PORT_MASK)
+        return ScsiPortReadRegisterUshort((PUSHORT)Register);
+    else
+        return ScsiPortReadPortUshort((PUSHORT)Register);
+}
+
+static
+u32
+VioStorReadDword(
+    _In_ ULONG_PTR Register)
+{
+    if (Register & ~PORT_MASK)
+        return ScsiPortReadRegisterUlong((PULONG)Register);
+    else
+        return ScsiPortReadPortUlong((PULONG)Register);
+}
+
+static
+void
+VioStorWriteByte(
+    _In_ ULONG_PTR Register,
+    _In_ u8 Value)
+{
+    if (Register & ~PORT_MASK)
+        ScsiPortWriteRegisterUchar((PUCHAR)Register, Value);
+    else
+        ScsiPortWritePortUchar((PUCHAR)Register, Value);
+}
+
+static
+void
+VioStorWriteWord(
+    _In_ ULONG_PTR Register,
+    _In_ u16 Value)
+{
+    if (Register & ~PORT_MASK)
+        ScsiPortWriteRegisterUshort((PUSHORT)Register, Value);
+    else
+        ScsiPortWritePortUshort((PUSHORT)Register, Value);
+}
+
+static
+void
+VioStorWriteDword(
+    _In_ ULONG_PTR Register,
+    _In_ u32 Value)
+{
+    if (Register & ~PORT_MASK)
+        ScsiPortWriteRegisterUlong((PULONG)Register, Value);
+    else
+        ScsiPortWritePortUlong((PULONG)Register, Value);
+}
+
+/*
+ * The ring is the only contiguous allocation the library makes for our
+ * single queue. It lives at the start of the uncached extension, which
+ * HwFindAdapter sized from virtio_query_queue_allocation.
+ */
+static
+void *
+VioStorAllocContiguousPages(
+    _In_ void *Context,
+    _In_ size_t Size)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+
+    if (AdapterExtension->RingAllocated || (Size > AdapterExtension->RingSize))
+    {
+        DPRINT1("VioStorAllocContiguousPages: No room for %Iu bytes\n", Size);
+        return NULL;
+    }
+
+    AdapterExtension->RingAllocated = TRUE;
+    RtlZeroMemory(AdapterExtension->RingVA, Size);
+
+    return AdapterExtension->RingVA;
+}
+
+static
+void
+VioStorFreeContiguousPages(
+    _In_ void *Context,
+    _In_ void *Address)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+
+    if (Address == AdapterExtension->RingVA)
+        AdapterExtension->RingAllocated = FALSE;
+}
+
+static
+ULONGLONG
+VioStorGetPhysicalAddress(
+    _In_ void *Context,
+    _In_ void *Address)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+    ULONG_PTR Offset;
+
+    Offset = (ULONG_PTR)Address - (ULONG_PTR)AdapterExtension->UncachedVA;
+    ASSERT(Offset < AdapterExtension->UncachedSize);
+
+    return AdapterExtension->UncachedPA.QuadPart + Offset;
+}
+
+/*
+ * Control blocks are never freed while the adapter runs. They come from
+ * the uncached extension as well, so setting up the queue works at any IRQL.
+ */
+static
+void *
+VioStorAllocNonpagedBlock(
+    _In_ void *Context,
+    _In_ size_t Size)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+    PVOID Block;
+
+    Size = ALIGN_UP_BY(Size, sizeof(ULONGLONG));
+    if (Size > AdapterExtension->PoolSize - AdapterExtension->PoolOffset)
+    {
+        DPRINT1("VioStorAllocNonpagedBlock: No room for %Iu bytes\n", Size);
+        return NULL;
+    }
+
+    Block = AdapterExtension->PoolVA + AdapterExtension->PoolOffset;
+    AdapterExtension->PoolOffset += (ULONG)Size;
+    RtlZeroMemory(Block, Size);
+
+    return Block;
+}
+
+static
+void
+VioStorFreeNonpagedBlock(
+    _In_ void *Context,
+    _In_ void *Address)
+{
+    UNREFERENCED_PARAMETER(Context);
+    UNREFERENCED_PARAMETER(Address);
+}
+
+/* The configuration space was read once by HwFindAdapter */
+static
+int
+VioStorReadConfig(
+    _In_ PVIOSTOR_ADAPTER_EXTENSION AdapterExtension,
+    _In_ int Offset,
+    _Out_ void *Buffer,
+    _In_ size_t Length)
+{
+    if ((Offset < 0) || ((size_t)Offset + Length > VIOSTOR_PCI_CONFIG_SIZE))
+        return -1;
+
+    RtlCopyMemory(Buffer, &AdapterExtension->PciConfig[Offset], Length);
+    return 0;
+}
+
+static
+int
+VioStorReadConfigByte(
+    _In_ void *Context,
+    _In_ int Offset,
+    _Out_ u8 *Value)
+{
+    return VioStorReadConfig(Context, Offset, Value, sizeof(*Value));
+}
+
+static
+int
+VioStorReadConfigWord(
+    _In_ void *Context,
+    _In_ int Offset,
+    _Out_ u16 *Value)
+{
+    return VioStorReadConfig(Context, Offset, Value, sizeof(*Value));
+}
+
+static
+int
+VioStorReadConfigDword(
+    _In_ void *Context,
+    _In_ int Offset,
+    _Out_ u32 *Value)
+{
+    return VioStorReadConfig(Context, Offset, Value, sizeof(*Value));
+}
+
+static
+size_t
+VioStorGetResourceLength(
+    _In_ void *Context,
+    _In_ int Bar)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+
+    if ((Bar < 0) || (Bar >= PCI_TYPE0_ADDRESSES))
+        return 0;
+
+    return AdapterExtension->PciBars[Bar].Length;
+}
+
+/* Only called from HwFindAdapter, the one place ScsiPortGetDeviceBase may be used */
+static
+void *
+VioStorMapAddressRange(
+    _In_ void *Context,
+    _In_ int Bar,
+    _In_ size_t Offset,
+    _In_ size_t MaxLength)
+{
+    PVIOSTOR_ADAPTER_EXTENSION AdapterExtension = Context;
+    PVIOSTOR_PCI_BAR PciBar;
+
+    UNREFERENCED_PARAMETER(MaxLength);
+
+    if ((Bar < 0) || (Bar >= PCI_TYPE0_ADDRESSES))
+        return NULL;
+
+    PciBar = &AdapterExtension->PciBars[Bar];
+    if ((PciBar->Length == 0) || (Offset >= PciBar->Length))
+        return NULL;
+
+    if (PciBar->BaseVA == NULL)
+    {
+        PciBar->BaseVA = ScsiPortGetDeviceBase(AdapterExtension,
+                                               PCIBus,
+                                               AdapterExtension->SystemIoBusNumber,
+                                               PciBar->BasePA,
+                                               PciBar->Length,
+                                               PciBar->IsPortSpace);
+        if (PciBar->BaseVA == NULL)
+        {
+            DPRINT1("VioStorMapAddressRange: Failed to map BAR %d\n", Bar);
+            return NULL;
+        }
+    }
+
+    return (PUCHAR)PciBar->BaseVA + Offset;
+}
+
+/* The SCSI port driver only connects the line interrupt */
+static
+u16
+VioStorGetMsixVector(
+    _In_ void *Context,
+    _In_ int Queue)
+{
+    UNREFERENCED_PARAMETER(Context);
+    UNREFERENCED_PARAMETER(Queue);
+
+    return VIRTIO_MSI_NO_VECTOR;
+}
+
+static
+void
+VioStorSleep(
+    _In_ void *Context,
+    _In_ unsigned int Milliseconds)
+{
+    UNREFERENCED_PARAMETER(Context);
+
+    ScsiPortStallExecution(Milliseconds * 1000);
+}
+
+VirtIOSystemOps VioStorSystemOps = {
+    VioStorReadByte,
+    VioStorReadWord,
+    VioStorReadDword,
+    VioStorWriteByte,
+    VioStorWriteWord,
+    VioStorWriteDword,
+    VioStorAllocContiguousPages,
+    VioStorFreeContiguousPages,
+    VioStorGetPhysicalAddress,
+    VioStorAllocNonpagedBlock,
+    VioStorFreeNonpagedBlock,
+    VioStorReadConfigByte,
+    VioStorReadConfigWord,
+    VioStorReadConfigDword,
+    VioStorGetResourceLength,
+    VioStorMapAddressRange,
+    VioStorGetMsixVector,
+    VioStorSleep,
+};
@@ -378,6 +378,12 @@ USBD_Initialize20Hub(IN PUSBHUB_FDO_EXTENSION HubExtension)
         TtCount = HubExtension->HubDescriptor->bNumberOfPorts;
     }
 
+    /* SuperSpeed hubs have no transaction translators */
+    if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB)
+    {
+        TtCount = 0;
+    }
+
     DeviceHandle = USBH_SyncGetDeviceHandle(HubExtension->LowerDevice);
 
     return Initialize20Hub(HubExtension->BusInterface.BusContext,
@@ -385,6 +391,35 @@ USBD_Initialize20Hub(IN PUSBHUB_FDO_EXTENSION HubExtension)
                            TtCount);
 }
 
+NTSTATUS
+NTAPI
+USBH_SyncSetHubDepth(IN PUSBHUB_FDO_EXTENSION HubExtension,
+                     IN ULONG HubCount)
+{
+    BM_REQUEST_TYPE RequestType;
+    USHORT HubDepth;
+
+    /* The root hub and the hub itself are both counted, the first tier is 0 */
+    HubDepth = (HubCount >= 2) ? (USHORT)(HubCount - 2) : 0;
+
+    DPRINT("USBH_SyncSetHubDepth: HubDepth - %x\n", HubDepth);
+
+    RequestType.B = 0;
+    RequestType.Recipient = BMREQUEST_TO_DEVICE;
+    RequestType.Type = BMREQUEST_CLASS;
+    RequestType.Dir = BMREQUEST_HOST_TO_DEVICE;
+
+    return USBH_Transact(HubExtension,
+                         NULL,
+                         0,
+                         BMREQUEST_HOST_TO_DEVICE,
+                         URB_FUNCTION_CLASS_DEVICE,
+                         RequestType,
+                         USB_REQUEST_SET_HUB_DEPTH,
+                         HubDepth,
+                         0);
+}
+
 NTSTATUS
 NTAPI
 USBH_AbortInterruptPipe(IN PUSBHUB_FDO_EXTENSION HubExtension)
@@ -828,6 +863,13 @@ USBH_StartHubFdoDevice(IN PUSBHUB_FDO_EXTENSION HubExtension,
         goto ErrorExit;
     }
 
+    if (HubExtension->HubDeviceDescriptor.bDeviceProtocol == USBHUB_SUPER_SPEED_HUB_PROTOCOL &&
+        HubExtension->LowerPDO != HubExtension->RootHubPdo)
+    {
+        DPRINT("USBH_StartHubFdoDevice: SuperSpeed hub\n");
+        HubExtension->HubFlags |= USBHUB_FDO_FLAG_USB30_HUB;
+    }
+
     Status = USBH_GetConfigurationDescriptor(HubExtension->Common.SelfDevice,
                                              &HubExtension->HubConfigDescriptor);
 
@@ -874,6 +916,19 @@ USBH_StartHubFdoDevice(IN PUSBHUB_FDO_EXTENSION HubExtension,
         goto ErrorExit;
     }
 
+    if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB)
+    {
+        /* Route strings sent to the hub depend on its tier */
+        Status = USBH_SyncSetHubDepth(HubExtension, HubCount);
+
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("USBH_StartHubFdoDevice: USBH_SyncSetHubDepth() failed - %lX\n",
+                    Status);
+            goto ErrorExit;
+        }
+    }
+
     if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB20_HUB)
     {
         Status = USBD_Initialize20Hub(HubExtension);
@@ -1096,6 +1096,12 @@ USBH_SyncGetHubDescriptor(IN PUSBHUB_FDO_EXTENSION HubExtension)
     RequestValue = 0;
     Retry = 0;
 
+    if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB)
+    {
+        /* The SuperSpeed hub descriptor matches the USB2 one up to bHubControlCurrent */
+        RequestValue = USB_30_HUB_DESCRIPTOR_TYPE << 8;
+    }
+
     while (TRUE)
     {
         while (Retry <= 5)
@@ -1122,7 +1128,10 @@ USBH_SyncGetHubDescriptor(IN PUSBHUB_FDO_EXTENSION HubExtension)
                 break;
             }
 
-            RequestValue = 0x2900; // Hub DescriptorType - 0x29
+            if (!(HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB))
+            {
+                RequestValue = 0x2900; // Hub DescriptorType - 0x29
+            }
 
             Retry++;
         }
@@ -1409,6 +1418,42 @@ USBH_SyncClearHubStatus(IN PUSBHUB_FDO_EXTENSION HubExtension,
                          0);
 }
 
+VOID
+NTAPI
+USBH_ConvertSsPortStatus(IN PUSBHUB_FDO_EXTENSION HubExtension,
+                         IN OUT PUSB_PORT_STATUS_AND_CHANGE PortStatus)
+{
+    USB_30_PORT_STATUS Usb30PortStatus;
+    USB_20_PORT_STATUS Usb20PortStatus;
+
+    if (!(HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB))
+    {
+        return;
+    }
+
+    /*
+     * The rest of the driver works with the USB2 layout. The change bits
+     * the two layouts share sit at the same positions, the SuperSpeed only
+     * ones (BH reset, link state, config error) stay where they are.
+     */
+    Usb30PortStatus = PortStatus->PortStatus.Usb30PortStatus;
+
+    Usb20PortStatus.AsUshort16 = 0;
+    Usb20PortStatus.CurrentConnectStatus = Usb30PortStatus.CurrentConnectStatus;
+    Usb20PortStatus.PortEnabledDisabled = Usb30PortStatus.PortEnabledDisabled;
+    Usb20PortStatus.Suspend = (Usb30PortStatus.PortLinkState == PORT_LINK_STATE_U3);
+    Usb20PortStatus.OverCurrent = Usb30PortStatus.OverCurrent;
+    Usb20PortStatus.Reset = Usb30PortStatus.Reset;
+    Usb20PortStatus.PortPower = Usb30PortStatus.PortPower;
+    Usb20PortStatus.Reserved1 = USB20_PORT_STATUS_RESERVED1_SUPER_SPEED;
+
+    DPRINT("USBH_ConvertSsPortStatus: %X -> %X\n",
+           Usb30PortStatus.AsUshort16,
+           Usb20PortStatus.AsUshort16);
+
+    PortStatus->PortStatus.Usb20PortStatus = Usb20PortStatus;
+}
+
 NTSTATUS
 NTAPI
 USBH_SyncGetPortStatus(IN PUSBHUB_FDO_EXTENSION HubExtension,
@@ -1417,6 +1462,7 @@ USBH_SyncGetPortStatus(IN PUSBHUB_FDO_EXTENSION HubExtension,
                        IN ULONG Length)
 {
     BM_REQUEST_TYPE RequestType;
+    NTSTATUS Status;
 
     DPRINT("USBH_SyncGetPortStatus: Port - %x\n", Port);
 
@@ -1425,15 +1471,22 @@ USBH_SyncGetPortStatus(IN PUSBHUB_FDO_EXTENSION HubExtension,
     RequestType.Type = BMREQUEST_CLASS;
     RequestType.Dir = BMREQUEST_DEVICE_TO_HOST;
 
-    return USBH_Transact(HubExtension,
-                         PortStatus,
-                         Length,
-                         BMREQUEST_DEVICE_TO_HOST,
-                         URB_FUNCTION_CLASS_OTHER,
-                         RequestType,
-                         USB_REQUEST_GET_STATUS,
-                         0,
-                         Port);
+    Status = USBH_Transact(HubExtension,
+                           PortStatus,
+                           Length,
+                           BMREQUEST_DEVICE_TO_HOST,
+                           URB_FUNCTION_CLASS_OTHER,
+                           RequestType,
+                           USB_REQUEST_GET_STATUS,
+                           0,
+                           Port);
+
+    if (NT_SUCCESS(Status))
+    {
+        USBH_ConvertSsPortStatus(HubExtension, PortStatus);
+    }
+
+    return Status;
 }
 
 
@@ -1561,6 +1614,13 @@ USBH_SyncDisablePort(IN PUSBHUB_FDO_EXTENSION HubExtension,
 
     PortData = &HubExtension->PortData[Port - 1];
 
+    /* SuperSpeed ports have no PORT_ENABLE feature */
+    if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB)
+    {
+        PortData->PortStatus.PortStatus.Usb20PortStatus.PortEnabledDisabled = 0;
+        return STATUS_SUCCESS;
+    }
+
     RequestType.B = 0;
     RequestType.Recipient = BMREQUEST_TO_DEVICE;
     RequestType.Type = BMREQUEST_CLASS;
@@ -1717,6 +1777,11 @@ USBH_ChangeIndicationProcessChange(IN PDEVICE_OBJECT DeviceObject,
 
     HubExtension = Context;
 
+    if (NT_SUCCESS(Irp->IoStatus.Status))
+    {
+        USBH_ConvertSsPortStatus(HubExtension, &HubExtension->PortStatus);
+    }
+
     DPRINT_SCE("USBH_ChangeIndicationProcessChange: PortStatus - %lX\n",
                HubExtension->PortStatus.AsUlong32);
 
@@ -1873,6 +1938,7 @@ USBH_ProcessPortStateChange(IN PUSBHUB_FDO_EXTENSION HubExtension,
 {
     PUSBHUB_PORT_DATA PortData;
     USB_20_PORT_CHANGE PortStatusChange;
+    USB_30_PORT_CHANGE Usb30PortChange;
     PDEVICE_OBJECT PortDevice;
     PUSBHUB_PORT_PDO_EXTENSION PortExtension;
     PVOID SerialNumber;
@@ -1972,6 +2038,33 @@ USBH_ProcessPortStateChange(IN PUSBHUB_FDO_EXTENSION HubExtension,
         PortData->PortStatus = *PortStatus;
         USBH_SyncClearPortStatus(HubExtension, Port, RequestValue);
     }
+    else if (HubExtension->HubFlags & USBHUB_FDO_FLAG_USB30_HUB)
+    {
+        Usb30PortChange = PortStatus->PortChange.Usb30PortChange;
+        PortData->PortStatus = *PortStatus;
+
+        if (Usb30PortChange.BHResetChange)
+        {
+            USBH_SyncClearPortStatus(HubExtension,
+                                     Port,
+                                     USBHUB_FEATURE_C_BH_PORT_RESET);
+        }
+
+        if (Usb30PortChange.PortLinkStateChange)
+        {
+            USBH_SyncClearPortStatus(HubExtension,
+                                     Port,
+                                     USBHUB_FEATURE_C_PORT_LINK_STATE);
+        }
+
+        if (Usb30PortChange.PortConfigErrorChange)
+        {
+            DPRINT1("USBH_ProcessPortStateChange: Port %x config error\n", Port);
+            USBH_SyncClearPortStatus(HubExtension,
+                                     Port,
+                                     USBHUB_FEATURE_C_PORT_CONFIG_ERROR);
+        }
+    }
 }
 
 NTSTATUS
@@ -4457,7 +4550,9 @@ USBH_CreateDevice(IN PUSBHUB_FDO_EXTENSION HubExtension,
 
     SerialNumberBuffer = NULL;
 
-    IsHsDevice = UsbPortStatus.Usb20PortStatus.HighSpeedDeviceAttached;
+    IsHsDevice = UsbPortStatus.Usb20PortStatus.HighSpeedDeviceAttached ||
+                 (UsbPortStatus.Usb20PortStatus.Reserved1 &
+                  USB20_PORT_STATUS_RESERVED1_SUPER_SPEED);
     IsLsDevice = UsbPortStatus.Usb20PortStatus.LowSpeedDeviceAttached;
 
     if (IsLsDevice == 0)
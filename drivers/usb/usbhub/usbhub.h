@@ -57,6 +57,7 @@
 #define USBHUB_FDO_FLAG_GOING_IDLE        (1 << 25)
 #define USBHUB_FDO_FLAG_DEVICE_SUSPENDED  (1 << 26)
 #define USBHUB_FDO_FLAG_WITEM_INIT        (1 << 27)
+#define USBHUB_FDO_FLAG_USB30_HUB         (1 << 28)  // SuperSpeed hub, its ports report the USB3 status layout
 
 #define USBHUB_PDO_FLAG_HUB_DEVICE        (1 << 0)
 #define USBHUB_PDO_FLAG_MULTI_INTERFACE   (1 << 1)
@@ -103,6 +104,14 @@
 #define USBHUB_FEATURE_PORT_TEST           21
 #define USBHUB_FEATURE_PORT_INDICATOR      22
 
+/* SuperSpeed Hub Class Feature Selectors */
+#define USBHUB_FEATURE_C_PORT_LINK_STATE   25
+#define USBHUB_FEATURE_C_PORT_CONFIG_ERROR 26
+#define USBHUB_FEATURE_C_BH_PORT_RESET     29
+
+/* bDeviceProtocol of the SuperSpeed part of a USB3 hub */
+#define USBHUB_SUPER_SPEED_HUB_PROTOCOL    3
+
 #define USBHUB_MAX_CASCADE_LEVELS  6
 #define USBHUB_RESET_PORT_MAX_RETRY  3
 #define USBHUB_MAX_REQUEST_ERRORS    3
@@ -482,6 +491,12 @@ USBH_SyncGetStringDescriptor(
   IN PULONG OutLength,
   IN BOOLEAN IsValidateLength);
 
+VOID
+NTAPI
+USBH_ConvertSsPortStatus(
+  IN PUSBHUB_FDO_EXTENSION HubExtension,
+  IN OUT PUSB_PORT_STATUS_AND_CHANGE PortStatus);
+
 NTSTATUS
 NTAPI
 USBH_SyncGetPortStatus(
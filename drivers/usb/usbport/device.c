@@ -998,12 +998,19 @@ USBPORT_CreateDevice(IN OUT PUSB_DEVICE_HANDLE *pUsbdDeviceHandle,
     UCHAR MaxPacketSize;
     PUSBPORT_DEVICE_EXTENSION FdoExtension;
     PUSBPORT_REGISTRATION_PACKET Packet;
+    USB_PORT_STATUS UsbPortStatus;
+    BOOLEAN IsSuperSpeed;
     NTSTATUS Status;
 
     DPRINT("USBPORT_CreateDevice: PortStatus - %p, Port - %x\n",
            PortStatus,
            Port);
 
+    /* xHCI root hubs and SuperSpeed hubs flag SuperSpeed ports in the USB2 layout */
+    UsbPortStatus.AsUshort16 = PortStatus;
+    IsSuperSpeed = (UsbPortStatus.Usb20PortStatus.Reserved1 &
+                    USB20_PORT_STATUS_RESERVED1_SUPER_SPEED) != 0;
+
     FdoExtension = FdoDevice->DeviceExtension;
     Packet = &FdoExtension->MiniPortInterface->Packet;
 
@@ -1027,7 +1034,8 @@ USBPORT_CreateDevice(IN OUT PUSB_DEVICE_HANDLE *pUsbdDeviceHandle,
     port = Port;
 
     if (Packet->MiniPortFlags & USB_MINIPORT_FLAGS_USB2 &&
-        !(PortStatus & USB_PORT_STATUS_HIGH_SPEED))
+        !(PortStatus & USB_PORT_STATUS_HIGH_SPEED) &&
+        !IsSuperSpeed)
     {
         DPRINT1("USBPORT_CreateDevice: USB1 device connected to USB2 port\n");
 
@@ -1064,7 +1072,11 @@ USBPORT_CreateDevice(IN OUT PUSB_DEVICE_HANDLE *pUsbdDeviceHandle,
     DeviceHandle->PortNumber = Port;
     DeviceHandle->HubDeviceHandle = HubDeviceHandle;
 
-    if (PortStatus & USB_PORT_STATUS_LOW_SPEED)
+    if (IsSuperSpeed)
+    {
+        DeviceHandle->DeviceSpeed = UsbSuperSpeed;
+    }
+    else if (PortStatus & USB_PORT_STATUS_LOW_SPEED)
     {
         DeviceHandle->DeviceSpeed = UsbLowSpeed;
     }
@@ -1094,6 +1106,10 @@ USBPORT_CreateDevice(IN OUT PUSB_DEVICE_HANDLE *pUsbdDeviceHandle,
     {
         PipeHandle->EndpointDescriptor.wMaxPacketSize = 8;
     }
+    else if (DeviceHandle->DeviceSpeed == UsbSuperSpeed)
+    {
+        PipeHandle->EndpointDescriptor.wMaxPacketSize = USB_SUPER_SPEED_MAX_PACKET0;
+    }
     else
     {
         PipeHandle->EndpointDescriptor.wMaxPacketSize = USB_DEFAULT_MAX_PACKET;
@@ -1175,7 +1191,8 @@ USBPORT_CreateDevice(IN OUT PUSB_DEVICE_HANDLE *pUsbdDeviceHandle,
             if (MaxPacketSize == 8 ||
                 MaxPacketSize == 16 ||
                 MaxPacketSize == 32 ||
-                MaxPacketSize == 64)
+                MaxPacketSize == 64 ||
+                (DeviceHandle->DeviceSpeed == UsbSuperSpeed && MaxPacketSize == 9))
             {
                 USBPORT_AddDeviceHandle(FdoDevice, DeviceHandle);
 
@@ -1362,7 +1379,16 @@ USBPORT_InitializeDevice(IN PUSBPORT_DEVICE_HANDLE DeviceHandle,
     DeviceHandle->DeviceAddress = DeviceAddress;
     Endpoint = DeviceHandle->PipeHandle.Endpoint;
 
-    Endpoint->EndpointProperties.TotalMaxPacketSize = DeviceHandle->DeviceDescriptor.bMaxPacketSize0;
+    if (DeviceHandle->DeviceSpeed == UsbSuperSpeed)
+    {
+        /* bMaxPacketSize0 is an exponent for SuperSpeed devices */
+        Endpoint->EndpointProperties.TotalMaxPacketSize = 1 << DeviceHandle->DeviceDescriptor.bMaxPacketSize0;
+    }
+    else
+    {
+        Endpoint->EndpointProperties.TotalMaxPacketSize = DeviceHandle->DeviceDescriptor.bMaxPacketSize0;
+    }
+
     Endpoint->EndpointProperties.DeviceAddress = DeviceAddress;
 
     Status = USBPORT_ReopenPipe(FdoDevice, Endpoint);
@@ -1398,7 +1424,8 @@ USBPORT_InitializeDevice(IN PUSBPORT_DEVICE_HANDLE DeviceHandle,
         ASSERT((MaxPacketSize == 8) ||
                (MaxPacketSize == 16) ||
                (MaxPacketSize == 32) ||
-               (MaxPacketSize == 64));
+               (MaxPacketSize == 64) ||
+               (DeviceHandle->DeviceSpeed == UsbSuperSpeed && MaxPacketSize == 9));
 
         if (DeviceHandle->DeviceSpeed == UsbHighSpeed &&
             DeviceHandle->DeviceDescriptor.bDeviceClass == USB_DEVICE_CLASS_HUB)
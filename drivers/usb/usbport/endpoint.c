@@ -249,6 +249,33 @@ USBPORT_NormalizeHsInterval(UCHAR Interval)
     return 1 << interval;
 }
 
+VOID
+NTAPI
+USBPORT_GetRouteString(IN PUSBPORT_DEVICE_HANDLE DeviceHandle,
+                       OUT PUCHAR RootPortNumber,
+                       OUT PULONG RouteString)
+{
+    ULONG Route = 0;
+    USHORT Port;
+
+    /* Collect the hub ports up to the root hub, the first tier ends up in the lowest bits */
+    while (DeviceHandle->HubDeviceHandle &&
+           !(DeviceHandle->HubDeviceHandle->Flags & DEVICE_HANDLE_FLAG_ROOTHUB))
+    {
+        Port = min(DeviceHandle->PortNumber, 15);
+        Route = (Route << 4) | Port;
+
+        DeviceHandle = DeviceHandle->HubDeviceHandle;
+    }
+
+    *RootPortNumber = (UCHAR)DeviceHandle->PortNumber;
+    *RouteString = Route;
+
+    DPRINT("USBPORT_GetRouteString: RootPortNumber - %x, RouteString - %lx\n",
+           *RootPortNumber,
+           *RouteString);
+}
+
 BOOLEAN
 NTAPI
 USBPORT_EndpointHasQueuedTransfers(IN PDEVICE_OBJECT FdoDevice,
@@ -881,6 +908,13 @@ USBPORT_OpenPipe(IN PDEVICE_OBJECT FdoDevice,
 
     EndpointProperties->PortNumber = DeviceHandle->PortNumber;
 
+    if (Packet->MiniPortVersion == USB_MINIPORT_VERSION_XHCI)
+    {
+        USBPORT_GetRouteString(DeviceHandle,
+                               &EndpointProperties->RootPortNumber,
+                               &EndpointProperties->RouteString);
+    }
+
     switch (EndpointDescriptor->bmAttributes & USB_ENDPOINT_TYPE_MASK)
     {
         case USB_ENDPOINT_TYPE_CONTROL:
@@ -916,7 +950,8 @@ USBPORT_OpenPipe(IN PDEVICE_OBJECT FdoDevice,
 
     if (EndpointProperties->TransferType == USBPORT_TRANSFER_TYPE_INTERRUPT)
     {
-        if (EndpointProperties->DeviceSpeed == UsbHighSpeed)
+        if (EndpointProperties->DeviceSpeed == UsbHighSpeed ||
+            EndpointProperties->DeviceSpeed == UsbSuperSpeed)
         {
             Interval = USBPORT_NormalizeHsInterval(EndpointDescriptor->bInterval);
         }
@@ -954,7 +989,8 @@ USBPORT_OpenPipe(IN PDEVICE_OBJECT FdoDevice,
 
     if (EndpointProperties->TransferType == USB_ENDPOINT_TYPE_ISOCHRONOUS)
     {
-        if (EndpointProperties->DeviceSpeed == UsbHighSpeed)
+        if (EndpointProperties->DeviceSpeed == UsbHighSpeed ||
+            EndpointProperties->DeviceSpeed == UsbSuperSpeed)
         {
             EndpointProperties->Period =
                 USBPORT_NormalizeHsInterval(EndpointDescriptor->bInterval);
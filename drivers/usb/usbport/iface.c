@@ -241,7 +241,8 @@ USBHI_QueryDeviceInformation(IN PVOID BusContext,
     {
         DeviceInfo->DeviceType = Usb11Device;
     }
-    else if (DeviceHandle->DeviceSpeed == UsbHighSpeed)
+    else if (DeviceHandle->DeviceSpeed == UsbHighSpeed ||
+             DeviceHandle->DeviceSpeed == UsbSuperSpeed)
     {
         DeviceInfo->DeviceType = Usb20Device;
     }
@@ -1847,6 +1847,12 @@ USBPORT_AllocateBandwidthUSB2(IN PDEVICE_OBJECT FdoDevice,
         return TRUE;
     }
 
+    /* The xHC schedules SuperSpeed periodic endpoints itself */
+    if (EndpointProperties->DeviceSpeed == UsbSuperSpeed)
+    {
+        return TRUE;
+    }
+
     if (Endpoint->TtExtension)
         TtExtension = Endpoint->TtExtension;
     else
@@ -2068,7 +2074,8 @@ USBPORT_FreeBandwidthUSB2(IN PDEVICE_OBJECT FdoDevice,
 
     if (TransferType == USBPORT_TRANSFER_TYPE_CONTROL ||
         TransferType == USBPORT_TRANSFER_TYPE_BULK ||
-        (Endpoint->Flags & ENDPOINT_FLAG_ROOTHUB_EP0))
+        (Endpoint->Flags & ENDPOINT_FLAG_ROOTHUB_EP0) ||
+        Endpoint->EndpointProperties.DeviceSpeed == UsbSuperSpeed)
     {
         return;
     }
@@ -44,6 +44,8 @@
 #define USB_PORT_TAG 'pbsu'
 #define URB_FUNCTION_MAX 0x31
 
+#define USB_SUPER_SPEED_MAX_PACKET0 512
+
 /* Hub Class Feature Selectors (Recipient - Port) */
 #define FEATURE_PORT_CONNECTION     0
 #define FEATURE_PORT_ENABLE         1
@@ -933,6 +935,13 @@ USBPORT_AddPipeHandle(
   IN PUSBPORT_DEVICE_HANDLE DeviceHandle,
   IN PUSBPORT_PIPE_HANDLE PipeHandle);
 
+VOID
+NTAPI
+USBPORT_GetRouteString(
+  IN PUSBPORT_DEVICE_HANDLE DeviceHandle,
+  OUT PUCHAR RootPortNumber,
+  OUT PULONG RouteString);
+
 VOID
 NTAPI
 USBPORT_RemovePipeHandle(
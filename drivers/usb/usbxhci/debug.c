@@ -0,0 +1,48 @@
+/*
+ * PROJECT:     ReactOS USB xHCI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     USBXHCI debugging functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "usbxhci.h"
+
+//#define NDEBUG
+#include <debug.h>
+
+VOID
+NTAPI
+XHCI_DumpTrb(IN PXHCI_TRB Trb)
+{
+    DPRINT(": Trb              - %p\n", Trb);
+    DPRINT(": Trb->Parameter[0] - %lx\n", Trb->Parameter[0]);
+    DPRINT(": Trb->Parameter[1] - %lx\n", Trb->Parameter[1]);
+    DPRINT(": Trb->Status       - %lx\n", Trb->Status);
+    DPRINT(": Trb->Control      - %lx\n", Trb->Control);
+}
+
+VOID
+NTAPI
+XHCI_DumpRing(IN PXHCI_RING Ring,
+              IN ULONG FirstTrb,
+              IN ULONG LastTrb)
+{
+    ULONG Index;
+
+    DPRINT(": Ring->FirstTrbPA - %lx, Enqueue - %x, Cycle - %x\n",
+           Ring->FirstTrbPA,
+           Ring->Enqueue,
+           Ring->Cycle);
+
+    Index = FirstTrb;
+
+    while (TRUE)
+    {
+        XHCI_DumpTrb(&Ring->FirstTrb[Index]);
+
+        if (Index == LastTrb)
+            break;
+
+        Index = (Index + 1) % Ring->NumberOfTrbs;
+    }
+}
@@ -0,0 +1,426 @@
+/*
+ * PROJECT:     ReactOS USB xHCI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     USBXHCI hardware declarations
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#define XHCI_MAX_ROOT_PORTS  255
+
+/* Capability Registers. Section 5.3 */
+typedef union _XHCI_HC_STRUCTURAL_PARAMS_1 {
+  struct {
+    ULONG MaxDeviceSlots : 8;
+    ULONG MaxInterrupters : 11;
+    ULONG Reserved1 : 5;
+    ULONG MaxPorts : 8;
+  };
+  ULONG AsULONG;
+} XHCI_HC_STRUCTURAL_PARAMS_1;
+
+C_ASSERT(sizeof(XHCI_HC_STRUCTURAL_PARAMS_1) == sizeof(ULONG));
+
+typedef union _XHCI_HC_STRUCTURAL_PARAMS_2 {
+  struct {
+    ULONG IsochSchedulingThreshold : 4;
+    ULONG EventRingSegmentTableMax : 4;
+    ULONG Reserved1 : 13;
+    ULONG MaxScratchpadBuffersHi : 5;
+    ULONG ScratchpadRestore : 1;
+    ULONG MaxScratchpadBuffersLo : 5;
+  };
+  ULONG AsULONG;
+} XHCI_HC_STRUCTURAL_PARAMS_2;
+
+C_ASSERT(sizeof(XHCI_HC_STRUCTURAL_PARAMS_2) == sizeof(ULONG));
+
+typedef union _XHCI_HC_CAPABILITY_PARAMS_1 {
+  struct {
+    ULONG Addressing64bitCapability : 1;
+    ULONG BwNegotiationCapability : 1;
+    ULONG ContextSize : 1; // 0 - 32 byte contexts, 1 - 64 byte contexts
+    ULONG PortPowerControl : 1;
+    ULONG PortIndicators : 1;
+    ULONG LightHcResetCapability : 1;
+    ULONG LatencyToleranceMessagingCapability : 1;
+    ULONG NoSecondarySidSupport : 1;
+    ULONG ParseAllEventData : 1;
+    ULONG StoppedShortPacketCapability : 1;
+    ULONG StoppedEdtlaCapability : 1;
+    ULONG ContiguousFrameIdCapability : 1;
+    ULONG MaxPrimaryStreamArraySize : 4;
+    ULONG ExtCapabilitiesPointer : 16; // In DWORDs from the register base (xECP)
+  };
+  ULONG AsULONG;
+} XHCI_HC_CAPABILITY_PARAMS_1;
+
+C_ASSERT(sizeof(XHCI_HC_CAPABILITY_PARAMS_1) == sizeof(ULONG));
+
+typedef struct _XHCI_HC_CAPABILITY_REGISTERS {
+  UCHAR RegistersLength; // RO
+  UCHAR Reserved; // RO
+  USHORT InterfaceVersion; // RO
+  XHCI_HC_STRUCTURAL_PARAMS_1 StructParameters1; // RO
+  XHCI_HC_STRUCTURAL_PARAMS_2 StructParameters2; // RO
+  ULONG StructParameters3; // RO
+  XHCI_HC_CAPABILITY_PARAMS_1 CapParameters1; // RO
+  ULONG DoorbellOffset; // RO
+  ULONG RuntimeRegistersOffset; // RO
+  ULONG CapParameters2; // RO
+} XHCI_HC_CAPABILITY_REGISTERS, *PXHCI_HC_CAPABILITY_REGISTERS;
+
+/* Extended Capabilities. Section 7 */
+#define XHCI_EXT_CAP_ID_LEGACY_SUPPORT      1
+#define XHCI_EXT_CAP_ID_SUPPORTED_PROTOCOL  2
+
+typedef union _XHCI_EXTENDED_CAPABILITY {
+  struct {
+    ULONG CapabilityID : 8;
+    ULONG NextCapabilityPointer : 8; // In DWORDs
+    ULONG CapabilitySpecific : 16;
+  };
+  ULONG AsULONG;
+} XHCI_EXTENDED_CAPABILITY;
+
+C_ASSERT(sizeof(XHCI_EXTENDED_CAPABILITY) == sizeof(ULONG));
+
+typedef union _XHCI_LEGACY_SUPPORT_CAPABILITY {
+  struct {
+    ULONG CapabilityID : 8;
+    ULONG NextCapabilityPointer : 8;
+    ULONG BiosOwnedSemaphore : 1;
+    ULONG Reserved1 : 7;
+    ULONG OsOwnedSemaphore : 1;
+    ULONG Reserved2 : 7;
+  };
+  ULONG AsULONG;
+} XHCI_LEGACY_SUPPORT_CAPABILITY;
+
+C_ASSERT(sizeof(XHCI_LEGACY_SUPPORT_CAPABILITY) == sizeof(ULONG));
+
+/* USB Legacy Support Control/Status. SMI enables and RW1C SMI events */
+#define XHCI_LEGACY_SMI_ENABLE_MASK  0x0000E011
+#define XHCI_LEGACY_SMI_EVENTS_MASK  0xE0000000
+
+typedef union _XHCI_SUPPORTED_PROTOCOL_CAPABILITY {
+  struct {
+    ULONG CapabilityID : 8;
+    ULONG NextCapabilityPointer : 8;
+    ULONG MinorRevision : 8;
+    ULONG MajorRevision : 8;
+  };
+  ULONG AsULONG;
+} XHCI_SUPPORTED_PROTOCOL_CAPABILITY;
+
+C_ASSERT(sizeof(XHCI_SUPPORTED_PROTOCOL_CAPABILITY) == sizeof(ULONG));
+
+typedef union _XHCI_SUPPORTED_PROTOCOL_PORTS {
+  struct {
+    ULONG CompatiblePortOffset : 8; // 1-based
+    ULONG CompatiblePortCount : 8;
+    ULONG ProtocolDefined : 12;
+    ULONG ProtocolSpeedIdCount : 4;
+  };
+  ULONG AsULONG;
+} XHCI_SUPPORTED_PROTOCOL_PORTS;
+
+C_ASSERT(sizeof(XHCI_SUPPORTED_PROTOCOL_PORTS) == sizeof(ULONG));
+
+/* Operational Registers. Section 5.4 */
+typedef union _XHCI_USB_COMMAND {
+  struct {
+    ULONG Run : 1;
+    ULONG Reset : 1;
+    ULONG InterrupterEnable : 1;
+    ULONG HostSystemErrorEnable : 1;
+    ULONG Reserved1 : 3;
+    ULONG LightHcReset : 1;
+    ULONG ControllerSaveState : 1;
+    ULONG ControllerRestoreState : 1;
+    ULONG EnableWrapEvent : 1;
+    ULONG EnableU3MfindexStop : 1;
+    ULONG Reserved2 : 1;
+    ULONG CemEnable : 1;
+    ULONG Reserved3 : 18;
+  };
+  ULONG AsULONG;
+} XHCI_USB_COMMAND;
+
+C_ASSERT(sizeof(XHCI_USB_COMMAND) == sizeof(ULONG));
+
+typedef union _XHCI_USB_STATUS {
+  struct {
+    ULONG HCHalted : 1;
+    ULONG Reserved1 : 1;
+    ULONG HostSystemError : 1; // RW1C
+    ULONG EventInterrupt : 1; // RW1C
+    ULONG PortChangeDetect : 1; // RW1C
+    ULONG Reserved2 : 3;
+    ULONG SaveStateStatus : 1;
+    ULONG RestoreStateStatus : 1;
+    ULONG SaveRestoreError : 1; // RW1C
+    ULONG ControllerNotReady : 1;
+    ULONG HostControllerError : 1;
+    ULONG Reserved3 : 19;
+  };
+  ULONG AsULONG;
+} XHCI_USB_STATUS;
+
+C_ASSERT(sizeof(XHCI_USB_STATUS) == sizeof(ULONG));
+
+#define XHCI_USB_STATUS_RW1C_MASK  0x0000041C
+
+#define XHCI_CRCR_RING_CYCLE_STATE   0x00000001
+#define XHCI_CRCR_COMMAND_STOP       0x00000002
+#define XHCI_CRCR_COMMAND_ABORT      0x00000004
+#define XHCI_CRCR_COMMAND_RUNNING    0x00000008
+
+/* Port Status and Control Register. Section 5.4.8 */
+#define XHCI_PORT_SPEED_FULL        1
+#define XHCI_PORT_SPEED_LOW         2
+#define XHCI_PORT_SPEED_HIGH        3
+#define XHCI_PORT_SPEED_SUPER       4
+#define XHCI_PORT_SPEED_SUPER_PLUS  5
+
+#define XHCI_PORT_LINK_STATE_U0      0
+#define XHCI_PORT_LINK_STATE_U3      3
+#define XHCI_PORT_LINK_STATE_RESUME  15
+
+typedef union _XHCI_PORT_STATUS_CONTROL {
+  struct {
+    ULONG CurrentConnectStatus : 1;
+    ULONG PortEnabledDisabled : 1; // RW1CS. Writing 1 disables the port
+    ULONG Reserved1 : 1;
+    ULONG OverCurrentActive : 1;
+    ULONG PortReset : 1;
+    ULONG PortLinkState : 4;
+    ULONG PortPower : 1;
+    ULONG PortSpeed : 4;
+    ULONG PortIndicatorControl : 2;
+    ULONG PortLinkStateWriteStrobe : 1;
+    ULONG ConnectStatusChange : 1; // RW1CS
+    ULONG PortEnableDisableChange : 1; // RW1CS
+    ULONG WarmPortResetChange : 1; // RW1CS
+    ULONG OverCurrentChange : 1; // RW1CS
+    ULONG PortResetChange : 1; // RW1CS
+    ULONG PortLinkStateChange : 1; // RW1CS
+    ULONG PortConfigErrorChange : 1; // RW1CS
+    ULONG ColdAttachStatus : 1;
+    ULONG WakeOnConnectEnable : 1;
+    ULONG WakeOnDisconnectEnable : 1;
+    ULONG WakeOnOverCurrentEnable : 1;
+    ULONG Reserved2 : 2;
+    ULONG DeviceRemovable : 1;
+    ULONG WarmPortReset : 1;
+  };
+  ULONG AsULONG;
+} XHCI_PORT_STATUS_CONTROL;
+
+C_ASSERT(sizeof(XHCI_PORT_STATUS_CONTROL) == sizeof(ULONG));
+
+/* Bits that keep their value when written back, everything else is RW1C or ignored */
+#define XHCI_PORTSC_PRESERVE_MASK  0x0E00C200
+#define XHCI_PORTSC_CHANGE_MASK    0x00FE0000
+
+typedef struct _XHCI_PORT_REGISTERS {
+  XHCI_PORT_STATUS_CONTROL PortStatusControl;
+  ULONG PortPowerManagement;
+  ULONG PortLinkInfo;
+  ULONG PortHardwareLpmControl;
+} XHCI_PORT_REGISTERS, *PXHCI_PORT_REGISTERS;
+
+typedef struct _XHCI_HW_REGISTERS {
+  XHCI_USB_COMMAND HcCommand; // RW
+  XHCI_USB_STATUS HcStatus; // RW
+  ULONG PageSize; // RO
+  ULONG Reserved1[2];
+  ULONG DeviceNotificationControl; // RW
+  ULONG CommandRingControl[2]; // RW
+  ULONG Reserved2[4];
+  ULONG DeviceContextBaseArray[2]; // RW
+  ULONG Configure; // RW
+  ULONG Reserved3[241];
+  XHCI_PORT_REGISTERS PortControl[XHCI_MAX_ROOT_PORTS]; // 0x400
+} XHCI_HW_REGISTERS, *PXHCI_HW_REGISTERS;
+
+C_ASSERT(FIELD_OFFSET(XHCI_HW_REGISTERS, CommandRingControl) == 0x18);
+C_ASSERT(FIELD_OFFSET(XHCI_HW_REGISTERS, DeviceContextBaseArray) == 0x30);
+C_ASSERT(FIELD_OFFSET(XHCI_HW_REGISTERS, PortControl) == 0x400);
+
+/* Runtime Registers. Section 5.5 */
+#define XHCI_IMAN_INTERRUPT_PENDING  0x00000001 // RW1C
+#define XHCI_IMAN_INTERRUPT_ENABLE   0x00000002
+
+#define XHCI_ERDP_EVENT_HANDLER_BUSY  0x00000008 // RW1C
+
+typedef struct _XHCI_INTERRUPTER_REGISTERS {
+  ULONG InterrupterManagement;
+  ULONG InterrupterModeration; // Interval in 250 ns units
+  ULONG EventRingSegmentTableSize;
+  ULONG Reserved;
+  ULONG EventRingSegmentTableBase[2];
+  ULONG EventRingDequeuePointer[2];
+} XHCI_INTERRUPTER_REGISTERS, *PXHCI_INTERRUPTER_REGISTERS;
+
+C_ASSERT(sizeof(XHCI_INTERRUPTER_REGISTERS) == 32);
+
+typedef struct _XHCI_RUNTIME_REGISTERS {
+  ULONG MicroframeIndex;
+  ULONG Reserved[7];
+  XHCI_INTERRUPTER_REGISTERS Interrupter[1]; // Only the primary interrupter is used
+} XHCI_RUNTIME_REGISTERS, *PXHCI_RUNTIME_REGISTERS;
+
+#define XHCI_MFINDEX_MASK  0x3FFF
+
+/* Transfer Request Blocks. Section 6.4 */
+#define XHCI_TRB_TYPE_NORMAL                 1
+#define XHCI_TRB_TYPE_SETUP_STAGE            2
+#define XHCI_TRB_TYPE_DATA_STAGE             3
+#define XHCI_TRB_TYPE_STATUS_STAGE           4
+#define XHCI_TRB_TYPE_LINK                   6
+#define XHCI_TRB_TYPE_NOOP                   8
+#define XHCI_TRB_TYPE_ENABLE_SLOT            9
+#define XHCI_TRB_TYPE_DISABLE_SLOT           10
+#define XHCI_TRB_TYPE_ADDRESS_DEVICE         11
+#define XHCI_TRB_TYPE_CONFIGURE_ENDPOINT     12
+#define XHCI_TRB_TYPE_EVALUATE_CONTEXT       13
+#define XHCI_TRB_TYPE_RESET_ENDPOINT         14
+#define XHCI_TRB_TYPE_STOP_ENDPOINT          15
+#define XHCI_TRB_TYPE_SET_TR_DEQUEUE         16
+#define XHCI_TRB_TYPE_TRANSFER_EVENT         32
+#define XHCI_TRB_TYPE_COMMAND_COMPLETION     33
+#define XHCI_TRB_TYPE_PORT_STATUS_CHANGE     34
+#define XHCI_TRB_TYPE_HOST_CONTROLLER_EVENT  37
+#define XHCI_TRB_TYPE_MFINDEX_WRAP           39
+
+/* Control field bits */
+#define XHCI_TRB_CYCLE                0x00000001
+#define XHCI_TRB_TOGGLE_CYCLE         0x00000002 // Link TRB
+#define XHCI_TRB_EVENT_DATA           0x00000004 // Transfer Event TRB
+#define XHCI_TRB_INTERRUPT_ON_SHORT   0x00000004
+#define XHCI_TRB_CHAIN                0x00000010
+#define XHCI_TRB_INTERRUPT_ON_COMPLETION 0x00000020
+#define XHCI_TRB_IMMEDIATE_DATA       0x00000040
+#define XHCI_TRB_BLOCK_SET_ADDRESS    0x00000200 // Address Device Command TRB
+#define XHCI_TRB_DIRECTION_IN         0x00010000 // Data and Status Stage TRBs
+
+#define XHCI_TRB_TYPE_SHIFT           10
+#define XHCI_TRB_TYPE_MASK            0x0000FC00
+#define XHCI_TRB_TYPE(Type)           ((ULONG)(Type) << XHCI_TRB_TYPE_SHIFT)
+#define XHCI_TRB_GET_TYPE(Control)    (((Control) & XHCI_TRB_TYPE_MASK) >> XHCI_TRB_TYPE_SHIFT)
+
+#define XHCI_TRB_TRANSFER_TYPE_NO_DATA  0x00000000 // Setup Stage TRB
+#define XHCI_TRB_TRANSFER_TYPE_OUT      0x00020000
+#define XHCI_TRB_TRANSFER_TYPE_IN       0x00030000
+
+#define XHCI_TRB_ENDPOINT_ID(Dci)     ((ULONG)(Dci) << 16)
+#define XHCI_TRB_GET_ENDPOINT_ID(Control) (((Control) >> 16) & 0x1F)
+#define XHCI_TRB_SLOT_ID(SlotId)      ((ULONG)(SlotId) << 24)
+#define XHCI_TRB_GET_SLOT_ID(Control) ((Control) >> 24)
+
+/* Status field of the transfer TRBs */
+#define XHCI_TRB_MAX_TRANSFER_LENGTH  0x10000
+#define XHCI_TRB_LENGTH_MASK          0x0001FFFF
+#define XHCI_TRB_TD_SIZE(Packets)     ((ULONG)(Packets) << 17)
+#define XHCI_TRB_TD_SIZE_MAX          31
+
+/* Status field of the event TRBs */
+#define XHCI_EVENT_LENGTH_MASK            0x00FFFFFF
+#define XHCI_EVENT_GET_COMPLETION_CODE(Status)  ((Status) >> 24)
+
+/* Completion codes. Section 6.4.5 */
+#define XHCI_COMPLETION_SUCCESS                1
+#define XHCI_COMPLETION_DATA_BUFFER_ERROR      2
+#define XHCI_COMPLETION_BABBLE_DETECTED        3
+#define XHCI_COMPLETION_USB_TRANSACTION_ERROR  4
+#define XHCI_COMPLETION_TRB_ERROR              5
+#define XHCI_COMPLETION_STALL_ERROR            6
+#define XHCI_COMPLETION_SHORT_PACKET           13
+#define XHCI_COMPLETION_RING_UNDERRUN          14
+#define XHCI_COMPLETION_RING_OVERRUN           15
+#define XHCI_COMPLETION_CONTEXT_STATE_ERROR    19
+#define XHCI_COMPLETION_EVENT_RING_FULL        21
+#define XHCI_COMPLETION_MISSED_SERVICE         23
+#define XHCI_COMPLETION_STOPPED                26
+#define XHCI_COMPLETION_STOPPED_LENGTH_INVALID 27
+#define XHCI_COMPLETION_STOPPED_SHORT_PACKET   28
+
+typedef struct _XHCI_TRB {
+  ULONG Parameter[2];
+  ULONG Status;
+  ULONG Control;
+} XHCI_TRB, *PXHCI_TRB;
+
+C_ASSERT(sizeof(XHCI_TRB) == 16);
+
+/* The Link TRB is the last TRB of every page of a ring */
+#define XHCI_TRBS_PER_PAGE  (PAGE_SIZE / sizeof(XHCI_TRB))
+
+typedef struct _XHCI_EVENT_RING_SEGMENT_TABLE_ENTRY {
+  ULONG RingSegmentBase[2];
+  ULONG RingSegmentSize;
+  ULONG Reserved;
+} XHCI_EVENT_RING_SEGMENT_TABLE_ENTRY, *PXHCI_EVENT_RING_SEGMENT_TABLE_ENTRY;
+
+C_ASSERT(sizeof(XHCI_EVENT_RING_SEGMENT_TABLE_ENTRY) == 16);
+
+/* Contexts. Section 6.2. Shown in the 32 byte layout, the 64 byte layout pads each one */
+#define XHCI_SLOT_SPEED_SHIFT          20
+#define XHCI_SLOT_CONTEXT_ENTRIES_SHIFT 27
+#define XHCI_SLOT_MTT                  0x02000000
+#define XHCI_SLOT_HUB                  0x04000000
+#define XHCI_SLOT_ROUTE_STRING_MASK    0x000FFFFF
+
+#define XHCI_SLOT_ROOT_PORT_SHIFT      16
+#define XHCI_SLOT_TT_PORT_SHIFT        8
+
+typedef struct _XHCI_SLOT_CONTEXT {
+  ULONG RouteSpeedEntries; // Route String, Speed, MTT, Hub, Context Entries
+  ULONG RootPortNumber; // Max Exit Latency, Root Hub Port Number, Number of Ports
+  ULONG TtInfo; // TT Hub Slot ID, TT Port Number, TTT, Interrupter Target
+  ULONG DeviceState; // USB Device Address, Slot State
+  ULONG Reserved[4];
+} XHCI_SLOT_CONTEXT, *PXHCI_SLOT_CONTEXT;
+
+C_ASSERT(sizeof(XHCI_SLOT_CONTEXT) == 32);
+
+#define XHCI_ENDPOINT_TYPE_ISOCH_OUT  1
+#define XHCI_ENDPOINT_TYPE_BULK_OUT   2
+#define XHCI_ENDPOINT_TYPE_INT_OUT    3
+#define XHCI_ENDPOINT_TYPE_CONTROL    4
+#define XHCI_ENDPOINT_TYPE_ISOCH_IN   5
+#define XHCI_ENDPOINT_TYPE_BULK_IN    6
+#define XHCI_ENDPOINT_TYPE_INT_IN     7
+
+#define XHCI_ENDPOINT_STATE_MASK      0x00000007
+#define XHCI_ENDPOINT_STATE_HALTED    2
+#define XHCI_ENDPOINT_INTERVAL_SHIFT  16
+#define XHCI_ENDPOINT_ERROR_COUNT_SHIFT 1
+#define XHCI_ENDPOINT_TYPE_SHIFT      3
+#define XHCI_ENDPOINT_MAX_BURST_SHIFT 8
+#define XHCI_ENDPOINT_MAX_PACKET_SHIFT 16
+#define XHCI_ENDPOINT_DEQUEUE_CYCLE   0x00000001
+
+typedef struct _XHCI_ENDPOINT_CONTEXT {
+  ULONG StateInterval; // EP State, Mult, MaxPStreams, LSA, Interval, Max ESIT Payload Hi
+  ULONG TypeMaxPacket; // CErr, EP Type, HID, Max Burst Size, Max Packet Size
+  ULONG DequeuePointer[2]; // DCS in bit 0
+  ULONG AverageTrbLength; // Average TRB Length, Max ESIT Payload Lo
+  ULONG Reserved[3];
+} XHCI_ENDPOINT_CONTEXT, *PXHCI_ENDPOINT_CONTEXT;
+
+C_ASSERT(sizeof(XHCI_ENDPOINT_CONTEXT) == 32);
+
+typedef struct _XHCI_INPUT_CONTROL_CONTEXT {
+  ULONG DropFlags;
+  ULONG AddFlags;
+  ULONG Reserved[6];
+} XHCI_INPUT_CONTROL_CONTEXT, *PXHCI_INPUT_CONTROL_CONTEXT;
+
+C_ASSERT(sizeof(XHCI_INPUT_CONTROL_CONTEXT) == 32);
+
+/* Device Context Index. The Slot Context is DCI 0, the default control endpoint is DCI 1 */
+#define XHCI_MAX_DCI  31
+#define XHCI_DCI(EndpointAddress) \
+    ((((EndpointAddress) & 0x0F) * 2) + \
+     ((((EndpointAddress) & USB_ENDPOINT_DIRECTION_MASK) || !((EndpointAddress) & 0x0F)) ? 1 : 0))
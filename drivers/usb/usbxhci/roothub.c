@@ -0,0 +1,455 @@
+/*
+ * PROJECT:     ReactOS USB xHCI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     USBXHCI root hub functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "usbxhci.h"
+
+#define NDEBUG
+#include <debug.h>
+
+#define NDEBUG_XHCI_ROOT_HUB
+#include "dbg_xhci.h"
+
+PULONG
+NTAPI
+XHCI_RH_GetPortStatusReg(IN PXHCI_EXTENSION XhciExtension,
+                         IN USHORT Port)
+{
+    ASSERT(Port != 0);
+    return &XhciExtension->OperationalRegs->PortControl[Port - 1].PortStatusControl.AsULONG;
+}
+
+VOID
+NTAPI
+XHCI_RH_WritePortSC(IN PXHCI_EXTENSION XhciExtension,
+                    IN USHORT Port,
+                    IN ULONG Bits)
+{
+    PULONG PortStatusReg;
+    ULONG PortSC;
+
+    /* Writing back what was read would clear every pending change and disable the port */
+    PortStatusReg = XHCI_RH_GetPortStatusReg(XhciExtension, Port);
+    PortSC = READ_REGISTER_ULONG(PortStatusReg) & XHCI_PORTSC_PRESERVE_MASK;
+
+    WRITE_REGISTER_ULONG(PortStatusReg, PortSC | Bits);
+}
+
+ULONG
+NTAPI
+XHCI_RH_PortLinkState(IN ULONG LinkState)
+{
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    PortSC.AsULONG = 0;
+    PortSC.PortLinkState = LinkState;
+    PortSC.PortLinkStateWriteStrobe = 1;
+
+    return PortSC.AsULONG;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ChirpRootPort(IN PVOID xhciExtension,
+                      IN USHORT Port)
+{
+    /* No companion controllers, every device speed is handled on the port it is attached to */
+    DPRINT_RH("XHCI_RH_ChirpRootPort: Port - %x\n", Port);
+    return MP_STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+XHCI_RH_GetRootHubData(IN PVOID xhciExtension,
+                       IN PVOID rootHubData)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PUSBPORT_ROOT_HUB_DATA RootHubData;
+    USBPORT_HUB_20_CHARACTERISTICS HubCharacteristics;
+
+    DPRINT_RH("XHCI_RH_GetRootHubData: XhciExtension - %p, rootHubData - %p\n",
+              XhciExtension,
+              rootHubData);
+
+    RootHubData = rootHubData;
+
+    RootHubData->NumberOfPorts = XhciExtension->NumberOfPorts;
+
+    HubCharacteristics.AsUSHORT = 0;
+
+    /* Individual port power switching if the xHC has PPC, ganged otherwise */
+    HubCharacteristics.PowerControlMode = XhciExtension->PortPowerControl;
+    HubCharacteristics.NoPowerSwitching = 0;
+    HubCharacteristics.PartOfCompoundDevice = 0;
+    HubCharacteristics.OverCurrentProtectionMode = 0;
+
+    RootHubData->HubCharacteristics.Usb20HubCharacteristics = HubCharacteristics;
+
+    RootHubData->PowerOnToPowerGood = 10; // Time (in 2 ms intervals)
+    RootHubData->HubControlCurrent = 0;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetStatus(IN PVOID xhciExtension,
+                  IN PUSHORT Status)
+{
+    DPRINT_RH("XHCI_RH_GetStatus: ... \n");
+    *Status = USB_GETSTATUS_SELF_POWERED;
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetPortStatus(IN PVOID xhciExtension,
+                      IN USHORT Port,
+                      IN PUSB_PORT_STATUS_AND_CHANGE PortStatus)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+    USB_PORT_STATUS_AND_CHANGE status;
+
+    PortSC.AsULONG = READ_REGISTER_ULONG(XHCI_RH_GetPortStatusReg(XhciExtension, Port));
+
+    if (PortSC.CurrentConnectStatus)
+    {
+        DPRINT_RH("XHCI_RH_GetPortStatus: Port - %x, PortSC.AsULONG - %X\n",
+                  Port,
+                  PortSC.AsULONG);
+    }
+
+    PortStatus->AsUlong32 = 0;
+
+    if (PortSC.AsULONG == 0xFFFFFFFF)
+        return MP_STATUS_SUCCESS;
+
+    status.AsUlong32 = 0;
+
+    /*
+     * The root hub reports in the USB 2.0 layout for all ports. SuperSpeed
+     * devices are flagged in Reserved1 so that USBPORT gives them the
+     * right speed.
+     */
+    status.PortStatus.Usb20PortStatus.CurrentConnectStatus = PortSC.CurrentConnectStatus;
+    status.PortStatus.Usb20PortStatus.PortEnabledDisabled = PortSC.PortEnabledDisabled;
+    status.PortStatus.Usb20PortStatus.Suspend = (PortSC.PortLinkState == XHCI_PORT_LINK_STATE_U3);
+    status.PortStatus.Usb20PortStatus.OverCurrent = PortSC.OverCurrentActive;
+    status.PortStatus.Usb20PortStatus.Reset = PortSC.PortReset;
+    status.PortStatus.Usb20PortStatus.PortPower = PortSC.PortPower;
+
+    if (PortSC.CurrentConnectStatus)
+    {
+        switch (PortSC.PortSpeed)
+        {
+            case XHCI_PORT_SPEED_LOW:
+                status.PortStatus.Usb20PortStatus.LowSpeedDeviceAttached = 1;
+                break;
+
+            case XHCI_PORT_SPEED_HIGH:
+                status.PortStatus.Usb20PortStatus.HighSpeedDeviceAttached = 1;
+                break;
+
+            case XHCI_PORT_SPEED_FULL:
+                break;
+
+            default:
+                status.PortStatus.Usb20PortStatus.Reserved1 = USB20_PORT_STATUS_RESERVED1_SUPER_SPEED;
+                break;
+        }
+    }
+
+    status.PortChange.Usb20PortChange.ConnectStatusChange = PortSC.ConnectStatusChange;
+    status.PortChange.Usb20PortChange.PortEnableDisableChange = PortSC.PortEnableDisableChange;
+    status.PortChange.Usb20PortChange.OverCurrentIndicatorChange = PortSC.OverCurrentChange;
+    status.PortChange.Usb20PortChange.ResetChange = PortSC.PortResetChange |
+                                                    PortSC.WarmPortResetChange;
+    status.PortChange.Usb20PortChange.SuspendChange = PortSC.PortLinkStateChange;
+
+    *PortStatus = status;
+
+    if (status.PortStatus.Usb20PortStatus.CurrentConnectStatus)
+    {
+        DPRINT_RH("XHCI_RH_GetPortStatus: Port - %x, status.AsULONG - %X\n",
+                  Port,
+                  status.AsUlong32);
+    }
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetHubStatus(IN PVOID xhciExtension,
+                     IN PUSB_HUB_STATUS_AND_CHANGE HubStatus)
+{
+    DPRINT_RH("XHCI_RH_GetHubStatus: ... \n");
+    HubStatus->AsUlong32 = 0;
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortReset(IN PVOID xhciExtension,
+                            IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_SetFeaturePortReset: Port - %x\n", Port);
+
+    /* The xHC times the reset itself and sets PRC when it is done */
+    PortSC.AsULONG = 0;
+    PortSC.PortReset = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortPower(IN PVOID xhciExtension,
+                            IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT_RH("XHCI_RH_SetFeaturePortPower: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.PortPower = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortEnable(IN PVOID xhciExtension,
+                             IN USHORT Port)
+{
+    DPRINT_RH("XHCI_RH_SetFeaturePortEnable: Not supported\n");
+    ASSERT(Port != 0);
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortSuspend(IN PVOID xhciExtension,
+                              IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+
+    DPRINT("XHCI_RH_SetFeaturePortSuspend: Port - %x\n", Port);
+
+    XHCI_RH_WritePortSC(XhciExtension,
+                        Port,
+                        XHCI_RH_PortLinkState(XHCI_PORT_LINK_STATE_U3));
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortEnable(IN PVOID xhciExtension,
+                               IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_ClearFeaturePortEnable: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.PortEnabledDisabled = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortPower(IN PVOID xhciExtension,
+                              IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PULONG PortStatusReg;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_ClearFeaturePortPower: Port - %x\n", Port);
+
+    PortStatusReg = XHCI_RH_GetPortStatusReg(XhciExtension, Port);
+
+    PortSC.AsULONG = READ_REGISTER_ULONG(PortStatusReg) & XHCI_PORTSC_PRESERVE_MASK;
+    PortSC.PortPower = 0;
+
+    WRITE_REGISTER_ULONG(PortStatusReg, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+XHCI_RH_PortResumeComplete(IN PVOID xhciExtension,
+                           IN PVOID Context)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PUSHORT Port = Context;
+
+    DPRINT("XHCI_RH_PortResumeComplete: *Port - %x\n", *Port);
+
+    /* The resume signalling has lasted long enough, PLC is set once the port is in U0 */
+    XHCI_RH_WritePortSC(XhciExtension,
+                        *Port,
+                        XHCI_RH_PortLinkState(XHCI_PORT_LINK_STATE_U0));
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortSuspend(IN PVOID xhciExtension,
+                                IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+
+    DPRINT("XHCI_RH_ClearFeaturePortSuspend: Port - %x\n", Port);
+
+    if (XHCI_IS_SUPER_SPEED_PORT(XhciExtension, Port))
+    {
+        XHCI_RH_WritePortSC(XhciExtension,
+                            Port,
+                            XHCI_RH_PortLinkState(XHCI_PORT_LINK_STATE_U0));
+
+        return MP_STATUS_SUCCESS;
+    }
+
+    /* USB 2.0 ports drive resume signalling until software moves them to U0 */
+    XHCI_RH_WritePortSC(XhciExtension,
+                        Port,
+                        XHCI_RH_PortLinkState(XHCI_PORT_LINK_STATE_RESUME));
+
+    RegPacket.UsbPortRequestAsyncCallback(XhciExtension,
+                                          20, // TimerValue
+                                          &Port,
+                                          sizeof(Port),
+                                          XHCI_RH_PortResumeComplete);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortEnableChange(IN PVOID xhciExtension,
+                                     IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT_RH("XHCI_RH_ClearFeaturePortEnableChange: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.PortEnableDisableChange = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortConnectChange(IN PVOID xhciExtension,
+                                      IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT_RH("XHCI_RH_ClearFeaturePortConnectChange: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.ConnectStatusChange = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortResetChange(IN PVOID xhciExtension,
+                                    IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_ClearFeaturePortResetChange: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.PortResetChange = 1;
+    PortSC.WarmPortResetChange = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortSuspendChange(IN PVOID xhciExtension,
+                                      IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_ClearFeaturePortSuspendChange: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.PortLinkStateChange = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortOvercurrentChange(IN PVOID xhciExtension,
+                                          IN USHORT Port)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_PORT_STATUS_CONTROL PortSC;
+
+    DPRINT("XHCI_RH_ClearFeaturePortOvercurrentChange: Port - %x\n", Port);
+
+    PortSC.AsULONG = 0;
+    PortSC.OverCurrentChange = 1;
+
+    XHCI_RH_WritePortSC(XhciExtension, Port, PortSC.AsULONG);
+
+    return MP_STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+XHCI_RH_DisableIrq(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+
+    DPRINT_RH("XHCI_RH_DisableIrq: ... \n");
+
+    /* Port changes share the interrupter with the transfers, they are only masked here */
+    XhciExtension->Flags |= XHCI_FLAGS_RH_IRQ_DISABLED;
+}
+
+VOID
+NTAPI
+XHCI_RH_EnableIrq(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+
+    DPRINT_RH("XHCI_RH_EnableIrq: ... \n");
+
+    XhciExtension->Flags &= ~XHCI_FLAGS_RH_IRQ_DISABLED;
+}
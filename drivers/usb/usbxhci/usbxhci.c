@@ -0,0 +1,2592 @@
+/*
+ * PROJECT:     ReactOS USB xHCI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     USBXHCI main driver functions
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "usbxhci.h"
+
+#define NDEBUG
+#include <debug.h>
+
+#define NDEBUG_XHCI_TRACE
+#include "dbg_xhci.h"
+
+USBPORT_REGISTRATION_PACKET RegPacket;
+
+/* Contexts */
+
+PVOID
+NTAPI
+XHCI_GetInputContext(IN PXHCI_EXTENSION XhciExtension,
+                     IN ULONG Index)
+{
+    /* Index 0 is the Input Control Context, 1 is the Slot Context, DCI + 1 the endpoints */
+    return XhciExtension->HcResourcesVA->InputContext + Index * XhciExtension->ContextSize;
+}
+
+ULONG
+NTAPI
+XHCI_GetInputContextPA(IN PXHCI_EXTENSION XhciExtension)
+{
+    return XhciExtension->HcResourcesPA + FIELD_OFFSET(XHCI_HC_RESOURCES, InputContext);
+}
+
+PVOID
+NTAPI
+XHCI_GetDeviceContext(IN PXHCI_EXTENSION XhciExtension,
+                      IN ULONG SlotId,
+                      IN ULONG Dci)
+{
+    return XhciExtension->HcResourcesVA->DeviceContexts[SlotId - 1] + Dci * XhciExtension->ContextSize;
+}
+
+PXHCI_INPUT_CONTROL_CONTEXT
+NTAPI
+XHCI_PrepareInputContext(IN PXHCI_EXTENSION XhciExtension)
+{
+    RtlZeroMemory(XhciExtension->HcResourcesVA->InputContext, XHCI_INPUT_CONTEXT_SIZE);
+    return XHCI_GetInputContext(XhciExtension, 0);
+}
+
+VOID
+NTAPI
+XHCI_FillSlotContext(IN PXHCI_EXTENSION XhciExtension,
+                     IN PXHCI_ENDPOINT XhciEndpoint,
+                     IN PXHCI_SLOT_CONTEXT SlotContext,
+                     IN ULONG ContextEntries)
+{
+    PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+    ULONG Speed;
+    ULONG HubSlotId;
+
+    EndpointProperties = &XhciEndpoint->EndpointProperties;
+
+    switch (EndpointProperties->DeviceSpeed)
+    {
+        case UsbLowSpeed:
+            Speed = XHCI_PORT_SPEED_LOW;
+            break;
+
+        case UsbFullSpeed:
+            Speed = XHCI_PORT_SPEED_FULL;
+            break;
+
+        case UsbHighSpeed:
+            Speed = XHCI_PORT_SPEED_HIGH;
+            break;
+
+        default:
+            Speed = XHCI_PORT_SPEED_SUPER;
+            break;
+    }
+
+    SlotContext->RouteSpeedEntries = (EndpointProperties->RouteString & XHCI_SLOT_ROUTE_STRING_MASK) |
+                                     (Speed << XHCI_SLOT_SPEED_SHIFT) |
+                                     (ContextEntries << XHCI_SLOT_CONTEXT_ENTRIES_SHIFT);
+
+    SlotContext->RootPortNumber = EndpointProperties->RootPortNumber << XHCI_SLOT_ROOT_PORT_SHIFT;
+
+    /* Low and full speed devices behind a high speed hub go through its TT */
+    if ((Speed == XHCI_PORT_SPEED_LOW || Speed == XHCI_PORT_SPEED_FULL) &&
+        EndpointProperties->HubAddr < XHCI_MAX_USB_ADDRESSES)
+    {
+        HubSlotId = XhciExtension->AddressToSlot[EndpointProperties->HubAddr];
+
+        if (HubSlotId)
+        {
+            SlotContext->TtInfo = HubSlotId |
+                                  (EndpointProperties->PortNumber << XHCI_SLOT_TT_PORT_SHIFT);
+        }
+    }
+}
+
+VOID
+NTAPI
+XHCI_FillEndpointContext(IN PXHCI_ENDPOINT XhciEndpoint,
+                         IN PXHCI_ENDPOINT_CONTEXT EndpointContext,
+                         IN ULONG DequeuePA,
+                         IN ULONG DequeueCycle)
+{
+    PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+    ULONG TransferType;
+    ULONG EndpointType;
+    ULONG MaxPacketSize;
+    ULONG MaxBurst = 0;
+    ULONG Interval = 0;
+    ULONG AverageTrbLength;
+    ULONG MaxEsitPayload = 0;
+    BOOLEAN IsIn;
+
+    EndpointProperties = &XhciEndpoint->EndpointProperties;
+    TransferType = EndpointProperties->TransferType;
+    IsIn = (EndpointProperties->EndpointAddress & USB_ENDPOINT_DIRECTION_MASK) != 0;
+
+    if (TransferType == USBPORT_TRANSFER_TYPE_CONTROL)
+    {
+        /* USBPORT updates only the total size after it reads bMaxPacketSize0 */
+        MaxPacketSize = EndpointProperties->TotalMaxPacketSize;
+        EndpointType = XHCI_ENDPOINT_TYPE_CONTROL;
+        AverageTrbLength = 8;
+    }
+    else if (TransferType == USBPORT_TRANSFER_TYPE_BULK)
+    {
+        MaxPacketSize = EndpointProperties->MaxPacketSize;
+        EndpointType = IsIn ? XHCI_ENDPOINT_TYPE_BULK_IN : XHCI_ENDPOINT_TYPE_BULK_OUT;
+        AverageTrbLength = 3 * 1024;
+    }
+    else
+    {
+        MaxPacketSize = EndpointProperties->MaxPacketSize;
+        EndpointType = IsIn ? XHCI_ENDPOINT_TYPE_INT_IN : XHCI_ENDPOINT_TYPE_INT_OUT;
+        AverageTrbLength = 1024;
+        MaxEsitPayload = EndpointProperties->TotalMaxPacketSize;
+
+        if (EndpointProperties->DeviceSpeed == UsbHighSpeed)
+            MaxBurst = EndpointProperties->TransactionPerMicroframe - 1;
+
+        /* Period is in microframes for high and super speed, in frames otherwise */
+        while ((1UL << Interval) < EndpointProperties->Period)
+            Interval++;
+
+        if (EndpointProperties->DeviceSpeed == UsbLowSpeed ||
+            EndpointProperties->DeviceSpeed == UsbFullSpeed)
+        {
+            Interval += 3;
+        }
+    }
+
+    EndpointContext->StateInterval = Interval << XHCI_ENDPOINT_INTERVAL_SHIFT;
+
+    EndpointContext->TypeMaxPacket = (3 << XHCI_ENDPOINT_ERROR_COUNT_SHIFT) |
+                                     (EndpointType << XHCI_ENDPOINT_TYPE_SHIFT) |
+                                     (MaxBurst << XHCI_ENDPOINT_MAX_BURST_SHIFT) |
+                                     (MaxPacketSize << XHCI_ENDPOINT_MAX_PACKET_SHIFT);
+
+    EndpointContext->DequeuePointer[0] = DequeuePA | (DequeueCycle & XHCI_ENDPOINT_DEQUEUE_CYCLE);
+    EndpointContext->DequeuePointer[1] = 0;
+
+    EndpointContext->AverageTrbLength = AverageTrbLength | (MaxEsitPayload << 16);
+}
+
+/* Rings */
+
+VOID
+NTAPI
+XHCI_InitializeRing(IN PXHCI_RING Ring,
+                    IN PVOID RingVA,
+                    IN ULONG RingPA,
+                    IN ULONG Pages)
+{
+    PXHCI_TRB LinkTrb;
+    ULONG NextPage;
+    ULONG ix;
+
+    DPRINT_XHCI("XHCI_InitializeRing: RingVA - %p, RingPA - %lx, Pages - %x\n",
+                RingVA,
+                RingPA,
+                Pages);
+
+    RtlZeroMemory(RingVA, Pages * PAGE_SIZE);
+
+    Ring->FirstTrb = RingVA;
+    Ring->FirstTrbPA = RingPA;
+    Ring->NumberOfTrbs = Pages * XHCI_TRBS_PER_PAGE;
+    Ring->Enqueue = 0;
+    Ring->Cycle = 1;
+
+    /* The last TRB of each page links to the next page, the last page back to the first */
+    for (ix = 0; ix < Pages; ix++)
+    {
+        LinkTrb = &Ring->FirstTrb[(ix + 1) * XHCI_TRBS_PER_PAGE - 1];
+        NextPage = (ix + 1 == Pages) ? 0 : (ix + 1);
+
+        LinkTrb->Parameter[0] = RingPA + NextPage * PAGE_SIZE;
+        LinkTrb->Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_LINK);
+
+        if (ix + 1 == Pages)
+            LinkTrb->Control |= XHCI_TRB_TOGGLE_CYCLE;
+    }
+}
+
+ULONG
+NTAPI
+XHCI_QueueTrb(IN PXHCI_RING Ring,
+              IN ULONG Parameter0,
+              IN ULONG Parameter1,
+              IN ULONG Status,
+              IN ULONG Control,
+              IN BOOLEAN IsFirstTrb)
+{
+    PXHCI_TRB Trb;
+    PXHCI_TRB LinkTrb;
+    ULONG Index;
+
+    Index = Ring->Enqueue;
+    Trb = &Ring->FirstTrb[Index];
+
+    Trb->Parameter[0] = Parameter0;
+    Trb->Parameter[1] = Parameter1;
+    Trb->Status = Status;
+
+    /* The first TRB of a TD stays with software until the whole TD is written */
+    if (IsFirstTrb)
+        Trb->Control = Control | (Ring->Cycle ^ XHCI_TRB_CYCLE);
+    else
+        Trb->Control = Control | Ring->Cycle;
+
+    Ring->Enqueue = Index + 1;
+
+    if ((Ring->Enqueue % XHCI_TRBS_PER_PAGE) == (XHCI_TRBS_PER_PAGE - 1))
+    {
+        /* Hand the Link TRB over, it is part of the TD if the TD goes on */
+        LinkTrb = &Ring->FirstTrb[Ring->Enqueue];
+
+        LinkTrb->Control = (LinkTrb->Control & (XHCI_TRB_TYPE_MASK | XHCI_TRB_TOGGLE_CYCLE)) |
+                           (Control & XHCI_TRB_CHAIN) |
+                           Ring->Cycle;
+
+        if (LinkTrb->Control & XHCI_TRB_TOGGLE_CYCLE)
+            Ring->Cycle ^= XHCI_TRB_CYCLE;
+
+        Ring->Enqueue = (Ring->Enqueue + 1) % Ring->NumberOfTrbs;
+    }
+
+    return Index;
+}
+
+VOID
+NTAPI
+XHCI_CommitTrbs(IN PXHCI_RING Ring,
+                IN ULONG FirstTrb)
+{
+    /* Everything after the first TRB must be visible before the controller may fetch it */
+    KeMemoryBarrier();
+    Ring->FirstTrb[FirstTrb].Control ^= XHCI_TRB_CYCLE;
+}
+
+ULONG
+NTAPI
+XHCI_GetFreeTrbs(IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+    PXHCI_TRANSFER XhciTransfer;
+    PLIST_ENTRY Entry;
+
+    /* TRBs can be reused once the controller has moved past them, up to the oldest TD it still owns */
+    for (Entry = XhciEndpoint->TransferList.Flink;
+         Entry != &XhciEndpoint->TransferList;
+         Entry = Entry->Flink)
+    {
+        XhciTransfer = CONTAINING_RECORD(Entry, XHCI_TRANSFER, TransferLink);
+
+        if (XhciTransfer->TrbCount)
+        {
+            return (XhciTransfer->FirstTrb + Ring->NumberOfTrbs - Ring->Enqueue) %
+                   Ring->NumberOfTrbs;
+        }
+    }
+
+    return Ring->NumberOfTrbs;
+}
+
+VOID
+NTAPI
+XHCI_RingDoorbell(IN PXHCI_EXTENSION XhciExtension,
+                  IN ULONG SlotId,
+                  IN ULONG Target)
+{
+    WRITE_REGISTER_ULONG(&XhciExtension->DoorbellRegs[SlotId], Target);
+}
+
+/* Events and commands */
+
+USBD_STATUS
+NTAPI
+XHCI_GetUSBDStatus(IN ULONG CompletionCode)
+{
+    switch (CompletionCode)
+    {
+        case XHCI_COMPLETION_SUCCESS:
+        case XHCI_COMPLETION_SHORT_PACKET:
+            return USBD_STATUS_SUCCESS;
+
+        case XHCI_COMPLETION_STALL_ERROR:
+            return USBD_STATUS_STALL_PID;
+
+        case XHCI_COMPLETION_BABBLE_DETECTED:
+            return USBD_STATUS_BABBLE_DETECTED;
+
+        case XHCI_COMPLETION_DATA_BUFFER_ERROR:
+            return USBD_STATUS_DATA_BUFFER_ERROR;
+
+        case XHCI_COMPLETION_USB_TRANSACTION_ERROR:
+            return USBD_STATUS_XACT_ERROR;
+
+        default:
+            return USBD_STATUS_INTERNAL_HC_ERROR;
+    }
+}
+
+PXHCI_TRANSFER
+NTAPI
+XHCI_FindTransfer(IN PXHCI_ENDPOINT XhciEndpoint,
+                  IN ULONG TrbIndex)
+{
+    PXHCI_TRANSFER XhciTransfer;
+    PLIST_ENTRY Entry;
+    ULONG First;
+    ULONG Last;
+
+    for (Entry = XhciEndpoint->TransferList.Flink;
+         Entry != &XhciEndpoint->TransferList;
+         Entry = Entry->Flink)
+    {
+        XhciTransfer = CONTAINING_RECORD(Entry, XHCI_TRANSFER, TransferLink);
+
+        if (!XhciTransfer->TrbCount)
+            continue;
+
+        First = XhciTransfer->FirstTrb;
+        Last = XhciTransfer->LastTrb;
+
+        if (First <= Last)
+        {
+            if (TrbIndex >= First && TrbIndex <= Last)
+                return XhciTransfer;
+        }
+        else if (TrbIndex >= First || TrbIndex <= Last)
+        {
+            return XhciTransfer;
+        }
+    }
+
+    return NULL;
+}
+
+ULONG
+NTAPI
+XHCI_GetTransferredLength(IN PXHCI_RING Ring,
+                          IN PXHCI_TRANSFER XhciTransfer,
+                          IN ULONG TrbIndex,
+                          IN ULONG Residual)
+{
+    PXHCI_TRB Trb;
+    ULONG Type;
+    ULONG TrbLength;
+    ULONG Length = 0;
+    ULONG Index;
+
+    Index = XhciTransfer->FirstTrb;
+
+    while (TRUE)
+    {
+        Trb = &Ring->FirstTrb[Index];
+        Type = XHCI_TRB_GET_TYPE(Trb->Control);
+
+        if (Type == XHCI_TRB_TYPE_NORMAL || Type == XHCI_TRB_TYPE_DATA_STAGE)
+        {
+            TrbLength = Trb->Status & XHCI_TRB_LENGTH_MASK;
+
+            if (Index == TrbIndex)
+            {
+                if (Residual < TrbLength)
+                    Length += TrbLength - Residual;
+
+                break;
+            }
+
+            Length += TrbLength;
+        }
+
+        if (Index == TrbIndex || Index == XhciTransfer->LastTrb)
+            break;
+
+        Index = (Index + 1) % Ring->NumberOfTrbs;
+    }
+
+    return Length;
+}
+
+VOID
+NTAPI
+XHCI_ProcessTransferEvent(IN PXHCI_EXTENSION XhciExtension,
+                          IN PXHCI_TRB Event)
+{
+    PXHCI_ENDPOINT XhciEndpoint;
+    PXHCI_TRANSFER XhciTransfer;
+    PXHCI_ENDPOINT_CONTEXT EndpointContext;
+    PXHCI_RING Ring;
+    ULONG SlotId;
+    ULONG Dci;
+    ULONG CompletionCode;
+    ULONG Residual;
+    ULONG TrbPA;
+    ULONG TrbIndex;
+    ULONG TrbType;
+    ULONG BufferLength;
+    BOOLEAN IsHalted;
+
+    SlotId = XHCI_TRB_GET_SLOT_ID(Event->Control);
+    Dci = XHCI_TRB_GET_ENDPOINT_ID(Event->Control);
+    CompletionCode = XHCI_EVENT_GET_COMPLETION_CODE(Event->Status);
+    Residual = Event->Status & XHCI_EVENT_LENGTH_MASK;
+
+    DPRINT_XHCI("XHCI_ProcessTransferEvent: SlotId - %x, Dci - %x, CompletionCode - %x\n",
+                SlotId,
+                Dci,
+                CompletionCode);
+
+    if (SlotId == 0 || SlotId > XhciExtension->MaxSlots || Dci == 0)
+        return;
+
+    XhciEndpoint = XhciExtension->Slots[SlotId].Endpoints[Dci];
+
+    if (!XhciEndpoint)
+    {
+        DPRINT("XHCI_ProcessTransferEvent: No endpoint for SlotId - %x, Dci - %x\n",
+               SlotId,
+               Dci);
+        return;
+    }
+
+    /* Stop Endpoint reports where it stopped, the TD goes on when the ring is restarted */
+    if (CompletionCode == XHCI_COMPLETION_STOPPED ||
+        CompletionCode == XHCI_COMPLETION_STOPPED_LENGTH_INVALID ||
+        CompletionCode == XHCI_COMPLETION_STOPPED_SHORT_PACKET)
+    {
+        return;
+    }
+
+    Ring = &XhciEndpoint->TransferRing;
+    TrbPA = Event->Parameter[0];
+
+    if (Event->Parameter[1] != 0 ||
+        TrbPA < Ring->FirstTrbPA ||
+        TrbPA >= Ring->FirstTrbPA + Ring->NumberOfTrbs * sizeof(XHCI_TRB))
+    {
+        DPRINT1("XHCI_ProcessTransferEvent: TRB %lx is not on the ring, CompletionCode - %x\n",
+                TrbPA,
+                CompletionCode);
+        return;
+    }
+
+    TrbIndex = (TrbPA - Ring->FirstTrbPA) / sizeof(XHCI_TRB);
+
+    XhciTransfer = XHCI_FindTransfer(XhciEndpoint, TrbIndex);
+
+    /* Events for TRBs of aborted or already finished TDs are of no interest */
+    if (!XhciTransfer || (XhciTransfer->Flags & XHCI_TRANSFER_FLAG_DONE))
+        return;
+
+    TrbType = XHCI_TRB_GET_TYPE(Ring->FirstTrb[TrbIndex].Control);
+    BufferLength = XhciTransfer->TransferParameters->TransferBufferLength;
+
+    if (CompletionCode == XHCI_COMPLETION_SUCCESS ||
+        CompletionCode == XHCI_COMPLETION_SHORT_PACKET)
+    {
+        if (TrbType == XHCI_TRB_TYPE_STATUS_STAGE)
+        {
+            if (!(XhciTransfer->Flags & XHCI_TRANSFER_FLAG_SHORT))
+                XhciTransfer->TransferLen = BufferLength;
+        }
+        else if (TrbType == XHCI_TRB_TYPE_NORMAL || TrbType == XHCI_TRB_TYPE_DATA_STAGE)
+        {
+            XhciTransfer->TransferLen = XHCI_GetTransferredLength(Ring,
+                                                                  XhciTransfer,
+                                                                  TrbIndex,
+                                                                  Residual);
+
+            if (CompletionCode == XHCI_COMPLETION_SHORT_PACKET)
+                XhciTransfer->Flags |= XHCI_TRANSFER_FLAG_SHORT;
+
+            /* A short data stage is followed by the status stage */
+            if (XhciEndpoint->EndpointProperties.TransferType == USBPORT_TRANSFER_TYPE_CONTROL)
+                return;
+        }
+        else
+        {
+            return;
+        }
+
+        XhciTransfer->USBDStatus = USBD_STATUS_SUCCESS;
+    }
+    else
+    {
+        DPRINT1("XHCI_ProcessTransferEvent: SlotId - %x, Dci - %x, CompletionCode - %x\n",
+                SlotId,
+                Dci,
+                CompletionCode);
+
+        if (TrbType == XHCI_TRB_TYPE_NORMAL || TrbType == XHCI_TRB_TYPE_DATA_STAGE)
+        {
+            XhciTransfer->TransferLen = XHCI_GetTransferredLength(Ring,
+                                                                  XhciTransfer,
+                                                                  TrbIndex,
+                                                                  Residual);
+        }
+        else if (TrbType == XHCI_TRB_TYPE_STATUS_STAGE &&
+                 !(XhciTransfer->Flags & XHCI_TRANSFER_FLAG_SHORT))
+        {
+            XhciTransfer->TransferLen = BufferLength;
+        }
+
+        XhciTransfer->USBDStatus = XHCI_GetUSBDStatus(CompletionCode);
+
+        EndpointContext = XHCI_GetDeviceContext(XhciExtension, SlotId, Dci);
+
+        IsHalted = (EndpointContext->StateInterval & XHCI_ENDPOINT_STATE_MASK) ==
+                   XHCI_ENDPOINT_STATE_HALTED;
+
+        if (IsHalted ||
+            CompletionCode == XHCI_COMPLETION_STALL_ERROR ||
+            CompletionCode == XHCI_COMPLETION_BABBLE_DETECTED ||
+            CompletionCode == XHCI_COMPLETION_USB_TRANSACTION_ERROR)
+        {
+            XhciEndpoint->Flags |= XHCI_ENDPOINT_FLAG_HALTED;
+        }
+    }
+
+    XhciTransfer->Flags |= XHCI_TRANSFER_FLAG_DONE;
+    RegPacket.UsbPortInvalidateEndpoint(XhciExtension, XhciEndpoint);
+}
+
+VOID
+NTAPI
+XHCI_ProcessEventRing(IN PXHCI_EXTENSION XhciExtension)
+{
+    PXHCI_HC_RESOURCES HcResourcesVA;
+    PXHCI_INTERRUPTER_REGISTERS Interrupter;
+    PXHCI_TRB Event;
+    ULONG Type;
+    ULONG DequeuePA;
+
+    HcResourcesVA = XhciExtension->HcResourcesVA;
+
+    while (TRUE)
+    {
+        Event = &HcResourcesVA->EventRing[XhciExtension->EventDequeue];
+
+        if ((Event->Control & XHCI_TRB_CYCLE) != XhciExtension->EventCycle)
+            break;
+
+        /* Read the event only after its cycle bit */
+        KeMemoryBarrier();
+
+        Type = XHCI_TRB_GET_TYPE(Event->Control);
+
+        switch (Type)
+        {
+            case XHCI_TRB_TYPE_TRANSFER_EVENT:
+                XHCI_ProcessTransferEvent(XhciExtension, Event);
+                break;
+
+            case XHCI_TRB_TYPE_COMMAND_COMPLETION:
+                if (Event->Parameter[0] == XhciExtension->CommandTrbPA &&
+                    !XhciExtension->CommandDone)
+                {
+                    XhciExtension->CommandCompletionCode = XHCI_EVENT_GET_COMPLETION_CODE(Event->Status);
+                    XhciExtension->CommandSlotId = XHCI_TRB_GET_SLOT_ID(Event->Control);
+                    XhciExtension->CommandDone = TRUE;
+                }
+                break;
+
+            case XHCI_TRB_TYPE_PORT_STATUS_CHANGE:
+                /* Port changes are picked up through USBSTS.PCD */
+                DPRINT_XHCI("XHCI_ProcessEventRing: Port - %x changed\n",
+                            Event->Parameter[0] >> 24);
+                break;
+
+            case XHCI_TRB_TYPE_HOST_CONTROLLER_EVENT:
+                DPRINT1("XHCI_ProcessEventRing: Host controller event - %x\n",
+                        XHCI_EVENT_GET_COMPLETION_CODE(Event->Status));
+                break;
+
+            default:
+                DPRINT_XHCI("XHCI_ProcessEventRing: Event type - %x\n", Type);
+                break;
+        }
+
+        XhciExtension->EventDequeue++;
+
+        if (XhciExtension->EventDequeue == XHCI_TRBS_PER_PAGE)
+        {
+            XhciExtension->EventDequeue = 0;
+            XhciExtension->EventCycle ^= XHCI_TRB_CYCLE;
+        }
+    }
+
+    /* Always clear the Event Handler Busy flag, an interrupt may have set it after the last update */
+    DequeuePA = XhciExtension->HcResourcesPA +
+                FIELD_OFFSET(XHCI_HC_RESOURCES, EventRing) +
+                XhciExtension->EventDequeue * sizeof(XHCI_TRB);
+
+    Interrupter = &XhciExtension->RuntimeRegs->Interrupter[0];
+
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingDequeuePointer[0],
+                         DequeuePA | XHCI_ERDP_EVENT_HANDLER_BUSY);
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingDequeuePointer[1], 0);
+}
+
+ULONG
+NTAPI
+XHCI_SendCommand(IN PXHCI_EXTENSION XhciExtension,
+                 IN ULONG Parameter,
+                 IN ULONG Control,
+                 OUT PULONG SlotId)
+{
+    PXHCI_RING Ring = &XhciExtension->CommandRing;
+    ULONG Index;
+    ULONG ix;
+
+    DPRINT_XHCI("XHCI_SendCommand: Parameter - %lx, Control - %lx\n", Parameter, Control);
+
+    /* Commands are synchronous, the ring never holds more than one */
+    Index = XHCI_QueueTrb(Ring, Parameter, 0, 0, Control, TRUE);
+
+    XhciExtension->CommandTrbPA = Ring->FirstTrbPA + Index * sizeof(XHCI_TRB);
+    XhciExtension->CommandDone = FALSE;
+
+    XHCI_CommitTrbs(Ring, Index);
+    XHCI_RingDoorbell(XhciExtension, 0, 0);
+
+    for (ix = 0; ix < XHCI_COMMAND_TIMEOUT; ix += 10)
+    {
+        XHCI_ProcessEventRing(XhciExtension);
+
+        if (XhciExtension->CommandDone)
+            break;
+
+        KeStallExecutionProcessor(10);
+    }
+
+    if (!XhciExtension->CommandDone)
+    {
+        DPRINT1("XHCI_SendCommand: Command %lx timed out\n", Control);
+        return 0;
+    }
+
+    if (SlotId)
+        *SlotId = XhciExtension->CommandSlotId;
+
+    if (XhciExtension->CommandCompletionCode != XHCI_COMPLETION_SUCCESS)
+    {
+        DPRINT("XHCI_SendCommand: Control - %lx, CompletionCode - %x\n",
+               Control,
+               XhciExtension->CommandCompletionCode);
+    }
+
+    return XhciExtension->CommandCompletionCode;
+}
+
+VOID
+NTAPI
+XHCI_StopEndpoint(IN PXHCI_EXTENSION XhciExtension,
+                  IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    /* Fails with a context state error if the endpoint is not running, that is fine */
+    XHCI_SendCommand(XhciExtension,
+                     0,
+                     XHCI_TRB_TYPE(XHCI_TRB_TYPE_STOP_ENDPOINT) |
+                     XHCI_TRB_ENDPOINT_ID(XhciEndpoint->Dci) |
+                     XHCI_TRB_SLOT_ID(XhciEndpoint->SlotId),
+                     NULL);
+}
+
+VOID
+NTAPI
+XHCI_MoveDequeue(IN PXHCI_EXTENSION XhciExtension,
+                 IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+    PXHCI_TRANSFER XhciTransfer;
+    PLIST_ENTRY Entry;
+    ULONG Index;
+    ULONG Cycle;
+
+    /* Point the controller at the oldest TD it still has to run, or at the enqueue pointer */
+    Index = Ring->Enqueue;
+    Cycle = Ring->Cycle;
+
+    for (Entry = XhciEndpoint->TransferList.Flink;
+         Entry != &XhciEndpoint->TransferList;
+         Entry = Entry->Flink)
+    {
+        XhciTransfer = CONTAINING_RECORD(Entry, XHCI_TRANSFER, TransferLink);
+
+        if (XhciTransfer->TrbCount && !(XhciTransfer->Flags & XHCI_TRANSFER_FLAG_DONE))
+        {
+            Index = XhciTransfer->FirstTrb;
+            Cycle = Ring->FirstTrb[Index].Control & XHCI_TRB_CYCLE;
+            break;
+        }
+    }
+
+    DPRINT_XHCI("XHCI_MoveDequeue: XhciEndpoint - %p, Index - %x, Cycle - %x\n",
+                XhciEndpoint,
+                Index,
+                Cycle);
+
+    XHCI_SendCommand(XhciExtension,
+                     (Ring->FirstTrbPA + Index * sizeof(XHCI_TRB)) | Cycle,
+                     XHCI_TRB_TYPE(XHCI_TRB_TYPE_SET_TR_DEQUEUE) |
+                     XHCI_TRB_ENDPOINT_ID(XhciEndpoint->Dci) |
+                     XHCI_TRB_SLOT_ID(XhciEndpoint->SlotId),
+                     NULL);
+}
+
+VOID
+NTAPI
+XHCI_ResetEndpoint(IN PXHCI_EXTENSION XhciExtension,
+                   IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    DPRINT("XHCI_ResetEndpoint: XhciEndpoint - %p\n", XhciEndpoint);
+
+    /* Clears the halt and the data toggle or sequence number, the endpoint ends up stopped */
+    XHCI_SendCommand(XhciExtension,
+                     0,
+                     XHCI_TRB_TYPE(XHCI_TRB_TYPE_RESET_ENDPOINT) |
+                     XHCI_TRB_ENDPOINT_ID(XhciEndpoint->Dci) |
+                     XHCI_TRB_SLOT_ID(XhciEndpoint->SlotId),
+                     NULL);
+
+    /* Skip the failed TD */
+    XHCI_MoveDequeue(XhciExtension, XhciEndpoint);
+
+    XhciEndpoint->Flags &= ~XHCI_ENDPOINT_FLAG_HALTED;
+
+    if (!(XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_STOPPED) &&
+        !IsListEmpty(&XhciEndpoint->TransferList))
+    {
+        XHCI_RingDoorbell(XhciExtension, XhciEndpoint->SlotId, XhciEndpoint->Dci);
+    }
+}
+
+VOID
+NTAPI
+XHCI_DisableSlot(IN PXHCI_EXTENSION XhciExtension,
+                 IN ULONG SlotId)
+{
+    PXHCI_DEVICE_SLOT Slot = &XhciExtension->Slots[SlotId];
+
+    DPRINT("XHCI_DisableSlot: SlotId - %x, DeviceAddress - %x\n",
+           SlotId,
+           Slot->DeviceAddress);
+
+    XHCI_SendCommand(XhciExtension,
+                     0,
+                     XHCI_TRB_TYPE(XHCI_TRB_TYPE_DISABLE_SLOT) | XHCI_TRB_SLOT_ID(SlotId),
+                     NULL);
+
+    XhciExtension->HcResourcesVA->DeviceContextBaseArray[SlotId] = 0;
+
+    if (XhciExtension->AddressToSlot[Slot->DeviceAddress] == SlotId)
+        XhciExtension->AddressToSlot[Slot->DeviceAddress] = 0;
+
+    RtlZeroMemory(Slot, sizeof(XHCI_DEVICE_SLOT));
+}
+
+/* Endpoints */
+
+MPSTATUS
+NTAPI
+XHCI_OpenDefaultEndpoint(IN PXHCI_EXTENSION XhciExtension,
+                         IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+    PXHCI_INPUT_CONTROL_CONTEXT ControlContext;
+    PXHCI_DEVICE_SLOT Slot;
+    PXHCI_RING Ring;
+    ULONG SlotId;
+    ULONG CompletionCode;
+
+    EndpointProperties = &XhciEndpoint->EndpointProperties;
+    Ring = &XhciEndpoint->TransferRing;
+
+    if (EndpointProperties->DeviceAddress == 0)
+    {
+        /* A new device. It gets a slot and stays in the Default state until SET_ADDRESS */
+        CompletionCode = XHCI_SendCommand(XhciExtension,
+                                          0,
+                                          XHCI_TRB_TYPE(XHCI_TRB_TYPE_ENABLE_SLOT),
+                                          &SlotId);
+
+        if (CompletionCode != XHCI_COMPLETION_SUCCESS ||
+            SlotId == 0 ||
+            SlotId > XhciExtension->MaxSlots)
+        {
+            DPRINT1("XHCI_OpenDefaultEndpoint: No slot, CompletionCode - %x\n", CompletionCode);
+            return MP_STATUS_NO_RESOURCES;
+        }
+
+        Slot = &XhciExtension->Slots[SlotId];
+        RtlZeroMemory(Slot, sizeof(XHCI_DEVICE_SLOT));
+        Slot->Flags = XHCI_SLOT_FLAG_ENABLED;
+
+        RtlZeroMemory(XhciExtension->HcResourcesVA->DeviceContexts[SlotId - 1],
+                      XHCI_DEVICE_CONTEXT_SIZE);
+
+        XhciExtension->HcResourcesVA->DeviceContextBaseArray[SlotId] =
+            XhciExtension->HcResourcesPA +
+            FIELD_OFFSET(XHCI_HC_RESOURCES, DeviceContexts) +
+            (SlotId - 1) * XHCI_DEVICE_CONTEXT_SIZE;
+
+        XhciEndpoint->SlotId = SlotId;
+
+        ControlContext = XHCI_PrepareInputContext(XhciExtension);
+        ControlContext->AddFlags = 3; // Slot Context and the default control endpoint
+
+        XHCI_FillSlotContext(XhciExtension,
+                             XhciEndpoint,
+                             XHCI_GetInputContext(XhciExtension, 1),
+                             1);
+
+        XHCI_FillEndpointContext(XhciEndpoint,
+                                 XHCI_GetInputContext(XhciExtension, 2),
+                                 Ring->FirstTrbPA,
+                                 Ring->Cycle);
+
+        CompletionCode = XHCI_SendCommand(XhciExtension,
+                                          XHCI_GetInputContextPA(XhciExtension),
+                                          XHCI_TRB_TYPE(XHCI_TRB_TYPE_ADDRESS_DEVICE) |
+                                          XHCI_TRB_BLOCK_SET_ADDRESS |
+                                          XHCI_TRB_SLOT_ID(SlotId),
+                                          NULL);
+
+        if (CompletionCode != XHCI_COMPLETION_SUCCESS)
+        {
+            DPRINT1("XHCI_OpenDefaultEndpoint: Address Device failed - %x\n", CompletionCode);
+            XHCI_DisableSlot(XhciExtension, SlotId);
+            return MP_STATUS_ERROR;
+        }
+
+        XhciExtension->AddressToSlot[0] = SlotId;
+    }
+    else
+    {
+        if (EndpointProperties->DeviceAddress >= XHCI_MAX_USB_ADDRESSES)
+            return MP_STATUS_ERROR;
+
+        SlotId = XhciExtension->AddressToSlot[EndpointProperties->DeviceAddress];
+
+        if (!SlotId)
+        {
+            DPRINT1("XHCI_OpenDefaultEndpoint: No slot for address %x\n",
+                    EndpointProperties->DeviceAddress);
+            return MP_STATUS_ERROR;
+        }
+
+        Slot = &XhciExtension->Slots[SlotId];
+        XhciEndpoint->SlotId = SlotId;
+
+        /* USBPORT reopens the default pipe on a new ring after SET_ADDRESS */
+        XHCI_StopEndpoint(XhciExtension, XhciEndpoint);
+
+        CompletionCode = XHCI_SendCommand(XhciExtension,
+                                          Ring->FirstTrbPA | Ring->Cycle,
+                                          XHCI_TRB_TYPE(XHCI_TRB_TYPE_SET_TR_DEQUEUE) |
+                                          XHCI_TRB_ENDPOINT_ID(1) |
+                                          XHCI_TRB_SLOT_ID(SlotId),
+                                          NULL);
+
+        if (CompletionCode != XHCI_COMPLETION_SUCCESS)
+        {
+            DPRINT1("XHCI_OpenDefaultEndpoint: Set TR Dequeue failed - %x\n", CompletionCode);
+            return MP_STATUS_ERROR;
+        }
+
+        /* The real bMaxPacketSize0 is known by now */
+        ControlContext = XHCI_PrepareInputContext(XhciExtension);
+        ControlContext->AddFlags = 2;
+
+        XHCI_FillEndpointContext(XhciEndpoint,
+                                 XHCI_GetInputContext(XhciExtension, 2),
+                                 Ring->FirstTrbPA,
+                                 Ring->Cycle);
+
+        CompletionCode = XHCI_SendCommand(XhciExtension,
+                                          XHCI_GetInputContextPA(XhciExtension),
+                                          XHCI_TRB_TYPE(XHCI_TRB_TYPE_EVALUATE_CONTEXT) |
+                                          XHCI_TRB_SLOT_ID(SlotId),
+                                          NULL);
+
+        if (CompletionCode != XHCI_COMPLETION_SUCCESS)
+        {
+            DPRINT1("XHCI_OpenDefaultEndpoint: Evaluate Context failed - %x\n", CompletionCode);
+            return MP_STATUS_ERROR;
+        }
+    }
+
+    Slot->Endpoints[1] = XhciEndpoint;
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_ConfigureEndpoint(IN PXHCI_EXTENSION XhciExtension,
+                       IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+    PXHCI_INPUT_CONTROL_CONTEXT ControlContext;
+    PXHCI_SLOT_CONTEXT SlotContext;
+    PXHCI_ENDPOINT_CONTEXT DeviceEndpointContext;
+    PXHCI_RING Ring;
+    ULONG SlotId;
+    ULONG Dci;
+    ULONG ContextEntries;
+    ULONG CompletionCode;
+
+    EndpointProperties = &XhciEndpoint->EndpointProperties;
+    Ring = &XhciEndpoint->TransferRing;
+    Dci = XhciEndpoint->Dci;
+
+    if (EndpointProperties->DeviceAddress >= XHCI_MAX_USB_ADDRESSES)
+        return MP_STATUS_ERROR;
+
+    SlotId = XhciExtension->AddressToSlot[EndpointProperties->DeviceAddress];
+
+    if (!SlotId)
+    {
+        DPRINT1("XHCI_ConfigureEndpoint: No slot for address %x\n",
+                EndpointProperties->DeviceAddress);
+        return MP_STATUS_ERROR;
+    }
+
+    XhciEndpoint->SlotId = SlotId;
+
+    ControlContext = XHCI_PrepareInputContext(XhciExtension);
+    ControlContext->AddFlags = (1 << Dci) | 1;
+
+    /* An endpoint that is still enabled (a reopen) is dropped and added again */
+    DeviceEndpointContext = XHCI_GetDeviceContext(XhciExtension, SlotId, Dci);
+
+    if (DeviceEndpointContext->StateInterval & XHCI_ENDPOINT_STATE_MASK)
+        ControlContext->DropFlags = 1 << Dci;
+
+    SlotContext = XHCI_GetInputContext(XhciExtension, 1);
+
+    RtlCopyMemory(SlotContext,
+                  XHCI_GetDeviceContext(XhciExtension, SlotId, 0),
+                  sizeof(XHCI_SLOT_CONTEXT));
+
+    SlotContext->DeviceState = 0;
+
+    ContextEntries = SlotContext->RouteSpeedEntries >> XHCI_SLOT_CONTEXT_ENTRIES_SHIFT;
+
+    if (Dci > ContextEntries)
+    {
+        SlotContext->RouteSpeedEntries &= ~(0x1F << XHCI_SLOT_CONTEXT_ENTRIES_SHIFT);
+        SlotContext->RouteSpeedEntries |= Dci << XHCI_SLOT_CONTEXT_ENTRIES_SHIFT;
+    }
+
+    XHCI_FillEndpointContext(XhciEndpoint,
+                             XHCI_GetInputContext(XhciExtension, Dci + 1),
+                             Ring->FirstTrbPA,
+                             Ring->Cycle);
+
+    CompletionCode = XHCI_SendCommand(XhciExtension,
+                                      XHCI_GetInputContextPA(XhciExtension),
+                                      XHCI_TRB_TYPE(XHCI_TRB_TYPE_CONFIGURE_ENDPOINT) |
+                                      XHCI_TRB_SLOT_ID(SlotId),
+                                      NULL);
+
+    if (CompletionCode != XHCI_COMPLETION_SUCCESS)
+    {
+        DPRINT1("XHCI_ConfigureEndpoint: Configure Endpoint failed - %x\n", CompletionCode);
+        return MP_STATUS_NO_BANDWIDTH;
+    }
+
+    XhciExtension->Slots[SlotId].Endpoints[Dci] = XhciEndpoint;
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_InitializeEndpoint(IN PXHCI_EXTENSION XhciExtension,
+                        IN PXHCI_ENDPOINT XhciEndpoint)
+{
+    PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+    ULONG Pages;
+
+    EndpointProperties = &XhciEndpoint->EndpointProperties;
+
+    switch (EndpointProperties->TransferType)
+    {
+        case USBPORT_TRANSFER_TYPE_CONTROL:
+            Pages = XHCI_CONTROL_RING_PAGES;
+            break;
+
+        case USBPORT_TRANSFER_TYPE_BULK:
+            Pages = XHCI_BULK_RING_PAGES;
+            break;
+
+        case USBPORT_TRANSFER_TYPE_INTERRUPT:
+            Pages = XHCI_INTERRUPT_RING_PAGES;
+            break;
+
+        default:
+            DPRINT1("XHCI_InitializeEndpoint: Isochronous endpoints are not supported\n");
+            return MP_STATUS_NOT_SUPPORTED;
+    }
+
+    Pages = min(Pages, EndpointProperties->BufferLength / PAGE_SIZE);
+
+    XhciEndpoint->Flags = 0;
+    XhciEndpoint->SlotId = 0;
+    XhciEndpoint->Dci = XHCI_DCI(EndpointProperties->EndpointAddress);
+    InitializeListHead(&XhciEndpoint->TransferList);
+
+    XHCI_InitializeRing(&XhciEndpoint->TransferRing,
+                        (PVOID)EndpointProperties->BufferVA,
+                        EndpointProperties->BufferPA,
+                        Pages);
+
+    if (XhciEndpoint->Dci == 1)
+        return XHCI_OpenDefaultEndpoint(XhciExtension, XhciEndpoint);
+
+    return XHCI_ConfigureEndpoint(XhciExtension, XhciEndpoint);
+}
+
+MPSTATUS
+NTAPI
+XHCI_OpenEndpoint(IN PVOID xhciExtension,
+                  IN PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties,
+                  IN PVOID xhciEndpoint)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+
+    DPRINT("XHCI_OpenEndpoint: DeviceAddress - %x, EndpointAddress - %x, TransferType - %x\n",
+           EndpointProperties->DeviceAddress,
+           EndpointProperties->EndpointAddress,
+           EndpointProperties->TransferType);
+
+    RtlCopyMemory(&XhciEndpoint->EndpointProperties,
+                  EndpointProperties,
+                  sizeof(XhciEndpoint->EndpointProperties));
+
+    return XHCI_InitializeEndpoint(XhciExtension, XhciEndpoint);
+}
+
+MPSTATUS
+NTAPI
+XHCI_ReopenEndpoint(IN PVOID xhciExtension,
+                    IN PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties,
+                    IN PVOID xhciEndpoint)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+    PXHCI_DEVICE_SLOT Slot;
+
+    DPRINT("XHCI_ReopenEndpoint: DeviceAddress - %x, EndpointAddress - %x\n",
+           EndpointProperties->DeviceAddress,
+           EndpointProperties->EndpointAddress);
+
+    /* The endpoint may move to another slot, the device was reset */
+    if (XhciEndpoint->SlotId)
+    {
+        Slot = &XhciExtension->Slots[XhciEndpoint->SlotId];
+
+        if (Slot->Endpoints[XhciEndpoint->Dci] == XhciEndpoint)
+            Slot->Endpoints[XhciEndpoint->Dci] = NULL;
+    }
+
+    RtlCopyMemory(&XhciEndpoint->EndpointProperties,
+                  EndpointProperties,
+                  sizeof(XhciEndpoint->EndpointProperties));
+
+    return XHCI_InitializeEndpoint(XhciExtension, XhciEndpoint);
+}
+
+VOID
+NTAPI
+XHCI_QueryEndpointRequirements(IN PVOID xhciExtension,
+                               IN PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties,
+                               IN PUSBPORT_ENDPOINT_REQUIREMENTS EndpointRequirements)
+{
+    DPRINT("XHCI_QueryEndpointRequirements: TransferType - %x\n",
+           EndpointProperties->TransferType);
+
+    /* The header buffer holds the transfer ring */
+    switch (EndpointProperties->TransferType)
+    {
+        case USBPORT_TRANSFER_TYPE_CONTROL:
+            EndpointRequirements->HeaderBufferSize = XHCI_CONTROL_RING_PAGES * PAGE_SIZE;
+            EndpointRequirements->MaxTransferSize = XHCI_MAX_CONTROL_TRANSFER_SIZE;
+            break;
+
+        case USBPORT_TRANSFER_TYPE_BULK:
+            EndpointRequirements->HeaderBufferSize = XHCI_BULK_RING_PAGES * PAGE_SIZE;
+            EndpointRequirements->MaxTransferSize = XHCI_MAX_BULK_TRANSFER_SIZE;
+            break;
+
+        case USBPORT_TRANSFER_TYPE_INTERRUPT:
+            EndpointRequirements->HeaderBufferSize = XHCI_INTERRUPT_RING_PAGES * PAGE_SIZE;
+            EndpointRequirements->MaxTransferSize = XHCI_MAX_INTERRUPT_TRANSFER_SIZE;
+            break;
+
+        default:
+            EndpointRequirements->HeaderBufferSize = PAGE_SIZE;
+            EndpointRequirements->MaxTransferSize = XHCI_MAX_INTERRUPT_TRANSFER_SIZE;
+            break;
+    }
+}
+
+VOID
+NTAPI
+XHCI_CloseEndpoint(IN PVOID xhciExtension,
+                   IN PVOID xhciEndpoint,
+                   IN BOOLEAN DisablePeriodic)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+    PXHCI_INPUT_CONTROL_CONTEXT ControlContext;
+    PXHCI_SLOT_CONTEXT SlotContext;
+    PXHCI_DEVICE_SLOT Slot;
+    ULONG SlotId;
+    ULONG Dci;
+
+    SlotId = XhciEndpoint->SlotId;
+    Dci = XhciEndpoint->Dci;
+
+    DPRINT("XHCI_CloseEndpoint: SlotId - %x, Dci - %x\n", SlotId, Dci);
+
+    if (!SlotId)
+        return;
+
+    Slot = &XhciExtension->Slots[SlotId];
+
+    /* The slot may be gone already, or reused for another device */
+    if (Slot->Endpoints[Dci] != XhciEndpoint)
+        return;
+
+    Slot->Endpoints[Dci] = NULL;
+
+    if (Dci == 1)
+    {
+        /* After SET_ADDRESS the default pipe is reopened on the same slot */
+        if ((Slot->Flags & XHCI_SLOT_FLAG_ADDRESSED) &&
+            Slot->DeviceAddress != XhciEndpoint->EndpointProperties.DeviceAddress)
+        {
+            return;
+        }
+
+        XHCI_DisableSlot(XhciExtension, SlotId);
+        return;
+    }
+
+    ControlContext = XHCI_PrepareInputContext(XhciExtension);
+    ControlContext->DropFlags = 1 << Dci;
+    ControlContext->AddFlags = 1;
+
+    SlotContext = XHCI_GetInputContext(XhciExtension, 1);
+
+    RtlCopyMemory(SlotContext,
+                  XHCI_GetDeviceContext(XhciExtension, SlotId, 0),
+                  sizeof(XHCI_SLOT_CONTEXT));
+
+    SlotContext->DeviceState = 0;
+
+    XHCI_SendCommand(XhciExtension,
+                     XHCI_GetInputContextPA(XhciExtension),
+                     XHCI_TRB_TYPE(XHCI_TRB_TYPE_CONFIGURE_ENDPOINT) |
+                     XHCI_TRB_SLOT_ID(SlotId),
+                     NULL);
+}
+
+/* Controller */
+
+VOID
+NTAPI
+XHCI_TakeControlHC(IN PXHCI_EXTENSION XhciExtension)
+{
+    XHCI_HC_CAPABILITY_PARAMS_1 CapParameters;
+    XHCI_LEGACY_SUPPORT_CAPABILITY LegacyCapability;
+    XHCI_EXTENDED_CAPABILITY Capability;
+    LARGE_INTEGER EndTime;
+    LARGE_INTEGER CurrentTime;
+    PULONG CapabilityReg;
+    ULONG LegacyControl;
+    ULONG Offset;
+
+    CapParameters.AsULONG = READ_REGISTER_ULONG(&XhciExtension->CapabilityRegisters->CapParameters1.AsULONG);
+    Offset = CapParameters.ExtCapabilitiesPointer;
+
+    while (Offset)
+    {
+        CapabilityReg = (PULONG)XhciExtension->BaseAddress + Offset;
+        Capability.AsULONG = READ_REGISTER_ULONG(CapabilityReg);
+
+        if (Capability.CapabilityID == XHCI_EXT_CAP_ID_LEGACY_SUPPORT)
+        {
+            LegacyCapability.AsULONG = Capability.AsULONG;
+
+            if (LegacyCapability.BiosOwnedSemaphore)
+            {
+                DPRINT("XHCI_TakeControlHC: Requesting ownership from the BIOS\n");
+
+                WRITE_REGISTER_UCHAR((PUCHAR)CapabilityReg + 3, 1); // OS Owned Semaphore
+
+                KeQuerySystemTime(&EndTime);
+                EndTime.QuadPart += 1000 * 10000; // 1 sec
+
+                do
+                {
+                    RegPacket.UsbPortWait(XhciExtension, 10);
+
+                    LegacyCapability.AsULONG = READ_REGISTER_ULONG(CapabilityReg);
+                    KeQuerySystemTime(&CurrentTime);
+                }
+                while (LegacyCapability.BiosOwnedSemaphore &&
+                       CurrentTime.QuadPart <= EndTime.QuadPart);
+
+                if (LegacyCapability.BiosOwnedSemaphore)
+                    DPRINT1("XHCI_TakeControlHC: The BIOS did not release the controller\n");
+            }
+
+            /* No more SMIs, and clear the pending ones */
+            LegacyControl = READ_REGISTER_ULONG(CapabilityReg + 1);
+            LegacyControl &= ~XHCI_LEGACY_SMI_ENABLE_MASK;
+            LegacyControl |= XHCI_LEGACY_SMI_EVENTS_MASK;
+            WRITE_REGISTER_ULONG(CapabilityReg + 1, LegacyControl);
+        }
+
+        if (!Capability.NextCapabilityPointer)
+            break;
+
+        Offset += Capability.NextCapabilityPointer;
+    }
+}
+
+VOID
+NTAPI
+XHCI_GetSuperSpeedPorts(IN PXHCI_EXTENSION XhciExtension)
+{
+    XHCI_HC_CAPABILITY_PARAMS_1 CapParameters;
+    XHCI_SUPPORTED_PROTOCOL_CAPABILITY Protocol;
+    XHCI_SUPPORTED_PROTOCOL_PORTS Ports;
+    PULONG CapabilityReg;
+    ULONG Offset;
+    ULONG Port;
+
+    RtlZeroMemory(XhciExtension->SuperSpeedPorts, sizeof(XhciExtension->SuperSpeedPorts));
+
+    CapParameters.AsULONG = READ_REGISTER_ULONG(&XhciExtension->CapabilityRegisters->CapParameters1.AsULONG);
+    Offset = CapParameters.ExtCapabilitiesPointer;
+
+    while (Offset)
+    {
+        CapabilityReg = (PULONG)XhciExtension->BaseAddress + Offset;
+        Protocol.AsULONG = READ_REGISTER_ULONG(CapabilityReg);
+
+        if (Protocol.CapabilityID == XHCI_EXT_CAP_ID_SUPPORTED_PROTOCOL &&
+            Protocol.MajorRevision >= 3)
+        {
+            Ports.AsULONG = READ_REGISTER_ULONG(CapabilityReg + 2);
+
+            DPRINT("XHCI_GetSuperSpeedPorts: USB %x.%x ports %x - %x\n",
+                   Protocol.MajorRevision,
+                   Protocol.MinorRevision >> 4,
+                   Ports.CompatiblePortOffset,
+                   Ports.CompatiblePortOffset + Ports.CompatiblePortCount - 1);
+
+            for (Port = Ports.CompatiblePortOffset;
+                 Port < Ports.CompatiblePortOffset + Ports.CompatiblePortCount &&
+                 Port <= XhciExtension->NumberOfPorts;
+                 Port++)
+            {
+                XhciExtension->SuperSpeedPorts[(Port - 1) / 32] |= 1 << ((Port - 1) % 32);
+            }
+        }
+
+        if (!Protocol.NextCapabilityPointer)
+            break;
+
+        Offset += Protocol.NextCapabilityPointer;
+    }
+}
+
+MPSTATUS
+NTAPI
+XHCI_WaitHalted(IN PXHCI_EXTENSION XhciExtension,
+                IN BOOLEAN Halted)
+{
+    XHCI_USB_STATUS Status;
+    ULONG ix;
+
+    for (ix = 0; ix < XHCI_HALT_TIMEOUT; ix += 100)
+    {
+        Status.AsULONG = READ_REGISTER_ULONG(&XhciExtension->OperationalRegs->HcStatus.AsULONG);
+
+        if (Status.HCHalted == Halted)
+            return MP_STATUS_SUCCESS;
+
+        KeStallExecutionProcessor(100);
+    }
+
+    DPRINT1("XHCI_WaitHalted: Halted - %x, Status - %lx\n", Halted, Status.AsULONG);
+    return MP_STATUS_HW_ERROR;
+}
+
+MPSTATUS
+NTAPI
+XHCI_InitializeHardware(IN PXHCI_EXTENSION XhciExtension)
+{
+    PXHCI_HC_CAPABILITY_REGISTERS CapabilityRegisters;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_HC_STRUCTURAL_PARAMS_1 StructParams1;
+    XHCI_HC_STRUCTURAL_PARAMS_2 StructParams2;
+    XHCI_HC_CAPABILITY_PARAMS_1 CapParameters;
+    XHCI_USB_COMMAND Command;
+    XHCI_USB_STATUS Status;
+    LARGE_INTEGER EndTime;
+    LARGE_INTEGER CurrentTime;
+    MPSTATUS MPStatus;
+
+    DPRINT("XHCI_InitializeHardware: ... \n");
+
+    CapabilityRegisters = XhciExtension->CapabilityRegisters;
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    /* The controller must be halted before it can be reset */
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.Run = 0;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    MPStatus = XHCI_WaitHalted(XhciExtension, TRUE);
+
+    if (MPStatus)
+        return MPStatus;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.Reset = 1;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    KeQuerySystemTime(&EndTime);
+    EndTime.QuadPart += 1000 * 10000; // 1 sec
+
+    while (TRUE)
+    {
+        RegPacket.UsbPortWait(XhciExtension, 1);
+
+        KeQuerySystemTime(&CurrentTime);
+        Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+        Status.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcStatus.AsULONG);
+
+        if (!Command.Reset && !Status.ControllerNotReady)
+            break;
+
+        if (CurrentTime.QuadPart >= EndTime.QuadPart)
+        {
+            DPRINT1("XHCI_InitializeHardware: Reset failed!\n");
+            return MP_STATUS_HW_ERROR;
+        }
+    }
+
+    DPRINT("XHCI_InitializeHardware: Reset - OK\n");
+
+    StructParams1.AsULONG = READ_REGISTER_ULONG(&CapabilityRegisters->StructParameters1.AsULONG);
+    StructParams2.AsULONG = READ_REGISTER_ULONG(&CapabilityRegisters->StructParameters2.AsULONG);
+    CapParameters.AsULONG = READ_REGISTER_ULONG(&CapabilityRegisters->CapParameters1.AsULONG);
+
+    XhciExtension->NumberOfPorts = StructParams1.MaxPorts;
+    XhciExtension->MaxSlots = min(StructParams1.MaxDeviceSlots, XHCI_MAX_DEVICE_SLOTS);
+    XhciExtension->ScratchpadBuffers = (StructParams2.MaxScratchpadBuffersHi << 5) |
+                                       StructParams2.MaxScratchpadBuffersLo;
+    XhciExtension->ContextSize = CapParameters.ContextSize ? 64 : 32;
+    XhciExtension->PortPowerControl = CapParameters.PortPowerControl;
+
+    DPRINT("XHCI_InitializeHardware: Ports - %x, Slots - %x, Scratchpads - %x, ContextSize - %x\n",
+           XhciExtension->NumberOfPorts,
+           XhciExtension->MaxSlots,
+           XhciExtension->ScratchpadBuffers,
+           XhciExtension->ContextSize);
+
+    if (!(READ_REGISTER_ULONG(&OperationalRegs->PageSize) & 1))
+    {
+        DPRINT1("XHCI_InitializeHardware: 4K pages are not supported\n");
+        return MP_STATUS_HW_ERROR;
+    }
+
+    if (XhciExtension->ScratchpadBuffers > XHCI_MAX_SCRATCHPAD_BUFFERS)
+    {
+        DPRINT1("XHCI_InitializeHardware: Too many scratchpad buffers - %x\n",
+                XhciExtension->ScratchpadBuffers);
+        return MP_STATUS_NO_RESOURCES;
+    }
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_InitializeSchedule(IN PXHCI_EXTENSION XhciExtension,
+                        IN ULONG_PTR StartVA,
+                        IN ULONG StartPA)
+{
+    PXHCI_HW_REGISTERS OperationalRegs;
+    PXHCI_INTERRUPTER_REGISTERS Interrupter;
+    PXHCI_HC_RESOURCES HcResourcesVA;
+    ULONG HcResourcesPA;
+    ULONG Configure;
+    ULONG ix;
+
+    DPRINT("XHCI_InitializeSchedule: StartVA - %p, StartPA - %lx\n", StartVA, StartPA);
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    HcResourcesVA = (PXHCI_HC_RESOURCES)StartVA;
+    HcResourcesPA = StartPA;
+
+    XhciExtension->HcResourcesVA = HcResourcesVA;
+    XhciExtension->HcResourcesPA = HcResourcesPA;
+
+    RtlZeroMemory(HcResourcesVA, sizeof(XHCI_HC_RESOURCES));
+    RtlZeroMemory(XhciExtension->Slots, sizeof(XhciExtension->Slots));
+    RtlZeroMemory(XhciExtension->AddressToSlot, sizeof(XhciExtension->AddressToSlot));
+
+    /* Device contexts */
+    for (ix = 0; ix < XhciExtension->ScratchpadBuffers; ix++)
+    {
+        HcResourcesVA->ScratchpadArray[ix] = HcResourcesPA +
+                                             FIELD_OFFSET(XHCI_HC_RESOURCES, ScratchpadBuffers) +
+                                             ix * PAGE_SIZE;
+    }
+
+    if (XhciExtension->ScratchpadBuffers)
+    {
+        HcResourcesVA->DeviceContextBaseArray[0] = HcResourcesPA +
+                                                   FIELD_OFFSET(XHCI_HC_RESOURCES, ScratchpadArray);
+    }
+
+    Configure = READ_REGISTER_ULONG(&OperationalRegs->Configure);
+    Configure = (Configure & ~0xFF) | XhciExtension->MaxSlots;
+    WRITE_REGISTER_ULONG(&OperationalRegs->Configure, Configure);
+
+    WRITE_REGISTER_ULONG(&OperationalRegs->DeviceContextBaseArray[0],
+                         HcResourcesPA + FIELD_OFFSET(XHCI_HC_RESOURCES, DeviceContextBaseArray));
+    WRITE_REGISTER_ULONG(&OperationalRegs->DeviceContextBaseArray[1], 0);
+
+    /* Command ring */
+    XHCI_InitializeRing(&XhciExtension->CommandRing,
+                        HcResourcesVA->CommandRing,
+                        HcResourcesPA + FIELD_OFFSET(XHCI_HC_RESOURCES, CommandRing),
+                        1);
+
+    WRITE_REGISTER_ULONG(&OperationalRegs->CommandRingControl[0],
+                         XhciExtension->CommandRing.FirstTrbPA | XHCI_CRCR_RING_CYCLE_STATE);
+    WRITE_REGISTER_ULONG(&OperationalRegs->CommandRingControl[1], 0);
+
+    /* Event ring of the primary interrupter, a single segment */
+    XhciExtension->EventDequeue = 0;
+    XhciExtension->EventCycle = XHCI_TRB_CYCLE;
+
+    HcResourcesVA->EventRingSegmentTable.RingSegmentBase[0] = HcResourcesPA +
+                                                              FIELD_OFFSET(XHCI_HC_RESOURCES, EventRing);
+    HcResourcesVA->EventRingSegmentTable.RingSegmentSize = XHCI_TRBS_PER_PAGE;
+
+    Interrupter = &XhciExtension->RuntimeRegs->Interrupter[0];
+
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingSegmentTableSize, 1);
+
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingDequeuePointer[0],
+                         HcResourcesPA + FIELD_OFFSET(XHCI_HC_RESOURCES, EventRing));
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingDequeuePointer[1], 0);
+
+    /* Writing the table base enables the event ring */
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingSegmentTableBase[0],
+                         HcResourcesPA + FIELD_OFFSET(XHCI_HC_RESOURCES, EventRingSegmentTable));
+    WRITE_REGISTER_ULONG(&Interrupter->EventRingSegmentTableBase[1], 0);
+
+    /* Several completions within the moderation interval share one interrupt */
+    WRITE_REGISTER_ULONG(&Interrupter->InterrupterModeration, XHCI_INTERRUPT_MODERATION);
+
+    WRITE_REGISTER_ULONG(&Interrupter->InterrupterManagement,
+                         XHCI_IMAN_INTERRUPT_PENDING | XHCI_IMAN_INTERRUPT_ENABLE);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_StartController(IN PVOID xhciExtension,
+                     IN PUSBPORT_RESOURCES Resources)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HC_CAPABILITY_REGISTERS CapabilityRegisters;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+    MPSTATUS MPStatus;
+    UCHAR CapabilityRegLength;
+    USHORT Port;
+
+    DPRINT("XHCI_StartController: ... \n");
+
+    if ((Resources->ResourcesTypes & (USBPORT_RESOURCES_MEMORY | USBPORT_RESOURCES_INTERRUPT)) !=
+                                     (USBPORT_RESOURCES_MEMORY | USBPORT_RESOURCES_INTERRUPT))
+    {
+        DPRINT1("XHCI_StartController: Resources->ResourcesTypes - %x\n",
+                Resources->ResourcesTypes);
+
+        return MP_STATUS_ERROR;
+    }
+
+    XhciExtension->BaseAddress = Resources->ResourceBase;
+
+    CapabilityRegisters = (PXHCI_HC_CAPABILITY_REGISTERS)Resources->ResourceBase;
+    XhciExtension->CapabilityRegisters = CapabilityRegisters;
+
+    CapabilityRegLength = READ_REGISTER_UCHAR(&CapabilityRegisters->RegistersLength);
+
+    OperationalRegs = (PXHCI_HW_REGISTERS)(XhciExtension->BaseAddress + CapabilityRegLength);
+    XhciExtension->OperationalRegs = OperationalRegs;
+
+    XhciExtension->RuntimeRegs = (PXHCI_RUNTIME_REGISTERS)(XhciExtension->BaseAddress +
+        (READ_REGISTER_ULONG(&CapabilityRegisters->RuntimeRegistersOffset) & ~0x1F));
+
+    XhciExtension->DoorbellRegs = (PULONG)(XhciExtension->BaseAddress +
+        (READ_REGISTER_ULONG(&CapabilityRegisters->DoorbellOffset) & ~0x3));
+
+    DPRINT("XHCI_StartController: CapabilityRegisters - %p\n", CapabilityRegisters);
+    DPRINT("XHCI_StartController: OperationalRegs     - %p\n", OperationalRegs);
+    DPRINT("XHCI_StartController: RuntimeRegs         - %p\n", XhciExtension->RuntimeRegs);
+    DPRINT("XHCI_StartController: DoorbellRegs        - %p\n", XhciExtension->DoorbellRegs);
+
+    XHCI_TakeControlHC(XhciExtension);
+
+    MPStatus = XHCI_InitializeHardware(XhciExtension);
+
+    if (MPStatus)
+    {
+        DPRINT1("XHCI_StartController: Unsuccessful InitializeHardware()\n");
+        return MPStatus;
+    }
+
+    XHCI_GetSuperSpeedPorts(XhciExtension);
+
+    MPStatus = XHCI_InitializeSchedule(XhciExtension,
+                                       Resources->StartVA,
+                                       Resources->StartPA);
+
+    if (MPStatus)
+    {
+        DPRINT1("XHCI_StartController: Unsuccessful InitializeSchedule()\n");
+        return MPStatus;
+    }
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.HostSystemErrorEnable = 1;
+    Command.Run = 1;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    MPStatus = XHCI_WaitHalted(XhciExtension, FALSE);
+
+    if (MPStatus)
+    {
+        DPRINT1("XHCI_StartController: The controller does not run\n");
+        return MPStatus;
+    }
+
+    XhciExtension->IsStarted = TRUE;
+
+    if (XhciExtension->PortPowerControl)
+    {
+        for (Port = 1; Port <= XhciExtension->NumberOfPorts; Port++)
+        {
+            XHCI_RH_SetFeaturePortPower(XhciExtension, Port);
+        }
+
+        RegPacket.UsbPortWait(XhciExtension, 20);
+    }
+
+    return MP_STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+XHCI_StopController(IN PVOID xhciExtension,
+                    IN BOOLEAN DisableInterrupts)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+
+    DPRINT("XHCI_StopController: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.Run = 0;
+    Command.InterrupterEnable = 0;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    XHCI_WaitHalted(XhciExtension, TRUE);
+
+    XhciExtension->IsStarted = FALSE;
+}
+
+VOID
+NTAPI
+XHCI_SuspendController(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+
+    DPRINT("XHCI_SuspendController: ... \n");
+
+    /* The controller keeps its state as long as it keeps its power, nothing is saved */
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.Run = 0;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    XHCI_WaitHalted(XhciExtension, TRUE);
+
+    XhciExtension->Flags |= XHCI_FLAGS_CONTROLLER_SUSPEND;
+}
+
+MPSTATUS
+NTAPI
+XHCI_ResumeController(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+
+    DPRINT("XHCI_ResumeController: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.Run = 1;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+
+    XhciExtension->Flags &= ~XHCI_FLAGS_CONTROLLER_SUSPEND;
+
+    return XHCI_WaitHalted(XhciExtension, FALSE);
+}
+
+BOOLEAN
+NTAPI
+XHCI_InterruptService(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    PXHCI_INTERRUPTER_REGISTERS Interrupter;
+    XHCI_USB_STATUS Status;
+    ULONG Management;
+
+    DPRINT_XHCI("XHCI_InterruptService: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Status.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcStatus.AsULONG);
+
+    /* The controller is gone */
+    if (Status.AsULONG == 0xFFFFFFFF)
+        return FALSE;
+
+    Status.AsULONG &= XHCI_USB_STATUS_RW1C_MASK;
+
+    if (!Status.AsULONG)
+        return FALSE;
+
+    /* Clear USBSTS.EINT before IMAN.IP */
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcStatus.AsULONG, Status.AsULONG);
+
+    Interrupter = &XhciExtension->RuntimeRegs->Interrupter[0];
+    Management = READ_REGISTER_ULONG(&Interrupter->InterrupterManagement);
+
+    if (Management & XHCI_IMAN_INTERRUPT_PENDING)
+        WRITE_REGISTER_ULONG(&Interrupter->InterrupterManagement, Management);
+
+    if (Status.HostSystemError)
+        DPRINT1("XHCI_InterruptService: Host System Error\n");
+
+    /* The events themselves are processed under the miniport lock, in PollEndpoint */
+    InterlockedOr((PLONG)&XhciExtension->InterruptStatus.AsULONG, Status.AsULONG);
+
+    return TRUE;
+}
+
+VOID
+NTAPI
+XHCI_InterruptDpc(IN PVOID xhciExtension,
+                  IN BOOLEAN EnableInterrupts)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    XHCI_USB_STATUS iStatus;
+
+    iStatus.AsULONG = InterlockedExchange((PLONG)&XhciExtension->InterruptStatus.AsULONG, 0);
+
+    DPRINT_XHCI("XHCI_InterruptDpc: [%p] InterruptStatus - %X, EnableInterrupts - %x\n",
+                XhciExtension,
+                iStatus.AsULONG,
+                EnableInterrupts);
+
+    if (iStatus.EventInterrupt)
+        RegPacket.UsbPortInvalidateEndpoint(XhciExtension, NULL);
+
+    if (iStatus.PortChangeDetect &&
+        !(XhciExtension->Flags & XHCI_FLAGS_RH_IRQ_DISABLED))
+    {
+        RegPacket.UsbPortInvalidateRootHub(XhciExtension);
+    }
+}
+
+/* Transfers */
+
+VOID
+NTAPI
+XHCI_StartTransfer(IN PXHCI_EXTENSION XhciExtension,
+                   IN PXHCI_ENDPOINT XhciEndpoint,
+                   IN PXHCI_TRANSFER XhciTransfer,
+                   IN ULONG FirstTrb,
+                   IN ULONG LastTrb)
+{
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+
+    XhciTransfer->FirstTrb = FirstTrb;
+    XhciTransfer->LastTrb = LastTrb;
+    XhciTransfer->TrbCount = (Ring->Enqueue + Ring->NumberOfTrbs - FirstTrb) % Ring->NumberOfTrbs;
+
+    InsertTailList(&XhciEndpoint->TransferList, &XhciTransfer->TransferLink);
+
+    XHCI_CommitTrbs(Ring, FirstTrb);
+
+    if (!(XhciEndpoint->Flags & (XHCI_ENDPOINT_FLAG_STOPPED | XHCI_ENDPOINT_FLAG_HALTED)))
+        XHCI_RingDoorbell(XhciExtension, XhciEndpoint->SlotId, XhciEndpoint->Dci);
+}
+
+ULONG
+NTAPI
+XHCI_GetTdSize(IN ULONG Remaining,
+               IN ULONG MaxPacketSize)
+{
+    ULONG Packets;
+
+    /* Packets left in the TD after this TRB */
+    if (!MaxPacketSize)
+        return 0;
+
+    Packets = (Remaining + MaxPacketSize - 1) / MaxPacketSize;
+
+    return min(Packets, XHCI_TRB_TD_SIZE_MAX);
+}
+
+MPSTATUS
+NTAPI
+XHCI_SetAddress(IN PXHCI_EXTENSION XhciExtension,
+                IN PXHCI_ENDPOINT XhciEndpoint,
+                IN PXHCI_TRANSFER XhciTransfer)
+{
+    PUSB_DEFAULT_PIPE_SETUP_PACKET SetupPacket;
+    PXHCI_INPUT_CONTROL_CONTEXT ControlContext;
+    PXHCI_DEVICE_SLOT Slot;
+    PXHCI_RING Ring;
+    ULONG SlotId;
+    ULONG CompletionCode;
+    USHORT DeviceAddress;
+
+    SetupPacket = &XhciTransfer->TransferParameters->SetupPacket;
+    DeviceAddress = SetupPacket->wValue.W;
+    SlotId = XhciEndpoint->SlotId;
+    Slot = &XhciExtension->Slots[SlotId];
+    Ring = &XhciEndpoint->TransferRing;
+
+    DPRINT("XHCI_SetAddress: SlotId - %x, DeviceAddress - %x\n", SlotId, DeviceAddress);
+
+    /*
+     * The xHC assigns bus addresses itself, SET_ADDRESS must not reach the
+     * device. Address Device sends it instead, and USBPORT's address is only
+     * used to find the slot from now on.
+     */
+    if (DeviceAddress == 0 || DeviceAddress >= XHCI_MAX_USB_ADDRESSES)
+    {
+        XhciTransfer->USBDStatus = USBD_STATUS_INVALID_PARAMETER;
+    }
+    else
+    {
+        ControlContext = XHCI_PrepareInputContext(XhciExtension);
+        ControlContext->AddFlags = 3;
+
+        XHCI_FillSlotContext(XhciExtension,
+                             XhciEndpoint,
+                             XHCI_GetInputContext(XhciExtension, 1),
+                             1);
+
+        /* Address Device reloads the ring pointer of the default control endpoint */
+        XHCI_FillEndpointContext(XhciEndpoint,
+                                 XHCI_GetInputContext(XhciExtension, 2),
+                                 Ring->FirstTrbPA + Ring->Enqueue * sizeof(XHCI_TRB),
+                                 Ring->Cycle);
+
+        CompletionCode = XHCI_SendCommand(XhciExtension,
+                                          XHCI_GetInputContextPA(XhciExtension),
+                                          XHCI_TRB_TYPE(XHCI_TRB_TYPE_ADDRESS_DEVICE) |
+                                          XHCI_TRB_SLOT_ID(SlotId),
+                                          NULL);
+
+        if (CompletionCode == XHCI_COMPLETION_SUCCESS)
+        {
+            Slot->Flags |= XHCI_SLOT_FLAG_ADDRESSED;
+            Slot->DeviceAddress = DeviceAddress;
+
+            XhciExtension->AddressToSlot[DeviceAddress] = SlotId;
+
+            if (XhciExtension->AddressToSlot[0] == SlotId)
+                XhciExtension->AddressToSlot[0] = 0;
+        }
+        else
+        {
+            DPRINT1("XHCI_SetAddress: Address Device failed - %x\n", CompletionCode);
+            XhciTransfer->USBDStatus = USBD_STATUS_DEV_NOT_RESPONDING;
+        }
+    }
+
+    /* Nothing goes on the ring, the transfer completes with the next poll */
+    XhciTransfer->TrbCount = 0;
+    XhciTransfer->Flags |= XHCI_TRANSFER_FLAG_DONE;
+    InsertTailList(&XhciEndpoint->TransferList, &XhciTransfer->TransferLink);
+
+    RegPacket.UsbPortInvalidateEndpoint(XhciExtension, XhciEndpoint);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_ControlTransfer(IN PXHCI_EXTENSION XhciExtension,
+                     IN PXHCI_ENDPOINT XhciEndpoint,
+                     IN PUSBPORT_TRANSFER_PARAMETERS TransferParameters,
+                     IN PXHCI_TRANSFER XhciTransfer,
+                     IN PUSBPORT_SCATTER_GATHER_LIST SgList)
+{
+    PUSB_DEFAULT_PIPE_SETUP_PACKET SetupPacket;
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+    PUSBPORT_SCATTER_GATHER_ELEMENT SgElement;
+    ULONG Setup[2];
+    ULONG MaxPacketSize;
+    ULONG DataLength;
+    ULONG Remaining;
+    ULONG Control;
+    ULONG FirstTrb;
+    ULONG LastTrb;
+    ULONG Needed;
+    ULONG ix;
+    BOOLEAN IsIn;
+
+    SetupPacket = &TransferParameters->SetupPacket;
+
+    if (SetupPacket->bRequest == USB_REQUEST_SET_ADDRESS &&
+        SetupPacket->bmRequestType.B == 0)
+    {
+        return XHCI_SetAddress(XhciExtension, XhciEndpoint, XhciTransfer);
+    }
+
+    DataLength = TransferParameters->TransferBufferLength;
+    Needed = 2 + (DataLength ? SgList->SgElementCount : 0) +
+             Ring->NumberOfTrbs / XHCI_TRBS_PER_PAGE;
+
+    if (Needed >= XHCI_GetFreeTrbs(XhciEndpoint))
+        return MP_STATUS_FAILURE;
+
+    IsIn = (TransferParameters->TransferFlags & USBD_TRANSFER_DIRECTION_IN) != 0;
+    MaxPacketSize = XhciEndpoint->EndpointProperties.TotalMaxPacketSize;
+
+    /* Setup stage, the packet itself goes in the TRB */
+    RtlCopyMemory(Setup, SetupPacket, sizeof(Setup));
+
+    Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_SETUP_STAGE) | XHCI_TRB_IMMEDIATE_DATA;
+
+    if (DataLength == 0)
+        Control |= XHCI_TRB_TRANSFER_TYPE_NO_DATA;
+    else if (IsIn)
+        Control |= XHCI_TRB_TRANSFER_TYPE_IN;
+    else
+        Control |= XHCI_TRB_TRANSFER_TYPE_OUT;
+
+    FirstTrb = XHCI_QueueTrb(Ring, Setup[0], Setup[1], sizeof(Setup), Control, TRUE);
+
+    /* Data stage, a Data Stage TRB chained to Normal TRBs */
+    if (DataLength)
+    {
+        Remaining = DataLength;
+
+        for (ix = 0; ix < SgList->SgElementCount; ix++)
+        {
+            SgElement = &SgList->SgElement[ix];
+            Remaining -= SgElement->SgTransferLength;
+
+            if (ix == 0)
+            {
+                Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_DATA_STAGE);
+
+                if (IsIn)
+                    Control |= XHCI_TRB_DIRECTION_IN;
+            }
+            else
+            {
+                Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_NORMAL);
+            }
+
+            Control |= XHCI_TRB_INTERRUPT_ON_SHORT;
+
+            if (ix + 1 < SgList->SgElementCount)
+                Control |= XHCI_TRB_CHAIN;
+
+            XHCI_QueueTrb(Ring,
+                          SgElement->SgPhysicalAddress.LowPart,
+                          SgElement->SgPhysicalAddress.HighPart,
+                          SgElement->SgTransferLength |
+                          XHCI_TRB_TD_SIZE(XHCI_GetTdSize(Remaining, MaxPacketSize)),
+                          Control,
+                          FALSE);
+        }
+    }
+
+    /* Status stage, in the opposite direction of the data */
+    Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_STATUS_STAGE) | XHCI_TRB_INTERRUPT_ON_COMPLETION;
+
+    if (DataLength == 0 || !IsIn)
+        Control |= XHCI_TRB_DIRECTION_IN;
+
+    LastTrb = XHCI_QueueTrb(Ring, 0, 0, 0, Control, FALSE);
+
+    XHCI_StartTransfer(XhciExtension, XhciEndpoint, XhciTransfer, FirstTrb, LastTrb);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_BulkOrInterruptTransfer(IN PXHCI_EXTENSION XhciExtension,
+                             IN PXHCI_ENDPOINT XhciEndpoint,
+                             IN PUSBPORT_TRANSFER_PARAMETERS TransferParameters,
+                             IN PXHCI_TRANSFER XhciTransfer,
+                             IN PUSBPORT_SCATTER_GATHER_LIST SgList)
+{
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+    PUSBPORT_SCATTER_GATHER_ELEMENT SgElement;
+    ULONG MaxPacketSize;
+    ULONG Remaining;
+    ULONG Control;
+    ULONG FirstTrb;
+    ULONG LastTrb;
+    ULONG Needed;
+    ULONG ix;
+
+    Needed = max(SgList->SgElementCount, 1) + Ring->NumberOfTrbs / XHCI_TRBS_PER_PAGE;
+
+    if (Needed >= XHCI_GetFreeTrbs(XhciEndpoint))
+    {
+        DPRINT_XHCI("XHCI_BulkOrInterruptTransfer: Ring is full\n");
+        return MP_STATUS_FAILURE;
+    }
+
+    if (TransferParameters->TransferBufferLength == 0 || SgList->SgElementCount == 0)
+    {
+        FirstTrb = XHCI_QueueTrb(Ring,
+                                 0,
+                                 0,
+                                 0,
+                                 XHCI_TRB_TYPE(XHCI_TRB_TYPE_NORMAL) |
+                                 XHCI_TRB_INTERRUPT_ON_COMPLETION,
+                                 TRUE);
+
+        XHCI_StartTransfer(XhciExtension, XhciEndpoint, XhciTransfer, FirstTrb, FirstTrb);
+        return MP_STATUS_SUCCESS;
+    }
+
+    /*
+     * One Normal TRB per page, all chained into one TD. A short packet
+     * anywhere ends the TD and reports the TRB it happened on.
+     */
+    MaxPacketSize = XhciEndpoint->EndpointProperties.MaxPacketSize;
+    Remaining = TransferParameters->TransferBufferLength;
+    FirstTrb = LastTrb = Ring->Enqueue;
+
+    for (ix = 0; ix < SgList->SgElementCount; ix++)
+    {
+        SgElement = &SgList->SgElement[ix];
+        Remaining -= SgElement->SgTransferLength;
+
+        Control = XHCI_TRB_TYPE(XHCI_TRB_TYPE_NORMAL) | XHCI_TRB_INTERRUPT_ON_SHORT;
+
+        if (ix + 1 < SgList->SgElementCount)
+            Control |= XHCI_TRB_CHAIN;
+        else
+            Control |= XHCI_TRB_INTERRUPT_ON_COMPLETION;
+
+        LastTrb = XHCI_QueueTrb(Ring,
+                                SgElement->SgPhysicalAddress.LowPart,
+                                SgElement->SgPhysicalAddress.HighPart,
+                                SgElement->SgTransferLength |
+                                XHCI_TRB_TD_SIZE(XHCI_GetTdSize(Remaining, MaxPacketSize)),
+                                Control,
+                                ix == 0);
+    }
+
+    XHCI_StartTransfer(XhciExtension, XhciEndpoint, XhciTransfer, FirstTrb, LastTrb);
+
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_SubmitTransfer(IN PVOID xhciExtension,
+                    IN PVOID xhciEndpoint,
+                    IN PUSBPORT_TRANSFER_PARAMETERS TransferParameters,
+                    IN PVOID xhciTransfer,
+                    IN PUSBPORT_SCATTER_GATHER_LIST SgList)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+    PXHCI_TRANSFER XhciTransfer = xhciTransfer;
+
+    DPRINT_XHCI("XHCI_SubmitTransfer: XhciEndpoint - %p, TransferBufferLength - %x, SgElementCount - %x\n",
+                XhciEndpoint,
+                TransferParameters->TransferBufferLength,
+                SgList->SgElementCount);
+
+    RtlZeroMemory(XhciTransfer, sizeof(XHCI_TRANSFER));
+
+    XhciTransfer->TransferParameters = TransferParameters;
+    XhciTransfer->XhciEndpoint = XhciEndpoint;
+    XhciTransfer->USBDStatus = USBD_STATUS_SUCCESS;
+
+    switch (XhciEndpoint->EndpointProperties.TransferType)
+    {
+        case USBPORT_TRANSFER_TYPE_CONTROL:
+            return XHCI_ControlTransfer(XhciExtension,
+                                        XhciEndpoint,
+                                        TransferParameters,
+                                        XhciTransfer,
+                                        SgList);
+
+        case USBPORT_TRANSFER_TYPE_BULK:
+        case USBPORT_TRANSFER_TYPE_INTERRUPT:
+            return XHCI_BulkOrInterruptTransfer(XhciExtension,
+                                                XhciEndpoint,
+                                                TransferParameters,
+                                                XhciTransfer,
+                                                SgList);
+
+        default:
+            DPRINT1("XHCI_SubmitTransfer: Unsupported TransferType - %x\n",
+                    XhciEndpoint->EndpointProperties.TransferType);
+            return MP_STATUS_NOT_SUPPORTED;
+    }
+}
+
+MPSTATUS
+NTAPI
+XHCI_SubmitIsoTransfer(IN PVOID xhciExtension,
+                       IN PVOID xhciEndpoint,
+                       IN PUSBPORT_TRANSFER_PARAMETERS TransferParameters,
+                       IN PVOID xhciTransfer,
+                       IN PVOID isoParameters)
+{
+    DPRINT1("XHCI_SubmitIsoTransfer: UNIMPLEMENTED. FIXME\n");
+    return MP_STATUS_NOT_SUPPORTED;
+}
+
+VOID
+NTAPI
+XHCI_AbortTransfer(IN PVOID xhciExtension,
+                   IN PVOID xhciEndpoint,
+                   IN PVOID xhciTransfer,
+                   IN PULONG CompletedLength)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+    PXHCI_TRANSFER XhciTransfer = xhciTransfer;
+    PXHCI_RING Ring = &XhciEndpoint->TransferRing;
+    PXHCI_TRB Trb;
+    ULONG Index;
+
+    DPRINT("XHCI_AbortTransfer: XhciEndpoint - %p, XhciTransfer - %p\n",
+           XhciEndpoint,
+           XhciTransfer);
+
+    if (!(XhciEndpoint->Flags & (XHCI_ENDPOINT_FLAG_STOPPED | XHCI_ENDPOINT_FLAG_HALTED)))
+    {
+        XHCI_StopEndpoint(XhciExtension, XhciEndpoint);
+        XhciEndpoint->Flags |= XHCI_ENDPOINT_FLAG_STOPPED;
+    }
+
+    /* A TD in the middle of the ring is skipped as No Ops */
+    if (XhciTransfer->TrbCount && !(XhciTransfer->Flags & XHCI_TRANSFER_FLAG_DONE))
+    {
+        Index = XhciTransfer->FirstTrb;
+
+        while (TRUE)
+        {
+            Trb = &Ring->FirstTrb[Index];
+
+            if (XHCI_TRB_GET_TYPE(Trb->Control) != XHCI_TRB_TYPE_LINK)
+            {
+                Trb->Control = (Trb->Control & (XHCI_TRB_CYCLE | XHCI_TRB_CHAIN)) |
+                               XHCI_TRB_TYPE(XHCI_TRB_TYPE_NOOP);
+            }
+
+            if (Index == XhciTransfer->LastTrb)
+                break;
+
+            Index = (Index + 1) % Ring->NumberOfTrbs;
+        }
+    }
+
+    RemoveEntryList(&XhciTransfer->TransferLink);
+
+    /* A TD at the head is skipped by moving the dequeue pointer, a halted ring moves on reset */
+    if (!(XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_HALTED))
+        XHCI_MoveDequeue(XhciExtension, XhciEndpoint);
+
+    *CompletedLength = XhciTransfer->TransferLen;
+}
+
+ULONG
+NTAPI
+XHCI_GetEndpointState(IN PVOID xhciExtension,
+                      IN PVOID xhciEndpoint)
+{
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+
+    DPRINT("XHCI_GetEndpointState: ... \n");
+
+    if (XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_STOPPED)
+        return USBPORT_ENDPOINT_PAUSED;
+
+    return USBPORT_ENDPOINT_ACTIVE;
+}
+
+VOID
+NTAPI
+XHCI_SetEndpointState(IN PVOID xhciExtension,
+                      IN PVOID xhciEndpoint,
+                      IN ULONG EndpointState)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+
+    DPRINT("XHCI_SetEndpointState: XhciEndpoint - %p, EndpointState - %x\n",
+           XhciEndpoint,
+           EndpointState);
+
+    if (!XhciEndpoint->SlotId)
+        return;
+
+    switch (EndpointState)
+    {
+        case USBPORT_ENDPOINT_PAUSED:
+            if (!(XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_STOPPED))
+            {
+                XHCI_StopEndpoint(XhciExtension, XhciEndpoint);
+                XhciEndpoint->Flags |= XHCI_ENDPOINT_FLAG_STOPPED;
+            }
+            break;
+
+        case USBPORT_ENDPOINT_ACTIVE:
+            XhciEndpoint->Flags &= ~XHCI_ENDPOINT_FLAG_STOPPED;
+
+            if (!(XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_HALTED) &&
+                !IsListEmpty(&XhciEndpoint->TransferList))
+            {
+                XHCI_RingDoorbell(XhciExtension, XhciEndpoint->SlotId, XhciEndpoint->Dci);
+            }
+            break;
+
+        case USBPORT_ENDPOINT_REMOVE:
+            /* Close drops the endpoint or disables the slot */
+            XhciEndpoint->Flags |= XHCI_ENDPOINT_FLAG_STOPPED;
+            break;
+
+        default:
+            DPRINT1("XHCI_SetEndpointState: Unknown EndpointState - %x\n", EndpointState);
+            break;
+    }
+}
+
+VOID
+NTAPI
+XHCI_PollEndpoint(IN PVOID xhciExtension,
+                  IN PVOID xhciEndpoint)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+    PXHCI_TRANSFER XhciTransfer;
+    PLIST_ENTRY Entry;
+
+    DPRINT_XHCI("XHCI_PollEndpoint: XhciEndpoint - %p\n", XhciEndpoint);
+
+    /* Any endpoint's poll takes in the events of all of them */
+    XHCI_ProcessEventRing(XhciExtension);
+
+    Entry = XhciEndpoint->TransferList.Flink;
+
+    while (Entry != &XhciEndpoint->TransferList)
+    {
+        XhciTransfer = CONTAINING_RECORD(Entry, XHCI_TRANSFER, TransferLink);
+        Entry = Entry->Flink;
+
+        if (!(XhciTransfer->Flags & XHCI_TRANSFER_FLAG_DONE))
+            continue;
+
+        RemoveEntryList(&XhciTransfer->TransferLink);
+
+        RegPacket.UsbPortCompleteTransfer(XhciExtension,
+                                          XhciEndpoint,
+                                          XhciTransfer->TransferParameters,
+                                          XhciTransfer->USBDStatus,
+                                          XhciTransfer->TransferLen);
+    }
+
+    /* A stalled control request must not block the next one, other pipes wait for RESET_PIPE */
+    if ((XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_HALTED) &&
+        XhciEndpoint->EndpointProperties.TransferType == USBPORT_TRANSFER_TYPE_CONTROL)
+    {
+        XHCI_ResetEndpoint(XhciExtension, XhciEndpoint);
+    }
+}
+
+VOID
+NTAPI
+XHCI_CheckController(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    ULONG Status;
+
+    if (!XhciExtension->IsStarted)
+        return;
+
+    Status = READ_REGISTER_ULONG(&XhciExtension->OperationalRegs->HcStatus.AsULONG);
+
+    if (Status == 0xFFFFFFFF)
+    {
+        DPRINT1("XHCI_CheckController: The controller is gone\n");
+
+        RegPacket.UsbPortInvalidateController(XhciExtension,
+                                              USBPORT_INVALIDATE_CONTROLLER_SURPRISE_REMOVE);
+        return;
+    }
+
+    /* Catches events whose interrupt was lost, and keeps the frame counter from wrapping unseen */
+    XHCI_ProcessEventRing(XhciExtension);
+    RegPacket.Get32BitFrameNumber(XhciExtension);
+}
+
+ULONG
+NTAPI
+XHCI_Get32BitFrameNumber(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    ULONG FrameIndex;
+
+    /* MFINDEX counts microframes and wraps every 2048 frames */
+    FrameIndex = (READ_REGISTER_ULONG(&XhciExtension->RuntimeRegs->MicroframeIndex) &
+                  XHCI_MFINDEX_MASK) >> 3;
+
+    if (FrameIndex < XhciExtension->FrameIndex)
+        XhciExtension->FrameHighPart += (XHCI_MFINDEX_MASK + 1) >> 3;
+
+    XhciExtension->FrameIndex = FrameIndex;
+
+    return XhciExtension->FrameHighPart + FrameIndex;
+}
+
+VOID
+NTAPI
+XHCI_InterruptNextSOF(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+
+    DPRINT_XHCI("XHCI_InterruptNextSOF: XhciExtension - %p\n", XhciExtension);
+
+    RegPacket.UsbPortInvalidateController(XhciExtension,
+                                          USBPORT_INVALIDATE_CONTROLLER_SOFT_INTERRUPT);
+}
+
+VOID
+NTAPI
+XHCI_EnableInterrupts(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+
+    DPRINT("XHCI_EnableInterrupts: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.InterrupterEnable = 1;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+}
+
+VOID
+NTAPI
+XHCI_DisableInterrupts(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    XHCI_USB_COMMAND Command;
+
+    DPRINT("XHCI_DisableInterrupts: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Command.AsULONG = READ_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG);
+    Command.InterrupterEnable = 0;
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcCommand.AsULONG, Command.AsULONG);
+}
+
+VOID
+NTAPI
+XHCI_PollController(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    ULONG PortSC;
+    USHORT Port;
+
+    DPRINT_XHCI("XHCI_PollController: ... \n");
+
+    if (XhciExtension->Flags & XHCI_FLAGS_CONTROLLER_SUSPEND)
+        return;
+
+    for (Port = 0; Port < XhciExtension->NumberOfPorts; Port++)
+    {
+        PortSC = READ_REGISTER_ULONG(&XhciExtension->OperationalRegs->PortControl[Port].PortStatusControl.AsULONG);
+
+        if (PortSC & XHCI_PORTSC_CHANGE_MASK)
+        {
+            RegPacket.UsbPortInvalidateRootHub(XhciExtension);
+            break;
+        }
+    }
+}
+
+VOID
+NTAPI
+XHCI_SetEndpointDataToggle(IN PVOID xhciExtension,
+                           IN PVOID xhciEndpoint,
+                           IN ULONG DataToggle)
+{
+    /* The xHC owns the toggle, Reset Endpoint clears it */
+    DPRINT("XHCI_SetEndpointDataToggle: DataToggle - %x\n", DataToggle);
+}
+
+ULONG
+NTAPI
+XHCI_GetEndpointStatus(IN PVOID xhciExtension,
+                       IN PVOID xhciEndpoint)
+{
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+
+    DPRINT("XHCI_GetEndpointStatus: XhciEndpoint - %p\n", XhciEndpoint);
+
+    if (XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_HALTED)
+        return USBPORT_ENDPOINT_HALT;
+
+    return USBPORT_ENDPOINT_RUN;
+}
+
+VOID
+NTAPI
+XHCI_SetEndpointStatus(IN PVOID xhciExtension,
+                       IN PVOID xhciEndpoint,
+                       IN ULONG EndpointStatus)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_ENDPOINT XhciEndpoint = xhciEndpoint;
+
+    DPRINT("XHCI_SetEndpointStatus: XhciEndpoint - %p, EndpointStatus - %x\n",
+           XhciEndpoint,
+           EndpointStatus);
+
+    if (EndpointStatus == USBPORT_ENDPOINT_RUN &&
+        (XhciEndpoint->Flags & XHCI_ENDPOINT_FLAG_HALTED))
+    {
+        XHCI_ResetEndpoint(XhciExtension, XhciEndpoint);
+    }
+}
+
+VOID
+NTAPI
+XHCI_ResetController(IN PVOID xhciExtension)
+{
+    DPRINT1("XHCI_ResetController: UNIMPLEMENTED. FIXME\n");
+}
+
+MPSTATUS
+NTAPI
+XHCI_StartSendOnePacket(IN PVOID xhciExtension,
+                        IN PVOID PacketParameters,
+                        IN PVOID Data,
+                        IN PULONG pDataLength,
+                        IN PVOID BufferVA,
+                        IN PVOID BufferPA,
+                        IN ULONG BufferLength,
+                        IN USBD_STATUS * pUSBDStatus)
+{
+    DPRINT1("XHCI_StartSendOnePacket: UNIMPLEMENTED. FIXME\n");
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_EndSendOnePacket(IN PVOID xhciExtension,
+                      IN PVOID PacketParameters,
+                      IN PVOID Data,
+                      IN PULONG pDataLength,
+                      IN PVOID BufferVA,
+                      IN PVOID BufferPA,
+                      IN ULONG BufferLength,
+                      IN USBD_STATUS * pUSBDStatus)
+{
+    DPRINT1("XHCI_EndSendOnePacket: UNIMPLEMENTED. FIXME\n");
+    return MP_STATUS_SUCCESS;
+}
+
+MPSTATUS
+NTAPI
+XHCI_PassThru(IN PVOID xhciExtension,
+              IN PVOID passThruParameters,
+              IN ULONG ParameterLength,
+              IN PVOID pParameters)
+{
+    DPRINT1("XHCI_PassThru: UNIMPLEMENTED. FIXME\n");
+    return MP_STATUS_SUCCESS;
+}
+
+VOID
+NTAPI
+XHCI_RebalanceEndpoint(IN PVOID xhciExtension,
+                       IN PUSBPORT_ENDPOINT_PROPERTIES EndpointProperties,
+                       IN PVOID xhciEndpoint)
+{
+    DPRINT1("XHCI_RebalanceEndpoint: UNIMPLEMENTED. FIXME\n");
+}
+
+VOID
+NTAPI
+XHCI_FlushInterrupts(IN PVOID xhciExtension)
+{
+    PXHCI_EXTENSION XhciExtension = xhciExtension;
+    PXHCI_HW_REGISTERS OperationalRegs;
+    ULONG Status;
+
+    DPRINT("XHCI_FlushInterrupts: ... \n");
+
+    OperationalRegs = XhciExtension->OperationalRegs;
+
+    Status = READ_REGISTER_ULONG(&OperationalRegs->HcStatus.AsULONG);
+    WRITE_REGISTER_ULONG(&OperationalRegs->HcStatus.AsULONG, Status & XHCI_USB_STATUS_RW1C_MASK);
+}
+
+VOID
+NTAPI
+XHCI_TakePortControl(IN PVOID xhciExtension)
+{
+    DPRINT1("XHCI_TakePortControl: UNIMPLEMENTED. FIXME\n");
+}
+
+VOID
+NTAPI
+XHCI_Unload(IN PDRIVER_OBJECT DriverObject)
+{
+#if DBG
+    DPRINT1("XHCI_Unload: Not supported\n");
+#endif
+    return;
+}
+
+NTSTATUS
+NTAPI
+DriverEntry(IN PDRIVER_OBJECT DriverObject,
+            IN PUNICODE_STRING RegistryPath)
+{
+    DPRINT("DriverEntry: DriverObject - %p, RegistryPath - %wZ\n",
+           DriverObject,
+           RegistryPath);
+
+    if (USBPORT_GetHciMn() != USBPORT_HCI_MN)
+        return STATUS_INSUFFICIENT_RESOURCES;
+
+    RtlZeroMemory(&RegPacket, sizeof(USBPORT_REGISTRATION_PACKET));
+
+    RegPacket.MiniPortVersion = USB_MINIPORT_VERSION_XHCI;
+
+    RegPacket.MiniPortFlags = USB_MINIPORT_FLAGS_INTERRUPT |
+                              USB_MINIPORT_FLAGS_MEMORY_IO |
+                              USB_MINIPORT_FLAGS_USB2 |
+                              USB_MINIPORT_FLAGS_POLLING;
+
+    RegPacket.MiniPortBusBandwidth = TOTAL_USB20_BUS_BANDWIDTH;
+
+    RegPacket.MiniPortExtensionSize = sizeof(XHCI_EXTENSION);
+    RegPacket.MiniPortEndpointSize = sizeof(XHCI_ENDPOINT);
+    RegPacket.MiniPortTransferSize = sizeof(XHCI_TRANSFER);
+    RegPacket.MiniPortResourcesSize = sizeof(XHCI_HC_RESOURCES);
+
+    RegPacket.OpenEndpoint = XHCI_OpenEndpoint;
+    RegPacket.ReopenEndpoint = XHCI_ReopenEndpoint;
+    RegPacket.QueryEndpointRequirements = XHCI_QueryEndpointRequirements;
+    RegPacket.CloseEndpoint = XHCI_CloseEndpoint;
+    RegPacket.StartController = XHCI_StartController;
+    RegPacket.StopController = XHCI_StopController;
+    RegPacket.SuspendController = XHCI_SuspendController;
+    RegPacket.ResumeController = XHCI_ResumeController;
+    RegPacket.InterruptService = XHCI_InterruptService;
+    RegPacket.InterruptDpc = XHCI_InterruptDpc;
+    RegPacket.SubmitTransfer = XHCI_SubmitTransfer;
+    RegPacket.SubmitIsoTransfer = XHCI_SubmitIsoTransfer;
+    RegPacket.AbortTransfer = XHCI_AbortTransfer;
+    RegPacket.GetEndpointState = XHCI_GetEndpointState;
+    RegPacket.SetEndpointState = XHCI_SetEndpointState;
+    RegPacket.PollEndpoint = XHCI_PollEndpoint;
+    RegPacket.CheckController = XHCI_CheckController;
+    RegPacket.Get32BitFrameNumber = XHCI_Get32BitFrameNumber;
+    RegPacket.InterruptNextSOF = XHCI_InterruptNextSOF;
+    RegPacket.EnableInterrupts = XHCI_EnableInterrupts;
+    RegPacket.DisableInterrupts = XHCI_DisableInterrupts;
+    RegPacket.PollController = XHCI_PollController;
+    RegPacket.SetEndpointDataToggle = XHCI_SetEndpointDataToggle;
+    RegPacket.GetEndpointStatus = XHCI_GetEndpointStatus;
+    RegPacket.SetEndpointStatus = XHCI_SetEndpointStatus;
+    RegPacket.ResetController = XHCI_ResetController;
+    RegPacket.RH_GetRootHubData = XHCI_RH_GetRootHubData;
+    RegPacket.RH_GetStatus = XHCI_RH_GetStatus;
+    RegPacket.RH_GetPortStatus = XHCI_RH_GetPortStatus;
+    RegPacket.RH_GetHubStatus = XHCI_RH_GetHubStatus;
+    RegPacket.RH_SetFeaturePortReset = XHCI_RH_SetFeaturePortReset;
+    RegPacket.RH_SetFeaturePortPower = XHCI_RH_SetFeaturePortPower;
+    RegPacket.RH_SetFeaturePortEnable = XHCI_RH_SetFeaturePortEnable;
+    RegPacket.RH_SetFeaturePortSuspend = XHCI_RH_SetFeaturePortSuspend;
+    RegPacket.RH_ClearFeaturePortEnable = XHCI_RH_ClearFeaturePortEnable;
+    RegPacket.RH_ClearFeaturePortPower = XHCI_RH_ClearFeaturePortPower;
+    RegPacket.RH_ClearFeaturePortSuspend = XHCI_RH_ClearFeaturePortSuspend;
+    RegPacket.RH_ClearFeaturePortEnableChange = XHCI_RH_ClearFeaturePortEnableChange;
+    RegPacket.RH_ClearFeaturePortConnectChange = XHCI_RH_ClearFeaturePortConnectChange;
+    RegPacket.RH_ClearFeaturePortResetChange = XHCI_RH_ClearFeaturePortResetChange;
+    RegPacket.RH_ClearFeaturePortSuspendChange = XHCI_RH_ClearFeaturePortSuspendChange;
+    RegPacket.RH_ClearFeaturePortOvercurrentChange = XHCI_RH_ClearFeaturePortOvercurrentChange;
+    RegPacket.RH_DisableIrq = XHCI_RH_DisableIrq;
+    RegPacket.RH_EnableIrq = XHCI_RH_EnableIrq;
+    RegPacket.StartSendOnePacket = XHCI_StartSendOnePacket;
+    RegPacket.EndSendOnePacket = XHCI_EndSendOnePacket;
+    RegPacket.PassThru = XHCI_PassThru;
+    RegPacket.RebalanceEndpoint = XHCI_RebalanceEndpoint;
+    RegPacket.FlushInterrupts = XHCI_FlushInterrupts;
+    RegPacket.RH_ChirpRootPort = XHCI_RH_ChirpRootPort;
+    RegPacket.TakePortControl = XHCI_TakePortControl;
+
+    DriverObject->DriverUnload = XHCI_Unload;
+
+    return USBPORT_RegisterUSBPortDriver(DriverObject,
+                                         USB20_MINIPORT_INTERFACE_VERSION,
+                                         &RegPacket);
+}
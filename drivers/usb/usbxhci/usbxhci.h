@@ -0,0 +1,288 @@
+/*
+ * PROJECT:     ReactOS USB xHCI Miniport Driver
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     USBXHCI declarations
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef USBXHCI_H__
+#define USBXHCI_H__
+
+#include <ntddk.h>
+#include <windef.h>
+#include <stdio.h>
+#include <hubbusif.h>
+#include <usbbusif.h>
+#include <usbdlib.h>
+#include <drivers/usbport/usbmport.h>
+#include "hardware.h"
+
+extern USBPORT_REGISTRATION_PACKET RegPacket;
+
+#define XHCI_MAX_DEVICE_SLOTS        32
+#define XHCI_MAX_SCRATCHPAD_BUFFERS  32
+#define XHCI_MAX_USB_ADDRESSES       128
+
+/* Room for 64 byte contexts, used for 32 byte contexts as well */
+#define XHCI_CONTEXT_ENTRY_SIZE      64
+#define XHCI_DEVICE_CONTEXT_SIZE     ((XHCI_MAX_DCI + 1) * XHCI_CONTEXT_ENTRY_SIZE)
+#define XHCI_INPUT_CONTEXT_SIZE      ((XHCI_MAX_DCI + 2) * XHCI_CONTEXT_ENTRY_SIZE)
+
+#define XHCI_MAX_CONTROL_TRANSFER_SIZE    0x10000
+#define XHCI_MAX_INTERRUPT_TRANSFER_SIZE  0x10000
+#define XHCI_MAX_BULK_TRANSFER_SIZE       0x100000
+
+/* Pages of TRBs for the transfer rings. Bulk rings hold several big transfers in flight */
+#define XHCI_CONTROL_RING_PAGES    1
+#define XHCI_INTERRUPT_RING_PAGES  1
+#define XHCI_BULK_RING_PAGES       4
+
+/* Interrupter moderation in 250 ns units. At most one interrupt per 40 us */
+#define XHCI_INTERRUPT_MODERATION  160
+
+/* Timeouts in microseconds */
+#define XHCI_COMMAND_TIMEOUT       500000
+#define XHCI_HALT_TIMEOUT          20000
+
+typedef struct _XHCI_RING {
+  PXHCI_TRB FirstTrb;
+  ULONG FirstTrbPA;
+  ULONG NumberOfTrbs; // Including the Link TRBs
+  ULONG Enqueue;
+  ULONG Cycle;
+} XHCI_RING, *PXHCI_RING;
+
+#define XHCI_TRANSFER_FLAG_DONE   0x00000001
+#define XHCI_TRANSFER_FLAG_SHORT  0x00000002
+
+struct _XHCI_ENDPOINT;
+
+/* XHCI Transfer follows USBPORT Transfer */
+typedef struct _XHCI_TRANSFER {
+  ULONG Reserved;
+  PUSBPORT_TRANSFER_PARAMETERS TransferParameters;
+  ULONG USBDStatus;
+  ULONG TransferLen;
+  struct _XHCI_ENDPOINT * XhciEndpoint;
+  LIST_ENTRY TransferLink;
+  ULONG FirstTrb;
+  ULONG LastTrb;
+  ULONG TrbCount;
+  ULONG Flags;
+} XHCI_TRANSFER, *PXHCI_TRANSFER;
+
+#define XHCI_ENDPOINT_FLAG_STOPPED  0x00000001
+#define XHCI_ENDPOINT_FLAG_HALTED   0x00000002
+
+/* XHCI Endpoint follows USBPORT Endpoint */
+typedef struct _XHCI_ENDPOINT {
+  ULONG Reserved;
+  ULONG Flags;
+  USBPORT_ENDPOINT_PROPERTIES EndpointProperties;
+  ULONG SlotId;
+  ULONG Dci;
+  XHCI_RING TransferRing;
+  LIST_ENTRY TransferList;
+} XHCI_ENDPOINT, *PXHCI_ENDPOINT;
+
+#define XHCI_SLOT_FLAG_ENABLED    0x00000001
+#define XHCI_SLOT_FLAG_ADDRESSED  0x00000002
+
+typedef struct _XHCI_DEVICE_SLOT {
+  ULONG Flags;
+  USHORT DeviceAddress; // USBPORT address, the xHC picks its own on the bus
+  USHORT Padded;
+  PXHCI_ENDPOINT Endpoints[XHCI_MAX_DCI + 1];
+} XHCI_DEVICE_SLOT, *PXHCI_DEVICE_SLOT;
+
+typedef struct _XHCI_HC_RESOURCES {
+  UCHAR ScratchpadBuffers[XHCI_MAX_SCRATCHPAD_BUFFERS][PAGE_SIZE]; // 4K-page aligned
+  UCHAR DeviceContexts[XHCI_MAX_DEVICE_SLOTS][XHCI_DEVICE_CONTEXT_SIZE];
+  XHCI_TRB CommandRing[XHCI_TRBS_PER_PAGE];
+  XHCI_TRB EventRing[XHCI_TRBS_PER_PAGE];
+  ULONGLONG ScratchpadArray[XHCI_MAX_SCRATCHPAD_BUFFERS];
+  ULONGLONG DeviceContextBaseArray[XHCI_MAX_DEVICE_SLOTS + 1];
+  UCHAR Padded1[56];
+  XHCI_EVENT_RING_SEGMENT_TABLE_ENTRY EventRingSegmentTable;
+  UCHAR Padded2[48];
+  UCHAR InputContext[XHCI_INPUT_CONTEXT_SIZE];
+} XHCI_HC_RESOURCES, *PXHCI_HC_RESOURCES;
+
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, CommandRing) % 64 == 0);
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, EventRing) % 64 == 0);
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, ScratchpadArray) % 64 == 0);
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, DeviceContextBaseArray) % 64 == 0);
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, EventRingSegmentTable) % 64 == 0);
+C_ASSERT(FIELD_OFFSET(XHCI_HC_RESOURCES, InputContext) % 64 == 0);
+
+#define XHCI_FLAGS_CONTROLLER_SUSPEND  0x01
+#define XHCI_FLAGS_RH_IRQ_DISABLED     0x02
+
+/* XHCI Extension follows USBPORT Extension */
+typedef struct _XHCI_EXTENSION {
+  ULONG Reserved;
+  ULONG Flags;
+  PUCHAR BaseAddress;
+  PXHCI_HC_CAPABILITY_REGISTERS CapabilityRegisters;
+  PXHCI_HW_REGISTERS OperationalRegs;
+  PXHCI_RUNTIME_REGISTERS RuntimeRegs;
+  PULONG DoorbellRegs;
+  USHORT NumberOfPorts;
+  USHORT PortPowerControl;
+  ULONG MaxSlots;
+  ULONG ContextSize;
+  ULONG ScratchpadBuffers;
+  BOOLEAN IsStarted;
+  UCHAR Padded[3];
+  ULONG SuperSpeedPorts[(XHCI_MAX_ROOT_PORTS + 31) / 32];
+  XHCI_USB_STATUS InterruptStatus;
+  /* Schedule */
+  PXHCI_HC_RESOURCES HcResourcesVA;
+  ULONG HcResourcesPA;
+  XHCI_RING CommandRing;
+  ULONG EventDequeue;
+  ULONG EventCycle;
+  /* The command in progress */
+  ULONG CommandTrbPA;
+  ULONG CommandCompletionCode;
+  ULONG CommandSlotId;
+  BOOLEAN CommandDone;
+  UCHAR Padded2[3];
+  /* Devices */
+  XHCI_DEVICE_SLOT Slots[XHCI_MAX_DEVICE_SLOTS + 1];
+  UCHAR AddressToSlot[XHCI_MAX_USB_ADDRESSES];
+  ULONG FrameIndex;
+  ULONG FrameHighPart;
+} XHCI_EXTENSION, *PXHCI_EXTENSION;
+
+#define XHCI_IS_SUPER_SPEED_PORT(XhciExtension, Port) \
+    ((XhciExtension)->SuperSpeedPorts[((Port) - 1) / 32] & (1 << (((Port) - 1) % 32)))
+
+/* debug.c */
+VOID
+NTAPI
+XHCI_DumpTrb(
+  IN PXHCI_TRB Trb);
+
+VOID
+NTAPI
+XHCI_DumpRing(
+  IN PXHCI_RING Ring,
+  IN ULONG FirstTrb,
+  IN ULONG LastTrb);
+
+/* roothub.c */
+MPSTATUS
+NTAPI
+XHCI_RH_ChirpRootPort(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+VOID
+NTAPI
+XHCI_RH_GetRootHubData(
+  IN PVOID xhciExtension,
+  IN PVOID rootHubData);
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetStatus(
+  IN PVOID xhciExtension,
+  IN PUSHORT Status);
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetPortStatus(
+  IN PVOID xhciExtension,
+  IN USHORT Port,
+  IN PUSB_PORT_STATUS_AND_CHANGE PortStatus);
+
+MPSTATUS
+NTAPI
+XHCI_RH_GetHubStatus(
+  IN PVOID xhciExtension,
+  IN PUSB_HUB_STATUS_AND_CHANGE HubStatus);
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortReset(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortPower(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortEnable(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_SetFeaturePortSuspend(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortEnable(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortPower(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortSuspend(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortEnableChange(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortConnectChange(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortResetChange(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortSuspendChange(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+MPSTATUS
+NTAPI
+XHCI_RH_ClearFeaturePortOvercurrentChange(
+  IN PVOID xhciExtension,
+  IN USHORT Port);
+
+VOID
+NTAPI
+XHCI_RH_DisableIrq(
+  IN PVOID xhciExtension);
+
+VOID
+NTAPI
+XHCI_RH_EnableIrq(
+  IN PVOID xhciExtension);
+
+#endif /* USBXHCI_H__ */
@@ -0,0 +1,581 @@
+/*
+ * PROJECT:     ReactOS Kernel Streaming Mixer
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Per pin audio conversion graph and mixing
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifdef KMIXER_HOST
+#include "host.h"
+#else
+#include "kmixer.h"
+
+#define NDEBUG
+#include <debug.h>
+#endif
+
+/*
+ * KeSaveFloatingPointState only saves the x87 state on x86, so the SSE2
+ * paths are only used where SSE2 is the floating point unit anyway.
+ */
+#ifdef _M_AMD64
+#define CONVERSION_SSE2
+#endif
+
+#ifdef CONVERSION_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Samples are scaled to [-1.0, 1.0) */
+#define SCALE_8     (1.0f / 128.0f)
+#define SCALE_16    (1.0f / 32768.0f)
+#define SCALE_32    (1.0f / 2147483648.0f)
+
+static
+VOID
+LoadSamples8(
+    IN const UCHAR *In,
+    IN ULONG Count,
+    OUT PFLOAT Out)
+{
+    ULONG Index;
+
+    for (Index = 0; Index < Count; Index++)
+        Out[Index] = ((LONG)In[Index] - 0x80) * SCALE_8;
+}
+
+static
+VOID
+LoadSamples16(
+    IN const SHORT *In,
+    IN ULONG Count,
+    OUT PFLOAT Out)
+{
+    ULONG Index = 0;
+#ifdef CONVERSION_SSE2
+    const __m128 Scale = _mm_set1_ps(SCALE_16);
+
+    for (; Index + 8 <= Count; Index += 8)
+    {
+        __m128i Samples = _mm_loadu_si128((const __m128i *)(In + Index));
+        __m128i Low = _mm_srai_epi32(_mm_unpacklo_epi16(Samples, Samples), 16);
+        __m128i High = _mm_srai_epi32(_mm_unpackhi_epi16(Samples, Samples), 16);
+
+        _mm_storeu_ps(Out + Index, _mm_mul_ps(_mm_cvtepi32_ps(Low), Scale));
+        _mm_storeu_ps(Out + Index + 4, _mm_mul_ps(_mm_cvtepi32_ps(High), Scale));
+    }
+#endif
+
+    for (; Index < Count; Index++)
+        Out[Index] = In[Index] * SCALE_16;
+}
+
+static
+VOID
+LoadSamples24(
+    IN const UCHAR *In,
+    IN ULONG Count,
+    OUT PFLOAT Out)
+{
+    ULONG Index;
+    LONG Sample;
+
+    for (Index = 0; Index < Count; Index++, In += 3)
+    {
+        /* Put the sample into the upper bits so its sign is right */
+        Sample = (LONG)(((ULONG)In[0] << 8) | ((ULONG)In[1] << 16) | ((ULONG)In[2] << 24));
+        Out[Index] = Sample * SCALE_32;
+    }
+}
+
+static
+VOID
+LoadSamples32(
+    IN const LONG *In,
+    IN ULONG Count,
+    OUT PFLOAT Out)
+{
+    ULONG Index = 0;
+#ifdef CONVERSION_SSE2
+    const __m128 Scale = _mm_set1_ps(SCALE_32);
+
+    for (; Index + 4 <= Count; Index += 4)
+    {
+        __m128i Samples = _mm_loadu_si128((const __m128i *)(In + Index));
+        _mm_storeu_ps(Out + Index, _mm_mul_ps(_mm_cvtepi32_ps(Samples), Scale));
+    }
+#endif
+
+    for (; Index < Count; Index++)
+        Out[Index] = In[Index] * SCALE_32;
+}
+
+static
+VOID
+LoadSamples(
+    IN const UCHAR *In,
+    IN ULONG BytesPerSample,
+    IN ULONG Count,
+    OUT PFLOAT Out)
+{
+    if (BytesPerSample == 1)
+        LoadSamples8(In, Count, Out);
+    else if (BytesPerSample == 2)
+        LoadSamples16((const SHORT *)In, Count, Out);
+    else if (BytesPerSample == 3)
+        LoadSamples24(In, Count, Out);
+    else
+        LoadSamples32((const LONG *)In, Count, Out);
+}
+
+/* Clips the mixed samples and stores them in the output format */
+static
+VOID
+StoreSamples(
+    IN const FLOAT *In,
+    IN ULONG BytesPerSample,
+    IN ULONG Count,
+    OUT PUCHAR Out)
+{
+    ULONG Index = 0;
+    FLOAT Sample;
+    LONG Value;
+
+#ifdef CONVERSION_SSE2
+    if (BytesPerSample == 2)
+    {
+        const __m128 Max = _mm_set1_ps(1.0f);
+        const __m128 Min = _mm_set1_ps(-1.0f);
+        const __m128 Scale = _mm_set1_ps(32767.0f);
+
+        for (; Index + 8 <= Count; Index += 8)
+        {
+            __m128 Low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(In + Index), Min), Max);
+            __m128 High = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(In + Index + 4), Min), Max);
+            __m128i Samples = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(Low, Scale)),
+                                              _mm_cvtps_epi32(_mm_mul_ps(High, Scale)));
+
+            _mm_storeu_si128((__m128i *)(Out + Index * 2), Samples);
+        }
+    }
+#endif
+
+    for (; Index < Count; Index++)
+    {
+        Sample = In[Index];
+        if (Sample > 1.0f)
+            Sample = 1.0f;
+        else if (Sample < -1.0f)
+            Sample = -1.0f;
+
+        if (BytesPerSample == 1)
+        {
+            Out[Index] = (UCHAR)(lrintf(Sample * 127.0f) + 0x80);
+        }
+        else if (BytesPerSample == 2)
+        {
+            ((PSHORT)Out)[Index] = (SHORT)lrintf(Sample * 32767.0f);
+        }
+        else if (BytesPerSample == 3)
+        {
+            Value = lrintf(Sample * 8388607.0f);
+            Out[Index * 3] = (UCHAR)Value;
+            Out[Index * 3 + 1] = (UCHAR)(Value >> 8);
+            Out[Index * 3 + 2] = (UCHAR)(Value >> 16);
+        }
+        else
+        {
+            ((PLONG)Out)[Index] = (LONG)lrint(Sample * 2147483647.0);
+        }
+    }
+}
+
+static
+VOID
+AddSamples(
+    IN const FLOAT *In,
+    IN ULONG Count,
+    IN OUT PFLOAT Out)
+{
+    ULONG Index = 0;
+
+#ifdef CONVERSION_SSE2
+    for (; Index + 4 <= Count; Index += 4)
+        _mm_storeu_ps(Out + Index, _mm_add_ps(_mm_loadu_ps(Out + Index), _mm_loadu_ps(In + Index)));
+#endif
+
+    for (; Index < Count; Index++)
+        Out[Index] += In[Index];
+}
+
+/*
+ * Converts input frames to float in the output channel layout. Extra input
+ * channels are averaged into the output channel they wrap around to, and
+ * missing ones repeat the input channels, so stereo stretched to four
+ * channels is LRLR.
+ */
+static
+VOID
+ConvertFrames(
+    IN PCONVERSION_GRAPH Graph,
+    IN const UCHAR *In,
+    IN ULONG Frames,
+    OUT PFLOAT Out)
+{
+    FLOAT Frame[CONVERSION_MAX_CHANNELS];
+    ULONG Index, Channel, InBlockAlign;
+
+    if (Graph->InChannels == Graph->OutChannels)
+    {
+        LoadSamples(In, Graph->InBytesPerSample, Frames * Graph->InChannels, Out);
+        return;
+    }
+
+    if (Graph->InChannels == 1 && Graph->OutChannels == 2)
+    {
+        /* Load to the second half and spread it out from the front */
+        LoadSamples(In, Graph->InBytesPerSample, Frames, Out + Frames);
+        for (Index = 0; Index < Frames; Index++)
+        {
+            Out[Index * 2] = Out[Frames + Index];
+            Out[Index * 2 + 1] = Out[Frames + Index];
+        }
+        return;
+    }
+
+    InBlockAlign = Graph->InChannels * Graph->InBytesPerSample;
+
+    for (Index = 0; Index < Frames; Index++, In += InBlockAlign, Out += Graph->OutChannels)
+    {
+        LoadSamples(In, Graph->InBytesPerSample, Graph->InChannels, Frame);
+
+        if (Graph->InChannels > Graph->OutChannels)
+        {
+            for (Channel = 0; Channel < Graph->OutChannels; Channel++)
+                Out[Channel] = 0.0f;
+            for (Channel = 0; Channel < Graph->InChannels; Channel++)
+                Out[Channel % Graph->OutChannels] += Frame[Channel];
+            for (Channel = 0; Channel < Graph->OutChannels; Channel++)
+                Out[Channel] *= Graph->DownmixScale[Channel];
+        }
+        else
+        {
+            for (Channel = 0; Channel < Graph->OutChannels; Channel++)
+                Out[Channel] = Frame[Channel % Graph->InChannels];
+        }
+    }
+}
+
+static
+NTSTATUS
+GrowQueue(
+    IN PCONVERSION_GRAPH Graph)
+{
+    PFLOAT Queue;
+    ULONG Frames, Tail;
+
+    Frames = Graph->QueueFrames * 2;
+    Queue = ExAllocatePool(NonPagedPool, Frames * Graph->OutChannels * sizeof(FLOAT));
+    if (!Queue)
+        return STATUS_INSUFFICIENT_RESOURCES;
+
+    /* Straighten out what is queued on the way */
+    Tail = min(Graph->QueueFill, Graph->QueueFrames - Graph->QueueRead);
+    RtlCopyMemory(Queue,
+                  Graph->Queue + Graph->QueueRead * Graph->OutChannels,
+                  Tail * Graph->OutChannels * sizeof(FLOAT));
+    RtlCopyMemory(Queue + Tail * Graph->OutChannels,
+                  Graph->Queue,
+                  (Graph->QueueFill - Tail) * Graph->OutChannels * sizeof(FLOAT));
+
+    DPRINT("Queue grown from %lu to %lu frames\n", Graph->QueueFrames, Frames);
+
+    ExFreePool(Graph->Queue);
+    Graph->Queue = Queue;
+    Graph->QueueFrames = Frames;
+    Graph->QueueRead = 0;
+    return STATUS_SUCCESS;
+}
+
+/* Returns where the next frames go in the queue and how many fit there */
+static
+PFLOAT
+GetQueueSpace(
+    IN PCONVERSION_GRAPH Graph,
+    OUT PULONG Frames)
+{
+    ULONG Write;
+
+    if (Graph->QueueFill == Graph->QueueFrames)
+    {
+        if (!NT_SUCCESS(GrowQueue(Graph)))
+            return NULL;
+    }
+
+    Write = (Graph->QueueRead + Graph->QueueFill) % Graph->QueueFrames;
+    *Frames = min(Graph->QueueFrames - Graph->QueueFill, Graph->QueueFrames - Write);
+    return Graph->Queue + Write * Graph->OutChannels;
+}
+
+/* Copies or adds up to Frames queued frames to Out and dequeues them */
+static
+ULONG
+ReadQueue(
+    IN PCONVERSION_GRAPH Graph,
+    OUT PFLOAT Out,
+    IN ULONG Frames,
+    IN BOOLEAN Add)
+{
+    ULONG Count, Read = 0;
+    PFLOAT In;
+
+    Frames = min(Frames, Graph->QueueFill);
+
+    while (Read < Frames)
+    {
+        Count = min(Frames - Read, Graph->QueueFrames - Graph->QueueRead);
+        In = Graph->Queue + Graph->QueueRead * Graph->OutChannels;
+
+        if (Add)
+            AddSamples(In, Count * Graph->OutChannels, Out + Read * Graph->OutChannels);
+        else
+            RtlCopyMemory(Out + Read * Graph->OutChannels, In, Count * Graph->OutChannels * sizeof(FLOAT));
+
+        Graph->QueueRead = (Graph->QueueRead + Count) % Graph->QueueFrames;
+        Graph->QueueFill -= Count;
+        Read += Count;
+    }
+
+    return Read;
+}
+
+static
+NTSTATUS
+Resample(
+    IN PCONVERSION_GRAPH Graph,
+    IN ULONG Frames)
+{
+    SRC_DATA Data;
+    ULONG Space;
+    int error;
+
+    Data.data_in = Graph->Scratch;
+    Data.input_frames = Frames;
+    Data.end_of_input = 0;
+    Data.src_ratio = Graph->Ratio;
+
+    while (Data.input_frames > 0)
+    {
+        Data.data_out = GetQueueSpace(Graph, &Space);
+        if (!Data.data_out)
+            return STATUS_INSUFFICIENT_RESOURCES;
+        Data.output_frames = Space;
+
+        error = src_process(Graph->Resampler, &Data);
+        if (error)
+        {
+            DPRINT1("src_process failed with %x\n", error);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        Graph->QueueFill += Data.output_frames_gen;
+        Data.data_in += Data.input_frames_used * Graph->OutChannels;
+        Data.input_frames -= Data.input_frames_used;
+
+        /* The resampler holds on to the input until there is room for its output */
+        if (!Data.input_frames_used && !Data.output_frames_gen)
+        {
+            if (!NT_SUCCESS(GrowQueue(Graph)))
+                return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+ConvGraphInitialize(
+    OUT PCONVERSION_GRAPH Graph,
+    IN ULONG InChannels,
+    IN ULONG InBitsPerSample,
+    IN ULONG InRate,
+    IN ULONG OutChannels,
+    IN ULONG OutBitsPerSample,
+    IN ULONG OutRate)
+{
+    ULONG Channel;
+    int error;
+
+    RtlZeroMemory(Graph, sizeof(CONVERSION_GRAPH));
+
+    if (!InChannels || InChannels > CONVERSION_MAX_CHANNELS ||
+        !OutChannels || OutChannels > CONVERSION_MAX_CHANNELS ||
+        !InRate || !OutRate ||
+        (InBitsPerSample != 8 && InBitsPerSample != 16 && InBitsPerSample != 24 && InBitsPerSample != 32) ||
+        (OutBitsPerSample != 8 && OutBitsPerSample != 16 && OutBitsPerSample != 24 && OutBitsPerSample != 32))
+    {
+        DPRINT1("Not implemented conversion Channels %lu -> %lu Bits %lu -> %lu Rate %lu -> %lu\n",
+                InChannels, OutChannels, InBitsPerSample, OutBitsPerSample, InRate, OutRate);
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    Graph->InChannels = InChannels;
+    Graph->InBytesPerSample = InBitsPerSample / 8;
+    Graph->InRate = InRate;
+    Graph->OutChannels = OutChannels;
+    Graph->OutBytesPerSample = OutBitsPerSample / 8;
+    Graph->OutRate = OutRate;
+
+    for (Channel = 0; Channel < OutChannels && InChannels > OutChannels; Channel++)
+    {
+        /* Averages the input channels that end up in this one */
+        Graph->DownmixScale[Channel] = 1.0f / ((InChannels - Channel + OutChannels - 1) / OutChannels);
+    }
+
+    Graph->Scratch = ExAllocatePool(NonPagedPool, CONVERSION_CHUNK_FRAMES * OutChannels * sizeof(FLOAT));
+    if (!Graph->Scratch)
+        goto cleanup;
+
+    Graph->QueueFrames = max(OutRate / 10, CONVERSION_CHUNK_FRAMES * 2);
+    Graph->Queue = ExAllocatePool(NonPagedPool, Graph->QueueFrames * OutChannels * sizeof(FLOAT));
+    if (!Graph->Queue)
+        goto cleanup;
+
+    if (InRate != OutRate)
+    {
+        Graph->Ratio = (DOUBLE)OutRate / (DOUBLE)InRate;
+        Graph->Resampler = src_new(SRC_SINC_FASTEST, OutChannels, &error);
+        if (!Graph->Resampler)
+        {
+            DPRINT1("src_new failed with %x\n", error);
+            goto cleanup;
+        }
+    }
+
+    return STATUS_SUCCESS;
+
+cleanup:
+    ConvGraphFree(Graph);
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+VOID
+ConvGraphFree(
+    IN PCONVERSION_GRAPH Graph)
+{
+    if (Graph->Resampler)
+        src_delete(Graph->Resampler);
+    if (Graph->Scratch)
+        ExFreePool(Graph->Scratch);
+    if (Graph->Queue)
+        ExFreePool(Graph->Queue);
+    if (Graph->Output)
+        ExFreePool(Graph->Output);
+
+    RtlZeroMemory(Graph, sizeof(CONVERSION_GRAPH));
+}
+
+/*
+ * Converts a buffer in the input format and queues it. Format, channel
+ * and rate are converted chunk by chunk, so a chunk is still in the cache
+ * for the next step. Without rate conversion the chunk is converted right
+ * into the queue.
+ */
+NTSTATUS
+ConvGraphWrite(
+    IN PCONVERSION_GRAPH Graph,
+    IN PVOID Buffer,
+    IN ULONG BufferLength)
+{
+    const UCHAR *In = Buffer;
+    ULONG Frames, Chunk, Space, InBlockAlign;
+    PFLOAT Out;
+    NTSTATUS Status;
+
+    InBlockAlign = Graph->InChannels * Graph->InBytesPerSample;
+    Frames = BufferLength / InBlockAlign;
+
+    while (Frames)
+    {
+        Chunk = min(Frames, CONVERSION_CHUNK_FRAMES);
+
+        if (Graph->Resampler)
+        {
+            ConvertFrames(Graph, In, Chunk, Graph->Scratch);
+            Status = Resample(Graph, Chunk);
+            if (!NT_SUCCESS(Status))
+                return Status;
+        }
+        else
+        {
+            Out = GetQueueSpace(Graph, &Space);
+            if (!Out)
+                return STATUS_INSUFFICIENT_RESOURCES;
+
+            Chunk = min(Chunk, Space);
+            ConvertFrames(Graph, In, Chunk, Out);
+            Graph->QueueFill += Chunk;
+        }
+
+        In += Chunk * InBlockAlign;
+        Frames -= Chunk;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+/*
+ * Mixes Frames of the queued frames with what the other graphs have queued
+ * and stores them in the output format in Graph->Output. Other graphs that
+ * have less queued contribute silence for the rest, and graphs with another
+ * output layout or rate are left out.
+ */
+NTSTATUS
+ConvGraphMix(
+    IN PCONVERSION_GRAPH Graph,
+    IN PCONVERSION_GRAPH *Others,
+    IN ULONG OtherCount,
+    IN ULONG Frames)
+{
+    ULONG Size, Chunk, Index, OutBlockAlign;
+    PUCHAR Out;
+
+    ASSERT(Frames <= Graph->QueueFill);
+
+    OutBlockAlign = Graph->OutChannels * Graph->OutBytesPerSample;
+    Size = Frames * OutBlockAlign;
+    if (Size > Graph->OutputSize)
+    {
+        if (Graph->Output)
+            ExFreePool(Graph->Output);
+        Graph->OutputSize = 0;
+        Graph->OutputLength = 0;
+
+        Graph->Output = ExAllocatePool(NonPagedPool, Size);
+        if (!Graph->Output)
+            return STATUS_INSUFFICIENT_RESOURCES;
+        Graph->OutputSize = Size;
+    }
+
+    Out = Graph->Output;
+    Graph->OutputLength = Size;
+
+    while (Frames)
+    {
+        Chunk = min(Frames, CONVERSION_CHUNK_FRAMES);
+
+        ReadQueue(Graph, Graph->Scratch, Chunk, FALSE);
+        for (Index = 0; Index < OtherCount; Index++)
+        {
+            if (Others[Index]->OutChannels == Graph->OutChannels && Others[Index]->OutRate == Graph->OutRate)
+                ReadQueue(Others[Index], Graph->Scratch, Chunk, TRUE);
+        }
+
+        StoreSamples(Graph->Scratch, Graph->OutBytesPerSample, Chunk * Graph->OutChannels, Out);
+
+        Out += Chunk * OutBlockAlign;
+        Frames -= Chunk;
+    }
+
+    return STATUS_SUCCESS;
+}
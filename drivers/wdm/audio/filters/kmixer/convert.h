@@ -0,0 +1,75 @@
+/*
+ * PROJECT:     ReactOS Kernel Streaming Mixer
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Per pin audio conversion graph and mixing
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef _KMIXER_CONVERT_H_
+#define _KMIXER_CONVERT_H_
+
+#include <samplerate.h>
+
+/* Frames converted to float in one step */
+#define CONVERSION_CHUNK_FRAMES     256
+
+#define CONVERSION_MAX_CHANNELS     8
+
+/*
+ * Converts one input stream to float samples in the output channel layout
+ * and sample rate, and queues them until they are mixed into the output.
+ * Everything is allocated when the formats are set. The queue and the
+ * output buffer only grow when a bigger buffer than ever before comes in.
+ */
+typedef struct
+{
+    ULONG InChannels;
+    ULONG InBytesPerSample;
+    ULONG InRate;
+    ULONG OutChannels;
+    ULONG OutBytesPerSample;
+    ULONG OutRate;
+    FLOAT DownmixScale[CONVERSION_MAX_CHANNELS];
+
+    SRC_STATE *Resampler;       /* NULL if the rates match, keeps its state from buffer to buffer */
+    DOUBLE Ratio;
+    PFLOAT Scratch;             /* One chunk in the output layout, at the input rate */
+
+    PFLOAT Queue;               /* Ring of converted frames waiting to be mixed */
+    ULONG QueueFrames;
+    ULONG QueueRead;
+    ULONG QueueFill;
+
+    PVOID Output;               /* The mixed frames in the output format */
+    ULONG OutputSize;
+    ULONG OutputLength;
+}CONVERSION_GRAPH, *PCONVERSION_GRAPH;
+
+NTSTATUS
+ConvGraphInitialize(
+    OUT PCONVERSION_GRAPH Graph,
+    IN ULONG InChannels,
+    IN ULONG InBitsPerSample,
+    IN ULONG InRate,
+    IN ULONG OutChannels,
+    IN ULONG OutBitsPerSample,
+    IN ULONG OutRate);
+
+VOID
+ConvGraphFree(
+    IN PCONVERSION_GRAPH Graph);
+
+NTSTATUS
+ConvGraphWrite(
+    IN PCONVERSION_GRAPH Graph,
+    IN PVOID Buffer,
+    IN ULONG BufferLength);
+
+NTSTATUS
+ConvGraphMix(
+    IN PCONVERSION_GRAPH Graph,
+    IN PCONVERSION_GRAPH *Others,
+    IN ULONG OtherCount,
+    IN ULONG Frames);
+
+#endif /* _KMIXER_CONVERT_H_ */
@@ -34,7 +34,21 @@ Dispatch_fnClose(
     PDEVICE_OBJECT DeviceObject,
     PIRP Irp)
 {
-    UNIMPLEMENTED;
+    PIO_STACK_LOCATION IoStack;
+    PSUM_NODE_CONTEXT SumNode;
+
+    IoStack = IoGetCurrentIrpStackLocation(Irp);
+    SumNode = (PSUM_NODE_CONTEXT)IoStack->FileObject->FsContext;
+
+    /* the pins reference the filter, they are all closed by now */
+    ASSERT(SumNode->PinCount == 0);
+
+    if (SumNode->Graphs)
+        ExFreePool(SumNode->Graphs);
+
+    KsFreeObjectHeader(SumNode->ObjectHeader);
+    ExFreePool(SumNode->CreateItem);
+    ExFreePool(SumNode);
 
     Irp->IoStatus.Status = STATUS_SUCCESS;
     Irp->IoStatus.Information = 0;
@@ -103,9 +117,10 @@ DispatchCreateKMix(
     IN  PIRP Irp)
 {
     NTSTATUS Status;
-    KSOBJECT_HEADER ObjectHeader;
+    PSUM_NODE_CONTEXT SumNode;
     PKSOBJECT_CREATE_ITEM CreateItem;
     PKMIXER_DEVICE_EXT DeviceExtension;
+    PIO_STACK_LOCATION IoStack;
 
     DPRINT("DispatchCreateKMix entered\n");
 
@@ -150,6 +165,23 @@ DispatchCreateKMix(
     /* zero create struct */
     RtlZeroMemory(CreateItem, sizeof(KSOBJECT_CREATE_ITEM) * 2);
 
+    /* allocate the filter context, the pins are mixed there */
+    SumNode = ExAllocatePool(NonPagedPool, sizeof(SUM_NODE_CONTEXT));
+    if (!SumNode)
+    {
+        /* not enough memory */
+        ExFreePool(CreateItem);
+        Irp->IoStatus.Information = 0;
+        Irp->IoStatus.Status = STATUS_INSUFFICIENT_RESOURCES;
+        IoCompleteRequest(Irp, IO_NO_INCREMENT);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(SumNode, sizeof(SUM_NODE_CONTEXT));
+    SumNode->CreateItem = CreateItem;
+    ExInitializeFastMutex(&SumNode->Lock);
+    InitializeListHead(&SumNode->PinList);
+
     /* initialize pin create item */
     CreateItem[0].Create = DispatchCreateKMixPin;
     RtlInitUnicodeString(&CreateItem[0].ObjectClass, KSSTRING_Pin);
@@ -157,14 +189,21 @@ DispatchCreateKMix(
     RtlInitUnicodeString(&CreateItem[1].ObjectClass, KSSTRING_Allocator);
 
     /* allocate object header */
-    Status = KsAllocateObjectHeader(&ObjectHeader, 2, CreateItem, Irp, &DispatchTable);
+    Status = KsAllocateObjectHeader(&SumNode->ObjectHeader, 2, CreateItem, Irp, &DispatchTable);
 
     if (!NT_SUCCESS(Status))
     {
         /* failed to allocate object header */
+        ExFreePool(SumNode);
         ExFreePool(CreateItem);
         KsDereferenceSoftwareBusObject(DeviceExtension->KsDeviceHeader);
     }
+    else
+    {
+        /* store filter context */
+        IoStack = IoGetCurrentIrpStackLocation(Irp);
+        IoStack->FileObject->FsContext = (PVOID)SumNode;
+    }
 
     DPRINT("KsAllocateObjectHeader result %x\n", Status);
     /* complete the irp */
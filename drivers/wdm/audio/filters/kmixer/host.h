@@ -0,0 +1,48 @@
+/*
+ * PROJECT:     ReactOS Kernel Streaming Mixer
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Definitions to build the conversion graph with the host compiler
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef _KMIXER_HOST_H_
+#define _KMIXER_HOST_H_
+
+/*
+ * Used in place of kmixer.h when convert.c is built with the host
+ * compiler (KMIXER_HOST), so the conversion can be measured in user mode.
+ */
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef FLOAT *PFLOAT;
+
+#define NonPagedPool 0
+#define ExAllocatePool(Type, Size) malloc(Size)
+#define ExFreePool(Block) free(Block)
+
+#define STATUS_SUCCESS                  ((NTSTATUS)0x00000000)
+#define STATUS_UNSUCCESSFUL             ((NTSTATUS)0xC0000001)
+#define STATUS_NOT_IMPLEMENTED          ((NTSTATUS)0xC0000002)
+#define STATUS_INSUFFICIENT_RESOURCES   ((NTSTATUS)0xC000009A)
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+/* The host saves no floating point state, SSE2 is always available on x64 */
+#ifdef __x86_64__
+#define CONVERSION_SSE2
+#endif
+
+#include "convert.h"
+
+#endif /* _KMIXER_HOST_H_ */
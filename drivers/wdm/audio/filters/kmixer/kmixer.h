@@ -4,6 +4,8 @@
 #include <portcls.h>
 #include <float_cast.h>
 
+#include "convert.h"
+
 typedef struct
 {
     KSDEVICE_HEADER KsDeviceHeader;
@@ -11,13 +13,31 @@ typedef struct
 
 }KMIXER_DEVICE_EXT, *PKMIXER_DEVICE_EXT;
 
+/* Stored in the FsContext of a filter, the pins created on it are mixed here */
 typedef struct
 {
-    KSPIN_LOCK Lock;
-
+    KSOBJECT_HEADER ObjectHeader;
+    PKSOBJECT_CREATE_ITEM CreateItem;
+    FAST_MUTEX Lock;                        /* Guards the pins and their conversion graphs */
+    LIST_ENTRY PinList;
+    ULONG PinCount;
+    PCONVERSION_GRAPH *Graphs;              /* Room for the graphs of all pins when mixing */
+    ULONG GraphsSize;
 
 }SUM_NODE_CONTEXT, *PSUM_NODE_CONTEXT;
 
+/* Stored in the FsContext of a pin */
+typedef struct
+{
+    KSOBJECT_HEADER ObjectHeader;
+    KSDATAFORMAT_WAVEFORMATEX Formats[2];   /* Input and output format */
+    LIST_ENTRY Entry;
+    PSUM_NODE_CONTEXT SumNode;
+    CONVERSION_GRAPH Graph;
+    BOOLEAN GraphReady;
+
+}MIXER_PIN_CONTEXT, *PMIXER_PIN_CONTEXT;
+
 
 NTSTATUS
 NTAPI
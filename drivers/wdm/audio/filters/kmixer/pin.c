@@ -8,416 +8,100 @@
 
 #include "kmixer.h"
 
-#include <samplerate.h>
-
 #define NDEBUG
 #include <debug.h>
 
 const GUID KSPROPSETID_Connection              = {0x1D58C920L, 0xAC9B, 0x11CF, {0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00}};
 
+/* How far a stream may run ahead of the others before it is mixed without them */
+#define MIXER_LATENCY_MS    20
+
+/* Called with the sum node lock held */
+static
 NTSTATUS
-PerformSampleRateConversion(
-    PUCHAR Buffer,
-    ULONG BufferLength,
-    ULONG OldRate,
-    ULONG NewRate,
-    ULONG BytesPerSample,
-    ULONG NumChannels,
-    PVOID * Result,
-    PULONG ResultLength)
+UpdateConversionGraph(
+    IN PMIXER_PIN_CONTEXT Pin)
 {
+    PWAVEFORMATEX InputFormat = &Pin->Formats[0].WaveFormatEx;
+    PWAVEFORMATEX OutputFormat = &Pin->Formats[1].WaveFormatEx;
     KFLOATING_SAVE FloatSave;
     NTSTATUS Status;
-    ULONG Index;
-    SRC_STATE * State;
-    SRC_DATA Data;
-    PUCHAR ResultOut;
-    int error;
-    PFLOAT FloatIn, FloatOut;
-    ULONG NumSamples;
-    ULONG NewSamples;
 
-    DPRINT("PerformSampleRateConversion OldRate %u NewRate %u BytesPerSample %u NumChannels %u Irql %u\n", OldRate, NewRate, BytesPerSample, NumChannels, KeGetCurrentIrql());
+    if (Pin->GraphReady)
+    {
+        ConvGraphFree(&Pin->Graph);
+        Pin->GraphReady = FALSE;
+    }
 
-    ASSERT(BytesPerSample == 1 || BytesPerSample == 2 || BytesPerSample == 4);
+    /* Wait for the other format */
+    if (!InputFormat->nSamplesPerSec || !OutputFormat->nSamplesPerSec)
+        return STATUS_SUCCESS;
 
-    /* first acquire float save context */
     Status = KeSaveFloatingPointState(&FloatSave);
-
     if (!NT_SUCCESS(Status))
     {
         DPRINT1("KeSaveFloatingPointState failed with %x\n", Status);
         return Status;
     }
 
-    NumSamples = BufferLength / (BytesPerSample * NumChannels);
-
-    FloatIn = ExAllocatePool(NonPagedPool, NumSamples * NumChannels * sizeof(FLOAT));
-    if (!FloatIn)
-    {
-        KeRestoreFloatingPointState(&FloatSave);
-        return STATUS_INSUFFICIENT_RESOURCES;
-    }
-
-    NewSamples = ((((ULONG64)NumSamples * NewRate) + (OldRate / 2)) / OldRate) + 2;
-
-    FloatOut = ExAllocatePool(NonPagedPool, NewSamples * NumChannels * sizeof(FLOAT));
-    if (!FloatOut)
-    {
-        ExFreePool(FloatIn);
-        KeRestoreFloatingPointState(&FloatSave);
-        return STATUS_INSUFFICIENT_RESOURCES;
-    }
-
-    ResultOut = ExAllocatePool(NonPagedPool, NewSamples * NumChannels * BytesPerSample);
-    if (!ResultOut)
-    {
-        ExFreePool(FloatIn);
-        ExFreePool(FloatOut);
-        KeRestoreFloatingPointState(&FloatSave);
-        return STATUS_INSUFFICIENT_RESOURCES;
-    }
-
-    State = src_new(SRC_SINC_FASTEST, NumChannels, &error);
-    if (!State)
-    {
-        DPRINT1("src_new failed with %x\n", error);
-        KeRestoreFloatingPointState(&FloatSave);
-        ExFreePool(FloatIn);
-        ExFreePool(FloatOut);
-        ExFreePool(ResultOut);
-        return STATUS_UNSUCCESSFUL;
-    }
-
-    /* fixme use asm */
-    if (BytesPerSample == 1)
-    {
-        for(Index = 0; Index < NumSamples * NumChannels; Index++)
-            FloatIn[Index] = (float)(Buffer[Index] / (1.0 * 0x80));
-    }
-    else if (BytesPerSample == 2)
-    {
-        src_short_to_float_array((short*)Buffer, FloatIn, NumSamples * NumChannels);
-    }
-    else if (BytesPerSample == 4)
-    {
-        src_int_to_float_array((int*)Buffer, FloatIn, NumSamples * NumChannels);
-    }
-
-    Data.data_in = FloatIn;
-    Data.data_out = FloatOut;
-    Data.input_frames = NumSamples;
-    Data.output_frames = NewSamples;
-    Data.src_ratio = (double)NewRate / (double)OldRate;
-
-    error = src_process(State, &Data);
-    if (error)
-    {
-        DPRINT1("src_process failed with %x\n", error);
-        KeRestoreFloatingPointState(&FloatSave);
-        ExFreePool(FloatIn);
-        ExFreePool(FloatOut);
-        ExFreePool(ResultOut);
-        return STATUS_UNSUCCESSFUL;
-    }
-
-    if (BytesPerSample == 1)
-    {
-        /* FIXME perform over/under clipping */
-
-        for(Index = 0; Index < Data.output_frames_gen * NumChannels; Index++)
-            ResultOut[Index] = (lrintf(FloatOut[Index]) >> 24);
-    }
-    else if (BytesPerSample == 2)
-    {
-        PUSHORT Res = (PUSHORT)ResultOut;
-
-        src_float_to_short_array(FloatOut, (short*)Res, Data.output_frames_gen * NumChannels);
-    }
-    else if (BytesPerSample == 4)
-    {
-        PULONG Res = (PULONG)ResultOut;
-
-        src_float_to_int_array(FloatOut, (int*)Res, Data.output_frames_gen * NumChannels);
-    }
-
-
-    *Result = ResultOut;
-    *ResultLength = Data.output_frames_gen * BytesPerSample * NumChannels;
-    ExFreePool(FloatIn);
-    ExFreePool(FloatOut);
-    src_delete(State);
+    Status = ConvGraphInitialize(&Pin->Graph,
+                                 InputFormat->nChannels,
+                                 InputFormat->wBitsPerSample,
+                                 InputFormat->nSamplesPerSec,
+                                 OutputFormat->nChannels,
+                                 OutputFormat->wBitsPerSample,
+                                 OutputFormat->nSamplesPerSec);
     KeRestoreFloatingPointState(&FloatSave);
-    return STATUS_SUCCESS;
+
+    Pin->GraphReady = NT_SUCCESS(Status);
+    return Status;
 }
 
+/*
+ * Mixes what the pin has queued with the other pins of its sum node. The
+ * other streams get to catch up for MIXER_LATENCY_MS, after that the pin's
+ * frames are mixed with whatever they have. Called with the sum node lock
+ * held.
+ */
+static
 NTSTATUS
-PerformChannelConversion(
-    PUCHAR Buffer,
-    ULONG BufferLength,
-    ULONG OldChannels,
-    ULONG NewChannels,
-    ULONG BitsPerSample,
-    PVOID * Result,
-    PULONG ResultLength)
+MixPinStreams(
+    IN PMIXER_PIN_CONTEXT Pin)
 {
-    ULONG Samples;
-    ULONG NewIndex, OldIndex;
-
-    Samples = BufferLength / (BitsPerSample / 8) / OldChannels;
-
-    if (NewChannels > OldChannels)
-    {
-        if (BitsPerSample == 8)
-        {
-            PUCHAR BufferOut = ExAllocatePool(NonPagedPool, Samples * NewChannels);
-            if (!BufferOut)
-                return STATUS_INSUFFICIENT_RESOURCES;
-
-            for(NewIndex = 0, OldIndex = 0; OldIndex < Samples * OldChannels; NewIndex += NewChannels, OldIndex += OldChannels)
-            {
-                ULONG SubIndex = 0;
-
-                RtlMoveMemory(&BufferOut[NewIndex], &Buffer[OldIndex], OldChannels * sizeof(UCHAR));
-
-                do
-                {
-                    /* 2 channel stretched to 4 looks like LRLR */
-                     BufferOut[NewIndex+OldChannels + SubIndex] = Buffer[OldIndex + (SubIndex % OldChannels)];
-                }while(SubIndex++ < NewChannels - OldChannels);
-            }
-            *Result = BufferOut;
-            *ResultLength = Samples * NewChannels;
-        }
-        else if (BitsPerSample == 16)
-        {
-            PUSHORT BufferOut = ExAllocatePool(NonPagedPool, Samples * NewChannels);
-            if (!BufferOut)
-                return STATUS_INSUFFICIENT_RESOURCES;
+    PSUM_NODE_CONTEXT SumNode = Pin->SumNode;
+    PMIXER_PIN_CONTEXT Other;
+    PLIST_ENTRY Entry;
+    ULONG Frames, Latency, Count = 0;
 
-            for(NewIndex = 0, OldIndex = 0; OldIndex < Samples * OldChannels; NewIndex += NewChannels, OldIndex += OldChannels)
-            {
-                ULONG SubIndex = 0;
-
-                RtlMoveMemory(&BufferOut[NewIndex], &Buffer[OldIndex], OldChannels * sizeof(USHORT));
-
-                do
-                {
-                     BufferOut[NewIndex+OldChannels + SubIndex] = Buffer[OldIndex + (SubIndex % OldChannels)];
-                }while(SubIndex++ < NewChannels - OldChannels);
-            }
-            *Result = BufferOut;
-            *ResultLength = Samples * NewChannels;
-        }
-        else if (BitsPerSample == 24)
-        {
-            PUCHAR BufferOut = ExAllocatePool(NonPagedPool, Samples * NewChannels);
-            if (!BufferOut)
-                return STATUS_INSUFFICIENT_RESOURCES;
-
-            for(NewIndex = 0, OldIndex = 0; OldIndex < Samples * OldChannels; NewIndex += NewChannels, OldIndex += OldChannels)
-            {
-                ULONG SubIndex = 0;
-
-                RtlMoveMemory(&BufferOut[NewIndex], &Buffer[OldIndex], OldChannels * 3);
-
-                do
-                {
-                     RtlMoveMemory(&BufferOut[(NewIndex+OldChannels + SubIndex) * 3], &Buffer[(OldIndex + (SubIndex % OldChannels)) * 3], 3);
-                }while(SubIndex++ < NewChannels - OldChannels);
-            }
-            *Result = BufferOut;
-            *ResultLength = Samples * NewChannels;
-        }
-        else if (BitsPerSample == 32)
-        {
-            PULONG BufferOut = ExAllocatePool(NonPagedPool, Samples * NewChannels);
-            if (!BufferOut)
-                return STATUS_INSUFFICIENT_RESOURCES;
-
-            for(NewIndex = 0, OldIndex = 0; OldIndex < Samples * OldChannels; NewIndex += NewChannels, OldIndex += OldChannels)
-            {
-                ULONG SubIndex = 0;
+    Frames = Pin->Graph.QueueFill;
 
-                RtlMoveMemory(&BufferOut[NewIndex], &Buffer[OldIndex], OldChannels * sizeof(ULONG));
-
-                do
-                {
-                     BufferOut[NewIndex+OldChannels + SubIndex] = Buffer[OldIndex + (SubIndex % OldChannels)];
-                }while(SubIndex++ < NewChannels - OldChannels);
-            }
-            *Result = BufferOut;
-            *ResultLength = Samples * NewChannels;
-        }
-
-    }
-    else
+    for (Entry = SumNode->PinList.Flink; Entry != &SumNode->PinList; Entry = Entry->Flink)
     {
-        PUSHORT BufferOut = ExAllocatePool(NonPagedPool, Samples * NewChannels);
-        if (!BufferOut)
-            return STATUS_INSUFFICIENT_RESOURCES;
-
-        for(NewIndex = 0, OldIndex = 0; OldIndex < Samples * OldChannels; NewIndex += NewChannels, OldIndex += OldChannels)
+        Other = CONTAINING_RECORD(Entry, MIXER_PIN_CONTEXT, Entry);
+        if (Other == Pin || !Other->GraphReady ||
+            Other->Graph.OutChannels != Pin->Graph.OutChannels ||
+            Other->Graph.OutRate != Pin->Graph.OutRate)
         {
-            /* TODO
-             * mix stream instead of just dumping part of it ;)
-             */
-            RtlMoveMemory(&BufferOut[NewIndex], &Buffer[OldIndex], NewChannels * (BitsPerSample/8));
+            continue;
         }
 
-        *Result = BufferOut;
-        *ResultLength = Samples * NewChannels;
+        SumNode->Graphs[Count++] = &Other->Graph;
+        Frames = min(Frames, Other->Graph.QueueFill);
     }
-    return STATUS_SUCCESS;
-}
-
-
-NTSTATUS
-PerformQualityConversion(
-    PUCHAR Buffer,
-    ULONG BufferLength,
-    ULONG OldWidth,
-    ULONG NewWidth,
-    PVOID * Result,
-    PULONG ResultLength)
-{
-    ULONG Samples;
-    ULONG Index;
-
-    ASSERT(OldWidth != NewWidth);
 
-    Samples = BufferLength / (OldWidth / 8);
-    //DPRINT("Samples %u BufferLength %u\n", Samples, BufferLength);
+    Latency = Pin->Graph.OutRate * MIXER_LATENCY_MS / 1000;
+    if (Pin->Graph.QueueFill - Frames > Latency)
+        Frames = Pin->Graph.QueueFill - Latency;
 
-    if (OldWidth == 8 && NewWidth == 16)
+    if (!Frames)
     {
-         USHORT Sample;
-         PUSHORT BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(USHORT));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = Buffer[Index];
-              Sample *= 2;
-#ifdef _X86_
-              Sample = _byteswap_ushort(Sample);
-#endif
-              BufferOut[Index] = Sample;
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(USHORT);
-    }
-    else if (OldWidth == 8 && NewWidth == 32)
-    {
-         ULONG Sample;
-         PULONG BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(ULONG));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = Buffer[Index];
-              Sample *= 16777216;
-#ifdef _X86_
-              Sample = _byteswap_ulong(Sample);
-#endif
-              BufferOut[Index] = Sample;
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(ULONG);
-    }
-    else if (OldWidth == 16 && NewWidth == 32)
-    {
-         ULONG Sample;
-         PUSHORT BufferIn = (PUSHORT)Buffer;
-         PULONG BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(ULONG));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = BufferIn[Index];
-              Sample *= 65536;
-#ifdef _X86_
-              Sample = _byteswap_ulong(Sample);
-#endif
-              BufferOut[Index] = Sample;
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(ULONG);
+        Pin->Graph.OutputLength = 0;
+        return STATUS_SUCCESS;
     }
 
-    else if (OldWidth == 16 && NewWidth == 8)
-    {
-         USHORT Sample;
-         PUSHORT BufferIn = (PUSHORT)Buffer;
-         PUCHAR BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(UCHAR));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = BufferIn[Index];
-#ifdef _X86_
-              Sample = _byteswap_ushort(Sample);
-#endif
-              Sample /= 256;
-              BufferOut[Index] = (Sample & 0xFF);
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(UCHAR);
-    }
-    else if (OldWidth == 32 && NewWidth == 8)
-    {
-         ULONG Sample;
-         PULONG BufferIn = (PULONG)Buffer;
-         PUCHAR BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(UCHAR));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = BufferIn[Index];
-#ifdef _X86_
-              Sample = _byteswap_ulong(Sample);
-#endif
-              Sample /= 16777216;
-              BufferOut[Index] = (Sample & 0xFF);
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(UCHAR);
-    }
-    else if (OldWidth == 32 && NewWidth == 16)
-    {
-         USHORT Sample;
-         PULONG BufferIn = (PULONG)Buffer;
-         PUSHORT BufferOut = ExAllocatePool(NonPagedPool, Samples * sizeof(USHORT));
-         if (!BufferOut)
-             return STATUS_INSUFFICIENT_RESOURCES;
-
-          for(Index = 0; Index < Samples; Index++)
-          {
-              Sample = BufferIn[Index];
-#ifdef _X86_
-              Sample = _byteswap_ulong(Sample);
-#endif
-              Sample /= 65536;
-              BufferOut[Index] = (Sample & 0xFFFF);
-          }
-          *Result = BufferOut;
-          *ResultLength = Samples * sizeof(USHORT);
-    }
-    else
-    {
-        DPRINT1("Not implemented conversion OldWidth %u NewWidth %u\n", OldWidth, NewWidth);
-        return STATUS_NOT_IMPLEMENTED;
-    }
-
-    return STATUS_SUCCESS;
+    return ConvGraphMix(&Pin->Graph, SumNode->Graphs, Count, Frames);
 }
 
-
 NTSTATUS
 NTAPI
 Pin_fnDeviceIoControl(
@@ -426,6 +110,8 @@ Pin_fnDeviceIoControl(
 {
     PIO_STACK_LOCATION IoStack;
     PKSP_PIN Property;
+    PMIXER_PIN_CONTEXT Pin;
+    NTSTATUS Status;
     //DPRINT1("Pin_fnDeviceIoControl called DeviceObject %p Irp %p\n", DeviceObject);
 
     IoStack = IoGetCurrentIrpStackLocation(Irp);
@@ -441,21 +127,28 @@ Pin_fnDeviceIoControl(
                 PKSDATAFORMAT_WAVEFORMATEX Formats;
                 PKSDATAFORMAT_WAVEFORMATEX WaveFormat;
 
-                Formats = (PKSDATAFORMAT_WAVEFORMATEX)IoStack->FileObject->FsContext2;
+                Pin = (PMIXER_PIN_CONTEXT)IoStack->FileObject->FsContext;
+                Formats = Pin->Formats;
                 WaveFormat = (PKSDATAFORMAT_WAVEFORMATEX)Irp->UserBuffer;
 
                 ASSERT(Property->PinId == 0 || Property->PinId == 1);
-                ASSERT(Formats);
                 ASSERT(WaveFormat);
 
+                ExAcquireFastMutex(&Pin->SumNode->Lock);
+
                 Formats[Property->PinId].WaveFormatEx.nChannels = WaveFormat->WaveFormatEx.nChannels;
                 Formats[Property->PinId].WaveFormatEx.wBitsPerSample = WaveFormat->WaveFormatEx.wBitsPerSample;
                 Formats[Property->PinId].WaveFormatEx.nSamplesPerSec = WaveFormat->WaveFormatEx.nSamplesPerSec;
 
+                /* Everything the conversion needs is allocated now, not per buffer */
+                Status = UpdateConversionGraph(Pin);
+
+                ExReleaseFastMutex(&Pin->SumNode->Lock);
+
                 Irp->IoStatus.Information = 0;
-                Irp->IoStatus.Status = STATUS_SUCCESS;
+                Irp->IoStatus.Status = Status;
                 IoCompleteRequest(Irp, IO_NO_INCREMENT);
-                return STATUS_SUCCESS;
+                return Status;
             }
         }
     }
@@ -514,7 +207,22 @@ Pin_fnClose(
     PDEVICE_OBJECT DeviceObject,
     PIRP Irp)
 {
-    UNIMPLEMENTED;
+    PIO_STACK_LOCATION IoStack;
+    PMIXER_PIN_CONTEXT Pin;
+
+    IoStack = IoGetCurrentIrpStackLocation(Irp);
+    Pin = (PMIXER_PIN_CONTEXT)IoStack->FileObject->FsContext;
+
+    ExAcquireFastMutex(&Pin->SumNode->Lock);
+    RemoveEntryList(&Pin->Entry);
+    Pin->SumNode->PinCount--;
+    ExReleaseFastMutex(&Pin->SumNode->Lock);
+
+    if (Pin->GraphReady)
+        ConvGraphFree(&Pin->Graph);
+
+    KsFreeObjectHeader(Pin->ObjectHeader);
+    ExFreePool(Pin);
 
     Irp->IoStatus.Status = STATUS_SUCCESS;
     Irp->IoStatus.Information = 0;
@@ -601,78 +309,46 @@ Pin_fnFastWrite(
     PDEVICE_OBJECT DeviceObject)
 {
     PKSSTREAM_HEADER StreamHeader;
-    PVOID BufferOut;
-    ULONG BufferLength;
-    NTSTATUS Status = STATUS_SUCCESS;
-    PKSDATAFORMAT_WAVEFORMATEX Formats;
-    PKSDATAFORMAT_WAVEFORMATEX InputFormat, OutputFormat;
+    PMIXER_PIN_CONTEXT Pin;
+    KFLOATING_SAVE FloatSave;
+    NTSTATUS Status;
 
     DPRINT("Pin_fnFastWrite called DeviceObject %p Irp %p\n", DeviceObject);
 
-    Formats = (PKSDATAFORMAT_WAVEFORMATEX)FileObject->FsContext2;
-
-    InputFormat = Formats;
-    OutputFormat = (Formats + 1);
+    Pin = (PMIXER_PIN_CONTEXT)FileObject->FsContext;
     StreamHeader = (PKSSTREAM_HEADER)Buffer;
 
-
-    DPRINT("Num Channels %u Old Channels %u\n SampleRate %u Old SampleRate %u\n BitsPerSample %u Old BitsPerSample %u\n",
-               InputFormat->WaveFormatEx.nChannels, OutputFormat->WaveFormatEx.nChannels,
-               InputFormat->WaveFormatEx.nSamplesPerSec, OutputFormat->WaveFormatEx.nSamplesPerSec,
-               InputFormat->WaveFormatEx.wBitsPerSample, OutputFormat->WaveFormatEx.wBitsPerSample);
-
-    if (InputFormat->WaveFormatEx.wBitsPerSample != OutputFormat->WaveFormatEx.wBitsPerSample)
+    if (!Pin->GraphReady)
     {
-        Status = PerformQualityConversion(StreamHeader->Data,
-                                          StreamHeader->DataUsed,
-                                          InputFormat->WaveFormatEx.wBitsPerSample,
-                                          OutputFormat->WaveFormatEx.wBitsPerSample,
-                                          &BufferOut,
-                                          &BufferLength);
-        if (NT_SUCCESS(Status))
-        {
-            ExFreePool(StreamHeader->Data);
-            StreamHeader->Data = BufferOut;
-            StreamHeader->DataUsed = BufferLength;
-        }
+        DPRINT1("No data format set\n");
+        IoStatus->Status = STATUS_INVALID_DEVICE_STATE;
+        return FALSE;
     }
 
-    if (InputFormat->WaveFormatEx.nChannels != OutputFormat->WaveFormatEx.nChannels)
+    Status = KeSaveFloatingPointState(&FloatSave);
+    if (!NT_SUCCESS(Status))
     {
-        Status = PerformChannelConversion(StreamHeader->Data,
-                                          StreamHeader->DataUsed,
-                                          InputFormat->WaveFormatEx.nChannels,
-                                          OutputFormat->WaveFormatEx.nChannels,
-                                          OutputFormat->WaveFormatEx.wBitsPerSample,
-                                          &BufferOut,
-                                          &BufferLength);
-
-        if (NT_SUCCESS(Status))
-        {
-            ExFreePool(StreamHeader->Data);
-            StreamHeader->Data = BufferOut;
-            StreamHeader->DataUsed = BufferLength;
-        }
+        DPRINT1("KeSaveFloatingPointState failed with %x\n", Status);
+        IoStatus->Status = Status;
+        return FALSE;
     }
 
-    if (InputFormat->WaveFormatEx.nSamplesPerSec != OutputFormat->WaveFormatEx.nSamplesPerSec)
+    ExAcquireFastMutex(&Pin->SumNode->Lock);
+
+    Status = ConvGraphWrite(&Pin->Graph, StreamHeader->Data, StreamHeader->DataUsed);
+    if (NT_SUCCESS(Status))
+        Status = MixPinStreams(Pin);
+
+    if (NT_SUCCESS(Status))
     {
-        Status = PerformSampleRateConversion(StreamHeader->Data,
-                                             StreamHeader->DataUsed,
-                                             InputFormat->WaveFormatEx.nSamplesPerSec,
-                                             OutputFormat->WaveFormatEx.nSamplesPerSec,
-                                             OutputFormat->WaveFormatEx.wBitsPerSample / 8,
-                                             OutputFormat->WaveFormatEx.nChannels,
-                                             &BufferOut,
-                                             &BufferLength);
-        if (NT_SUCCESS(Status))
-        {
-            ExFreePool(StreamHeader->Data);
-            StreamHeader->Data = BufferOut;
-            StreamHeader->DataUsed = BufferLength;
-        }
+        /* The caller keeps its buffer, the mixed frames are valid until the next write */
+        StreamHeader->Data = Pin->Graph.Output;
+        StreamHeader->DataUsed = Pin->Graph.OutputLength;
     }
 
+    ExReleaseFastMutex(&Pin->SumNode->Lock);
+    KeRestoreFloatingPointState(&FloatSave);
+
     IoStatus->Status = Status;
 
     if (NT_SUCCESS(Status))
@@ -700,23 +376,60 @@ CreatePin(
     IN PIRP Irp)
 {
     NTSTATUS Status;
-    KSOBJECT_HEADER ObjectHeader;
-    PKSDATAFORMAT DataFormat;
+    PMIXER_PIN_CONTEXT Pin;
+    PSUM_NODE_CONTEXT SumNode;
+    PCONVERSION_GRAPH *Graphs;
     PIO_STACK_LOCATION IoStack;
 
+    IoStack = IoGetCurrentIrpStackLocation(Irp);
+
+    /* the pin is mixed with the other pins of its filter */
+    ASSERT(IoStack->FileObject->RelatedFileObject);
+    SumNode = (PSUM_NODE_CONTEXT)IoStack->FileObject->RelatedFileObject->FsContext;
+    ASSERT(SumNode);
 
-    DataFormat = ExAllocatePool(NonPagedPool, sizeof(KSDATAFORMAT_WAVEFORMATEX) * 2);
-    if (!DataFormat)
+    Pin = ExAllocatePool(NonPagedPool, sizeof(MIXER_PIN_CONTEXT));
+    if (!Pin)
         return STATUS_INSUFFICIENT_RESOURCES;
 
-    RtlZeroMemory(DataFormat, sizeof(KSDATAFORMAT_WAVEFORMATEX) * 2);
-
-    IoStack = IoGetCurrentIrpStackLocation(Irp);
-    IoStack->FileObject->FsContext2 = (PVOID)DataFormat;
+    RtlZeroMemory(Pin, sizeof(MIXER_PIN_CONTEXT));
+    Pin->SumNode = SumNode;
 
     /* allocate object header */
-    Status = KsAllocateObjectHeader(&ObjectHeader, 0, NULL, Irp, &PinTable);
-    return Status;
+    Status = KsAllocateObjectHeader(&Pin->ObjectHeader, 0, NULL, Irp, &PinTable);
+    if (!NT_SUCCESS(Status))
+    {
+        ExFreePool(Pin);
+        return Status;
+    }
+
+    ExAcquireFastMutex(&SumNode->Lock);
+
+    /* make room to mix all pins, so writes don't need to allocate */
+    if (SumNode->PinCount + 1 > SumNode->GraphsSize)
+    {
+        Graphs = ExAllocatePool(NonPagedPool, (SumNode->GraphsSize + 8) * sizeof(PCONVERSION_GRAPH));
+        if (!Graphs)
+        {
+            ExReleaseFastMutex(&SumNode->Lock);
+            KsFreeObjectHeader(Pin->ObjectHeader);
+            ExFreePool(Pin);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        if (SumNode->Graphs)
+            ExFreePool(SumNode->Graphs);
+        SumNode->Graphs = Graphs;
+        SumNode->GraphsSize += 8;
+    }
+
+    InsertTailList(&SumNode->PinList, &Pin->Entry);
+    SumNode->PinCount++;
+
+    ExReleaseFastMutex(&SumNode->Lock);
+
+    IoStack->FileObject->FsContext = (PVOID)Pin;
+    return STATUS_SUCCESS;
 }
 
 void * calloc(size_t Elements, size_t ElementSize)
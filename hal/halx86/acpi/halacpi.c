@@ -24,6 +24,7 @@ FADT HalpFixedAcpiDescTable;
 PDEBUG_PORT_TABLE HalpDebugPortTable;
 PACPI_SRAT HalpAcpiSrat;
 PBOOT_TABLE HalpSimpleBootFlagTable;
+PHPET_TABLE HalpHpetTable;
 
 PHYSICAL_ADDRESS HalpMaxHotPlugMemoryAddress;
 PHYSICAL_ADDRESS HalpLowStubPhysicalAddress;
@@ -825,6 +826,9 @@ HalpSetupAcpiPhase0(IN PLOADER_PARAMETER_BLOCK LoaderBlock)
     /* Get the debug table for KD */
     HalpDebugPortTable = HalAcpiGetTable(LoaderBlock, DBGP_SIGNATURE);
 
+    /* Get the event timer table, for the HPET */
+    HalpHpetTable = HalAcpiGetTable(LoaderBlock, HPET_SIGNATURE);
+
     /* Initialize NUMA through the SRAT */
     HalpNumaInitializeStaticConfiguration(LoaderBlock);
 
@@ -955,6 +959,21 @@ HalpGetDebugPortTable(VOID)
             (HalpDebugPortTable->BaseAddress.AddressSpaceID == 1));
 }
 
+INIT_FUNCTION
+PHPET_TABLE
+NTAPI
+HalpGetHpetTable(VOID)
+{
+    /* Only memory mapped timer blocks can be used */
+    if ((HalpHpetTable) &&
+        (HalpHpetTable->BaseAddress.AddressSpaceID == 0))
+    {
+        return HalpHpetTable;
+    }
+
+    return NULL;
+}
+
 INIT_FUNCTION
 ULONG
 NTAPI
@@ -26,6 +26,7 @@ void __cdecl HackEoi(void);
 
 ULONG ApicVersion;
 UCHAR HalpVectorToIndex[256];
+static ULONG HalpNextMessageProcessor;
 
 #ifndef _M_AMD64
 const UCHAR
@@ -440,6 +441,30 @@ ApicInitializeIOApic(VOID)
     IOApicWrite(IOAPIC_REDTBL + 2 * APIC_CLOCK_INDEX, ReDirReg.Long0);
 }
 
+VOID
+NTAPI
+HalpSetClockInterruptIndex(UCHAR Index)
+{
+    IOAPIC_REDIRECTION_REGISTER ReDirReg;
+    UCHAR OldIndex = HalpVectorToIndex[APIC_CLOCK_VECTOR];
+
+    /* Mask the input the clock used so far */
+    ReDirReg = ApicReadIORedirectionEntry(OldIndex);
+    ReDirReg.Mask = 1;
+    ApicWriteIORedirectionEntry(OldIndex, ReDirReg);
+
+    /* Send the new one to the clock vector, like the original one */
+    ReDirReg.Vector = APIC_CLOCK_VECTOR;
+    ReDirReg.DeliveryMode = APIC_MT_Fixed;
+    ReDirReg.DestinationMode = APIC_DM_Physical;
+    ReDirReg.TriggerMode = APIC_TGM_Edge;
+    ReDirReg.Mask = 0;
+    ReDirReg.Destination = ApicRead(APIC_ID);
+    ApicWriteIORedirectionEntry(Index, ReDirReg);
+
+    HalpVectorToIndex[APIC_CLOCK_VECTOR] = Index;
+}
+
 VOID
 NTAPI
 HalpInitializePICs(IN BOOLEAN EnableInterrupts)
@@ -593,6 +618,107 @@ HalClearSoftwareInterrupt(
 }
 
 
+/* MESSAGE SIGNALED INTERRUPTS ************************************************/
+
+/*
+ * Message vectors don't go through the I/O APIC, so every one of them can
+ * target its own processor. Hand out the processors in the affinity mask
+ * round robin, so that the messages of a device spread over the system.
+ * Called by the PnP manager while it assigns resources, which serializes
+ * the calls.
+ */
+NTSTATUS
+NTAPI
+HalpAllocateMessageInterrupt(
+    IN KAFFINITY Affinity,
+    OUT PULONG Vector,
+    OUT PKIRQL Irql,
+    OUT PKAFFINITY TargetProcessor)
+{
+    ULONG Processor, Candidate;
+    KIRQL VectorIrql;
+
+    Affinity &= HalpDefaultInterruptAffinity;
+    if (!Affinity) Affinity = HalpDefaultInterruptAffinity;
+
+    /* Pick the next processor from the mask */
+    for (Processor = 0; Processor < sizeof(KAFFINITY) * 8; Processor++)
+    {
+        Candidate = (HalpNextMessageProcessor + Processor) % (sizeof(KAFFINITY) * 8);
+        if (Affinity & ((KAFFINITY)1 << Candidate)) break;
+    }
+    HalpNextMessageProcessor = Candidate + 1;
+
+    /* Find a free vector in a device IRQL */
+    for (*Vector = 0x30; *Vector <= MAXIMUM_IDTVECTOR; (*Vector)++)
+    {
+        if (HalpVectorToIndex[*Vector] != 0xFF) continue;
+        if (HalpIDTUsageFlags[*Vector].Flags & IDT_REGISTERED) continue;
+
+        VectorIrql = TprToIrql(*Vector);
+        if ((VectorIrql <= DISPATCH_LEVEL) || (VectorIrql > APIC_MAX_DEVICE_IRQL))
+            continue;
+
+        HalpVectorToIndex[*Vector] = APIC_MSI_INDEX;
+        *Irql = VectorIrql;
+        *TargetProcessor = (KAFFINITY)1 << Candidate;
+        return STATUS_SUCCESS;
+    }
+
+    DPRINT1("Out of message interrupt vectors\n");
+    return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+VOID
+NTAPI
+HalpFreeMessageInterrupt(
+    IN ULONG Vector)
+{
+    if ((Vector <= MAXIMUM_IDTVECTOR) &&
+        (HalpVectorToIndex[Vector] == APIC_MSI_INDEX))
+    {
+        HalpVectorToIndex[Vector] = 0xFF;
+    }
+}
+
+NTSTATUS
+NTAPI
+HalpGetMessageRoute(
+    IN ULONG Vector,
+    IN KAFFINITY TargetProcessor,
+    OUT PKIRQL Irql OPTIONAL,
+    OUT PPHYSICAL_ADDRESS MessageAddress OPTIONAL,
+    OUT PULONG MessageData OPTIONAL)
+{
+    ULONG Processor;
+
+    if ((Vector > MAXIMUM_IDTVECTOR) ||
+        (HalpVectorToIndex[Vector] != APIC_MSI_INDEX) ||
+        !TargetProcessor)
+    {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Messages target a single processor, take the lowest one */
+    for (Processor = 0; !(TargetProcessor & ((KAFFINITY)1 << Processor)); Processor++);
+
+    if (Irql) *Irql = TprToIrql(Vector);
+
+    /* Use the flat logical ID, like the I/O APIC entries do */
+    if (MessageAddress)
+    {
+        MessageAddress->QuadPart = APIC_MSI_ADDRESS_BASE |
+                                   ApicMsiDestination(ApicLogicalId(Processor)) |
+                                   APIC_MSI_ADDRESS_RH |
+                                   APIC_MSI_ADDRESS_DM;
+    }
+
+    /* Fixed delivery, edge triggered */
+    if (MessageData) *MessageData = Vector | (APIC_MT_Fixed << 8);
+
+    return STATUS_SUCCESS;
+}
+
 /* SYSTEM INTERRUPTS **********************************************************/
 
 BOOLEAN
@@ -618,6 +744,9 @@ HalEnableSystemInterrupt(
         return FALSE;
     }
 
+    /* Message vectors are masked by the device, not by us */
+    if (Index == APIC_MSI_INDEX) return TRUE;
+
     /* Read the redirection entry */
     ReDirReg = ApicReadIORedirectionEntry(Index);
 
@@ -661,6 +790,7 @@ HalDisableSystemInterrupt(
     ASSERT(Vector < RTL_NUMBER_OF(HalpVectorToIndex));
 
     Index = HalpVectorToIndex[Vector];
+    if (Index == APIC_MSI_INDEX) return;
 
     /* Read lower dword of redirection entry */
     ReDirReg.Long0 = IOApicRead(IOAPIC_REDTBL + 2 * Index);
@@ -705,7 +835,7 @@ HalBeginSystemInterrupt(
         Index = HalpVectorToIndex[Vector];
 
         /* Check if its valid */
-        if (Index != 0xff)
+        if ((Index != 0xff) && (Index != APIC_MSI_INDEX))
         {
             /* Read the I/O redirection entry */
             RedirReg = ApicReadIORedirectionEntry(Index);
@@ -38,7 +38,23 @@
 #define TprToIrql(Tpr)  (HalVectorToIRQL[Tpr >> 4])
 #endif
 
+#ifdef _M_AMD64
+#define APIC_MAX_DEVICE_IRQL 11
+#else
+#define APIC_MAX_DEVICE_IRQL 26
+#endif
+
+/* Vectors that are delivered by message rather than by an I/O APIC pin */
+#define APIC_MSI_INDEX 0xFE
+
+/* Message address and data for MSI/MSI-X, see Intel SDM 10.11 */
+#define APIC_MSI_ADDRESS_BASE    0xFEE00000
+#define APIC_MSI_ADDRESS_RH      0x00000008
+#define APIC_MSI_ADDRESS_DM      0x00000004
+#define ApicMsiDestination(Id)   ((ULONG)(Id) << 12)
+
 #define MSR_APIC_BASE 0x0000001B
+#define MSR_TSC_DEADLINE 0x000006E0
 #define IOAPIC_PHYS_BASE 0xFEC00000
 #define APIC_CLOCK_INDEX 8
 
@@ -217,8 +233,8 @@ typedef union
         ULONG RemoteIRR:1;
         ULONG TriggerMode:1;
         ULONG Mask:1;
-        ULONG TimerMode:1;
-        ULONG Reserved2MBZ:13;
+        ULONG TimerMode:2;
+        ULONG Reserved2MBZ:12;
     };
 } LVT_REGISTER;
 
@@ -282,5 +298,81 @@ VOID
 NTAPI
 HalInitializeProfiling(VOID);
 
+VOID
+NTAPI
+ApicInitializeOneShotTimer(VOID);
+
+BOOLEAN
+NTAPI
+ApicArmOneShotTimer(ULONGLONG Interval);
+
+VOID
+NTAPI
+ApicDisarmOneShotTimer(VOID);
+
+VOID
+NTAPI
+HalpInitializeDynamicTick(VOID);
+
+VOID
+NTAPI
+HalpSetClockInterruptIndex(UCHAR Index);
+
+NTSTATUS
+NTAPI
+HalpAllocateMessageInterrupt(
+    IN KAFFINITY Affinity,
+    OUT PULONG Vector,
+    OUT PKIRQL Irql,
+    OUT PKAFFINITY TargetProcessor);
+
+VOID
+NTAPI
+HalpFreeMessageInterrupt(
+    IN ULONG Vector);
+
+NTSTATUS
+NTAPI
+HalpGetMessageRoute(
+    IN ULONG Vector,
+    IN KAFFINITY TargetProcessor,
+    OUT PKIRQL Irql OPTIONAL,
+    OUT PPHYSICAL_ADDRESS MessageAddress OPTIONAL,
+    OUT PULONG MessageData OPTIONAL);
+
+/* rtctimer.c */
+extern HAL_TIMER_SOURCE HalpClockSource;
+extern ULONG HalpCurrentTimeIncrement;
+
+/* hpet.c */
+extern PHYSICAL_ADDRESS HalpHpetAddress;
+extern ULONGLONG HalpHpetFrequency;
+extern BOOLEAN HalpHpetCounter64;
+extern BOOLEAN HalpHpetClockCapable;
+
+BOOLEAN
+NTAPI
+HalpInitializeHpet(VOID);
+
+ULONGLONG
+NTAPI
+HalpReadHpetCounter(VOID);
+
+VOID
+NTAPI
+HalpHpetEnableLegacyRoute(VOID);
+
+VOID
+NTAPI
+HalpHpetStartClock(ULONG Frequency);
+
+VOID
+NTAPI
+HalpHpetStopClock(VOID);
+
+BOOLEAN
+NTAPI
+HalpHpetClockTicked(VOID);
+
 VOID __cdecl ApicSpuriousService(VOID);
 
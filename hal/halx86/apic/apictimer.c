@@ -22,6 +22,10 @@ ULONGLONG HalCurProfileInterval = 10000000;
 ULONGLONG HalMinProfileInterval = 1000;
 ULONGLONG HalMaxProfileInterval = 10000000;
 
+/* Dynamic tick variables */
+static BOOLEAN ApicTscDeadlineTimer = FALSE;
+static ULONGLONG ApicTimerFrequency = 0;
+
 /* TIMER FUNCTIONS ************************************************************/
 
 VOID
@@ -62,6 +66,117 @@ ApicInitializeTimer(ULONG Cpu)
 // KeSetTimeIncrement
 }
 
+/*
+ * The one-shot timer wakes an idle processor that suspended the periodic
+ * clock. It shares the local APIC timer with profiling, so it is only armed
+ * while profiling is off. The TSC-deadline mode is preferred when available,
+ * otherwise the timer counts down at a rate calibrated against the TSC.
+ */
+VOID
+NTAPI
+ApicInitializeOneShotTimer(VOID)
+{
+    LVT_REGISTER LvtEntry;
+    ULONGLONG TscStart, TscDelta;
+    ULONG Count;
+    INT CpuInfo[4];
+
+    /* Check for TSC-deadline support */
+    if (KeGetCurrentPrcb()->CpuID)
+    {
+        __cpuid(CpuInfo, 1);
+        if (CpuInfo[2] & (1 << 24))
+        {
+            ApicTscDeadlineTimer = TRUE;
+            ApicTimerFrequency = HalpCpuClockFrequency.QuadPart;
+            DPRINT("Using the TSC-deadline timer\n");
+            return;
+        }
+    }
+
+    /* Don't disturb a running profile */
+    if (HalIsProfiling) return;
+
+    /* Let a masked one-shot count run for about 10 ms */
+    LvtEntry.Long = 0;
+    LvtEntry.TimerMode = 0;
+    LvtEntry.Vector = APIC_PROFILE_VECTOR;
+    LvtEntry.Mask = 1;
+    ApicWrite(APIC_TMRLVTR, LvtEntry.Long);
+    ApicWrite(APIC_TICR, 0xFFFFFFFF);
+
+    TscStart = __rdtsc();
+    do
+    {
+        TscDelta = __rdtsc() - TscStart;
+    } while (TscDelta < (ULONGLONG)HalpCpuClockFrequency.QuadPart / 100);
+
+    Count = 0xFFFFFFFF - ApicRead(APIC_TCCR);
+    ApicWrite(APIC_TICR, 0);
+
+    /* Scale the count to ticks per second */
+    ApicTimerFrequency = (ULONGLONG)Count * HalpCpuClockFrequency.QuadPart / TscDelta;
+    DPRINT("Local APIC timer runs at %I64u Hz\n", ApicTimerFrequency);
+}
+
+BOOLEAN
+NTAPI
+ApicArmOneShotTimer(ULONGLONG Interval)
+{
+    LVT_REGISTER LvtEntry;
+    ULONGLONG Count;
+
+    /* The timer is busy with profiling, or could not be calibrated */
+    if (HalIsProfiling || (ApicTimerFrequency == 0)) return FALSE;
+
+    /* Convert the 100 ns interval to timer ticks */
+    Count = (Interval / 10000000) * ApicTimerFrequency +
+            (Interval % 10000000) * ApicTimerFrequency / 10000000;
+
+    LvtEntry.Long = 0;
+    LvtEntry.Vector = APIC_CLOCK_VECTOR;
+    LvtEntry.Mask = 0;
+
+    if (ApicTscDeadlineTimer)
+    {
+        LvtEntry.TimerMode = 2;
+        ApicWrite(APIC_TMRLVTR, LvtEntry.Long);
+
+        /* The LVT write must be visible before the deadline is set */
+        _mm_mfence();
+        __writemsr(MSR_TSC_DEADLINE, __rdtsc() + Count);
+    }
+    else
+    {
+        if (Count > 0xFFFFFFFF) Count = 0xFFFFFFFF;
+        if (Count == 0) Count = 1;
+
+        LvtEntry.TimerMode = 0;
+        ApicWrite(APIC_TMRLVTR, LvtEntry.Long);
+        ApicWrite(APIC_TICR, (ULONG)Count);
+    }
+
+    return TRUE;
+}
+
+VOID
+NTAPI
+ApicDisarmOneShotTimer(VOID)
+{
+    LVT_REGISTER LvtEntry;
+
+    /* Stop the count, then mask the timer */
+    if (ApicTscDeadlineTimer)
+        __writemsr(MSR_TSC_DEADLINE, 0);
+    else
+        ApicWrite(APIC_TICR, 0);
+
+    LvtEntry.Long = 0;
+    LvtEntry.Vector = APIC_PROFILE_VECTOR;
+    LvtEntry.Mask = 1;
+    ApicWrite(APIC_TMRLVTR, LvtEntry.Long);
+}
+
 
 /* PUBLIC FUNCTIONS ***********************************************************/
 
@@ -51,6 +51,11 @@ HalpInitPhase0(IN PLOADER_PARAMETER_BLOCK LoaderBlock)
                                CLOCK2_LEVEL,
                                HalpClockInterrupt,
                                Latched);
+
+    /* Message signaled interrupts go straight to the local APICs */
+    HalAllocateMessageInterrupt = HalpAllocateMessageInterrupt;
+    HalFreeMessageInterrupt = HalpFreeMessageInterrupt;
+    HalGetMessageRoute = HalpGetMessageRoute;
 }
 
 VOID
@@ -58,6 +63,9 @@ HalpInitPhase1(VOID)
 {
     /* Initialize DMA. NT does this in Phase 0 */
     HalpInitDma();
+
+    /* Let the idle loop suspend the clock */
+    HalpInitializeDynamicTick();
 }
 
 /* EOF */
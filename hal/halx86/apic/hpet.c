@@ -0,0 +1,210 @@
+/*
+ * PROJECT:     ReactOS HAL
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     High Precision Event Timer support
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* INCLUDES ******************************************************************/
+
+#include <hal.h>
+#define NDEBUG
+#include <debug.h>
+
+#include "apic.h"
+
+#if defined(ALLOC_PRAGMA) && !defined(_MINIHAL_)
+#pragma alloc_text(INIT, HalpInitializeHpet)
+#pragma alloc_text(INIT, HalpHpetEnableLegacyRoute)
+#endif
+
+/* Register offsets */
+#define HPET_GENERAL_CAPABILITIES   0x000
+#define HPET_GENERAL_CONFIGURATION  0x010
+#define HPET_MAIN_COUNTER           0x0F0
+#define HPET_TIMER_CONFIGURATION(n) (0x100 + 0x20 * (n))
+#define HPET_TIMER_COMPARATOR(n)    (0x108 + 0x20 * (n))
+
+/* General capabilities, low part */
+#define HPET_CAP_COUNTER_64BIT      0x00002000
+#define HPET_CAP_LEGACY_ROUTE       0x00008000
+
+/* General configuration */
+#define HPET_CONF_ENABLE            0x00000001
+#define HPET_CONF_LEGACY_ROUTE      0x00000002
+
+/* Timer configuration */
+#define HPET_TIMER_INT_ENABLE       0x00000004
+#define HPET_TIMER_PERIODIC         0x00000008
+#define HPET_TIMER_PERIODIC_CAP     0x00000010
+#define HPET_TIMER_VALUE_SET        0x00000040
+#define HPET_TIMER_32BIT_MODE       0x00000100
+
+/* The specification caps the counter period at 100 ns */
+#define HPET_MAXIMUM_PERIOD_FS      100000000
+
+/* The clock uses timer 0, which legacy routing connects to IRQ 0 */
+#define HPET_CLOCK_TIMER            0
+
+/* GLOBALS *******************************************************************/
+
+volatile PUCHAR HalpHpetBase;
+static ULONG HalpHpetLastComparator;
+PHYSICAL_ADDRESS HalpHpetAddress;
+ULONGLONG HalpHpetFrequency;
+BOOLEAN HalpHpetCounter64;
+BOOLEAN HalpHpetClockCapable;
+
+/* PRIVATE FUNCTIONS *********************************************************/
+
+FORCEINLINE
+ULONG
+HpetRead(ULONG Offset)
+{
+    return *(volatile ULONG *)(HalpHpetBase + Offset);
+}
+
+FORCEINLINE
+VOID
+HpetWrite(ULONG Offset, ULONG Value)
+{
+    *(volatile ULONG *)(HalpHpetBase + Offset) = Value;
+}
+
+INIT_FUNCTION
+BOOLEAN
+NTAPI
+HalpInitializeHpet(VOID)
+{
+    PHPET_TABLE HpetTable;
+    PHARDWARE_PTE Pte;
+    ULONG Capabilities, Period, Configuration;
+
+    /* Check if the firmware describes a timer block */
+    HpetTable = HalpGetHpetTable();
+    if (!HpetTable) return FALSE;
+
+    /* Map the registers uncached */
+    HalpHpetAddress = HpetTable->BaseAddress.Address;
+    HalpHpetBase = HalpMapPhysicalMemory64(HalpHpetAddress, 1);
+    if (!HalpHpetBase) return FALSE;
+
+    Pte = HalAddressToPte(HalpHpetBase);
+    Pte->CacheDisable = 1;
+    Pte->WriteThrough = 1;
+    __invlpg((PVOID)HalpHpetBase);
+
+    /* The upper part of the capabilities is the counter period */
+    Capabilities = HpetRead(HPET_GENERAL_CAPABILITIES);
+    Period = HpetRead(HPET_GENERAL_CAPABILITIES + 4);
+    if ((Period == 0) || (Period > HPET_MAXIMUM_PERIOD_FS))
+    {
+        DPRINT1("HPET at %I64x reports a bogus period of %lu fs\n",
+                HalpHpetAddress.QuadPart, Period);
+        HalpUnmapVirtualAddress((PVOID)HalpHpetBase, 1);
+        HalpHpetBase = NULL;
+        return FALSE;
+    }
+
+    HalpHpetFrequency = 1000000000000000ULL / Period;
+    HalpHpetCounter64 = (Capabilities & HPET_CAP_COUNTER_64BIT) != 0;
+
+    /* The clock needs a periodic timer 0 and legacy routing */
+    Configuration = HpetRead(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER));
+    HalpHpetClockCapable = (Capabilities & HPET_CAP_LEGACY_ROUTE) &&
+                           (Configuration & HPET_TIMER_PERIODIC_CAP);
+
+    /* Make sure the timer is quiet, then start the main counter */
+    HpetWrite(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER),
+              Configuration & ~HPET_TIMER_INT_ENABLE);
+    HpetWrite(HPET_GENERAL_CONFIGURATION,
+              HpetRead(HPET_GENERAL_CONFIGURATION) | HPET_CONF_ENABLE);
+
+    DPRINT("HPET at %I64x runs at %I64u Hz, %s counter\n",
+           HalpHpetAddress.QuadPart,
+           HalpHpetFrequency,
+           HalpHpetCounter64 ? "64-bit" : "32-bit");
+    return TRUE;
+}
+
+ULONGLONG
+NTAPI
+HalpReadHpetCounter(VOID)
+{
+#ifdef _M_AMD64
+    return *(volatile ULONGLONG *)(HalpHpetBase + HPET_MAIN_COUNTER);
+#else
+    ULONG High, Low;
+
+    /* Read the halves until the upper one is stable */
+    do
+    {
+        High = HpetRead(HPET_MAIN_COUNTER + 4);
+        Low = HpetRead(HPET_MAIN_COUNTER);
+    } while (High != HpetRead(HPET_MAIN_COUNTER + 4));
+
+    return ((ULONGLONG)High << 32) | Low;
+#endif
+}
+
+INIT_FUNCTION
+VOID
+NTAPI
+HalpHpetEnableLegacyRoute(VOID)
+{
+    /* Timer 0 replaces the PIT on IRQ 0, and timer 1 the RTC on IRQ 8 */
+    HpetWrite(HPET_GENERAL_CONFIGURATION,
+              HpetRead(HPET_GENERAL_CONFIGURATION) | HPET_CONF_LEGACY_ROUTE);
+}
+
+VOID
+NTAPI
+HalpHpetStartClock(ULONG Frequency)
+{
+    ULONG Configuration, Period, Comparator;
+
+    /* Get the number of counter ticks per interrupt */
+    Period = (ULONG)(HalpHpetFrequency / Frequency);
+
+    /* Run the comparator on the low 32 bits, which keeps this atomic */
+    Configuration = HpetRead(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER));
+    Configuration |= HPET_TIMER_INT_ENABLE | HPET_TIMER_PERIODIC |
+                     HPET_TIMER_VALUE_SET | HPET_TIMER_32BIT_MODE;
+    HpetWrite(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER), Configuration);
+
+    /* With VALUE_SET, the first write sets the comparator and the second
+       one the period that is added to it on every interrupt */
+    Comparator = (ULONG)HalpReadHpetCounter() + Period;
+    HpetWrite(HPET_TIMER_COMPARATOR(HPET_CLOCK_TIMER), Comparator);
+    KeStallExecutionProcessor(1);
+    HpetWrite(HPET_TIMER_COMPARATOR(HPET_CLOCK_TIMER), Period);
+
+    HalpHpetLastComparator = Comparator;
+}
+
+VOID
+NTAPI
+HalpHpetStopClock(VOID)
+{
+    ULONG Configuration;
+
+    Configuration = HpetRead(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER));
+    HpetWrite(HPET_TIMER_CONFIGURATION(HPET_CLOCK_TIMER),
+              Configuration & ~HPET_TIMER_INT_ENABLE);
+}
+
+BOOLEAN
+NTAPI
+HalpHpetClockTicked(VOID)
+{
+    ULONG Comparator;
+
+    /* A real tick moved the comparator on by one period */
+    Comparator = HpetRead(HPET_TIMER_COMPARATOR(HPET_CLOCK_TIMER));
+    if (Comparator == HalpHpetLastComparator) return FALSE;
+
+    HalpHpetLastComparator = Comparator;
+    return TRUE;
+}
+
+/* EOF */
@@ -13,8 +13,12 @@
 #define NDEBUG
 #include <debug.h>
 
+#include "apic.h"
+#include "tsc.h"
+
 #if defined(ALLOC_PRAGMA) && !defined(_MINIHAL_)
 #pragma alloc_text(INIT, HalpInitializeClock)
+#pragma alloc_text(INIT, HalpInitializeDynamicTick)
 #endif
 
 /* GLOBALS ********************************************************************/
@@ -24,9 +28,15 @@ BOOLEAN HalpClockSetMSRate;
 UCHAR HalpNextMSRate;
 UCHAR HalpCurrentRate = 9;  /* Initial rate  9: 128 Hz / 7.8 ms */
 ULONG HalpCurrentTimeIncrement;
+HAL_TIMER_SOURCE HalpClockSource = HalTimerSourceRtc;
 static UCHAR RtcMinimumClockRate = 6;  /* Minimum rate  6:  16 Hz / 62.5 ms */
 static UCHAR RtcMaximumClockRate = 10; /* Maximum rate 10: 256 Hz / 3.9 ms */
 
+/* Dynamic tick state, only touched by the clock processor */
+static ULONGLONG HalpLastClockTsc;
+static BOOLEAN HalpClockSuspended;
+static BOOLEAN HalpClockResync;
+
 
 FORCEINLINE
 ULONG
@@ -36,6 +46,55 @@ RtcClockRateToIncrement(UCHAR Rate)
     return (1000000 + (Freqency/2)) / Freqency;
 }
 
+FORCEINLINE
+ULONGLONG
+HalpTscToInterruptTime(ULONGLONG TscDelta)
+{
+    ULONGLONG Frequency = HalpCpuClockFrequency.QuadPart;
+
+    /* Split the division, so that long intervals don't overflow */
+    return (TscDelta / Frequency) * 10000000 +
+           (TscDelta % Frequency) * 10000000 / Frequency;
+}
+
+FORCEINLINE
+ULONG
+RtcClockRateToFrequency(UCHAR Rate)
+{
+    return (32768 << 1) >> Rate;
+}
+
+static
+VOID
+RtcEnablePeriodicInterrupt(BOOLEAN Enable)
+{
+    UCHAR RegisterB;
+
+    /* The HPET replaces the RTC at the same rates */
+    if (HalpClockSource == HalTimerSourceHpet)
+    {
+        if (Enable)
+            HalpHpetStartClock(RtcClockRateToFrequency(HalpCurrentRate));
+        else
+            HalpHpetStopClock();
+        return;
+    }
+
+    HalpAcquireCmosSpinLock();
+
+    RegisterB = HalpReadCmos(RTC_REGISTER_B);
+    if (Enable)
+        RegisterB |= RTC_REG_B_PI;
+    else
+        RegisterB &= ~RTC_REG_B_PI;
+    HalpWriteCmos(RTC_REGISTER_B, RegisterB);
+
+    /* Drop a periodic interrupt that is already latched */
+    HalpReadCmos(RTC_REGISTER_C);
+
+    HalpReleaseCmosSpinLock();
+}
+
 VOID
 RtcSetClockRate(UCHAR ClockRate)
 {
@@ -45,6 +104,13 @@ RtcSetClockRate(UCHAR ClockRate)
     HalpCurrentRate = ClockRate;
     HalpCurrentTimeIncrement = RtcClockRateToIncrement(ClockRate);
 
+    if (HalpClockSource == HalTimerSourceHpet)
+    {
+        /* Restart the HPET with the new period */
+        HalpHpetStartClock(RtcClockRateToFrequency(ClockRate));
+        return;
+    }
+
     /* Acquire CMOS lock */
     HalpAcquireCmosSpinLock();
 
@@ -76,17 +142,27 @@ HalpInitializeClock(VOID)
     EFlags = __readeflags();
     _disable();
 
-    // TODO: disable NMI
+    if (HalpHpetClockCapable)
+    {
+        /* The HPET takes over IRQ 0, which becomes the clock input */
+        HalpClockSource = HalTimerSourceHpet;
+        HalpHpetEnableLegacyRoute();
+        HalpSetClockInterruptIndex(2);
+    }
+    else
+    {
+        // TODO: disable NMI
 
-    /* Acquire CMOS lock */
-    HalpAcquireCmosSpinLock();
+        /* Acquire CMOS lock */
+        HalpAcquireCmosSpinLock();
 
-    /* Enable the periodic interrupt in the CMOS */
-    RegisterB = HalpReadCmos(RTC_REGISTER_B);
-    HalpWriteCmos(RTC_REGISTER_B, RegisterB | RTC_REG_B_PI);
+        /* Enable the periodic interrupt in the CMOS */
+        RegisterB = HalpReadCmos(RTC_REGISTER_B);
+        HalpWriteCmos(RTC_REGISTER_B, RegisterB | RTC_REG_B_PI);
 
-    /* Release CMOS lock */
-    HalpReleaseCmosSpinLock();
+        /* Release CMOS lock */
+        HalpReleaseCmosSpinLock();
+    }
 
     /* Set initial rate */
     RtcSetClockRate(HalpCurrentRate);
@@ -102,11 +178,67 @@ HalpInitializeClock(VOID)
     DPRINT1("Clock initialized\n");
 }
 
+/*
+ * Dynamic tick. The idle loop of the clock processor can stop the periodic
+ * RTC interrupt while nothing is due, and have the local APIC timer raise
+ * the clock vector once the next timer expires. Any interrupt ends the
+ * idle period; the kernel then resumes the clock and catches up with the
+ * time that passed, which is measured with the TSC.
+ */
+BOOLEAN
+NTAPI
+HalpSuspendClockTick(IN ULONGLONG Interval)
+{
+    /* Arm the wake up first, the clock keeps running if that fails */
+    if (!ApicArmOneShotTimer(Interval)) return FALSE;
+
+    RtcEnablePeriodicInterrupt(FALSE);
+    HalpClockSuspended = TRUE;
+    return TRUE;
+}
+
+ULONGLONG
+NTAPI
+HalpResumeClockTick(VOID)
+{
+    ULONGLONG Tsc, Elapsed;
+
+    ASSERT(HalpClockSuspended);
+
+    ApicDisarmOneShotTimer();
+    RtcEnablePeriodicInterrupt(TRUE);
+    HalpClockSuspended = FALSE;
+
+    /* Report the time since the last tick the kernel has seen */
+    Tsc = __rdtsc();
+    Elapsed = HalpTscToInterruptTime(Tsc - HalpLastClockTsc);
+    HalpLastClockTsc = Tsc;
+
+    /* The next tick only accounts for the time since now */
+    HalpClockResync = TRUE;
+    return Elapsed;
+}
+
+INIT_FUNCTION
+VOID
+NTAPI
+HalpInitializeDynamicTick(VOID)
+{
+    /* The kernel decides which processor may suspend the clock */
+    ApicInitializeOneShotTimer();
+    HalpLastClockTsc = __rdtsc();
+
+    HalSuspendClockTick = HalpSuspendClockTick;
+    HalResumeClockTick = HalpResumeClockTick;
+}
+
 VOID
 FASTCALL
 HalpClockInterruptHandler(IN PKTRAP_FRAME TrapFrame)
 {
     ULONG LastIncrement;
+    ULONGLONG Tsc, Elapsed;
+    BOOLEAN Ticked;
     KIRQL Irql;
 
     /* Enter trap */
@@ -123,12 +255,40 @@ HalpClockInterruptHandler(IN PKTRAP_FRAME TrapFrame)
         KiEoiHelper(TrapFrame);
     }
 
-    /* Read register C, so that the next interrupt can happen */
-    HalpReadCmos(RTC_REGISTER_C);
+    if (HalpClockSource == HalTimerSourceHpet)
+    {
+        /* Check if the comparator moved on */
+        Ticked = HalpHpetClockTicked();
+    }
+    else
+    {
+        /* Read register C, so that the next interrupt can happen */
+        Ticked = (HalpReadCmos(RTC_REGISTER_C) & RTC_REG_C_IRQ) != 0;
+    }
+
+    /* The one-shot timer only wakes the idle loop, which resumes the clock.
+       A shot that fired right before it was disarmed is dropped as well. */
+    if (HalpClockSuspended || !Ticked)
+    {
+        _disable();
+        HalEndSystemInterrupt(Irql, TrapFrame);
+        KiEoiHelper(TrapFrame);
+    }
 
     /* Save increment */
     LastIncrement = HalpCurrentTimeIncrement;
 
+    /* Remember when the kernel saw its last tick */
+    Tsc = __rdtsc();
+    if (HalpClockResync)
+    {
+        /* Only a part of a period passed since the clock resumed */
+        Elapsed = HalpTscToInterruptTime(Tsc - HalpLastClockTsc);
+        if (Elapsed < LastIncrement) LastIncrement = (ULONG)Elapsed;
+        HalpClockResync = FALSE;
+    }
+    HalpLastClockTsc = Tsc;
+
     /* Check if someone changed the time rate */
     if (HalpClockSetMSRate)
     {
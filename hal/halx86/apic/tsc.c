@@ -12,6 +12,7 @@
 #define NDEBUG
 #include <debug.h>
 
+#include "apic.h"
 #include "tsc.h"
 
 LARGE_INTEGER HalpCpuClockFrequency = {{INITIAL_STALL_COUNT * 1000000}};
@@ -20,9 +21,15 @@ UCHAR TscCalibrationPhase;
 ULONG64 TscCalibrationArray[NUM_SAMPLES];
 UCHAR HalpRtcClockVector = 0xD1;
 
+HAL_TIMER_SOURCE HalpPerformanceCounterSource = HalTimerSourceTsc;
+BOOLEAN HalpInvariantTsc;
+
 #define RTC_MODE 6 /* Mode 6 is 1024 Hz */
 #define SAMPLE_FREQENCY ((32768 << 1) >> RTC_MODE)
 
+/* Length of the calibration against the HPET, in HPET ticks */
+#define HPET_CALIBRATION_DIVISOR 40 /* 25 ms */
+
 /* PRIVATE FUNCTIONS *********************************************************/
 
 static
@@ -118,15 +125,94 @@ HalpInitializeTsc(VOID)
 
 }
 
+static
+VOID
+HalpCalibrateTscWithHpet(VOID)
+{
+    ULONG_PTR Flags;
+    ULONG64 TscStart, TscEnd, HpetStart, HpetDelta, HpetTicks;
+
+    /* Check if the CPU supports RDTSC */
+    if (!(KeGetCurrentPrcb()->FeatureBits & KF_RDTSC))
+    {
+        KeBugCheck(HAL_INITIALIZATION_FAILED);
+    }
+
+    Flags = __readeflags();
+    _disable();
+
+    /* Count TSC ticks over a fixed number of HPET ticks */
+    HpetTicks = HalpHpetFrequency / HPET_CALIBRATION_DIVISOR;
+    HpetStart = HalpReadHpetCounter();
+    TscStart = __rdtsc();
+    do
+    {
+        HpetDelta = HalpReadHpetCounter() - HpetStart;
+        if (!HalpHpetCounter64) HpetDelta &= 0xFFFFFFFF;
+    } while (HpetDelta < HpetTicks);
+    TscEnd = __rdtsc();
+
+    HalpCpuClockFrequency.QuadPart = (TscEnd - TscStart) * HalpHpetFrequency / HpetDelta;
+
+    __writeeflags(Flags);
+}
+
+static
+VOID
+HalpDetectInvariantTsc(VOID)
+{
+    INT CpuInfo[4];
+
+    if (!KeGetCurrentPrcb()->CpuID) return;
+
+    /* The advanced power management leaf reports an invariant TSC */
+    __cpuid(CpuInfo, 0x80000000);
+    if ((ULONG)CpuInfo[0] < 0x80000007) return;
+
+    __cpuid(CpuInfo, 0x80000007);
+    HalpInvariantTsc = (CpuInfo[3] & 0x100) != 0;
+}
+
 VOID
 NTAPI
 HalpCalibrateStallExecution(VOID)
 {
     // Timer interrupt is now active
 
-    HalpInitializeTsc();
+    /* The HPET is a better reference than the RTC, if there is one */
+    if (HalpInitializeHpet())
+        HalpCalibrateTscWithHpet();
+    else
+        HalpInitializeTsc();
 
     KeGetPcr()->StallScaleFactor = (ULONG)(HalpCpuClockFrequency.QuadPart / 1000000);
+
+    /* Only an invariant TSC keeps its rate across P- and C-states. Without
+       one, fall back to the HPET for the performance counter, but only if
+       its counter does not wrap within a few minutes. */
+    HalpDetectInvariantTsc();
+    if (!HalpInvariantTsc && HalpHpetFrequency && HalpHpetCounter64)
+        HalpPerformanceCounterSource = HalTimerSourceHpet;
+
+    DPRINT("TSC runs at %I64u Hz, %s\n",
+           HalpCpuClockFrequency.QuadPart,
+           HalpInvariantTsc ? "invariant" : "variant");
+}
+
+VOID
+NTAPI
+HalpQueryPlatformTimerInformation(OUT PHAL_PLATFORM_TIMER_INFORMATION TimerInformation)
+{
+    RtlZeroMemory(TimerInformation, sizeof(*TimerInformation));
+    TimerInformation->ClockSource = HalpClockSource;
+    TimerInformation->PerformanceCounterSource = HalpPerformanceCounterSource;
+    KeQueryPerformanceCounter(&TimerInformation->PerformanceFrequency);
+    TimerInformation->ClockIncrement = HalpCurrentTimeIncrement;
+    TimerInformation->InvariantTsc = HalpInvariantTsc;
+    /* The APIC HALs only run on the boot processor for now */
+    TimerInformation->TscSynchronized = (KeNumberProcessors == 1);
+    TimerInformation->HpetAddress = HalpHpetAddress;
+    TimerInformation->HpetFrequency = HalpHpetFrequency;
 }
 
 /* PUBLIC FUNCTIONS ***********************************************************/
@@ -141,6 +227,15 @@ KeQueryPerformanceCounter(
     /* Make sure it's calibrated */
     ASSERT(HalpCpuClockFrequency.QuadPart != 0);
 
+    if (HalpPerformanceCounterSource == HalTimerSourceHpet)
+    {
+        if (PerformanceFrequency)
+            PerformanceFrequency->QuadPart = HalpHpetFrequency;
+
+        Result.QuadPart = HalpReadHpetCounter();
+        return Result;
+    }
+
     /* Does the caller want the frequency? */
     if (PerformanceFrequency)
     {
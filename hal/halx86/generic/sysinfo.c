@@ -53,7 +53,16 @@ HaliQuerySystemInformation(IN HAL_QUERY_INFORMATION_CLASS InformationClass,
 		REPORT_THIS_CASE(HalFrequencyInformation);
 		REPORT_THIS_CASE(HalProcessorBrandString);
 		REPORT_THIS_CASE(HalHypervisorInformation);
-		REPORT_THIS_CASE(HalPlatformTimerInformation);
+		case HalPlatformTimerInformation:
+		{
+            /* Report the clock and performance counter sources */
+            if (BufferSize < sizeof(HAL_PLATFORM_TIMER_INFORMATION))
+                return STATUS_INFO_LENGTH_MISMATCH;
+
+            HalpQueryPlatformTimerInformation(Buffer);
+            *ReturnedLength = sizeof(HAL_PLATFORM_TIMER_INFORMATION);
+            return STATUS_SUCCESS;
+		}
 		REPORT_THIS_CASE(HalAcpiAuditInformation);
 	}
 #undef REPORT_THIS_CASE
@@ -196,6 +196,18 @@ HalpProfileInterruptHandler(IN PKTRAP_FRAME TrapFrame)
 
 #endif
 
+VOID
+NTAPI
+HalpQueryPlatformTimerInformation(OUT PHAL_PLATFORM_TIMER_INFORMATION TimerInformation)
+{
+    /* The PIT drives both the clock and the performance counter */
+    RtlZeroMemory(TimerInformation, sizeof(*TimerInformation));
+    TimerInformation->ClockSource = HalTimerSourcePit;
+    TimerInformation->PerformanceCounterSource = HalTimerSourcePit;
+    TimerInformation->PerformanceFrequency.QuadPart = PIT_FREQUENCY;
+    TimerInformation->ClockIncrement = HalpCurrentTimeIncrement;
+}
+
 /* PUBLIC FUNCTIONS ***********************************************************/
 
 /*
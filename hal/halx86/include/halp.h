@@ -233,6 +233,12 @@ VOID
 NTAPI
 HalpCalibrateStallExecution(VOID);
 
+VOID
+NTAPI
+HalpQueryPlatformTimerInformation(
+    OUT PHAL_PLATFORM_TIMER_INFORMATION TimerInformation
+);
+
 /* pci.c */
 VOID HalpInitPciBus (VOID);
 
@@ -436,6 +442,13 @@ HalpGetDebugPortTable(
     VOID
 );
 
+INIT_FUNCTION
+PHPET_TABLE
+NTAPI
+HalpGetHpetTable(
+    VOID
+);
+
 INIT_FUNCTION
 VOID
 NTAPI
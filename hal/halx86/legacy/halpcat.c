@@ -16,6 +16,7 @@
 //#pragma alloc_text(INIT, HaliInitPnpDriver)
 #pragma alloc_text(INIT, HalpBuildAddressMap)
 #pragma alloc_text(INIT, HalpGetDebugPortTable)
+#pragma alloc_text(INIT, HalpGetHpetTable)
 #pragma alloc_text(INIT, HalpIs16BitPortDecodeSupported)
 #pragma alloc_text(INIT, HalpSetupAcpiPhase0)
 #pragma alloc_text(INIT, HalReportResourceUsage)
@@ -65,6 +66,15 @@ HalpGetDebugPortTable(VOID)
     return FALSE;
 }
 
+INIT_FUNCTION
+PHPET_TABLE
+NTAPI
+HalpGetHpetTable(VOID)
+{
+    /* No ACPI */
+    return NULL;
+}
+
 INIT_FUNCTION
 ULONG
 NTAPI
@@ -426,7 +426,7 @@ list(APPEND SOURCE_CRTDLL
 #    mblen.c
     mbstowcs.c
     mbtowc.c
-#    memchr.c
+    memchr.c
 #    memcmp.c
 #    memcpy.c
 #    memmove.c
@@ -505,7 +505,7 @@ list(APPEND SOURCE_CRTDLL
 #    wcscpy.c
 #    wcscspn.c
 #    wcsftime.c
-#    wcslen.c
+    wcslen.c
 #    wcsncat.c
 #    wcsncmp.c
 #    wcsncpy.c
@@ -0,0 +1,139 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for memchr
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <apitest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_PAGE_SIZE  0x1000
+#define FUZZ_ROUNDS     20000
+#define BENCH_SIZE      (64 * 1024)
+#define BENCH_ROUNDS    2000
+
+static
+void *
+ReferenceMemchr(const void *s, int c, size_t n)
+{
+    const unsigned char *p = s;
+
+    for (; n != 0; p++, n--)
+    {
+        if (*p == (unsigned char)c)
+            return (void *)p;
+    }
+    return NULL;
+}
+
+/* Buffers end right in front of an inaccessible page */
+static
+PUCHAR
+AllocateGuarded(void)
+{
+    PUCHAR Buffer;
+    DWORD OldProtect;
+
+    Buffer = VirtualAlloc(NULL, 2 * TEST_PAGE_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!Buffer)
+        return NULL;
+    VirtualProtect(Buffer + TEST_PAGE_SIZE, TEST_PAGE_SIZE, PAGE_NOACCESS, &OldProtect);
+    return Buffer;
+}
+
+static
+void
+Test_Fuzz(void)
+{
+    PUCHAR Page;
+    ULONG Round, Failures = 0;
+    size_t Offset, Length, i;
+    int c;
+
+    Page = AllocateGuarded();
+    if (!Page)
+    {
+        skip("VirtualAlloc failed\n");
+        return;
+    }
+
+    srand(42);
+    for (Round = 0; Round < FUZZ_ROUNDS; Round++)
+    {
+        Length = rand() % 300;
+        if (rand() & 1)
+            Offset = rand() % 64;
+        else
+            Offset = TEST_PAGE_SIZE - Length;
+        for (i = 0; i < Length; i++)
+            Page[Offset + i] = (UCHAR)(1 + rand() % 8);
+        c = rand() % 10;
+
+        /* Only the low byte of c counts */
+        if (memchr(Page + Offset, c | 0x100, Length) != ReferenceMemchr(Page + Offset, c, Length))
+        {
+            if (Failures++ < 10)
+                ok(FALSE, "Mismatch for offset %Iu, length %Iu, c %d\n", Offset, Length, c);
+        }
+    }
+    ok(Failures == 0, "%lu mismatches\n", Failures);
+
+    /* Matches past the end must not count, even in the same block */
+    memset(Page, 0, TEST_PAGE_SIZE);
+    Page[40] = 7;
+    ok(memchr(Page + 3, 7, 37) == NULL, "Found a match past the end\n");
+    ok(memchr(Page + 3, 7, 38) == Page + 40, "Missed the last byte\n");
+    ok(memchr(Page + 41, 7, 0) == NULL, "Found a match in an empty buffer\n");
+
+    /* Nor the ones in front of the start */
+    ok(memchr(Page + 41, 7, 10) == NULL, "Found a match before the start\n");
+
+    /* A length larger than the buffer is fine as long as there is a match */
+    ok(memchr(Page + 1, 7, (size_t)-1) == Page + 40, "Unbounded search failed\n");
+
+    VirtualFree(Page, 0, MEM_RELEASE);
+}
+
+static
+void
+Test_Benchmark(void)
+{
+    PUCHAR Buffer;
+    LARGE_INTEGER Start, Middle, End, Frequency;
+    ULONG Round;
+    volatile ULONG_PTR Sum = 0;
+
+    Buffer = malloc(BENCH_SIZE);
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+    memset(Buffer, 'a', BENCH_SIZE);
+    Buffer[BENCH_SIZE - 1] = 'b';
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+        Sum += (ULONG_PTR)ReferenceMemchr(Buffer + (Round & 7), 'b', BENCH_SIZE - 8);
+    QueryPerformanceCounter(&Middle);
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+        Sum += (ULONG_PTR)memchr(Buffer + (Round & 7), 'b', BENCH_SIZE - 8);
+    QueryPerformanceCounter(&End);
+
+    trace("memchr over %u KB: %I64u us byte by byte, %I64u us exported\n",
+          BENCH_SIZE / 1024,
+          (Middle.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart,
+          (End.QuadPart - Middle.QuadPart) * 1000000 / Frequency.QuadPart);
+
+    free(Buffer);
+}
+
+START_TEST(memchr)
+{
+    Test_Fuzz();
+    Test_Benchmark();
+}
@@ -1120,7 +1120,7 @@ list(APPEND SOURCE_MSVCRT
     mbstowcs.c
 #    mbstowcs_s Not exported in 2k3 Sp1
     mbtowc.c
-#    memchr.c
+    memchr.c
 #    memcmp.c
 #    memcpy.c
 #    memcpy_s.c memmove_s
@@ -1233,7 +1233,7 @@ list(APPEND SOURCE_MSVCRT
 #    wcscpy_s.c
 #    wcscspn.c
 #    wcsftime.c
-#    wcslen.c
+    wcslen.c
 #    wcsncat.c
 #    wcsncat_s.c
 #    wcsncmp.c
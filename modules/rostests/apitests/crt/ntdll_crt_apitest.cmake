@@ -73,7 +73,7 @@ list(APPEND SOURCE_NTDLL
 #    log.c
     mbstowcs.c
     mbtowc.c
-#    memchr.c
+    memchr.c
 #    memcmp.c
     # memcpy == memmove
 #    memmove.c
@@ -111,7 +111,7 @@ list(APPEND SOURCE_NTDLL
 #    wcscmp.c
 #    wcscpy.c
 #    wcscspn.c
-#    wcslen.c
+    wcslen.c
 #    wcsncat.c
 #    wcsncmp.c
 #    wcsncpy.c
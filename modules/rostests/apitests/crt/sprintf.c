@@ -10,6 +10,7 @@
 
 #define WIN32_NO_STATUS
 #include <stdio.h>
+#include <string.h>
 #include <tchar.h>
 #include <pseh/pseh2.h>
 #include <ndk/mmfuncs.h>
@@ -26,6 +27,73 @@
 #endif
 #endif
 
+#if defined(TEST_MSVCRT) || defined(TEST_STATIC_CRT)
+static
+void
+Test_Float(void)
+{
+    CHAR Buffer[400];
+
+    /* Rounding is done on the exact value, halfway cases away from zero */
+    sprintf(Buffer, "%.0f", 0.5); ok_str(Buffer, "1");
+    sprintf(Buffer, "%.0f", 2.5); ok_str(Buffer, "3");
+    sprintf(Buffer, "%.0f", 0.6); ok_str(Buffer, "1");
+    sprintf(Buffer, "%.2f", 1.005); ok_str(Buffer, "1.00");
+    sprintf(Buffer, "%.1f", 0.05); ok_str(Buffer, "0.1");
+    sprintf(Buffer, "%.3f", 0.0006); ok_str(Buffer, "0.001");
+    sprintf(Buffer, "%.0e", 9.5); ok_str(Buffer, "1e+001");
+    sprintf(Buffer, "%2.4e", 8.6); ok_str(Buffer, "8.6000e+000");
+    sprintf(Buffer, "%+#23.15e", 789456123.); ok_str(Buffer, "+7.894561230000000e+008");
+    sprintf(Buffer, "%e", 4.9e-324); ok_str(Buffer, "4.940656e-324");
+
+    /* Only 17 significant digits are printed, the rest is zeroes */
+    sprintf(Buffer, "%.20f", 0.1); ok_str(Buffer, "0.10000000000000001000");
+    sprintf(Buffer, "%.0f", 1e23); ok_str(Buffer, "99999999999999992000000");
+    sprintf(Buffer, "%f", 1.7976931348623157e308);
+    ok_int(strlen(Buffer), 316);
+    ok(!strncmp(Buffer, "17976931348623157000", 20), "Got %s\n", Buffer);
+
+    /* %g switches to %e for exponents below -4 or from the precision on */
+    sprintf(Buffer, "%g", 0.); ok_str(Buffer, "0");
+    sprintf(Buffer, "%g", 100000.); ok_str(Buffer, "100000");
+    sprintf(Buffer, "%g", 999999.5); ok_str(Buffer, "1e+006");
+    sprintf(Buffer, "%g", 0.0001); ok_str(Buffer, "0.0001");
+    sprintf(Buffer, "%g", 0.00001); ok_str(Buffer, "1e-005");
+    sprintf(Buffer, "%g", 123456789.); ok_str(Buffer, "1.23457e+008");
+    sprintf(Buffer, "%g", 0.000123456789); ok_str(Buffer, "0.000123457");
+    sprintf(Buffer, "%#g", 1.); ok_str(Buffer, "1.00000");
+    sprintf(Buffer, "%#1.1g", 789456123.); ok_str(Buffer, "8.e+008");
+}
+
+static
+void
+Test_FloatBenchmark(void)
+{
+    CHAR Buffer[64];
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG i;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (i = 0; i < 100000; i++)
+    {
+        sprintf(Buffer, "%g %.3f %e", i * 1.37, i * 0.01, i * 1e-7);
+    }
+    QueryPerformanceCounter(&End);
+    trace("100000 float sprintf calls: %I64u us\n",
+          (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart);
+
+    QueryPerformanceCounter(&Start);
+    for (i = 0; i < 100000; i++)
+    {
+        sprintf(Buffer, "%u %x %I64d", i * 7919, i, i * 1000003ll);
+    }
+    QueryPerformanceCounter(&End);
+    trace("100000 integer sprintf calls: %I64u us\n",
+          (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart);
+}
+#endif
+
 /* NOTE: This test is not only used for all the CRT apitests, but also for
  *       user32's wsprintf. Make sure to test them all */
 START_TEST(sprintf)
@@ -257,4 +325,9 @@ START_TEST(sprintf)
     EndSeh(STATUS_SUCCESS);
 
     FreeGuarded(String);
+
+#if defined(TEST_MSVCRT) || defined(TEST_STATIC_CRT)
+    Test_Float();
+    Test_FloatBenchmark();
+#endif
 }
@@ -0,0 +1,121 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for wcslen
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <apitest.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_PAGE_SIZE  0x1000
+#define FUZZ_ROUNDS     20000
+#define BENCH_CHARS     (32 * 1024)
+#define BENCH_ROUNDS    2000
+
+static
+size_t
+ReferenceWcslen(const WCHAR *str)
+{
+    const WCHAR *s;
+
+    for (s = str; *s; s++);
+    return s - str;
+}
+
+static
+void
+Test_Fuzz(void)
+{
+    PUCHAR Page;
+    PWCHAR String;
+    DWORD OldProtect;
+    ULONG Round, Failures = 0;
+    size_t Offset, Length, i;
+
+    /* Strings end right in front of an inaccessible page */
+    Page = VirtualAlloc(NULL, 2 * TEST_PAGE_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!Page)
+    {
+        skip("VirtualAlloc failed\n");
+        return;
+    }
+    VirtualProtect(Page + TEST_PAGE_SIZE, TEST_PAGE_SIZE, PAGE_NOACCESS, &OldProtect);
+
+    srand(42);
+    for (Round = 0; Round < FUZZ_ROUNDS; Round++)
+    {
+        Length = rand() % 200;
+        if (rand() & 1)
+            Offset = rand() % 64;
+        else
+            Offset = TEST_PAGE_SIZE - (Length + 1) * sizeof(WCHAR) - (rand() & 1);
+
+        /* Odd addresses are legal too, if slow */
+        String = (PWCHAR)(Page + Offset);
+        for (i = 0; i < Length; i++)
+            String[i] = (WCHAR)(1 + rand() % 0x300);
+        String[Length] = 0;
+
+        if (wcslen(String) != Length)
+        {
+            if (Failures++ < 10)
+                ok(FALSE, "Got %Iu for offset %Iu, length %Iu\n", wcslen(String), Offset, Length);
+        }
+    }
+    ok(Failures == 0, "%lu mismatches\n", Failures);
+
+    /* Zero bytes that are not a zero character don't end the string */
+    String = (PWCHAR)Page;
+    String[0] = 0x100;
+    String[1] = 0x001;
+    String[2] = 0;
+    ok_int((int)wcslen(String), 2);
+
+    VirtualFree(Page, 0, MEM_RELEASE);
+}
+
+static
+void
+Test_Benchmark(void)
+{
+    PWCHAR Buffer;
+    LARGE_INTEGER Start, Middle, End, Frequency;
+    ULONG Round;
+    volatile size_t Sum = 0;
+    size_t i;
+
+    Buffer = malloc(BENCH_CHARS * sizeof(WCHAR));
+    if (!Buffer)
+    {
+        skip("Out of memory\n");
+        return;
+    }
+    for (i = 0; i < BENCH_CHARS - 1; i++)
+        Buffer[i] = L'a';
+    Buffer[BENCH_CHARS - 1] = 0;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+        Sum += ReferenceWcslen(Buffer + (Round & 7));
+    QueryPerformanceCounter(&Middle);
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+        Sum += wcslen(Buffer + (Round & 7));
+    QueryPerformanceCounter(&End);
+
+    trace("wcslen over %u KB: %I64u us char by char, %I64u us exported\n",
+          BENCH_CHARS * sizeof(WCHAR) / 1024,
+          (Middle.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart,
+          (End.QuadPart - Middle.QuadPart) * 1000000 / Frequency.QuadPart);
+
+    free(Buffer);
+}
+
+START_TEST(wcslen)
+{
+    Test_Fuzz();
+    Test_Benchmark();
+}
@@ -0,0 +1,233 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for batched drawing calls
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define RED     RGB(0xff, 0, 0)
+#define GREEN   RGB(0, 0xff, 0)
+#define BLUE    RGB(0, 0, 0xff)
+#define WHITE   RGB(0xff, 0xff, 0xff)
+
+#define BENCH_CALLS 20000
+
+static
+HDC
+CreateTargetDC(HBITMAP *phbmp)
+{
+    HDC hdc;
+
+    /* DIB sections are drawn to directly and bypass the batch */
+    hdc = CreateCompatibleDC(NULL);
+    *phbmp = CreateBitmap(64, 64, 1, 32, NULL);
+    SelectObject(hdc, *phbmp);
+    PatBlt(hdc, 0, 0, 64, 64, WHITENESS);
+    return hdc;
+}
+
+static
+void
+DeleteTargetDC(HDC hdc, HBITMAP hbmp)
+{
+    DeleteDC(hdc);
+    DeleteObject(hbmp);
+}
+
+static
+void
+Test_Lines(void)
+{
+    HDC hdc;
+    HBITMAP hbmp;
+    HPEN hpenRed, hpenBlue, hpenOld;
+    POINT apt[3] = {{0, 20}, {10, 20}, {10, 30}};
+    POINT pt;
+
+    hdc = CreateTargetDC(&hbmp);
+    hpenRed = CreatePen(PS_SOLID, 1, RED);
+    hpenBlue = CreatePen(PS_SOLID, 1, BLUE);
+
+    /* Pen changes between queued lines must not leak into earlier ones */
+    hpenOld = SelectObject(hdc, hpenRed);
+    MoveToEx(hdc, 0, 0, NULL);
+    LineTo(hdc, 10, 0);
+    SelectObject(hdc, hpenBlue);
+    MoveToEx(hdc, 0, 5, NULL);
+    LineTo(hdc, 10, 5);
+    LineTo(hdc, 10, 15);
+    SetDCPenColor(hdc, GREEN);
+    SelectObject(hdc, GetStockObject(DC_PEN));
+    Polyline(hdc, apt, 3);
+    SelectObject(hdc, hpenRed);
+    MoveToEx(hdc, 20, 0, NULL);
+    PolylineTo(hdc, apt + 1, 2);
+
+    ok(GetCurrentPositionEx(hdc, &pt), "GetCurrentPositionEx failed\n");
+    ok(pt.x == 10 && pt.y == 30, "Current position is (%ld, %ld)\n", pt.x, pt.y);
+
+    ok_long(GetPixel(hdc, 5, 0), RED);
+    ok_long(GetPixel(hdc, 5, 5), BLUE);
+    ok_long(GetPixel(hdc, 10, 10), BLUE);
+    ok_long(GetPixel(hdc, 5, 20), GREEN);
+    ok_long(GetPixel(hdc, 15, 10), RED);
+
+    SelectObject(hdc, hpenOld);
+    DeleteObject(hpenRed);
+    DeleteObject(hpenBlue);
+    DeleteTargetDC(hdc, hbmp);
+}
+
+static
+void
+Test_Shapes(void)
+{
+    HDC hdc;
+    HBITMAP hbmp;
+    HBRUSH hbrRed, hbrOld;
+
+    hdc = CreateTargetDC(&hbmp);
+    hbrRed = CreateSolidBrush(RED);
+
+    hbrOld = SelectObject(hdc, hbrRed);
+    Rectangle(hdc, 0, 0, 20, 20);
+    SelectObject(hdc, GetStockObject(DC_BRUSH));
+    SetDCBrushColor(hdc, BLUE);
+    Ellipse(hdc, 20, 0, 40, 20);
+    SetDCBrushColor(hdc, GREEN);
+    Rectangle(hdc, 40, 0, 60, 20);
+
+    ok_long(GetPixel(hdc, 10, 10), RED);
+    ok_long(GetPixel(hdc, 30, 10), BLUE);
+    ok_long(GetPixel(hdc, 50, 10), GREEN);
+
+    /* A mode change has to wait for the shapes queued before it */
+    Rectangle(hdc, 0, 30, 20, 50);
+    SetROP2(hdc, R2_NOT);
+    Rectangle(hdc, 20, 30, 40, 50);
+    SetROP2(hdc, R2_COPYPEN);
+
+    ok_long(GetPixel(hdc, 10, 40), GREEN);
+    ok_long(GetPixel(hdc, 30, 40), RGB(0, 0, 0));
+
+    SelectObject(hdc, hbrOld);
+    DeleteObject(hbrRed);
+    DeleteTargetDC(hdc, hbmp);
+}
+
+static
+void
+Test_Pixels(void)
+{
+    HDC hdc;
+    HBITMAP hbmp;
+    ULONG i;
+
+    hdc = CreateTargetDC(&hbmp);
+
+    for (i = 0; i < 64; i++)
+    {
+        ok(SetPixelV(hdc, i, i, (i & 1) ? RED : BLUE), "SetPixelV failed\n");
+    }
+
+    ok_long(GetPixel(hdc, 0, 0), BLUE);
+    ok_long(GetPixel(hdc, 31, 31), RED);
+    ok_long(GetPixel(hdc, 63, 63), RED);
+    ok_long(GetPixel(hdc, 1, 0), WHITE);
+
+    DeleteTargetDC(hdc, hbmp);
+}
+
+static
+void
+Test_BitBlt(void)
+{
+    HDC hdcSrc, hdcDst;
+    HBITMAP hbmpSrc, hbmpDst;
+
+    hdcSrc = CreateTargetDC(&hbmpSrc);
+    hdcDst = CreateTargetDC(&hbmpDst);
+
+    /* BitBlt is not batched, it has to see what was queued on the source */
+    SetPixelV(hdcSrc, 0, 0, RED);
+    BitBlt(hdcDst, 0, 0, 2, 2, hdcSrc, 0, 0, SRCCOPY);
+    SetPixelV(hdcSrc, 0, 0, BLUE);
+    SetPixelV(hdcSrc, 1, 1, BLUE);
+
+    ok_long(GetPixel(hdcDst, 0, 0), RED);
+    ok_long(GetPixel(hdcDst, 1, 1), WHITE);
+    ok_long(GetPixel(hdcSrc, 0, 0), BLUE);
+
+    /* Only the blits after a source origin change see it */
+    BitBlt(hdcDst, 10, 10, 1, 1, hdcSrc, 1, 1, SRCCOPY);
+    SetViewportOrgEx(hdcSrc, 1, 1, NULL);
+    BitBlt(hdcDst, 11, 11, 1, 1, hdcSrc, 0, 0, SRCCOPY);
+    SetViewportOrgEx(hdcSrc, 0, 0, NULL);
+
+    ok_long(GetPixel(hdcDst, 10, 10), BLUE);
+    ok_long(GetPixel(hdcDst, 11, 11), BLUE);
+
+    DeleteTargetDC(hdcSrc, hbmpSrc);
+    DeleteTargetDC(hdcDst, hbmpDst);
+}
+
+static
+ULONGLONG
+DrawLines(HDC hdc)
+{
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG i;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (i = 0; i < BENCH_CALLS; i++)
+    {
+        MoveToEx(hdc, i % 64, 0, NULL);
+        LineTo(hdc, 63 - (i % 64), 63);
+    }
+    GdiFlush();
+    QueryPerformanceCounter(&End);
+
+    return (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+}
+
+static
+void
+Test_Benchmark(void)
+{
+    HDC hdc;
+    HBITMAP hbmp;
+    DWORD OldLimit;
+    ULONGLONG Unbatched, Batched;
+
+    hdc = CreateTargetDC(&hbmp);
+
+    OldLimit = GdiSetBatchLimit(1);
+    Unbatched = DrawLines(hdc);
+    GdiSetBatchLimit(0);
+    Batched = DrawLines(hdc);
+    GdiSetBatchLimit(OldLimit);
+
+    trace("%u lines: %I64u us unbatched, %I64u us batched (%I64u%%)\n",
+          BENCH_CALLS, Unbatched, Batched,
+          Unbatched ? Batched * 100 / Unbatched : 0);
+
+    DeleteTargetDC(hdc, hbmp);
+}
+
+START_TEST(GdiBatch)
+{
+    DWORD OldLimit;
+
+    OldLimit = GdiSetBatchLimit(0);
+
+    Test_Lines();
+    Test_Shapes();
+    Test_Pixels();
+    Test_BitBlt();
+    Test_Benchmark();
+
+    GdiSetBatchLimit(OldLimit);
+}
@@ -0,0 +1,146 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and TLB benchmark for MEM_LARGE_PAGES allocations
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#include <ndk/setypes.h>
+
+#define BENCH_SIZE      (8 * 1024 * 1024)
+#define BENCH_ROUNDS    200
+
+/* Visits every page once per round, in an order no prefetcher can follow */
+static
+ULONGLONG
+WalkPages(
+    _In_ volatile UCHAR *Buffer,
+    _In_ SIZE_T Size)
+{
+    SIZE_T Pages = Size / PAGE_SIZE, Page = 0, i;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG Round, Sum = 0;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Start);
+    for (Round = 0; Round < BENCH_ROUNDS; Round++)
+    {
+        for (i = 0; i < Pages; i++)
+        {
+            Sum += Buffer[Page * PAGE_SIZE];
+            Page = (Page + 4099) % Pages;
+        }
+    }
+    QueryPerformanceCounter(&End);
+
+    ok(Sum == 0, "Sum = %lu\n", Sum);
+    return (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+}
+
+static
+VOID
+TestAllocation(
+    _In_ SIZE_T Minimum)
+{
+    MEMORY_BASIC_INFORMATION Info;
+    PUCHAR Buffer;
+    SIZE_T i;
+    BOOL Ret;
+
+    /* Large pages must be committed right away */
+    SetLastError(0xdeadbeef);
+    Buffer = VirtualAlloc(NULL, Minimum, MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(Buffer == NULL, "Reserved large pages at %p\n", Buffer);
+    ok_err(ERROR_INVALID_PARAMETER);
+
+    Buffer = VirtualAlloc(NULL, Minimum, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ok(Buffer != NULL, "VirtualAlloc failed with %lu\n", GetLastError());
+    if (!Buffer)
+        return;
+
+    ok(((ULONG_PTR)Buffer & (Minimum - 1)) == 0, "Buffer %p is not aligned\n", Buffer);
+    for (i = 0; i < Minimum; i += PAGE_SIZE)
+    {
+        if (Buffer[i] != 0)
+        {
+            ok(FALSE, "Buffer[%Iu] = %u\n", i, Buffer[i]);
+            break;
+        }
+    }
+    Buffer[Minimum - 1] = 0x55;
+
+    Ret = VirtualQuery(Buffer + PAGE_SIZE, &Info, sizeof(Info));
+    ok(Ret == sizeof(Info), "VirtualQuery returned %d\n", Ret);
+    ok(Info.BaseAddress == Buffer, "BaseAddress = %p\n", Info.BaseAddress);
+    ok(Info.RegionSize == Minimum, "RegionSize = %Iu\n", Info.RegionSize);
+    ok(Info.State == MEM_COMMIT, "State = 0x%lx\n", Info.State);
+    ok(Info.Protect == PAGE_READWRITE, "Protect = 0x%lx\n", Info.Protect);
+
+    /* They can only go as a whole */
+    SetLastError(0xdeadbeef);
+    Ret = VirtualFree(Buffer + PAGE_SIZE, PAGE_SIZE, MEM_RELEASE);
+    ok(Ret == FALSE, "Released part of a large page\n");
+
+    Ret = VirtualFree(Buffer, 0, MEM_RELEASE);
+    ok(Ret == TRUE, "VirtualFree failed with %lu\n", GetLastError());
+}
+
+static
+VOID
+TestTlbBenchmark(
+    _In_ SIZE_T Minimum)
+{
+    SIZE_T Size = ALIGN_UP_BY(BENCH_SIZE, Minimum);
+    PUCHAR Small, Large;
+    ULONGLONG SmallTime, LargeTime;
+
+    Small = VirtualAlloc(NULL, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    Large = VirtualAlloc(NULL, Size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+    if (!Small || !Large)
+    {
+        skip("Not enough memory for the benchmark\n");
+    }
+    else
+    {
+        /* Fault the small pages in first, only the TLB misses should count */
+        WalkPages(Small, Size);
+
+        SmallTime = WalkPages(Small, Size);
+        LargeTime = WalkPages(Large, Size);
+        trace("Page walk over %Iu KB: %I64u us with small pages, %I64u us with large pages (%I64u%%)\n",
+              Size / 1024, SmallTime, LargeTime,
+              SmallTime ? LargeTime * 100 / SmallTime : 0);
+    }
+
+    if (Small) VirtualFree(Small, 0, MEM_RELEASE);
+    if (Large) VirtualFree(Large, 0, MEM_RELEASE);
+}
+
+START_TEST(LargePages)
+{
+    NTSTATUS Status;
+    BOOLEAN WasEnabled;
+    SIZE_T Minimum;
+
+    Minimum = GetLargePageMinimum();
+    if (!Minimum)
+    {
+        skip("No large page support\n");
+        return;
+    }
+    ok((Minimum & (Minimum - 1)) == 0, "Minimum = %Iu\n", Minimum);
+
+    Status = RtlAdjustPrivilege(SE_LOCK_MEMORY_PRIVILEGE, TRUE, FALSE, &WasEnabled);
+    if (!NT_SUCCESS(Status))
+    {
+        skip("RtlAdjustPrivilege(SE_LOCK_MEMORY_PRIVILEGE) failed (Status 0x%08lx)\n", Status);
+        return;
+    }
+
+    TestAllocation(Minimum);
+    TestTlbBenchmark(Minimum);
+
+    RtlAdjustPrivilege(SE_LOCK_MEMORY_PRIVILEGE, WasEnabled, FALSE, &WasEnabled);
+}
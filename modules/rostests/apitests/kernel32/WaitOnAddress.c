@@ -0,0 +1,228 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for WaitOnAddress and the SRW locks built on it
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define PINGPONG_ROUNDS 20000
+#define SRW_THREADS     4
+#define SRW_ITERATIONS  100000
+
+static BOOL (WINAPI *pWaitOnAddress)(volatile VOID *, PVOID, SIZE_T, DWORD);
+static VOID (WINAPI *pWakeByAddressSingle)(PVOID);
+static VOID (WINAPI *pWakeByAddressAll)(PVOID);
+static VOID (WINAPI *pInitializeSRWLock)(PRTL_SRWLOCK);
+static VOID (WINAPI *pAcquireSRWLockExclusive)(PRTL_SRWLOCK);
+static VOID (WINAPI *pReleaseSRWLockExclusive)(PRTL_SRWLOCK);
+
+static volatile LONG PingPong;
+static volatile LONG WakeAllGate;
+static volatile LONG WakeAllCount;
+
+static RTL_SRWLOCK SrwLock;
+static volatile ULONG SrwCounter;
+static HANDLE StartEvent;
+
+static void test_basic(void)
+{
+    LONG Value = 1, Compare = 0;
+    DWORD dwStart;
+    BOOL ret;
+
+    /* The value differs, this must return right away */
+    ret = pWaitOnAddress(&Value, &Compare, sizeof(Value), INFINITE);
+    ok(ret, "WaitOnAddress failed (%lu)\n", GetLastError());
+
+    Compare = 1;
+    SetLastError(0xdeadbeef);
+    dwStart = GetTickCount();
+    ret = pWaitOnAddress(&Value, &Compare, sizeof(Value), 50);
+    ok(!ret, "WaitOnAddress succeeded\n");
+    ok(GetLastError() == ERROR_TIMEOUT, "Expected ERROR_TIMEOUT, got %lu\n", GetLastError());
+    ok(GetTickCount() - dwStart >= 40, "Waited only %lu ms\n", GetTickCount() - dwStart);
+
+    SetLastError(0xdeadbeef);
+    ret = pWaitOnAddress(&Value, &Compare, 3, 0);
+    ok(!ret, "WaitOnAddress succeeded\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "Expected ERROR_INVALID_PARAMETER, got %lu\n", GetLastError());
+
+    /* Waking without waiters is a no-op */
+    pWakeByAddressSingle(&Value);
+    pWakeByAddressAll(&Value);
+}
+
+static DWORD WINAPI PingPongThread(PVOID Param)
+{
+    LONG Expected;
+    ULONG i;
+
+    for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        /* Wait for our turn, then hand it back */
+        Expected = 0;
+        while (PingPong == Expected)
+            pWaitOnAddress(&PingPong, &Expected, sizeof(Expected), INFINITE);
+
+        InterlockedExchange(&PingPong, 0);
+        pWakeByAddressSingle((PVOID)&PingPong);
+    }
+
+    return 0;
+}
+
+static void test_pingpong(void)
+{
+    HANDLE hThread;
+    DWORD dwStart, dwElapsed;
+    LONG Expected;
+    ULONG i;
+
+    PingPong = 0;
+    hThread = CreateThread(NULL, 0, PingPongThread, NULL, 0, NULL);
+    ok(hThread != NULL, "CreateThread failed (%lu)\n", GetLastError());
+    if (!hThread)
+        return;
+
+    dwStart = GetTickCount();
+    for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        InterlockedExchange(&PingPong, 1);
+        pWakeByAddressSingle((PVOID)&PingPong);
+
+        Expected = 1;
+        while (PingPong == Expected)
+            pWaitOnAddress(&PingPong, &Expected, sizeof(Expected), INFINITE);
+    }
+    dwElapsed = GetTickCount() - dwStart;
+
+    ok(WaitForSingleObject(hThread, 10000) == WAIT_OBJECT_0, "Ping-pong thread is stuck\n");
+    CloseHandle(hThread);
+
+    trace("ping-pong: %u round trips in %lu ms (%lu us per wake)\n",
+          PINGPONG_ROUNDS, dwElapsed, dwElapsed * 1000 / (PINGPONG_ROUNDS * 2));
+}
+
+static DWORD WINAPI WakeAllThread(PVOID Param)
+{
+    LONG Closed = 0;
+
+    while (WakeAllGate == Closed)
+        pWaitOnAddress(&WakeAllGate, &Closed, sizeof(Closed), INFINITE);
+
+    InterlockedIncrement(&WakeAllCount);
+    return 0;
+}
+
+static void test_wakeall(void)
+{
+    HANDLE hThreads[SRW_THREADS];
+    ULONG i, Threads = 0;
+
+    WakeAllGate = 0;
+    WakeAllCount = 0;
+
+    for (i = 0; i < SRW_THREADS; i++)
+    {
+        hThreads[Threads] = CreateThread(NULL, 0, WakeAllThread, NULL, 0, NULL);
+        ok(hThreads[Threads] != NULL, "CreateThread failed (%lu)\n", GetLastError());
+        if (hThreads[Threads])
+            Threads++;
+    }
+
+    Sleep(100);
+    ok(WakeAllCount == 0, "%ld thread(s) passed the closed gate\n", WakeAllCount);
+
+    InterlockedExchange(&WakeAllGate, 1);
+    pWakeByAddressAll((PVOID)&WakeAllGate);
+
+    ok(WaitForMultipleObjects(Threads, hThreads, TRUE, 10000) == WAIT_OBJECT_0,
+       "Not all threads were woken\n");
+    ok(WakeAllCount == (LONG)Threads, "%ld of %lu thread(s) were woken\n", WakeAllCount, Threads);
+
+    for (i = 0; i < Threads; i++)
+        CloseHandle(hThreads[i]);
+}
+
+static DWORD WINAPI SrwThread(PVOID Param)
+{
+    ULONG i;
+
+    WaitForSingleObject(StartEvent, INFINITE);
+
+    for (i = 0; i < SRW_ITERATIONS; i++)
+    {
+        pAcquireSRWLockExclusive(&SrwLock);
+        SrwCounter++;
+        pReleaseSRWLockExclusive(&SrwLock);
+    }
+
+    return 0;
+}
+
+static void test_srw_contention(void)
+{
+    HANDLE hThreads[SRW_THREADS];
+    DWORD dwStart, dwElapsed;
+    ULONG i, Threads = 0;
+
+    pInitializeSRWLock(&SrwLock);
+    SrwCounter = 0;
+    StartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    for (i = 0; i < SRW_THREADS; i++)
+    {
+        hThreads[Threads] = CreateThread(NULL, 0, SrwThread, NULL, 0, NULL);
+        ok(hThreads[Threads] != NULL, "CreateThread failed (%lu)\n", GetLastError());
+        if (hThreads[Threads])
+            Threads++;
+    }
+
+    dwStart = GetTickCount();
+    SetEvent(StartEvent);
+    WaitForMultipleObjects(Threads, hThreads, TRUE, INFINITE);
+    dwElapsed = GetTickCount() - dwStart;
+
+    ok(SrwCounter == Threads * SRW_ITERATIONS, "Counter is %lu, expected %lu\n",
+       SrwCounter, Threads * SRW_ITERATIONS);
+    trace("SRW exclusive, %lu threads: %lu acquisitions in %lu ms\n",
+          Threads, Threads * SRW_ITERATIONS, dwElapsed);
+
+    for (i = 0; i < Threads; i++)
+        CloseHandle(hThreads[i]);
+    CloseHandle(StartEvent);
+}
+
+START_TEST(WaitOnAddress)
+{
+    HMODULE hModule;
+
+    /* Our implementation lives in kernel32_vista, Windows has it in kernel32 */
+    hModule = LoadLibraryW(L"kernel32_vista.dll");
+    if (!hModule)
+        hModule = GetModuleHandleW(L"kernel32.dll");
+
+    pWaitOnAddress = (PVOID)GetProcAddress(hModule, "WaitOnAddress");
+    pWakeByAddressSingle = (PVOID)GetProcAddress(hModule, "WakeByAddressSingle");
+    pWakeByAddressAll = (PVOID)GetProcAddress(hModule, "WakeByAddressAll");
+    pInitializeSRWLock = (PVOID)GetProcAddress(hModule, "InitializeSRWLock");
+    pAcquireSRWLockExclusive = (PVOID)GetProcAddress(hModule, "AcquireSRWLockExclusive");
+    pReleaseSRWLockExclusive = (PVOID)GetProcAddress(hModule, "ReleaseSRWLockExclusive");
+
+    if (!pWaitOnAddress || !pWakeByAddressSingle || !pWakeByAddressAll)
+    {
+        skip("WaitOnAddress is not available\n");
+        return;
+    }
+
+    test_basic();
+    test_pingpong();
+    test_wakeall();
+
+    if (pInitializeSRWLock && pAcquireSRWLockExclusive && pReleaseSRWLockExclusive)
+        test_srw_contention();
+    else
+        skip("SRW locks are not available\n");
+}
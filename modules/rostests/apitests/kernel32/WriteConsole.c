@@ -0,0 +1,138 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests for WriteConsole ordering and throughput
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define BIGFILE_LINES   20000
+
+static void test_ordering(HANDLE hConOut)
+{
+    static const char Text[] = "Ring";
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    COORD c = {0, 0};
+    CHAR Buffer[16];
+    DWORD dwWritten, dwRead;
+    BOOL ret;
+
+    ret = SetConsoleCursorPosition(hConOut, c);
+    ok(ret, "SetConsoleCursorPosition failed (%lu)\n", GetLastError());
+
+    /* The first write maps the shared output ring, the next ones go through it */
+    ret = WriteConsoleA(hConOut, "x", 1, &dwWritten, NULL);
+    ok(ret && dwWritten == 1, "WriteConsoleA failed (%lu)\n", GetLastError());
+    ret = WriteConsoleA(hConOut, "\r", 1, &dwWritten, NULL);
+    ok(ret && dwWritten == 1, "WriteConsoleA failed (%lu)\n", GetLastError());
+    ret = WriteConsoleA(hConOut, Text, sizeof(Text) - 1, &dwWritten, NULL);
+    ok(ret && dwWritten == sizeof(Text) - 1, "WriteConsoleA failed (%lu)\n", GetLastError());
+
+    /* Any console call must see the previous writes */
+    ret = GetConsoleScreenBufferInfo(hConOut, &csbi);
+    ok(ret, "GetConsoleScreenBufferInfo failed (%lu)\n", GetLastError());
+    ok(csbi.dwCursorPosition.X == sizeof(Text) - 1 && csbi.dwCursorPosition.Y == 0,
+       "Expected cursor at (%u,0), got (%d,%d)\n", (UINT)(sizeof(Text) - 1),
+       csbi.dwCursorPosition.X, csbi.dwCursorPosition.Y);
+
+    ret = ReadConsoleOutputCharacterA(hConOut, Buffer, sizeof(Text) - 1, c, &dwRead);
+    ok(ret && dwRead == sizeof(Text) - 1, "ReadConsoleOutputCharacterA failed (%lu)\n", GetLastError());
+    ok(memcmp(Buffer, Text, sizeof(Text) - 1) == 0, "Got '%.*s'\n", (int)dwRead, Buffer);
+
+    /* A write issued after a synchronous call lands at the new position */
+    c.Y = 1;
+    ret = SetConsoleCursorPosition(hConOut, c);
+    ok(ret, "SetConsoleCursorPosition failed (%lu)\n", GetLastError());
+    ret = WriteConsoleW(hConOut, L"W", 1, &dwWritten, NULL);
+    ok(ret && dwWritten == 1, "WriteConsoleW failed (%lu)\n", GetLastError());
+    ret = ReadConsoleOutputCharacterA(hConOut, Buffer, 1, c, &dwRead);
+    ok(ret && dwRead == 1 && Buffer[0] == 'W', "Got '%c'\n", Buffer[0]);
+}
+
+/* Same pattern as "type bigfile.txt": read a file, write it line by line */
+static void test_type_bigfile(HANDLE hConOut)
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    CHAR szPath[MAX_PATH], szFile[MAX_PATH], szLine[128];
+    HANDLE hFile;
+    DWORD dwWritten, dwRead, dwStart, dwElapsed;
+    PCHAR FileData, Line, End;
+    ULONG i, Lines = 0;
+    BOOL ret;
+
+    GetTempPathA(_countof(szPath), szPath);
+    GetTempFileNameA(szPath, "con", 0, szFile);
+
+    hFile = CreateFileA(szFile, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+    ok(hFile != INVALID_HANDLE_VALUE, "CreateFileA failed (%lu)\n", GetLastError());
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+
+    for (i = 0; i < BIGFILE_LINES; i++)
+    {
+        StringCbPrintfA(szLine, sizeof(szLine),
+                        "%06lu: gcc -c -O2 -Wall -I../include source/module_%lu.c -o obj/module_%lu.o\r\n",
+                        i, i, i);
+        WriteFile(hFile, szLine, lstrlenA(szLine), &dwWritten, NULL);
+    }
+
+    FileData = HeapAlloc(GetProcessHeap(), 0, GetFileSize(hFile, NULL));
+    ok(FileData != NULL, "HeapAlloc failed\n");
+    if (!FileData)
+        goto Quit;
+
+    SetFilePointer(hFile, 0, NULL, FILE_BEGIN);
+    ret = ReadFile(hFile, FileData, GetFileSize(hFile, NULL), &dwRead, NULL);
+    ok(ret, "ReadFile failed (%lu)\n", GetLastError());
+
+    dwStart = GetTickCount();
+    for (Line = FileData, End = FileData + dwRead; Line < End; Lines++)
+    {
+        PCHAR Next = memchr(Line, '\n', End - Line);
+        Next = (Next ? Next + 1 : End);
+
+        ret = WriteConsoleA(hConOut, Line, (DWORD)(Next - Line), &dwWritten, NULL);
+        if (!ret || dwWritten != (DWORD)(Next - Line))
+        {
+            ok(FALSE, "WriteConsoleA failed at line %lu (%lu)\n", Lines, GetLastError());
+            break;
+        }
+        Line = Next;
+    }
+
+    /* Make sure everything has reached the screen buffer */
+    GetConsoleScreenBufferInfo(hConOut, &csbi);
+    dwElapsed = GetTickCount() - dwStart;
+
+    ok(Lines == BIGFILE_LINES, "Wrote %lu lines, expected %u\n", Lines, BIGFILE_LINES);
+    trace("type bigfile.txt: %lu lines in %lu ms (%lu lines/s)\n",
+          Lines, dwElapsed, dwElapsed ? (Lines * 1000 / dwElapsed) : 0);
+
+    HeapFree(GetProcessHeap(), 0, FileData);
+
+Quit:
+    CloseHandle(hFile);
+    DeleteFileA(szFile);
+}
+
+START_TEST(WriteConsole)
+{
+    HANDLE hConOut;
+
+    hConOut = CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                        NULL, CONSOLE_TEXTMODE_BUFFER, NULL);
+    ok(hConOut != INVALID_HANDLE_VALUE, "CreateConsoleScreenBuffer failed (%lu)\n", GetLastError());
+    if (hConOut == INVALID_HANDLE_VALUE)
+    {
+        skip("No console screen buffer\n");
+        return;
+    }
+
+    test_ordering(hConOut);
+    test_type_bigfile(hConOut);
+
+    CloseHandle(hConOut);
+}
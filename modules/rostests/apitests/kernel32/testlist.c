@@ -20,6 +20,7 @@ extern void func_GetVolumeInformation(void);
 extern void func_interlck(void);
 extern void func_IsDBCSLeadByteEx(void);
 extern void func_JapaneseCalendar(void);
+extern void func_LargePages(void);
 extern void func_LoadLibraryExW(void);
 extern void func_lstrcpynW(void);
 extern void func_lstrlen(void);
@@ -34,7 +35,9 @@ extern void func_SetUnhandledExceptionFilter(void);
 extern void func_SystemFirmware(void);
 extern void func_TerminateProcess(void);
 extern void func_TunnelCache(void);
+extern void func_WaitOnAddress(void);
 extern void func_WideCharToMultiByte(void);
+extern void func_WriteConsole(void);
 
 const struct test winetest_testlist[] =
 {
@@ -55,6 +58,7 @@ const struct test winetest_testlist[] =
     { "interlck",                    func_interlck },
     { "IsDBCSLeadByteEx",            func_IsDBCSLeadByteEx },
     { "JapaneseCalendar",            func_JapaneseCalendar },
+    { "LargePages",                  func_LargePages },
     { "LoadLibraryExW",              func_LoadLibraryExW },
     { "lstrcpynW",                   func_lstrcpynW },
     { "lstrlen",                     func_lstrlen },
@@ -69,6 +73,8 @@ const struct test winetest_testlist[] =
     { "SystemFirmware",              func_SystemFirmware },
     { "TerminateProcess",            func_TerminateProcess },
     { "TunnelCache",                 func_TunnelCache },
+    { "WaitOnAddress",               func_WaitOnAddress },
     { "WideCharToMultiByte",         func_WideCharToMultiByte },
+    { "WriteConsole",                func_WriteConsole },
     { 0, 0 }
 };
@@ -0,0 +1,338 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for LPC round trips, port views and NtReplyWaitReplyPort
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#include <process.h>
+
+#define ECHO_ROUNDS     20000
+#define VIEW_ROUNDS     2000
+#define VIEW_SIZE       (64 * 1024)
+#define VIEW_CHUNK      (32 * 1024)
+
+#define TEST_COMMAND_ECHO   1
+#define TEST_COMMAND_VIEW   2
+#define TEST_COMMAND_BOUNCE 3
+#define TEST_COMMAND_QUIT   4
+
+typedef struct _TEST_MESSAGE
+{
+    PORT_MESSAGE Header;
+    ULONG Command;
+    ULONG Value;
+} TEST_MESSAGE, *PTEST_MESSAGE;
+
+static UNICODE_STRING PortName = RTL_CONSTANT_STRING(L"\\NtdllApitestNtRequestWaitReplyPortTestPort");
+static UINT ServerThreadId;
+static PUCHAR ServerViewBase;
+static PUCHAR ClientViewOfServer;
+
+static
+ULONG
+SumView(
+    _In_ PUCHAR View,
+    _In_ ULONG Length)
+{
+    ULONG i, Sum = 0;
+
+    for (i = 0; i < Length; i++)
+        Sum += View[i];
+
+    return Sum;
+}
+
+static
+VOID
+InitMessage(
+    _Out_ PTEST_MESSAGE Message,
+    _In_ ULONG Command,
+    _In_ ULONG Value)
+{
+    RtlZeroMemory(Message, sizeof(*Message));
+    Message->Header.u1.s1.TotalLength = sizeof(*Message);
+    Message->Header.u1.s1.DataLength = sizeof(*Message) - sizeof(PORT_MESSAGE);
+    Message->Command = Command;
+    Message->Value = Value;
+}
+
+UINT
+CALLBACK
+ServerThread(
+    _Inout_ PVOID Parameter)
+{
+    NTSTATUS Status;
+    TEST_MESSAGE Message;
+    PPORT_MESSAGE Reply = NULL;
+    HANDLE PortHandle, SectionHandle = NULL;
+    HANDLE ServerPortHandle = Parameter;
+    LARGE_INTEGER SectionSize;
+    PORT_VIEW ServerView;
+    REMOTE_PORT_VIEW ClientView;
+
+    RtlZeroMemory(&Message, sizeof(Message));
+    Status = NtListenPort(ServerPortHandle, &Message.Header);
+    ok_hex(Status, STATUS_SUCCESS);
+
+    /* Share a section with the client, for the bulk data */
+    SectionSize.QuadPart = VIEW_SIZE;
+    Status = NtCreateSection(&SectionHandle,
+                             SECTION_ALL_ACCESS,
+                             NULL,
+                             &SectionSize,
+                             PAGE_READWRITE,
+                             SEC_COMMIT,
+                             NULL);
+    ok_hex(Status, STATUS_SUCCESS);
+
+    RtlZeroMemory(&ServerView, sizeof(ServerView));
+    ServerView.Length = sizeof(ServerView);
+    ServerView.SectionHandle = SectionHandle;
+    ServerView.ViewSize = VIEW_SIZE;
+    RtlZeroMemory(&ClientView, sizeof(ClientView));
+    ClientView.Length = sizeof(ClientView);
+
+    Status = NtAcceptConnectPort(&PortHandle,
+                                 NULL,
+                                 &Message.Header,
+                                 TRUE,
+                                 NT_SUCCESS(Status) ? &ServerView : NULL,
+                                 &ClientView);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (SectionHandle) NtClose(SectionHandle);
+    if (!NT_SUCCESS(Status))
+        return 0;
+
+    ok(ServerView.ViewBase != NULL, "ViewBase is NULL\n");
+    ok(ServerView.ViewRemoteBase != NULL, "ViewRemoteBase is NULL\n");
+    ok(ServerView.ViewSize >= VIEW_SIZE, "ViewSize is %Iu\n", ServerView.ViewSize);
+    ServerViewBase = ServerView.ViewBase;
+
+    Status = NtCompleteConnectPort(PortHandle);
+    ok_hex(Status, STATUS_SUCCESS);
+
+    for (;;)
+    {
+        RtlZeroMemory(&Message, sizeof(Message));
+        Status = NtReplyWaitReceivePort(PortHandle, NULL, Reply, &Message.Header);
+        Reply = NULL;
+        if (!NT_SUCCESS(Status))
+        {
+            ok_hex(Status, STATUS_SUCCESS);
+            break;
+        }
+
+        if (Message.Header.u2.s2.Type == LPC_PORT_CLOSED ||
+            Message.Header.u2.s2.Type == LPC_CLIENT_DIED)
+        {
+            break;
+        }
+
+        if (Message.Header.u2.s2.Type != LPC_REQUEST)
+            continue;
+
+        switch (Message.Command)
+        {
+            case TEST_COMMAND_ECHO:
+                Message.Value++;
+                Reply = &Message.Header;
+                break;
+
+            case TEST_COMMAND_VIEW:
+                /* The client wrote into the shared view, nothing was copied */
+                Message.Value = SumView(ServerViewBase, min(Message.Value, VIEW_SIZE));
+                Reply = &Message.Header;
+                break;
+
+            case TEST_COMMAND_BOUNCE:
+                /* Answer, then wait for the client to answer the answer */
+                Message.Value++;
+                Status = NtReplyWaitReplyPort(PortHandle, &Message.Header);
+                ok_hex(Status, STATUS_SUCCESS);
+                ok(Message.Header.u2.s2.Type == LPC_REPLY, "Type = %x\n", Message.Header.u2.s2.Type);
+                ok(Message.Value == 3, "Value = %lu\n", Message.Value);
+                break;
+
+            case TEST_COMMAND_QUIT:
+                Reply = &Message.Header;
+                Status = NtReplyPort(PortHandle, Reply);
+                ok_hex(Status, STATUS_SUCCESS);
+                NtClose(PortHandle);
+                return 0;
+        }
+    }
+
+    NtClose(PortHandle);
+    return 0;
+}
+
+static
+VOID
+TestEcho(
+    _In_ HANDLE PortHandle)
+{
+    NTSTATUS Status;
+    TEST_MESSAGE Message;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG i;
+
+    NtQueryPerformanceCounter(&Start, &Frequency);
+    for (i = 0; i < ECHO_ROUNDS; i++)
+    {
+        InitMessage(&Message, TEST_COMMAND_ECHO, i);
+        Status = NtRequestWaitReplyPort(PortHandle, &Message.Header, &Message.Header);
+        if (!NT_SUCCESS(Status) || Message.Value != i + 1)
+        {
+            ok(FALSE, "Round %lu: Status 0x%lx, Value %lu\n", i, Status, Message.Value);
+            return;
+        }
+    }
+    NtQueryPerformanceCounter(&End, NULL);
+
+    trace("LPC echo: %u round trips, %I64u us each\n",
+          ECHO_ROUNDS,
+          (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart / ECHO_ROUNDS);
+}
+
+static
+VOID
+TestView(
+    _In_ HANDLE PortHandle)
+{
+    NTSTATUS Status;
+    TEST_MESSAGE Message;
+    LARGE_INTEGER Start, End, Frequency;
+    ULONG i, Expected;
+    ULONGLONG Elapsed;
+
+    /* Data written by the client must be visible at the server's base */
+    for (i = 0; i < VIEW_CHUNK; i++)
+        ClientViewOfServer[i] = (UCHAR)(i * 7);
+    Expected = SumView(ClientViewOfServer, VIEW_CHUNK);
+
+    InitMessage(&Message, TEST_COMMAND_VIEW, VIEW_CHUNK);
+    Status = NtRequestWaitReplyPort(PortHandle, &Message.Header, &Message.Header);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok(Message.Value == Expected, "Value = %lu, expected %lu\n", Message.Value, Expected);
+
+    NtQueryPerformanceCounter(&Start, &Frequency);
+    for (i = 0; i < VIEW_ROUNDS; i++)
+    {
+        ClientViewOfServer[0] = (UCHAR)i;
+        InitMessage(&Message, TEST_COMMAND_VIEW, VIEW_CHUNK);
+        Status = NtRequestWaitReplyPort(PortHandle, &Message.Header, &Message.Header);
+        if (!NT_SUCCESS(Status))
+        {
+            ok_hex(Status, STATUS_SUCCESS);
+            return;
+        }
+    }
+    NtQueryPerformanceCounter(&End, NULL);
+
+    Elapsed = (End.QuadPart - Start.QuadPart) * 1000000 / Frequency.QuadPart;
+    trace("LPC view: %u x %u bytes in %I64u us (%I64u MB/s)\n",
+          VIEW_ROUNDS, VIEW_CHUNK, Elapsed,
+          Elapsed ? (ULONGLONG)VIEW_ROUNDS * VIEW_CHUNK / Elapsed : 0);
+}
+
+static
+VOID
+TestReplyWaitReply(
+    _In_ HANDLE PortHandle)
+{
+    NTSTATUS Status;
+    TEST_MESSAGE Message;
+
+    InitMessage(&Message, TEST_COMMAND_BOUNCE, 1);
+    Status = NtRequestWaitReplyPort(PortHandle, &Message.Header, &Message.Header);
+    ok_hex(Status, STATUS_SUCCESS);
+    ok(Message.Value == 2, "Value = %lu\n", Message.Value);
+
+    /* The server is now waiting for our answer to its reply */
+    Message.Value++;
+    Message.Header.ClientId.UniqueThread = UlongToHandle(ServerThreadId);
+    Status = NtReplyPort(PortHandle, &Message.Header);
+    ok_hex(Status, STATUS_SUCCESS);
+}
+
+START_TEST(NtRequestWaitReplyPort)
+{
+    NTSTATUS Status;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    SECURITY_QUALITY_OF_SERVICE SecurityQos;
+    REMOTE_PORT_VIEW ServerView;
+    TEST_MESSAGE Message;
+    HANDLE ServerPortHandle, PortHandle, ThreadHandle;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &PortName,
+                               OBJ_CASE_INSENSITIVE,
+                               NULL,
+                               NULL);
+    Status = NtCreatePort(&ServerPortHandle,
+                          &ObjectAttributes,
+                          0,
+                          sizeof(TEST_MESSAGE),
+                          2 * sizeof(TEST_MESSAGE));
+    ok_hex(Status, STATUS_SUCCESS);
+    if (!NT_SUCCESS(Status))
+    {
+        skip("Failed to create port\n");
+        return;
+    }
+
+    ThreadHandle = (HANDLE)_beginthreadex(NULL,
+                                          0,
+                                          ServerThread,
+                                          ServerPortHandle,
+                                          0,
+                                          &ServerThreadId);
+    ok(ThreadHandle != NULL, "_beginthreadex failed\n");
+
+    SecurityQos.Length = sizeof(SecurityQos);
+    SecurityQos.ImpersonationLevel = SecurityIdentification;
+    SecurityQos.EffectiveOnly = TRUE;
+    SecurityQos.ContextTrackingMode = SECURITY_STATIC_TRACKING;
+
+    RtlZeroMemory(&ServerView, sizeof(ServerView));
+    ServerView.Length = sizeof(ServerView);
+    Status = NtConnectPort(&PortHandle,
+                           &PortName,
+                           &SecurityQos,
+                           NULL,
+                           &ServerView,
+                           NULL,
+                           NULL,
+                           NULL);
+    ok_hex(Status, STATUS_SUCCESS);
+    if (NT_SUCCESS(Status))
+    {
+        ok(ServerView.ViewBase != NULL, "ViewBase is NULL\n");
+        ok(ServerView.ViewSize >= VIEW_SIZE, "ViewSize is %Iu\n", ServerView.ViewSize);
+        ClientViewOfServer = ServerView.ViewBase;
+
+        TestEcho(PortHandle);
+        if (ClientViewOfServer)
+            TestView(PortHandle);
+        else
+            skip("No server view\n");
+        TestReplyWaitReply(PortHandle);
+
+        InitMessage(&Message, TEST_COMMAND_QUIT, 0);
+        Status = NtRequestWaitReplyPort(PortHandle, &Message.Header, &Message.Header);
+        ok_hex(Status, STATUS_SUCCESS);
+
+        NtClose(PortHandle);
+    }
+    else
+    {
+        skip("Failed to connect\n");
+    }
+
+    WaitForSingleObject(ThreadHandle, 10000);
+    CloseHandle(ThreadHandle);
+    NtClose(ServerPortHandle);
+}
@@ -0,0 +1,140 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for contended Rtl critical sections
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "precomp.h"
+
+#define MAX_THREADS     8
+#define ITERATIONS      200000
+
+typedef struct _LOCK_TEST
+{
+    RTL_CRITICAL_SECTION CriticalSection;
+    HANDLE StartEvent;
+    ULONG HoldSpins;
+    ULONG Iterations;
+    volatile ULONG Counter;
+} LOCK_TEST, *PLOCK_TEST;
+
+static DWORD WINAPI LockThread(PVOID Param)
+{
+    PLOCK_TEST Test = Param;
+    ULONG i, j;
+
+    WaitForSingleObject(Test->StartEvent, INFINITE);
+
+    for (i = 0; i < Test->Iterations; i++)
+    {
+        RtlEnterCriticalSection(&Test->CriticalSection);
+
+        /* Recursive acquisition must not touch the contention path */
+        RtlEnterCriticalSection(&Test->CriticalSection);
+        Test->Counter++;
+        RtlLeaveCriticalSection(&Test->CriticalSection);
+
+        for (j = 0; j < Test->HoldSpins; j++)
+            YieldProcessor();
+
+        RtlLeaveCriticalSection(&Test->CriticalSection);
+    }
+
+    return 0;
+}
+
+static void RunLockTest(ULONG Threads, ULONG HoldSpins)
+{
+    LOCK_TEST Test;
+    HANDLE hThreads[MAX_THREADS];
+    DWORD dwStart, dwElapsed;
+    ULONG i, Total;
+    NTSTATUS Status;
+
+    Status = RtlInitializeCriticalSection(&Test.CriticalSection);
+    ok(NT_SUCCESS(Status), "RtlInitializeCriticalSection failed: 0x%lx\n", Status);
+    if (!NT_SUCCESS(Status))
+        return;
+
+    Test.StartEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    Test.HoldSpins = HoldSpins;
+    Test.Iterations = ITERATIONS / Threads;
+    Test.Counter = 0;
+    Total = Test.Iterations * Threads;
+
+    for (i = 0; i < Threads; i++)
+    {
+        hThreads[i] = CreateThread(NULL, 0, LockThread, &Test, 0, NULL);
+        ok(hThreads[i] != NULL, "CreateThread failed (%lu)\n", GetLastError());
+        if (!hThreads[i])
+        {
+            Threads = i;
+            break;
+        }
+    }
+
+    dwStart = GetTickCount();
+    SetEvent(Test.StartEvent);
+    WaitForMultipleObjects(Threads, hThreads, TRUE, INFINITE);
+    dwElapsed = GetTickCount() - dwStart;
+
+    ok(Test.Counter == Test.Iterations * Threads, "Counter is %lu, expected %lu\n",
+       Test.Counter, Test.Iterations * Threads);
+    ok(Test.CriticalSection.LockCount == -1, "LockCount is %ld\n", Test.CriticalSection.LockCount);
+    ok(Test.CriticalSection.RecursionCount == 0, "RecursionCount is %ld\n", Test.CriticalSection.RecursionCount);
+
+    /* Contention goes through the keyed event, without a per-lock handle */
+    ok(Test.CriticalSection.LockSemaphore == NULL, "LockSemaphore is %p\n",
+       Test.CriticalSection.LockSemaphore);
+
+    if (Test.CriticalSection.DebugInfo)
+    {
+        /* ReactOS keeps its spin statistics in the spare debug fields */
+        trace("%lu thread(s), hold %3lu: %lu acquisitions in %lu ms (%lu/ms), "
+              "%lu waits, %u spin acquisitions, spin history %u\n",
+              Threads, HoldSpins, Total, dwElapsed, dwElapsed ? Total / dwElapsed : 0,
+              Test.CriticalSection.DebugInfo->EntryCount,
+              Test.CriticalSection.DebugInfo->CreatorBackTraceIndexHigh,
+              Test.CriticalSection.DebugInfo->SpareWORD);
+    }
+
+    for (i = 0; i < Threads; i++)
+        CloseHandle(hThreads[i]);
+    CloseHandle(Test.StartEvent);
+    RtlDeleteCriticalSection(&Test.CriticalSection);
+}
+
+static void test_TryEnter(void)
+{
+    RTL_CRITICAL_SECTION CriticalSection;
+
+    RtlInitializeCriticalSectionAndSpinCount(&CriticalSection, 4000);
+
+    ok(RtlTryEnterCriticalSection(&CriticalSection), "RtlTryEnterCriticalSection failed\n");
+    ok(RtlTryEnterCriticalSection(&CriticalSection), "Recursive RtlTryEnterCriticalSection failed\n");
+    ok(CriticalSection.RecursionCount == 2, "RecursionCount is %ld\n", CriticalSection.RecursionCount);
+
+    RtlLeaveCriticalSection(&CriticalSection);
+    RtlLeaveCriticalSection(&CriticalSection);
+    ok(CriticalSection.LockCount == -1, "LockCount is %ld\n", CriticalSection.LockCount);
+
+    RtlDeleteCriticalSection(&CriticalSection);
+}
+
+START_TEST(RtlCriticalSection)
+{
+    SYSTEM_INFO SystemInfo;
+    ULONG Threads;
+
+    GetSystemInfo(&SystemInfo);
+    trace("%lu processor(s)\n", SystemInfo.dwNumberOfProcessors);
+
+    test_TryEnter();
+
+    for (Threads = 1; Threads <= MAX_THREADS; Threads *= 2)
+    {
+        RunLockTest(Threads, 0);
+        RunLockTest(Threads, 100);
+    }
+}
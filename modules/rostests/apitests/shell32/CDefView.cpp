@@ -0,0 +1,295 @@
+/*
+ * PROJECT:     ReactOS api tests
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Tests and benchmark for filling CDefView in the background
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include "shelltest.h"
+#include <stdio.h>
+#include <commctrl.h>
+#include <shellutils.h>
+
+#define BENCH_FILES     50000
+#define FILL_TIMEOUT    120000
+
+class CTestShellBrowser : public IShellBrowser
+{
+public:
+    HWND m_hwnd;
+
+    CTestShellBrowser()
+    {
+        WNDCLASSW wc = {};
+        wc.lpfnWndProc = DefWindowProcW;
+        wc.hInstance = GetModuleHandleW(NULL);
+        wc.lpszClassName = L"CDefViewTestHost";
+        RegisterClassW(&wc);
+        m_hwnd = CreateWindowExW(0, wc.lpszClassName, L"CDefView", WS_OVERLAPPEDWINDOW,
+                                 0, 0, 640, 480, NULL, NULL, NULL, NULL);
+        ShowWindow(m_hwnd, SW_SHOW);
+    }
+
+    ~CTestShellBrowser()
+    {
+        DestroyWindow(m_hwnd);
+    }
+
+    // *** IUnknown methods ***
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppvObject)
+    {
+        if (riid == IID_IShellBrowser || riid == IID_IOleWindow || riid == IID_IUnknown)
+        {
+            *ppvObject = this;
+            return S_OK;
+        }
+        *ppvObject = NULL;
+        return E_NOINTERFACE;
+    }
+    virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 2; }
+    virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+    // *** IOleWindow methods ***
+    virtual HRESULT STDMETHODCALLTYPE GetWindow(HWND *phwnd) { *phwnd = m_hwnd; return S_OK; }
+    virtual HRESULT STDMETHODCALLTYPE ContextSensitiveHelp(BOOL fEnterMode) { return E_NOTIMPL; }
+
+    // *** IShellBrowser methods ***
+    virtual HRESULT STDMETHODCALLTYPE InsertMenusSB(HMENU hmenuShared, LPOLEMENUGROUPWIDTHS lpMenuWidths) { return S_OK; }
+    virtual HRESULT STDMETHODCALLTYPE SetMenuSB(HMENU hmenuShared, HOLEMENU holemenuRes, HWND hwndActiveObject) { return S_OK; }
+    virtual HRESULT STDMETHODCALLTYPE RemoveMenusSB(HMENU hmenuShared) { return S_OK; }
+    virtual HRESULT STDMETHODCALLTYPE SetStatusTextSB(LPCWSTR pszStatusText) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE EnableModelessSB(BOOL fEnable) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE TranslateAcceleratorSB(MSG *pmsg, WORD wID) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE BrowseObject(PCUIDLIST_RELATIVE pidl, UINT wFlags) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE GetViewStateStream(DWORD grfMode, IStream **ppStrm) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE GetControlWindow(UINT id, HWND *phwnd) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE SendControlMsg(UINT id, UINT uMsg, WPARAM wParam, LPARAM lParam, LRESULT *pret) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE QueryActiveShellView(IShellView **ppshv) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE OnViewWindowActive(IShellView *pshv) { return E_NOTIMPL; }
+    virtual HRESULT STDMETHODCALLTYPE SetToolbarItems(LPTBBUTTONSB lpButtons, UINT nButtons, UINT uFlags) { return E_NOTIMPL; }
+};
+
+static
+ULONGLONG
+ElapsedMs(const LARGE_INTEGER *pStart)
+{
+    LARGE_INTEGER Now, Frequency;
+
+    QueryPerformanceFrequency(&Frequency);
+    QueryPerformanceCounter(&Now);
+    return (Now.QuadPart - pStart->QuadPart) * 1000 / Frequency.QuadPart;
+}
+
+/* Pumps messages until the list has cItems items, returns FALSE on timeout */
+static
+BOOL
+WaitForItems(HWND hwndList, INT cItems, const LARGE_INTEGER *pStart, ULONGLONG *pFirst)
+{
+    DWORD dwStart = GetTickCount();
+    MSG msg;
+
+    while (GetTickCount() - dwStart < FILL_TIMEOUT)
+    {
+        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+
+        if (pFirst && !*pFirst && ListView_GetItemCount(hwndList) > 0)
+        {
+            UpdateWindow(hwndList);
+            *pFirst = ElapsedMs(pStart);
+        }
+
+        if (ListView_GetItemCount(hwndList) >= cItems)
+            return TRUE;
+
+        MsgWaitForMultipleObjects(0, NULL, FALSE, 10, QS_ALLINPUT);
+    }
+
+    return FALSE;
+}
+
+/* Pumps messages until pszFirst is the first item, returns FALSE on timeout */
+static
+BOOL
+WaitForFirstItem(HWND hwndList, LPCWSTR pszFirst)
+{
+    WCHAR szText[MAX_PATH];
+    DWORD dwStart = GetTickCount();
+    MSG msg;
+
+    while (GetTickCount() - dwStart < FILL_TIMEOUT)
+    {
+        while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+
+        ListView_GetItemText(hwndList, 0, 0, szText, _countof(szText));
+        if (!wcsncmp(szText, pszFirst, wcslen(pszFirst)))
+            return TRUE;
+
+        MsgWaitForMultipleObjects(0, NULL, FALSE, 10, QS_ALLINPUT);
+    }
+
+    return FALSE;
+}
+
+static
+BOOL
+CreateTestFiles(LPCWSTR pszDir, UINT cFiles)
+{
+    WCHAR szPath[MAX_PATH];
+    HANDLE hFile;
+    UINT i;
+
+    for (i = 0; i < cFiles; i++)
+    {
+        /* Created in reverse, so the enumeration order isn't the sort order */
+        swprintf(szPath, L"%s\\file%05u.txt", pszDir, cFiles - 1 - i);
+        hFile = CreateFileW(szPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return FALSE;
+        CloseHandle(hFile);
+    }
+
+    return TRUE;
+}
+
+static
+void
+DeleteTestFiles(LPCWSTR pszDir)
+{
+    WCHAR szPath[MAX_PATH];
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind;
+
+    swprintf(szPath, L"%s\\*", pszDir);
+    hFind = FindFirstFileW(szPath, &fd);
+    if (hFind != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            swprintf(szPath, L"%s\\%s", pszDir, fd.cFileName);
+            DeleteFileW(szPath);
+        } while (FindNextFileW(hFind, &fd));
+        FindClose(hFind);
+    }
+
+    RemoveDirectoryW(pszDir);
+}
+
+static
+void
+Test_LargeFolder(LPCWSTR pszDir)
+{
+    CComPtr<IShellFolder> psfDesktop, psf;
+    CComPtr<IShellView> psv;
+    CComHeapPtr<ITEMIDLIST> pidl;
+    CTestShellBrowser Browser;
+    FOLDERSETTINGS fs = { FVM_DETAILS, 0 };
+    RECT rc = { 0, 0, 640, 480 };
+    LARGE_INTEGER Start;
+    ULONGLONG Created, First = 0, Total, Sorted;
+    WCHAR szPath[MAX_PATH], szText[MAX_PATH];
+    HWND hwndView = NULL, hwndList;
+    HANDLE hFile;
+    HRESULT hr;
+    BOOL bFilled;
+
+    hr = SHGetDesktopFolder(&psfDesktop);
+    ok_hex(hr, S_OK);
+    if (FAILED(hr))
+        return;
+
+    hr = psfDesktop->ParseDisplayName(NULL, NULL, const_cast<LPWSTR>(pszDir), NULL, &pidl, NULL);
+    ok_hex(hr, S_OK);
+    if (FAILED(hr))
+        return;
+
+    hr = psfDesktop->BindToObject(pidl, NULL, IID_PPV_ARG(IShellFolder, &psf));
+    ok_hex(hr, S_OK);
+    if (FAILED(hr))
+        return;
+
+    SFV_CREATE sfvc = { sizeof(sfvc), psf };
+    hr = SHCreateShellFolderView(&sfvc, &psv);
+    ok_hex(hr, S_OK);
+    if (FAILED(hr))
+        return;
+
+    QueryPerformanceCounter(&Start);
+    hr = psv->CreateViewWindow(NULL, &fs, &Browser, &rc, &hwndView);
+    Created = ElapsedMs(&Start);
+    ok_hex(hr, S_OK);
+    if (FAILED(hr))
+        return;
+
+    hwndList = FindWindowExW(hwndView, NULL, WC_LISTVIEWW, NULL);
+    ok(hwndList != NULL, "No list view\n");
+    if (!hwndList)
+    {
+        psv->DestroyViewWindow();
+        return;
+    }
+
+    bFilled = WaitForItems(hwndList, BENCH_FILES, &Start, &First);
+    Total = ElapsedMs(&Start);
+    ok(bFilled, "Only %d of %u items after %u ms\n", ListView_GetItemCount(hwndList), BENCH_FILES, FILL_TIMEOUT);
+
+    /* The list is sorted by name once it is complete */
+    ok(WaitForFirstItem(hwndList, L"file00000"), "The items were not sorted\n");
+    Sorted = ElapsedMs(&Start);
+
+    trace("%u files: window after %I64u ms, first items after %I64u ms, all items after %I64u ms, sorted after %I64u ms\n",
+          BENCH_FILES, Created, First, Total, Sorted);
+
+    ListView_GetItemText(hwndList, BENCH_FILES - 1, 0, szText, _countof(szText));
+    ok(!wcsncmp(szText, L"file49999", 9), "Last item is %S\n", szText);
+
+    /* A new file goes straight to its place */
+    swprintf(szPath, L"%s\\file00000a.txt", pszDir);
+    hFile = CreateFileW(szPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    ok(hFile != INVALID_HANDLE_VALUE, "CreateFileW failed (%lu)\n", GetLastError());
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(hFile);
+        SHChangeNotify(SHCNE_CREATE, SHCNF_PATHW | SHCNF_FLUSH, szPath, NULL);
+
+        ok(WaitForItems(hwndList, BENCH_FILES + 1, &Start, NULL), "The new file did not show up\n");
+        ListView_GetItemText(hwndList, 1, 0, szText, _countof(szText));
+        ok(!wcsncmp(szText, L"file00000a", 10), "Second item is %S\n", szText);
+    }
+
+    psv->DestroyViewWindow();
+}
+
+START_TEST(CDefView)
+{
+    WCHAR szDir[MAX_PATH];
+
+    CoInitialize(NULL);
+
+    GetTempPathW(_countof(szDir), szDir);
+    wcscat(szDir, L"CDefViewTest");
+    DeleteTestFiles(szDir);
+    if (!CreateDirectoryW(szDir, NULL))
+    {
+        skip("Cannot create %S (%lu)\n", szDir, GetLastError());
+        CoUninitialize();
+        return;
+    }
+
+    if (CreateTestFiles(szDir, BENCH_FILES))
+        Test_LargeFolder(szDir);
+    else
+        skip("Cannot create the test files (%lu)\n", GetLastError());
+
+    DeleteTestFiles(szDir);
+    CoUninitialize();
+}
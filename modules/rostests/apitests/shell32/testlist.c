@@ -5,6 +5,7 @@
 
 extern void func_AddCommas(void);
 extern void func_Control_RunDLLW(void);
+extern void func_CDefView(void);
 extern void func_CFSFolder(void);
 extern void func_CheckEscapes(void);
 extern void func_CIDLData(void);
@@ -33,6 +34,7 @@ const struct test winetest_testlist[] =
 {
     { "AddCommas", func_AddCommas },
     { "Control_RunDLLW", func_Control_RunDLLW },
+    { "CDefView", func_CDefView },
     { "CFSFolder", func_CFSFolder },
     { "CheckEscapes", func_CheckEscapes },
     { "CIDLData", func_CIDLData },
@@ -5,6 +5,8 @@
  * PROJECT:         ReactOS diskspeed.exe
  * FILE:            apps/tests/diskspeed/diskspeed.c
  * PURPOSE:         Determines disk transfer rates
+ *                  diskspeed [drive] measures a single drive, e.g. a USB disk
+ *                  The last column is random 4 kB reads at queue depth 32
  * PROGRAMMER:
  */
 
@@ -19,6 +21,10 @@
 #include <ntddscsi.h>
 #include <scsi.h>
 
+#define MAX_TRANSFER_SIZE   (1024 * 1024)
+#define RANDOM_READ_SIZE    4096
+#define RANDOM_QUEUE_DEPTH  32
+
 BOOL GetInquiryData(HANDLE hDevice, PINQUIRYDATA InquiryData)
 {
   BOOL Result;
@@ -78,9 +84,114 @@ BOOL GetInquiryData(HANDLE hDevice, PINQUIRYDATA InquiryData)
   return FALSE;
 }
 
+static ULONGLONG NextRandom(ULONGLONG *Seed)
+{
+  *Seed = *Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *Seed >> 16;
+}
+
+/* Keeps RANDOM_QUEUE_DEPTH unbuffered reads in flight, which measures the
+   per request cost of the whole storage stack rather than the media */
+DWORD GetRandomReadRate(PCHAR Name)
+{
+  HANDLE hDevice;
+  HANDLE Events[RANDOM_QUEUE_DEPTH];
+  OVERLAPPED Overlapped[RANDOM_QUEUE_DEPTH];
+  DISK_GEOMETRY Geometry;
+  ULONGLONG Blocks, Offset, Seed;
+  PBYTE Buffer;
+  DWORD dwReturned, Start, Completed = 0;
+  DWORD Index, Wait;
+  BOOL Result;
+
+  hDevice = CreateFile(Name,
+                       GENERIC_READ,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       NULL,
+                       OPEN_EXISTING,
+                       FILE_FLAG_OVERLAPPED | FILE_FLAG_NO_BUFFERING,
+                       NULL);
+  if (hDevice == INVALID_HANDLE_VALUE)
+    {
+      return 0;
+    }
+
+  Result = DeviceIoControl(hDevice,
+                           IOCTL_DISK_GET_DRIVE_GEOMETRY,
+                           NULL,
+                           0,
+                           &Geometry,
+                           sizeof(Geometry),
+                           &dwReturned,
+                           NULL);
+  if (Result == FALSE || Geometry.BytesPerSector > RANDOM_READ_SIZE)
+    {
+      CloseHandle(hDevice);
+      return 0;
+    }
+  Blocks = (ULONGLONG)Geometry.Cylinders.QuadPart * Geometry.TracksPerCylinder *
+           Geometry.SectorsPerTrack * Geometry.BytesPerSector / RANDOM_READ_SIZE;
+  if (Blocks == 0)
+    {
+      CloseHandle(hDevice);
+      return 0;
+    }
+
+  Buffer = VirtualAlloc(NULL, RANDOM_QUEUE_DEPTH * RANDOM_READ_SIZE, MEM_COMMIT, PAGE_READWRITE);
+  Seed = GetTickCount();
+
+  for (Index = 0; Index < RANDOM_QUEUE_DEPTH; Index++)
+    {
+      Events[Index] = CreateEvent(NULL, TRUE, FALSE, NULL);
+    }
+
+  Start = GetTickCount();
+  for (Index = 0; Index < RANDOM_QUEUE_DEPTH; Index++)
+    {
+      Offset = (NextRandom(&Seed) % Blocks) * RANDOM_READ_SIZE;
+      memset(&Overlapped[Index], 0, sizeof(OVERLAPPED));
+      Overlapped[Index].Offset = (DWORD)Offset;
+      Overlapped[Index].OffsetHigh = (DWORD)(Offset >> 32);
+      Overlapped[Index].hEvent = Events[Index];
+      ReadFile(hDevice, Buffer + Index * RANDOM_READ_SIZE, RANDOM_READ_SIZE, NULL, &Overlapped[Index]);
+    }
+
+  while (GetTickCount() - Start < 2000)
+    {
+      Wait = WaitForMultipleObjects(RANDOM_QUEUE_DEPTH, Events, FALSE, 1000);
+      if (Wait >= WAIT_OBJECT_0 + RANDOM_QUEUE_DEPTH)
+        {
+          continue;
+        }
+      Index = Wait - WAIT_OBJECT_0;
+      if (GetOverlappedResult(hDevice, &Overlapped[Index], &dwReturned, FALSE))
+        {
+          Completed++;
+        }
+
+      /* Reissue the slot right away to keep the queue full */
+      ResetEvent(Events[Index]);
+      Offset = (NextRandom(&Seed) % Blocks) * RANDOM_READ_SIZE;
+      Overlapped[Index].Offset = (DWORD)Offset;
+      Overlapped[Index].OffsetHigh = (DWORD)(Offset >> 32);
+      ReadFile(hDevice, Buffer + Index * RANDOM_READ_SIZE, RANDOM_READ_SIZE, NULL, &Overlapped[Index]);
+    }
+
+  /* Drain the reads still in flight before freeing their buffers */
+  CancelIo(hDevice);
+  for (Index = 0; Index < RANDOM_QUEUE_DEPTH; Index++)
+    {
+      GetOverlappedResult(hDevice, &Overlapped[Index], &dwReturned, TRUE);
+      CloseHandle(Events[Index]);
+    }
 
+  CloseHandle(hDevice);
+  VirtualFree(Buffer, 0, MEM_RELEASE);
 
-int main(void)
+  return Completed / 2;
+}
+
+int main(int argc, char *argv[])
 {
     HANDLE hDevice;
     OVERLAPPED ov;
@@ -95,9 +206,16 @@ int main(void)
     CHAR Name[20];
 
     INQUIRYDATA InquiryData;
+    ULONG FirstDrive = 0;
+    BOOL SingleDrive = FALSE;
 
+    if (argc > 1)
+      {
+        FirstDrive = strtoul(argv[1], NULL, 10);
+        SingleDrive = TRUE;
+      }
 
-    Drive = 0;
+    Drive = FirstDrive;
     while (1)
       {
         sprintf(Name, "\\\\.\\PHYSICALDRIVE%ld", Drive);
@@ -110,9 +228,9 @@ int main(void)
 			     NULL);
 	if (hDevice == INVALID_HANDLE_VALUE)
 	  {
-	    if (Drive > 0)
+	    if (Drive > FirstDrive)
 	      {
-	        VirtualFree(Buffer, 512 * 1024, MEM_RELEASE);
+	        VirtualFree(Buffer, 0, MEM_RELEASE);
 	      }
 	    else
 	      {
@@ -120,13 +238,13 @@ int main(void)
 	      }
 	    break;
 	  }
-        if (Drive == 0)
+        if (Drive == FirstDrive)
 	  {
-            printf("Transfer Size (kB)           1     2     4     8    16    32    64   128   256\n");
-            printf("Transfer Rate (MB/s)\n");
-            printf("-------------------------------------------------------------------------------\n");
+            printf("Transfer Size (kB)           1     2     4     8    16    32    64   128   256   512  1024  4k QD32\n");
+            printf("Transfer Rate (MB/s)                                                                        (IOPS)\n");
+            printf("---------------------------------------------------------------------------------------------------\n");
 
-	    Buffer = VirtualAlloc(NULL, 512 * 1024, MEM_COMMIT, PAGE_READWRITE);
+	    Buffer = VirtualAlloc(NULL, MAX_TRANSFER_SIZE, MEM_COMMIT, PAGE_READWRITE);
 	  }
         Result = GetInquiryData(hDevice, &InquiryData);
         if (Result)
@@ -139,7 +257,7 @@ int main(void)
 	  }
         Size = 1024;
         memset(&ov, 0, sizeof(OVERLAPPED));
-	while (Size <= 256 * 1024)
+	while (Size <= MAX_TRANSFER_SIZE)
 	  {
 	    memset(Buffer, 0, Size);
 	    dwReadTotal = 0;
@@ -158,8 +276,13 @@ int main(void)
             printf("%3ld.%ld ", dwReadTotal / 1024, (dwReadTotal % 1024) * 10 / 1024);
 	    Size *= 2;
 	  }
-        printf("\n");
 	CloseHandle(hDevice);
+        printf("%7ld\n", GetRandomReadRate(Name));
+	if (SingleDrive)
+	  {
+	    VirtualFree(Buffer, 0, MEM_RELEASE);
+	    break;
+	  }
 	Drive++;
       }
     printf("\n");
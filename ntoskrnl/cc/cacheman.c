@@ -14,7 +14,10 @@
 #define NDEBUG
 #include <debug.h>
 
+extern ULONG InitSafeBootMode;
+
 BOOLEAN CcPfEnablePrefetcher;
+ULONG CcPfEnableMask = PF_ENABLE_APPLICATION_LAUNCH | PF_ENABLE_BOOT;
 PFSN_PREFETCHER_GLOBALS CcPfGlobals;
 MM_SYSTEMSIZE CcCapturedSystemSize;
 
@@ -34,10 +37,13 @@ CcPfInitializePrefetcher(VOID)
 
     /* Setup the Prefetcher Data */
     InitializeListHead(&CcPfGlobals.ActiveTraces);
+    KeInitializeSpinLock(&CcPfGlobals.ActiveTracesLock);
     InitializeListHead(&CcPfGlobals.CompletedTraces);
     ExInitializeFastMutex(&CcPfGlobals.CompletedTracesLock);
 
-    /* FIXME: Setup the rest of the prefetecher */
+    /* Traces of a safe mode boot would not be of any use later */
+    if (InitSafeBootMode) CcPfEnableMask = 0;
+    CcPfEnablePrefetcher = (CcPfEnableMask != 0);
 }
 
 INIT_FUNCTION
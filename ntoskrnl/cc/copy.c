@@ -819,6 +819,9 @@ CcCopyRead (
            FileObject, FileOffset->QuadPart, Length, Wait,
            Buffer, IoStatus);
 
+    /* Let the prefetcher know, even if this is served from the cache */
+    CcPfLogFileAccess(FileObject, FileOffset->QuadPart, Length);
+
     return CcCopyData(FileObject,
                       FileOffset->QuadPart,
                       Buffer,
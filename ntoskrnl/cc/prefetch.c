@@ -0,0 +1,843 @@
+/*
+ * PROJECT:     ReactOS Kernel
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Boot and application launch prefetcher
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* INCLUDES *****************************************************************/
+
+#include <ntoskrnl.h>
+#define NDEBUG
+#include <debug.h>
+
+/*
+ * A scenario is the boot, or the start of an application. While it runs, the
+ * prefetcher logs which parts of which files it reads, in VACB sized units.
+ * When the trace ends, the log is sorted and saved as a scenario file under
+ * %SystemRoot%\Prefetch. The next time the scenario begins, a worker thread
+ * reads the same ranges into the cache, file by file and in offset order,
+ * ahead of the faults that need them.
+ *
+ * Accesses are logged from the cached read and the section page-in paths,
+ * whether they hit the cache or not, so that a trace doesn't shrink as the
+ * prefetcher gets better at its job.
+ *
+ * A scenario file is a PF_TRACE_HEADER, the PF_LOG_ENTRY array and the file
+ * name table. Each name is a ULONG byte count followed by the characters,
+ * padded to a ULONG. FileOffset in the log entries counts VACBs, and FileKey
+ * is the index of the file in the name table.
+ */
+
+/* GLOBALS ******************************************************************/
+
+#define TAG_PREFETCH                'fPcC'
+#define PFSN_TRACE_MAGIC            'hTfP'
+
+#define PFSN_BOOT_TRACE_SECONDS     60
+#define PFSN_BOOT_MAX_ENTRIES       16384
+#define PFSN_BOOT_MAX_FILES         1024
+#define PFSN_APP_TRACE_SECONDS      10
+#define PFSN_APP_MAX_ENTRIES        4096
+#define PFSN_APP_MAX_FILES          256
+#define PFSN_MAX_ACTIVE_TRACES      8
+#define PFSN_MAX_SCENARIO_SIZE      (1024 * 1024)
+
+/* File keys hash to twice as many slots as there are files, see CcPfLogEntry */
+#define PFSN_FILE_HASH_SLOTS(MaxFiles)  ((MaxFiles) * 2)
+#define PFSN_FILE_HASH(Key, Mask) \
+    ((ULONG)((((ULONG_PTR)(Key) >> 3) * 0x9E3779B1) >> 16) & (Mask))
+
+#define PFSN_BOOT_SCENARIO_NAME     L"NTOSBOOT"
+#define PFSN_BOOT_SCENARIO_HASH     0xB00DFAAD
+
+typedef struct _PFSN_TRACE
+{
+    PFSN_TRACE_HEADER Header;
+    WORK_QUEUE_ITEM PrefetchWorkItem;
+    PVOID *FileKeys;
+    PFILE_OBJECT *Files;
+    PULONG FileHash;
+    ULONG FileHashMask;
+    ULONG NumFiles;
+    ULONG MaxFiles;
+    PHANDLE PrefetchedFiles;
+    ULONG NumPrefetchedFiles;
+} PFSN_TRACE, *PPFSN_TRACE;
+
+/* PRIVATE FUNCTIONS ********************************************************/
+
+static
+VOID
+CcPfEndTraceAsync(
+    IN PPFSN_TRACE Trace)
+{
+    /* Whoever gets here first queues the end of the trace */
+    if (!InterlockedExchange(&Trace->Header.EndTraceCalled, TRUE))
+    {
+        ExQueueWorkItem(&Trace->Header.EndTraceWorkItem, DelayedWorkQueue);
+    }
+}
+
+static
+VOID
+NTAPI
+CcPfTraceTimerDpc(
+    IN PKDPC Dpc,
+    IN PVOID DeferredContext,
+    IN PVOID SystemArgument1,
+    IN PVOID SystemArgument2)
+{
+    CcPfEndTraceAsync(DeferredContext);
+}
+
+static
+VOID
+CcPfLogEntry(
+    IN PPFSN_TRACE Trace,
+    IN PFILE_OBJECT FileObject,
+    IN ULONG VacbIndex)
+{
+    PPFSN_LOG_ENTRIES Log = Trace->Header.CurrentTraceBuffer;
+    PPF_LOG_ENTRY Entry;
+    PVOID Key = FileObject->SectionObjectPointer;
+    ULONG FileKey, Slot;
+
+    if (Trace->Header.EndTraceCalled) return;
+
+    /*
+     * Find the file, or add it. Slots hold the file key plus one, and the
+     * table is never more than half full, so probing ends at an empty slot.
+     */
+    for (Slot = PFSN_FILE_HASH(Key, Trace->FileHashMask);
+         Trace->FileHash[Slot] != 0;
+         Slot = (Slot + 1) & Trace->FileHashMask)
+    {
+        if (Trace->FileKeys[Trace->FileHash[Slot] - 1] == Key) break;
+    }
+
+    if (Trace->FileHash[Slot] != 0)
+    {
+        FileKey = Trace->FileHash[Slot] - 1;
+    }
+    else
+    {
+        if (Trace->NumFiles == Trace->MaxFiles) return;
+
+        /* Keep the file object, its name is only looked up at the end */
+        ObReferenceObject(FileObject);
+        FileKey = Trace->NumFiles++;
+        Trace->FileKeys[FileKey] = Key;
+        Trace->Files[FileKey] = FileObject;
+        Trace->FileHash[Slot] = FileKey + 1;
+    }
+
+    /* Several accesses in a row to the same VACB only count once */
+    if (Log->NumEntries != 0)
+    {
+        Entry = &Log->Entries[Log->NumEntries - 1];
+        if ((Entry->FileKey == FileKey) && (Entry->FileOffset == VacbIndex)) return;
+    }
+
+    Entry = &Log->Entries[Log->NumEntries++];
+    Entry->FileOffset = VacbIndex;
+    Entry->Type = 0;
+    Entry->FileKey = FileKey;
+    Trace->Header.NumFaults++;
+
+    /* End the trace early if it is full */
+    if (Log->NumEntries == Log->MaxEntries) CcPfEndTraceAsync(Trace);
+}
+
+static
+int
+__cdecl
+CcPfCompareLogEntries(
+    const void *First,
+    const void *Second)
+{
+    const PF_LOG_ENTRY *Entry1 = First, *Entry2 = Second;
+
+    if (Entry1->FileKey != Entry2->FileKey)
+        return (Entry1->FileKey < Entry2->FileKey) ? -1 : 1;
+    if (Entry1->FileOffset != Entry2->FileOffset)
+        return (Entry1->FileOffset < Entry2->FileOffset) ? -1 : 1;
+    return 0;
+}
+
+static
+VOID
+CcPfGetScenarioPath(
+    IN PPF_SCENARIO_ID ScenarioId,
+    OUT PWCHAR Buffer,
+    IN ULONG BufferLength,
+    OUT PUNICODE_STRING Path)
+{
+    _snwprintf(Buffer,
+               BufferLength / sizeof(WCHAR),
+               L"\\SystemRoot\\Prefetch\\%s-%08lX.pf",
+               ScenarioId->ScenName,
+               ScenarioId->HashId);
+    Buffer[BufferLength / sizeof(WCHAR) - 1] = UNICODE_NULL;
+    RtlInitUnicodeString(Path, Buffer);
+}
+
+static
+NTSTATUS
+CcPfWriteScenario(
+    IN PPFSN_TRACE Trace)
+{
+    PPFSN_LOG_ENTRIES Log = Trace->Header.CurrentTraceBuffer;
+    POBJECT_NAME_INFORMATION *Names;
+    PPF_TRACE_HEADER Scenario;
+    PPF_LOG_ENTRY Entries;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    UNICODE_STRING Path;
+    WCHAR PathBuffer[64];
+    HANDLE Handle;
+    NTSTATUS Status;
+    ULONG i, j, NumEntries, Size, NameLength, ReturnLength;
+    PUCHAR Data;
+
+    if (Log->NumEntries == 0) return STATUS_SUCCESS;
+
+    /* Sort the log by file and offset, and drop the duplicates */
+    qsort(Log->Entries, Log->NumEntries, sizeof(PF_LOG_ENTRY), CcPfCompareLogEntries);
+    for (i = 1, NumEntries = 1; i < (ULONG)Log->NumEntries; i++)
+    {
+        if (CcPfCompareLogEntries(&Log->Entries[i], &Log->Entries[NumEntries - 1]) != 0)
+        {
+            Log->Entries[NumEntries++] = Log->Entries[i];
+        }
+    }
+
+    /* Look up the file names */
+    Names = ExAllocatePoolWithTag(PagedPool, Trace->NumFiles * sizeof(PVOID), TAG_PREFETCH);
+    if (!Names) return STATUS_INSUFFICIENT_RESOURCES;
+
+    Size = sizeof(PF_TRACE_HEADER) + NumEntries * sizeof(PF_LOG_ENTRY);
+    for (i = 0; i < Trace->NumFiles; i++)
+    {
+        Names[i] = ExAllocatePoolWithTag(PagedPool, PAGE_SIZE, TAG_PREFETCH);
+        if (Names[i])
+        {
+            Status = ObQueryNameString(Trace->Files[i], Names[i], PAGE_SIZE, &ReturnLength);
+            if (!NT_SUCCESS(Status))
+            {
+                /* The file can't be prefetched without a name */
+                ExFreePoolWithTag(Names[i], TAG_PREFETCH);
+                Names[i] = NULL;
+            }
+        }
+
+        NameLength = Names[i] ? Names[i]->Name.Length : 0;
+        Size += sizeof(ULONG) + ALIGN_UP_BY(NameLength, sizeof(ULONG));
+    }
+
+    /* Build the scenario file */
+    Scenario = ExAllocatePoolWithTag(PagedPool, Size, TAG_PREFETCH);
+    if (!Scenario)
+    {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Cleanup;
+    }
+
+    RtlZeroMemory(Scenario, sizeof(PF_TRACE_HEADER));
+    Scenario->Version = PF_CURRENT_VERSION;
+    Scenario->MagicNumber = PF_SCENARIO_MAGIC_NUMBER;
+    Scenario->Size = Size;
+    Scenario->ScenarioId = Trace->Header.ScenarioId;
+    Scenario->ScenarioType = Trace->Header.ScenarioType;
+    Scenario->TraceBufferOffset = sizeof(PF_TRACE_HEADER);
+    Scenario->NumEntries = NumEntries;
+    Scenario->SectionInfoOffset = sizeof(PF_TRACE_HEADER) + NumEntries * sizeof(PF_LOG_ENTRY);
+    Scenario->NumSections = Trace->NumFiles;
+    Scenario->LaunchTime = Trace->Header.LaunchTime;
+
+    Entries = (PPF_LOG_ENTRY)(Scenario + 1);
+    RtlCopyMemory(Entries, Log->Entries, NumEntries * sizeof(PF_LOG_ENTRY));
+
+    Data = (PUCHAR)Scenario + Scenario->SectionInfoOffset;
+    for (i = 0; i < Trace->NumFiles; i++)
+    {
+        NameLength = Names[i] ? Names[i]->Name.Length : 0;
+        *(PULONG)Data = NameLength;
+        Data += sizeof(ULONG);
+
+        if (NameLength) RtlCopyMemory(Data, Names[i]->Name.Buffer, NameLength);
+        for (j = NameLength; j < ALIGN_UP_BY(NameLength, sizeof(ULONG)); j++) Data[j] = 0;
+        Data += ALIGN_UP_BY(NameLength, sizeof(ULONG));
+    }
+    ASSERT(Data == (PUCHAR)Scenario + Size);
+
+    /* Make sure the directory is there, then write the file */
+    RtlInitUnicodeString(&Path, L"\\SystemRoot\\Prefetch");
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &Path,
+                               OBJ_CASE_INSENSITIVE | OBJ_KERNEL_HANDLE,
+                               NULL,
+                               NULL);
+    Status = ZwCreateFile(&Handle,
+                          FILE_LIST_DIRECTORY | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          NULL,
+                          FILE_ATTRIBUTE_DIRECTORY,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE,
+                          FILE_OPEN_IF,
+                          FILE_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT,
+                          NULL,
+                          0);
+    if (!NT_SUCCESS(Status)) goto Cleanup;
+    ZwClose(Handle);
+
+    CcPfGetScenarioPath(&Trace->Header.ScenarioId, PathBuffer, sizeof(PathBuffer), &Path);
+    Status = ZwCreateFile(&Handle,
+                          FILE_WRITE_DATA | SYNCHRONIZE,
+                          &ObjectAttributes,
+                          &IoStatusBlock,
+                          NULL,
+                          FILE_ATTRIBUTE_NORMAL,
+                          0,
+                          FILE_OVERWRITE_IF,
+                          FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT,
+                          NULL,
+                          0);
+    if (!NT_SUCCESS(Status)) goto Cleanup;
+
+    Status = ZwWriteFile(Handle,
+                         NULL,
+                         NULL,
+                         NULL,
+                         &IoStatusBlock,
+                         Scenario,
+                         Size,
+                         NULL,
+                         NULL);
+    ZwClose(Handle);
+
+Cleanup:
+    if (Scenario) ExFreePoolWithTag(Scenario, TAG_PREFETCH);
+    for (i = 0; i < Trace->NumFiles; i++)
+    {
+        if (Names[i]) ExFreePoolWithTag(Names[i], TAG_PREFETCH);
+    }
+    ExFreePoolWithTag(Names, TAG_PREFETCH);
+    return Status;
+}
+
+static
+VOID
+NTAPI
+CcPfEndTraceWorker(
+    IN PVOID Context)
+{
+    PPFSN_TRACE Trace = Context;
+    LARGE_INTEGER Now;
+    NTSTATUS Status;
+    KIRQL OldIrql;
+    ULONG i;
+
+    /* Stop logging into the trace */
+    KeAcquireSpinLock(&CcPfGlobals.ActiveTracesLock, &OldIrql);
+    RemoveEntryList(&Trace->Header.ActiveTracesLink);
+    if (CcPfGlobals.SystemWideTrace == &Trace->Header) CcPfGlobals.SystemWideTrace = NULL;
+    KeReleaseSpinLock(&CcPfGlobals.ActiveTracesLock, OldIrql);
+
+    /* Make sure the timer is done with us */
+    KeCancelTimer(&Trace->Header.TraceTimer);
+    KeFlushQueuedDpcs();
+
+    /* Wait for the prefetch, then let go of what it read */
+    ExWaitForRundownProtectionRelease(&Trace->Header.RefCount);
+    for (i = 0; i < Trace->NumPrefetchedFiles; i++)
+    {
+        ZwClose(Trace->PrefetchedFiles[i]);
+    }
+    if (Trace->PrefetchedFiles) ExFreePoolWithTag(Trace->PrefetchedFiles, TAG_PREFETCH);
+
+    Status = CcPfWriteScenario(Trace);
+
+    KeQuerySystemTime(&Now);
+    DbgPrintEx(DPFLTR_PREFETCHER_ID,
+               DPFLTR_TRACE_LEVEL,
+               "CCPF: Traced %S for %I64u ms: %ld entries in %lu files (Status 0x%08lx)\n",
+               Trace->Header.ScenarioId.ScenName,
+               (Now.QuadPart - Trace->Header.LaunchTime.QuadPart) / 10000,
+               Trace->Header.NumFaults,
+               Trace->NumFiles,
+               Status);
+
+    for (i = 0; i < Trace->NumFiles; i++)
+    {
+        ObDereferenceObject(Trace->Files[i]);
+    }
+    if (Trace->Header.Process) ObDereferenceObject(Trace->Header.Process);
+    ExFreePoolWithTag(Trace->Header.CurrentTraceBuffer, TAG_PREFETCH);
+    ExFreePoolWithTag(Trace, TAG_PREFETCH);
+}
+
+static
+NTSTATUS
+CcPfReadScenario(
+    IN PPF_SCENARIO_ID ScenarioId,
+    OUT PPF_TRACE_HEADER *ScenarioOut)
+{
+    FILE_STANDARD_INFORMATION StandardInfo;
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    PPF_TRACE_HEADER Scenario;
+    UNICODE_STRING Path;
+    WCHAR PathBuffer[64];
+    HANDLE Handle;
+    NTSTATUS Status;
+    ULONG Size;
+
+    CcPfGetScenarioPath(ScenarioId, PathBuffer, sizeof(PathBuffer), &Path);
+    InitializeObjectAttributes(&ObjectAttributes,
+                               &Path,
+                               OBJ_CASE_INSENSITIVE | OBJ_KERNEL_HANDLE,
+                               NULL,
+                               NULL);
+    Status = ZwOpenFile(&Handle,
+                        FILE_READ_DATA | SYNCHRONIZE,
+                        &ObjectAttributes,
+                        &IoStatusBlock,
+                        FILE_SHARE_READ,
+                        FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT);
+    if (!NT_SUCCESS(Status)) return Status;
+
+    Status = ZwQueryInformationFile(Handle,
+                                    &IoStatusBlock,
+                                    &StandardInfo,
+                                    sizeof(StandardInfo),
+                                    FileStandardInformation);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    if ((StandardInfo.EndOfFile.QuadPart < sizeof(PF_TRACE_HEADER)) ||
+        (StandardInfo.EndOfFile.QuadPart > PFSN_MAX_SCENARIO_SIZE))
+    {
+        Status = STATUS_INVALID_IMAGE_FORMAT;
+        goto Quit;
+    }
+    Size = StandardInfo.EndOfFile.LowPart;
+
+    Scenario = ExAllocatePoolWithTag(PagedPool, Size, TAG_PREFETCH);
+    if (!Scenario)
+    {
+        Status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Quit;
+    }
+
+    Status = ZwReadFile(Handle, NULL, NULL, NULL, &IoStatusBlock, Scenario, Size, NULL, NULL);
+    if (NT_SUCCESS(Status) && (IoStatusBlock.Information != Size)) Status = STATUS_END_OF_FILE;
+
+    /* Don't trust anything in there that would take us out of the buffer */
+    if (NT_SUCCESS(Status) &&
+        ((Scenario->MagicNumber != PF_SCENARIO_MAGIC_NUMBER) ||
+         (Scenario->Version != PF_CURRENT_VERSION) ||
+         (Scenario->Size != Size) ||
+         (Scenario->ScenarioId.HashId != ScenarioId->HashId) ||
+         (Scenario->TraceBufferOffset < sizeof(PF_TRACE_HEADER)) ||
+         (Scenario->TraceBufferOffset > Size) ||
+         (Scenario->TraceBufferOffset % sizeof(ULONG)) ||
+         (Scenario->NumEntries > (Size - Scenario->TraceBufferOffset) / sizeof(PF_LOG_ENTRY)) ||
+         (Scenario->SectionInfoOffset > Size) ||
+         (Scenario->SectionInfoOffset % sizeof(ULONG)) ||
+         (Scenario->NumSections > PFSN_BOOT_MAX_FILES)))
+    {
+        DPRINT1("Ignoring invalid scenario file %wZ\n", &Path);
+        Status = STATUS_INVALID_IMAGE_FORMAT;
+    }
+
+    if (NT_SUCCESS(Status))
+        *ScenarioOut = Scenario;
+    else
+        ExFreePoolWithTag(Scenario, TAG_PREFETCH);
+
+Quit:
+    ZwClose(Handle);
+    return Status;
+}
+
+static
+ULONG
+CcPfPrefetchRanges(
+    IN PFILE_OBJECT FileObject,
+    IN PPF_LOG_ENTRY Entries,
+    IN ULONG NumEntries)
+{
+    PROS_SHARED_CACHE_MAP SharedCacheMap;
+    LONGLONG Offset;
+    PROS_VACB Vacb;
+    PVOID BaseAddress;
+    BOOLEAN Valid;
+    NTSTATUS Status;
+    ULONG i, BytesRead = 0;
+
+    SharedCacheMap = FileObject->SectionObjectPointer->SharedCacheMap;
+    if (!SharedCacheMap) return 0;
+
+    /* Lock the file like the lazy writer's read ahead does */
+    if (!SharedCacheMap->Callbacks->AcquireForReadAhead(SharedCacheMap->LazyWriteContext, TRUE))
+        return 0;
+
+    for (i = 0; i < NumEntries; i++)
+    {
+        /* The file may have shrunk since the trace */
+        Offset = (LONGLONG)Entries[i].FileOffset * VACB_MAPPING_GRANULARITY;
+        if (Offset >= SharedCacheMap->SectionSize.QuadPart) break;
+
+        Status = CcRosRequestVacb(SharedCacheMap, Offset, &BaseAddress, &Valid, &Vacb);
+        if (!NT_SUCCESS(Status)) break;
+
+        if (!Valid)
+        {
+            Status = CcReadVirtualAddress(Vacb);
+            if (!NT_SUCCESS(Status))
+            {
+                CcRosReleaseVacb(SharedCacheMap, Vacb, FALSE, FALSE, FALSE);
+                break;
+            }
+
+            BytesRead += VACB_MAPPING_GRANULARITY;
+        }
+
+        CcRosReleaseVacb(SharedCacheMap, Vacb, TRUE, FALSE, FALSE);
+    }
+
+    SharedCacheMap->Callbacks->ReleaseFromReadAhead(SharedCacheMap->LazyWriteContext);
+    return BytesRead;
+}
+
+static
+HANDLE
+CcPfPrefetchFile(
+    IN PUNICODE_STRING FileName,
+    IN PPF_LOG_ENTRY Entries,
+    IN ULONG NumEntries,
+    IN OUT PULONG BytesRead)
+{
+    OBJECT_ATTRIBUTES ObjectAttributes;
+    IO_STATUS_BLOCK IoStatusBlock;
+    LARGE_INTEGER ByteOffset;
+    PFILE_OBJECT FileObject;
+    HANDLE Handle;
+    NTSTATUS Status;
+    UCHAR Byte;
+
+    InitializeObjectAttributes(&ObjectAttributes,
+                               FileName,
+                               OBJ_CASE_INSENSITIVE | OBJ_KERNEL_HANDLE,
+                               NULL,
+                               NULL);
+    Status = ZwOpenFile(&Handle,
+                        FILE_READ_DATA | SYNCHRONIZE,
+                        &ObjectAttributes,
+                        &IoStatusBlock,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT);
+    if (!NT_SUCCESS(Status)) return NULL;
+
+    /* A cached read gets the file system to set up the cache map */
+    ByteOffset.QuadPart = 0;
+    Status = ZwReadFile(Handle, NULL, NULL, NULL, &IoStatusBlock, &Byte, sizeof(Byte), &ByteOffset, NULL);
+    if (NT_SUCCESS(Status))
+    {
+        Status = ObReferenceObjectByHandle(Handle,
+                                           0,
+                                           IoFileObjectType,
+                                           KernelMode,
+                                           (PVOID*)&FileObject,
+                                           NULL);
+    }
+
+    if (!NT_SUCCESS(Status))
+    {
+        ZwClose(Handle);
+        return NULL;
+    }
+
+    *BytesRead += CcPfPrefetchRanges(FileObject, Entries, NumEntries);
+    ObDereferenceObject(FileObject);
+
+    /* The cached data goes away with the last handle, so keep this one */
+    return Handle;
+}
+
+static
+VOID
+NTAPI
+CcPfPrefetchWorker(
+    IN PVOID Context)
+{
+    PPFSN_TRACE Trace = Context;
+    PPF_TRACE_HEADER Scenario;
+    PUNICODE_STRING Names = NULL;
+    PPF_LOG_ENTRY Entries;
+    LARGE_INTEGER Start, End;
+    PUCHAR Data, DataEnd;
+    NTSTATUS Status;
+    HANDLE Handle;
+    ULONG i, j, FileKey, NameLength, BytesRead = 0;
+
+    Status = CcPfReadScenario(&Trace->Header.ScenarioId, &Scenario);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    InterlockedIncrement(&CcPfGlobals.ActivePrefetches);
+    KeQuerySystemTime(&Start);
+
+    Names = ExAllocatePoolWithTag(PagedPool,
+                                  Scenario->NumSections * sizeof(UNICODE_STRING),
+                                  TAG_PREFETCH);
+    Trace->PrefetchedFiles = ExAllocatePoolWithTag(PagedPool,
+                                                   Scenario->NumSections * sizeof(HANDLE),
+                                                   TAG_PREFETCH);
+    if (!Names || !Trace->PrefetchedFiles) goto Cleanup;
+
+    /* Walk the name table */
+    Data = (PUCHAR)Scenario + Scenario->SectionInfoOffset;
+    DataEnd = (PUCHAR)Scenario + Scenario->Size;
+    for (i = 0; i < Scenario->NumSections; i++)
+    {
+        if ((ULONG)(DataEnd - Data) < sizeof(ULONG)) goto Cleanup;
+        NameLength = *(PULONG)Data;
+        Data += sizeof(ULONG);
+
+        if ((NameLength > MAXUSHORT - 1) ||
+            (NameLength % sizeof(WCHAR)) ||
+            (ALIGN_UP_BY(NameLength, sizeof(ULONG)) > (ULONG)(DataEnd - Data)))
+        {
+            goto Cleanup;
+        }
+
+        Names[i].Length = Names[i].MaximumLength = (USHORT)NameLength;
+        Names[i].Buffer = (PWCHAR)Data;
+        Data += ALIGN_UP_BY(NameLength, sizeof(ULONG));
+    }
+
+    /* The log is sorted by file, then offset: read each file front to back */
+    Entries = (PPF_LOG_ENTRY)((PUCHAR)Scenario + Scenario->TraceBufferOffset);
+    for (i = 0; i < Scenario->NumEntries; i = j)
+    {
+        FileKey = Entries[i].FileKey;
+        for (j = i + 1; (j < Scenario->NumEntries) && (Entries[j].FileKey == FileKey); j++);
+
+        if ((FileKey >= Scenario->NumSections) || !Names[FileKey].Length) continue;
+        if (Trace->NumPrefetchedFiles == Scenario->NumSections) break;
+
+        Handle = CcPfPrefetchFile(&Names[FileKey], &Entries[i], j - i, &BytesRead);
+        if (Handle) Trace->PrefetchedFiles[Trace->NumPrefetchedFiles++] = Handle;
+    }
+
+Cleanup:
+    KeQuerySystemTime(&End);
+    DbgPrintEx(DPFLTR_PREFETCHER_ID,
+               DPFLTR_TRACE_LEVEL,
+               "CCPF: Prefetched %lu KB from %lu files for %S in %I64u ms\n",
+               BytesRead / 1024,
+               Trace->NumPrefetchedFiles,
+               Trace->Header.ScenarioId.ScenName,
+               (End.QuadPart - Start.QuadPart) / 10000);
+
+    if (Names) ExFreePoolWithTag(Names, TAG_PREFETCH);
+    ExFreePoolWithTag(Scenario, TAG_PREFETCH);
+    InterlockedDecrement(&CcPfGlobals.ActivePrefetches);
+
+Quit:
+    ExReleaseRundownProtection(&Trace->Header.RefCount);
+}
+
+static
+NTSTATUS
+CcPfBeginTrace(
+    IN PPF_SCENARIO_ID ScenarioId,
+    IN PF_SCENARIO_TYPE ScenarioType,
+    IN PEPROCESS Process OPTIONAL)
+{
+    PPFSN_TRACE Trace, OtherTrace;
+    PLIST_ENTRY ListEntry;
+    ULONG MaxEntries, MaxFiles, Seconds, ActiveTraces = 0;
+    KIRQL OldIrql;
+
+    if (ScenarioType == PfSystemBootScenarioType)
+    {
+        MaxEntries = PFSN_BOOT_MAX_ENTRIES;
+        MaxFiles = PFSN_BOOT_MAX_FILES;
+        Seconds = PFSN_BOOT_TRACE_SECONDS;
+    }
+    else
+    {
+        MaxEntries = PFSN_APP_MAX_ENTRIES;
+        MaxFiles = PFSN_APP_MAX_FILES;
+        Seconds = PFSN_APP_TRACE_SECONDS;
+    }
+
+    /* Entries get logged at DISPATCH_LEVEL, so everything is nonpaged */
+    Trace = ExAllocatePoolWithTag(NonPagedPool,
+                                  sizeof(PFSN_TRACE) + MaxFiles * 2 * sizeof(PVOID) +
+                                  PFSN_FILE_HASH_SLOTS(MaxFiles) * sizeof(ULONG),
+                                  TAG_PREFETCH);
+    if (!Trace) return STATUS_INSUFFICIENT_RESOURCES;
+    RtlZeroMemory(Trace, sizeof(PFSN_TRACE));
+
+    Trace->Header.CurrentTraceBuffer =
+        ExAllocatePoolWithTag(NonPagedPool,
+                              FIELD_OFFSET(PFSN_LOG_ENTRIES, Entries[MaxEntries]),
+                              TAG_PREFETCH);
+    if (!Trace->Header.CurrentTraceBuffer)
+    {
+        ExFreePoolWithTag(Trace, TAG_PREFETCH);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    Trace->Header.CurrentTraceBuffer->NumEntries = 0;
+    Trace->Header.CurrentTraceBuffer->MaxEntries = MaxEntries;
+
+    Trace->Header.Magic = PFSN_TRACE_MAGIC;
+    Trace->Header.ScenarioId = *ScenarioId;
+    Trace->Header.ScenarioType = ScenarioType;
+    Trace->Header.MaxFaults = MaxEntries;
+    Trace->Header.Process = Process;
+    KeQuerySystemTime(&Trace->Header.LaunchTime);
+    ExInitializeRundownProtection(&Trace->Header.RefCount);
+    ExInitializeWorkItem(&Trace->Header.EndTraceWorkItem, CcPfEndTraceWorker, Trace);
+    ExInitializeWorkItem(&Trace->PrefetchWorkItem, CcPfPrefetchWorker, Trace);
+    KeInitializeTimer(&Trace->Header.TraceTimer);
+    KeInitializeDpc(&Trace->Header.TraceTimerDpc, CcPfTraceTimerDpc, Trace);
+    Trace->Header.TraceTimerPeriod.QuadPart = Int32x32To64(Seconds, -10000000);
+    Trace->FileKeys = (PVOID*)(Trace + 1);
+    Trace->Files = (PFILE_OBJECT*)(Trace->FileKeys + MaxFiles);
+    Trace->FileHash = (PULONG)(Trace->Files + MaxFiles);
+    Trace->FileHashMask = PFSN_FILE_HASH_SLOTS(MaxFiles) - 1;
+    RtlZeroMemory(Trace->FileHash, PFSN_FILE_HASH_SLOTS(MaxFiles) * sizeof(ULONG));
+    Trace->MaxFiles = MaxFiles;
+
+    /* Don't trace a scenario twice, nor too many at once */
+    KeAcquireSpinLock(&CcPfGlobals.ActiveTracesLock, &OldIrql);
+    for (ListEntry = CcPfGlobals.ActiveTraces.Flink;
+         ListEntry != &CcPfGlobals.ActiveTraces;
+         ListEntry = ListEntry->Flink)
+    {
+        OtherTrace = CONTAINING_RECORD(ListEntry, PFSN_TRACE, Header.ActiveTracesLink);
+        if (OtherTrace->Header.ScenarioId.HashId == ScenarioId->HashId) break;
+        ActiveTraces++;
+    }
+
+    if ((ListEntry != &CcPfGlobals.ActiveTraces) || (ActiveTraces >= PFSN_MAX_ACTIVE_TRACES))
+    {
+        KeReleaseSpinLock(&CcPfGlobals.ActiveTracesLock, OldIrql);
+        ExFreePoolWithTag(Trace->Header.CurrentTraceBuffer, TAG_PREFETCH);
+        ExFreePoolWithTag(Trace, TAG_PREFETCH);
+        return STATUS_TOO_MANY_SESSIONS;
+    }
+
+    if (Process) ObReferenceObject(Process);
+    InsertTailList(&CcPfGlobals.ActiveTraces, &Trace->Header.ActiveTracesLink);
+    if (ScenarioType == PfSystemBootScenarioType) CcPfGlobals.SystemWideTrace = &Trace->Header;
+    KeSetTimer(&Trace->Header.TraceTimer, Trace->Header.TraceTimerPeriod, &Trace->Header.TraceTimerDpc);
+    KeReleaseSpinLock(&CcPfGlobals.ActiveTracesLock, OldIrql);
+
+    /* Replay the last trace while this one is recorded */
+    ExAcquireRundownProtection(&Trace->Header.RefCount);
+    ExQueueWorkItem(&Trace->PrefetchWorkItem, DelayedWorkQueue);
+    return STATUS_SUCCESS;
+}
+
+/* FUNCTIONS ****************************************************************/
+
+VOID
+NTAPI
+CcPfLogFileAccess(
+    IN PFILE_OBJECT FileObject,
+    IN LONGLONG FileOffset,
+    IN ULONG Length)
+{
+    PEPROCESS Process = PsGetCurrentProcess();
+    PPFSN_TRACE Trace;
+    PLIST_ENTRY ListEntry;
+    LONGLONG Offset;
+    KIRQL OldIrql;
+
+    /* Keep this cheap when nothing is traced */
+    if (IsListEmpty(&CcPfGlobals.ActiveTraces)) return;
+    if (!FileObject->SectionObjectPointer || !Length || (FileOffset < 0)) return;
+
+    KeAcquireSpinLock(&CcPfGlobals.ActiveTracesLock, &OldIrql);
+    for (ListEntry = CcPfGlobals.ActiveTraces.Flink;
+         ListEntry != &CcPfGlobals.ActiveTraces;
+         ListEntry = ListEntry->Flink)
+    {
+        /* The boot trace takes everything, the others their own process */
+        Trace = CONTAINING_RECORD(ListEntry, PFSN_TRACE, Header.ActiveTracesLink);
+        if (Trace->Header.Process && (Trace->Header.Process != Process)) continue;
+
+        for (Offset = ROUND_DOWN(FileOffset, VACB_MAPPING_GRANULARITY);
+             Offset < FileOffset + Length;
+             Offset += VACB_MAPPING_GRANULARITY)
+        {
+            CcPfLogEntry(Trace, FileObject, (ULONG)(Offset / VACB_MAPPING_GRANULARITY));
+        }
+    }
+    KeReleaseSpinLock(&CcPfGlobals.ActiveTracesLock, OldIrql);
+}
+
+NTSTATUS
+NTAPI
+CcPfBeginBootPhase(
+    IN PF_BOOT_PHASE_ID Phase)
+{
+    PF_SCENARIO_ID ScenarioId;
+
+    /* The file systems are up once the session manager is about to start */
+    if (Phase != PfSessionManagerInitPhase) return STATUS_SUCCESS;
+    if (!(CcPfEnableMask & PF_ENABLE_BOOT)) return STATUS_NOT_SUPPORTED;
+
+    RtlZeroMemory(&ScenarioId, sizeof(ScenarioId));
+    wcscpy(ScenarioId.ScenName, PFSN_BOOT_SCENARIO_NAME);
+    ScenarioId.HashId = PFSN_BOOT_SCENARIO_HASH;
+    return CcPfBeginTrace(&ScenarioId, PfSystemBootScenarioType, NULL);
+}
+
+NTSTATUS
+NTAPI
+CcPfBeginAppLaunch(
+    IN PEPROCESS Process)
+{
+    PF_SCENARIO_ID ScenarioId;
+    PUNICODE_STRING ImageName;
+    NTSTATUS Status;
+    ULONG i, Start;
+
+    PAGED_CODE();
+
+    if (!(CcPfEnableMask & PF_ENABLE_APPLICATION_LAUNCH)) return STATUS_NOT_SUPPORTED;
+
+    Status = SeLocateProcessImageName(Process, &ImageName);
+    if (!NT_SUCCESS(Status)) return Status;
+
+    if (!ImageName->Length)
+    {
+        ExFreePool(ImageName);
+        return STATUS_OBJECT_NAME_NOT_FOUND;
+    }
+
+    /* Scenarios are named after the image, and told apart by its full path */
+    RtlZeroMemory(&ScenarioId, sizeof(ScenarioId));
+    RtlHashUnicodeString(ImageName, TRUE, HASH_STRING_ALGORITHM_X65599, &ScenarioId.HashId);
+
+    for (Start = ImageName->Length / sizeof(WCHAR); Start > 0; Start--)
+    {
+        if (ImageName->Buffer[Start - 1] == OBJ_NAME_PATH_SEPARATOR) break;
+    }
+    for (i = 0; (Start + i < ImageName->Length / sizeof(WCHAR)) &&
+                (i < RTL_NUMBER_OF(ScenarioId.ScenName) - 1); i++)
+    {
+        ScenarioId.ScenName[i] = RtlUpcaseUnicodeChar(ImageName->Buffer[Start + i]);
+    }
+    ExFreePool(ImageName);
+
+    return CcPfBeginTrace(&ScenarioId, PfApplicationLaunchScenarioType, Process);
+}
+
+/* EOF */
@@ -236,6 +236,13 @@ INIT_SECTION CM_SYSTEM_CONTROL_VECTOR CmControlVector[] =
         NULL,
         NULL
     },
+    {
+        L"Session Manager\\Memory Management\\PrefetchParameters",
+        L"EnablePrefetcher",
+        &CcPfEnableMask,
+        NULL,
+        NULL
+    },
     {
         L"Session Manager\\Memory Management",
         L"DynamicMemory",
@@ -530,6 +537,13 @@ INIT_SECTION CM_SYSTEM_CONTROL_VECTOR CmControlVector[] =
         NULL,
         NULL
     },
+    {
+        L"Session Manager\\Kernel",
+        L"DisableDynamicTick",
+        &KiDisableDynamicTick,
+        NULL,
+        NULL
+    },
     {
         L"Session Manager\\Kernel",
         L"ObUnsecureGlobalNames",
@@ -548,7 +548,7 @@ ExpLoadInitialProcess(IN PINIT_BUFFER InitBuffer,
     RtlAppendUnicodeStringToString(&Environment, &NullString);
 
     /* Prepare the prefetcher */
-    //CcPfBeginBootPhase(150);
+    CcPfBeginBootPhase(PfSessionManagerInitPhase);
 
     /* Create SMSS process */
     SmssName = ProcessParams->ImagePathName;
@@ -695,6 +695,10 @@ QSI_DEF(SystemPerformanceInformation)
     Spi->IoReadOperationCount = IoReadOperationCount;
     Spi->IoWriteOperationCount = IoWriteOperationCount;
     Spi->IoOtherOperationCount = IoOtherOperationCount;
+    Spi->PageFaultCount = 0;
+    Spi->DemandZeroCount = 0;
+    Spi->PageReadCount = 0;
+    Spi->PageReadIoCount = 0;
     for (i = 0; i < KeNumberProcessors; i ++)
     {
         Prcb = KiProcessorBlock[i];
@@ -706,6 +710,10 @@ QSI_DEF(SystemPerformanceInformation)
             Spi->IoReadOperationCount += Prcb->IoReadOperationCount;
             Spi->IoWriteOperationCount += Prcb->IoWriteOperationCount;
             Spi->IoOtherOperationCount += Prcb->IoOtherOperationCount;
+            Spi->PageFaultCount += Prcb->MmPageFaultCount;
+            Spi->DemandZeroCount += Prcb->MmDemandZeroCount;
+            Spi->PageReadCount += Prcb->MmPageReadCount;
+            Spi->PageReadIoCount += Prcb->MmPageReadIoCount;
         }
     }
 
@@ -726,13 +734,9 @@ QSI_DEF(SystemPerformanceInformation)
     Spi->CommitLimit = MmNumberOfPhysicalPages + MiFreeSwapPages + MiUsedSwapPages;
 
     Spi->PeakCommitment = 0; /* FIXME */
-    Spi->PageFaultCount = 0; /* FIXME */
     Spi->CopyOnWriteCount = 0; /* FIXME */
     Spi->TransitionCount = 0; /* FIXME */
     Spi->CacheTransitionCount = 0; /* FIXME */
-    Spi->DemandZeroCount = 0; /* FIXME */
-    Spi->PageReadCount = 0; /* FIXME */
-    Spi->PageReadIoCount = 0; /* FIXME */
     Spi->CacheReadCount = 0; /* FIXME */
     Spi->CacheIoCount = 0; /* FIXME */
     Spi->DirtyPagesWriteCount = 0; /* FIXME */
@@ -65,6 +65,35 @@ extern ULONG CcPinReadNoWait;
 extern ULONG CcPinMappedDataCount;
 extern ULONG CcDataPages;
 extern ULONG CcDataFlushes;
+extern ULONG CcPfEnableMask;
+
+#define PF_CURRENT_VERSION              17
+#define PF_SCENARIO_MAGIC_NUMBER        'ACCS'
+
+/* EnablePrefetcher registry value */
+#define PF_ENABLE_APPLICATION_LAUNCH    0x1
+#define PF_ENABLE_BOOT                  0x2
+
+typedef enum _PF_SCENARIO_TYPE
+{
+    PfApplicationLaunchScenarioType,
+    PfSystemBootScenarioType,
+    PfMaxScenarioType
+} PF_SCENARIO_TYPE;
+
+typedef enum _PF_BOOT_PHASE_ID
+{
+    PfKernelInitPhase = 0,
+    PfBootDriverInitPhase = 90,
+    PfSystemDriverInitPhase = 120,
+    PfSessionManagerInitPhase = 150,
+    PfSMRegistryInitPhase = 180,
+    PfVideoInitPhase = 210,
+    PfPostVideoInitPhase = 240,
+    PfBootAcceptedRegistryInitPhase = 270,
+    PfUserShellReadyPhase = 300,
+    PfMaxBootPhaseId = 900
+} PF_BOOT_PHASE_ID;
 
 typedef struct _PF_SCENARIO_ID
 {
@@ -167,6 +196,8 @@ typedef struct _PFSN_PREFETCHER_GLOBALS
     LONG ActivePrefetches;
 } PFSN_PREFETCHER_GLOBALS, *PPFSN_PREFETCHER_GLOBALS;
 
+extern PFSN_PREFETCHER_GLOBALS CcPfGlobals;
+
 typedef struct _ROS_SHARED_CACHE_MAP
 {
     CSHORT NodeTypeCode;
@@ -293,6 +324,26 @@ CcPfInitializePrefetcher(
     VOID
 );
 
+NTSTATUS
+NTAPI
+CcPfBeginBootPhase(
+    IN PF_BOOT_PHASE_ID Phase
+);
+
+NTSTATUS
+NTAPI
+CcPfBeginAppLaunch(
+    IN PEPROCESS Process
+);
+
+VOID
+NTAPI
+CcPfLogFileAccess(
+    IN PFILE_OBJECT FileObject,
+    IN LONGLONG FileOffset,
+    IN ULONG Length
+);
+
 VOID
 NTAPI
 CcMdlReadComplete2(
@@ -321,6 +321,26 @@ typedef struct _IO_INTERRUPT
     KSPIN_LOCK SpinLock;
 } IO_INTERRUPT, *PIO_INTERRUPT;
 
+//
+// Message Signaled Interrupt, one per message connected by IoConnectInterruptEx
+//
+typedef struct _IO_MESSAGE_INTERRUPT
+{
+    KINTERRUPT Interrupt;
+    PKMESSAGE_SERVICE_ROUTINE MessageServiceRoutine;
+    PVOID ServiceContext;
+    ULONG MessageId;
+} IO_MESSAGE_INTERRUPT, *PIO_MESSAGE_INTERRUPT;
+
+//
+// Private part that follows the message table returned to the driver
+//
+typedef struct _IO_MESSAGE_INTERRUPT_BLOCK
+{
+    KSPIN_LOCK SpinLock;
+    IO_MESSAGE_INTERRUPT Message[ANYSIZE_ARRAY];
+} IO_MESSAGE_INTERRUPT_BLOCK, *PIO_MESSAGE_INTERRUPT_BLOCK;
+
 //
 // I/O Error Log Packet Header
 //
@@ -581,6 +601,13 @@ IopFixupResourceListWithRequirements(
     OUT PCM_RESOURCE_LIST *ResourceList
 );
 
+VOID
+NTAPI
+IopReleaseMessageInterrupts(
+    IN PCM_RESOURCE_LIST ResourceList,
+    IN ULONG FirstDescriptor
+);
+
 NTSTATUS
 NTAPI
 IopDetectResourceConflict(
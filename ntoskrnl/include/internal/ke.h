@@ -142,6 +142,9 @@ extern ULONG KeTimeIncrement;
 extern ULONG KeTimeAdjustment;
 extern BOOLEAN KiTimeAdjustmentEnabled;
 extern LONG KiTickOffset;
+extern ULONG KiDisableDynamicTick;
+extern ULONG KiDynamicTickSuspendCount;
+extern ULONG KiDynamicTickSkippedTicks;
 extern ULONG_PTR KiBugCheckData[5];
 extern ULONG KiFreezeFlag;
 extern ULONG KiDPCTimeout;
@@ -418,6 +421,18 @@ KeUpdateRunTime(
     KIRQL Irql
 );
 
+BOOLEAN
+FASTCALL
+KiSuspendClockTick(
+    IN PKPRCB Prcb
+);
+
+VOID
+FASTCALL
+KiResumeClockTick(
+    IN PKPRCB Prcb
+);
+
 VOID
 NTAPI
 KiExpireTimers(
@@ -815,6 +830,11 @@ FASTCALL
 KeZeroPages(IN PVOID Address,
             IN ULONG Size);
 
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size);
+
 BOOLEAN
 FASTCALL
 KeInvalidAccessAllowed(IN PVOID TrapInformation OPTIONAL);
@@ -83,7 +83,8 @@
 }
 
 //
-// Releases an LPC Semaphore to complete a wait
+// Releases an LPC Semaphore to complete a wait. The waiter is only readied,
+// there is no direct switch to it.
 //
 #define LpcpCompleteWait(s)                                 \
 {                                                           \
@@ -169,6 +169,8 @@ typedef struct _MM_SECTION_SEGMENT
     ULONG Flags;
     BOOLEAN WriteCopy;
 	BOOLEAN Locked;
+    ULONG FaultClusterPages;		/* pages read in by the next file-backed fault */
+    LONGLONG NextFaultOffset;		/* offset a sequential fault would hit next */
 
 	struct
 	{
@@ -12,6 +12,232 @@
 #define NDEBUG
 #include <debug.h>
 
+/* PRIVATE FUNCTIONS *********************************************************/
+
+/* The private block lives right after the table, suitably aligned */
+#define IopMessageTableSize(Count) \
+    ALIGN_UP_BY(FIELD_OFFSET(IO_INTERRUPT_MESSAGE_INFO, MessageInfo[Count]), \
+                MEMORY_ALLOCATION_ALIGNMENT)
+
+#define IopMessageBlockFromTable(Table) \
+    ((PIO_MESSAGE_INTERRUPT_BLOCK)((ULONG_PTR)(Table) + \
+                                   IopMessageTableSize((Table)->MessageCount)))
+
+static
+BOOLEAN
+NTAPI
+IopMessageInterruptThunk(
+    IN PKINTERRUPT Interrupt,
+    IN PVOID ServiceContext)
+{
+    PIO_MESSAGE_INTERRUPT Message = ServiceContext;
+
+    return Message->MessageServiceRoutine(Interrupt,
+                                          Message->ServiceContext,
+                                          Message->MessageId);
+}
+
+static
+ULONG
+IopCountMessageInterrupts(
+    IN PCM_RESOURCE_LIST ResourceList,
+    IN PCM_PARTIAL_RESOURCE_DESCRIPTOR *Messages OPTIONAL,
+    OUT PCM_PARTIAL_RESOURCE_DESCRIPTOR *Line OPTIONAL)
+{
+    PCM_FULL_RESOURCE_DESCRIPTOR FullDescriptor;
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR Descriptor;
+    ULONG i, j, Count = 0;
+
+    if (Line) *Line = NULL;
+    if (!ResourceList) return 0;
+
+    FullDescriptor = &ResourceList->List[0];
+    for (i = 0; i < ResourceList->Count; i++)
+    {
+        for (j = 0; j < FullDescriptor->PartialResourceList.Count; j++)
+        {
+            Descriptor = &FullDescriptor->PartialResourceList.PartialDescriptors[j];
+            if (Descriptor->Type != CmResourceTypeInterrupt) continue;
+
+            if (Descriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE)
+            {
+                if (Messages) Messages[Count] = Descriptor;
+                Count++;
+            }
+            else if (Line && !*Line)
+            {
+                *Line = Descriptor;
+            }
+        }
+
+        FullDescriptor = CmiGetNextResourceDescriptor(FullDescriptor);
+    }
+
+    return Count;
+}
+
+static
+NTSTATUS
+IopConnectLineBasedInterrupt(
+    IN PDEVICE_OBJECT PhysicalDeviceObject,
+    OUT PKINTERRUPT *InterruptObject,
+    IN PKSERVICE_ROUTINE ServiceRoutine,
+    IN PVOID ServiceContext,
+    IN PKSPIN_LOCK SpinLock OPTIONAL,
+    IN KIRQL SynchronizeIrql,
+    IN BOOLEAN FloatingSave)
+{
+    PDEVICE_NODE DeviceNode = IopGetDeviceNode(PhysicalDeviceObject);
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR Line;
+
+    if (!DeviceNode) return STATUS_INVALID_PARAMETER;
+
+    IopCountMessageInterrupts(DeviceNode->ResourceListTranslated, NULL, &Line);
+    if (!Line)
+    {
+        DPRINT1("No line interrupt for %wZ\n", &DeviceNode->InstancePath);
+        return STATUS_NOT_FOUND;
+    }
+
+    /* Without a lock of their own, the interrupt synchronizes at its own IRQL */
+    return IoConnectInterrupt(InterruptObject,
+                              ServiceRoutine,
+                              ServiceContext,
+                              SpinLock,
+                              Line->u.Interrupt.Vector,
+                              (KIRQL)Line->u.Interrupt.Level,
+                              SpinLock ? SynchronizeIrql : (KIRQL)Line->u.Interrupt.Level,
+                              (Line->Flags & CM_RESOURCE_INTERRUPT_LATCHED) ? Latched : LevelSensitive,
+                              Line->ShareDisposition == CmResourceShareShared,
+                              Line->u.Interrupt.Affinity,
+                              FloatingSave);
+}
+
+static
+VOID
+IopDisconnectMessageInterrupts(
+    IN PIO_INTERRUPT_MESSAGE_INFO Table,
+    IN ULONG Connected)
+{
+    ULONG i;
+
+    for (i = 0; i < Connected; i++)
+    {
+        KeDisconnectInterrupt(Table->MessageInfo[i].InterruptObject);
+    }
+
+    ExFreePoolWithTag(Table, TAG_KINTERRUPT);
+}
+
+static
+NTSTATUS
+IopConnectMessageBasedInterrupt(
+    IN PIO_CONNECT_INTERRUPT_MESSAGE_BASED_PARAMETERS Parameters)
+{
+    PDEVICE_NODE DeviceNode = IopGetDeviceNode(Parameters->PhysicalDeviceObject);
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR *Messages;
+    PIO_INTERRUPT_MESSAGE_INFO Table;
+    PIO_INTERRUPT_MESSAGE_INFO_ENTRY Entry;
+    PIO_MESSAGE_INTERRUPT_BLOCK Block;
+    PKSPIN_LOCK SpinLock;
+    KIRQL SynchronizeIrql;
+    ULONG i, Count, Processor;
+    KAFFINITY Affinity;
+    NTSTATUS Status;
+
+    if (!DeviceNode || !HalGetMessageRoute) return STATUS_NOT_FOUND;
+
+    Count = IopCountMessageInterrupts(DeviceNode->ResourceListTranslated, NULL, NULL);
+    if (!Count) return STATUS_NOT_FOUND;
+
+    Messages = ExAllocatePoolWithTag(PagedPool, Count * sizeof(*Messages), TAG_KINTERRUPT);
+    if (!Messages) return STATUS_INSUFFICIENT_RESOURCES;
+    IopCountMessageInterrupts(DeviceNode->ResourceListTranslated, Messages, NULL);
+
+    /* One allocation for the table the driver sees and the objects behind it */
+    Table = ExAllocatePoolWithTag(NonPagedPool,
+                                  IopMessageTableSize(Count) +
+                                  FIELD_OFFSET(IO_MESSAGE_INTERRUPT_BLOCK, Message[Count]),
+                                  TAG_KINTERRUPT);
+    if (!Table)
+    {
+        ExFreePoolWithTag(Messages, TAG_KINTERRUPT);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(Table, IopMessageTableSize(Count) +
+                         FIELD_OFFSET(IO_MESSAGE_INTERRUPT_BLOCK, Message[Count]));
+    Table->MessageCount = Count;
+    Block = IopMessageBlockFromTable(Table);
+    KeInitializeSpinLock(&Block->SpinLock);
+
+    /* All messages share one lock, so they all synchronize at the highest IRQL */
+    for (i = 0; i < Count; i++)
+    {
+        Entry = &Table->MessageInfo[i];
+        Entry->Vector = Messages[i]->u.MessageInterrupt.Translated.Vector;
+        Entry->TargetProcessorSet = Messages[i]->u.MessageInterrupt.Translated.Affinity;
+        Entry->Mode = Latched;
+        Entry->Polarity = InterruptActiveHigh;
+
+        Status = HalGetMessageRoute(Entry->Vector,
+                                    Entry->TargetProcessorSet,
+                                    &Entry->Irql,
+                                    &Entry->MessageAddress,
+                                    &Entry->MessageData);
+        if (!NT_SUCCESS(Status))
+        {
+            ExFreePoolWithTag(Messages, TAG_KINTERRUPT);
+            ExFreePoolWithTag(Table, TAG_KINTERRUPT);
+            return Status;
+        }
+
+        Table->UnifiedIrql = max(Table->UnifiedIrql, Entry->Irql);
+    }
+    ExFreePoolWithTag(Messages, TAG_KINTERRUPT);
+
+    SpinLock = Parameters->SpinLock ? Parameters->SpinLock : &Block->SpinLock;
+    SynchronizeIrql = Table->UnifiedIrql;
+    if (Parameters->SpinLock) SynchronizeIrql = max(SynchronizeIrql, Parameters->SynchronizeIrql);
+    Table->UnifiedIrql = SynchronizeIrql;
+
+    /* Connect every message on the processor it is routed to */
+    for (i = 0; i < Count; i++)
+    {
+        Entry = &Table->MessageInfo[i];
+        Block->Message[i].MessageServiceRoutine = Parameters->MessageServiceRoutine;
+        Block->Message[i].ServiceContext = Parameters->ServiceContext;
+        Block->Message[i].MessageId = i;
+
+        Affinity = Entry->TargetProcessorSet;
+        for (Processor = 0; !(Affinity & 1); Processor++) Affinity >>= 1;
+
+        KeInitializeInterrupt(&Block->Message[i].Interrupt,
+                              IopMessageInterruptThunk,
+                              &Block->Message[i],
+                              SpinLock,
+                              Entry->Vector,
+                              Entry->Irql,
+                              SynchronizeIrql,
+                              Latched,
+                              FALSE,
+                              (CHAR)Processor,
+                              Parameters->FloatingSave);
+
+        if (!KeConnectInterrupt(&Block->Message[i].Interrupt))
+        {
+            DPRINT1("Failed to connect message %lu on vector 0x%lx\n", i, Entry->Vector);
+            IopDisconnectMessageInterrupts(Table, i);
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        Entry->InterruptObject = &Block->Message[i].Interrupt;
+    }
+
+    *Parameters->ConnectionContext.InterruptMessageTable = Table;
+    return STATUS_SUCCESS;
+}
+
 /* FUNCTIONS *****************************************************************/
 
 /*
@@ -166,4 +392,91 @@ IoDisconnectInterrupt(PKINTERRUPT InterruptObject)
     ExFreePool(IoInterrupt); // ExFreePoolWithTag(IoInterrupt, TAG_KINTERRUPT);
 }
 
+/*
+ * @implemented
+ */
+NTSTATUS
+NTAPI
+IoConnectInterruptEx(IN OUT PIO_CONNECT_INTERRUPT_PARAMETERS Parameters)
+{
+    NTSTATUS Status;
+    PAGED_CODE();
+
+    switch (Parameters->Version)
+    {
+        case CONNECT_FULLY_SPECIFIED:
+        case CONNECT_FULLY_SPECIFIED_GROUP:
+            /* We only have the one group */
+            if (Parameters->FullySpecified.Group != 0) return STATUS_INVALID_PARAMETER;
+
+            return IoConnectInterrupt(Parameters->FullySpecified.InterruptObject,
+                                      Parameters->FullySpecified.ServiceRoutine,
+                                      Parameters->FullySpecified.ServiceContext,
+                                      Parameters->FullySpecified.SpinLock,
+                                      Parameters->FullySpecified.Vector,
+                                      Parameters->FullySpecified.Irql,
+                                      Parameters->FullySpecified.SynchronizeIrql,
+                                      Parameters->FullySpecified.InterruptMode,
+                                      Parameters->FullySpecified.ShareVector,
+                                      Parameters->FullySpecified.ProcessorEnableMask,
+                                      Parameters->FullySpecified.FloatingSave);
+
+        case CONNECT_LINE_BASED:
+            return IopConnectLineBasedInterrupt(Parameters->LineBased.PhysicalDeviceObject,
+                                                Parameters->LineBased.InterruptObject,
+                                                Parameters->LineBased.ServiceRoutine,
+                                                Parameters->LineBased.ServiceContext,
+                                                Parameters->LineBased.SpinLock,
+                                                Parameters->LineBased.SynchronizeIrql,
+                                                Parameters->LineBased.FloatingSave);
+
+        case CONNECT_MESSAGE_BASED:
+            Status = IopConnectMessageBasedInterrupt(&Parameters->MessageBased);
+            if (Status != STATUS_NOT_FOUND || !Parameters->MessageBased.FallBackServiceRoutine)
+                return Status;
+
+            /* The device got a line, tell the caller which kind it has */
+            Status = IopConnectLineBasedInterrupt(Parameters->MessageBased.PhysicalDeviceObject,
+                                                  Parameters->MessageBased.ConnectionContext.InterruptObject,
+                                                  Parameters->MessageBased.FallBackServiceRoutine,
+                                                  Parameters->MessageBased.ServiceContext,
+                                                  Parameters->MessageBased.SpinLock,
+                                                  Parameters->MessageBased.SynchronizeIrql,
+                                                  Parameters->MessageBased.FloatingSave);
+            if (NT_SUCCESS(Status)) Parameters->Version = CONNECT_LINE_BASED;
+            return Status;
+
+        default:
+            return STATUS_INVALID_PARAMETER;
+    }
+}
+
+/*
+ * @implemented
+ */
+VOID
+NTAPI
+IoDisconnectInterruptEx(IN PIO_DISCONNECT_INTERRUPT_PARAMETERS Parameters)
+{
+    PAGED_CODE();
+
+    switch (Parameters->Version)
+    {
+        case CONNECT_FULLY_SPECIFIED:
+        case CONNECT_FULLY_SPECIFIED_GROUP:
+        case CONNECT_LINE_BASED:
+            IoDisconnectInterrupt(Parameters->ConnectionContext.InterruptObject);
+            break;
+
+        case CONNECT_MESSAGE_BASED:
+            IopDisconnectMessageInterrupts(Parameters->ConnectionContext.InterruptMessageTable,
+                                           Parameters->ConnectionContext.InterruptMessageTable->MessageCount);
+            break;
+
+        default:
+            ASSERT(FALSE);
+            break;
+    }
+}
+
 /* EOF */
@@ -295,6 +295,7 @@ IopFreeDeviceNode(
 
     if (DeviceNode->ResourceList)
     {
+        IopReleaseMessageInterrupts(DeviceNode->ResourceList, 0);
         ExFreePool(DeviceNode->ResourceList);
     }
 
@@ -190,10 +190,36 @@ IopFindInterruptResource(
     OUT PCM_PARTIAL_RESOURCE_DESCRIPTOR CmDesc)
 {
     ULONG Vector;
+    KIRQL Irql;
+    KAFFINITY TargetProcessor;
+    NTSTATUS Status;
 
     ASSERT(IoDesc->Type == CmDesc->Type);
     ASSERT(IoDesc->Type == CmResourceTypeInterrupt);
 
+    /* Messages aren't wired to a line, the HAL hands out a vector for each */
+    if (IoDesc->Flags & CM_RESOURCE_INTERRUPT_MESSAGE)
+    {
+        if (!HalAllocateMessageInterrupt)
+            return FALSE;
+
+        Status = HalAllocateMessageInterrupt((KAFFINITY)-1,
+                                             &Vector,
+                                             &Irql,
+                                             &TargetProcessor);
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Failed to allocate a message interrupt (Status 0x%08lx)\n", Status);
+            return FALSE;
+        }
+
+        CmDesc->u.MessageInterrupt.Raw.Reserved = 0;
+        CmDesc->u.MessageInterrupt.Raw.MessageCount = 1;
+        CmDesc->u.MessageInterrupt.Raw.Vector = Vector;
+        CmDesc->u.MessageInterrupt.Raw.Affinity = TargetProcessor;
+        return TRUE;
+    }
+
     for (Vector = IoDesc->u.Interrupt.MinimumVector;
          Vector <= IoDesc->u.Interrupt.MaximumVector;
          Vector++)
@@ -215,6 +241,37 @@ IopFindInterruptResource(
     return FALSE;
 }
 
+/*
+ * Message vectors are owned by the HAL from the moment they are assigned,
+ * so whoever drops a raw list has to give them back. Only the descriptors
+ * from FirstDescriptor on are released.
+ */
+VOID
+NTAPI
+IopReleaseMessageInterrupts(
+    IN PCM_RESOURCE_LIST ResourceList,
+    IN ULONG FirstDescriptor)
+{
+    PCM_PARTIAL_RESOURCE_LIST PartialList;
+    PCM_PARTIAL_RESOURCE_DESCRIPTOR Descriptor;
+    ULONG i;
+
+    if (!ResourceList || !HalFreeMessageInterrupt)
+        return;
+
+    /* The lists we build only ever have one full descriptor */
+    PartialList = &ResourceList->List[0].PartialResourceList;
+    for (i = FirstDescriptor; i < PartialList->Count; i++)
+    {
+        Descriptor = &PartialList->PartialDescriptors[i];
+        if (Descriptor->Type == CmResourceTypeInterrupt &&
+            (Descriptor->Flags & CM_RESOURCE_INTERRUPT_MESSAGE))
+        {
+            HalFreeMessageInterrupt(Descriptor->u.MessageInterrupt.Raw.Vector);
+        }
+    }
+}
+
 NTSTATUS NTAPI
 IopFixupResourceListWithRequirements(
     IN PIO_RESOURCE_REQUIREMENTS_LIST RequirementsList,
@@ -235,6 +292,13 @@ IopFixupResourceListWithRequirements(
     {
         ULONG ii;
 
+        /* Every alternative list starts from scratch */
+        AlternateRequired = FALSE;
+
+        /* Give back the message vectors of the last alternative list */
+        if (*ResourceList != NULL)
+            IopReleaseMessageInterrupts(*ResourceList, OldCount);
+
         /* We need to get back to where we were before processing the last alternative list */
         if (OldCount == 0 && *ResourceList != NULL)
         {
@@ -300,6 +364,10 @@ IopFixupResourceListWithRequirements(
                 switch (IoDesc->Type)
                 {
                     case CmResourceTypeInterrupt:
+                        /* Every message needs its own vector, and lines only match lines */
+                        if ((IoDesc->Flags | CmDesc->Flags) & CM_RESOURCE_INTERRUPT_MESSAGE)
+                            break;
+
                         /* Make sure it satisfies our vector range */
                         if (CmDesc->u.Interrupt.Vector >= IoDesc->u.Interrupt.MinimumVector &&
                             CmDesc->u.Interrupt.Vector <= IoDesc->u.Interrupt.MaximumVector)
@@ -527,8 +595,8 @@ IopFixupResourceListWithRequirements(
             }
         }
 
-        /* Check if we need an alternate with no resources left */
-        if (AlternateRequired)
+        /* Check if we need an alternate with no resources left, or gave up early */
+        if (AlternateRequired || ii < ResList->Count)
         {
             DPRINT1("Unable to satisfy preferred resource or alternates in list %lu\n", i);
 
@@ -546,6 +614,7 @@ IopFixupResourceListWithRequirements(
     /* Free the list */
     if (*ResourceList)
     {
+        IopReleaseMessageInterrupts(*ResourceList, OldCount);
         ExFreePool(*ResourceList);
         *ResourceList = NULL;
     }
@@ -632,6 +701,10 @@ IopCheckResourceDescriptor(
                     break;
 
                 case CmResourceTypeInterrupt:
+                    /* Message vectors come from the HAL and are never shared */
+                    if ((ResDesc->Flags | ResDesc2->Flags) & CM_RESOURCE_INTERRUPT_MESSAGE)
+                        break;
+
                     if (ResDesc->u.Interrupt.Vector == ResDesc2->u.Interrupt.Vector)
                     {
                         if (!Silent)
@@ -1032,6 +1105,27 @@ IopTranslateDeviceResources(
             case CmResourceTypeInterrupt:
             {
                KIRQL Irql;
+               if (DescriptorRaw->Flags & CM_RESOURCE_INTERRUPT_MESSAGE)
+               {
+                   /* The vector was assigned by the HAL already, ask it for the IRQL */
+                   Status = HalGetMessageRoute(DescriptorRaw->u.MessageInterrupt.Raw.Vector,
+                                               DescriptorRaw->u.MessageInterrupt.Raw.Affinity,
+                                               &Irql,
+                                               NULL,
+                                               NULL);
+                   if (!NT_SUCCESS(Status))
+                   {
+                       DPRINT1("Failed to translate message interrupt (Vector: 0x%x)\n",
+                               DescriptorRaw->u.MessageInterrupt.Raw.Vector);
+                       goto cleanup;
+                   }
+
+                   DescriptorTranslated->u.MessageInterrupt.Translated.Level = Irql;
+                   DescriptorTranslated->u.MessageInterrupt.Translated.Vector = DescriptorRaw->u.MessageInterrupt.Raw.Vector;
+                   DescriptorTranslated->u.MessageInterrupt.Translated.Affinity = DescriptorRaw->u.MessageInterrupt.Raw.Affinity;
+                   break;
+               }
+
                DescriptorTranslated->u.Interrupt.Vector = HalGetInterruptVector(
                   DeviceNode->ResourceList->List[i].InterfaceType,
                   DeviceNode->ResourceList->List[i].BusNumber,
@@ -1090,6 +1184,7 @@ IopTranslateDeviceResources(
 cleanup:
    /* Yes! Also delete ResourceList because ResourceList and
     * ResourceListTranslated should be a pair! */
+   IopReleaseMessageInterrupts(DeviceNode->ResourceList, 0);
    ExFreePool(DeviceNode->ResourceList);
    DeviceNode->ResourceList = NULL;
    if (DeviceNode->ResourceListTranslated)
@@ -1199,6 +1294,7 @@ Finish:
 ByeBye:
    if (DeviceNode->ResourceList)
    {
+      IopReleaseMessageInterrupts(DeviceNode->ResourceList, 0);
       ExFreePool(DeviceNode->ResourceList);
       DeviceNode->ResourceList = NULL;
    }
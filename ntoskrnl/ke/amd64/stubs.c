@@ -86,6 +86,19 @@ KeZeroPages(IN PVOID Address,
     RtlZeroMemory(Address, Size);
 }
 
+VOID
+KiZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size)
+{
+    /* Nobody is waiting for these pages, so keep them out of the caches */
+    KiZeroPagesNonTemporal(Address, Size);
+}
+
 PVOID
 NTAPI
 KeSwitchKernelStack(PVOID StackBase, PVOID StackLimit)
@@ -114,6 +127,7 @@ KiIdleLoop(VOID)
 {
     PKPRCB Prcb = KeGetCurrentPrcb();
     PKTHREAD OldThread, NewThread;
+    BOOLEAN Suspended;
 
     /* Now loop forever */
     while (TRUE)
@@ -164,8 +178,18 @@ KiIdleLoop(VOID)
         }
         else
         {
+            /* Stop the clock if nothing is due for a while */
+            Suspended = KiSuspendClockTick(Prcb);
+
             /* Continue staying idle. Note the HAL returns with interrupts on */
             Prcb->PowerState.IdleFunction(&Prcb->PowerState);
+
+            /* Whatever woke us, catch up with the skipped ticks */
+            if (Suspended)
+            {
+                _disable();
+                KiResumeClockTick(Prcb);
+            }
         }
     }
 }
@@ -1138,6 +1138,27 @@ KeZeroPages(IN PVOID Address,
     RtlZeroMemory(Address, Size);
 }
 
+VOID
+FASTCALL
+KiZeroPagesNonTemporal(IN PVOID Address,
+                       IN ULONG Size);
+
+VOID
+FASTCALL
+KeZeroPagesFromIdleThread(IN PVOID Address,
+                          IN ULONG Size)
+{
+    /* Nobody is waiting for these pages, so keep them out of the caches */
+    if (KeFeatureBits & KF_XMMI64)
+    {
+        KiZeroPagesNonTemporal(Address, Size);
+    }
+    else
+    {
+        RtlZeroMemory(Address, Size);
+    }
+}
+
 VOID
 NTAPI
 KiSaveProcessorState(IN PKTRAP_FRAME TrapFrame,
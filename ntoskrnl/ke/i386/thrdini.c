@@ -272,6 +272,7 @@ KiIdleLoop(VOID)
 {
     PKPRCB Prcb = KeGetCurrentPrcb();
     PKTHREAD OldThread, NewThread;
+    BOOLEAN Suspended;
 
     /* Now loop forever */
     while (TRUE)
@@ -316,8 +317,18 @@ KiIdleLoop(VOID)
         }
         else
         {
+            /* Stop the clock if nothing is due for a while */
+            Suspended = KiSuspendClockTick(Prcb);
+
             /* Continue staying idle. Note the HAL returns with interrupts on */
             Prcb->PowerState.IdleFunction(&Prcb->PowerState);
+
+            /* Whatever woke us, catch up with the skipped ticks */
+            if (Suspended)
+            {
+                _disable();
+                KiResumeClockTick(Prcb);
+            }
         }
     }
 }
@@ -18,6 +18,12 @@ LONG KiTickOffset;
 ULONG KeTimeAdjustment;
 BOOLEAN KiTimeAdjustmentEnabled = FALSE;
 
+/* Dynamic tick */
+#define KI_MAXIMUM_TICK_SUSPEND (10 * 1000 * 1000)
+ULONG KiDisableDynamicTick;
+ULONG KiDynamicTickSuspendCount;
+ULONG KiDynamicTickSkippedTicks;
+
 /* FUNCTIONS ******************************************************************/
 
 FORCEINLINE
@@ -135,6 +141,126 @@ KeUpdateSystemTime(IN PKTRAP_FRAME TrapFrame,
     KiEndInterrupt(Irql, TrapFrame);
 }
 
+static
+ULONGLONG
+KiQueryNextTimerDueTime(VOID)
+{
+    ULONGLONG DueTime = ~0ULL;
+    ULONG Hand;
+
+    /* Each list head holds the earliest due time of its list */
+    for (Hand = 0; Hand < TIMER_TABLE_SIZE; Hand++)
+    {
+        if (KiTimerTableListHead[Hand].Time.QuadPart < DueTime)
+            DueTime = KiTimerTableListHead[Hand].Time.QuadPart;
+    }
+
+    return DueTime;
+}
+
+/*
+ * Called by the idle loop with interrupts disabled. If no timer is due for a
+ * few ticks, asks the HAL to stop the periodic clock and to wake us when the
+ * next one expires. Idle processors would otherwise wake on every tick.
+ */
+BOOLEAN
+FASTCALL
+KiSuspendClockTick(IN PKPRCB Prcb)
+{
+    ULONGLONG InterruptTime, DueTime;
+
+    /* Check if the HAL can do it, and if we may */
+    if (KiDisableDynamicTick || !HalSuspendClockTick) return FALSE;
+
+    /* The clock owner must be the only processor, since nothing could wake
+       the others, and the debugger polls for break-in on each tick */
+    if ((KeNumberProcessors != 1) || (Prcb->Number != 0)) return FALSE;
+    if (KdDebuggerEnabled) return FALSE;
+
+    /* Don't bother if expiration is already pending */
+    if (Prcb->TimerRequest) return FALSE;
+
+    /* Check how long we can sleep */
+    InterruptTime = *(ULONGLONG*)&SharedUserData->InterruptTime;
+    DueTime = KiQueryNextTimerDueTime();
+    if (DueTime <= InterruptTime + 2 * KeMaximumIncrement) return FALSE;
+
+    /* Ask the HAL */
+    if (!HalSuspendClockTick(min(DueTime - InterruptTime, KI_MAXIMUM_TICK_SUSPEND)))
+        return FALSE;
+
+    KiDynamicTickSuspendCount++;
+    return TRUE;
+}
+
+/*
+ * Called by the idle loop with interrupts disabled, after any interrupt woke
+ * a processor that suspended the clock. Brings the interrupt time, the tick
+ * count and the system time up to date and charges the skipped ticks to the
+ * idle thread, as KeUpdateSystemTime would have done.
+ */
+VOID
+FASTCALL
+KiResumeClockTick(IN PKPRCB Prcb)
+{
+    ULARGE_INTEGER CurrentTime, InterruptTime;
+    ULONGLONG Elapsed;
+    ULONG Ticks = 0, FirstTick, Hand, i;
+
+    /* Restart the clock and find out how long we slept */
+    Elapsed = HalResumeClockTick();
+
+    /* Update the interrupt time */
+    InterruptTime.QuadPart = *(ULONGLONG*)&SharedUserData->InterruptTime;
+    InterruptTime.QuadPart += Elapsed;
+    KiWriteSystemTime(&SharedUserData->InterruptTime, InterruptTime);
+
+    /* Count the full ticks that passed */
+    while ((LONGLONG)Elapsed >= KiTickOffset)
+    {
+        Elapsed -= KiTickOffset;
+        KiTickOffset = KeMaximumIncrement;
+        Ticks++;
+    }
+    KiTickOffset -= (LONG)Elapsed;
+
+    FirstTick = KeTickCount.LowPart;
+    if (Ticks)
+    {
+        /* Update the system time */
+        CurrentTime.QuadPart = *(ULONGLONG*)&SharedUserData->SystemTime;
+        CurrentTime.QuadPart += (ULONGLONG)Ticks * KeTimeAdjustment;
+        KiWriteSystemTime(&SharedUserData->SystemTime, CurrentTime);
+
+        /* Update the tick count */
+        CurrentTime.QuadPart = (*(ULONGLONG*)&KeTickCount) + Ticks;
+        KiWriteSystemTime(&KeTickCount, CurrentTime);
+        KiWriteSystemTime(&SharedUserData->TickCount, CurrentTime);
+
+        /* We were idle for the whole time */
+        Prcb->KernelTime += Ticks;
+        Prcb->IdleThread->KernelTime += Ticks;
+        KiDynamicTickSkippedTicks += Ticks;
+    }
+
+    /* Check every hand we went past for expired timers */
+    if (!Prcb->TimerRequest)
+    {
+        for (i = 0; i <= min(Ticks, TIMER_TABLE_SIZE - 1); i++)
+        {
+            Hand = (FirstTick + i) & (TIMER_TABLE_SIZE - 1);
+            if (KiTimerTableListHead[Hand].Time.QuadPart <= InterruptTime.QuadPart)
+            {
+                /* Expiration runs from this hand to the current tick */
+                Prcb->TimerRequest = (ULONG_PTR)KeGetCurrentThread();
+                Prcb->TimerHand = Hand;
+                HalRequestSoftwareInterrupt(DISPATCH_LEVEL);
+                break;
+            }
+        }
+    }
+}
+
 VOID
 NTAPI
 KeUpdateRunTime(IN PKTRAP_FRAME TrapFrame,
@@ -53,6 +53,7 @@ NtAcceptConnectPort(OUT PHANDLE PortHandle,
     PLPCP_CONNECTION_MESSAGE ConnectMessage;
     PLPCP_MESSAGE Message;
     PVOID ClientSectionToMap = NULL;
+    PVOID ServerSectionToMap = NULL;
     HANDLE Handle;
     PEPROCESS ClientProcess;
     PETHREAD ClientThread;
@@ -317,9 +318,86 @@ NtAcceptConnectPort(OUT PHANDLE PortHandle,
     /* Check if there's a server section */
     if (ServerView)
     {
-        /* FIXME: TODO */
-        UNREFERENCED_PARAMETER(CapturedServerView);
-        ASSERT(FALSE);
+        /* Get the section handle */
+        Status = ObReferenceObjectByHandle(CapturedServerView.SectionHandle,
+                                           SECTION_MAP_READ |
+                                           SECTION_MAP_WRITE,
+                                           MmSectionObjectType,
+                                           PreviousMode,
+                                           &ServerSectionToMap,
+                                           NULL);
+        if (!NT_SUCCESS(Status))
+        {
+            /* Fail */
+            DPRINT1("Failed to reference server section handle: 0x%lx\n", Status);
+            ServerSectionToMap = NULL;
+            ObDereferenceObject(ServerPort);
+            goto Cleanup;
+        }
+
+        /* Setup the offset */
+        SectionOffset.QuadPart = CapturedServerView.SectionOffset;
+
+        /* Map the section in the server */
+        Status = MmMapViewOfSection(ServerSectionToMap,
+                                    PsGetCurrentProcess(),
+                                    &ServerPort->ServerSectionBase,
+                                    0,
+                                    0,
+                                    &SectionOffset,
+                                    &CapturedServerView.ViewSize,
+                                    ViewUnmap,
+                                    0,
+                                    PAGE_READWRITE);
+        CapturedServerView.SectionOffset = SectionOffset.LowPart;
+        if (NT_SUCCESS(Status))
+        {
+            /* Set the view base */
+            CapturedServerView.ViewBase = ServerPort->ServerSectionBase;
+
+            /* Save and reference the mapping process, unless done above */
+            if (!ServerPort->MappingProcess)
+            {
+                ServerPort->MappingProcess = PsGetCurrentProcess();
+                ObReferenceObject(ServerPort->MappingProcess);
+            }
+
+            /* Map the same pages in the client, so both sides really share
+               them and large data never has to be copied through us */
+            Status = MmMapViewOfSection(ServerSectionToMap,
+                                        ClientProcess,
+                                        &ClientPort->ServerSectionBase,
+                                        0,
+                                        0,
+                                        &SectionOffset,
+                                        &CapturedServerView.ViewSize,
+                                        ViewUnmap,
+                                        0,
+                                        PAGE_READWRITE);
+        }
+
+        if (!NT_SUCCESS(Status))
+        {
+            /* Quit, the server port unmaps its own view when it dies */
+            DPRINT1("Server section mapping failed: %lx\n", Status);
+            ObDereferenceObject(ServerPort);
+            goto Cleanup;
+        }
+
+        /* Set the remote view base */
+        CapturedServerView.ViewRemoteBase = ClientPort->ServerSectionBase;
+
+        /* The client port unmaps the view from the client process */
+        if (!ClientPort->MappingProcess)
+        {
+            ClientPort->MappingProcess = ClientProcess;
+            ObReferenceObject(ClientPort->MappingProcess);
+        }
+
+        /* Describe the view to the client */
+        ConnectMessage->ServerView.Length = sizeof(REMOTE_PORT_VIEW);
+        ConnectMessage->ServerView.ViewBase = CapturedServerView.ViewRemoteBase;
+        ConnectMessage->ServerView.ViewSize = CapturedServerView.ViewSize;
     }
 
     /* Reference the server port until it's fully inserted */
@@ -350,6 +428,16 @@ NtAcceptConnectPort(OUT PHANDLE PortHandle,
             ClientView->ViewSize = ConnectMessage->ClientView.ViewSize;
         }
 
+        /* Check if the caller gave a server view */
+        if (ServerView)
+        {
+            /* Return both mappings */
+            ServerView->SectionOffset = CapturedServerView.SectionOffset;
+            ServerView->ViewSize = CapturedServerView.ViewSize;
+            ServerView->ViewBase = CapturedServerView.ViewBase;
+            ServerView->ViewRemoteBase = CapturedServerView.ViewRemoteBase;
+        }
+
         /* Return the handle to user mode */
         *PortHandle = Handle;
     }
@@ -388,8 +476,9 @@ NtAcceptConnectPort(OUT PHANDLE PortHandle,
     ObDereferenceObject(ServerPort);
 
 Cleanup:
-    /* If there was a section, dereference it */
+    /* If there were sections, dereference them */
     if (ClientSectionToMap) ObDereferenceObject(ClientSectionToMap);
+    if (ServerSectionToMap) ObDereferenceObject(ServerSectionToMap);
 
     /* Check if we got here while still having a client thread */
     if (ClientThread)
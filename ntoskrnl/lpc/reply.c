@@ -369,7 +369,7 @@ NtReplyWaitReceivePortEx(IN HANDLE PortHandle,
     LARGE_INTEGER CapturedTimeout;
     PLPCP_PORT_OBJECT Port, ReceivePort, ConnectionPort = NULL;
     PLPCP_MESSAGE Message;
-    PETHREAD Thread = PsGetCurrentThread(), WakeupThread;
+    PETHREAD Thread = PsGetCurrentThread(), WakeupThread = NULL;
     PLPCP_CONNECTION_MESSAGE ConnectMessage;
     ULONG ConnectionInfoLength;
 
@@ -586,16 +586,16 @@ NtReplyWaitReceivePortEx(IN HANDLE PortHandle,
                                 CapturedReplyMessage.CallbackId,
                                 CapturedReplyMessage.ClientId);
 
-        /* Release the lock and release the LPC semaphore to wake up waiters */
+        /* Release the lock and wake up the client */
         KeReleaseGuardedMutex(&LpcpLock);
         LpcpCompleteWait(&WakeupThread->LpcReplySemaphore);
-
-        /* Now we can let go of the thread */
-        ObDereferenceObject(WakeupThread);
     }
 
     /* Now wait for someone to reply to us */
     LpcpReceiveWait(ReceivePort->MsgQueue.Semaphore, WaitMode);
+
+    /* Now we can let go of the thread we replied to */
+    if (WakeupThread) ObDereferenceObject(WakeupThread);
     if (Status != STATUS_SUCCESS) goto Cleanup;
 
     /* Wait done, get the LPC lock */
@@ -754,15 +754,278 @@ NtReplyWaitReceivePort(IN HANDLE PortHandle,
 }
 
 /*
- * @unimplemented
+ * @implemented
  */
 NTSTATUS
 NTAPI
 NtReplyWaitReplyPort(IN HANDLE PortHandle,
-                     IN PPORT_MESSAGE ReplyMessage)
+                     IN OUT PPORT_MESSAGE ReplyMessage)
 {
-    UNIMPLEMENTED;
-    return STATUS_NOT_IMPLEMENTED;
+    NTSTATUS Status;
+    KPROCESSOR_MODE PreviousMode = KeGetPreviousMode();
+    PORT_MESSAGE CapturedReplyMessage;
+    PLPCP_PORT_OBJECT Port, ReplyPort;
+    PLPCP_MESSAGE Message;
+    PETHREAD Thread = PsGetCurrentThread(), WakeupThread;
+
+    PAGED_CODE();
+    LPCTRACE(LPC_REPLY_DEBUG,
+             "Handle: %p. Message: %p.\n",
+             PortHandle,
+             ReplyMessage);
+
+    /* Check if the call comes from user mode */
+    if (PreviousMode != KernelMode)
+    {
+        _SEH2_TRY
+        {
+            /* The answer is written back into the same buffer */
+            ProbeForWrite(ReplyMessage, sizeof(*ReplyMessage), sizeof(ULONG));
+            CapturedReplyMessage = *(volatile PORT_MESSAGE*)ReplyMessage;
+        }
+        _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+        {
+            _SEH2_YIELD(return _SEH2_GetExceptionCode());
+        }
+        _SEH2_END;
+    }
+    else
+    {
+        CapturedReplyMessage = *ReplyMessage;
+    }
+
+    /* Validate its length */
+    if (((ULONG)CapturedReplyMessage.u1.s1.DataLength + sizeof(PORT_MESSAGE)) >
+         (ULONG)CapturedReplyMessage.u1.s1.TotalLength)
+    {
+        /* Fail */
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    /* Make sure it has a valid ID */
+    if (!CapturedReplyMessage.MessageId) return STATUS_INVALID_PARAMETER;
+
+    /* Get the Port object */
+    Status = ObReferenceObjectByHandle(PortHandle,
+                                       0,
+                                       LpcPortObjectType,
+                                       PreviousMode,
+                                       (PVOID*)&Port,
+                                       NULL);
+    if (!NT_SUCCESS(Status)) return Status;
+
+    /* Validate its length in respect to the port object */
+    if (((ULONG)CapturedReplyMessage.u1.s1.TotalLength > Port->MaxMessageLength) ||
+        ((ULONG)CapturedReplyMessage.u1.s1.TotalLength <=
+         (ULONG)CapturedReplyMessage.u1.s1.DataLength))
+    {
+        /* Too large, fail */
+        ObDereferenceObject(Port);
+        return STATUS_PORT_MESSAGE_TOO_LONG;
+    }
+
+    /* Get the ETHREAD corresponding to it */
+    Status = PsLookupProcessThreadByCid(&CapturedReplyMessage.ClientId,
+                                        NULL,
+                                        &WakeupThread);
+    if (!NT_SUCCESS(Status))
+    {
+        /* No thread found, fail */
+        ObDereferenceObject(Port);
+        return Status;
+    }
+
+    /* Allocate a message from the port zone */
+    Message = LpcpAllocateFromPortZone();
+    if (!Message)
+    {
+        /* Fail if we couldn't allocate a message */
+        ObDereferenceObject(WakeupThread);
+        ObDereferenceObject(Port);
+        return STATUS_NO_MEMORY;
+    }
+
+    /* Keep the lock acquired */
+    KeAcquireGuardedMutex(&LpcpLock);
+
+    /* Our own wait is run down through the other end, like for requests */
+    if ((Port->Flags & LPCP_PORT_TYPE_MASK) != LPCP_CONNECTION_PORT)
+    {
+        ReplyPort = Port->ConnectedPort;
+        if (!ReplyPort)
+        {
+            /* We have no connected port, fail */
+            LpcpFreeToPortZone(Message, LPCP_LOCK_HELD | LPCP_LOCK_RELEASE);
+            ObDereferenceObject(WakeupThread);
+            ObDereferenceObject(Port);
+            return STATUS_PORT_DISCONNECTED;
+        }
+    }
+    else
+    {
+        ReplyPort = Port;
+    }
+
+    /* Make sure this is the reply the thread is waiting for */
+    if ((WakeupThread->LpcReplyMessageId != CapturedReplyMessage.MessageId) ||
+        ((LpcpGetMessageFromThread(WakeupThread)) &&
+        (LpcpGetMessageType(&LpcpGetMessageFromThread(WakeupThread)-> Request)
+            != LPC_REQUEST)))
+    {
+        /* It isn't, fail */
+        LpcpFreeToPortZone(Message, LPCP_LOCK_HELD | LPCP_LOCK_RELEASE);
+        ObDereferenceObject(WakeupThread);
+        ObDereferenceObject(Port);
+        return STATUS_REPLY_MESSAGE_MISMATCH;
+    }
+
+    /* Copy the message */
+    _SEH2_TRY
+    {
+        LpcpMoveMessage(&Message->Request,
+                        &CapturedReplyMessage,
+                        ReplyMessage + 1,
+                        LPC_REPLY,
+                        NULL);
+    }
+    _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+    {
+        /* Cleanup and return the exception code */
+        LpcpFreeToPortZone(Message, LPCP_LOCK_HELD | LPCP_LOCK_RELEASE);
+        ObDereferenceObject(WakeupThread);
+        ObDereferenceObject(Port);
+        _SEH2_YIELD(return _SEH2_GetExceptionCode());
+    }
+    _SEH2_END;
+
+    /* Reference the thread while we use it */
+    ObReferenceObject(WakeupThread);
+    Message->RepliedToThread = WakeupThread;
+
+    /* Set this as the reply message */
+    WakeupThread->LpcReplyMessageId = 0;
+    WakeupThread->LpcReplyMessage = (PVOID)Message;
+
+    /* Check if we have messages on the reply chain */
+    if (!(WakeupThread->LpcExitThreadCalled) &&
+        !(IsListEmpty(&WakeupThread->LpcReplyChain)))
+    {
+        /* Remove us from it and reinitialize it */
+        RemoveEntryList(&WakeupThread->LpcReplyChain);
+        InitializeListHead(&WakeupThread->LpcReplyChain);
+    }
+
+    /* Check if this is the message the thread had received */
+    if ((Thread->LpcReceivedMsgIdValid) &&
+        (Thread->LpcReceivedMessageId == CapturedReplyMessage.MessageId))
+    {
+        /* Clear this data */
+        Thread->LpcReceivedMessageId = 0;
+        Thread->LpcReceivedMsgIdValid = FALSE;
+    }
+
+    /* Free any data information */
+    LpcpFreeDataInfoMessage(Port,
+                            CapturedReplyMessage.MessageId,
+                            CapturedReplyMessage.CallbackId,
+                            CapturedReplyMessage.ClientId);
+
+    /* Now wait for a reply to the very same message ourselves. Set this up
+       before dropping the lock, so that an immediate answer can't be lost */
+    Thread->LpcReplyMessageId = CapturedReplyMessage.MessageId;
+    Thread->LpcReplyMessage = NULL;
+    InsertTailList(&ReplyPort->LpcReplyChainHead, &Thread->LpcReplyChain);
+    LpcpSetPortToThread(Thread, Port);
+
+    /* Release the lock and wake up the other side */
+    KeEnterCriticalRegion();
+    KeReleaseGuardedMutex(&LpcpLock);
+    LpcpCompleteWait(&WakeupThread->LpcReplySemaphore);
+    KeLeaveCriticalRegion();
+
+    /* And let's wait for the reply */
+    LpcpReplyWait(&Thread->LpcReplySemaphore, PreviousMode);
+
+    /* Now we can let go of the thread */
+    ObDereferenceObject(WakeupThread);
+
+    /* Acquire the LPC lock */
+    KeAcquireGuardedMutex(&LpcpLock);
+
+    /* Get the LPC Message and clear our thread's reply data */
+    Message = LpcpGetMessageFromThread(Thread);
+    Thread->LpcReplyMessage = NULL;
+    Thread->LpcReplyMessageId = 0;
+
+    /* Check if we have anything on the reply chain*/
+    if (!IsListEmpty(&Thread->LpcReplyChain))
+    {
+        /* Remove this thread and reinitialize the list */
+        RemoveEntryList(&Thread->LpcReplyChain);
+        InitializeListHead(&Thread->LpcReplyChain);
+    }
+
+    /* Release the lock */
+    KeReleaseGuardedMutex(&LpcpLock);
+
+    /* Check if we got a reply */
+    if (Status == STATUS_SUCCESS)
+    {
+        /* Check if we have a valid message */
+        if (Message)
+        {
+            LPCTRACE(LPC_REPLY_DEBUG,
+                     "Reply Messages: %p/%p\n",
+                     &Message->Request,
+                     (&Message->Request) + 1);
+
+            /* Move the message */
+            _SEH2_TRY
+            {
+                LpcpMoveMessage(ReplyMessage,
+                                &Message->Request,
+                                (&Message->Request) + 1,
+                                0,
+                                NULL);
+            }
+            _SEH2_EXCEPT(EXCEPTION_EXECUTE_HANDLER)
+            {
+                Status = _SEH2_GetExceptionCode();
+            }
+            _SEH2_END;
+
+            /* Check if this is an LPC request with data information */
+            if ((LpcpGetMessageType(&Message->Request) == LPC_REQUEST) &&
+                (Message->Request.u2.s2.DataInfoOffset))
+            {
+                /* Save the data information */
+                LpcpSaveDataInfoMessage(Port, Message, 0);
+            }
+            else
+            {
+                /* Otherwise, just free it */
+                LpcpFreeToPortZone(Message, 0);
+            }
+        }
+        else
+        {
+            /* We don't have a reply */
+            Status = STATUS_LPC_REPLY_LOST;
+        }
+    }
+    else
+    {
+        /* The wait failed, free the message */
+        if (Message) LpcpFreeToPortZone(Message, 0);
+    }
+
+    /* All done */
+    LPCTRACE(LPC_REPLY_DEBUG,
+             "Port: %p. Status: %d\n",
+             Port,
+             Status);
+    ObDereferenceObject(Port);
+    return Status;
 }
 
 NTSTATUS
@@ -82,6 +82,15 @@ MiFindContiguousPages(IN PFN_NUMBER LowestPfn,
                 continue;
             }
 
+            //
+            // Frames under a large page mapping can only be mapped cached
+            //
+            if ((CacheType != MmCached) && (MiMustFrameBeCached(Page)))
+            {
+                Length = 0;
+                continue;
+            }
+
             //
             // If we haven't chosen a start PFN yet and the caller specified an
             // alignment, make sure the page matches the alignment restriction
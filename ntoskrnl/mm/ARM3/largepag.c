@@ -26,8 +26,371 @@ ULONG MmLargePageDriverBufferLength = -1;
 LIST_ENTRY MiLargePageDriverList;
 BOOLEAN MiLargePageAllDrivers;
 
+/* Like NT, only map the kernel with large pages when there is enough memory
+   to afford giving up write protection of its code */
+#define MI_LARGE_PAGE_KERNEL_MINIMUM ((256 * _1MB) >> PAGE_SHIFT)
+
+/* PRIVATE FUNCTIONS **********************************************************/
+
+static
+VOID
+MiFreeLargePageFrames(IN PFN_NUMBER PageFrameIndex)
+{
+    PMMPFN Pfn1;
+    ULONG i;
+
+    /* PFN lock must be held */
+    MI_ASSERT_PFN_LOCK_HELD();
+
+    /* Drop the only reference on every small page of the large page */
+    Pfn1 = MiGetPfnEntry(PageFrameIndex);
+    for (i = 0; i < PTE_PER_PAGE; i++, Pfn1++, PageFrameIndex++)
+    {
+        ASSERT(Pfn1->u2.ShareCount == 1);
+        ASSERT(Pfn1->u3.e1.PageLocation == ActiveAndValid);
+        Pfn1->u3.e1.StartOfAllocation = 0;
+        Pfn1->u3.e1.EndOfAllocation = 0;
+        MI_SET_PFN_DELETED(Pfn1);
+        MiDecrementShareCount(Pfn1, PageFrameIndex);
+    }
+}
+
+#if (_MI_PAGING_LEVELS == 2)
+INIT_FUNCTION
+static
+BOOLEAN
+MiIsBootImageAddress(IN PVOID Address)
+{
+    PLIST_ENTRY NextEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+
+    /* Loop the boot loaded images */
+    for (NextEntry = PsLoadedModuleList.Flink;
+         NextEntry != &PsLoadedModuleList;
+         NextEntry = NextEntry->Flink)
+    {
+        LdrEntry = CONTAINING_RECORD(NextEntry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+        if (((ULONG_PTR)Address >= (ULONG_PTR)LdrEntry->DllBase) &&
+            ((ULONG_PTR)Address < (ULONG_PTR)LdrEntry->DllBase + LdrEntry->SizeOfImage))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+INIT_FUNCTION
+static
+VOID
+MiWriteSystemPdeInAllProcesses(IN PMMPDE PointerPde,
+                               IN MMPDE TempPde)
+{
+    PLIST_ENTRY NextEntry;
+    PEPROCESS Process, CurrentProcess = PsGetCurrentProcess();
+    PMMPDE PageDirectory;
+    KIRQL OldIrql, HyperIrql;
+
+    /* Every process has its own copy of the system PDEs */
+    OldIrql = MiAcquireExpansionLock();
+    for (NextEntry = MmProcessList.Flink;
+         NextEntry != &MmProcessList;
+         NextEntry = NextEntry->Flink)
+    {
+        Process = CONTAINING_RECORD(NextEntry, EPROCESS, MmProcessLinks);
+        if (Process == CurrentProcess) continue;
+
+        /* Map its page directory and update the entry */
+        PageDirectory = MiMapPageInHyperSpace(CurrentProcess,
+                                              Process->Pcb.DirectoryTableBase[0] >> PAGE_SHIFT,
+                                              &HyperIrql);
+        PageDirectory[MiGetPdeOffset(MiPdeToAddress(PointerPde))] = TempPde;
+        MiUnmapPageInHyperSpace(CurrentProcess, PageDirectory, HyperIrql);
+    }
+
+    /* And finally our own */
+    *PointerPde = TempPde;
+    MiReleaseExpansionLock(OldIrql);
+}
+
+INIT_FUNCTION
+static
+VOID
+MiMapImageWithLargePages(IN PVOID ImageBase,
+                         IN ULONG ImageSize)
+{
+    PMMPDE PointerPde, LastPde;
+    PMMPTE PointerPte;
+    MMPDE TempPde;
+    PFN_NUMBER PageFrameIndex;
+    PUCHAR BaseVa;
+    ULONG i;
+
+    /* Loop every PDE covering the image */
+    PointerPde = MiAddressToPde(ImageBase);
+    LastPde = MiAddressToPde((PVOID)((ULONG_PTR)ImageBase + ImageSize - 1));
+    for (; PointerPde <= LastPde; PointerPde++)
+    {
+        /* Skip what is already done, or has no page table at all */
+        if (!(PointerPde->u.Hard.Valid) || (MI_IS_PAGE_LARGE(PointerPde))) continue;
+
+        /* The page table must map one aligned, physically contiguous run */
+        PointerPte = MiPdeToPte(PointerPde);
+        PageFrameIndex = PFN_FROM_PTE(PointerPte);
+        if (PageFrameIndex & (PTE_PER_PAGE - 1)) continue;
+        BaseVa = MiPdeToAddress(PointerPde);
+        for (i = 0; i < PTE_PER_PAGE; i++)
+        {
+            /* Holes would let the large page alias memory owned by others.
+               So would pages of the loader, which get freed later on */
+            if (!(PointerPte[i].u.Hard.Valid) ||
+                (PFN_FROM_PTE(&PointerPte[i]) != PageFrameIndex + i) ||
+                !(MiGetPfnEntry(PageFrameIndex + i)) ||
+                !(MiIsBootImageAddress(BaseVa + i * PAGE_SIZE)))
+            {
+                break;
+            }
+        }
+        if (i != PTE_PER_PAGE) continue;
+
+        /* Make sure there is room to remember the range */
+        if (MiLargePageRangeIndex == RTL_NUMBER_OF(MiLargePageRanges)) return;
+        MiLargePageRanges[MiLargePageRangeIndex].StartFrame = PageFrameIndex;
+        MiLargePageRanges[MiLargePageRangeIndex].LastFrame = PageFrameIndex + PTE_PER_PAGE - 1;
+        MiLargePageRangeIndex++;
+
+        /* Switch to a writable large page. The page table stays allocated */
+        TempPde = ValidKernelPde;
+        TempPde.u.Hard.PageFrameNumber = PageFrameIndex;
+        TempPde.u.Hard.LargePage = 1;
+        MiWriteSystemPdeInAllProcesses(PointerPde, TempPde);
+
+        DPRINT("Mapped %p with a large page at frame %lx\n",
+               MiPdeToAddress(PointerPde), PageFrameIndex);
+    }
+}
+#endif
+
 /* FUNCTIONS ******************************************************************/
 
+BOOLEAN
+NTAPI
+MiMustFrameBeCached(IN PFN_NUMBER PageFrameIndex)
+{
+    ULONG i;
+
+    /* Frames under a cached large page mapping can never be mapped otherwise */
+    for (i = 0; i < MiLargePageRangeIndex; i++)
+    {
+        if ((PageFrameIndex >= MiLargePageRanges[i].StartFrame) &&
+            (PageFrameIndex <= MiLargePageRanges[i].LastFrame))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+NTSTATUS
+NTAPI
+MiInsertLargePageVad(IN PMMVAD Vad,
+                     IN OUT PULONG_PTR BaseAddress,
+                     IN SIZE_T ViewSize,
+                     IN ULONG_PTR HighestAddress,
+                     IN ULONG AllocationType)
+{
+    PEPROCESS CurrentProcess = PsGetCurrentProcess();
+    PETHREAD CurrentThread = PsGetCurrentThread();
+    PPFN_NUMBER LargePages;
+    PFN_NUMBER PageCount, i, j;
+    PMMPDE PointerPde;
+    MMPDE TempPde;
+    PMMPFN Pfn1;
+    KIRQL OldIrql;
+    NTSTATUS Status;
+    PAGED_CODE();
+    ASSERT((ViewSize & (PDE_MAPPED_VA - 1)) == 0);
+
+    /* The processors must have been set up for large pages */
+    if (!SharedUserData->LargePageMinimum)
+    {
+        DPRINT1("Large pages are not enabled\n");
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    /* A large page is always valid, so it needs a real page protection */
+    if (((Vad->u.VadFlags.Protection & MM_PROTECT_ACCESS) == MM_ZERO_ACCESS) ||
+        (Vad->u.VadFlags.Protection & ~MM_PROTECT_ACCESS))
+    {
+        DPRINT1("Invalid protection for large pages\n");
+        return STATUS_INVALID_PAGE_PROTECTION;
+    }
+
+    PageCount = ViewSize / PDE_MAPPED_VA;
+    if (!PageCount) return STATUS_INVALID_PARAMETER;
+
+    LargePages = ExAllocatePoolWithTag(PagedPool,
+                                       PageCount * sizeof(PFN_NUMBER),
+                                       TAG_MM);
+    if (!LargePages) return STATUS_INSUFFICIENT_RESOURCES;
+
+    /* Every large page needs an aligned, physically contiguous run */
+    for (i = 0; i < PageCount; i++)
+    {
+        LargePages[i] = MiFindContiguousPages(0,
+                                              MmHighestPhysicalPage,
+                                              PTE_PER_PAGE,
+                                              PTE_PER_PAGE,
+                                              MmCached);
+        if (!LargePages[i])
+        {
+            DPRINT1("No contiguous memory left for large page %lu\n", i);
+            Status = STATUS_INSUFFICIENT_RESOURCES;
+            goto FreePages;
+        }
+
+        /* These come straight from the free lists, so clean them */
+        for (j = 0; j < PTE_PER_PAGE; j++) MiZeroPhysicalPage(LargePages[i] + j);
+    }
+
+    /* Large pages are mapped by PDEs, so the VAD must be aligned like one */
+    Vad->u.VadFlags.VadType = VadLargePages;
+    Status = MiInsertVadEx(Vad,
+                           BaseAddress,
+                           ViewSize,
+                           HighestAddress,
+                           PDE_MAPPED_VA,
+                           AllocationType);
+    if (!NT_SUCCESS(Status)) goto FreePages;
+
+    /* Build the large PDE template */
+    PointerPde = MiAddressToPde(*BaseAddress);
+    MI_MAKE_HARDWARE_PTE_USER(&TempPde,
+                              MiAddressToPte(*BaseAddress),
+                              Vad->u.VadFlags.Protection,
+                              0);
+    TempPde.u.Hard.LargePage = 1;
+    MI_MAKE_ACCESSED_PAGE(&TempPde);
+    if (MI_IS_PAGE_WRITEABLE(&TempPde)) MI_MAKE_DIRTY_PAGE(&TempPde);
+
+    /* Map all the large pages. Faults on the VAD do not build page tables */
+    MiLockProcessWorkingSetUnsafe(CurrentProcess, CurrentThread);
+    for (i = 0; i < PageCount; i++, PointerPde++)
+    {
+#if (_MI_PAGING_LEVELS >= 3)
+        /* Make sure the page directory itself exists */
+        MiMakeSystemAddressValid(PointerPde, CurrentProcess);
+#endif
+        OldIrql = MiAcquirePfnLock();
+
+        /* An empty page table may remain from an earlier allocation */
+        if (PointerPde->u.Hard.Valid)
+        {
+            ASSERT(MI_IS_PAGE_LARGE(PointerPde) == FALSE);
+            ASSERT(MiQueryPageTableReferences(MiPdeToAddress(PointerPde)) == 0);
+            MiDeletePte(PointerPde, MiPdeToPte(PointerPde), CurrentProcess, NULL);
+        }
+
+        /* The PFN entries describe the PDE that maps them */
+        Pfn1 = MiGetPfnEntry(LargePages[i]);
+        for (j = 0; j < PTE_PER_PAGE; j++, Pfn1++)
+        {
+            Pfn1->PteAddress = PointerPde;
+            Pfn1->u3.e1.CacheAttribute = MiCached;
+        }
+
+        TempPde.u.Hard.PageFrameNumber = LargePages[i];
+        MI_WRITE_VALID_PDE(PointerPde, TempPde);
+        MiReleasePfnLock(OldIrql);
+    }
+    MiUnlockProcessWorkingSetUnsafe(CurrentProcess, CurrentThread);
+
+    ExFreePoolWithTag(LargePages, TAG_MM);
+    return STATUS_SUCCESS;
+
+FreePages:
+    OldIrql = MiAcquirePfnLock();
+    for (j = 0; j < i; j++) MiFreeLargePageFrames(LargePages[j]);
+    MiReleasePfnLock(OldIrql);
+    ExFreePoolWithTag(LargePages, TAG_MM);
+    return Status;
+}
+
+VOID
+NTAPI
+MiDeleteLargePageRange(IN ULONG_PTR StartingAddress,
+                       IN ULONG_PTR EndingAddress)
+{
+    PMMPDE PointerPde, LastPde;
+    PFN_NUMBER PageFrameIndex;
+    KIRQL OldIrql;
+
+    /* The working set lock must be held */
+    ASSERT(KeAreAllApcsDisabled() == TRUE);
+    ASSERT((StartingAddress & (PDE_MAPPED_VA - 1)) == 0);
+
+    PointerPde = MiAddressToPde(StartingAddress);
+    LastPde = MiAddressToPde(EndingAddress);
+
+    OldIrql = MiAcquirePfnLock();
+    for (; PointerPde <= LastPde; PointerPde++)
+    {
+        ASSERT(PointerPde->u.Hard.Valid == 1);
+        ASSERT(MI_IS_PAGE_LARGE(PointerPde));
+
+        /* Unmap the large page before its frames can go anywhere */
+        PageFrameIndex = PFN_FROM_PTE(PointerPde);
+        MI_ERASE_PTE(PointerPde);
+        KeInvalidateTlbEntry(MiPdeToAddress(PointerPde));
+
+        /* Locked pages stay around until they are unlocked */
+        MiFreeLargePageFrames(PageFrameIndex);
+    }
+    MiReleasePfnLock(OldIrql);
+}
+
+INIT_FUNCTION
+VOID
+NTAPI
+MiMapBootImagesWithLargePages(VOID)
+{
+#if (_MI_PAGING_LEVELS == 2)
+    PLIST_ENTRY NextEntry;
+    PLDR_DATA_TABLE_ENTRY LdrEntry;
+    ULONG i;
+#endif
+
+    /* The processors only have large pages enabled from phase 1 on */
+#if defined(_M_IX86)
+    if (!(KeFeatureBits & KF_LARGE_PAGE) || !(__readcr4() & CR4_PSE)) return;
+#elif !defined(_M_AMD64)
+    return;
+#endif
+
+    /* User mode can have large pages now */
+    SharedUserData->LargePageMinimum = PDE_MAPPED_VA;
+
+#if (_MI_PAGING_LEVELS == 2)
+    if (MmNumberOfPhysicalPages < MI_LARGE_PAGE_KERNEL_MINIMUM) return;
+
+    /* The kernel and the HAL are the first two boot images */
+    NextEntry = PsLoadedModuleList.Flink;
+    for (i = 0; (i < 2) && (NextEntry != &PsLoadedModuleList); i++)
+    {
+        LdrEntry = CONTAINING_RECORD(NextEntry, LDR_DATA_TABLE_ENTRY, InLoadOrderLinks);
+        MiMapImageWithLargePages(LdrEntry->DllBase, LdrEntry->SizeOfImage);
+        NextEntry = NextEntry->Flink;
+    }
+
+    /* Flush the small page translations, including global ones */
+    KeFlushEntireTb(TRUE, TRUE);
+
+    /* Keep the PFN database consistent with the new mappings */
+    MiSyncCachedRanges();
+#endif
+}
+
 INIT_FUNCTION
 VOID
 NTAPI
@@ -54,12 +417,24 @@ NTAPI
 MiSyncCachedRanges(VOID)
 {
     ULONG i;
+    PFN_NUMBER PageFrameIndex;
+    PMMPFN Pfn1;
+    KIRQL OldIrql;
 
     /* Scan every range */
+    OldIrql = MiAcquirePfnLock();
     for (i = 0; i < MiLargePageRangeIndex; i++)
     {
-        UNIMPLEMENTED_DBGBREAK("No support for large pages\n");
+        /* The large page maps these frames cached, and so must everyone else */
+        for (PageFrameIndex = MiLargePageRanges[i].StartFrame;
+             PageFrameIndex <= MiLargePageRanges[i].LastFrame;
+             PageFrameIndex++)
+        {
+            Pfn1 = MiGetPfnEntry(PageFrameIndex);
+            if (Pfn1) Pfn1->u3.e1.CacheAttribute = MiCached;
+        }
     }
+    MiReleasePfnLock(OldIrql);
 }
 
 INIT_FUNCTION
@@ -1015,9 +1015,6 @@ MmProbeAndLockPages(IN PMDL Mdl,
     TotalPages = LockPages;
     StartAddress = Address;
 
-    /* Large pages not supported */
-    ASSERT(!MI_IS_PHYSICAL_ADDRESS(Address));
-
     //
     // Now probe them
     //
@@ -1192,6 +1189,61 @@ MmProbeAndLockPages(IN PMDL Mdl,
         // Assume failure and check for non-mapped pages
         //
         *MdlPages = LIST_HEAD;
+
+        //
+        // Large pages are always resident, and have no PTEs
+        //
+        if (
+#if (_MI_PAGING_LEVELS == 4)
+            (PointerPxe->u.Hard.Valid == 1) &&
+#endif
+#if (_MI_PAGING_LEVELS >= 3)
+            (PointerPpe->u.Hard.Valid == 1) &&
+#endif
+            (PointerPde->u.Hard.Valid == 1) &&
+            (MI_IS_PAGE_LARGE(PointerPde)))
+        {
+            //
+            // Fail writes to read-only large pages, they cannot be copy on write
+            //
+            if ((Operation != IoReadAccess) && !(MI_IS_PAGE_WRITEABLE(PointerPde)))
+            {
+                Status = STATUS_ACCESS_VIOLATION;
+                goto CleanupWithLock;
+            }
+
+            //
+            // The small page is at the same offset in the large one
+            //
+            PageFrameIndex = PFN_FROM_PTE(PointerPde) +
+                             MiAddressToPteOffset(MiPteToAddress(PointerPte));
+            Pfn1 = MiGetPfnEntry(PageFrameIndex);
+            if (Pfn1)
+            {
+                MiReferenceProbedPageAndBumpLockCount(Pfn1);
+            }
+            else
+            {
+                Mdl->MdlFlags |= MDL_IO_SPACE;
+            }
+
+            //
+            // Write the page and move on
+            //
+            *MdlPages++ = PageFrameIndex;
+            PointerPte++;
+
+            /* Check if we're on a PDE boundary */
+            if (MiIsPteOnPdeBoundary(PointerPte)) PointerPde++;
+#if (_MI_PAGING_LEVELS >= 3)
+            if (MiIsPteOnPpeBoundary(PointerPte)) PointerPpe++;
+#endif
+#if (_MI_PAGING_LEVELS == 4)
+            if (MiIsPteOnPxeBoundary(PointerPte)) PointerPxe++;
+#endif
+            continue;
+        }
+
         while (
 #if (_MI_PAGING_LEVELS == 4)
                (PointerPxe->u.Hard.Valid == 0) ||
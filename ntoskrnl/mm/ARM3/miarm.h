@@ -640,6 +640,9 @@ extern PFN_NUMBER MmSystemPageDirectory[PPE_PER_PAGE];
 extern PMMPTE MmSharedUserDataPte;
 extern LIST_ENTRY MmProcessList;
 extern KEVENT MmZeroingPageEvent;
+extern PFN_NUMBER MiZeroedPagesPerColor;
+extern volatile LONG MiZeroedInBackgroundCount;
+extern volatile LONG MiZeroOnFaultCount;
 extern ULONG MmSystemPageColor;
 extern ULONG MmProcessColorSeed;
 extern PMMWSL MmWorkingSetList;
@@ -2044,6 +2047,36 @@ MiSyncCachedRanges(
     VOID
 );
 
+INIT_FUNCTION
+VOID
+NTAPI
+MiMapBootImagesWithLargePages(
+    VOID
+);
+
+BOOLEAN
+NTAPI
+MiMustFrameBeCached(
+    IN PFN_NUMBER PageFrameIndex
+);
+
+NTSTATUS
+NTAPI
+MiInsertLargePageVad(
+    IN PMMVAD Vad,
+    IN OUT PULONG_PTR BaseAddress,
+    IN SIZE_T ViewSize,
+    IN ULONG_PTR HighestAddress,
+    IN ULONG AllocationType
+);
+
+VOID
+NTAPI
+MiDeleteLargePageRange(
+    IN ULONG_PTR StartingAddress,
+    IN ULONG_PTR EndingAddress
+);
+
 BOOLEAN
 NTAPI
 MiIsPfnInUse(
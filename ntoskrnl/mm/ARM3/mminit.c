@@ -1162,8 +1162,12 @@ MmFreeLoaderBlock(IN PLOADER_PARAMETER_BLOCK LoaderBlock)
         Pfn1 = MiGetPfnEntry(BasePage);
         while (i--)
         {
-            /* Check if it has references or is in any kind of list */
-            if (!(Pfn1->u3.e2.ReferenceCount) && (!Pfn1->u1.Flink))
+            /* Frames under a large page mapping stay mapped, so keep them */
+            if (MiMustFrameBeCached(BasePage))
+            {
+                DPRINT1("Keeping loader page %lx, it is under a large page\n", BasePage);
+            }
+            else if (!(Pfn1->u3.e2.ReferenceCount) && (!Pfn1->u1.Flink))
             {
                 /* Set the new PTE address and put this page into the free list */
                 Pfn1->PteAddress = (PMMPTE)(BasePage << PAGE_SHIFT);
@@ -1575,6 +1579,13 @@ MmDumpArmPfnDatabase(IN BOOLEAN StatusOnly)
     DbgPrint("Free:                 %5d pages\t[%6d KB]\n", FreePages,    (FreePages      << PAGE_SHIFT) / 1024);
     DbgPrint("Other:                %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
     DbgPrint("-----------------------------------------\n");
+    OtherPages = (ULONG)MmZeroedPageListHead.Total;
+    DbgPrint("Zeroed List:          %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
+    OtherPages = MiZeroedInBackgroundCount;
+    DbgPrint("Zeroed When Idle:     %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
+    OtherPages = MiZeroOnFaultCount;
+    DbgPrint("Zeroed On Fault:      %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
+    DbgPrint("-----------------------------------------\n");
 #if MI_TRACE_PFNS
     OtherPages = UsageBucket[MI_USAGE_BOOT_DRIVER];
     DbgPrint("Boot Images:          %5d pages\t[%6d KB]\n", OtherPages,   (OtherPages     << PAGE_SHIFT) / 1024);
@@ -274,7 +274,12 @@ MiCheckVirtualAddress(IN PVOID VirtualAddress,
             ASSERT(Vad->u.VadFlags.VadType != VadAwe);
 
             /* This must be a TEB/PEB VAD */
-            if (Vad->u.VadFlags.MemCommit)
+            if (Vad->u.VadFlags.VadType == VadLargePages)
+            {
+                /* Large pages are mapped by their PDEs, never through page tables */
+                *ProtectCode = MM_NOACCESS;
+            }
+            else if (Vad->u.VadFlags.MemCommit)
             {
                 /* It's committed, so return the VAD protection */
                 *ProtectCode = (ULONG)Vad->u.VadFlags.Protection;
@@ -519,6 +524,7 @@ MiZeroPfn(IN PFN_NUMBER PageFrameNumber)
     /* Get the address it maps to, and zero it out */
     ZeroAddress = MiPteToAddress(ZeroPte);
     KeZeroPages(ZeroAddress, PAGE_SIZE);
+    InterlockedIncrement(&MiZeroOnFaultCount);
 
     /* Now get rid of it */
     MiReleaseSystemPtes(ZeroPte, 1, SystemPteSpace);
@@ -2185,10 +2191,13 @@ UserFault:
         ASSERT(KeAreAllApcsDisabled() == TRUE);
         ASSERT(PointerPde->u.Hard.Valid == 1);
     }
-    else
+    else if (MI_IS_PAGE_LARGE(PointerPde))
     {
-        /* Not yet implemented in ReactOS */
-        ASSERT(MI_IS_PAGE_LARGE(PointerPde) == FALSE);
+        /* Large pages are always resident, so this is either a race or a protection fault */
+        Status = (MI_IS_WRITE_ACCESS(FaultCode) && !MI_IS_PAGE_WRITEABLE(PointerPde)) ?
+                 STATUS_ACCESS_VIOLATION : STATUS_SUCCESS;
+        MiUnlockProcessWorkingSet(CurrentProcess, CurrentThread);
+        return Status;
     }
 
     /* Now capture the PTE. */
@@ -584,7 +584,11 @@ MiRemoveZeroPage(IN ULONG Color)
     ASSERT(Pfn1 == MI_PFN_ELEMENT(PageIndex));
 
     /* Zero it, if needed */
-    if (Zero) MiZeroPhysicalPage(PageIndex);
+    if (Zero)
+    {
+        MiZeroPhysicalPage(PageIndex);
+        InterlockedIncrement(&MiZeroOnFaultCount);
+    }
 
     /* Sanity checks */
     ASSERT(Pfn1->u3.e2.ReferenceCount == 0);
@@ -700,8 +704,9 @@ MiInsertPageInFreeList(IN PFN_NUMBER PageFrameIndex)
     /* And increase the count in the colored list */
     ColorTable->Count++;
 
-    /* Notify zero page thread if enough pages are on the free list now */
-    if (ListHead->Total >= 8)
+    /* Notify the zero page threads if this color is short of zeroed pages */
+    if ((ListHead->Total >= 8) &&
+        (MmFreePagesByColor[ZeroedPageList][Color].Count < MiZeroedPagesPerColor))
     {
         /* Set the event */
         KeSetEvent(&MmZeroingPageEvent, IO_NO_INCREMENT, FALSE);
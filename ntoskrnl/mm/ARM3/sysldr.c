@@ -1486,6 +1486,15 @@ MiFindInitializationCode(OUT PVOID *StartVa,
             continue;
         }
 
+        /* Images under a large page keep their init code, it can't be unmapped */
+        if ((MI_IS_PHYSICAL_ADDRESS((PVOID)DllBase)) ||
+            (MI_IS_PHYSICAL_ADDRESS((PVOID)(DllBase + LdrEntry->SizeOfImage - 1))))
+        {
+            /* Keep going */
+            NextEntry = NextEntry->Flink;
+            continue;
+        }
+
         /* Get the NT header */
         NtHeader = RtlImageNtHeader((PVOID)DllBase);
         if (!NtHeader)
@@ -1638,6 +1647,13 @@ MmFreeDriverInitialization(IN PLDR_DATA_TABLE_ENTRY LdrEntry)
     DllBase = LdrEntry->DllBase;
     PageCount = LdrEntry->SizeOfImage >> PAGE_SHIFT;
 
+    /* Boot drivers sharing a large page with the kernel can't be trimmed */
+    if ((MI_IS_PHYSICAL_ADDRESS(DllBase)) ||
+        (MI_IS_PHYSICAL_ADDRESS((PVOID)((ULONG_PTR)DllBase + LdrEntry->SizeOfImage - 1))))
+    {
+        return;
+    }
+
     /* Get the last PTE in this image */
     EndPte = MiAddressToPte(DllBase) + PageCount;
 
@@ -2405,6 +2421,9 @@ MiSetSystemCodeProtection(
     /* Loop the PTEs */
     for (PointerPte = FirstPte; PointerPte <= LastPte; PointerPte++)
     {
+        /* Pages under a large page share the protection of its PDE */
+        if (MI_IS_PHYSICAL_ADDRESS(MiPteToAddress(PointerPte))) continue;
+
         /* Read the PTE */
         TempPte = *PointerPte;
 
@@ -2446,8 +2465,8 @@ MiWriteProtectSystemImage(
         return;
     }
 
-    /* Large page mapped images are not supported */
-    NT_ASSERT(!MI_IS_PHYSICAL_ADDRESS(ImageBase));
+    /* Large page mapped images stay writable, like the rest of the large page */
+    if (MI_IS_PHYSICAL_ADDRESS(ImageBase)) return;
 
     /* Session images are not yet supported */
     NT_ASSERT(!MI_IS_SESSION_ADDRESS(ImageBase));
@@ -552,6 +552,13 @@ MiDeleteVirtualAddresses(IN ULONG_PTR Va,
     /* Get out if this is a fake VAD, RosMm will free the marea pages */
     if ((Vad) && (Vad->u.VadFlags.Spare == 1)) return;
 
+    /* Large pages have no page tables to walk */
+    if ((Vad) && (Vad->u.VadFlags.VadType == VadLargePages))
+    {
+        MiDeleteLargePageRange(Va, EndingAddress);
+        return;
+    }
+
     /* Grab the process and PTE/PDE for the address being deleted */
     CurrentProcess = PsGetCurrentProcess();
     PointerPde = MiAddressToPde(Va);
@@ -1462,6 +1469,14 @@ MiQueryAddressState(IN PVOID Va,
     ASSERT((Vad->StartingVpn <= ((ULONG_PTR)Va >> PAGE_SHIFT)) &&
            (Vad->EndingVpn >= ((ULONG_PTR)Va >> PAGE_SHIFT)));
 
+    /* Large pages are committed as a whole, with the VAD protection */
+    if (Vad->u.VadFlags.VadType == VadLargePages)
+    {
+        *NextVa = (PVOID)((Vad->EndingVpn + 1) << PAGE_SHIFT);
+        *ReturnedProtect = MmProtectToValue[Vad->u.VadFlags.Protection];
+        return MEM_COMMIT;
+    }
+
     /* Only normal VADs supported */
     ASSERT(Vad->u.VadFlags.VadType == VadNone);
 
@@ -4569,12 +4584,6 @@ NtAllocateVirtualMemory(IN HANDLE ProcessHandle,
     //
     // Fail on the things we don't yet support
     //
-    if ((AllocationType & MEM_LARGE_PAGES) == MEM_LARGE_PAGES)
-    {
-        DPRINT1("MEM_LARGE_PAGES not supported\n");
-        Status = STATUS_INVALID_PARAMETER;
-        goto FailPathNoLock;
-    }
     if ((AllocationType & MEM_PHYSICAL) == MEM_PHYSICAL)
     {
         DPRINT1("MEM_PHYSICAL not supported\n");
@@ -4644,6 +4653,18 @@ NtAllocateVirtualMemory(IN HANDLE ProcessHandle,
             StartingAddress = (ULONG_PTR)PBaseAddress;
         }
 
+        //
+        // Large pages are allocated in whole units, aligned like their PDEs
+        //
+        if (AllocationType & MEM_LARGE_PAGES)
+        {
+            if (StartingAddress)
+            {
+                PRegionSize = EndingAddress + 1 - ALIGN_DOWN_BY(StartingAddress, PDE_MAPPED_VA);
+            }
+            PRegionSize = ALIGN_UP_BY(PRegionSize, PDE_MAPPED_VA);
+        }
+
         //
         // Allocate and initialize the VAD
         //
@@ -4662,14 +4683,26 @@ NtAllocateVirtualMemory(IN HANDLE ProcessHandle,
         Vad->ControlArea = NULL; // For Memory-Area hack
 
         //
-        // Insert the VAD
+        // Insert the VAD. Large pages also get their memory and mappings now
         //
-        Status = MiInsertVadEx(Vad,
-                               &StartingAddress,
-                               PRegionSize,
-                               HighestAddress,
-                               MM_VIRTMEM_GRANULARITY,
-                               AllocationType);
+        if (AllocationType & MEM_LARGE_PAGES)
+        {
+            Status = MiInsertLargePageVad(Vad,
+                                          &StartingAddress,
+                                          PRegionSize,
+                                          HighestAddress,
+                                          AllocationType);
+            if (!NT_SUCCESS(Status)) ExFreePoolWithTag(Vad, 'SdaV');
+        }
+        else
+        {
+            Status = MiInsertVadEx(Vad,
+                                   &StartingAddress,
+                                   PRegionSize,
+                                   HighestAddress,
+                                   MM_VIRTMEM_GRANULARITY,
+                                   AllocationType);
+        }
         if (!NT_SUCCESS(Status))
         {
             DPRINT1("Failed to insert the VAD!\n");
@@ -5266,9 +5299,23 @@ NtFreeVirtualMemory(IN HANDLE ProcessHandle,
     if (FreeType & MEM_RELEASE)
     {
         //
-        // ARM3 only supports this VAD in this path
+        // ARM3 only supports these VADs in this path
         //
-        ASSERT(Vad->u.VadFlags.VadType == VadNone);
+        ASSERT((Vad->u.VadFlags.VadType == VadNone) ||
+               (Vad->u.VadFlags.VadType == VadLargePages));
+
+        //
+        // Large pages can only be released all at once
+        //
+        if ((Vad->u.VadFlags.VadType == VadLargePages) &&
+            (PRegionSize) &&
+            (((StartingAddress >> PAGE_SHIFT) != Vad->StartingVpn) ||
+             ((EndingAddress >> PAGE_SHIFT) != Vad->EndingVpn)))
+        {
+            DPRINT1("Large page VADs must be released as a whole\n");
+            Status = STATUS_FREE_VM_NOT_AT_BASE;
+            goto FailPath;
+        }
 
         //
         // Is the caller trying to remove the whole VAD, or remove only a portion
@@ -5407,7 +5454,14 @@ NtFreeVirtualMemory(IN HANDLE ProcessHandle,
         // to do that and then release the working set, since we're done messing
         // around with process pages.
         //
-        MiDeleteVirtualAddresses(StartingAddress, EndingAddress, NULL);
+        if ((Vad) && (Vad->u.VadFlags.VadType == VadLargePages))
+        {
+            MiDeleteLargePageRange(StartingAddress, EndingAddress);
+        }
+        else
+        {
+            MiDeleteVirtualAddresses(StartingAddress, EndingAddress, NULL);
+        }
         MiUnlockProcessWorkingSetUnsafe(Process, CurrentThread);
         Status = STATUS_SUCCESS;
 
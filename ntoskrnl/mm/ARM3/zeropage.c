@@ -17,7 +17,19 @@
 
 /* GLOBALS ********************************************************************/
 
+/* Pages zeroed per PFN lock round trip, and the size of each thread's window */
+#define MI_ZERO_BATCH_PAGES         16
+
+/* Zeroing threads beyond this only fight over the memory bus */
+#define MI_MAXIMUM_ZERO_THREADS     8
+
+/* How long the zeroing threads sleep before looking at the free list anyway */
+#define MI_ZERO_IDLE_TIMEOUT_MS     1000
+
 KEVENT MmZeroingPageEvent;
+PFN_NUMBER MiZeroedPagesPerColor;
+volatile LONG MiZeroedInBackgroundCount;
+volatile LONG MiZeroOnFaultCount;
 
 /* PRIVATE FUNCTIONS **********************************************************/
 
@@ -31,82 +43,183 @@ NTAPI
 MiFreeInitializationCode(IN PVOID StartVa,
 IN PVOID EndVa);
 
+static
+PFN_NUMBER
+MiGatherFreePages(IN OUT PULONG Color,
+                  IN BOOLEAN Idle,
+                  OUT PPFN_NUMBER Pages)
+{
+    PFN_NUMBER Count = 0, Taken, PageIndex;
+    ULONG Colors;
+
+    MI_ASSERT_PFN_LOCK_HELD();
+
+    /* Refill the colors that are short of zeroed pages first */
+    for (Colors = 0; Colors < MmSecondaryColors; Colors++)
+    {
+        Taken = 0;
+        while ((Count < MI_ZERO_BATCH_PAGES) &&
+               (MmFreePagesByColor[FreePageList][*Color].Flink != LIST_HEAD) &&
+               (MmFreePagesByColor[ZeroedPageList][*Color].Count + Taken < MiZeroedPagesPerColor))
+        {
+            MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
+            MI_SET_PROCESS2("Kernel 0 Loop");
+            Pages[Count++] = MiRemoveAnyPage(*Color);
+            Taken++;
+        }
+
+        if (Count == MI_ZERO_BATCH_PAGES) return Count;
+        *Color = (*Color + 1) & MmSecondaryColorMask;
+    }
+
+    /* Once every reserve is full, idle time goes to the rest of the free list */
+    while (Idle && (Count < MI_ZERO_BATCH_PAGES) && (MmFreePageListHead.Total != 0))
+    {
+        PageIndex = MmFreePageListHead.Flink;
+        ASSERT(PageIndex != LIST_HEAD);
+        MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
+        MI_SET_PROCESS2("Kernel 0 Loop");
+        Pages[Count++] = MiRemoveAnyPage(MI_GET_PAGE_COLOR(PageIndex));
+    }
+
+    return Count;
+}
+
+static
 VOID
-NTAPI
-MmZeroPageThread(VOID)
+MiZeroPageWorker(IN ULONG Processor)
 {
     PKTHREAD Thread = KeGetCurrentThread();
-    PVOID StartAddress, EndAddress;
-    PVOID WaitObjects[2];
+    PFN_NUMBER Pages[MI_ZERO_BATCH_PAGES];
+    PFN_NUMBER Count, i;
+    LARGE_INTEGER Timeout;
+    PMMPTE PointerPte;
+    MMPTE TempPte;
+    PUCHAR ZeroAddress;
+    NTSTATUS Status;
+    BOOLEAN Idle;
     KIRQL OldIrql;
-    PVOID ZeroAddress;
-    PFN_NUMBER PageIndex, FreePage;
-    PMMPFN Pfn1;
+    ULONG Color;
 
-    /* Get the discardable sections to free them */
-    MiFindInitializationCode(&StartAddress, &EndAddress);
-    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
-    DPRINT("Free non-cache pages: %lx\n", MmAvailablePages + MiMemoryConsumers[MC_CACHE].PagesUsed);
+    /* Stay on one processor, so the window never needs a TLB shootdown */
+    KeSetSystemAffinityThread(AFFINITY_MASK(Processor));
 
     /* Set our priority to 0 */
     Thread->BasePriority = 0;
     KeSetPriorityThread(Thread, 0);
 
-    /* Setup the wait objects */
-    WaitObjects[0] = &MmZeroingPageEvent;
-//    WaitObjects[1] = &PoSystemIdleTimer; FIXME: Implement idle timer
+    /* Get the window the batches are mapped through */
+    PointerPte = MiReserveSystemPtes(MI_ZERO_BATCH_PAGES, SystemPteSpace);
+    if (!PointerPte)
+    {
+        DPRINT1("No system PTEs for the zero page thread of processor %lu\n", Processor);
+        return;
+    }
+    ZeroAddress = MiPteToAddress(PointerPte);
+    TempPte = ValidKernelPte;
+
+    /* Spread the threads over the colors */
+    Color = (Processor * MmSecondaryColors / MI_MAXIMUM_ZERO_THREADS) & MmSecondaryColorMask;
+    Timeout.QuadPart = Int32x32To64(MI_ZERO_IDLE_TIMEOUT_MS, -10000);
 
     while (TRUE)
     {
-        KeWaitForMultipleObjects(1, // 2
-                                 WaitObjects,
-                                 WaitAny,
-                                 WrFreePage,
-                                 KernelMode,
-                                 FALSE,
-                                 NULL,
-                                 NULL);
-        OldIrql = MiAcquirePfnLock();
+        /* Wait for a color to run low, or for the processor to have been idle a while */
+        Status = KeWaitForSingleObject(&MmZeroingPageEvent,
+                                       WrFreePage,
+                                       KernelMode,
+                                       FALSE,
+                                       &Timeout);
+        Idle = (Status == STATUS_TIMEOUT);
 
         while (TRUE)
         {
-            if (!MmFreePageListHead.Total)
+            OldIrql = MiAcquirePfnLock();
+
+            Count = MiGatherFreePages(&Color, Idle, Pages);
+            if (!Count)
             {
                 KeClearEvent(&MmZeroingPageEvent);
                 MiReleasePfnLock(OldIrql);
                 break;
             }
 
-            PageIndex = MmFreePageListHead.Flink;
-            ASSERT(PageIndex != LIST_HEAD);
-            Pfn1 = MiGetPfnEntry(PageIndex);
-            MI_SET_USAGE(MI_USAGE_ZERO_LOOP);
-            MI_SET_PROCESS2("Kernel 0 Loop");
-            FreePage = MiRemoveAnyPage(MI_GET_PAGE_COLOR(PageIndex));
+            MiReleasePfnLock(OldIrql);
 
-            /* The first global free page should also be the first on its own list */
-            if (FreePage != PageIndex)
+            /* Map the whole batch and zero it in one go */
+            for (i = 0; i < Count; i++)
             {
-                KeBugCheckEx(PFN_LIST_CORRUPT,
-                             0x8F,
-                             FreePage,
-                             PageIndex,
-                             0);
+                TempPte.u.Hard.PageFrameNumber = Pages[i];
+                MI_WRITE_VALID_PTE(PointerPte + i, TempPte);
             }
 
-            Pfn1->u1.Flink = LIST_HEAD;
-            MiReleasePfnLock(OldIrql);
+            KeZeroPagesFromIdleThread(ZeroAddress, (ULONG)(Count * PAGE_SIZE));
 
-            ZeroAddress = MiMapPagesInZeroSpace(Pfn1, 1);
-            ASSERT(ZeroAddress);
-            RtlZeroMemory(ZeroAddress, PAGE_SIZE);
-            MiUnmapPagesInZeroSpace(ZeroAddress, 1);
+            for (i = 0; i < Count; i++)
+            {
+                MI_ERASE_PTE(PointerPte + i);
+                KeInvalidateTlbEntry(ZeroAddress + i * PAGE_SIZE);
+            }
 
             OldIrql = MiAcquirePfnLock();
+            for (i = 0; i < Count; i++)
+            {
+                MiInsertPageInList(&MmZeroedPageListHead, Pages[i]);
+            }
+            MiReleasePfnLock(OldIrql);
+
+            InterlockedExchangeAdd(&MiZeroedInBackgroundCount, (LONG)Count);
+        }
+    }
+}
+
+static
+VOID
+NTAPI
+MiZeroPageWorkerThread(IN PVOID Context)
+{
+    MiZeroPageWorker(PtrToUlong(Context));
+}
 
-            MiInsertPageInList(&MmZeroedPageListHead, PageIndex);
+VOID
+NTAPI
+MmZeroPageThread(VOID)
+{
+    PVOID StartAddress, EndAddress;
+    HANDLE ThreadHandle;
+    NTSTATUS Status;
+    ULONG i, Workers;
+
+    /* Get the discardable sections to free them */
+    MiFindInitializationCode(&StartAddress, &EndAddress);
+    if (StartAddress) MiFreeInitializationCode(StartAddress, EndAddress);
+    DPRINT("Free non-cache pages: %lx\n", MmAvailablePages + MiMemoryConsumers[MC_CACHE].PagesUsed);
+
+    /* Keep an eighth of memory zeroed ahead of the page faults */
+    MiZeroedPagesPerColor = (MmNumberOfPhysicalPages / 8) / MmSecondaryColors;
+    if (MiZeroedPagesPerColor == 0) MiZeroedPagesPerColor = 1;
+
+    /* Every processor zeroes pages while it is idle, we take the boot one */
+    Workers = min((ULONG)KeNumberProcessors, MI_MAXIMUM_ZERO_THREADS);
+    for (i = 1; i < Workers; i++)
+    {
+        Status = PsCreateSystemThread(&ThreadHandle,
+                                      THREAD_ALL_ACCESS,
+                                      NULL,
+                                      NULL,
+                                      NULL,
+                                      MiZeroPageWorkerThread,
+                                      UlongToPtr(i));
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Failed to create zero page thread %lu (Status 0x%08lx)\n", i, Status);
+            break;
         }
+
+        ObCloseHandle(ThreadHandle, KernelMode);
     }
+
+    MiZeroPageWorker(0);
 }
 
 /* EOF */
@@ -376,7 +376,11 @@ MiAllocatePagesForMdl(IN PHYSICAL_ADDRESS LowAddress,
         //
         Pfn1 = MiGetPfnEntry(Page);
         ASSERT(Pfn1);
-        if (Pfn1->u3.e1.PageLocation != ZeroedPageList) MiZeroPhysicalPage(Page);
+        if (Pfn1->u3.e1.PageLocation != ZeroedPageList)
+        {
+            MiZeroPhysicalPage(Page);
+            InterlockedIncrement(&MiZeroOnFaultCount);
+        }
         Pfn1->u3.e1.PageLocation = ActiveAndValid;
     }
 
@@ -221,6 +221,8 @@ MmAccessFault(IN ULONG FaultCode,
 #endif
     }
 
+    KeGetCurrentPrcb()->MmPageFaultCount++;
+
     /* Handle shared user page, which doesn't have a VAD / MemoryArea */
     if (PAGE_ALIGN(Address) == (PVOID)MM_SHARED_USER_DATA_VA)
     {
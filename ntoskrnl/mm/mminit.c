@@ -273,6 +273,9 @@ MmInitSystem(IN ULONG Phase,
     /* Initialize the balance set manager */
     MmInitBsmThread();
 
+    /* Large pages are enabled now, use them for user mode and the kernel */
+    MiMapBootImagesWithLargePages();
+
     /* Loop the boot loaded images */
     for (ListEntry = PsLoadedModuleList.Flink;
          ListEntry != &PsLoadedModuleList;
@@ -1098,6 +1098,9 @@ MiReadPage(PMEMORY_AREA MemoryArea,
 
     DPRINT("%S %I64x\n", FileObject->FileName.Buffer, FileOffset);
 
+    /* Let the prefetcher know, even if this is served from the cache */
+    CcPfLogFileAccess(FileObject, FileOffset, PAGE_SIZE);
+
     /*
      * If the file system is letting us go directly to the cache and the
      * memory area was mapped at an offset in the file which is page aligned
@@ -1129,6 +1132,7 @@ MiReadPage(PMEMORY_AREA MemoryArea,
              * If the VACB isn't up to date then call the file
              * system to read in the data.
              */
+            KeGetCurrentPrcb()->MmPageReadIoCount++;
             Status = CcReadVirtualAddress(Vacb);
             if (!NT_SUCCESS(Status))
             {
@@ -1182,6 +1186,7 @@ MiReadPage(PMEMORY_AREA MemoryArea,
              * If the VACB isn't up to date then call the file
              * system to read in the data.
              */
+            KeGetCurrentPrcb()->MmPageReadIoCount++;
             Status = CcReadVirtualAddress(Vacb);
             if (!NT_SUCCESS(Status))
             {
@@ -1223,6 +1228,7 @@ MiReadPage(PMEMORY_AREA MemoryArea,
                  * If the VACB isn't up to date then call the file
                  * system to read in the data.
                  */
+                KeGetCurrentPrcb()->MmPageReadIoCount++;
                 Status = CcReadVirtualAddress(Vacb);
                 if (!NT_SUCCESS(Status))
                 {
@@ -1359,6 +1365,237 @@ MmAlterViewAttributes(PMMSUPPORT AddressSpace,
     MmUnlockSectionSegment(Segment);
 }
 
+/*
+ * Fault-around window for file backed sections, in pages. It doubles while
+ * faults on a segment keep landing right after the previous cluster and
+ * halves on every other fault, so random access degrades to single pages.
+ */
+#define MI_MIN_FAULT_CLUSTER        1
+#define MI_DEFAULT_FAULT_CLUSTER    8
+#define MI_MAX_FAULT_CLUSTER        32
+
+static
+ULONG
+MiReserveFaultCluster(PEPROCESS Process,
+                      PMEMORY_AREA MemoryArea,
+                      PMM_REGION Region,
+                      PMM_SECTION_SEGMENT Segment,
+                      PVOID Address,
+                      PLARGE_INTEGER Offset)
+/*
+ * FUNCTION: Claim the non-resident pages following a faulting one so they
+ * can be read in along with it.
+ * PARAMETERS:
+ *       Address - Page aligned faulting address.
+ *       Offset - Its offset within the segment.
+ * RETURNS: The number of pages claimed after Address. Each of them carries
+ * a wait entry in the segment and in the process until
+ * MiCompleteFaultCluster is called. The segment must be locked.
+ */
+{
+    LARGE_INTEGER NextOffset;
+    PVOID NextAddress;
+    ULONG Window, Count;
+
+    if (Offset->QuadPart == Segment->NextFaultOffset)
+    {
+        Window = min(Segment->FaultClusterPages * 2, MI_MAX_FAULT_CLUSTER);
+    }
+    else
+    {
+        Window = max(Segment->FaultClusterPages / 2, MI_MIN_FAULT_CLUSTER);
+    }
+    Segment->FaultClusterPages = Window;
+
+    NextOffset = *Offset;
+    NextAddress = Address;
+    for (Count = 0; Count + 1 < Window; Count++)
+    {
+        NextOffset.QuadPart += PAGE_SIZE;
+        NextAddress = (PVOID)((ULONG_PTR)NextAddress + PAGE_SIZE);
+
+        /* Stay within the view, its protection and the file data */
+        if ((ULONG_PTR)NextAddress >= MA_GetEndingAddress(MemoryArea) ||
+            NextOffset.QuadPart >= (LONGLONG)PAGE_ROUND_UP(Segment->RawLength.QuadPart) ||
+            MmFindRegion((PVOID)MA_GetStartingAddress(MemoryArea),
+                         &MemoryArea->Data.SectionData.RegionListHead,
+                         NextAddress, NULL) != Region)
+        {
+            break;
+        }
+
+        /* Stop at the first page somebody already has or is bringing in */
+        if (MmGetPageEntrySectionSegment(Segment, &NextOffset) != 0 ||
+            MmIsPagePresent(Process, NextAddress) ||
+            MmIsDisabledPage(Process, NextAddress) ||
+            MmIsPageSwapEntry(Process, NextAddress))
+        {
+            break;
+        }
+
+        MmSetPageEntrySectionSegment(Segment, &NextOffset, MAKE_SWAP_SSE(MM_WAIT_ENTRY));
+        MmCreatePageFileMapping(Process, NextAddress, MM_WAIT_ENTRY);
+    }
+
+    Segment->NextFaultOffset = Offset->QuadPart + (LONGLONG)(Count + 1) * PAGE_SIZE;
+    return Count;
+}
+
+static
+VOID
+MiCompleteFaultCluster(PEPROCESS Process,
+                       PMM_SECTION_SEGMENT Segment,
+                       PVOID Address,
+                       PLARGE_INTEGER Offset,
+                       ULONG Attributes,
+                       PPFN_NUMBER Pages,
+                       ULONG PagesRead,
+                       ULONG Count)
+/*
+ * FUNCTION: Map the pages claimed by MiReserveFaultCluster that were read
+ * in and give the others back. The address space and the segment must be
+ * locked.
+ */
+{
+    LARGE_INTEGER NextOffset;
+    PVOID NextAddress;
+    SWAPENTRY FakeSwapEntry;
+    NTSTATUS Status;
+    ULONG i;
+
+    NextOffset = *Offset;
+    NextAddress = Address;
+    for (i = 0; i < Count; i++)
+    {
+        NextOffset.QuadPart += PAGE_SIZE;
+        NextAddress = (PVOID)((ULONG_PTR)NextAddress + PAGE_SIZE);
+
+        MmDeletePageFileMapping(Process, NextAddress, &FakeSwapEntry);
+        if (i >= PagesRead)
+        {
+            MmSetPageEntrySectionSegment(Segment, &NextOffset, 0);
+            continue;
+        }
+
+        Status = MmCreateVirtualMapping(Process,
+                                        NextAddress,
+                                        Attributes,
+                                        &Pages[i],
+                                        1);
+        if (!NT_SUCCESS(Status))
+        {
+            DPRINT1("Unable to create virtual mapping\n");
+            KeBugCheck(MEMORY_MANAGEMENT);
+        }
+        MmInsertRmap(Pages[i], Process, NextAddress);
+        MmSetPageEntrySectionSegment(Segment, &NextOffset, MAKE_SSE(Pages[i] << PAGE_SHIFT, 1));
+    }
+}
+
+static
+NTSTATUS
+MiReadFaultCluster(PMEMORY_AREA MemoryArea,
+                   LONGLONG SegOffset,
+                   PPFN_NUMBER Pages,
+                   ULONG Count)
+/*
+ * FUNCTION: Read a faulting page and the cluster claimed behind it straight
+ * from the file, with a single paging I/O.
+ * PARAMETERS:
+ *       SegOffset - Offset of the faulting page within the segment.
+ *       Pages - Receives the Count pages read.
+ * RETURNS: STATUS_NOT_SUPPORTED if the run has to go through the cache,
+ * which data sections do to stay coherent with cached I/O on the file.
+ */
+{
+    UCHAR MdlBase[sizeof(MDL) + MI_MAX_FAULT_CLUSTER * sizeof(PFN_NUMBER)];
+    PMDL Mdl = (PMDL)MdlBase;
+    PMM_SECTION_SEGMENT Segment = MemoryArea->Data.SectionData.Segment;
+    PFILE_OBJECT FileObject = MemoryArea->Data.SectionData.Section->FileObject;
+    PEPROCESS Process = PsGetCurrentProcess();
+    LARGE_INTEGER FileOffset;
+    IO_STATUS_BLOCK IoStatus;
+    KEVENT Event;
+    LONGLONG Valid;
+    PVOID PageAddr;
+    KIRQL Irql;
+    NTSTATUS Status;
+    ULONG i;
+
+    ASSERT(Count <= MI_MAX_FAULT_CLUSTER);
+
+    FileOffset.QuadPart = SegOffset + Segment->Image.FileOffset;
+    if (!(MemoryArea->Data.SectionData.Section->AllocationAttributes & SEC_IMAGE) ||
+        (FileOffset.QuadPart % PAGE_SIZE) != 0)
+    {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    for (i = 0; i < Count; i++)
+    {
+        MI_SET_USAGE(MI_USAGE_SECTION);
+        MI_SET_PROCESS2(Process->ImageFileName);
+        Status = MmRequestPageMemoryConsumer(MC_USER, TRUE, &Pages[i]);
+        if (!NT_SUCCESS(Status))
+        {
+            while (i--) MmReleasePageMemoryConsumer(MC_USER, Pages[i]);
+            return Status;
+        }
+    }
+
+    CcPfLogFileAccess(FileObject, FileOffset.QuadPart, Count * PAGE_SIZE);
+
+    MmInitializeMdl(Mdl, NULL, Count * PAGE_SIZE);
+    MmBuildMdlFromPages(Mdl, Pages);
+    Mdl->MdlFlags |= MDL_PAGES_LOCKED;
+
+    KeGetCurrentPrcb()->MmPageReadIoCount++;
+    KeInitializeEvent(&Event, NotificationEvent, FALSE);
+    Status = IoPageRead(FileObject, Mdl, &FileOffset, &Event, &IoStatus);
+    if (Status == STATUS_PENDING)
+    {
+        KeWaitForSingleObject(&Event, Executive, KernelMode, FALSE, NULL);
+        Status = IoStatus.Status;
+    }
+    if (Mdl->MdlFlags & MDL_MAPPED_TO_SYSTEM_VA)
+    {
+        MmUnmapLockedPages(Mdl->MappedSystemVa, Mdl);
+    }
+
+    if (Status == STATUS_END_OF_FILE)
+    {
+        Status = STATUS_SUCCESS;
+    }
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("IoPageRead failed (Status %x)\n", Status);
+        for (i = 0; i < Count; i++) MmReleasePageMemoryConsumer(MC_USER, Pages[i]);
+        return Status;
+    }
+
+    /* Whatever follows the raw data in the file belongs to another segment */
+    Valid = min((LONGLONG)IoStatus.Information, Segment->RawLength.QuadPart - SegOffset);
+    for (i = 0; i < Count; i++)
+    {
+        if (Valid >= (LONGLONG)(i + 1) * PAGE_SIZE)
+            continue;
+
+        PageAddr = MiMapPageInHyperSpace(Process, Pages[i], &Irql);
+        if (Valid > (LONGLONG)i * PAGE_SIZE)
+        {
+            RtlZeroMemory((PCHAR)PageAddr + (Valid - i * PAGE_SIZE),
+                          PAGE_SIZE - (ULONG)(Valid - i * PAGE_SIZE));
+        }
+        else
+        {
+            RtlZeroMemory(PageAddr, PAGE_SIZE);
+        }
+        MiUnmapPageInHyperSpace(Process, PageAddr, Irql);
+    }
+
+    return STATUS_SUCCESS;
+}
+
 NTSTATUS
 NTAPI
 MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
@@ -1379,6 +1616,9 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
     PVOID PAddress;
     PEPROCESS Process = MmGetAddressSpaceOwner(AddressSpace);
     SWAPENTRY SwapEntry;
+    PFN_NUMBER ClusterPages[MI_MAX_FAULT_CLUSTER];
+    ULONG ClusterCount, ClusterRead;
+    LARGE_INTEGER ClusterOffset;
 
     /*
      * There is a window between taking the page fault and locking the
@@ -1612,6 +1852,15 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
          * Release all our locks and read in the page from disk
          */
         MmSetPageEntrySectionSegment(Segment, &Offset, MAKE_SWAP_SSE(MM_WAIT_ENTRY));
+        ClusterCount = 0;
+        ClusterRead = 0;
+        if (!(Segment->Flags & MM_PAGEFILE_SEGMENT) &&
+            Offset.QuadPart < (LONGLONG)PAGE_ROUND_UP(Segment->RawLength.QuadPart))
+        {
+            /* The pages after this one will most likely be needed as well */
+            ClusterCount = MiReserveFaultCluster(Process, MemoryArea, Region,
+                                                 Segment, PAddress, &Offset);
+        }
         MmUnlockSectionSegment(Segment);
         MmCreatePageFileMapping(Process, PAddress, MM_WAIT_ENTRY);
         MmUnlockAddressSpace(AddressSpace);
@@ -1632,10 +1881,44 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
         }
         else
         {
-            Status = MiReadPage(MemoryArea, Offset.QuadPart, &Page);
-            if (!NT_SUCCESS(Status))
+            /* The faulting page goes first, the cluster follows it */
+            Status = MiReadFaultCluster(MemoryArea, Offset.QuadPart,
+                                        ClusterPages, 1 + ClusterCount);
+            if (NT_SUCCESS(Status))
             {
-                DPRINT1("MiReadPage failed (Status %x)\n", Status);
+                ClusterRead = ClusterCount;
+            }
+            else
+            {
+                Status = MiReadPage(MemoryArea, Offset.QuadPart, &ClusterPages[0]);
+                if (!NT_SUCCESS(Status))
+                {
+                    DPRINT1("MiReadPage failed (Status %x)\n", Status);
+                }
+                else
+                {
+                    /*
+                     * The rest of the cluster normally comes out of the view
+                     * the cache just read for the faulting page, so this
+                     * costs no further I/O.
+                     */
+                    ClusterOffset = Offset;
+                    for (ClusterRead = 0; ClusterRead < ClusterCount; ClusterRead++)
+                    {
+                        ClusterOffset.QuadPart += PAGE_SIZE;
+                        if (!NT_SUCCESS(MiReadPage(MemoryArea,
+                                                   ClusterOffset.QuadPart,
+                                                   &ClusterPages[1 + ClusterRead])))
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+            if (NT_SUCCESS(Status))
+            {
+                Page = ClusterPages[0];
+                KeGetCurrentPrcb()->MmPageReadCount += 1 + ClusterRead;
             }
         }
         if (!NT_SUCCESS(Status))
@@ -1647,6 +1930,13 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
              * Cleanup and release locks
              */
             MmLockAddressSpace(AddressSpace);
+            if (ClusterCount)
+            {
+                MmLockSectionSegment(Segment);
+                MiCompleteFaultCluster(Process, Segment, PAddress, &Offset,
+                                       Attributes, &ClusterPages[1], 0, ClusterCount);
+                MmUnlockSectionSegment(Segment);
+            }
             MiSetPageEvent(Process, Address);
             DPRINT("Address 0x%p\n", Address);
             return(Status);
@@ -1675,6 +1965,12 @@ MmNotPresentFaultSectionView(PMMSUPPORT AddressSpace,
         /* Set this section offset has being backed by our new page. */
         Entry = MAKE_SSE(Page << PAGE_SHIFT, 1);
         MmSetPageEntrySectionSegment(Segment, &Offset, Entry);
+
+        if (ClusterCount)
+        {
+            MiCompleteFaultCluster(Process, Segment, PAddress, &Offset, Attributes,
+                                   &ClusterPages[1], ClusterRead, ClusterCount);
+        }
         MmUnlockSectionSegment(Segment);
 
         MiSetPageEvent(Process, Address);
@@ -3064,6 +3360,8 @@ MmCreateDataFileSection(PROS_SECTION_OBJECT *SectionObject,
             Segment->Length.QuadPart = PAGE_ROUND_UP(Segment->RawLength.QuadPart);
         }
         Segment->Image.VirtualAddress = 0;
+        Segment->FaultClusterPages = MI_DEFAULT_FAULT_CLUSTER;
+        Segment->NextFaultOffset = 0;
         Segment->Locked = TRUE;
         MiInitializeSectionPageTable(Segment);
     }
@@ -3719,6 +4017,7 @@ ExeFmtpCreateImageSection(PFILE_OBJECT FileObject,
     {
         ExInitializeFastMutex(&ImageSectionObject->Segments[i].Lock);
         ImageSectionObject->Segments[i].ReferenceCount = 1;
+        ImageSectionObject->Segments[i].FaultClusterPages = MI_DEFAULT_FAULT_CLUSTER;
         MiInitializeSectionPageTable(&ImageSectionObject->Segments[i]);
     }
 
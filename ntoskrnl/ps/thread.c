@@ -65,7 +65,12 @@ PspUserThreadStartup(IN PKSTART_ROUTINE StartRoutine,
         /* Check if the Prefetcher is enabled */
         if (CcPfEnablePrefetcher)
         {
-            /* FIXME: Prepare to prefetch this process */
+            /* Prefetch for the first thread of the process only */
+            if (!(PspSetProcessFlag(Thread->ThreadsProcess,
+                                    PSF_LAUNCH_PREFETCHED_BIT) & PSF_LAUNCH_PREFETCHED_BIT))
+            {
+                CcPfBeginAppLaunch(Thread->ThreadsProcess);
+            }
         }
 
         /* Raise to APC */
@@ -0,0 +1,32 @@
+/*
+ * PROJECT:     ReactOS DDK
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     IoConnectInterruptEx for drivers built for downlevel targets
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#if (NTDDI_VERSION < NTDDI_VISTA)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+NTKERNELAPI
+NTSTATUS
+NTAPI
+IoConnectInterruptEx(
+  _Inout_ PIO_CONNECT_INTERRUPT_PARAMETERS Parameters);
+
+NTKERNELAPI
+VOID
+NTAPI
+IoDisconnectInterruptEx(
+  _In_ PIO_DISCONNECT_INTERRUPT_PARAMETERS Parameters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* (NTDDI_VERSION < NTDDI_VISTA) */
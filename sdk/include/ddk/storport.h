@@ -386,6 +386,8 @@ extern "C" {
 #define SRB_HEAD_OF_QUEUE_TAG_REQUEST       0x21
 #define SRB_ORDERED_QUEUE_TAG_REQUEST       0x22
 
+#define SP_UNTAGGED                         ((UCHAR) ~0)
+
 #define SRB_WMI_FLAGS_ADAPTER_REQUEST       0x01
 #define SRB_POWER_FLAGS_ADAPTER_REQUEST     0x01
 #define SRB_PNP_FLAGS_ADAPTER_REQUEST       0x01
@@ -427,6 +429,19 @@ typedef enum _STOR_SYNCHRONIZATION_MODEL
     StorSynchronizeFullDuplex
 } STOR_SYNCHRONIZATION_MODEL;
 
+typedef enum _INTERRUPT_SYNCHRONIZATION_MODE
+{
+    InterruptSupportNone,
+    InterruptSynchronizeAll,
+    InterruptSynchronizePerMessage
+} INTERRUPT_SYNCHRONIZATION_MODE;
+
+typedef
+BOOLEAN
+(NTAPI *PHW_MESSAGE_SIGNALED_INTERRUPT_ROUTINE)(
+    _In_ PVOID HwDeviceExtension,
+    _In_ ULONG MessageId);
+
 typedef enum _STOR_DMA_WIDTH
 {
     DmaUnknown,
@@ -547,6 +562,13 @@ typedef enum _VPD_IDENTIFIER_TYPE
     VpdIdentifierTypeSCSINameString = 8
 } VPD_IDENTIFIER_TYPE, *PVPD_IDENTIFIER_TYPE;
 
+#define STOR_STATUS_SUCCESS                 0x00000000L
+#define STOR_STATUS_UNSUCCESSFUL            0xC1000001L
+#define STOR_STATUS_NOT_IMPLEMENTED         0xC1000002L
+#define STOR_STATUS_INSUFFICIENT_RESOURCES  0xC1000003L
+#define STOR_STATUS_BUFFER_TOO_SMALL        0xC1000004L
+#define STOR_STATUS_INVALID_PARAMETER       0xC1000005L
+
 typedef enum _STORPORT_FUNCTION_CODE
 {
     ExtFunctionAllocatePool,
@@ -2040,6 +2062,8 @@ typedef struct _PORT_CONFIGURATION_INFORMATION
     UCHAR MaximumNumberOfLogicalUnits;
     BOOLEAN WmiDataProvider;
     STOR_SYNCHRONIZATION_MODEL SynchronizationModel;
+    PHW_MESSAGE_SIGNALED_INTERRUPT_ROUTINE HwMSInterruptRoutine;
+    INTERRUPT_SYNCHRONIZATION_MODE InterruptSynchronizationMode;
 } PORT_CONFIGURATION_INFORMATION, *PPORT_CONFIGURATION_INFORMATION;
 
 typedef struct _STOR_SCATTER_GATHER_ELEMENT
@@ -51,6 +51,11 @@ Author:
 #define HalVectorToIDTEntry             HALPRIVATEDISPATCH->HalVectorToIDTEntry
 #define KdMapPhysicalMemory64           HALPRIVATEDISPATCH->KdMapPhysicalMemory64
 #define KdUnmapVirtualAddress           HALPRIVATEDISPATCH->KdUnmapVirtualAddress
+#define HalSuspendClockTick             HALPRIVATEDISPATCH->HalSuspendClockTick
+#define HalResumeClockTick              HALPRIVATEDISPATCH->HalResumeClockTick
+#define HalAllocateMessageInterrupt     HALPRIVATEDISPATCH->HalAllocateMessageInterrupt
+#define HalFreeMessageInterrupt         HALPRIVATEDISPATCH->HalFreeMessageInterrupt
+#define HalGetMessageRoute              HALPRIVATEDISPATCH->HalGetMessageRoute
 
 //
 // Display Functions
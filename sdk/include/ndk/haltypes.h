@@ -96,6 +96,43 @@ NTSTATUS
     PMAP_REGISTER_ENTRY Registers
 );
 
+typedef
+BOOLEAN
+(NTAPI *pHalSuspendClockTick)(
+    _In_ ULONGLONG Interval
+);
+
+typedef
+ULONGLONG
+(NTAPI *pHalResumeClockTick)(
+    VOID
+);
+
+typedef
+NTSTATUS
+(NTAPI *pHalAllocateMessageInterrupt)(
+    _In_ KAFFINITY Affinity,
+    _Out_ PULONG Vector,
+    _Out_ PKIRQL Irql,
+    _Out_ PKAFFINITY TargetProcessor
+);
+
+typedef
+VOID
+(NTAPI *pHalFreeMessageInterrupt)(
+    _In_ ULONG Vector
+);
+
+typedef
+NTSTATUS
+(NTAPI *pHalGetMessageRoute)(
+    _In_ ULONG Vector,
+    _In_ KAFFINITY TargetProcessor,
+    _Out_opt_ PKIRQL Irql,
+    _Out_opt_ PPHYSICAL_ADDRESS MessageAddress,
+    _Out_opt_ PULONG MessageData
+);
+
 //
 // HAL Bus Handler Callback Types
 //
@@ -184,6 +221,13 @@ typedef struct _HAL_PRIVATE_DISPATCH
     PVOID HalGetInterruptVectorOverride;
     PVOID HalGetVectorInputOverride;
 #endif
+    /* ReactOS dynamic tick support, NULL if the HAL lacks a one-shot timer */
+    pHalSuspendClockTick HalSuspendClockTick;
+    pHalResumeClockTick HalResumeClockTick;
+    /* ReactOS message signaled interrupt support, NULL if the HAL has none */
+    pHalAllocateMessageInterrupt HalAllocateMessageInterrupt;
+    pHalFreeMessageInterrupt HalFreeMessageInterrupt;
+    pHalGetMessageRoute HalGetMessageRoute;
 } HAL_PRIVATE_DISPATCH, *PHAL_PRIVATE_DISPATCH;
 
 //
@@ -246,6 +290,31 @@ typedef struct _BUS_HANDLER
     PVOID Spare8;
 } BUS_HANDLER;
 
+//
+// HAL Timer Sources, for HalPlatformTimerInformation
+//
+typedef enum _HAL_TIMER_SOURCE
+{
+    HalTimerSourceNone,
+    HalTimerSourcePit,
+    HalTimerSourceRtc,
+    HalTimerSourceHpet,
+    HalTimerSourceTsc,
+    HalTimerSourceLocalApic
+} HAL_TIMER_SOURCE;
+
+typedef struct _HAL_PLATFORM_TIMER_INFORMATION
+{
+    HAL_TIMER_SOURCE ClockSource;
+    HAL_TIMER_SOURCE PerformanceCounterSource;
+    LARGE_INTEGER PerformanceFrequency;
+    ULONG ClockIncrement;
+    BOOLEAN InvariantTsc;
+    BOOLEAN TscSynchronized;
+    PHYSICAL_ADDRESS HpetAddress;
+    ULONGLONG HpetFrequency;
+} HAL_PLATFORM_TIMER_INFORMATION, *PHAL_PLATFORM_TIMER_INFORMATION;
+
 //
 // HAL Chip Hacks
 //
@@ -183,7 +183,7 @@ NTSTATUS
 NTAPI
 NtReplyWaitReplyPort(
     _In_ HANDLE PortHandle,
-    _Out_ PPORT_MESSAGE ReplyMessage
+    _Inout_ PPORT_MESSAGE ReplyMessage
 );
 
 NTSYSCALLAPI
@@ -2576,6 +2576,19 @@ DECLARE_INTERFACE_(IDockingWindowSite, IOleWindow)
 
 typedef void (CALLBACK *PFNASYNCICONTASKBALLBACK)(LPCITEMIDLIST pidl, LPVOID pvData, LPVOID pvHint, INT iIconIndex, INT iOpenIconIndex);
 
+HRESULT
+WINAPI
+SHMapIDListToImageListIndexAsync(
+  _In_opt_ IShellTaskScheduler*,
+  _In_ IShellFolder*,
+  _In_ LPCITEMIDLIST,
+  UINT,
+  _In_opt_ PFNASYNCICONTASKBALLBACK,
+  _In_opt_ LPVOID,
+  _In_opt_ LPVOID,
+  _Out_ int*,
+  _Out_opt_ int*);
+
 #define ISFB_MASK_STATE       0x00000001
 #define ISFB_MASK_IDLIST      0x00000010
 
@@ -41,7 +41,8 @@ typedef enum _USB_DEVICE_TYPE {
 typedef enum _USB_DEVICE_SPEED {
   UsbLowSpeed = 0,
   UsbFullSpeed,
-  UsbHighSpeed
+  UsbHighSpeed,
+  UsbSuperSpeed
 } USB_DEVICE_SPEED;
 
 #define USB_PORT_STATUS_CONNECT                       0x0001
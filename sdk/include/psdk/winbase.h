@@ -3265,10 +3265,17 @@ DWORD WINAPI WaitForSingleObject(_In_ HANDLE hHandle, _In_ DWORD dwMilliseconds)
 DWORD WINAPI WaitForSingleObjectEx(HANDLE,DWORD,BOOL);
 BOOL WINAPI WaitNamedPipeA(_In_ LPCSTR, _In_ DWORD);
 BOOL WINAPI WaitNamedPipeW(_In_ LPCWSTR, _In_ DWORD);
+#if (_WIN32_WINNT >= 0x0602)
+BOOL WINAPI WaitOnAddress(_In_reads_bytes_(AddressSize) volatile VOID *Address, _In_reads_bytes_(AddressSize) PVOID CompareAddress, _In_ SIZE_T AddressSize, _In_opt_ DWORD dwMilliseconds);
+#endif
 #if (_WIN32_WINNT >= 0x0600)
 VOID WINAPI WakeConditionVariable(PCONDITION_VARIABLE);
 VOID WINAPI WakeAllConditionVariable(PCONDITION_VARIABLE);
 #endif
+#if (_WIN32_WINNT >= 0x0602)
+VOID WINAPI WakeByAddressAll(_In_ PVOID Address);
+VOID WINAPI WakeByAddressSingle(_In_ PVOID Address);
+#endif
 BOOL WINAPI WinLoadTrustProvider(GUID*);
 BOOL WINAPI Wow64DisableWow64FsRedirection(PVOID*);
 BOOLEAN WINAPI Wow64EnableWow64FsRedirection(_In_ BOOLEAN);
@@ -0,0 +1,32 @@
+
+#pragma once
+
+/*
+ * Ioctl handled by classpnp for any disk or partition object.
+ * Returns the CLASS_REQUEST_QUEUE_STATISTICS of the whole disk.
+ */
+#define IOCTL_STORAGE_QUERY_REQUEST_QUEUE_STATISTICS \
+    CTL_CODE(IOCTL_STORAGE_BASE, 0x0A00, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+/*
+ * The request queue is enabled per disk by the RequestQueueDepth value
+ * in the Classpnp subkey of the device's hardware key. Times are in
+ * microseconds.
+ */
+typedef struct _CLASS_REQUEST_QUEUE_STATISTICS
+{
+    ULONG Size;                     /* sizeof(CLASS_REQUEST_QUEUE_STATISTICS) */
+    ULONG QueueDepth;               /* 0 when the request queue is disabled */
+    ULONG CurrentQueued;
+    ULONG CurrentOutstanding;
+    ULONGLONG Requests;             /* Read and write requests received */
+    ULONGLONG Transfers;            /* Transfers sent to the lower driver */
+    ULONGLONG MergedRequests;       /* Requests carried by another request's transfer */
+    ULONGLONG MergedBytes;
+    ULONGLONG MergeFailures;        /* Merged transfers that failed and were reissued one by one */
+    ULONGLONG DeadlineDispatches;   /* Requests dispatched out of disk order on their deadline */
+    ULONGLONG TotalQueueTime;       /* From arrival to dispatch */
+    ULONGLONG TotalLatency;         /* From arrival to completion */
+    ULONG MaxLatency;
+    ULONG Reserved;
+} CLASS_REQUEST_QUEUE_STATISTICS, *PCLASS_REQUEST_QUEUE_STATISTICS;
@@ -69,7 +69,7 @@ typedef struct _USBPORT_ENDPOINT_PROPERTIES {
   USHORT EndpointAddress;
   USHORT TotalMaxPacketSize; // TransactionPerMicroframe * MaxPacketSize
   UCHAR Period;
-  UCHAR Reserved1;
+  UCHAR RootPortNumber; // xHCI only
   USB_DEVICE_SPEED DeviceSpeed;
   ULONG UsbBandwidth;
   ULONG ScheduleOffset;
@@ -78,7 +78,7 @@ typedef struct _USBPORT_ENDPOINT_PROPERTIES {
   ULONG_PTR BufferVA;
   ULONG BufferPA;
   ULONG BufferLength;
-  ULONG Reserved3;
+  ULONG RouteString; // xHCI only. Hub ports below the root port, 4 bits per tier
   ULONG MaxTransferSize;
   USHORT HubAddr;
   USHORT PortNumber;
@@ -285,6 +285,7 @@ typedef MPSTATUS
   PVOID,
   PUSHORT);
 
+#define USB20_PORT_STATUS_RESERVED1_SUPER_SPEED        (1 << 1)
 #define USB20_PORT_STATUS_RESERVED1_OWNED_BY_COMPANION (1 << 2)
 
 typedef MPSTATUS
@@ -116,6 +116,21 @@
 C_ASSERT((FAST486_CACHE_SIZE >= sizeof(ULONG))
          && (FAST486_CACHE_SIZE <= FAST486_PAGE_SIZE));
 
+/*
+ * The decode cache keeps the already decoded prefixes and opcode of recently
+ * executed instructions, indexed by linear address and tagged with the code
+ * segment size, which changes how they decode. Its size must be a power
+ * of two. Writes to memory are checked against a hashed filter of the
+ * 256-byte blocks that contain cached code.
+ */
+#define FAST486_DECODE_CACHE_SIZE   4096
+#define FAST486_DECODE_FILTER_SIZE  8192
+#define FAST486_DECODE_BLOCK_SHIFT  8
+#define FAST486_MAX_INST_LENGTH     15
+
+C_ASSERT(((FAST486_DECODE_CACHE_SIZE & (FAST486_DECODE_CACHE_SIZE - 1)) == 0)
+         && ((FAST486_DECODE_FILTER_SIZE & (FAST486_DECODE_FILTER_SIZE - 1)) == 0));
+
 struct _FAST486_STATE;
 typedef struct _FAST486_STATE FAST486_STATE, *PFAST486_STATE;
 
@@ -459,6 +474,21 @@ typedef union _FAST486_FLAGS_REG
     };
 } FAST486_FLAGS_REG, *PFAST486_FLAGS_REG;
 
+typedef struct _FAST486_DECODED_INST
+{
+    ULONG Address;
+    ULONG Generation;
+    ULONG PrefixFlags;
+    UCHAR Opcode;
+    UCHAR Length;
+    UCHAR SegmentOverride;
+    UCHAR ModRmLength;
+    UCHAR ModRm;
+    UCHAR Sib;
+    UCHAR CodeSize;
+    LONG Displacement;
+} FAST486_DECODED_INST, *PFAST486_DECODED_INST;
+
 typedef struct _FAST486_FPU_DATA_REG
 {
     ULONGLONG Mantissa;
@@ -544,6 +574,12 @@ struct _FAST486_STATE
     ULONG PrefetchAddress;
     UCHAR PrefetchCache[FAST486_CACHE_SIZE];
 #endif
+#ifndef FAST486_NO_DECODE_CACHE
+    ULONG DecodeGeneration;
+    PFAST486_DECODED_INST CurrentDecoded;
+    ULONG DecodeFilter[FAST486_DECODE_FILTER_SIZE / 32];
+    FAST486_DECODED_INST DecodeCache[FAST486_DECODE_CACHE_SIZE];
+#endif
 #ifndef FAST486_NO_FPU
     FAST486_FPU_DATA_REG FpuRegisters[FAST486_NUM_FPU_REGS];
     FAST486_FPU_STATUS_REG FpuStatus;
@@ -111,6 +111,8 @@ typedef enum _CONSRV_API_NUMBER
     // ConsolepSetScreenBufferInfo,            // Added in Vista+
     // ConsolepClientConnect,                  // Added in Win7
 
+    ConsolepMapOutputRing,                  // ReactOS-specific
+
     ConsolepMaxApiNumber
 } CONSRV_API_NUMBER, *PCONSRV_API_NUMBER;
 
@@ -250,6 +252,40 @@ typedef struct _CONSOLE_WRITECONSOLE
     CHAR Reserved2[6];
 } CONSOLE_WRITECONSOLE, *PCONSOLE_WRITECONSOLE;
 
+/*
+ * Shared output ring, mapped both in CSRSS and in the client process.
+ * The client appends WriteConsole records to it without issuing a CSR call
+ * for each of them, and the server drains it in batches. WriteOffset is
+ * only modified by the client and ReadOffset only by the server; both are
+ * free-running counters, their difference is the number of used bytes.
+ */
+#define CONSOLE_OUTPUT_RING_SIZE        0x10000 // Must be a power of two
+#define CONSOLE_OUTPUT_RING_ALIGNMENT   sizeof(CONSOLE_OUTPUT_RING_RECORD)
+
+typedef struct _CONSOLE_OUTPUT_RING_RECORD
+{
+    ULONG Length;       // Total length of the record, header included and aligned
+    ULONG NumBytes;     // Size of the string following the header; 0 for padding up to the end of the ring
+    ULONG OutputHandle; // Console screen-buffer handle
+    ULONG Unicode;
+} CONSOLE_OUTPUT_RING_RECORD, *PCONSOLE_OUTPUT_RING_RECORD;
+
+typedef struct _CONSOLE_OUTPUT_RING
+{
+    ULONG Size;                 // Size of the Data area
+    volatile ULONG WriteOffset;
+    volatile ULONG ReadOffset;
+    volatile LONG  WakePending; // Set by the client when it signals the ring event
+    UCHAR Data[ANYSIZE_ARRAY];
+} CONSOLE_OUTPUT_RING, *PCONSOLE_OUTPUT_RING;
+
+typedef struct _CONSOLE_MAPOUTPUTRING
+{
+    HANDLE ConsoleHandle;
+    PCONSOLE_OUTPUT_RING Ring;  // Client-side view of the ring
+    HANDLE Event;               // Signaled by the client when new records are available
+} CONSOLE_MAPOUTPUTRING, *PCONSOLE_MAPOUTPUTRING;
+
 typedef struct _CONSOLE_READCONSOLE
 {
     HANDLE ConsoleHandle;
@@ -969,6 +1005,7 @@ typedef struct _CONSOLE_API_MESSAGE
         CONSOLE_WRITEINPUT WriteInputRequest;
         CONSOLE_WRITEOUTPUT WriteOutputRequest;
         CONSOLE_WRITEOUTPUTCODE WriteOutputCodeRequest;
+        CONSOLE_MAPOUTPUTRING MapOutputRingRequest;
 
         CONSOLE_FILLOUTPUTCODE FillOutputRequest;
         CONSOLE_SETTEXTATTRIB SetTextAttribRequest;
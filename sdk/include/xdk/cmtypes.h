@@ -154,7 +154,7 @@ typedef struct _CM_PARTIAL_RESOURCE_DESCRIPTOR {
       ULONG Vector;
       KAFFINITY Affinity;
     } Interrupt;
-#if (NTDDI_VERSION >= NTDDI_LONGHORN)
+#if (NTDDI_VERSION >= NTDDI_LONGHORN) || defined(__REACTOS__)
     struct {
       _ANONYMOUS_UNION union {
         struct {
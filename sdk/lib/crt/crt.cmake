@@ -401,6 +401,7 @@ if(ARCH STREQUAL "i386")
         mem/i386/memmove_asm.s
         mem/i386/memset_asm.s
         misc/i386/readcr4.S
+        misc/i386/simdlevel.S
         setjmp/i386/setjmp.s
         string/i386/strcat_asm.s
         string/i386/strchr_asm.s
@@ -472,7 +473,11 @@ elseif(ARCH STREQUAL "amd64")
         math/amd64/sqrt.S
         # math/amd64/sqrtf.S
         math/amd64/tan.S
-        setjmp/amd64/setjmp.s)
+        mem/amd64/memchr_asm.s
+        misc/amd64/simdlevel.S
+        setjmp/amd64/setjmp.s
+        string/amd64/strlen_asm.s
+        string/amd64/wcslen_asm.s)
 
     list(APPEND CRT_SOURCE
         except/amd64/ehandler.c
@@ -493,6 +498,9 @@ elseif(ARCH STREQUAL "arm")
         math/arm/__rt_sdiv64_worker.c
         math/arm/__rt_udiv.c
         math/arm/__rt_udiv64_worker.c
+        mem/memchr.c
+        string/strlen.c
+        string/wcslen.c
     )
     list(APPEND CRT_WINE_SOURCE
         wine/except_arm.c
@@ -564,7 +572,6 @@ if(NOT ARCH STREQUAL "i386")
         math/tanf.c
         math/tanhf.c
         math/stubs.c
-        mem/memchr.c
         mem/memcpy.c
         mem/memmove.c
         mem/memset.c
@@ -572,7 +579,6 @@ if(NOT ARCH STREQUAL "i386")
         string/strchr.c
         string/strcmp.c
         string/strcpy.c
-        string/strlen.c
         string/strncat.c
         string/strncmp.c
         string/strncpy.c
@@ -582,7 +588,6 @@ if(NOT ARCH STREQUAL "i386")
         string/wcschr.c
         string/wcscmp.c
         string/wcscpy.c
-        string/wcslen.c
         string/wcsncat.c
         string/wcsncmp.c
         string/wcsncpy.c
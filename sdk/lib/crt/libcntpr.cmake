@@ -97,7 +97,8 @@ if(ARCH STREQUAL "i386")
         math/i386/sin_asm.s
         math/i386/sqrt_asm.s
         math/i386/tan_asm.s
-        misc/i386/readcr4.S)
+        misc/i386/readcr4.S
+        misc/i386/simdlevel.S)
 
     list(APPEND LIBCNTPR_SOURCE
         math/i386/ci.c
@@ -128,7 +129,11 @@ elseif(ARCH STREQUAL "amd64")
         math/amd64/log10.S
         math/amd64/pow.S
         math/amd64/sqrt.S
-        math/amd64/tan.S)
+        math/amd64/tan.S
+        mem/amd64/memchr_asm.s
+        misc/amd64/simdlevel.S
+        string/amd64/strlen_asm.s
+        string/amd64/wcslen_asm.s)
     list(APPEND LIBCNTPR_SOURCE
         except/amd64/ehandler.c
         math/cos.c
@@ -141,6 +146,9 @@ elseif(ARCH STREQUAL "arm")
         math/arm/__rt_sdiv64_worker.c
         math/arm/__rt_udiv.c
         math/arm/__rt_udiv64_worker.c
+        mem/memchr.c
+        string/strlen.c
+        string/wcslen.c
     )
     list(APPEND LIBCNTPR_ASM_SOURCE
         except/arm/_abnormal_termination.s
@@ -211,7 +219,6 @@ else()
         math/cos.c
         math/sin.c
         math/sqrt.c
-        mem/memchr.c
         mem/memcpy.c
         mem/memmove.c
         mem/memset.c
@@ -219,7 +226,6 @@ else()
         string/strchr.c
         string/strcmp.c
         string/strcpy.c
-        string/strlen.c
         string/strncat.c
         string/strncmp.c
         string/strncpy.c
@@ -229,7 +235,6 @@ else()
         string/wcschr.c
         string/wcscmp.c
         string/wcscpy.c
-        string/wcslen.c
         string/wcsncat.c
         string/wcsncmp.c
         string/wcsncpy.c
@@ -0,0 +1,150 @@
+/*
+ * PROJECT:     ReactOS CRT library
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Implementation of memchr for amd64
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <asm.inc>
+
+.code64
+
+EXTERN CrtSimdLevel:PROC
+
+.data
+
+/* Picked on the first call, see memchr_resolve */
+memchr_dispatch:
+    .quad memchr_resolve
+
+.code
+
+/*
+ * void *memchr(const void *s <rcx>, int c <edx>, size_t n <r8>);
+ */
+PUBLIC memchr
+FUNC memchr
+    .endprolog
+    jmp qword ptr memchr_dispatch[rip]
+ENDFUNC
+
+FUNC memchr_resolve
+    sub rsp, 40
+    .allocstack 40
+    .endprolog
+    mov [rsp + 48], rcx
+    mov [rsp + 56], rdx
+    mov [rsp + 64], r8
+    call CrtSimdLevel
+    mov rcx, [rsp + 48]
+    mov rdx, [rsp + 56]
+    mov r8, [rsp + 64]
+    lea r9, memchr_sse2[rip]
+    cmp eax, 2
+    jb .Lresolved
+    lea r9, memchr_avx2[rip]
+.Lresolved:
+    mov memchr_dispatch[rip], r9
+    add rsp, 40
+    jmp r9
+ENDFUNC
+
+/*
+ * Only aligned blocks are loaded. Matches in front of the buffer are masked
+ * out and the ones past its end are rejected against the remaining count.
+ */
+FUNC memchr_sse2
+    .endprolog
+    test r8, r8
+    jz .Lsse2_notfound
+
+    /* Broadcast the byte we are looking for */
+    movzx edx, dl
+    movd xmm0, edx
+    punpcklbw xmm0, xmm0
+    punpcklwd xmm0, xmm0
+    pshufd xmm0, xmm0, 0
+
+    /* Count the remaining bytes from the start of the aligned block */
+    mov rax, rcx
+    and rax, -16
+    and ecx, 15
+    add r8, rcx
+    jnc .Lsse2_first
+    or r8, -1
+.Lsse2_first:
+    movdqa xmm1, [rax]
+    pcmpeqb xmm1, xmm0
+    pmovmskb edx, xmm1
+    shr edx, cl
+    shl edx, cl
+
+.Lsse2_check:
+    test edx, edx
+    jnz .Lsse2_found
+    sub r8, 16
+    jbe .Lsse2_notfound
+    add rax, 16
+    movdqa xmm1, [rax]
+    pcmpeqb xmm1, xmm0
+    pmovmskb edx, xmm1
+    jmp .Lsse2_check
+
+.Lsse2_found:
+    bsf edx, edx
+    cmp rdx, r8
+    jae .Lsse2_notfound
+    add rax, rdx
+    ret
+
+.Lsse2_notfound:
+    xor eax, eax
+    ret
+ENDFUNC
+
+FUNC memchr_avx2
+    .endprolog
+    test r8, r8
+    jz .Lavx2_notfound
+
+    movzx edx, dl
+    vmovd xmm0, edx
+    vpbroadcastb ymm0, xmm0
+
+    mov rax, rcx
+    and rax, -32
+    and ecx, 31
+    add r8, rcx
+    jnc .Lavx2_first
+    or r8, -1
+.Lavx2_first:
+    vpcmpeqb ymm1, ymm0, [rax]
+    vpmovmskb edx, ymm1
+    shr edx, cl
+    shl edx, cl
+
+.Lavx2_check:
+    test edx, edx
+    jnz .Lavx2_found
+    sub r8, 32
+    jbe .Lavx2_notfound
+    add rax, 32
+    vpcmpeqb ymm1, ymm0, [rax]
+    vpmovmskb edx, ymm1
+    jmp .Lavx2_check
+
+.Lavx2_found:
+    bsf edx, edx
+    cmp rdx, r8
+    jae .Lavx2_notfound
+    add rax, rdx
+    vzeroupper
+    ret
+
+.Lavx2_notfound:
+    xor eax, eax
+    vzeroupper
+    ret
+ENDFUNC
+
+END
@@ -12,9 +12,38 @@
  */
 
 PUBLIC	_memchr
+
+EXTERN _CrtSimdLevel:PROC
+
+.data
+ASSUME nothing
+
+/* Picked on the first call, see _memchr_resolve */
+_memchr_dispatch:
+	.long _memchr_resolve
+
 .code
 
 FUNC _memchr
+	FPO 0, 3, 0, 0, 0, FRAME_FPO
+	jmp dword ptr [_memchr_dispatch]
+ENDFUNC
+
+FUNC _memchr_resolve
+	FPO 0, 3, 0, 0, 0, FRAME_FPO
+	call _CrtSimdLevel
+	mov ecx, offset _memchr_generic
+	cmp eax, 1
+	jb .Lresolved
+	mov ecx, offset _memchr_sse2
+	je .Lresolved
+	mov ecx, offset _memchr_avx2
+.Lresolved:
+	mov dword ptr [_memchr_dispatch], ecx
+	jmp ecx
+ENDFUNC
+
+FUNC _memchr_generic
 	FPO 0, 3, 4, 1, 1, FRAME_NONFPO
 	push ebp
 	mov ebp, esp
@@ -36,4 +65,112 @@ FUNC _memchr
 	ret
 ENDFUNC
 
+/*
+ * Only aligned blocks are loaded. Matches in front of the buffer are masked
+ * out and the ones past its end are rejected against the remaining count.
+ */
+FUNC _memchr_sse2
+	FPO 0, 3, 1, 1, 0, FRAME_FPO
+	push ebx
+	mov edx, [esp + 16]
+	test edx, edx
+	jz .Lsse2_notfound
+
+	/* Broadcast the byte we are looking for */
+	movzx eax, byte ptr [esp + 12]
+	movd xmm0, eax
+	punpcklbw xmm0, xmm0
+	punpcklwd xmm0, xmm0
+	pshufd xmm0, xmm0, 0
+
+	/* Count the remaining bytes from the start of the aligned block */
+	mov eax, [esp + 8]
+	mov ecx, eax
+	and eax, -16
+	and ecx, 15
+	add edx, ecx
+	jnc .Lsse2_first
+	or edx, -1
+.Lsse2_first:
+	movdqa xmm1, [eax]
+	pcmpeqb xmm1, xmm0
+	pmovmskb ebx, xmm1
+	shr ebx, cl
+	shl ebx, cl
+
+.Lsse2_check:
+	test ebx, ebx
+	jnz .Lsse2_found
+	sub edx, 16
+	jbe .Lsse2_notfound
+	add eax, 16
+	movdqa xmm1, [eax]
+	pcmpeqb xmm1, xmm0
+	pmovmskb ebx, xmm1
+	jmp .Lsse2_check
+
+.Lsse2_found:
+	bsf ebx, ebx
+	cmp ebx, edx
+	jae .Lsse2_notfound
+	add eax, ebx
+	pop ebx
+	ret
+
+.Lsse2_notfound:
+	xor eax, eax
+	pop ebx
+	ret
+ENDFUNC
+
+FUNC _memchr_avx2
+	FPO 0, 3, 1, 1, 0, FRAME_FPO
+	push ebx
+	mov edx, [esp + 16]
+	test edx, edx
+	jz .Lavx2_notfound
+
+	movzx eax, byte ptr [esp + 12]
+	vmovd xmm0, eax
+	vpbroadcastb ymm0, xmm0
+
+	mov eax, [esp + 8]
+	mov ecx, eax
+	and eax, -32
+	and ecx, 31
+	add edx, ecx
+	jnc .Lavx2_first
+	or edx, -1
+.Lavx2_first:
+	vpcmpeqb ymm1, ymm0, [eax]
+	vpmovmskb ebx, ymm1
+	shr ebx, cl
+	shl ebx, cl
+
+.Lavx2_check:
+	test ebx, ebx
+	jnz .Lavx2_found
+	sub edx, 32
+	jbe .Lavx2_notfound
+	add eax, 32
+	vpcmpeqb ymm1, ymm0, [eax]
+	vpmovmskb ebx, ymm1
+	jmp .Lavx2_check
+
+.Lavx2_found:
+	bsf ebx, ebx
+	cmp ebx, edx
+	jae .Lavx2_notfound
+	add eax, ebx
+	vzeroupper
+	pop ebx
+	ret
+
+.Lavx2_notfound:
+	xor eax, eax
+	vzeroupper
+	pop ebx
+	ret
+ENDFUNC
+
 END
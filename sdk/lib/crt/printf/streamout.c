@@ -20,7 +20,12 @@
 #endif
 
 #define MB_CUR_MAX 10
+#ifdef _USER32_WSPRINTF
 #define BUFFER_SIZE (32 + 17)
+#else
+/* Room for the integer part of DBL_MAX in %f and some decimals */
+#define BUFFER_SIZE (DBL_MAX_10_EXP + 1 + 1 + 40)
+#endif
 
 int mbtowc(wchar_t *wchar, const char *mbchar, size_t count);
 int wctomb(char *mbchar, wchar_t wchar);
@@ -68,11 +73,257 @@ enum
     (flags & FLAG_LONGDOUBLE) ? va_arg(argptr, long double) : \
     va_arg(argptr, double)
 
-#define get_exp(f) (int)floor(f == 0 ? 0 : (f >= 0 ? log10(f) : log10(-f)))
-#define round(x) floor((x) + 0.5)
-
 #ifndef _USER32_WSPRINTF
 
+/* msvcrt prints at most 17 significant digits, the rest are zeroes */
+#define FLOAT_DIGITS 17
+
+/* Enough 32 bit words for any double scaled by a power of ten, ~2^1130 */
+#define BIGNUM_WORDS 40
+
+typedef struct _BIGNUM
+{
+    unsigned int Length;
+    unsigned int Words[BIGNUM_WORDS];
+} BIGNUM;
+
+static
+void
+bignum_set(BIGNUM *num, unsigned __int64 value)
+{
+    num->Words[0] = (unsigned int)value;
+    num->Words[1] = (unsigned int)(value >> 32);
+    num->Length = num->Words[1] ? 2 : (num->Words[0] ? 1 : 0);
+}
+
+static
+void
+bignum_mul(BIGNUM *num, unsigned int factor)
+{
+    unsigned __int64 carry = 0;
+    unsigned int i;
+
+    for (i = 0; i < num->Length; i++)
+    {
+        carry += (unsigned __int64)num->Words[i] * factor;
+        num->Words[i] = (unsigned int)carry;
+        carry >>= 32;
+    }
+
+    if (carry) num->Words[num->Length++] = (unsigned int)carry;
+}
+
+static
+void
+bignum_mul_pow10(BIGNUM *num, int power)
+{
+    static const unsigned int pow10[] =
+        {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+    for (; power >= 9; power -= 9) bignum_mul(num, pow10[9]);
+    if (power > 0) bignum_mul(num, pow10[power]);
+}
+
+static
+void
+bignum_shl(BIGNUM *num, unsigned int shift)
+{
+    unsigned int words = shift / 32, bits = shift % 32, i;
+
+    if (num->Length == 0) return;
+
+    if (bits)
+    {
+        num->Words[num->Length] = 0;
+        for (i = num->Length; i > 0; i--)
+        {
+            num->Words[i] |= num->Words[i - 1] >> (32 - bits);
+            num->Words[i - 1] <<= bits;
+        }
+        if (num->Words[num->Length]) num->Length++;
+    }
+
+    if (words)
+    {
+        for (i = num->Length; i > 0; i--) num->Words[i - 1 + words] = num->Words[i - 1];
+        for (i = 0; i < words; i++) num->Words[i] = 0;
+        num->Length += words;
+    }
+}
+
+static
+int
+bignum_cmp(const BIGNUM *a, const BIGNUM *b)
+{
+    unsigned int i;
+
+    if (a->Length != b->Length) return a->Length < b->Length ? -1 : 1;
+
+    for (i = a->Length; i > 0; i--)
+    {
+        if (a->Words[i - 1] != b->Words[i - 1])
+            return a->Words[i - 1] < b->Words[i - 1] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/* a -= b, a must not be smaller than b */
+static
+void
+bignum_sub(BIGNUM *a, const BIGNUM *b)
+{
+    unsigned __int64 diff;
+    unsigned int i, borrow = 0;
+
+    for (i = 0; i < a->Length; i++)
+    {
+        diff = (unsigned __int64)a->Words[i] - (i < b->Length ? b->Words[i] : 0) - borrow;
+        a->Words[i] = (unsigned int)diff;
+        borrow = (unsigned int)(diff >> 63);
+    }
+
+    while (a->Length && a->Words[a->Length - 1] == 0) a->Length--;
+}
+
+/*
+ * Calculates the decimal digits of a finite non-zero double exactly and
+ * returns the decimal exponent of the first one. Only count significant
+ * digits plus one to round from are generated, or count digits after the
+ * decimal point if fixed is set, the rest is zeroed. The sign is ignored.
+ */
+static
+int
+float_to_digits(double fpval, int count, int fixed, char *digits)
+{
+    union
+    {
+        double d;
+        unsigned __int64 u;
+    } bits;
+    unsigned __int64 mantissa, num64, den64;
+    int exponent, exp10, log2, i;
+    BIGNUM num, den, den10;
+
+    bits.d = fpval;
+    mantissa = bits.u & (((unsigned __int64)1 << 52) - 1);
+    exponent = (int)(bits.u >> 52) & 0x7ff;
+    if (exponent)
+    {
+        mantissa |= (unsigned __int64)1 << 52;
+        exponent -= 1075;
+    }
+    else exponent = -1074;
+
+    /* The value is num / den */
+    bignum_set(&num, mantissa);
+    bignum_set(&den, 1);
+    if (exponent > 0) bignum_shl(&num, exponent);
+    else bignum_shl(&den, -exponent);
+
+    /* Estimate the decimal exponent from the binary one, 1233 / 4096 ~ log10(2) */
+    for (log2 = exponent - 1; mantissa; mantissa >>= 1) log2++;
+    exp10 = log2 * 1233 / 4096;
+
+    /* Scale the value by 10^-exp10 and correct the estimate if it was off */
+    if (exp10 >= 0) bignum_mul_pow10(&den, exp10);
+    else bignum_mul_pow10(&num, -exp10);
+
+    while (bignum_cmp(&num, &den) < 0)
+    {
+        bignum_mul(&num, 10);
+        exp10--;
+    }
+
+    for (;;)
+    {
+        den10 = den;
+        bignum_mul(&den10, 10);
+        if (bignum_cmp(&num, &den10) < 0) break;
+        den = den10;
+        exp10++;
+    }
+
+    /* Generate just what the rounding looks at */
+    if (fixed) count += exp10 + 1;
+    if (count < 0) count = 0;
+    else if (count > FLOAT_DIGITS) count = FLOAT_DIGITS;
+    for (i = count + 1; i <= FLOAT_DIGITS; i++) digits[i] = 0;
+
+    /* Now 1 <= num / den < 10. For most values in practice den is small
+       enough to do the rest natively, 10 * num must not overflow */
+    if (den.Length == 1 || (den.Length == 2 && den.Words[1] < 0x02000000))
+    {
+        num64 = num.Words[0];
+        if (num.Length == 2) num64 |= (unsigned __int64)num.Words[1] << 32;
+        den64 = den.Words[0];
+        if (den.Length == 2) den64 |= (unsigned __int64)den.Words[1] << 32;
+
+        for (i = 0; i <= count; i++)
+        {
+            digits[i] = (char)(num64 / den64);
+            num64 = (num64 % den64) * 10;
+        }
+
+        return exp10;
+    }
+
+    /* Otherwise peel off one digit at a time */
+    for (i = 0; i <= count; i++)
+    {
+        digits[i] = 0;
+        while (bignum_cmp(&num, &den) >= 0)
+        {
+            bignum_sub(&num, &den);
+            digits[i]++;
+        }
+        bignum_mul(&num, 10);
+    }
+
+    return exp10;
+}
+
+/*
+ * Rounds the digits to count significant ones, halfway cases away from zero
+ * like msvcrt. Returns the decimal exponent, which changes when the rounding
+ * carries over, e.g. 9.99 -> 10.0.
+ */
+static
+int
+round_digits(char *digits, int count, int exp10)
+{
+    int i, round_up;
+
+    if (count > FLOAT_DIGITS) count = FLOAT_DIGITS;
+
+    if (count < 0)
+    {
+        /* Nothing is left, not even a digit to round from */
+        for (i = 0; i <= FLOAT_DIGITS; i++) digits[i] = 0;
+        return exp10;
+    }
+
+    round_up = digits[count] >= 5;
+    for (i = count; i <= FLOAT_DIGITS; i++) digits[i] = 0;
+
+    if (round_up)
+    {
+        for (i = count - 1; i >= 0; i--)
+        {
+            if (++digits[i] < 10) return exp10;
+            digits[i] = 0;
+        }
+
+        digits[0] = 1;
+        exp10++;
+    }
+
+    return exp10;
+}
+
+#define get_digit(digits, i) \
+    ((i) >= 0 && (i) <= FLOAT_DIGITS ? (digits)[i] : 0)
+
 void
 #ifdef _LIBCNT_
 /* Due to restrictions in kernel mode regarding the use of floating point,
@@ -87,140 +338,157 @@ format_float(
     const TCHAR **prefix,
     va_list *argptr)
 {
-    static const TCHAR digits_l[] = _T("0123456789abcdef0x");
-    static const TCHAR digits_u[] = _T("0123456789ABCDEF0X");
     static const TCHAR _nan[] = _T("#QNAN");
     static const TCHAR _infinity[] = _T("#INF");
-    const TCHAR *digits = digits_l;
-    int exponent = 0, sign;
-    long double fpval, fpval2;
-    int padding = 0, num_digits, val32, base = 10;
+    char digits[FLOAT_DIGITS + 1];
+    TCHAR exp_char = _T('e');
+    int exponent = 0, exp_style = 0, fixed = 0, count, num_digits, val32, i;
+    double fpval;
 
     /* Normalize the precision */
     if (precision < 0) precision = 6;
-    else if (precision > 17)
+
+    /* Get the float value */
+    fpval = va_arg_ffp(*argptr, flags);
+
+    /* Handle sign */
+    if (fpval < 0)
     {
-        padding = precision - 17;
-        precision = 17;
+        *prefix = _T("-");
     }
+    else if (flags & FLAG_FORCE_SIGN)
+        *prefix = _T("+");
+    else if (flags & FLAG_FORCE_SIGNSP)
+        *prefix = _T(" ");
 
-    /* Get the float value and calculate the exponent */
-    fpval = va_arg_ffp(*argptr, flags);
-    exponent = get_exp(fpval);
-    sign = fpval < 0 ? -1 : 1;
+    /* Handle special cases first */
+    if (_isnan(fpval) || !_finite(fpval))
+    {
+        if (_isnan(fpval))
+        {
+            (*string) -= sizeof(_nan) / sizeof(TCHAR) - 1;
+            _tcscpy((*string), _nan);
+        }
+        else
+        {
+            (*string) -= sizeof(_infinity) / sizeof(TCHAR) - 1;
+            _tcscpy((*string), _infinity);
+        }
+
+        if (precision > 0 || flags & FLAG_SPECIAL)
+            *--(*string) = _T('.');
+        *--(*string) = _T('1');
+        return;
+    }
 
+    /* %f counts the digits after the decimal point, the others the
+       significant ones */
     switch (chr)
     {
         case _T('G'):
-            digits = digits_u;
+            exp_char = _T('E');
         case _T('g'):
-            if (precision > 0) precision--;
-            if (exponent < -4 || exponent >= precision) goto case_e;
-
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision));
-
-            /* Skip trailing zeroes */
-            while (precision && (unsigned __int64)fpval2 % 10 == 0)
-            {
-                precision--;
-                fpval2 /= 10;
-            }
+            if (precision == 0) precision = 1;
+            count = precision;
             break;
 
         case _T('E'):
-            digits = digits_u;
+            exp_char = _T('E');
         case _T('e'):
-        case_e:
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision - exponent));
-
-            /* Compensate for changed exponent through rounding */
-            if (fpval2 >= (unsigned __int64)pow(10., precision + 1))
-            {
-                exponent++;
-                fpval2 = round(sign * fpval * pow(10., precision - exponent));
-            }
-
-            val32 = exponent >= 0 ? exponent : -exponent;
-
-            // FIXME: handle length of exponent field:
-            // http://msdn.microsoft.com/de-de/library/0fatw238%28VS.80%29.aspx
-            num_digits = 3;
-            while (num_digits--)
-            {
-                *--(*string) = digits[val32 % 10];
-                val32 /= 10;
-            }
-
-            /* Sign for the exponent */
-            *--(*string) = exponent >= 0 ? _T('+') : _T('-');
-
-            /* Add 'e' or 'E' separator */
-            *--(*string) = digits[0xe];
+            count = precision + 1;
+            exp_style = 1;
             break;
 
         case _T('A'):
-            digits = digits_u;
         case _T('a'):
-//            base = 16;
             // FIXME: TODO
 
         case _T('f'):
         default:
-            /* Shift the decimal point and round */
-            fpval2 = round(sign * fpval * pow(10., precision));
+            count = precision;
+            fixed = 1;
             break;
     }
 
-    /* Handle sign */
-    if (fpval < 0)
+    /* Get the exact digits, rounding happens on them and not on the double */
+    if (fpval == 0)
     {
-        *prefix = _T("-");
+        for (i = 0; i <= FLOAT_DIGITS; i++) digits[i] = 0;
     }
-    else if (flags & FLAG_FORCE_SIGN)
-        *prefix = _T("+");
-    else if (flags & FLAG_FORCE_SIGNSP)
-        *prefix = _T(" ");
+    else exponent = float_to_digits(fpval, count, fixed, digits);
 
-    /* Handle special cases first */
-    if (_isnan(fpval))
-    {
-        (*string) -= sizeof(_nan) / sizeof(TCHAR) - 1;
-        _tcscpy((*string), _nan);
-        fpval2 = 1;
-    }
-    else if (!_finite(fpval))
+    if (fixed) count += exponent + 1;
+    exponent = round_digits(digits, count, exponent);
+
+    if (chr == _T('g') || chr == _T('G'))
     {
-        (*string) -= sizeof(_infinity) / sizeof(TCHAR) - 1;
-        _tcscpy((*string), _infinity);
-        fpval2 = 1;
+        if (exponent < -4 || exponent >= precision)
+        {
+            exp_style = 1;
+            precision--;
+            i = precision;
+        }
+        else
+        {
+            precision -= exponent + 1;
+            i = exponent + precision;
+        }
+
+        /* Skip trailing zeroes, i is the last digit after the point */
+        if (!(flags & FLAG_SPECIAL))
+        {
+            while (precision > 0 && get_digit(digits, i) == 0)
+            {
+                precision--;
+                i--;
+            }
+        }
     }
-    else
+
+    if (exp_style)
     {
-        /* Zero padding */
-        while (padding-- > 0) *--(*string) = _T('0');
+        /* Stay inside the buffer, "d." and "e+ddd" take 7 characters */
+        if (precision > BUFFER_SIZE - 7) precision = BUFFER_SIZE - 7;
+
+        val32 = exponent >= 0 ? exponent : -exponent;
 
-        /* Digits after the decimal point */
-        num_digits = precision;
-        while (num_digits-- > 0)
+        // FIXME: handle length of exponent field:
+        // http://msdn.microsoft.com/de-de/library/0fatw238%28VS.80%29.aspx
+        num_digits = 3;
+        while (num_digits--)
         {
-            *--(*string) = digits[(unsigned __int64)fpval2 % 10];
-            fpval2 /= base;
+            *--(*string) = _T('0') + val32 % 10;
+            val32 /= 10;
         }
+
+        /* Sign for the exponent */
+        *--(*string) = exponent >= 0 ? _T('+') : _T('-');
+
+        /* Add 'e' or 'E' separator */
+        *--(*string) = exp_char;
+
+        /* The digits are printed relative to the first one */
+        exponent = 0;
+    }
+    else
+    {
+        /* Stay inside the buffer */
+        num_digits = exponent >= 0 ? exponent + 1 : 1;
+        if (precision > BUFFER_SIZE - 1 - num_digits)
+            precision = BUFFER_SIZE - 1 - num_digits;
     }
 
+    /* Digits after the decimal point */
+    for (i = exponent + precision; i > exponent; i--)
+        *--(*string) = _T('0') + get_digit(digits, i);
+
     if (precision > 0 || flags & FLAG_SPECIAL)
         *--(*string) = _T('.');
 
     /* Digits before the decimal point */
-    do
-    {
-        *--(*string) = digits[(unsigned __int64)fpval2 % base];
-        fpval2 /= base;
-    }
-    while ((unsigned __int64)fpval2);
-
+    if (exponent < 0) *--(*string) = _T('0');
+    for (i = exponent; i >= 0; i--)
+        *--(*string) = _T('0') + get_digit(digits, i);
 }
 #endif
 
@@ -327,12 +595,24 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
 {
     static const TCHAR digits_l[] = _T("0123456789abcdef0x");
     static const TCHAR digits_u[] = _T("0123456789ABCDEF0X");
+    static const TCHAR digit_pairs[] =
+        _T("00010203040506070809")
+        _T("10111213141516171819")
+        _T("20212223242526272829")
+        _T("30313233343536373839")
+        _T("40414243444546474849")
+        _T("50515253545556575859")
+        _T("60616263646566676869")
+        _T("70717273747576777879")
+        _T("80818283848586878889")
+        _T("90919293949596979899");
     static const char *_nullstring = "(null)";
     TCHAR buffer[BUFFER_SIZE + 1];
     TCHAR chr, *string;
     STRING *nt_string;
     const TCHAR *digits, *prefix;
     int base, fieldwidth, precision, padding;
+    unsigned int val32, shift;
     size_t prefixlen, len;
     int written = 1, written_all = 0;
     unsigned int flags;
@@ -610,6 +890,15 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
             case_unsigned:
                 val64 = va_arg_fu(argptr, flags);
 
+#ifndef _USER32_WSPRINTF
+                /* '#' only prefixes nonzero values */
+                if (val64 == 0 && prefix && chr != _T('p'))
+                {
+                    if (base == 8 && precision >= 0) precision++;
+                    prefix = NULL;
+                }
+#endif
+
             case_number:
 #ifdef _UNICODE
                 flags |= FLAG_WIDECHAR;
@@ -619,14 +908,44 @@ streamout(FILE *stream, const TCHAR *format, va_list argptr)
                 if (precision < 0) precision = 1;
 
                 /* Gather digits in reverse order */
-                while (val64)
+                if (base == 10)
+                {
+                    /* Two digits per division, in 32 bits once the value fits */
+                    while (val64 > 0xffffffff)
+                    {
+                        val32 = (unsigned int)(val64 % 100);
+                        val64 /= 100;
+                        *--string = digit_pairs[2 * val32 + 1];
+                        *--string = digit_pairs[2 * val32];
+                    }
+
+                    for (val32 = (unsigned int)val64; val32 >= 100; val32 /= 100)
+                    {
+                        *--string = digit_pairs[2 * (val32 % 100) + 1];
+                        *--string = digit_pairs[2 * (val32 % 100)];
+                    }
+
+                    if (val32 >= 10)
+                    {
+                        *--string = digit_pairs[2 * val32 + 1];
+                        *--string = digit_pairs[2 * val32];
+                    }
+                    else if (val32)
+                        *--string = digits[val32];
+                }
+                else
                 {
-                    *--string = digits[val64 % base];
-                    val64 /= base;
-                    precision--;
+                    /* Octal and hex only need shifts */
+                    shift = (base == 16) ? 4 : 3;
+                    while (val64)
+                    {
+                        *--string = digits[val64 & (base - 1)];
+                        val64 >>= shift;
+                    }
                 }
 
                 len = _tcslen(string);
+                precision -= (int)len;
                 break;
 
             default:
@@ -0,0 +1,4 @@
+
+#include "tcslen.inc"
+
+/* EOF */
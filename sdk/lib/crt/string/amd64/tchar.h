@@ -0,0 +1,31 @@
+
+#ifndef __TCHAR_INC_S__
+#define __TCHAR_INC_S__
+
+#ifdef _UNICODE
+
+#define _tcslen wcslen
+#define _tcslen_dispatch wcslen_dispatch
+#define _tcslen_resolve wcslen_resolve
+#define _tcslen_sse2 wcslen_sse2
+#define _tcslen_avx2 wcslen_avx2
+
+#define _tpcmpeq pcmpeqw
+#define _tvpcmpeq vpcmpeqw
+
+#else
+
+#define _tcslen strlen
+#define _tcslen_dispatch strlen_dispatch
+#define _tcslen_resolve strlen_resolve
+#define _tcslen_sse2 strlen_sse2
+#define _tcslen_avx2 strlen_avx2
+
+#define _tpcmpeq pcmpeqb
+#define _tvpcmpeq vpcmpeqb
+
+#endif
+
+#endif
+
+/* EOF */
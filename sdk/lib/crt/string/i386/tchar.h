@@ -10,6 +10,11 @@
 #define _tcscpy _wcscpy
 #define tcscpy wcscpy
 #define _tcslen _wcslen
+#define _tcslen_dispatch _wcslen_dispatch
+#define _tcslen_resolve _wcslen_resolve
+#define _tcslen_generic _wcslen_generic
+#define _tcslen_sse2 _wcslen_sse2
+#define _tcslen_avx2 _wcslen_avx2
 #define _tcsncat _wcsncat
 #define _tcsncmp _wcsncmp
 #define _tcsncpy _wcsncpy
@@ -20,6 +25,9 @@
 #define _tlods lodsw
 #define _tstos stosw
 
+#define _tpcmpeq pcmpeqw
+#define _tvpcmpeq vpcmpeqw
+
 #define _tsize 2
 
 #define _treg(_O_) _O_ ## x
@@ -35,6 +43,11 @@
 #define _tcscpy _strcpy
 #define tcscpy strcpy
 #define _tcslen _strlen
+#define _tcslen_dispatch _strlen_dispatch
+#define _tcslen_resolve _strlen_resolve
+#define _tcslen_generic _strlen_generic
+#define _tcslen_sse2 _strlen_sse2
+#define _tcslen_avx2 _strlen_avx2
 #define _tcsncat _strncat
 #define _tcsncmp _strncmp
 #define _tcsncpy _strncpy
@@ -45,6 +58,9 @@
 #define _tlods lodsb
 #define _tstos stosb
 
+#define _tpcmpeq pcmpeqb
+#define _tvpcmpeq vpcmpeqb
+
 #define _tsize  1
 
 #define _treg(_O_) _O_ ## l
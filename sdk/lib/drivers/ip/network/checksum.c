@@ -56,6 +56,30 @@ ULONG ChecksumCompute(
   return Sum;
 }
 
+USHORT
+IPv4PseudoHeaderChecksum(
+  PIPv4_HEADER IPHeader,
+  UCHAR Protocol,
+  USHORT Length)
+/*
+ * FUNCTION: Calculate the sum of a TCP or UDP pseudo header
+ * ARGUMENTS:
+ *     IPHeader = Pointer to IPv4 header of the datagram
+ *     Protocol = Transport protocol
+ *     Length   = Length of transport header and data (0 for large send)
+ * RETURNS:
+ *     Folded sum in network byte order, the seed an adapter
+ *     expects in the checksum field when it completes the checksum
+ */
+{
+  ULONG Sum;
+
+  Sum = ChecksumCompute(&IPHeader->SrcAddr, 2 * sizeof(IPv4_RAW_ADDRESS), 0);
+  Sum += WH2N(Protocol) + WH2N(Length);
+
+  return (USHORT)ChecksumFold(Sum);
+}
+
 ULONG
 UDPv4ChecksumCalculate(
   PIPv4_HEADER IPHeader,
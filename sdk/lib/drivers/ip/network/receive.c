@@ -461,6 +461,11 @@ VOID ProcessFragment(
     /* FIXME: Assumes IPv4 */
     IPInitializePacket(&Datagram, IP_ADDRESS_V4);
 
+    /* What the adapter verified holds for a datagram that came in one piece */
+    if (FragFirst == 0 && !MoreFragments)
+        Datagram.Flags = IPPacket->Flags & (IP_PACKET_FLAG_TCP_CHECKSUM_OK |
+                                            IP_PACKET_FLAG_UDP_CHECKSUM_OK);
+
     Success = ReassembleDatagram(&Datagram, IPDR);
 
     FreeIPDR(IPDR);
@@ -611,8 +616,9 @@ VOID IPv4Receive(PIP_INTERFACE IF, PIP_PACKET IPPacket)
         return;
     }
 
-    /* Checksum IPv4 header */
-    if (!IPv4CorrectChecksum(IPPacket->Header, IPPacket->HeaderSize)) {
+    /* Checksum IPv4 header, unless the adapter did */
+    if (!(IPPacket->Flags & IP_PACKET_FLAG_IP_CHECKSUM_OK) &&
+        !IPv4CorrectChecksum(IPPacket->Header, IPPacket->HeaderSize)) {
         TI_DbgPrint(MIN_TRACE, ("Datagram received with bad checksum. Checksum field (0x%X)\n",
 	      WN2H(((PIPv4_HEADER)IPPacket->Header)->Checksum)));
         /* Discard packet */
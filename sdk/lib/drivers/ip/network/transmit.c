@@ -83,10 +83,9 @@ BOOLEAN PrepareNextFragment(
         TI_DbgPrint(MAX_TRACE, ("Preparing 1 fragment.\n"));
 
         MaxData  = IFC->PathMTU - IFC->HeaderSize;
-        /* Make fragment a multiplum of 64bit */
-        MaxData -= MaxData % 8;
         if (IFC->BytesLeft > MaxData) {
-            DataSize      = MaxData;
+            /* Make fragment a multiplum of 64bit */
+            DataSize      = MaxData - MaxData % 8;
             MoreFragments = TRUE;
         } else {
             DataSize      = IFC->BytesLeft;
@@ -112,9 +111,10 @@ BOOLEAN PrepareNextFragment(
 
         /* FIXME: Handle options */
 
-        /* Calculate checksum of IP header */
+        /* Calculate checksum of IP header, unless the adapter does */
         Header->Checksum = 0;
-        Header->Checksum = (USHORT)IPv4Checksum(Header, IFC->HeaderSize, 0);
+        if (!IFC->OffloadIpChecksum)
+            Header->Checksum = (USHORT)IPv4Checksum(Header, IFC->HeaderSize, 0);
 	TI_DbgPrint(MID_TRACE,("IP Check: %x\n", Header->Checksum));
 
         /* Update pointers */
@@ -150,6 +150,7 @@ NTSTATUS SendFragments(
     PVOID Data;
     UINT BufferSize = PathMTU, InSize;
     PCHAR InData;
+    NDIS_TCP_IP_CHECKSUM_PACKET_INFO ChecksumInfo;
 
     TI_DbgPrint(MAX_TRACE, ("Called. IPPacket (0x%X)  NCE (0x%X)  PathMTU (%d).\n",
         IPPacket, NCE, PathMTU));
@@ -188,8 +189,28 @@ NTSTATUS SendFragments(
     IFC->Position     = 0;
     IFC->BytesLeft    = IPPacket->TotalSize - IPPacket->HeaderSize;
     IFC->Data         = (PVOID)((ULONG_PTR)IFC->Header + IPPacket->HeaderSize);
+    IFC->OffloadIpChecksum = FALSE;
     KeInitializeEvent(&IFC->Event, NotificationEvent, FALSE);
 
+    /* A datagram sent in one piece keeps the offloads its transport asked
+       for. Those of a fragmented one were computed in software already. */
+    if (IPPacket->TotalSize <= PathMTU)
+    {
+        ChecksumInfo.Value = (ULONG)(ULONG_PTR)NDIS_PER_PACKET_INFO_FROM_PACKET(IPPacket->NdisPacket,
+                                                                               TcpIpChecksumPacketInfo);
+        if (NCE->Interface->OffloadFlags & IP_OFFLOAD_IP_CHECKSUM)
+        {
+            ChecksumInfo.Transmit.NdisPacketChecksumV4 = 1;
+            ChecksumInfo.Transmit.NdisPacketIpChecksum = 1;
+            IFC->OffloadIpChecksum = TRUE;
+        }
+
+        NDIS_PER_PACKET_INFO_FROM_PACKET(IFC->NdisPacket, TcpIpChecksumPacketInfo) =
+            (PVOID)(ULONG_PTR)ChecksumInfo.Value;
+        NDIS_PER_PACKET_INFO_FROM_PACKET(IFC->NdisPacket, TcpLargeSendPacketInfo) =
+            NDIS_PER_PACKET_INFO_FROM_PACKET(IPPacket->NdisPacket, TcpLargeSendPacketInfo);
+    }
+
     TI_DbgPrint(MID_TRACE,("Copying header from %x to %x (%d)\n",
 			   IPPacket->Header, IFC->Header,
 			   IPPacket->HeaderSize));
@@ -238,10 +259,40 @@ NTSTATUS IPSendDatagram(PIP_PACKET IPPacket, PNEIGHBOR_CACHE_ENTRY NCE)
 
     DISPLAY_IP_PACKET(IPPacket);
 
+    /* The adapter cuts large send segments down to the MTU itself */
+    if (NDIS_PER_PACKET_INFO_FROM_PACKET(IPPacket->NdisPacket, TcpLargeSendPacketInfo))
+        return SendFragments(IPPacket, NCE, IPPacket->TotalSize);
+
     /* Fetch path MTU now, because it may change */
     TI_DbgPrint(MID_TRACE,("PathMTU: %d\n", NCE->Interface->MTU));
 
     return SendFragments(IPPacket, NCE, NCE->Interface->MTU);
 }
 
+VOID IPSetChecksumOffload(
+    PNDIS_PACKET NdisPacket,
+    UCHAR Protocol)
+/*
+ * FUNCTION: Asks the adapter to complete the transport checksum of a datagram
+ * ARGUMENTS:
+ *     NdisPacket = Pointer to NDIS packet holding the datagram
+ *     Protocol   = IPPROTO_TCP or IPPROTO_UDP
+ * NOTES:
+ *     The checksum field must hold the pseudo header sum and the
+ *     datagram must not need fragmentation
+ */
+{
+    NDIS_TCP_IP_CHECKSUM_PACKET_INFO ChecksumInfo;
+
+    ChecksumInfo.Value = 0;
+    ChecksumInfo.Transmit.NdisPacketChecksumV4 = 1;
+    if (Protocol == IPPROTO_TCP)
+        ChecksumInfo.Transmit.NdisPacketTcpChecksum = 1;
+    else
+        ChecksumInfo.Transmit.NdisPacketUdpChecksum = 1;
+
+    NDIS_PER_PACKET_INFO_FROM_PACKET(NdisPacket, TcpIpChecksumPacketInfo) =
+        (PVOID)(ULONG_PTR)ChecksumInfo.Value;
+}
+
 /* EOF */
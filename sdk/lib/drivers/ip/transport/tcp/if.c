@@ -7,6 +7,40 @@
 #include "lwip/api.h"
 #include "lwip/tcpip.h"
 
+static VOID
+TCPCompleteChecksum(PIP_PACKET Packet, PIP_INTERFACE Interface, USHORT LargeSendMss)
+{
+    PTCPv4_HEADER TCPHeader;
+    USHORT Length;
+
+    TCPHeader = (PTCPv4_HEADER)((PCHAR)Packet->Header + Packet->HeaderSize);
+    Length = (USHORT)(Packet->TotalSize - Packet->HeaderSize);
+
+    if (LargeSendMss && (Interface->OffloadFlags & IP_OFFLOAD_LARGE_SEND))
+    {
+        /* The adapter cuts the segment down and checksums each part */
+        TCPHeader->Checksum = IPv4PseudoHeaderChecksum(Packet->Header, IPPROTO_TCP, 0);
+        NDIS_PER_PACKET_INFO_FROM_PACKET(Packet->NdisPacket,
+                                         TcpLargeSendPacketInfo) = (PVOID)((ULONG_PTR)LargeSendMss);
+    }
+    else if ((Interface->OffloadFlags & IP_OFFLOAD_TCP_CHECKSUM) &&
+             Packet->TotalSize <= Interface->MTU)
+    {
+        TCPHeader->Checksum = IPv4PseudoHeaderChecksum(Packet->Header, IPPROTO_TCP, Length);
+        IPSetChecksumOffload(Packet->NdisPacket, IPPROTO_TCP);
+    }
+    else
+    {
+        /* Routed through an interface lwIP did not expect, compute it here */
+        TCPHeader->Checksum = 0;
+        TCPHeader->Checksum = (USHORT)IPv4Checksum(TCPHeader,
+                                                   Length,
+                                                   IPv4PseudoHeaderChecksum(Packet->Header,
+                                                                            IPPROTO_TCP,
+                                                                            Length));
+    }
+}
+
 err_t
 TCPSendDataCallback(struct netif *netif, struct pbuf *p, struct ip_addr *dest)
 {
@@ -17,6 +51,7 @@ TCPSendDataCallback(struct netif *netif, struct pbuf *p, struct ip_addr *dest)
     PIPv4_HEADER Header;
     ULONG Length;
     ULONG TotalLength;
+    USHORT LargeSendMss;
 
     /* The caller frees the pbuf struct */
 
@@ -53,6 +88,7 @@ TCPSendDataCallback(struct netif *netif, struct pbuf *p, struct ip_addr *dest)
 
     ASSERT(Packet.TotalSize == p->tot_len);
 
+    LargeSendMss = p->tso_mss;
     TotalLength = p->tot_len;
     Length = 0;
     while (Length < TotalLength)
@@ -70,6 +106,13 @@ TCPSendDataCallback(struct netif *netif, struct pbuf *p, struct ip_addr *dest)
     Packet.SrcAddr = LocalAddress;
     Packet.DstAddr = RemoteAddress;
 
+    /* lwIP leaves the TCP checksum to adapters that offload it */
+    if (Header->Protocol == IPPROTO_TCP &&
+        (LargeSendMss || !NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP)))
+    {
+        TCPCompleteChecksum(&Packet, NCE->Interface, LargeSendMss);
+    }
+
     NdisStatus = IPSendDatagram(&Packet, NCE);
     if (!NT_SUCCESS(NdisStatus))
         return ERR_RTE;
@@ -102,6 +145,13 @@ TCPInterfaceInit(struct netif *netif)
 
     netif->output = TCPSendDataCallback;
     netif->mtu = IF->MTU;
+
+    /* Segments must still fit the 16 bit IP total length */
+    if (IF->OffloadFlags & IP_OFFLOAD_LARGE_SEND)
+        netif->tso_max = (u16_t)min(IF->LargeSendMaxSize, 0xFFFF - 2 * IPv4_MAX_HEADER_SIZE);
+
+    if (IF->OffloadFlags & IP_OFFLOAD_TCP_CHECKSUM)
+        NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL & ~NETIF_CHECKSUM_GEN_TCP);
     
     netif->name[0] = 'e';
     netif->name[1] = 'n';
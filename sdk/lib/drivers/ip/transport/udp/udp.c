@@ -21,7 +21,8 @@ NTSTATUS AddUDPHeaderIPv4(
     USHORT LocalPort,
     PIP_PACKET IPPacket,
     PVOID Data,
-    UINT DataLength)
+    UINT DataLength,
+    PIP_INTERFACE Interface)
 /*
  * FUNCTION: Adds an IPv4 and UDP header to an IP packet
  * ARGUMENTS:
@@ -29,6 +30,7 @@ NTSTATUS AddUDPHeaderIPv4(
  *     LocalAddress = Pointer to our local address
  *     LocalPort    = The port we send this datagram from
  *     IPPacket     = Pointer to IP packet
+ *     Interface    = Pointer to interface the datagram is sent on
  * RETURNS:
  *     Status of operation
  */
@@ -61,10 +63,22 @@ NTSTATUS AddUDPHeaderIPv4(
 
     RtlCopyMemory(IPPacket->Data, Data, DataLength);
 
-    UDPHeader->Checksum = UDPv4ChecksumCalculate((PIPv4_HEADER)IPPacket->Header,
-                                                 (PUCHAR)UDPHeader,
-                                                 DataLength + sizeof(UDP_HEADER));
-    UDPHeader->Checksum = WH2N(UDPHeader->Checksum);
+    if ((Interface->OffloadFlags & IP_OFFLOAD_UDP_CHECKSUM) &&
+        IPPacket->TotalSize <= Interface->MTU)
+    {
+        /* The adapter completes the checksum */
+        UDPHeader->Checksum = IPv4PseudoHeaderChecksum((PIPv4_HEADER)IPPacket->Header,
+                                                       IPPROTO_UDP,
+                                                       (USHORT)(DataLength + sizeof(UDP_HEADER)));
+        IPSetChecksumOffload(IPPacket->NdisPacket, IPPROTO_UDP);
+    }
+    else
+    {
+        UDPHeader->Checksum = UDPv4ChecksumCalculate((PIPv4_HEADER)IPPacket->Header,
+                                                     (PUCHAR)UDPHeader,
+                                                     DataLength + sizeof(UDP_HEADER));
+        UDPHeader->Checksum = WH2N(UDPHeader->Checksum);
+    }
 
     TI_DbgPrint(MID_TRACE, ("Packet: %d ip %d udp %d payload\n",
 			    (PCHAR)UDPHeader - (PCHAR)IPPacket->Header,
@@ -83,7 +97,8 @@ NTSTATUS BuildUDPPacket(
     PIP_ADDRESS LocalAddress,
     USHORT LocalPort,
     PCHAR DataBuffer,
-    UINT DataLen )
+    UINT DataLen,
+    PIP_INTERFACE Interface )
 /*
  * FUNCTION: Builds an UDP packet
  * ARGUMENTS:
@@ -91,6 +106,7 @@ NTSTATUS BuildUDPPacket(
  *     LocalAddress = Pointer to our local address
  *     LocalPort    = The port we send this datagram from
  *     IPPacket     = Address of pointer to IP packet
+ *     Interface    = Pointer to interface the packet is sent on
  * RETURNS:
  *     Status of operation
  */
@@ -122,7 +138,8 @@ NTSTATUS BuildUDPPacket(
     switch (RemoteAddress->Type) {
         case IP_ADDRESS_V4:
             Status = AddUDPHeaderIPv4(AddrFile, RemoteAddress, RemotePort,
-                                      LocalAddress, LocalPort, Packet, DataBuffer, DataLen);
+                                      LocalAddress, LocalPort, Packet, DataBuffer, DataLen,
+                                      Interface);
             break;
         case IP_ADDRESS_V6:
             /* FIXME: Support IPv6 */
@@ -221,7 +238,8 @@ NTSTATUS UDPSendDatagram(
 							 &LocalAddress,
 							 AddrFile->Port,
 							 BufferData,
-							 DataSize );
+							 DataSize,
+							 NCE->Interface );
 
     UnlockObject(AddrFile, OldIrql);
 
@@ -279,14 +297,17 @@ VOID UDPReceive(PIP_INTERFACE Interface, PIP_PACKET IPPacket)
 
   UDPHeader = (PUDP_HEADER)IPPacket->Data;
 
-  /* Calculate and validate UDP checksum */
-  i = UDPv4ChecksumCalculate(IPv4Header,
-                             (PUCHAR)UDPHeader,
-                             WH2N(UDPHeader->Length));
-  if (i != DH2N(0x0000FFFF) && UDPHeader->Checksum != 0)
+  /* Calculate and validate UDP checksum, unless the adapter did */
+  if (!(IPPacket->Flags & IP_PACKET_FLAG_UDP_CHECKSUM_OK))
   {
-      TI_DbgPrint(MIN_TRACE, ("Bad checksum on packet received.\n"));
-      return;
+      i = UDPv4ChecksumCalculate(IPv4Header,
+                                 (PUCHAR)UDPHeader,
+                                 WH2N(UDPHeader->Length));
+      if (i != DH2N(0x0000FFFF) && UDPHeader->Checksum != 0)
+      {
+          TI_DbgPrint(MIN_TRACE, ("Bad checksum on packet received.\n"));
+          return;
+      }
   }
 
   /* Sanity checks */
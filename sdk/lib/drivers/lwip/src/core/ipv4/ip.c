@@ -787,8 +787,9 @@ err_t ip_output_if_opt(struct pbuf *p, ip_addr_t *src, ip_addr_t *dest,
 #endif /* LWIP_IGMP */
 #endif /* ENABLE_LOOPBACK */
 #if IP_FRAG
-  /* don't fragment if interface has mtu set to 0 [loopif] */
-  if (netif->mtu && (p->tot_len > netif->mtu)) {
+  /* don't fragment if interface has mtu set to 0 [loopif], nor large
+     TCP segments the interface cuts down itself */
+  if (netif->mtu && (p->tot_len > netif->mtu) && (PBUF_TSO_MSS(p) == 0)) {
     return ip_frag(p, netif, dest);
   }
 #endif /* IP_FRAG */
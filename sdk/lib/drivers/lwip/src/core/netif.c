@@ -174,6 +174,10 @@ netif_add(struct netif *netif, ip_addr_t *ipaddr, ip_addr_t *netmask,
   netif->num = netif_num++;
   netif->input = input;
   NETIF_SET_HWADDRHINT(netif, NULL);
+  NETIF_SET_CHECKSUM_CTRL(netif, NETIF_CHECKSUM_ENABLE_ALL);
+#if LWIP_NETIF_TSO
+  netif->tso_max = 0;
+#endif /* LWIP_NETIF_TSO */
 #if ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS
   netif->loop_cnt_current = 0;
 #endif /* ENABLE_LOOPBACK && LWIP_LOOPBACK_MAX_PBUFS */
@@ -344,6 +344,9 @@ pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
   p->ref = 1;
   /* set flags */
   p->flags = 0;
+#if LWIP_NETIF_TSO
+  p->tso_mss = 0;
+#endif /* LWIP_NETIF_TSO */
   LWIP_DEBUGF(PBUF_DEBUG | LWIP_DBG_TRACE, ("pbuf_alloc(length=%"U16_F") == %p\n", length, (void *)p));
   return p;
 }
@@ -404,6 +407,9 @@ pbuf_alloced_custom(pbuf_layer l, u16_t length, pbuf_type type, struct pbuf_cust
     p->pbuf.payload = NULL;
   }
   p->pbuf.flags = PBUF_FLAG_IS_CUSTOM;
+#if LWIP_NETIF_TSO
+  p->pbuf.tso_mss = 0;
+#endif /* LWIP_NETIF_TSO */
   p->pbuf.len = p->pbuf.tot_len = length;
   p->pbuf.type = type;
   p->pbuf.ref = 1;
@@ -388,6 +388,18 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
   }
   queuelen = pcb->snd_queuelen;
 
+#if LWIP_NETIF_TSO
+  /* Build segments as large as the netif can cut down, within the
+     congestion window so slow start still sends MSS sized ones */
+  if (mss_local == pcb->mss) {
+    struct netif *netif = ip_route(&(pcb->remote_ip));
+    if ((netif != NULL) && (netif->tso_max > pcb->mss)) {
+      mss_local = LWIP_MIN(LWIP_MIN(netif->tso_max, pcb->cwnd), pcb->snd_wnd_max/2);
+      mss_local = LWIP_MAX(mss_local, pcb->mss);
+    }
+  }
+#endif /* LWIP_NETIF_TSO */
+
 #if LWIP_TCP_TIMESTAMPS
   if ((pcb->flags & TF_TIMESTAMP)) {
     optflags = TF_SEG_OPTS_TS;
@@ -919,6 +931,16 @@ tcp_output(struct tcp_pcb *pcb)
 
   seg = pcb->unsent;
 
+#if LWIP_NETIF_TSO
+  /* A large segment may not fit a congestion window that shrank after it
+     was queued. Send it anyway once nothing is in flight, so the connection
+     does not stall, as long as the receiver has room for it. */
+  if ((seg != NULL) && (pcb->unacked == NULL) && (seg->len > pcb->mss) &&
+      (seg->len <= pcb->snd_wnd)) {
+    wnd = LWIP_MAX(wnd, ntohl(seg->tcphdr->seqno) - pcb->lastack + seg->len);
+  }
+#endif /* LWIP_NETIF_TSO */
+
   /* If the TF_ACK_NOW flag is set and no data will be sent (either
    * because the ->unsent queue is empty or because the window does
    * not allow it), construct an empty ACK segment and send it.
@@ -1092,13 +1114,13 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
     pcb->rtime = 0;
   }
 
-  /* If we don't have a local IP address, we get one by
-     calling ip_route(). */
+  /* The netif tells which checksums to compute and how large a segment
+     it takes. If we don't have a local IP address, we get it from there. */
+  netif = ip_route(&(pcb->remote_ip));
+  if (netif == NULL) {
+    return;
+  }
   if (ip_addr_isany(&(pcb->local_ip))) {
-    netif = ip_route(&(pcb->remote_ip));
-    if (netif == NULL) {
-      return;
-    }
     ip_addr_copy(pcb->local_ip, netif->ip_addr);
   }
 
@@ -1119,8 +1141,19 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 
   seg->p->payload = seg->tcphdr;
 
+#if LWIP_NETIF_TSO
+  /* Segments above the MSS are cut down by the netif */
+  if ((netif->tso_max != 0) &&
+      (seg->len > pcb->mss - LWIP_TCP_OPT_LENGTH(seg->flags))) {
+    seg->p->tso_mss = pcb->mss - LWIP_TCP_OPT_LENGTH(seg->flags);
+  } else {
+    seg->p->tso_mss = 0;
+  }
+#endif /* LWIP_NETIF_TSO */
+
   seg->tcphdr->chksum = 0;
 #if CHECKSUM_GEN_TCP
+  if (NETIF_CHECKSUM_ENABLED(netif, NETIF_CHECKSUM_GEN_TCP)) {
 #if TCP_CHECKSUM_ON_COPY
   {
     u32_t acc;
@@ -1159,6 +1192,7 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
          &(pcb->remote_ip),
          IP_PROTO_TCP, seg->p->tot_len);
 #endif /* TCP_CHECKSUM_ON_COPY */
+  }
 #endif /* CHECKSUM_GEN_TCP */
   TCP_STATS_INC(tcp.xmit);
 
@@ -94,6 +94,16 @@ extern "C" {
  * Set by the netif driver in its init function. */
 #define NETIF_FLAG_IGMP         0x80U
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/** Checksums generated in software for this netif (see netif->chksum_flags).
+ * A netif clears the bits of the checksums its hardware computes. */
+#define NETIF_CHECKSUM_GEN_IP       0x0001
+#define NETIF_CHECKSUM_GEN_UDP      0x0002
+#define NETIF_CHECKSUM_GEN_TCP      0x0004
+#define NETIF_CHECKSUM_ENABLE_ALL   0xFFFF
+#define NETIF_CHECKSUM_DISABLE_ALL  0x0000
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+
 /** Function prototype for netif init functions. Set up flags and output/linkoutput
  * callback functions in this function.
  *
@@ -184,6 +194,14 @@ struct netif {
 #endif /* LWIP_NETIF_HOSTNAME */
   /** maximum transfer unit (in bytes) */
   u16_t mtu;
+#if LWIP_NETIF_TSO
+  /** largest TCP segment the hardware cuts down to MTU sized packets, 0 if none */
+  u16_t tso_max;
+#endif /* LWIP_NETIF_TSO */
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+  /** checksums generated in software (see NETIF_CHECKSUM_ above) */
+  u16_t chksum_flags;
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
   /** number of bytes used in hwaddr */
   u8_t hwaddr_len;
   /** link level hardware address of this interface */
@@ -321,6 +339,15 @@ void netif_poll_all(void);
 #define NETIF_SET_HWADDRHINT(netif, hint)
 #endif /* LWIP_NETIF_HWADDRHINT */
 
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+#define NETIF_SET_CHECKSUM_CTRL(netif, chksumflags) ((netif)->chksum_flags = (chksumflags))
+#define NETIF_CHECKSUM_ENABLED(netif, chksumflag) \
+  (((netif) == NULL) || (((netif)->chksum_flags & (chksumflag)) != 0))
+#else /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+#define NETIF_SET_CHECKSUM_CTRL(netif, chksumflags)
+#define NETIF_CHECKSUM_ENABLED(netif, chksumflag) 1
+#endif /* LWIP_CHECKSUM_CTRL_PER_NETIF */
+
 #ifdef __cplusplus
 }
 #endif
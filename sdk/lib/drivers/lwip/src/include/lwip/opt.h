@@ -1205,6 +1205,15 @@
 #define LWIP_NETIF_TX_SINGLE_PBUF             0
 #endif /* LWIP_NETIF_TX_SINGLE_PBUF */
 
+/**
+ * LWIP_NETIF_TSO==1: Support TCP segmentation offload. A netif with a non-zero
+ * tso_max accepts TCP segments of up to tso_max bytes, which it cuts down to
+ * the MSS stored in pbuf->tso_mss. Such segments are never IP fragmented.
+ */
+#ifndef LWIP_NETIF_TSO
+#define LWIP_NETIF_TSO                        0
+#endif /* LWIP_NETIF_TSO */
+
 /*
    ------------------------------------
    ---------- LOOPIF options ----------
@@ -1841,6 +1850,15 @@
 #define LWIP_CHECKSUM_ON_COPY           0
 #endif
 
+/**
+ * LWIP_CHECKSUM_CTRL_PER_NETIF==1: Checksum generation can be disabled per
+ * netif (see NETIF_SET_CHECKSUM_CTRL), for hardware that computes them.
+ * ATTENTION: the CHECKSUM_GEN_* defines must stay enabled for this to work!
+ */
+#ifndef LWIP_CHECKSUM_CTRL_PER_NETIF
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    0
+#endif
+
 /*
    ---------------------------------------
    ---------- Hook options ---------------
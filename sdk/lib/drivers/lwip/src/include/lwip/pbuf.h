@@ -75,6 +75,15 @@ typedef enum {
 #define PBUF_FLAG_LLMCAST   0x10U
 /** indicates this pbuf includes a TCP FIN flag */
 #define PBUF_FLAG_TCP_FIN   0x20U
+/** indicates the TCP checksum of this received packet was already verified
+    by the network interface */
+#define PBUF_FLAG_TCP_CHKSUM_OK 0x40U
+
+#if LWIP_NETIF_TSO
+#define PBUF_TSO_MSS(p) ((p)->tso_mss)
+#else /* LWIP_NETIF_TSO */
+#define PBUF_TSO_MSS(p) 0
+#endif /* LWIP_NETIF_TSO */
 
 struct pbuf {
   /** next pbuf in singly linked pbuf chain */
@@ -107,6 +116,12 @@ struct pbuf {
    * the stack itself, or pbuf->next pointers from a chain.
    */
   u16_t ref;
+
+#if LWIP_NETIF_TSO
+  /** TCP payload per packet the netif cuts this segment into, 0 if the
+      segment fits the MTU (only valid in the first pbuf of a chain) */
+  u16_t tso_mss;
+#endif /* LWIP_NETIF_TSO */
 };
 
 #if LWIP_SUPPORT_CUSTOM_PBUF
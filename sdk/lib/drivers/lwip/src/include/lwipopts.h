@@ -76,6 +76,17 @@
 
 #define LWIP_TCP_TIMESTAMPS             1
 
+/* The IP layer of tcpip.sys validates the header of every packet before
+ * handing it to lwIP and rebuilds it on the way out */
+#define CHECKSUM_GEN_IP                 0
+
+#define CHECKSUM_CHECK_IP               0
+
+/* Adapters with task offload compute TCP checksums and cut large segments */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+
+#define LWIP_NETIF_TSO                  1
+
 #define LWIP_CALLBACK_API               1
 
 #define LWIP_NETIF_API                  1
@@ -113,7 +113,7 @@ void        LibTCPSetNoDelay(PTCP_PCB pcb, BOOLEAN Set);
 void        LibTCPGetSocketStatus(PTCP_PCB pcb, PULONG State);
 
 /* IP functions */
-void LibIPInsertPacket(void *ifarg, const void *const data, const u32_t size);
+void LibIPInsertPacket(void *ifarg, const void *const data, const u32_t size, const u8_t flags);
 void LibIPInitialize(void);
 void LibIPShutdown(void);
 
@@ -11,7 +11,8 @@ typedef struct netif* PNETIF;
 void
 LibIPInsertPacket(void *ifarg,
                   const void *const data,
-                  const u32_t size)
+                  const u32_t size,
+                  const u8_t flags)
 {
     struct pbuf *p;
 
@@ -27,6 +28,9 @@ LibIPInsertPacket(void *ifarg,
 
         RtlCopyMemory(p->payload, data, p->len);
 
+        /* Checksums the adapter already verified */
+        p->flags |= flags;
+
         ((PNETIF)ifarg)->input(p, (PNETIF)ifarg);
     }
 }
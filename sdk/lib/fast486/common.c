@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -912,6 +916,11 @@ Fast486TaskSwitch(PFAST486_STATE State, FAST486_TASK_SWITCH_TYPE Type, USHORT Se
     State->PrefetchValid = FALSE;
 #endif
 
+#ifndef FAST486_NO_DECODE_CACHE
+    /* And the decode cache */
+    Fast486FlushDecodeCache(State);
+#endif
+
     /* Load the registers */
     if (NewTssDescriptor.Signature == FAST486_BUSY_TSS_SIGNATURE)
     {
@@ -155,6 +155,154 @@ Fast486FlushTlb(PFAST486_STATE State)
     State->TlbEmpty = TRUE;
 }
 
+#ifndef FAST486_NO_DECODE_CACHE
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486FlushDecodeCache(PFAST486_STATE State)
+{
+    /* Changing the generation makes all the cached instructions stale */
+    if (++State->DecodeGeneration == 0)
+    {
+        /* Wrapped around, really clear the cache */
+        RtlZeroMemory(State->DecodeCache, sizeof(State->DecodeCache));
+        State->DecodeGeneration = 1;
+    }
+
+    /* No block contains cached code anymore */
+    RtlZeroMemory(State->DecodeFilter, sizeof(State->DecodeFilter));
+}
+
+FORCEINLINE
+VOID
+FASTCALL
+Fast486InvalidateDecodeCache(PFAST486_STATE State,
+                             ULONG Address,
+                             ULONG Size)
+{
+    ULONG Block, Current;
+    ULONG Start = (Address >= FAST486_MAX_INST_LENGTH - 1)
+                  ? (Address - FAST486_MAX_INST_LENGTH + 1) : 0;
+    ULONG End = Address + Size - 1;
+
+    /* Clamp writes that wrap around the address space */
+    if (End < Address) End = 0xFFFFFFFF;
+
+    /* Cached instructions starting up to 14 bytes before the write can overlap it */
+    for (Block = Start >> FAST486_DECODE_BLOCK_SHIFT;
+         Block <= (End >> FAST486_DECODE_BLOCK_SHIFT);
+         Block++)
+    {
+        ULONG Bit = Block & (FAST486_DECODE_FILTER_SIZE - 1);
+        if (State->DecodeFilter[Bit / 32] & (1U << (Bit % 32))) break;
+    }
+
+    /* Fast path: none of these blocks contain cached code */
+    if (Block > (End >> FAST486_DECODE_BLOCK_SHIFT)) return;
+
+    if ((End - Start) >= FAST486_DECODE_CACHE_SIZE)
+    {
+        /* That would touch every entry anyway */
+        Fast486FlushDecodeCache(State);
+        return;
+    }
+
+    for (Current = Start; (Current - Start) <= (End - Start); Current++)
+    {
+        PFAST486_DECODED_INST Decoded = &State->DecodeCache[Current & (FAST486_DECODE_CACHE_SIZE - 1)];
+        if (Decoded->Address == Current) Decoded->Generation = 0;
+    }
+}
+
+FORCEINLINE
+PFAST486_DECODED_INST
+FASTCALL
+Fast486LookupDecodeCache(PFAST486_STATE State)
+{
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    ULONG Offset = (CachedDescriptor->Size) ? State->InstPtr.Long
+                                            : State->InstPtr.LowWord;
+    ULONG LinearAddress = CachedDescriptor->Base + Offset;
+    PFAST486_DECODED_INST Decoded = &State->DecodeCache[LinearAddress & (FAST486_DECODE_CACHE_SIZE - 1)];
+
+    if ((Decoded->Address != LinearAddress)
+        || (Decoded->Generation != State->DecodeGeneration)
+        || (Decoded->CodeSize != CachedDescriptor->Size))
+    {
+        /* Not cached */
+        return NULL;
+    }
+
+    if ((Offset + Decoded->Length - 1) > CachedDescriptor->Limit)
+    {
+        /* Let the normal instruction fetch raise the exception */
+        return NULL;
+    }
+
+    /* Skip the prefixes and the opcode */
+    if (CachedDescriptor->Size) State->InstPtr.Long += Decoded->Length;
+    else State->InstPtr.LowWord += Decoded->Length;
+
+    return Decoded;
+}
+
+FORCEINLINE
+PFAST486_DECODED_INST
+FASTCALL
+Fast486StoreDecodeCache(PFAST486_STATE State,
+                        UCHAR Opcode)
+{
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    PFAST486_DECODED_INST Decoded;
+    ULONG Offset, Length, LinearAddress, Block;
+
+    /*
+     * Only physical addresses can be tracked through the write path,
+     * so nothing is cached while paging is enabled.
+     */
+    if (State->ControlRegisters[FAST486_REG_CR0] & FAST486_CR0_PG) return NULL;
+
+    if (CachedDescriptor->Size)
+    {
+        Offset = State->SavedInstPtr.Long;
+        Length = State->InstPtr.Long - Offset;
+    }
+    else
+    {
+        Offset = State->SavedInstPtr.LowWord;
+        Length = State->InstPtr.LowWord - Offset;
+    }
+
+    /* Don't cache anything that wrapped around or is invalid */
+    if ((Length == 0) || (Length > FAST486_MAX_INST_LENGTH)) return NULL;
+
+    LinearAddress = CachedDescriptor->Base + Offset;
+    Decoded = &State->DecodeCache[LinearAddress & (FAST486_DECODE_CACHE_SIZE - 1)];
+
+    Decoded->Address = LinearAddress;
+    Decoded->Generation = State->DecodeGeneration;
+    Decoded->PrefixFlags = State->PrefixFlags;
+    Decoded->Opcode = Opcode;
+    Decoded->Length = (UCHAR)Length;
+    Decoded->SegmentOverride = (UCHAR)State->SegmentOverride;
+    Decoded->ModRmLength = 0;
+    Decoded->CodeSize = (UCHAR)CachedDescriptor->Size;
+
+    /* Mark the blocks as containing cached code */
+    for (Block = LinearAddress >> FAST486_DECODE_BLOCK_SHIFT;
+         Block <= ((LinearAddress + Length - 1) >> FAST486_DECODE_BLOCK_SHIFT);
+         Block++)
+    {
+        ULONG Bit = Block & (FAST486_DECODE_FILTER_SIZE - 1);
+        State->DecodeFilter[Bit / 32] |= 1U << (Bit % 32);
+    }
+
+    return Decoded;
+}
+
+#endif
+
 FORCEINLINE
 BOOLEAN
 FASTCALL
@@ -291,6 +439,11 @@ Fast486WriteLinearMemory(PFAST486_STATE State,
     }
     else
     {
+#ifndef FAST486_NO_DECODE_CACHE
+        /* Drop any cached instruction this write overlaps */
+        Fast486InvalidateDecodeCache(State, LinearAddress, Size);
+#endif
+
         /* Write the memory */
         State->MemWriteCallback(State, LinearAddress, Buffer, Size);
     }
@@ -1014,20 +1167,16 @@ Fast486CalculateParity(UCHAR Number)
 }
 
 FORCEINLINE
-BOOLEAN
+VOID
 FASTCALL
-Fast486ParseModRegRm(PFAST486_STATE State,
-                     BOOLEAN AddressSize,
-                     PFAST486_MOD_REG_RM ModRegRm)
+Fast486DecodeModRegRm(PFAST486_STATE State,
+                      BOOLEAN AddressSize,
+                      UCHAR ModRmByte,
+                      UCHAR SibByte,
+                      LONG Displacement,
+                      PFAST486_MOD_REG_RM ModRegRm)
 {
-    UCHAR ModRmByte, Mode, RegMem;
-
-    /* Fetch the MOD REG R/M byte */
-    if (!Fast486FetchByte(State, &ModRmByte))
-    {
-        /* Exception occurred */
-        return FALSE;
-    }
+    UCHAR Mode, RegMem;
 
     /* Unpack the mode and R/M */
     Mode = ModRmByte >> 6;
@@ -1044,7 +1193,7 @@ Fast486ParseModRegRm(PFAST486_STATE State,
         ModRegRm->SecondRegister = RegMem;
 
         /* Done parsing */
-        return TRUE;
+        return;
     }
 
     /* The second operand is memory */
@@ -1054,16 +1203,8 @@ Fast486ParseModRegRm(PFAST486_STATE State,
     {
         if (RegMem == FAST486_REG_ESP)
         {
-            UCHAR SibByte;
             ULONG Scale, Index, Base;
 
-            /* Fetch the SIB byte */
-            if (!Fast486FetchByte(State, &SibByte))
-            {
-                /* Exception occurred */
-                return FALSE;
-            }
-
             /* Unpack the scale, index and base */
             Scale = 1 << (SibByte >> 6);
             Index = (SibByte >> 3) & 0x07;
@@ -1077,12 +1218,8 @@ Fast486ParseModRegRm(PFAST486_STATE State,
             }
             else
             {
-                /* Fetch the base */
-                if (!Fast486FetchDword(State, &Base))
-                {
-                    /* Exception occurred */
-                    return FALSE;
-                }
+                /* The base was fetched as the displacement */
+                Base = 0;
             }
 
             if (((SibByte & 0x07) == FAST486_REG_ESP)
@@ -1123,34 +1260,8 @@ Fast486ParseModRegRm(PFAST486_STATE State,
             }
         }
 
-        if (Mode == 1)
-        {
-            CHAR Offset;
-
-            /* Fetch the byte */
-            if (!Fast486FetchByte(State, (PUCHAR)&Offset))
-            {
-                /* Exception occurred */
-                return FALSE;
-            }
-
-            /* Add the signed offset to the address */
-            ModRegRm->MemoryAddress += (LONG)Offset;
-        }
-        else if ((Mode == 2) || ((Mode == 0) && (RegMem == FAST486_REG_EBP)))
-        {
-            LONG Offset;
-
-            /* Fetch the dword */
-            if (!Fast486FetchDword(State, (PULONG)&Offset))
-            {
-                /* Exception occurred */
-                return FALSE;
-            }
-
-            /* Add the signed offset to the address */
-            ModRegRm->MemoryAddress += Offset;
-        }
+        /* Add the signed offset to the address */
+        ModRegRm->MemoryAddress += Displacement;
     }
     else
     {
@@ -1239,39 +1350,154 @@ Fast486ParseModRegRm(PFAST486_STATE State,
             }
         }
 
-        if (Mode == 1)
-        {
-            CHAR Offset;
+        /* Add the signed offset to the address */
+        ModRegRm->MemoryAddress += Displacement;
+
+        /* Clear the top 16 bits */
+        ModRegRm->MemoryAddress &= 0x0000FFFF;
+    }
+}
+
+FORCEINLINE
+BOOLEAN
+FASTCALL
+Fast486ParseModRegRm(PFAST486_STATE State,
+                     BOOLEAN AddressSize,
+                     PFAST486_MOD_REG_RM ModRegRm)
+{
+    UCHAR ModRmByte, Mode, RegMem;
+    UCHAR SibByte = 0;
+    LONG Displacement = 0;
+#ifndef FAST486_NO_DECODE_CACHE
+    PFAST486_SEG_REG CachedDescriptor = &State->SegmentRegs[FAST486_REG_CS];
+    PFAST486_DECODED_INST Decoded = State->CurrentDecoded;
+    ULONG StartOffset = (CachedDescriptor->Size) ? State->InstPtr.Long
+                                                 : State->InstPtr.LowWord;
+
+    /* Only the first MOD REG R/M of the instruction is cached */
+    State->CurrentDecoded = NULL;
+
+    if ((Decoded != NULL)
+        && (Decoded->ModRmLength != 0)
+        && ((StartOffset + Decoded->ModRmLength - 1) <= CachedDescriptor->Limit))
+    {
+        /* Skip over the bytes that were already fetched and decoded */
+        if (CachedDescriptor->Size) State->InstPtr.Long += Decoded->ModRmLength;
+        else State->InstPtr.LowWord += Decoded->ModRmLength;
+
+        Fast486DecodeModRegRm(State,
+                              AddressSize,
+                              Decoded->ModRm,
+                              Decoded->Sib,
+                              Decoded->Displacement,
+                              ModRegRm);
+        return TRUE;
+    }
+#endif
+
+    /* Fetch the MOD REG R/M byte */
+    if (!Fast486FetchByte(State, &ModRmByte))
+    {
+        /* Exception occurred */
+        return FALSE;
+    }
 
-            /* Fetch the byte */
-            if (!Fast486FetchByte(State, (PUCHAR)&Offset))
+    /* Unpack the mode and R/M */
+    Mode = ModRmByte >> 6;
+    RegMem = ModRmByte & 0x07;
+
+    if (Mode != 3)
+    {
+        if (AddressSize)
+        {
+            if (RegMem == FAST486_REG_ESP)
             {
-                /* Exception occurred */
-                return FALSE;
+                /* Fetch the SIB byte */
+                if (!Fast486FetchByte(State, &SibByte))
+                {
+                    /* Exception occurred */
+                    return FALSE;
+                }
+
+                if (((SibByte & 0x07) == FAST486_REG_EBP) && (Mode == 0))
+                {
+                    /* Fetch the base */
+                    if (!Fast486FetchDword(State, (PULONG)&Displacement))
+                    {
+                        /* Exception occurred */
+                        return FALSE;
+                    }
+                }
             }
 
-            /* Add the signed offset to the address */
-            ModRegRm->MemoryAddress += (LONG)Offset;
+            if (Mode == 1)
+            {
+                CHAR Offset;
+
+                /* Fetch the byte */
+                if (!Fast486FetchByte(State, (PUCHAR)&Offset))
+                {
+                    /* Exception occurred */
+                    return FALSE;
+                }
+
+                Displacement = (LONG)Offset;
+            }
+            else if ((Mode == 2) || ((Mode == 0) && (RegMem == FAST486_REG_EBP)))
+            {
+                /* Fetch the dword */
+                if (!Fast486FetchDword(State, (PULONG)&Displacement))
+                {
+                    /* Exception occurred */
+                    return FALSE;
+                }
+            }
         }
-        else if ((Mode == 2) || ((Mode == 0) && (RegMem == 6)))
+        else
         {
-            SHORT Offset;
-
-            /* Fetch the word */
-            if (!Fast486FetchWord(State, (PUSHORT)&Offset))
+            if (Mode == 1)
             {
-                /* Exception occurred */
-                return FALSE;
+                CHAR Offset;
+
+                /* Fetch the byte */
+                if (!Fast486FetchByte(State, (PUCHAR)&Offset))
+                {
+                    /* Exception occurred */
+                    return FALSE;
+                }
+
+                Displacement = (LONG)Offset;
             }
+            else if ((Mode == 2) || ((Mode == 0) && (RegMem == 6)))
+            {
+                SHORT Offset;
 
-            /* Add the signed offset to the address */
-            ModRegRm->MemoryAddress += (LONG)Offset;
+                /* Fetch the word */
+                if (!Fast486FetchWord(State, (PUSHORT)&Offset))
+                {
+                    /* Exception occurred */
+                    return FALSE;
+                }
+
+                Displacement = (LONG)Offset;
+            }
         }
+    }
 
-        /* Clear the top 16 bits */
-        ModRegRm->MemoryAddress &= 0x0000FFFF;
+#ifndef FAST486_NO_DECODE_CACHE
+    if (Decoded != NULL)
+    {
+        /* Save the fetched bytes along with the opcode */
+        Decoded->ModRm = ModRmByte;
+        Decoded->Sib = SibByte;
+        Decoded->Displacement = Displacement;
+        Decoded->ModRmLength = (UCHAR)((CachedDescriptor->Size)
+                                       ? (State->InstPtr.Long - StartOffset)
+                                       : (USHORT)(State->InstPtr.LowWord - StartOffset));
     }
+#endif
 
+    Fast486DecodeModRegRm(State, AddressSize, ModRmByte, SibByte, Displacement, ModRegRm);
     return TRUE;
 }
 
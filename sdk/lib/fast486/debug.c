@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -50,6 +54,9 @@ Fast486ExecutionControl(PFAST486_STATE State, FAST486_EXEC_CMD Command)
 {
     UCHAR Opcode;
     FAST486_OPCODE_HANDLER_PROC CurrentHandler;
+#ifndef FAST486_NO_DECODE_CACHE
+    PFAST486_DECODED_INST Decoded;
+#endif
     INT ProcedureCallCount = 0;
     BOOLEAN Trap;
 
@@ -66,6 +73,25 @@ NextInst:
             {
                 State->SavedInstPtr = State->InstPtr;
                 State->SavedStackPtr = State->GeneralRegs[FAST486_REG_ESP];
+
+#ifndef FAST486_NO_DECODE_CACHE
+                /* Check if the prefixes and the opcode were already decoded */
+                Decoded = Fast486LookupDecodeCache(State);
+
+                if (Decoded != NULL)
+                {
+                    Opcode = Decoded->Opcode;
+                    State->PrefixFlags = Decoded->PrefixFlags;
+                    State->SegmentOverride = Decoded->SegmentOverride;
+
+                    /* Call the opcode handler directly */
+                    State->CurrentDecoded = Decoded;
+                    Fast486OpcodeHandlers[Opcode](State, Opcode);
+                    State->CurrentDecoded = NULL;
+                    State->PrefixFlags = 0;
+                    goto CheckInterrupts;
+                }
+#endif
             }
 
             /* Perform an instruction fetch */
@@ -80,8 +106,21 @@ NextInst:
 
             /* Call the opcode handler */
             CurrentHandler = Fast486OpcodeHandlers[Opcode];
+
+#ifndef FAST486_NO_DECODE_CACHE
+            /* Remember the decoded prefixes and opcode for the next time */
+            if (CurrentHandler != Fast486OpcodePrefix)
+            {
+                State->CurrentDecoded = Fast486StoreDecodeCache(State, Opcode);
+            }
+#endif
+
             CurrentHandler(State, Opcode);
 
+#ifndef FAST486_NO_DECODE_CACHE
+            State->CurrentDecoded = NULL;
+#endif
+
             /* If this is a prefix, go to the next instruction immediately */
             if (CurrentHandler == Fast486OpcodePrefix) goto NextInst;
 
@@ -89,6 +128,9 @@ NextInst:
             State->PrefixFlags = 0;
         }
 
+#ifndef FAST486_NO_DECODE_CACHE
+CheckInterrupts:
+#endif
         /*
          * Check if there is an interrupt to execute, or a hardware interrupt signal
          * while interrupts are enabled.
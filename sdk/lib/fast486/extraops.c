@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -640,6 +644,11 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeLoadControlReg)
     State->PrefetchValid = FALSE;
 #endif
 
+#ifndef FAST486_NO_DECODE_CACHE
+    /* The same goes for the decode cache */
+    Fast486FlushDecodeCache(State);
+#endif
+
     if (ModRegRm.Register == (INT)FAST486_REG_CR3)
     {
         /* Flush the TLB */
@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -198,6 +202,11 @@ Fast486Reset(PFAST486_STATE State)
 
     /* Flush the TLB */
     Fast486FlushTlb(State);
+
+#ifndef FAST486_NO_DECODE_CACHE
+    /* Start with an empty decode cache */
+    State->DecodeGeneration = 1;
+#endif
 }
 
 VOID
@@ -258,6 +267,11 @@ Fast486Rewind(PFAST486_STATE State)
 #ifndef FAST486_NO_PREFETCH
     State->PrefetchValid = FALSE;
 #endif
+
+#ifndef FAST486_NO_DECODE_CACHE
+    /* The caller may modify the memory before resuming */
+    Fast486FlushDecodeCache(State);
+#endif
 }
 
 /* EOF */
@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -0,0 +1,58 @@
+/*
+ * PROJECT:     Fast486 386/486 CPU Emulation Library
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Definitions for building Fast486 with the host compiler
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#ifndef _FAST486_HOST_H_
+#define _FAST486_HOST_H_
+
+#pragma once
+
+/*
+ * Definitions needed to build Fast486 with the host compiler (FAST486_HOST),
+ * in place of <windef.h>. Only the host headers are used.
+ */
+
+#include <typedefs.h>
+#include <stdio.h>
+#include <string.h>
+
+#undef  FASTCALL
+#define FASTCALL
+
+#ifndef FORCEINLINE
+#ifdef _MSC_VER
+#define FORCEINLINE static __forceinline
+#else
+#define FORCEINLINE static inline __attribute__((always_inline))
+#endif
+#endif
+
+#ifndef C_ASSERT
+#define C_ASSERT(expr) extern char (*c_assert(void)) [(expr) ? 1 : -1]
+#endif
+
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+#endif
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define RtlFillMemory(Destination, Length, Fill) memset(Destination, Fill, Length)
+#define UlongToPtr(ul) ((PVOID)(ULONG_PTR)(ULONG)(ul))
+#define DbgPrint printf
+
+typedef ULONGLONG *PULONGLONG;
+typedef LONGLONG *PLONGLONG;
+
+#endif // _FAST486_HOST_H_
+
+/* EOF */
@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -4145,6 +4149,11 @@ FAST486_OPCODE_HANDLER(Fast486OpcodeLdsLes)
             State->PrefetchValid = FALSE;
 #endif
 
+#ifndef FAST486_NO_DECODE_CACHE
+            /* The same goes for the decode cache */
+            Fast486FlushDecodeCache(State);
+#endif
+
             /* Call the BOP handler */
             State->BopCallback(State, BopCode);
 
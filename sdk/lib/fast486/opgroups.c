@@ -21,7 +21,11 @@
 
 /* INCLUDES *******************************************************************/
 
+#ifdef FAST486_HOST
+#include "host.h"
+#else
 #include <windef.h>
+#endif
 
 // #define NDEBUG
 #include <debug.h>
@@ -2253,6 +2257,11 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeGroup0F01)
             State->ControlRegisters[FAST486_REG_CR0] &= 0xFFFFFFF1;
             State->ControlRegisters[FAST486_REG_CR0] |= MachineStatusWord & 0x0F;
 
+#ifndef FAST486_NO_DECODE_CACHE
+            /* This may have switched to protected mode */
+            Fast486FlushDecodeCache(State);
+#endif
+
             break;
         }
 
@@ -2264,6 +2273,11 @@ FAST486_OPCODE_HANDLER(Fast486ExtOpcodeGroup0F01)
             State->PrefetchValid = FALSE;
 #endif
 
+#ifndef FAST486_NO_DECODE_CACHE
+            /* And the decode cache */
+            Fast486FlushDecodeCache(State);
+#endif
+
             /* This is a privileged instruction */
             if (Fast486GetCurrentPrivLevel(State) != 0)
             {
@@ -16,6 +16,18 @@
 
 #define MAX_STATIC_CS_DEBUG_OBJECTS 64
 
+/* Spin limits for busy critical sections (MP systems only) */
+#define CS_DEFAULT_MAX_SPIN 1024
+#define CS_MIN_SPIN         16
+
+/*
+ * Spin statistics are kept in the second spare ULONG of the debug block, the
+ * first one (Flags) tells heap blocks from static ones. Wine code may store a
+ * section name there on 64-bit, the history only is a hint.
+ */
+#define CS_SPIN_ACQUIRE_COUNT(DebugInfo)    ((DebugInfo)->CreatorBackTraceIndexHigh)
+#define CS_ADAPTIVE_SPIN_COUNT(DebugInfo)   ((DebugInfo)->SpareWORD)
+
 static RTL_CRITICAL_SECTION RtlCriticalSectionLock;
 static LIST_ENTRY RtlCriticalSectionList;
 static BOOLEAN RtlpCritSectInitialized = FALSE;
@@ -28,69 +40,6 @@ extern HANDLE LdrpShutdownThreadId;
 
 /* FUNCTIONS *****************************************************************/
 
-/*++
- * RtlpCreateCriticalSectionSem
- *
- *     Checks if an Event has been created for the critical section.
- *
- * Params:
- *     None
- *
- * Returns:
- *     None. Raises an exception if the system call failed.
- *
- * Remarks:
- *     None
- *
- *--*/
-_At_(CriticalSection->LockSemaphore, _Post_notnull_)
-VOID
-NTAPI
-RtlpCreateCriticalSectionSem(PRTL_CRITICAL_SECTION CriticalSection)
-{
-    HANDLE hEvent = CriticalSection->LockSemaphore;
-    HANDLE hNewEvent;
-    NTSTATUS Status;
-
-    /* Check if we have an event */
-    if (!hEvent)
-    {
-        /* No, so create it */
-        Status = NtCreateEvent(&hNewEvent,
-                               EVENT_ALL_ACCESS,
-                               NULL,
-                               SynchronizationEvent,
-                               FALSE);
-        if (!NT_SUCCESS(Status))
-        {
-            DPRINT1("Failed to Create Event!\n");
-
-            /*
-             * Use INVALID_HANDLE_VALUE (-1) to signal that
-             * the global keyed event must be used.
-             */
-            hNewEvent = INVALID_HANDLE_VALUE;
-        }
-
-        DPRINT("Created Event: %p \n", hNewEvent);
-
-        /* Exchange the LockSemaphore field with the new handle, if it is still 0 */
-        if (InterlockedCompareExchangePointer((PVOID*)&CriticalSection->LockSemaphore,
-                                              (PVOID)hNewEvent,
-                                               NULL) != NULL)
-        {
-            /* Someone else just created an event */
-            if (hNewEvent != INVALID_HANDLE_VALUE)
-            {
-                DPRINT("Closing already created event: %p\n", hNewEvent);
-                NtClose(hNewEvent);
-            }
-        }
-    }
-
-    return;
-}
-
 /*++
  * RtlpWaitForCriticalSection
  *
@@ -103,7 +52,8 @@ RtlpCreateCriticalSectionSem(PRTL_CRITICAL_SECTION CriticalSection)
  *     STATUS_SUCCESS, or raises an exception if a deadlock is occuring.
  *
  * Remarks:
- *     None
+ *     Waits on the global keyed event, with the critical section as the
+ *     key, so that no per-lock event handle is needed.
  *
  *--*/
 NTSTATUS
@@ -114,16 +64,8 @@ RtlpWaitForCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
     EXCEPTION_RECORD ExceptionRecord;
     BOOLEAN LastChance = FALSE;
 
-    /* Do we have an Event yet? */
-    if (!CriticalSection->LockSemaphore)
-    {
-        RtlpCreateCriticalSectionSem(CriticalSection);
-    }
-
     /* Increase the Debug Entry count */
-    DPRINT("Waiting on Critical Section Event: %p %p\n",
-            CriticalSection,
-            CriticalSection->LockSemaphore);
+    DPRINT("Waiting on Critical Section: %p\n", CriticalSection);
 
     if (CriticalSection->DebugInfo)
         CriticalSection->DebugInfo->EntryCount++;
@@ -146,22 +88,11 @@ RtlpWaitForCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
         if (CriticalSection->DebugInfo)
             CriticalSection->DebugInfo->ContentionCount++;
 
-        /* Check if allocating the event failed */
-        if (CriticalSection->LockSemaphore == INVALID_HANDLE_VALUE)
-        {
-            /* Use the global keyed event (NULL as keyed event handle) */
-            Status = NtWaitForKeyedEvent(NULL,
-                                         CriticalSection,
-                                         FALSE,
-                                         &RtlpTimeout);
-        }
-        else
-        {
-            /* Wait on the Event */
-            Status = NtWaitForSingleObject(CriticalSection->LockSemaphore,
-                                           FALSE,
-                                           &RtlpTimeout);
-        }
+        /* Wait on the global keyed event (NULL as keyed event handle) */
+        Status = NtWaitForKeyedEvent(NULL,
+                                     CriticalSection,
+                                     FALSE,
+                                     &RtlpTimeout);
 
         /* We have Timed out */
         if (Status == STATUS_TIMEOUT)
@@ -195,7 +126,7 @@ RtlpWaitForCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
 /*++
  * RtlpUnWaitCriticalSection
  *
- *     Slow path of RtlLeaveCriticalSection. Fires an Event Object.
+ *     Slow path of RtlLeaveCriticalSection. Releases a waiting thread.
  *
  * Params:
  *     CriticalSection - Critical section to release.
@@ -204,7 +135,8 @@ RtlpWaitForCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
  *     None. Raises an exception if the system call failed.
  *
  * Remarks:
- *     None
+ *     The waiter has already announced itself in LockCount, so the keyed
+ *     event release only blocks until it actually starts waiting.
  *
  *--*/
 VOID
@@ -213,40 +145,82 @@ RtlpUnWaitCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
 {
     NTSTATUS Status;
 
-    /* Do we have an Event yet? */
-    if (!CriticalSection->LockSemaphore)
-    {
-        RtlpCreateCriticalSectionSem(CriticalSection);
-    }
-
-    /* Signal the Event */
-    DPRINT("Signaling Critical Section Event: %p, %p\n",
-            CriticalSection,
-            CriticalSection->LockSemaphore);
-
-    /* Check if this critical section needs to use the keyed event */
-    if (CriticalSection->LockSemaphore == INVALID_HANDLE_VALUE)
-    {
-        /* Release keyed event */
-        Status = NtReleaseKeyedEvent(NULL, CriticalSection, FALSE, &RtlpTimeout);
-    }
-    else
-    {
-        /* Set the event */
-        Status = NtSetEvent(CriticalSection->LockSemaphore, NULL);
-    }
+    /* Release one waiter of the global keyed event */
+    DPRINT("Signaling Critical Section: %p\n", CriticalSection);
+    Status = NtReleaseKeyedEvent(NULL, CriticalSection, FALSE, &RtlpTimeout);
 
     if (!NT_SUCCESS(Status))
     {
         /* We've failed */
-        DPRINT1("Signaling Failed for: %p, %p, 0x%08lx\n",
+        DPRINT1("Signaling Failed for: %p, 0x%08lx\n",
                 CriticalSection,
-                CriticalSection->LockSemaphore,
                 Status);
         RtlRaiseStatus(Status);
     }
 }
 
+/*++
+ * RtlpSpinOnCriticalSection
+ *
+ *     Spins on a busy critical section, for an owner about to release it.
+ *
+ * Params:
+ *     CriticalSection - Critical section to acquire.
+ *
+ * Returns:
+ *     TRUE if the critical section has been acquired, FALSE if the caller
+ *     has to queue up and wait for it.
+ *
+ * Remarks:
+ *     Only spins on MP systems. The spin limit adapts to the spins the
+ *     previous acquisitions needed: it follows them for short-held locks,
+ *     and shrinks when spinning fails, up to the lock spin count (or a
+ *     default one if none was set). The history is not updated atomically,
+ *     as it only is a hint.
+ *
+ *--*/
+static
+BOOLEAN
+RtlpSpinOnCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
+{
+    PRTL_CRITICAL_SECTION_DEBUG DebugInfo = CriticalSection->DebugInfo;
+    ULONG MaxSpin, SpinLimit, Spin, SpinHistory;
+
+    if (NtCurrentPeb()->NumberOfProcessors <= 1)
+        return FALSE;
+
+    MaxSpin = (CriticalSection->SpinCount != 0) ? (ULONG)CriticalSection->SpinCount
+                                                : CS_DEFAULT_MAX_SPIN;
+
+    /* Allow twice what was needed recently, the owner may hold it a bit longer */
+    SpinHistory = DebugInfo ? CS_ADAPTIVE_SPIN_COUNT(DebugInfo) : 0;
+    SpinLimit = min(SpinHistory * 2 + CS_MIN_SPIN, MaxSpin);
+
+    for (Spin = 0; Spin < SpinLimit; Spin++)
+    {
+        YieldProcessor();
+
+        if (*(volatile LONG*)&CriticalSection->LockCount == -1 &&
+            InterlockedCompareExchange(&CriticalSection->LockCount, 0, -1) == -1)
+        {
+            /* Got it, we can update the history safely now */
+            if (DebugInfo)
+            {
+                SpinHistory += ((LONG)Spin - (LONG)SpinHistory) / 8;
+                CS_SPIN_ACQUIRE_COUNT(DebugInfo)++;
+                CS_ADAPTIVE_SPIN_COUNT(DebugInfo) = (WORD)min(SpinHistory, MAXUSHORT);
+            }
+            return TRUE;
+        }
+    }
+
+    /* Spinning was wasted, spin less next time */
+    if (DebugInfo)
+        CS_ADAPTIVE_SPIN_COUNT(DebugInfo) = (WORD)(SpinHistory / 2);
+
+    return FALSE;
+}
+
 /*++
  * RtlpInitDeferedCriticalSection
  *
@@ -477,7 +451,8 @@ RtlSetCriticalSectionSpinCount(PRTL_CRITICAL_SECTION CriticalSection,
  *     STATUS_SUCCESS.
  *
  * Remarks:
- *     Uses a fast-path unless contention happens.
+ *     Uses a fast-path unless contention happens. On contention it spins
+ *     for a while before waiting, see RtlpSpinOnCriticalSection.
  *
  *--*/
 NTSTATUS
@@ -486,6 +461,19 @@ RtlEnterCriticalSection(PRTL_CRITICAL_SECTION CriticalSection)
 {
     HANDLE Thread = (HANDLE)NtCurrentTeb()->ClientId.UniqueThread;
 
+    /*
+     * If someone else holds it, spin first. This has to be done before
+     * incrementing LockCount: once we did, the owner expects us to wait.
+     */
+    if (*(volatile LONG*)&CriticalSection->LockCount != -1 &&
+        Thread != CriticalSection->OwningThread &&
+        RtlpSpinOnCriticalSection(CriticalSection))
+    {
+        CriticalSection->OwningThread = Thread;
+        CriticalSection->RecursionCount = 1;
+        return STATUS_SUCCESS;
+    }
+
     /* Try to lock it */
     if (InterlockedIncrement(&CriticalSection->LockCount) != 0)
     {
@@ -598,6 +586,8 @@ RtlInitializeCriticalSectionAndSpinCount(PRTL_CRITICAL_SECTION CriticalSection,
     CritcalSectionDebugData->EntryCount = 0;
     CritcalSectionDebugData->CriticalSection = CriticalSection;
     CritcalSectionDebugData->Flags = 0;
+    CS_SPIN_ACQUIRE_COUNT(CritcalSectionDebugData) = 0;
+    CS_ADAPTIVE_SPIN_COUNT(CritcalSectionDebugData) = 0;
     CriticalSection->DebugInfo = CritcalSectionDebugData;
 
     /*
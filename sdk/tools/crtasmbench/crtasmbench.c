@@ -0,0 +1,362 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Fuzzer and benchmark for the CRT strlen, wcslen and memchr
+ *              assembly, runs natively on the build host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define DEFAULT_ROUNDS  20000
+#define DEFAULT_MBYTES  1024
+#define DATA_PAGES      2
+#define MAX_LENGTH      3000
+#define BENCH_SIZE      (64 * 1024)
+#define MAX_ERRORS      10
+
+/* The assembly follows the calling convention of the target */
+#ifdef __x86_64__
+#define CRTASM __attribute__((ms_abi))
+#define CRTASM_SYMBOL(Name) Name
+#else
+#define CRTASM
+#define CRTASM_SYMBOL(Name) _##Name
+#endif
+
+typedef unsigned short WCHAR16;
+
+typedef size_t (CRTASM *PSTRLEN)(const char *String);
+typedef size_t (CRTASM *PWCSLEN)(const WCHAR16 *String);
+typedef void * (CRTASM *PMEMCHR)(const void *Buffer, int Char, size_t Count);
+
+extern unsigned int CRTASM CRTASM_SYMBOL(CrtSimdLevel)(void);
+
+#define DECLARE_VARIANTS(Suffix) \
+    extern size_t CRTASM CRTASM_SYMBOL(strlen_##Suffix)(const char *String); \
+    extern size_t CRTASM CRTASM_SYMBOL(wcslen_##Suffix)(const WCHAR16 *String); \
+    extern void * CRTASM CRTASM_SYMBOL(memchr_##Suffix)(const void *Buffer, int Char, size_t Count);
+
+DECLARE_VARIANTS(sse2)
+DECLARE_VARIANTS(avx2)
+#ifndef __x86_64__
+DECLARE_VARIANTS(generic)
+#endif
+
+extern size_t CRTASM CRTASM_SYMBOL(CrtAsm_strlen)(const char *String);
+extern size_t CRTASM CRTASM_SYMBOL(CrtAsm_wcslen)(const WCHAR16 *String);
+extern void * CRTASM CRTASM_SYMBOL(CrtAsm_memchr)(const void *Buffer, int Char, size_t Count);
+
+/* The C versions from the CRT, see reference.c */
+size_t CrtRef_strlen(const char *String);
+size_t CrtRef_wcslen(const WCHAR16 *String);
+void *CrtRef_memchr(const void *Buffer, int Char, size_t Count);
+
+typedef struct _VARIANT
+{
+    const char *Name;
+    unsigned int SimdLevel;
+    PSTRLEN Strlen;
+    PWCSLEN Wcslen;
+    PMEMCHR Memchr;
+} VARIANT;
+
+#define VARIANT_ENTRY(Name, Level) \
+    { #Name, Level, CRTASM_SYMBOL(strlen_##Name), CRTASM_SYMBOL(wcslen_##Name), CRTASM_SYMBOL(memchr_##Name) }
+
+static const VARIANT Variants[] =
+{
+    { "export", 0, CRTASM_SYMBOL(CrtAsm_strlen), CRTASM_SYMBOL(CrtAsm_wcslen), CRTASM_SYMBOL(CrtAsm_memchr) },
+#ifndef __x86_64__
+    VARIANT_ENTRY(generic, 0),
+#endif
+    VARIANT_ENTRY(sse2, 1),
+    VARIANT_ENTRY(avx2, 2),
+};
+
+#define VARIANT_COUNT (sizeof(Variants) / sizeof(Variants[0]))
+
+static unsigned int SimdLevel;
+static unsigned char *Data;
+static size_t DataSize;
+static unsigned int Seed = 0x2545F491;
+static unsigned long Errors;
+
+static unsigned int
+Random(void)
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+/*
+ * The data pages sit between two no-access pages, so reading past either end
+ * of them faults.
+ */
+static int
+AllocateData(void)
+{
+    size_t PageSize = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *Area;
+
+    DataSize = DATA_PAGES * PageSize;
+    Area = mmap(NULL, DataSize + 2 * PageSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Area == MAP_FAILED)
+        return 0;
+
+    Data = Area + PageSize;
+    return (mprotect(Area, PageSize, PROT_NONE) == 0 &&
+            mprotect(Data + DataSize, PageSize, PROT_NONE) == 0);
+}
+
+/* Random bytes, with a zero now and then in front of and behind the string */
+static void
+FillData(void)
+{
+    size_t i;
+
+    for (i = 0; i < DataSize; i++)
+        Data[i] = (Random() % 16) ? (unsigned char)Random() : 0;
+}
+
+/* Places Size bytes either against the end guard page or anywhere */
+static unsigned char *
+PlaceBuffer(size_t Size, int AllowOdd)
+{
+    size_t Offset;
+
+    if (Random() % 2)
+        Offset = DataSize - Size;
+    else
+        Offset = Random() % (DataSize - Size + 1);
+
+    if (!AllowOdd || (Random() % 8))
+        Offset &= ~(size_t)1;
+
+    return Data + Offset;
+}
+
+static size_t
+RandomLength(void)
+{
+    return (Random() % 2) ? (Random() % 80) : (Random() % MAX_LENGTH);
+}
+
+static void
+ReportMismatch(const char *Routine, const char *Variant, const void *Buffer,
+               size_t Length, size_t Expected, size_t Actual)
+{
+    if (++Errors <= MAX_ERRORS)
+    {
+        printf("%s_%s mismatch: buffer %p (offset %lu), length %lu, got %lu, expected %lu\n",
+               Routine, Variant, Buffer,
+               (unsigned long)((const unsigned char *)Buffer - Data),
+               (unsigned long)Length, (unsigned long)Actual, (unsigned long)Expected);
+    }
+}
+
+static void
+FuzzStrlen(void)
+{
+    size_t Length, Expected, i, v;
+    char *String;
+
+    FillData();
+    Length = RandomLength();
+    String = (char *)PlaceBuffer(Length + 1, 1);
+    for (i = 0; i < Length; i++)
+    {
+        if (!String[i]) String[i] = 1;
+    }
+    String[Length] = 0;
+
+    Expected = CrtRef_strlen(String);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        if (Variants[v].Strlen(String) != Expected)
+            ReportMismatch("strlen", Variants[v].Name, String, Length, Expected, Variants[v].Strlen(String));
+    }
+}
+
+static void
+FuzzWcslen(void)
+{
+    size_t Length, Expected, i, v;
+    WCHAR16 *String;
+
+    FillData();
+    Length = RandomLength();
+    String = (WCHAR16 *)PlaceBuffer((Length + 1) * sizeof(WCHAR16), 1);
+    for (i = 0; i < Length; i++)
+    {
+        if (!String[i]) String[i] = (WCHAR16)(Random() % 2 ? 0x0100 : 0x0001);
+    }
+    String[Length] = 0;
+
+    Expected = CrtRef_wcslen(String);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        if (Variants[v].Wcslen(String) != Expected)
+            ReportMismatch("wcslen", Variants[v].Name, String, Length, Expected, Variants[v].Wcslen(String));
+    }
+}
+
+static void
+FuzzMemchr(void)
+{
+    static const unsigned char Alphabet[] = { 0x00, 0x41, 0x80, 0xFF };
+    size_t Length, Count, i, v;
+    unsigned char *Buffer;
+    const unsigned char *Expected, *Actual;
+    int Char;
+
+    /* Few distinct values, so matches turn up before, in and after the buffer */
+    for (i = 0; i < DataSize; i++)
+        Data[i] = Alphabet[Random() % 4];
+
+    Length = RandomLength();
+    Buffer = PlaceBuffer(Length, 1);
+    Count = Length;
+    for (i = 0; i < Length; i++)
+    {
+        if (Random() % 8) Buffer[i] = Alphabet[Random() % 2 + 1];
+    }
+
+    /* The CRT C version compares with a plain char, pass what it can match */
+    Char = (char)Alphabet[Random() % 4];
+
+    /* An unbounded count must still stop at the first match */
+    if (Buffer < Data + DataSize && !(Random() % 32))
+    {
+        Data[DataSize - 1] = (unsigned char)Char;
+        Count = (size_t)-1;
+    }
+
+    Expected = CrtRef_memchr(Buffer, Char, Count);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        Actual = Variants[v].Memchr(Buffer, Char, Count);
+        if (Actual != Expected)
+        {
+            ReportMismatch("memchr", Variants[v].Name, Buffer, Count,
+                           Expected ? (size_t)(Expected - Buffer) : (size_t)-1,
+                           Actual ? (size_t)(Actual - Buffer) : (size_t)-1);
+        }
+    }
+}
+
+static void
+PrintThroughput(const char *Routine, const char *Variant, clock_t Start, clock_t End,
+                unsigned long long Bytes)
+{
+    double Seconds = (double)(End - Start) / CLOCKS_PER_SEC;
+
+    printf("%-8s %-8s %8.2f GB/s\n", Routine, Variant,
+           (Seconds > 0.0) ? (Bytes / Seconds / 1e9) : 0.0);
+}
+
+/* Scans of a 64 KB buffer, which leave the match or terminator at its end */
+static void
+Benchmark(unsigned long MBytes)
+{
+    static union
+    {
+        char String[BENCH_SIZE];
+        WCHAR16 WideString[BENCH_SIZE / sizeof(WCHAR16)];
+    } Buffer;
+    unsigned long Rounds = (unsigned long)(MBytes * 1024ull * 1024 / BENCH_SIZE);
+    volatile size_t Sink = 0;
+    unsigned long r;
+    size_t v;
+    clock_t Start;
+
+    memset(Buffer.String, 'a', sizeof(Buffer.String));
+    Buffer.String[BENCH_SIZE - 1] = 0;
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++) Sink += CrtRef_strlen(Buffer.String);
+    PrintThroughput("strlen", "C", Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        Start = clock();
+        for (r = 0; r < Rounds; r++) Sink += Variants[v].Strlen(Buffer.String);
+        PrintThroughput("strlen", Variants[v].Name, Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    }
+
+    Buffer.WideString[BENCH_SIZE / sizeof(WCHAR16) - 1] = 0;
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++) Sink += CrtRef_wcslen(Buffer.WideString);
+    PrintThroughput("wcslen", "C", Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        Start = clock();
+        for (r = 0; r < Rounds; r++) Sink += Variants[v].Wcslen(Buffer.WideString);
+        PrintThroughput("wcslen", Variants[v].Name, Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    }
+
+    memset(Buffer.String, 'a', sizeof(Buffer.String));
+    Buffer.String[BENCH_SIZE - 1] = 'b';
+
+    Start = clock();
+    for (r = 0; r < Rounds; r++) Sink += (size_t)CrtRef_memchr(Buffer.String, 'b', BENCH_SIZE);
+    PrintThroughput("memchr", "C", Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    for (v = 0; v < VARIANT_COUNT; v++)
+    {
+        if (Variants[v].SimdLevel > SimdLevel) continue;
+        Start = clock();
+        for (r = 0; r < Rounds; r++) Sink += (size_t)Variants[v].Memchr(Buffer.String, 'b', BENCH_SIZE);
+        PrintThroughput("memchr", Variants[v].Name, Start, clock(), (unsigned long long)Rounds * BENCH_SIZE);
+    }
+
+    (void)Sink;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long Rounds = DEFAULT_ROUNDS, MBytes = DEFAULT_MBYTES, r;
+
+    if (argc > 1) Rounds = strtoul(argv[1], NULL, 0);
+    if (argc > 2) MBytes = strtoul(argv[2], NULL, 0);
+    if (argc > 3 || Rounds == 0)
+    {
+        fprintf(stderr, "Usage: %s [fuzz rounds] [benchmark MB per routine]\n", argv[0]);
+        return 2;
+    }
+
+    if (!AllocateData())
+    {
+        fprintf(stderr, "Could not set up the guarded buffer\n");
+        return 2;
+    }
+
+    SimdLevel = CRTASM_SYMBOL(CrtSimdLevel)();
+    printf("SIMD level %u, %lu fuzz rounds per routine\n", SimdLevel, Rounds);
+
+    for (r = 0; r < Rounds; r++)
+    {
+        FuzzStrlen();
+        FuzzWcslen();
+        FuzzMemchr();
+    }
+
+    printf("Fuzzing %s, %lu mismatch(es)\n", Errors ? "FAILED" : "OK", Errors);
+
+    if (MBytes)
+        Benchmark(MBytes);
+
+    return Errors ? 1 : 0;
+}
@@ -0,0 +1,22 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     CRT C routines the assembly versions are checked against
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#define memchr CrtRef_memchr
+#include "mem/memchr.c"
+
+#define _TCHAR char
+#define _tcslen CrtRef_strlen
+#include "string/tcslen.h"
+#undef _TCHAR
+#undef _tcslen
+
+/* wchar_t is 32 bits wide on most hosts */
+#define _TCHAR unsigned short
+#define _tcslen CrtRef_wcslen
+#include "string/tcslen.h"
+
+/* EOF */
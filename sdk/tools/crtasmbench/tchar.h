@@ -0,0 +1,12 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Stands in for <tchar.h> when building the CRT C routines on the host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+/* _TCHAR and the routine names are defined by reference.c */
+
+/* EOF */
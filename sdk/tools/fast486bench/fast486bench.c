@@ -0,0 +1,313 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Fast486 CPU emulator benchmark, runs natively on the build host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <host.h>
+#include <time.h>
+#include <fast486.h>
+
+#define MEMORY_SIZE     0x200000
+#define MEMORY_MASK     (MEMORY_SIZE - 1)
+#define DEFAULT_OUTER   2000
+
+/* 16-bit real mode program, loaded at 1000:0000 */
+#define CODE16_SEGMENT  0x1000
+#define DATA16_OFFSET   0x4000
+#define DATA16_COUNT    0x100
+
+/* 32-bit protected mode program with flat segments */
+#define GDT_ADDRESS     0x1000
+#define CODE32_ADDRESS  0x20000
+#define DATA32_ADDRESS  0x30000
+#define DATA32_COUNT    0x100
+#define STACK32_TOP     0x90000
+
+static UCHAR Memory[MEMORY_SIZE];
+static FAST486_STATE State;
+
+/*
+ *        mov   dx, OUTER
+ * outer: mov   si, 4000h
+ *        mov   cx, 100h
+ * inner: lodsw
+ *        add   bx, ax
+ *        xor   ax, bx
+ *        rol   ax, 1
+ *        mov   es:[si-2], ax
+ *        loop  inner
+ *        dec   dx
+ *        jnz   outer
+ *        xor   ax, ax
+ *        mov   cx, 2
+ * patch: inc   ax                      ; patched to "dec ax" on the first pass
+ *        mov   byte ptr cs:[patch], 48h
+ *        loop  patch
+ *        hlt
+ */
+static const UCHAR Code16[] =
+{
+    0xBA, 0x00, 0x00,
+    0xBE, 0x00, 0x40,
+    0xB9, 0x00, 0x01,
+    0xAD,
+    0x01, 0xC3,
+    0x31, 0xD8,
+    0xD1, 0xC0,
+    0x26, 0x89, 0x44, 0xFE,
+    0xE2, 0xF3,
+    0x4A,
+    0x75, 0xEA,
+    0x31, 0xC0,
+    0xB9, 0x02, 0x00,
+    0x40,
+    0x2E, 0xC6, 0x06, 0x1E, 0x00, 0x48,
+    0xE2, 0xF7,
+    0xF4
+};
+
+/*
+ *        mov   edx, OUTER
+ * outer: mov   esi, 30000h
+ *        mov   ecx, 100h
+ * inner: lodsd
+ *        add   ebx, eax
+ *        imul  eax, eax, 9E3779B1h
+ *        xor   eax, ebx
+ *        add   ax, bx
+ *        mov   [esi-4], eax
+ *        loop  inner
+ *        dec   edx
+ *        jnz   outer
+ *        xor   eax, eax
+ *        mov   ecx, 2
+ * patch: inc   eax                     ; patched to "dec eax" on the first pass
+ *        mov   byte ptr [patch], 48h
+ *        loop  patch
+ *        hlt
+ */
+static const UCHAR Code32[] =
+{
+    0xBA, 0x00, 0x00, 0x00, 0x00,
+    0xBE, 0x00, 0x00, 0x03, 0x00,
+    0xB9, 0x00, 0x01, 0x00, 0x00,
+    0xAD,
+    0x01, 0xC3,
+    0x69, 0xC0, 0xB1, 0x79, 0x37, 0x9E,
+    0x31, 0xD8,
+    0x66, 0x01, 0xD8,
+    0x89, 0x46, 0xFC,
+    0xE2, 0xED,
+    0x4A,
+    0x75, 0xE0,
+    0x31, 0xC0,
+    0xB9, 0x02, 0x00, 0x00, 0x00,
+    0x40,
+    0xC6, 0x05, 0x2C, 0x00, 0x02, 0x00, 0x48,
+    0xE2, 0xF6,
+    0xF4
+};
+
+/* Null descriptor, flat 32-bit code (08h) and flat 32-bit data (10h) */
+static const ULONGLONG Gdt[] =
+{
+    0x0000000000000000ULL,
+    0x00CF9A000000FFFFULL,
+    0x00CF92000000FFFFULL
+};
+
+static VOID
+FASTCALL
+BenchMemRead(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+    memcpy(Buffer, &Memory[Address & MEMORY_MASK], Size);
+}
+
+static VOID
+FASTCALL
+BenchMemWrite(PFAST486_STATE State, ULONG Address, PVOID Buffer, ULONG Size)
+{
+    UNREFERENCED_PARAMETER(State);
+    memcpy(&Memory[Address & MEMORY_MASK], Buffer, Size);
+}
+
+static ULONG
+InitialData(ULONG Index)
+{
+    return Index * 0x9E3779B1;
+}
+
+static USHORT
+Rol16(USHORT Value)
+{
+    return (USHORT)((Value << 1) | (Value >> 15));
+}
+
+static BOOLEAN
+Check16(ULONG Outer)
+{
+    USHORT Data[DATA16_COUNT];
+    USHORT Ax = 0, Bx = 0;
+    ULONG i, j;
+
+    for (i = 0; i < DATA16_COUNT; i++) Data[i] = (USHORT)InitialData(i);
+
+    for (i = 0; i < Outer; i++)
+    {
+        for (j = 0; j < DATA16_COUNT; j++)
+        {
+            Ax = Data[j];
+            Bx += Ax;
+            Ax ^= Bx;
+            Ax = Rol16(Ax);
+            Data[j] = Ax;
+        }
+    }
+
+    return (State.GeneralRegs[FAST486_REG_EBX].LowWord == Bx)
+           && (State.GeneralRegs[FAST486_REG_EAX].LowWord == 0)
+           && (memcmp(Data, &Memory[(CODE16_SEGMENT << 4) + DATA16_OFFSET], sizeof(Data)) == 0);
+}
+
+static BOOLEAN
+Check32(ULONG Outer)
+{
+    ULONG Data[DATA32_COUNT];
+    ULONG Eax = 0, Ebx = 0;
+    ULONG i, j;
+
+    for (i = 0; i < DATA32_COUNT; i++) Data[i] = InitialData(i);
+
+    for (i = 0; i < Outer; i++)
+    {
+        for (j = 0; j < DATA32_COUNT; j++)
+        {
+            Eax = Data[j];
+            Ebx += Eax;
+            Eax *= 0x9E3779B1;
+            Eax ^= Ebx;
+            Eax = (Eax & 0xFFFF0000) | ((Eax + Ebx) & 0xFFFF);
+            Data[j] = Eax;
+        }
+    }
+
+    return (State.GeneralRegs[FAST486_REG_EBX].Long == Ebx)
+           && (State.GeneralRegs[FAST486_REG_EAX].Long == 0)
+           && (memcmp(Data, &Memory[DATA32_ADDRESS], sizeof(Data)) == 0);
+}
+
+static VOID
+Setup16(ULONG Outer)
+{
+    ULONG Base = CODE16_SEGMENT << 4;
+    ULONG i;
+
+    memset(Memory, 0, sizeof(Memory));
+    memcpy(&Memory[Base], Code16, sizeof(Code16));
+    Memory[Base + 1] = (UCHAR)Outer;
+    Memory[Base + 2] = (UCHAR)(Outer >> 8);
+
+    for (i = 0; i < DATA16_COUNT; i++)
+    {
+        USHORT Value = (USHORT)InitialData(i);
+        memcpy(&Memory[Base + DATA16_OFFSET + i * sizeof(USHORT)], &Value, sizeof(Value));
+    }
+
+    Fast486Reset(&State);
+    Fast486SetSegment(&State, FAST486_REG_DS, CODE16_SEGMENT);
+    Fast486SetSegment(&State, FAST486_REG_ES, CODE16_SEGMENT);
+    Fast486SetStack(&State, CODE16_SEGMENT, 0xFFFE);
+    Fast486ExecuteAt(&State, CODE16_SEGMENT, 0);
+}
+
+static VOID
+Setup32(ULONG Outer)
+{
+    ULONG i;
+
+    memset(Memory, 0, sizeof(Memory));
+    memcpy(&Memory[GDT_ADDRESS], Gdt, sizeof(Gdt));
+    memcpy(&Memory[CODE32_ADDRESS], Code32, sizeof(Code32));
+    memcpy(&Memory[CODE32_ADDRESS + 1], &Outer, sizeof(Outer));
+
+    for (i = 0; i < DATA32_COUNT; i++)
+    {
+        ULONG Value = InitialData(i);
+        memcpy(&Memory[DATA32_ADDRESS + i * sizeof(ULONG)], &Value, sizeof(Value));
+    }
+
+    Fast486Reset(&State);
+    State.Gdtr.Address = GDT_ADDRESS;
+    State.Gdtr.Size = sizeof(Gdt) - 1;
+    State.ControlRegisters[FAST486_REG_CR0] |= FAST486_CR0_PE;
+
+    Fast486SetSegment(&State, FAST486_REG_DS, 0x10);
+    Fast486SetSegment(&State, FAST486_REG_ES, 0x10);
+    Fast486SetStack(&State, 0x10, STACK32_TOP);
+    Fast486ExecuteAt(&State, 0x08, CODE32_ADDRESS);
+}
+
+static BOOLEAN
+RunBenchmark(const char *Name,
+             VOID (*Setup)(ULONG),
+             BOOLEAN (*Check)(ULONG),
+             ULONG Outer)
+{
+    ULONGLONG Instructions = 0;
+    clock_t Start, End;
+    double Seconds;
+    BOOLEAN Success;
+
+    Setup(Outer);
+
+    Start = clock();
+    while (!State.Halted)
+    {
+        Fast486StepInto(&State);
+        Instructions++;
+    }
+    End = clock();
+
+    Seconds = (double)(End - Start) / CLOCKS_PER_SEC;
+    Success = Check(Outer);
+
+    printf("%-8s %12llu instructions in %8.3f s, %8.2f MIPS  %s\n",
+           Name,
+           (unsigned long long)Instructions,
+           Seconds,
+           (Seconds > 0.0) ? (Instructions / Seconds / 1000000.0) : 0.0,
+           Success ? "OK" : "MISMATCH");
+
+    return Success;
+}
+
+int main(int argc, char **argv)
+{
+    ULONG Outer = DEFAULT_OUTER;
+    BOOLEAN Success = TRUE;
+
+    if (argc > 1) Outer = strtoul(argv[1], NULL, 0);
+    if (Outer == 0 || Outer > 0xFFFF)
+    {
+        fprintf(stderr, "Usage: %s [iterations (1-65535)]\n", argv[0]);
+        return 2;
+    }
+
+    Fast486Initialize(&State,
+                      BenchMemRead,
+                      BenchMemWrite,
+                      NULL,
+                      NULL,
+                      NULL,
+                      NULL,
+                      NULL,
+                      NULL);
+
+    Success &= RunBenchmark("16-bit", Setup16, Check16, Outer);
+    Success &= RunBenchmark("32-bit", Setup32, Check32, Outer);
+
+    return Success ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Kernel mixer conversion benchmark, runs natively on the build host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <host.h>
+#include <stdarg.h>
+#include <time.h>
+
+#define IN_RATE         44100
+#define OUT_RATE        48000
+#define CHANNELS        2
+#define BUFFER_FRAMES   (IN_RATE / 100)         /* 10 ms, as the audio stack writes them */
+#define DEFAULT_SECONDS 60
+#define STREAMS         4
+#define TONE            440.0
+
+/* libsamplerate reports through these in the kernel */
+unsigned long __cdecl DbgPrint(const char *Format, ...)
+{
+    va_list Args;
+    int Length;
+
+    va_start(Args, Format);
+    Length = vfprintf(stderr, Format, Args);
+    va_end(Args);
+    return Length;
+}
+
+void __cdecl __debugbreak(void)
+{
+    abort();
+}
+
+#ifdef KMIXBENCH_NO_SINC
+/*
+ * Without all of its coefficient tables src_sinc.c does not build, the
+ * linear converter stands in. Old and new paths use the same one, so the
+ * comparison still shows what the per write setup costs.
+ */
+struct SRC_PRIVATE_tag;
+int linear_set_converter(struct SRC_PRIVATE_tag *psrc, int src_enum);
+
+int sinc_set_converter(struct SRC_PRIVATE_tag *psrc, int src_enum)
+{
+    return linear_set_converter(psrc, SRC_LINEAR);
+}
+
+const char *sinc_get_name(int src_enum)
+{
+    return NULL;
+}
+
+const char *sinc_get_description(int src_enum)
+{
+    return NULL;
+}
+#endif
+
+static SHORT Input[STREAMS][BUFFER_FRAMES * CHANNELS];
+static ULONG Phase[STREAMS];
+static SHORT LastSample;
+static ULONG MaxStep;
+
+static VOID FillBuffer(ULONG Stream)
+{
+    ULONG Index;
+    SHORT Sample;
+
+    /* A quiet tone per stream so that the mix does not clip */
+    for (Index = 0; Index < BUFFER_FRAMES; Index++, Phase[Stream]++)
+    {
+        Sample = (SHORT)(6000.0 * sin(2.0 * M_PI * TONE * (Stream + 1) * Phase[Stream] / IN_RATE));
+        Input[Stream][Index * CHANNELS] = Sample;
+        Input[Stream][Index * CHANNELS + 1] = Sample;
+    }
+}
+
+/* The largest step between neighbouring output samples, a click shows up here */
+static VOID TrackSteps(const SHORT *Samples, ULONG Frames)
+{
+    ULONG Index, Step;
+
+    for (Index = 0; Index < Frames; Index++)
+    {
+        Step = abs(Samples[Index * CHANNELS] - LastSample);
+        MaxStep = max(MaxStep, Step);
+        LastSample = Samples[Index * CHANNELS];
+    }
+}
+
+/* What kmixer did before: a new resampler and fresh buffers for every write */
+static ULONG LegacyWrite(const SHORT *Buffer, ULONG Frames)
+{
+    SRC_STATE *State;
+    SRC_DATA Data;
+    PFLOAT FloatIn, FloatOut;
+    PSHORT Result;
+    ULONG NewFrames;
+    int error;
+
+    NewFrames = (((ULONGLONG)Frames * OUT_RATE + IN_RATE / 2) / IN_RATE) + 2;
+
+    FloatIn = malloc(Frames * CHANNELS * sizeof(FLOAT));
+    FloatOut = malloc(NewFrames * CHANNELS * sizeof(FLOAT));
+    Result = malloc(NewFrames * CHANNELS * sizeof(SHORT));
+    State = src_new(SRC_SINC_FASTEST, CHANNELS, &error);
+    if (!FloatIn || !FloatOut || !Result || !State)
+    {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    src_short_to_float_array(Buffer, FloatIn, Frames * CHANNELS);
+
+    memset(&Data, 0, sizeof(Data));
+    Data.data_in = FloatIn;
+    Data.data_out = FloatOut;
+    Data.input_frames = Frames;
+    Data.output_frames = NewFrames;
+    Data.src_ratio = (double)OUT_RATE / IN_RATE;
+    Data.end_of_input = 1;
+    src_process(State, &Data);
+
+    src_float_to_short_array(FloatOut, Result, Data.output_frames_gen * CHANNELS);
+    TrackSteps(Result, Data.output_frames_gen);
+
+    src_delete(State);
+    free(Result);
+    free(FloatOut);
+    free(FloatIn);
+
+    return Data.output_frames_gen;
+}
+
+static VOID InitializeGraph(PCONVERSION_GRAPH Graph)
+{
+    if (!NT_SUCCESS(ConvGraphInitialize(Graph, CHANNELS, 16, IN_RATE, CHANNELS, 16, OUT_RATE)))
+    {
+        fprintf(stderr, "ConvGraphInitialize failed\n");
+        exit(1);
+    }
+}
+
+static VOID Report(const char *Name, ULONG Seconds, ULONGLONG Frames, clock_t Start, clock_t End)
+{
+    double Elapsed = (double)(End - Start) / CLOCKS_PER_SEC;
+
+    printf("%-10s %10llu frames %8.3f s, %8.3f ms CPU per second of audio, max step %lu\n",
+           Name, Frames, Elapsed, Elapsed * 1000.0 / Seconds, MaxStep);
+}
+
+int main(int argc, char **argv)
+{
+    CONVERSION_GRAPH Graphs[STREAMS];
+    PCONVERSION_GRAPH Others[STREAMS - 1];
+    ULONG Seconds = DEFAULT_SECONDS;
+    ULONG Buffers, Buffer, Stream, Frames;
+    ULONGLONG Total;
+    clock_t Start;
+
+    if (argc > 1) Seconds = strtoul(argv[1], NULL, 0);
+    if (Seconds == 0 || Seconds > 3600)
+    {
+        fprintf(stderr, "Usage: %s [seconds of audio (1-3600)]\n", argv[0]);
+        return 1;
+    }
+
+    Buffers = Seconds * 100;
+    printf("%u Hz -> %u Hz, %u channels, %u frames per write, %lu s of audio\n",
+           IN_RATE, OUT_RATE, CHANNELS, BUFFER_FRAMES, Seconds);
+
+    /* Per write resampler, as before */
+    Total = 0;
+    Start = clock();
+    for (Buffer = 0; Buffer < Buffers; Buffer++)
+    {
+        FillBuffer(0);
+        Total += LegacyWrite(Input[0], BUFFER_FRAMES);
+    }
+    Report("legacy", Seconds, Total, Start, clock());
+
+    /* One stream through its conversion graph */
+    memset(Phase, 0, sizeof(Phase));
+    MaxStep = 0;
+    LastSample = 0;
+    Total = 0;
+    InitializeGraph(&Graphs[0]);
+    Start = clock();
+    for (Buffer = 0; Buffer < Buffers; Buffer++)
+    {
+        FillBuffer(0);
+        ConvGraphWrite(&Graphs[0], Input[0], sizeof(Input[0]));
+        ConvGraphMix(&Graphs[0], NULL, 0, Graphs[0].QueueFill);
+        TrackSteps(Graphs[0].Output, Graphs[0].OutputLength / (CHANNELS * sizeof(SHORT)));
+        Total += Graphs[0].OutputLength / (CHANNELS * sizeof(SHORT));
+    }
+    Report("graph", Seconds, Total, Start, clock());
+    ConvGraphFree(&Graphs[0]);
+
+    /* Several streams mixed into the first one */
+    memset(Phase, 0, sizeof(Phase));
+    MaxStep = 0;
+    LastSample = 0;
+    Total = 0;
+    for (Stream = 0; Stream < STREAMS; Stream++)
+    {
+        InitializeGraph(&Graphs[Stream]);
+        if (Stream)
+            Others[Stream - 1] = &Graphs[Stream];
+    }
+    Start = clock();
+    for (Buffer = 0; Buffer < Buffers; Buffer++)
+    {
+        Frames = ~0U;
+        for (Stream = 0; Stream < STREAMS; Stream++)
+        {
+            FillBuffer(Stream);
+            ConvGraphWrite(&Graphs[Stream], Input[Stream], sizeof(Input[Stream]));
+            Frames = min(Frames, Graphs[Stream].QueueFill);
+        }
+        ConvGraphMix(&Graphs[0], Others, STREAMS - 1, Frames);
+        TrackSteps(Graphs[0].Output, Frames);
+        Total += Frames;
+    }
+    Report("mix4", Seconds, Total, Start, clock());
+    for (Stream = 0; Stream < STREAMS; Stream++)
+        ConvGraphFree(&Graphs[Stream]);
+
+    return 0;
+}
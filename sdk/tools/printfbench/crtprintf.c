@@ -0,0 +1,42 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     CRT printf core built for the host, see include/ for the CRT headers
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+/* Write straight into the string, as the kernel mode CRT does */
+#define _LIBCNT_
+
+#define __int64 long long
+#define __declspec(x) __attribute__((x))
+#define _isnan(x) isnan(x)
+#define _finite(x) isfinite(x)
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/* <wchar.h> of the host would bring its own FILE */
+size_t wcsnlen(const wchar_t *String, size_t Count);
+
+/*
+ * streamout takes the address of its va_list, which only works where va_list
+ * is a plain pointer. Build it with the Windows calling convention on x64.
+ */
+#ifdef __x86_64__
+#undef va_list
+#undef va_start
+#undef va_end
+#define va_list __builtin_ms_va_list
+#define va_start(Args, Last) __builtin_ms_va_start(Args, Last)
+#define va_end(Args) __builtin_ms_va_end(Args)
+#define __cdecl __attribute__((ms_abi))
+#define _WIN64
+#else
+#define __cdecl
+#endif
+
+#include "printf/streamout.c"
+#include "printf/_vsnprintf.c"
+
+/* EOF */
@@ -0,0 +1,31 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Stands in for the CRT <stdio.h> when building its printf core on the host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdarg.h>
+
+#define EOF     (-1)
+
+#define _IOWRT  0x0002
+#define _IOSTRG 0x0040
+
+/* Same layout as the CRT stream, only string streams are used */
+typedef struct _iobuf
+{
+    char *_ptr;
+    int _cnt;
+    char *_base;
+    int _flag;
+    int _file;
+    int _charbuf;
+    int _bufsiz;
+    char *_tmpfname;
+} FILE;
+
+/* EOF */
@@ -0,0 +1,20 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Stands in for the CRT <tchar.h> when building its printf core on the host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#pragma once
+
+#include <string.h>
+
+typedef char TCHAR;
+typedef char _TCHAR;
+
+#define _T(x)       x
+#define _TEOF       EOF
+#define _tcslen     strlen
+#define _tcscpy     strcpy
+
+/* EOF */
@@ -0,0 +1,438 @@
+/*
+ * PROJECT:     ReactOS host tools
+ * LICENSE:     GPL-2.0+ (https://spdx.org/licenses/GPL-2.0+)
+ * PURPOSE:     Checks the CRT printf core byte for byte and benchmarks it,
+ *              runs natively on the build host
+ * COPYRIGHT:   Copyright 2026 ReactOS Team
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fenv.h>
+#include <math.h>
+#include <time.h>
+
+#define DEFAULT_ROUNDS  200000
+#define DEFAULT_CALLS   1000000
+#define MAX_ERRORS      20
+#define FLOAT_DIGITS    17
+
+/* How far the host has to expand a value to tell a halfway case */
+#define EXACT_DIGITS    1100
+
+/* The CRT is built with the calling convention of its target, see crtprintf.c */
+#ifdef __x86_64__
+#define CRTCALL __attribute__((ms_abi))
+typedef __builtin_ms_va_list CRT_VA_LIST;
+#define CRT_VA_START(Args, Last) __builtin_ms_va_start(Args, Last)
+#define CRT_VA_END(Args) __builtin_ms_va_end(Args)
+#else
+#define CRTCALL
+typedef va_list CRT_VA_LIST;
+#define CRT_VA_START(Args, Last) va_start(Args, Last)
+#define CRT_VA_END(Args) va_end(Args)
+#endif
+
+extern int CRTCALL _vsnprintf(char *Buffer, size_t Count, const char *Format, CRT_VA_LIST Args);
+
+typedef struct _FLOAT_CASE
+{
+    const char *Format;
+    double Value;
+    const char *Expected;
+} FLOAT_CASE;
+
+typedef struct _INT_CASE
+{
+    const char *Format;
+    long long Value;
+    const char *Expected;
+} INT_CASE;
+
+/* What msvcrt prints where the C library of the host differs */
+static const FLOAT_CASE FloatCases[] =
+{
+    { "%.0f", 0.5, "1" },
+    { "%.0f", 2.5, "3" },
+    { "%.0f", 0.6, "1" },
+    { "%.2f", 1.005, "1.00" },
+    { "%.1f", 0.05, "0.1" },
+    { "%.3f", 0.0006, "0.001" },
+    { "%.2f", 0.125, "0.13" },
+    { "%.0e", 9.5, "1e+001" },
+    { "%2.4e", 8.6, "8.6000e+000" },
+    { "%+#23.15e", 789456123., "+7.894561230000000e+008" },
+    { "%e", 4.9e-324, "4.940656e-324" },
+    { "%E", 1e300, "1.000000E+300" },
+    { "%.20f", 0.1, "0.10000000000000001000" },
+    { "%.0f", 1e23, "99999999999999992000000" },
+    { "%.25e", 1.0 / 3, "3.3333333333333331000000000e-001" },
+    { "%g", 0., "0" },
+    { "%g", 100000., "100000" },
+    { "%g", 999999.5, "1e+006" },
+    { "%g", 0.0001, "0.0001" },
+    { "%g", 0.00001, "1e-005" },
+    { "%g", 123456789., "1.23457e+008" },
+    { "%g", 0.000123456789, "0.000123457" },
+    { "%G", 1e-10, "1E-010" },
+    { "%#g", 1., "1.00000" },
+    { "%#1.1g", 789456123., "8.e+008" },
+    { "%-12.3e|", -2.5, "-2.500e+000 |" },
+    { "%013.3e", -2.5, "-002.500e+000" },
+};
+
+static const INT_CASE IntCases[] =
+{
+    { "%I64d", -9223372036854775807ll - 1, "-9223372036854775808" },
+    { "%I64u", -1ll, "18446744073709551615" },
+    { "%I64x", 0x123456789abcdefll, "123456789abcdef" },
+    { "%#I64o", 01234567012345670123ll, "01234567012345670123" },
+    { "%I32d", -1, "-1" },
+};
+
+static unsigned int Seed = 0x9E3779B9;
+static unsigned long Errors, Checked, Skipped;
+
+static unsigned int
+Random(void)
+{
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    return Seed;
+}
+
+static int CRTCALL
+CrtFormat(char *Buffer, size_t Count, const char *Format, ...)
+{
+    CRT_VA_LIST Args;
+    int Length;
+
+    CRT_VA_START(Args, Format);
+    Length = _vsnprintf(Buffer, Count, Format, Args);
+    CRT_VA_END(Args);
+
+    return Length;
+}
+
+static void
+Compare(const char *Format, const char *Expected, const char *Actual, double Value)
+{
+    Checked++;
+    if (!strcmp(Expected, Actual))
+        return;
+
+    if (++Errors <= MAX_ERRORS)
+    {
+        printf("\"%s\" (%.17g, %a): got \"%s\", expected \"%s\"\n",
+               Format, Value, Value, Actual, Expected);
+    }
+}
+
+static void
+CheckFixedCases(void)
+{
+    char Buffer[512];
+    size_t i;
+
+    for (i = 0; i < sizeof(FloatCases) / sizeof(FloatCases[0]); i++)
+    {
+        CrtFormat(Buffer, sizeof(Buffer), FloatCases[i].Format, FloatCases[i].Value);
+        Compare(FloatCases[i].Format, FloatCases[i].Expected, Buffer, FloatCases[i].Value);
+    }
+
+    for (i = 0; i < sizeof(IntCases) / sizeof(IntCases[0]); i++)
+    {
+        CrtFormat(Buffer, sizeof(Buffer), IntCases[i].Format, IntCases[i].Value);
+        Compare(IntCases[i].Format, IntCases[i].Expected, Buffer, (double)IntCases[i].Value);
+    }
+}
+
+/* Appends a random set of flags, a width and a precision */
+static char *
+RandomSpec(char *Spec, const char *Flags, int *Width, int MaxPrecision)
+{
+    const char *Flag;
+
+    for (Flag = Flags; *Flag; Flag++)
+    {
+        if (!(Random() % 4)) *Spec++ = *Flag;
+    }
+
+    *Width = (Random() % 2) ? (int)(Random() % 30) : 0;
+    if (*Width) Spec += sprintf(Spec, "%d", *Width);
+
+    if (Random() % 4)
+        Spec += sprintf(Spec, ".%d", (int)(Random() % (MaxPrecision + 1)));
+
+    return Spec;
+}
+
+static void
+FuzzInteger(void)
+{
+    static const char Conversions[] = "diuoxX";
+    char Format[32], HostFormat[32], Expected[128], Actual[128], *Spec;
+    char Conversion = Conversions[Random() % 6];
+    long long Value;
+    int Width, Size = Random() % 3;
+
+    /* Values of all magnitudes */
+    Value = ((long long)Random() << 32) | Random();
+    Value >>= Random() % 64;
+
+    Format[0] = '%';
+    Spec = RandomSpec(Format + 1, (Conversion == 'o' || Conversion == 'x' || Conversion == 'X') ? "-+ 0#" : "-+ 0",
+                      &Width, 25);
+    strcpy(HostFormat, Format);
+
+    /* C drops the 0 flag when there is a precision, leave that to the apitests */
+    if (Format[strspn(Format + 1, "-+ #") + 1] == '0' && strchr(Format, '.'))
+    {
+        Skipped++;
+        return;
+    }
+
+    if (Size == 0)
+    {
+        sprintf(Spec, "%c", Conversion);
+        sprintf(HostFormat + (Spec - Format), "%c", Conversion);
+        CrtFormat(Actual, sizeof(Actual), Format, (int)Value);
+        snprintf(Expected, sizeof(Expected), HostFormat, (int)Value);
+    }
+    else if (Size == 1)
+    {
+        sprintf(Spec, "h%c", Conversion);
+        sprintf(HostFormat + (Spec - Format), "h%c", Conversion);
+        CrtFormat(Actual, sizeof(Actual), Format, (int)Value);
+        snprintf(Expected, sizeof(Expected), HostFormat, (int)Value);
+    }
+    else
+    {
+        sprintf(Spec, "I64%c", Conversion);
+        sprintf(HostFormat + (Spec - Format), "ll%c", Conversion);
+        CrtFormat(Actual, sizeof(Actual), Format, Value);
+        snprintf(Expected, sizeof(Expected), HostFormat, Value);
+    }
+
+    Compare(Format, Expected, Actual, (double)Value);
+}
+
+/* Doubles from all over the range, and ones with short decimal expansions */
+static double
+RandomDouble(void)
+{
+    union
+    {
+        double d;
+        unsigned long long u;
+    } Bits;
+    static const double Scale[] = { 1., 10., 100., 1000., 1e4, 1e5, 1e6, 1e9 };
+
+    switch (Random() % 4)
+    {
+        case 0:
+            do
+            {
+                Bits.u = ((unsigned long long)Random() << 32) | Random();
+            } while (((Bits.u >> 52) & 0x7FF) == 0x7FF);
+            return Bits.d;
+
+        case 1:
+            /* Halfway cases for some precision */
+            return ((double)(Random() % 100000) + 0.5) / Scale[Random() % 4];
+
+        case 2:
+            return (double)(int)Random() / Scale[Random() % 8];
+
+        default:
+            Bits.d = (double)Random() / ((Random() | 1) % 100000 + 1);
+            Bits.d *= Scale[Random() % 8];
+            return (Random() % 2) ? Bits.d : 1.0 / Bits.d;
+    }
+}
+
+/* msvcrt always prints at least 3 exponent digits */
+static void
+WidenExponent(char *String)
+{
+    char *Exponent = strpbrk(String, "eE");
+
+    if (Exponent && strlen(Exponent + 2) == 2)
+    {
+        memmove(Exponent + 3, Exponent + 2, 3);
+        Exponent[2] = '0';
+    }
+}
+
+/* Pads the unpadded host output like the CRT does */
+static void
+PadField(char *String, const char *Flags, int Width)
+{
+    size_t Length = strlen(String), Pad, Sign;
+
+    if (!Width || Length >= (size_t)Width)
+        return;
+
+    Pad = Width - Length;
+    if (strchr(Flags, '-'))
+    {
+        memset(String + Length, ' ', Pad);
+        String[Width] = 0;
+    }
+    else if (strchr(Flags, '0'))
+    {
+        Sign = (String[0] == '-' || String[0] == '+' || String[0] == ' ');
+        memmove(String + Sign + Pad, String + Sign, Length - Sign + 1);
+        memset(String + Sign, '0', Pad);
+    }
+    else
+    {
+        memmove(String + Pad, String, Length + 1);
+        memset(String, ' ', Pad);
+    }
+}
+
+/*
+ * Returns the number of significant digits the conversion keeps, counted from
+ * the first nonzero one, and whether the value lies exactly halfway there.
+ */
+static int
+CountDigits(double Value, char Conversion, int Precision, int *Halfway)
+{
+    static char Exact[EXACT_DIGITS + 32];
+    char *Digits, *Exponent;
+    int Decimal, Count, i;
+
+    /* d.ddd...e+x, exact */
+    snprintf(Exact, sizeof(Exact), "%.*e", EXACT_DIGITS, Value);
+    Digits = Exact + (Exact[0] == '-');
+    Exponent = strchr(Digits, 'e');
+    Decimal = atoi(Exponent + 1);
+    *Exponent = 0;
+    memmove(Digits + 1, Digits + 2, strlen(Digits + 2) + 1);
+
+    if (Conversion == 'f')
+        Count = Decimal + 1 + Precision;
+    else if (Conversion == 'e' || Conversion == 'E')
+        Count = Precision + 1;
+    else
+        Count = Precision ? Precision : 1;
+
+    *Halfway = 0;
+    if (Value != 0. && Count >= 0 && Digits[Count] == '5')
+    {
+        *Halfway = 1;
+        for (i = Count + 1; Digits[i]; i++)
+        {
+            if (Digits[i] != '0') *Halfway = 0;
+        }
+    }
+
+    return (Value == 0.) ? 0 : Count;
+}
+
+static void
+FuzzFloat(void)
+{
+    static const char Conversions[] = "eEfgG";
+    static char Expected[2 * EXACT_DIGITS], Actual[2 * EXACT_DIGITS];
+    char Format[32], HostFormat[32], Flags[8], *Spec, *Start;
+    char Conversion = Conversions[Random() % 5];
+    double Value = RandomDouble();
+    int Width, Precision, Halfway;
+
+    Format[0] = '%';
+    Spec = RandomSpec(Format + 1, "-+ 0#", &Width, FLOAT_DIGITS);
+    sprintf(Spec, "%c", Conversion);
+
+    /* Significant digits past the 17th are zeroes, rounded on the 17th */
+    Start = strchr(Format, '.');
+    Precision = Start ? atoi(Start + 1) : 6;
+    if (CountDigits(Value, (Conversion == 'f') ? 'f' : Conversion, Precision, &Halfway) > FLOAT_DIGITS ||
+        (Conversion == 'f' && fabs(Value) >= 1e300))
+    {
+        Skipped++;
+        return;
+    }
+
+    /* The host prints without the width, the exponent gets widened first */
+    memset(Flags, 0, sizeof(Flags));
+    for (Start = Format + 1; strchr("-+ 0#", *Start); Start++)
+        Flags[Start - Format - 1] = *Start;
+    sprintf(HostFormat, "%%%s%s", Flags, Start + (Width ? (Width >= 10 ? 2 : 1) : 0));
+
+    /* Halfway cases go away from zero */
+    if (Halfway) fesetround(Value > 0 ? FE_UPWARD : FE_DOWNWARD);
+    snprintf(Expected, sizeof(Expected), HostFormat, Value);
+    fesetround(FE_TONEAREST);
+
+    WidenExponent(Expected);
+    PadField(Expected, Flags, Width);
+
+    CrtFormat(Actual, sizeof(Actual), Format, Value);
+    Compare(Format, Expected, Actual, Value);
+}
+
+static void
+Benchmark(const char *Name, unsigned long Calls, int Crt, int Floats)
+{
+    char Buffer[128];
+    unsigned long i;
+    clock_t Start, End;
+    double Seconds;
+
+    Start = clock();
+    for (i = 0; i < Calls; i++)
+    {
+        if (Floats && Crt)
+            CrtFormat(Buffer, sizeof(Buffer), "%g %.3f %e", i * 1.37, i * 0.01, i * 1e-7);
+        else if (Floats)
+            snprintf(Buffer, sizeof(Buffer), "%g %.3f %e", i * 1.37, i * 0.01, i * 1e-7);
+        else if (Crt)
+            CrtFormat(Buffer, sizeof(Buffer), "%u %x %I64d", i * 7919, (unsigned int)i, i * 1000003ll);
+        else
+            snprintf(Buffer, sizeof(Buffer), "%u %x %lld", (unsigned int)(i * 7919), (unsigned int)i, i * 1000003ll);
+    }
+    End = clock();
+
+    Seconds = (double)(End - Start) / CLOCKS_PER_SEC;
+    printf("%-16s %8lu calls in %6.3f s, %7.1f ns per call\n",
+           Name, Calls, Seconds, Seconds * 1e9 / Calls);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long Rounds = DEFAULT_ROUNDS, Calls = DEFAULT_CALLS, r;
+
+    if (argc > 1) Rounds = strtoul(argv[1], NULL, 0);
+    if (argc > 2) Calls = strtoul(argv[2], NULL, 0);
+    if (argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [fuzz rounds] [benchmark calls]\n", argv[0]);
+        return 2;
+    }
+
+    CheckFixedCases();
+
+    for (r = 0; r < Rounds; r++)
+    {
+        FuzzInteger();
+        FuzzFloat();
+    }
+
+    printf("%lu conversions compared, %lu skipped, %lu mismatch(es): %s\n",
+           Checked, Skipped, Errors, Errors ? "FAILED" : "OK");
+
+    if (Calls)
+    {
+        Benchmark("CRT integers", Calls, 1, 0);
+        Benchmark("host integers", Calls, 0, 0);
+        Benchmark("CRT floats", Calls, 1, 1);
+        Benchmark("host floats", Calls, 0, 1);
+    }
+
+    return Errors ? 1 : 0;
+}
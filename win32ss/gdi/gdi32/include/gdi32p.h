@@ -402,6 +402,11 @@ GdiAllocBatchCommand(
     else if (Cmd == GdiBCSelObj) cjSize = sizeof(GDIBSOBJECT);
     else if (Cmd == GdiBCDelRgn) cjSize = sizeof(GDIBSOBJECT);
     else if (Cmd == GdiBCDelObj) cjSize = sizeof(GDIBSOBJECT);
+    else if (Cmd == GdiBCLineTo) cjSize = sizeof(GDIBSLINETO);
+    else if (Cmd == GdiBCRectangle) cjSize = sizeof(GDIBSSHAPE);
+    else if (Cmd == GdiBCEllipse) cjSize = sizeof(GDIBSSHAPE);
+    else if (Cmd == GdiBCPolyPolyDraw) cjSize = sizeof(GDIBSPOLYPOLY);
+    else if (Cmd == GdiBCSetPixel) cjSize = sizeof(GDIBSSETPIXEL);
     else cjSize = 0;
 
     /* Unsupported operation */
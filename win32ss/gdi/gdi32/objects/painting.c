@@ -1,5 +1,132 @@
 #include <precomp.h>
 
+/* Snapshot the attributes a queued line or shape command draws with */
+static
+VOID
+GdiSetBatchDrawAttr(
+    _Out_ PGDIBSDRAWATTR pAttr,
+    _In_ PDC_ATTR pdcattr)
+{
+    pAttr->hpen            = pdcattr->hpen;
+    pAttr->hbrush          = pdcattr->hbrush;
+    pAttr->crForegroundClr = pdcattr->crForegroundClr;
+    pAttr->crBackgroundClr = pdcattr->crBackgroundClr;
+    pAttr->crBrushClr      = pdcattr->crBrushClr;
+    pAttr->crPenClr        = pdcattr->crPenClr;
+    pAttr->ulForegroundClr = pdcattr->ulForegroundClr;
+    pAttr->ulBackgroundClr = pdcattr->ulBackgroundClr;
+    pAttr->ulBrushClr      = pdcattr->ulBrushClr;
+    pAttr->ulPenClr        = pdcattr->ulPenClr;
+    pAttr->lBkMode         = pdcattr->lBkMode;
+}
+
+/* Move the current position on our side, win32k catches up on flush */
+static
+VOID
+GdiSetBatchCurrentPosition(
+    _In_ PDC_ATTR pdcattr,
+    _In_ INT x,
+    _In_ INT y)
+{
+    pdcattr->ptlCurrent.x = x;
+    pdcattr->ptlCurrent.y = y;
+
+    pdcattr->ulDirty_ &= ~DIRTY_PTLCURRENT;
+    pdcattr->ulDirty_ |= (DIRTY_PTFXCURRENT|DIRTY_STYLESTATE);
+}
+
+static
+BOOL
+GdiBatchShape(
+    _In_ HDC hdc,
+    _In_ USHORT Cmd,
+    _In_ INT left,
+    _In_ INT top,
+    _In_ INT right,
+    _In_ INT bottom)
+{
+    PDC_ATTR pdcattr;
+    PGDIBSSHAPE pgO;
+
+    /* Get the DC attribute */
+    pdcattr = GdiGetDcAttr(hdc);
+    if (!pdcattr || (pdcattr->ulDirty_ & DC_DIBSECTION))
+        return FALSE;
+
+    pgO = GdiAllocBatchCommand(hdc, Cmd);
+    if (!pgO)
+        return FALSE;
+
+    pdcattr->ulDirty_ |= DC_MODE_DIRTY;
+    GdiSetBatchDrawAttr(&pgO->Attr, pdcattr);
+    pgO->rcl.left   = left;
+    pgO->rcl.top    = top;
+    pgO->rcl.right  = right;
+    pgO->rcl.bottom = bottom;
+    return TRUE;
+}
+
+static
+BOOL
+GdiBatchPolyPolyDraw(
+    _In_ HDC hdc,
+    _In_ CONST POINT *apt,
+    _In_reads_(csz) CONST ULONG *asz,
+    _In_ ULONG csz,
+    _In_ INT iFunc)
+{
+    PDC_ATTR pdcattr;
+    PGDIBSPOLYPOLY pgO;
+    PTEB pTeb = NtCurrentTeb();
+    ULONG i, cpt = 0, cjSize;
+
+    /* Get the DC attribute */
+    pdcattr = GdiGetDcAttr(hdc);
+    if (!pdcattr || (pdcattr->ulDirty_ & (DC_DIBSECTION|DIRTY_PTLCURRENT)))
+        return FALSE;
+
+    /* Leave what win32k would refuse to the syscall, it sets the last error */
+    if ((csz == 0) || (csz > GDIBATCHBUFSIZE / sizeof(ULONG)))
+        return FALSE;
+    for (i = 0; i < csz; i++)
+    {
+        if (asz[i] < 2 || asz[i] > GDIBATCHBUFSIZE / sizeof(POINT))
+            return FALSE;
+        cpt += asz[i];
+    }
+    if (cpt > GDIBATCHBUFSIZE / sizeof(POINT))
+        return FALSE;
+
+    pgO = GdiAllocBatchCommand(hdc, GdiBCPolyPolyDraw);
+    if (!pgO)
+        return FALSE;
+
+    // One count is already accounted for in the structure.
+    cjSize = (csz - 1) * sizeof(ULONG) + cpt * sizeof(POINT);
+    if ((pTeb->GdiTebBatch.Offset + cjSize) > GDIBATCHBUFSIZE)
+    {
+        // Reset offset and count and let the caller do the syscall
+        pTeb->GdiTebBatch.Offset -= sizeof(GDIBSPOLYPOLY);
+        pTeb->GdiBatchCount--;
+        return FALSE;
+    }
+
+    pdcattr->ulDirty_ |= DC_MODE_DIRTY;
+    GdiSetBatchDrawAttr(&pgO->Attr, pdcattr);
+    pgO->ptlCurrent = pdcattr->ptlCurrent;
+    pgO->iFunc = iFunc;
+    pgO->Count = csz;
+    RtlCopyMemory(pgO->Buffer, asz, csz * sizeof(ULONG));
+    RtlCopyMemory(&pgO->Buffer[csz], apt, cpt * sizeof(POINT));
+    pTeb->GdiTebBatch.Offset += cjSize;
+    ((PGDIBATCHHDR)pgO)->Size += cjSize;
+
+    if ((iFunc == GdiPolyLineTo) || (iFunc == GdiPolyBezierTo))
+    {
+        GdiSetBatchCurrentPosition(pdcattr, apt[cpt - 1].x, apt[cpt - 1].y);
+    }
+    return TRUE;
+}
 
 /*
  * @implemented
@@ -11,10 +138,31 @@ LineTo(
     _In_ INT x,
     _In_ INT y )
 {
+    PDC_ATTR pdcattr;
+
     HANDLE_METADC(BOOL, LineTo, FALSE, hdc, x, y);
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    /* Get the DC attribute */
+    pdcattr = GdiGetDcAttr(hdc);
+    if (pdcattr && !(pdcattr->ulDirty_ & (DC_DIBSECTION|DIRTY_PTLCURRENT)))
+    {
+        PGDIBSLINETO pgO;
+
+        pgO = GdiAllocBatchCommand(hdc, GdiBCLineTo);
+        if (pgO)
+        {
+            pdcattr->ulDirty_ |= DC_MODE_DIRTY;
+            GdiSetBatchDrawAttr(&pgO->Attr, pdcattr);
+            pgO->ptlCurrent = pdcattr->ptlCurrent;
+            pgO->ptl.x = x;
+            pgO->ptl.y = y;
+            GdiSetBatchCurrentPosition(pdcattr, x, y);
+            return TRUE;
+        }
+    }
+
     return NtGdiLineTo(hdc, x, y);
 }
 
@@ -79,6 +227,9 @@ Ellipse(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchShape(hdc, GdiBCEllipse, left, top, right, bottom))
+        return TRUE;
+
     return NtGdiEllipse(hdc, left, top, right, bottom);
 }
 
@@ -99,6 +250,9 @@ Rectangle(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchShape(hdc, GdiBCRectangle, left, top, right, bottom))
+        return TRUE;
+
     return NtGdiRectangle(hdc, left, top, right, bottom);
 }
 
@@ -171,6 +325,28 @@ SetPixelV(
     _In_ INT y,
     _In_ COLORREF crColor)
 {
+    PDC_ATTR pdcattr;
+
+    /* Unlike SetPixel, nobody waits for the resulting color, so queue it */
+    if (GDI_HANDLE_GET_TYPE(hdc) == GDILoObjType_LO_DC_TYPE)
+    {
+        pdcattr = GdiGetDcAttr(hdc);
+        if (pdcattr && !(pdcattr->ulDirty_ & DC_DIBSECTION))
+        {
+            PGDIBSSETPIXEL pgO;
+
+            pgO = GdiAllocBatchCommand(hdc, GdiBCSetPixel);
+            if (pgO)
+            {
+                pdcattr->ulDirty_ |= DC_MODE_DIRTY;
+                pgO->ptl.x = x;
+                pgO->ptl.y = y;
+                pgO->crColor = crColor;
+                return TRUE;
+            }
+        }
+    }
+
     return SetPixel(hdc, x, y, crColor) != CLR_INVALID;
 }
 
@@ -269,6 +445,9 @@ PolyBezier(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, &cpt, 1, GdiPolyBezier))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc ,(PPOINT)apt, &cpt, 1, GdiPolyBezier);
 }
 
@@ -287,6 +466,9 @@ PolyBezierTo(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, &cpt, 1, GdiPolyBezierTo))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc , (PPOINT)apt, &cpt, 1, GdiPolyBezierTo);
 }
 
@@ -324,6 +506,9 @@ Polygon(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, (PULONG)&cpt, 1, GdiPolyPolygon))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc , (PPOINT)apt, (PULONG)&cpt, 1, GdiPolyPolygon);
 }
 
@@ -342,6 +527,9 @@ Polyline(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, (PULONG)&cpt, 1, GdiPolyPolyLine))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc, (PPOINT)apt, (PULONG)&cpt, 1, GdiPolyPolyLine);
 }
 
@@ -360,6 +548,9 @@ PolylineTo(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, &cpt, 1, GdiPolyLineTo))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc , (PPOINT)apt, &cpt, 1, GdiPolyLineTo);
 }
 
@@ -379,6 +570,9 @@ PolyPolygon(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, (PULONG)asz, csz, GdiPolyPolygon))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc, (PPOINT)apt, (PULONG)asz, csz, GdiPolyPolygon);
 }
 
@@ -401,6 +595,9 @@ PolyPolyline(
 
     if ( GdiConvertAndCheckDC(hdc) == NULL ) return FALSE;
 
+    if (GdiBatchPolyPolyDraw(hdc, apt, asz, csz, GdiPolyPolyLine))
+        return TRUE;
+
     return NtGdiPolyPolyDraw(hdc , (PPOINT)apt, (PULONG)asz, csz, GdiPolyPolyLine);
 }
 
@@ -62,6 +62,109 @@ SynchronizeDriver(FLONG Flags)
   return;
 }
 
+#define GDIBATCH_SWAP(a, b, tmp) { tmp = (a); (a) = (b); (b) = tmp; }
+
+//
+// Exchange the pen, brush and colors queued with a line or shape command
+// and the ones the client has moved on to. Only what differs is touched,
+// so a run of commands without state changes costs no brush realization.
+// The same call puts everything back afterwards.
+//
+static
+FLONG
+GdiSwapDrawAttr(PDC dc, PGDIBSDRAWATTR pAttr)
+{
+  PDC_ATTR pdcattr = dc->pdcattr;
+  FLONG flags = 0;
+  HANDLE hTmp;
+  ULONG ulTmp;
+  LONG lTmp;
+
+  if (pdcattr->hpen != pAttr->hpen)
+  {
+     GDIBATCH_SWAP(pdcattr->hpen, pAttr->hpen, hTmp);
+     flags |= DC_PEN_DIRTY;
+  }
+  if (pdcattr->hbrush != pAttr->hbrush)
+  {
+     GDIBATCH_SWAP(pdcattr->hbrush, pAttr->hbrush, hTmp);
+     flags |= DC_BRUSH_DIRTY;
+  }
+  if (pdcattr->crPenClr != pAttr->crPenClr)
+  {
+     GDIBATCH_SWAP(pdcattr->crPenClr, pAttr->crPenClr, ulTmp);
+     GDIBATCH_SWAP(pdcattr->ulPenClr, pAttr->ulPenClr, ulTmp);
+     flags |= DIRTY_LINE;
+  }
+  if (pdcattr->crBrushClr != pAttr->crBrushClr)
+  {
+     GDIBATCH_SWAP(pdcattr->crBrushClr, pAttr->crBrushClr, ulTmp);
+     GDIBATCH_SWAP(pdcattr->ulBrushClr, pAttr->ulBrushClr, ulTmp);
+     flags |= DIRTY_FILL;
+  }
+  if (pdcattr->crForegroundClr != pAttr->crForegroundClr)
+  {
+     GDIBATCH_SWAP(pdcattr->crForegroundClr, pAttr->crForegroundClr, ulTmp);
+     GDIBATCH_SWAP(pdcattr->ulForegroundClr, pAttr->ulForegroundClr, ulTmp);
+     flags |= (DIRTY_FILL|DIRTY_LINE|DIRTY_TEXT);
+  }
+  if (pdcattr->crBackgroundClr != pAttr->crBackgroundClr)
+  {
+     GDIBATCH_SWAP(pdcattr->crBackgroundClr, pAttr->crBackgroundClr, ulTmp);
+     GDIBATCH_SWAP(pdcattr->ulBackgroundClr, pAttr->ulBackgroundClr, ulTmp);
+     flags |= (DIRTY_FILL|DIRTY_LINE|DIRTY_BACKGROUND);
+  }
+  if (pdcattr->lBkMode != pAttr->lBkMode)
+  {
+     GDIBATCH_SWAP(pdcattr->lBkMode, pAttr->lBkMode, lTmp);
+     pdcattr->jBkMode = (BYTE)pdcattr->lBkMode;
+  }
+
+  pdcattr->ulDirty_ |= flags;
+  return flags;
+}
+
+//
+// Put the queued attributes in place, returns what to restore afterwards.
+//
+static
+FLONG
+GdiBeginBatchDraw(PDC dc, PGDIBSDRAWATTR pAttr)
+{
+  FLONG saveflags;
+
+  saveflags = dc->pdcattr->ulDirty_ & (DIRTY_FILL|DIRTY_LINE|DIRTY_TEXT|DIRTY_BACKGROUND|DC_BRUSH_DIRTY|DC_PEN_DIRTY);
+  GdiSwapDrawAttr(dc, pAttr);
+  return saveflags;
+}
+
+static
+VOID
+GdiEndBatchDraw(PDC dc, PGDIBSDRAWATTR pAttr, FLONG saveflags)
+{
+  dc->pdcattr->ulDirty_ |= saveflags | GdiSwapDrawAttr(dc, pAttr);
+}
+
+//
+// Line commands start from the position current when they were queued. The
+// client has already moved it on, so swap it the same way.
+//
+static
+VOID
+GdiSwapCurrentPosition(PDC dc, PPOINTL pptlCurrent, PPOINTL pptfxCurrent, FLONG *pflags)
+{
+  PDC_ATTR pdcattr = dc->pdcattr;
+  POINTL ptlTmp;
+  FLONG flTmp;
+
+  GDIBATCH_SWAP(pdcattr->ptlCurrent, *pptlCurrent, ptlTmp);
+  GDIBATCH_SWAP(pdcattr->ptfxCurrent, *pptfxCurrent, ptlTmp);
+  flTmp = pdcattr->ulDirty_ & (DIRTY_PTLCURRENT|DIRTY_PTFXCURRENT|DIRTY_STYLESTATE);
+  pdcattr->ulDirty_ &= ~(DIRTY_PTLCURRENT|DIRTY_PTFXCURRENT|DIRTY_STYLESTATE);
+  pdcattr->ulDirty_ |= *pflags;
+  *pflags = flTmp;
+}
+
 //
 // Process the batch.
 //
@@ -453,6 +556,84 @@ GdiFlushUserBatch(PDC dc, PGDIBATCHHDR pHdr)
         break;
      }
 
+     case GdiBCLineTo:
+     {
+        PGDIBSLINETO pgO;
+        POINTL ptlCurrent, ptfxCurrent;
+        FLONG saveflags, flPos;
+        if (!dc) break;
+        pgO = (PGDIBSLINETO) pHdr;
+
+        saveflags = GdiBeginBatchDraw(dc, &pgO->Attr);
+        ptlCurrent = ptfxCurrent = pgO->ptlCurrent;
+        flPos = DIRTY_PTFXCURRENT|DIRTY_STYLESTATE;
+        GdiSwapCurrentPosition(dc, &ptlCurrent, &ptfxCurrent, &flPos);
+
+        DC_vPrepareDCsForBlit(dc, NULL, NULL, NULL);
+        IntGdiLineTo(dc, pgO->ptl.x, pgO->ptl.y);
+        DC_vFinishBlit(dc, NULL);
+
+        GdiSwapCurrentPosition(dc, &ptlCurrent, &ptfxCurrent, &flPos);
+        GdiEndBatchDraw(dc, &pgO->Attr, saveflags);
+        break;
+     }
+
+     case GdiBCRectangle:
+     case GdiBCEllipse:
+     {
+        PGDIBSSHAPE pgO;
+        FLONG saveflags;
+        if (!dc) break;
+        pgO = (PGDIBSSHAPE) pHdr;
+
+        saveflags = GdiBeginBatchDraw(dc, &pgO->Attr);
+        // The DC lock is recursive, the flush already holds it.
+        if (Cmd == GdiBCRectangle)
+        {
+           NtGdiRectangle(dc->BaseObject.hHmgr, pgO->rcl.left, pgO->rcl.top, pgO->rcl.right, pgO->rcl.bottom);
+        }
+        else
+        {
+           NtGdiEllipse(dc->BaseObject.hHmgr, pgO->rcl.left, pgO->rcl.top, pgO->rcl.right, pgO->rcl.bottom);
+        }
+        GdiEndBatchDraw(dc, &pgO->Attr, saveflags);
+        break;
+     }
+
+     case GdiBCPolyPolyDraw:
+     {
+        PGDIBSPOLYPOLY pgO;
+        POINTL ptlCurrent, ptfxCurrent;
+        FLONG saveflags, flPos;
+        if (!dc) break;
+        pgO = (PGDIBSPOLYPOLY) pHdr;
+
+        saveflags = GdiBeginBatchDraw(dc, &pgO->Attr);
+        ptlCurrent = ptfxCurrent = pgO->ptlCurrent;
+        flPos = DIRTY_PTFXCURRENT|DIRTY_STYLESTATE;
+        GdiSwapCurrentPosition(dc, &ptlCurrent, &ptfxCurrent, &flPos);
+
+        // The counts and points still live in the TEB, let it probe them.
+        NtGdiPolyPolyDraw(dc->BaseObject.hHmgr,
+                          (PPOINT)&pgO->Buffer[pgO->Count],
+                          pgO->Buffer,
+                          pgO->Count,
+                          pgO->iFunc);
+
+        GdiSwapCurrentPosition(dc, &ptlCurrent, &ptfxCurrent, &flPos);
+        GdiEndBatchDraw(dc, &pgO->Attr, saveflags);
+        break;
+     }
+
+     case GdiBCSetPixel:
+     {
+        PGDIBSSETPIXEL pgO;
+        if (!dc) break;
+        pgO = (PGDIBSSETPIXEL) pHdr;
+        NtGdiSetPixel(dc->BaseObject.hHmgr, pgO->ptl.x, pgO->ptl.y, pgO->crColor);
+        break;
+     }
+
      default:
         break;
   }
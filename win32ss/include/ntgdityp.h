@@ -92,6 +92,11 @@ typedef enum _GDIBATCHCMD
     GdiBCSelObj,
     GdiBCDelObj,
     GdiBCDelRgn,
+    GdiBCLineTo,
+    GdiBCRectangle,
+    GdiBCEllipse,
+    GdiBCPolyPolyDraw,
+    GdiBCSetPixel,
 } GDIBATCHCMD, *PGDIBATCHCMD;
 
 typedef enum _TRANSFORMTYPE
@@ -560,6 +565,58 @@ typedef struct _GDIBSOBJECT
   HGDIOBJ hgdiobj;
 } GDIBSOBJECT, *PGDIBSOBJECT;
 
+//
+// Pen, brush and colors in effect when a line or shape command was queued.
+// ROP2, fill mode and transform changes flush the batch instead.
+//
+typedef struct _GDIBSDRAWATTR
+{
+  HANDLE hpen;
+  HANDLE hbrush;
+  COLORREF crForegroundClr;
+  COLORREF crBackgroundClr;
+  COLORREF crBrushClr;
+  COLORREF crPenClr;
+  ULONG ulForegroundClr;
+  ULONG ulBackgroundClr;
+  ULONG ulBrushClr;
+  ULONG ulPenClr;
+  LONG lBkMode;
+} GDIBSDRAWATTR, *PGDIBSDRAWATTR;
+
+typedef struct _GDIBSLINETO
+{
+  GDIBATCHHDR gbHdr;
+  GDIBSDRAWATTR Attr;
+  POINTL ptlCurrent;
+  POINTL ptl;
+} GDIBSLINETO, *PGDIBSLINETO;
+
+/* Use with GdiBCRectangle and GdiBCEllipse. */
+typedef struct _GDIBSSHAPE
+{
+  GDIBATCHHDR gbHdr;
+  GDIBSDRAWATTR Attr;
+  RECTL rcl;
+} GDIBSSHAPE, *PGDIBSSHAPE;
+
+typedef struct _GDIBSPOLYPOLY
+{
+  GDIBATCHHDR gbHdr;
+  GDIBSDRAWATTR Attr;
+  POINTL ptlCurrent;
+  INT iFunc;
+  ULONG Count;
+  ULONG Buffer[1]; // Count polygon sizes, then the points
+} GDIBSPOLYPOLY, *PGDIBSPOLYPOLY;
+
+typedef struct _GDIBSSETPIXEL
+{
+  GDIBATCHHDR gbHdr;
+  POINTL ptl;
+  COLORREF crColor;
+} GDIBSSETPIXEL, *PGDIBSSETPIXEL;
+
 /* Declaration missing in ddk/winddi.h */
 typedef VOID (APIENTRY *PFN_DrvMovePanning)(LONG, LONG, FLONG);
 
@@ -120,6 +120,7 @@ CSR_API(SrvSetConsoleActiveScreenBuffer);
 CSR_API(SrvSetConsoleScreenBufferSize);
 CSR_API(SrvScrollConsoleScreenBuffer);
 CSR_API(SrvSetConsoleWindowInfo);
+CSR_API(SrvMapOutputRing);
 
 /* console.c */
 CSR_API(SrvAllocConsole);
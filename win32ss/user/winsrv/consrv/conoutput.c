@@ -487,6 +487,205 @@ Quit:
 }
 
 
+/* SHARED OUTPUT RING FOR WriteConsole ****************************************/
+
+static VOID
+ConSrvWriteOutputRingBatch(IN PCONSOLE_PROCESS_DATA ProcessData,
+                           IN ULONG OutputHandle,
+                           IN BOOLEAN Unicode,
+                           IN PVOID Buffer,
+                           IN ULONG NumBytes)
+{
+    NTSTATUS Status;
+    PTEXTMODE_SCREEN_BUFFER ScreenBuffer;
+    ULONG CharSize = (Unicode ? sizeof(WCHAR) : sizeof(CHAR));
+
+    Status = ConSrvGetTextModeBuffer(ProcessData,
+                                     ULongToHandle(OutputHandle),
+                                     &ScreenBuffer, GENERIC_WRITE, FALSE);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Dropping %lu bytes written to invalid handle 0x%lx\n", NumBytes, OutputHandle);
+        return;
+    }
+
+    /* The console is locked and not paused, so everything gets written at once */
+    Status = ConDrvWriteConsole(ScreenBuffer->Header.Console,
+                                ScreenBuffer,
+                                Unicode,
+                                Buffer,
+                                NumBytes / CharSize,
+                                NULL);
+    ASSERT(Status != STATUS_PENDING);
+
+    ConSrvReleaseScreenBuffer(ScreenBuffer, FALSE);
+}
+
+/*
+ * Writes to the screen buffers all the records the client process has
+ * appended to its output ring. Consecutive records targeting the same
+ * screen buffer are coalesced, so that the terminal processes them (and
+ * scrolls) once per batch. The console must be locked.
+ */
+static VOID
+ConSrvDrainProcessOutputRing(IN PCONSRV_CONSOLE Console,
+                             IN PCONSOLE_PROCESS_DATA ProcessData)
+{
+    PCONSOLE_OUTPUT_RING Ring = ProcessData->OutputRing;
+    PUCHAR Buffer = ProcessData->OutputRingBuffer;
+    CONSOLE_OUTPUT_RING_RECORD Record;
+    ULONG ReadOffset, WriteOffset, Position;
+    ULONG BatchHandle = 0, BatchBytes = 0;
+    BOOLEAN BatchUnicode = FALSE;
+
+    if (Ring == NULL || ProcessData->OutputRingDraining)
+        return;
+
+    /* Keep the records in the ring while the console is paused; ConioUnpause drains it */
+    if (Console->ConsolePaused)
+        return;
+
+    ProcessData->OutputRingDraining = TRUE;
+
+    /* Any record appended after this point signals the ring event again */
+    InterlockedExchange(&Ring->WakePending, FALSE);
+
+    ReadOffset  = ProcessData->OutputRingReadOffset;
+    WriteOffset = Ring->WriteOffset;
+    MemoryBarrier();
+
+    if (WriteOffset - ReadOffset > CONSOLE_OUTPUT_RING_SIZE)
+    {
+        DPRINT1("Invalid output ring offsets (read %lu, write %lu)\n", ReadOffset, WriteOffset);
+        ReadOffset = WriteOffset;
+    }
+
+    /*
+     * The client can modify the ring at any time: copy the records
+     * into the staging buffer and validate them before using them.
+     */
+    while (ReadOffset != WriteOffset)
+    {
+        Position = ReadOffset & (CONSOLE_OUTPUT_RING_SIZE - 1);
+        RtlCopyMemory(&Record, &Ring->Data[Position], sizeof(Record));
+
+        if (Record.Length < sizeof(Record) ||
+            Record.Length % CONSOLE_OUTPUT_RING_ALIGNMENT != 0 ||
+            Record.Length > WriteOffset - ReadOffset ||
+            Record.Length > CONSOLE_OUTPUT_RING_SIZE - Position ||
+            Record.NumBytes > Record.Length - sizeof(Record) ||
+            (Record.Unicode && (Record.NumBytes % sizeof(WCHAR) != 0)))
+        {
+            DPRINT1("Invalid output ring record at offset %lu\n", ReadOffset);
+            ReadOffset = WriteOffset;
+            break;
+        }
+
+        /* Padding records are only used to wrap around the end of the ring */
+        if (Record.NumBytes != 0)
+        {
+            if (BatchBytes != 0 &&
+                (Record.OutputHandle != BatchHandle || !!Record.Unicode != BatchUnicode))
+            {
+                ConSrvWriteOutputRingBatch(ProcessData, BatchHandle, BatchUnicode,
+                                           Buffer, BatchBytes);
+                BatchBytes = 0;
+            }
+
+            BatchHandle  = Record.OutputHandle;
+            BatchUnicode = !!Record.Unicode;
+
+            /* The total size of the records never exceeds the staging buffer size */
+            RtlCopyMemory(Buffer + BatchBytes,
+                          &Ring->Data[Position + sizeof(Record)],
+                          Record.NumBytes);
+            BatchBytes += Record.NumBytes;
+        }
+
+        ReadOffset += Record.Length;
+    }
+
+    /* Give the space back to the client before processing the last batch */
+    ProcessData->OutputRingReadOffset = ReadOffset;
+    Ring->ReadOffset = ReadOffset;
+
+    if (BatchBytes != 0)
+    {
+        ConSrvWriteOutputRingBatch(ProcessData, BatchHandle, BatchUnicode,
+                                   Buffer, BatchBytes);
+    }
+
+    ProcessData->OutputRingDraining = FALSE;
+}
+
+/*
+ * Writes the pending output of all the processes attached to the console,
+ * so that a screen buffer operation of any of them sees the text the others
+ * have already written. The console must be locked.
+ */
+VOID
+ConSrvDrainOutputRings(IN PCONSRV_CONSOLE Console)
+{
+    PLIST_ENTRY ProcessEntry;
+
+    for (ProcessEntry = Console->ProcessList.Flink;
+         ProcessEntry != &Console->ProcessList;
+         ProcessEntry = ProcessEntry->Flink)
+    {
+        ConSrvDrainProcessOutputRing(Console,
+                                     CONTAINING_RECORD(ProcessEntry, CONSOLE_PROCESS_DATA, ConsoleLink));
+    }
+}
+
+// Wait callback WAITORTIMERCALLBACKFUNC
+static VOID
+NTAPI
+OutputRingCallback(IN PVOID Context,
+                   IN BOOLEAN TimerOrWaitFired)
+{
+    PCONSOLE_PROCESS_DATA ProcessData = (PCONSOLE_PROCESS_DATA)Context;
+    PCONSRV_CONSOLE Console;
+
+    UNREFERENCED_PARAMETER(TimerOrWaitFired);
+
+    /* ConSrvGetConsole drains the output rings when it locks the console */
+    if (NT_SUCCESS(ConSrvGetConsole(ProcessData, &Console, TRUE)))
+        ConSrvReleaseConsole(Console, TRUE);
+}
+
+/*
+ * Flushes and releases the output ring of a process being detached
+ * from its console. The console must NOT be locked.
+ */
+VOID
+ConSrvDeleteOutputRing(IN PCONSOLE_PROCESS_DATA ProcessData)
+{
+    PCONSRV_CONSOLE Console;
+
+    if (ProcessData->OutputRing == NULL)
+        return;
+
+    /* Stop the asynchronous draining, waiting for a running callback to finish */
+    RtlDeregisterWaitEx(ProcessData->OutputRingWait, INVALID_HANDLE_VALUE);
+    ProcessData->OutputRingWait = NULL;
+
+    /* Write what is left in the ring (ConSrvGetConsole drains it, the process is still attached) */
+    if (NT_SUCCESS(ConSrvGetConsole(ProcessData, &Console, TRUE)))
+        ConSrvReleaseConsole(Console, TRUE);
+
+    NtClose(ProcessData->OutputRingEvent);
+    NtUnmapViewOfSection(ProcessData->Process->ProcessHandle, ProcessData->ClientOutputRing);
+    NtUnmapViewOfSection(NtCurrentProcess(), ProcessData->OutputRing);
+    ConsoleFreeHeap(ProcessData->OutputRingBuffer);
+
+    ProcessData->OutputRingEvent  = NULL;
+    ProcessData->ClientOutputRing = NULL;
+    ProcessData->OutputRing       = NULL;
+    ProcessData->OutputRingBuffer = NULL;
+    ProcessData->OutputRingReadOffset = 0;
+}
+
+
 /* TEXT OUTPUT APIS ***********************************************************/
 
 NTSTATUS NTAPI
@@ -700,6 +899,122 @@ CON_API(SrvWriteConsole,
     return Status;
 }
 
+/* API_NUMBER: ConsolepMapOutputRing */
+CON_API(SrvMapOutputRing,
+        CONSOLE_MAPOUTPUTRING, MapOutputRingRequest)
+{
+    NTSTATUS Status;
+    HANDLE ProcessHandle = ProcessData->Process->ProcessHandle;
+    HANDLE SectionHandle;
+    LARGE_INTEGER SectionSize;
+    SIZE_T ViewSize = 0;
+    PCONSOLE_OUTPUT_RING Ring = NULL, ClientRing = NULL;
+    HANDLE Event = NULL, ClientEvent = NULL;
+    PVOID Buffer;
+
+    /* The ring is mapped once per console attachment */
+    if (ProcessData->OutputRing != NULL)
+        return STATUS_INVALID_PARAMETER;
+
+    Buffer = ConsoleAllocHeap(0, CONSOLE_OUTPUT_RING_SIZE);
+    if (Buffer == NULL) return STATUS_NO_MEMORY;
+
+    SectionSize.QuadPart = FIELD_OFFSET(CONSOLE_OUTPUT_RING, Data[CONSOLE_OUTPUT_RING_SIZE]);
+    Status = NtCreateSection(&SectionHandle,
+                             SECTION_ALL_ACCESS,
+                             NULL,
+                             &SectionSize,
+                             PAGE_READWRITE,
+                             SEC_COMMIT,
+                             NULL);
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Error: Impossible to create a shared section, Status = 0x%08lx\n", Status);
+        goto Quit;
+    }
+
+    Status = NtMapViewOfSection(SectionHandle,
+                                NtCurrentProcess(),
+                                (PVOID*)&Ring,
+                                0,
+                                0,
+                                NULL,
+                                &ViewSize,
+                                ViewUnmap,
+                                0,
+                                PAGE_READWRITE);
+    if (NT_SUCCESS(Status))
+    {
+        ViewSize = 0;
+        Status = NtMapViewOfSection(SectionHandle,
+                                    ProcessHandle,
+                                    (PVOID*)&ClientRing,
+                                    0,
+                                    0,
+                                    NULL,
+                                    &ViewSize,
+                                    ViewUnmap,
+                                    0,
+                                    PAGE_READWRITE);
+    }
+
+    /* The views keep the section alive */
+    NtClose(SectionHandle);
+
+    if (!NT_SUCCESS(Status))
+    {
+        DPRINT1("Error: Impossible to map the shared section, Status = 0x%08lx\n", Status);
+        goto Quit;
+    }
+
+    Status = NtCreateEvent(&Event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    Status = NtDuplicateObject(NtCurrentProcess(), Event,
+                               ProcessHandle, &ClientEvent,
+                               EVENT_MODIFY_STATE, 0, 0);
+    if (!NT_SUCCESS(Status)) goto Quit;
+
+    Ring->Size = CONSOLE_OUTPUT_RING_SIZE;
+
+    ProcessData->OutputRing           = Ring;
+    ProcessData->ClientOutputRing     = ClientRing;
+    ProcessData->OutputRingEvent      = Event;
+    ProcessData->OutputRingBuffer     = Buffer;
+    ProcessData->OutputRingReadOffset = 0;
+
+    Status = RtlRegisterWait(&ProcessData->OutputRingWait,
+                             Event,
+                             OutputRingCallback,
+                             ProcessData,
+                             INFINITE,
+                             WT_EXECUTEDEFAULT);
+    if (!NT_SUCCESS(Status))
+    {
+        ProcessData->OutputRing       = NULL;
+        ProcessData->ClientOutputRing = NULL;
+        ProcessData->OutputRingEvent  = NULL;
+        ProcessData->OutputRingBuffer = NULL;
+        goto Quit;
+    }
+
+    MapOutputRingRequest->Ring  = ClientRing;
+    MapOutputRingRequest->Event = ClientEvent;
+    return STATUS_SUCCESS;
+
+Quit:
+    if (ClientEvent)
+    {
+        NtDuplicateObject(ProcessHandle, ClientEvent,
+                          NULL, NULL, 0, 0, DUPLICATE_CLOSE_SOURCE);
+    }
+    if (Event) NtClose(Event);
+    if (ClientRing) NtUnmapViewOfSection(ProcessHandle, ClientRing);
+    if (Ring) NtUnmapViewOfSection(NtCurrentProcess(), Ring);
+    ConsoleFreeHeap(Buffer);
+    return Status;
+}
+
 NTSTATUS NTAPI
 ConDrvReadConsoleOutputString(IN PCONSOLE Console,
                               IN PTEXTMODE_SCREEN_BUFFER Buffer,
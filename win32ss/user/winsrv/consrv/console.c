@@ -307,6 +307,9 @@ ConSrvGetConsole(IN PCONSOLE_PROCESS_DATA ProcessData,
         _InterlockedIncrement(&GrabConsole->ReferenceCount);
         *Console = GrabConsole;
         Status = STATUS_SUCCESS;
+
+        /* Write the pending output of all the attached processes first, so that it stays in order */
+        if (LockConsole) ConSrvDrainOutputRings(GrabConsole);
     }
 
     return Status;
@@ -872,6 +875,9 @@ ConioUnpause(PCONSRV_CONSOLE Console, UCHAR Flags)
     {
         ConDrvUnpause((PCONSOLE)Console);
 
+        /* Flush the output rings before the writes that were pending */
+        ConSrvDrainOutputRings(Console);
+
         CsrNotifyWait(&Console->WriteWaitQueue,
                       TRUE,
                       NULL,
@@ -1232,6 +1238,9 @@ ConSrvRemoveConsole(
 
     DPRINT("ConSrvRemoveConsole\n");
 
+    /* Flush and release the output ring, while the console is still unlocked */
+    ConSrvDeleteOutputRing(ProcessData);
+
     /* Mark the process as not having a console anymore */
     ProcessData->ConsoleApp = FALSE;
     ProcessData->Process->Flags &= ~CsrProcessIsConsoleApp;
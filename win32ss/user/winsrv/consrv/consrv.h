@@ -49,6 +49,15 @@ typedef struct _CONSOLE_PROCESS_DATA
     ULONG HandleTableSize;
     struct _CONSOLE_IO_HANDLE* /* PCONSOLE_IO_HANDLE */ HandleTable; // Length-varying table
 
+    /* Shared output ring (see conoutput.c) */
+    PCONSOLE_OUTPUT_RING OutputRing;        // Server-side view
+    PCONSOLE_OUTPUT_RING ClientOutputRing;  // Client-side view
+    HANDLE OutputRingEvent;
+    HANDLE OutputRingWait;
+    PVOID  OutputRingBuffer;    // Staging buffer for the drained records
+    ULONG  OutputRingReadOffset;
+    BOOLEAN OutputRingDraining;
+
     LPTHREAD_START_ROUTINE CtrlRoutine;
     LPTHREAD_START_ROUTINE PropRoutine; // We hold the property dialog handler there, till all the GUI thingie moves out from CSRSS.
     // LPTHREAD_START_ROUTINE ImeRoutine;
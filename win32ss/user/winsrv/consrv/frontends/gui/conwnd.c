@@ -34,8 +34,10 @@
 #define CONGUI_MIN_HEIGHT     10
 #define CONGUI_UPDATE_TIME    0
 #define CONGUI_UPDATE_TIMER   1
+#define CONGUI_FRAME_TIMER    2
 
 #define CURSOR_BLINK_TIME 500
+#define FRAME_TIME        16
 
 
 /**************************************************************\
@@ -1238,6 +1240,95 @@ VOID
 InvalidateCell(PGUI_CONSOLE_DATA GuiData,
                SHORT x, SHORT y);
 
+/* Scroll the view to follow the cursor, if it has moved out of it */
+static VOID
+ScrollToCursor(PGUI_CONSOLE_DATA GuiData,
+               PCONSOLE_SCREEN_BUFFER Buff)
+{
+    SCROLLINFO sInfo;
+    int OldScrollX = -1, OldScrollY = -1;
+    int NewScrollX = -1, NewScrollY = -1;
+
+    if ((GuiData->OldCursor.x == Buff->CursorPosition.X) &&
+        (GuiData->OldCursor.y == Buff->CursorPosition.Y))
+    {
+        return;
+    }
+
+    sInfo.cbSize = sizeof(sInfo);
+    sInfo.fMask = SIF_POS;
+    // Capture the original position of the scroll bars and save them.
+    if (GetScrollInfo(GuiData->hWindow, SB_HORZ, &sInfo)) OldScrollX = sInfo.nPos;
+    if (GetScrollInfo(GuiData->hWindow, SB_VERT, &sInfo)) OldScrollY = sInfo.nPos;
+
+    // If we successfully got the info for the horizontal scrollbar
+    if (OldScrollX >= 0)
+    {
+        if ((Buff->CursorPosition.X < Buff->ViewOrigin.X) ||
+            (Buff->CursorPosition.X >= (Buff->ViewOrigin.X + Buff->ViewSize.X)))
+        {
+            // Handle the horizontal scroll bar
+            if (Buff->CursorPosition.X >= Buff->ViewSize.X)
+                NewScrollX = Buff->CursorPosition.X - Buff->ViewSize.X + 1;
+            else
+                NewScrollX = 0;
+        }
+        else
+        {
+            NewScrollX = OldScrollX;
+        }
+    }
+    // If we successfully got the info for the vertical scrollbar
+    if (OldScrollY >= 0)
+    {
+        if ((Buff->CursorPosition.Y < Buff->ViewOrigin.Y) ||
+            (Buff->CursorPosition.Y >= (Buff->ViewOrigin.Y + Buff->ViewSize.Y)))
+        {
+            // Handle the vertical scroll bar
+            if (Buff->CursorPosition.Y >= Buff->ViewSize.Y)
+                NewScrollY = Buff->CursorPosition.Y - Buff->ViewSize.Y + 1;
+            else
+                NewScrollY = 0;
+        }
+        else
+        {
+            NewScrollY = OldScrollY;
+        }
+    }
+
+    // Adjust scroll bars and refresh the window if the cursor has moved outside the visible area
+    // NOTE: OldScroll# and NewScroll# will both be -1 (initial value) if the info for the respective scrollbar
+    //       was not obtained successfully in the previous steps. This means their difference is 0 (no scrolling)
+    //       and their associated scrollbar is left alone.
+    if ((OldScrollX != NewScrollX) || (OldScrollY != NewScrollY))
+    {
+        Buff->ViewOrigin.X = NewScrollX;
+        Buff->ViewOrigin.Y = NewScrollY;
+        ScrollWindowEx(GuiData->hWindow,
+                       (OldScrollX - NewScrollX) * GuiData->CharWidth,
+                       (OldScrollY - NewScrollY) * GuiData->CharHeight,
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       SW_INVALIDATE);
+        if (NewScrollX >= 0)
+        {
+            sInfo.nPos = NewScrollX;
+            SetScrollInfo(GuiData->hWindow, SB_HORZ, &sInfo, TRUE);
+        }
+        if (NewScrollY >= 0)
+        {
+            sInfo.nPos = NewScrollY;
+            SetScrollInfo(GuiData->hWindow, SB_VERT, &sInfo, TRUE);
+        }
+        UpdateWindow(GuiData->hWindow);
+        // InvalidateRect(GuiData->hWindow, NULL, FALSE);
+        GuiData->OldCursor.x = Buff->CursorPosition.X;
+        GuiData->OldCursor.y = Buff->CursorPosition.Y;
+    }
+}
+
 static VOID
 OnTimer(PGUI_CONSOLE_DATA GuiData)
 {
@@ -1259,86 +1350,7 @@ OnTimer(PGUI_CONSOLE_DATA GuiData)
         InvalidateCell(GuiData, Buff->CursorPosition.X, Buff->CursorPosition.Y);
         Buff->CursorBlinkOn = !Buff->CursorBlinkOn;
 
-        if ((GuiData->OldCursor.x != Buff->CursorPosition.X) ||
-            (GuiData->OldCursor.y != Buff->CursorPosition.Y))
-        {
-            SCROLLINFO sInfo;
-            int OldScrollX = -1, OldScrollY = -1;
-            int NewScrollX = -1, NewScrollY = -1;
-
-            sInfo.cbSize = sizeof(sInfo);
-            sInfo.fMask = SIF_POS;
-            // Capture the original position of the scroll bars and save them.
-            if (GetScrollInfo(GuiData->hWindow, SB_HORZ, &sInfo)) OldScrollX = sInfo.nPos;
-            if (GetScrollInfo(GuiData->hWindow, SB_VERT, &sInfo)) OldScrollY = sInfo.nPos;
-
-            // If we successfully got the info for the horizontal scrollbar
-            if (OldScrollX >= 0)
-            {
-                if ((Buff->CursorPosition.X < Buff->ViewOrigin.X) ||
-                    (Buff->CursorPosition.X >= (Buff->ViewOrigin.X + Buff->ViewSize.X)))
-                {
-                    // Handle the horizontal scroll bar
-                    if (Buff->CursorPosition.X >= Buff->ViewSize.X)
-                        NewScrollX = Buff->CursorPosition.X - Buff->ViewSize.X + 1;
-                    else
-                        NewScrollX = 0;
-                }
-                else
-                {
-                    NewScrollX = OldScrollX;
-                }
-            }
-            // If we successfully got the info for the vertical scrollbar
-            if (OldScrollY >= 0)
-            {
-                if ((Buff->CursorPosition.Y < Buff->ViewOrigin.Y) ||
-                    (Buff->CursorPosition.Y >= (Buff->ViewOrigin.Y + Buff->ViewSize.Y)))
-                {
-                    // Handle the vertical scroll bar
-                    if (Buff->CursorPosition.Y >= Buff->ViewSize.Y)
-                        NewScrollY = Buff->CursorPosition.Y - Buff->ViewSize.Y + 1;
-                    else
-                        NewScrollY = 0;
-                }
-                else
-                {
-                    NewScrollY = OldScrollY;
-                }
-            }
-
-            // Adjust scroll bars and refresh the window if the cursor has moved outside the visible area
-            // NOTE: OldScroll# and NewScroll# will both be -1 (initial value) if the info for the respective scrollbar
-            //       was not obtained successfully in the previous steps. This means their difference is 0 (no scrolling)
-            //       and their associated scrollbar is left alone.
-            if ((OldScrollX != NewScrollX) || (OldScrollY != NewScrollY))
-            {
-                Buff->ViewOrigin.X = NewScrollX;
-                Buff->ViewOrigin.Y = NewScrollY;
-                ScrollWindowEx(GuiData->hWindow,
-                               (OldScrollX - NewScrollX) * GuiData->CharWidth,
-                               (OldScrollY - NewScrollY) * GuiData->CharHeight,
-                               NULL,
-                               NULL,
-                               NULL,
-                               NULL,
-                               SW_INVALIDATE);
-                if (NewScrollX >= 0)
-                {
-                    sInfo.nPos = NewScrollX;
-                    SetScrollInfo(GuiData->hWindow, SB_HORZ, &sInfo, TRUE);
-                }
-                if (NewScrollY >= 0)
-                {
-                    sInfo.nPos = NewScrollY;
-                    SetScrollInfo(GuiData->hWindow, SB_VERT, &sInfo, TRUE);
-                }
-                UpdateWindow(GuiData->hWindow);
-                // InvalidateRect(GuiData->hWindow, NULL, FALSE);
-                GuiData->OldCursor.x = Buff->CursorPosition.X;
-                GuiData->OldCursor.y = Buff->CursorPosition.Y;
-            }
-        }
+        ScrollToCursor(GuiData, Buff);
     }
     else /* if (GetType(Buff) == GRAPHICS_BUFFER) */
     {
@@ -1347,6 +1359,34 @@ OnTimer(PGUI_CONSOLE_DATA GuiData)
     LeaveCriticalSection(&Console->Lock);
 }
 
+static VOID
+OnFrame(PGUI_CONSOLE_DATA GuiData)
+{
+    PCONSRV_CONSOLE Console = GuiData->Console;
+    PCONSOLE_SCREEN_BUFFER Buff;
+
+    KillTimer(GuiData->hWindow, CONGUI_FRAME_TIMER);
+
+    if (!ConDrvValidateConsoleUnsafe((PCONSOLE)Console, CONSOLE_RUNNING, TRUE)) return;
+
+    /* From now on, new damage needs a new frame */
+    GuiData->FramePending = FALSE;
+
+    Buff = GuiData->ActiveBuffer;
+    if (GetType(Buff) == TEXTMODE_BUFFER)
+    {
+        ScrollToCursor(GuiData, Buff);
+
+        /* Repaint all the damage done since the previous frame at once */
+        GuiFlushTextModeBuffer((PTEXTMODE_SCREEN_BUFFER)Buff, GuiData);
+
+        /* Restart the caret blinking, so that it stays on while writing */
+        SetTimer(GuiData->hWindow, CONGUI_UPDATE_TIMER, CURSOR_BLINK_TIME, NULL);
+    }
+
+    LeaveCriticalSection(&Console->Lock);
+}
+
 static BOOL
 OnClose(PGUI_CONSOLE_DATA GuiData)
 {
@@ -1382,7 +1422,13 @@ OnNcDestroy(HWND hWnd)
     if (GuiData)
     {
         if (GuiData->IsWindowVisible)
+        {
             KillTimer(hWnd, CONGUI_UPDATE_TIMER);
+            KillTimer(hWnd, CONGUI_FRAME_TIMER);
+        }
+
+        /* Free the damage tracking of the framebuffer */
+        GuiFreeTextModeDamage(GuiData);
 
         /* Free the terminal framebuffer */
         if (GuiData->hMemDC ) DeleteDC(GuiData->hMemDC);
@@ -2237,7 +2283,10 @@ ConWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             break;
 
         case WM_TIMER:
-            OnTimer(GuiData);
+            if (wParam == CONGUI_FRAME_TIMER)
+                OnFrame(GuiData);
+            else
+                OnTimer(GuiData);
             break;
 
         case WM_PALETTECHANGED:
@@ -2547,6 +2596,11 @@ ConWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
             break;
         }
 
+        case PM_CONSOLE_FRAME:
+            /* Coalesce the damage of the next few milliseconds into one frame */
+            SetTimer(GuiData->hWindow, CONGUI_FRAME_TIMER, FRAME_TIME, NULL);
+            break;
+
         case PM_CONSOLE_BEEP:
             DPRINT1("Beep\n");
             Beep(800, 200);
@@ -20,6 +20,7 @@
 #define PM_RESIZE_TERMINAL      (WM_APP + 3)
 #define PM_CONSOLE_BEEP         (WM_APP + 4)
 #define PM_CONSOLE_SET_TITLE    (WM_APP + 5)
+#define PM_CONSOLE_FRAME        (WM_APP + 6)
 
 /* Flags for GetKeyState */
 #define KEY_TOGGLED 0x0001
@@ -63,6 +64,20 @@ typedef struct _GUI_CONSOLE_DATA
     HBITMAP  hBitmap;           /* Console framebuffer                       */
     HPALETTE hSysPalette;       /* Handle to the original system palette     */
 
+    /*
+     * Damage tracking for text-mode screen buffers (see text.c).
+     * The framebuffer is shared by all the screen buffers, hence this is
+     * only valid as long as the buffer, framebuffer and font it has been
+     * set up for stay the same. Protected by the console lock.
+     */
+    RTL_BITMAP DirtyLines;              /* Framebuffer lines out of date with the buffer */
+    PCONSOLE_SCREEN_BUFFER DirtyBuffer; /* Screen buffer the dirty lines refer to        */
+    HBITMAP DirtyFramebuffer;           /* Framebuffer the dirty lines refer to          */
+    UINT DirtyCharWidth;
+    UINT DirtyCharHeight;
+    UINT PendingScroll;         /* Lines the framebuffer has yet to be scrolled up by */
+    BOOLEAN FramePending;       /* A PM_CONSOLE_FRAME is on its way to the window     */
+
     HICON hIcon;                /* Handle to the console's icon (big)   */
     HICON hIconSm;              /* Handle to the console's icon (small) */
 
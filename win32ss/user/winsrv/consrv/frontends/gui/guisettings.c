@@ -340,6 +340,7 @@ GuiApplyUserSettings(PGUI_CONSOLE_DATA GuiData,
         GuiData->GuiInfo.WindowOrigin = pConInfo->WindowPosition;
         GuiConsoleMoveWindow(GuiData);
 
+        GuiInvalidateFramebuffer(GuiData);
         InvalidateRect(GuiData->hWindow, NULL, TRUE);
 
         /*
@@ -20,10 +20,6 @@
 #include "guiterm.h"
 #include "resource.h"
 
-// HACK!! Remove it when the hack in GuiWriteStream is fixed
-#define CONGUI_UPDATE_TIME    0
-#define CONGUI_UPDATE_TIMER   1
-
 #define PM_CREATE_CONSOLE     (WM_APP + 1)
 #define PM_DESTROY_CONSOLE    (WM_APP + 2)
 
@@ -78,6 +74,19 @@ DrawRegion(PGUI_CONSOLE_DATA GuiData,
 {
     RECT RegionRect;
 
+    if (GetType(GuiData->ActiveBuffer) == TEXTMODE_BUFFER)
+    {
+        /* Only record the damage, the next frame repaints it */
+        GuiInvalidateTextModeLines((PTEXTMODE_SCREEN_BUFFER)GuiData->ActiveBuffer,
+                                   GuiData, Region->Top, Region->Bottom);
+        if (!GuiData->FramePending)
+        {
+            GuiData->FramePending = TRUE;
+            PostMessageW(GuiData->hWindow, PM_CONSOLE_FRAME, 0, 0);
+        }
+        return;
+    }
+
     SmallRectToRect(GuiData, &RegionRect, Region);
     /* Do not erase the background: it speeds up redrawing and reduce flickering */
     InvalidateRect(GuiData->hWindow, &RegionRect, FALSE);
@@ -649,7 +658,6 @@ GuiWriteStream(IN OUT PFRONTEND This,
     PGUI_CONSOLE_DATA GuiData = This->Context;
     PCONSOLE_SCREEN_BUFFER Buff;
     SHORT CursorEndX, CursorEndY;
-    RECT ScrollRect;
 
     if (NULL == GuiData || NULL == GuiData->hWindow) return;
 
@@ -661,19 +669,8 @@ GuiWriteStream(IN OUT PFRONTEND This,
 
     if (0 != ScrolledLines)
     {
-        ScrollRect.left = 0;
-        ScrollRect.top = 0;
-        ScrollRect.right = Buff->ViewSize.X * GuiData->CharWidth;
-        ScrollRect.bottom = Region->Top * GuiData->CharHeight;
-
-        ScrollWindowEx(GuiData->hWindow,
-                       0,
-                       -(int)(ScrolledLines * GuiData->CharHeight),
-                       &ScrollRect,
-                       NULL,
-                       NULL,
-                       NULL,
-                       SW_INVALIDATE);
+        /* The framebuffer and the screen get scrolled at the next frame */
+        GuiScrollTextModeBuffer((PTEXTMODE_SCREEN_BUFFER)Buff, GuiData, ScrolledLines);
     }
 
     DrawRegion(GuiData, Region);
@@ -693,11 +690,8 @@ GuiWriteStream(IN OUT PFRONTEND This,
         InvalidateCell(GuiData, CursorEndX, CursorEndY);
     }
 
-    // HACK!!
-    // Set up the update timer (very short interval) - this is a "hack" for getting the OS to
-    // repaint the window without having it just freeze up and stay on the screen permanently.
+    /* Keep the caret on while writing, the frame restarts its blinking */
     Buff->CursorBlinkOn = TRUE;
-    SetTimer(GuiData->hWindow, CONGUI_UPDATE_TIMER, CONGUI_UPDATE_TIME, NULL);
 }
 
 /* static */ VOID NTAPI
@@ -792,6 +786,7 @@ GuiSetActiveScreenBuffer(IN OUT PFRONTEND This)
     /* Realize the (logical) palette */
     RealizePalette(GuiData->hMemDC);
 
+    GuiInvalidateFramebuffer(GuiData);
     GuiResizeTerminal(This);
     // ConioDrawConsole(Console);
 }
@@ -1031,6 +1026,9 @@ GuiSetPalette(IN OUT PFRONTEND This,
     /* Save the original system palette handle */
     if (GuiData->hSysPalette == NULL) GuiData->hSysPalette = OldPalette;
 
+    /* The colors of the whole framebuffer may have changed */
+    GuiInvalidateFramebuffer(GuiData);
+
     return TRUE;
 }
 
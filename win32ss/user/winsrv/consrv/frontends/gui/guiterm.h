@@ -53,6 +53,14 @@ SmallRectToRect(PGUI_CONSOLE_DATA GuiData, PRECT Rect, PSMALL_RECT SmallRect)
     Rect->bottom = (SmallRect->Bottom + 1 - Buffer->ViewOrigin.Y) * HeightUnit;
 }
 
+FORCEINLINE
+VOID
+GuiInvalidateFramebuffer(IN PGUI_CONSOLE_DATA GuiData)
+{
+    /* Forget the damage tracking: the next paint redraws the whole framebuffer */
+    GuiData->DirtyBuffer = NULL;
+}
+
 
 /* FUNCTIONS ******************************************************************/
 
@@ -120,5 +128,19 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
                        PGUI_CONSOLE_DATA GuiData,
                        PRECT rcView,
                        PRECT rcFramebuffer);
+VOID
+GuiInvalidateTextModeLines(PTEXTMODE_SCREEN_BUFFER Buffer,
+                           PGUI_CONSOLE_DATA GuiData,
+                           SHORT TopLine,
+                           SHORT BottomLine);
+VOID
+GuiScrollTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
+                        PGUI_CONSOLE_DATA GuiData,
+                        UINT ScrolledLines);
+VOID
+GuiFlushTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
+                       PGUI_CONSOLE_DATA GuiData);
+VOID
+GuiFreeTextModeDamage(PGUI_CONSOLE_DATA GuiData);
 
 /* EOF */
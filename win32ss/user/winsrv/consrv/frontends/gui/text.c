@@ -429,6 +429,262 @@ GuiPaintCaret(
     }
 }
 
+/*
+ * Damage tracking: the framebuffer keeps the rendered text between two
+ * paints. Writers only mark the lines they touch as dirty and record how
+ * far the buffer scrolled; the console window coalesces this into frames
+ * (see OnFrame in conwnd.c) and the paint re-renders the dirty lines only.
+ */
+
+static BOOLEAN
+IsDamageTracked(PTEXTMODE_SCREEN_BUFFER Buffer,
+                PGUI_CONSOLE_DATA GuiData)
+{
+    return (GuiData->DirtyBuffer      == (PCONSOLE_SCREEN_BUFFER)Buffer &&
+            GuiData->DirtyFramebuffer == GuiData->hBitmap    &&
+            GuiData->DirtyCharWidth   == GuiData->CharWidth  &&
+            GuiData->DirtyCharHeight  == GuiData->CharHeight &&
+            GuiData->DirtyLines.SizeOfBitMap == (ULONG)Buffer->ScreenBufferSize.Y);
+}
+
+static BOOLEAN
+ResetDamageTracking(PTEXTMODE_SCREEN_BUFFER Buffer,
+                    PGUI_CONSOLE_DATA GuiData)
+{
+    ULONG SizeOfBitMap = Buffer->ScreenBufferSize.Y;
+    PULONG BitMapBuffer;
+
+    if (GuiData->DirtyLines.Buffer == NULL ||
+        GuiData->DirtyLines.SizeOfBitMap != SizeOfBitMap)
+    {
+        GuiFreeTextModeDamage(GuiData);
+
+        /* Round up to 64 bits, RtlCheckBit may read them at once */
+        BitMapBuffer = ConsoleAllocHeap(0, (SizeOfBitMap + 63) / 64 * sizeof(ULONGLONG));
+        if (BitMapBuffer == NULL) return FALSE;
+
+        RtlInitializeBitMap(&GuiData->DirtyLines, BitMapBuffer, SizeOfBitMap);
+    }
+
+    /* Nothing of the framebuffer can be trusted */
+    RtlSetAllBits(&GuiData->DirtyLines);
+    GuiData->PendingScroll    = 0;
+    GuiData->DirtyBuffer      = (PCONSOLE_SCREEN_BUFFER)Buffer;
+    GuiData->DirtyFramebuffer = GuiData->hBitmap;
+    GuiData->DirtyCharWidth   = GuiData->CharWidth;
+    GuiData->DirtyCharHeight  = GuiData->CharHeight;
+
+    return TRUE;
+}
+
+static UINT
+ApplyPendingScroll(PTEXTMODE_SCREEN_BUFFER Buffer,
+                   PGUI_CONSOLE_DATA GuiData)
+{
+    UINT ScrolledLines = GuiData->PendingScroll;
+    RECT rcScroll;
+
+    if (ScrolledLines == 0) return 0;
+    GuiData->PendingScroll = 0;
+
+    /* Move the already rendered lines up, rather than rendering them again */
+    SetRect(&rcScroll, 0, 0,
+            Buffer->ScreenBufferSize.X * GuiData->CharWidth,
+            Buffer->ScreenBufferSize.Y * GuiData->CharHeight);
+    ScrollDC(GuiData->hMemDC,
+             0, -(INT)(ScrolledLines * GuiData->CharHeight),
+             &rcScroll, &rcScroll, NULL, NULL);
+
+    return ScrolledLines;
+}
+
+VOID
+GuiFreeTextModeDamage(PGUI_CONSOLE_DATA GuiData)
+{
+    if (GuiData->DirtyLines.Buffer)
+        ConsoleFreeHeap(GuiData->DirtyLines.Buffer);
+
+    RtlZeroMemory(&GuiData->DirtyLines, sizeof(GuiData->DirtyLines));
+    GuiData->DirtyBuffer = NULL;
+}
+
+VOID
+GuiInvalidateTextModeLines(PTEXTMODE_SCREEN_BUFFER Buffer,
+                           PGUI_CONSOLE_DATA GuiData,
+                           SHORT TopLine,
+                           SHORT BottomLine)
+{
+    /* If the damage is not tracked, the next paint redraws everything anyway */
+    if (!IsDamageTracked(Buffer, GuiData)) return;
+
+    if (TopLine < 0) TopLine = 0;
+    if (BottomLine >= Buffer->ScreenBufferSize.Y)
+        BottomLine = Buffer->ScreenBufferSize.Y - 1;
+    if (TopLine > BottomLine) return;
+
+    RtlSetBits(&GuiData->DirtyLines, TopLine, BottomLine - TopLine + 1);
+}
+
+VOID
+GuiScrollTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
+                        PGUI_CONSOLE_DATA GuiData,
+                        UINT ScrolledLines)
+{
+    PRTL_BITMAP DirtyLines = &GuiData->DirtyLines;
+    ULONG Line, FirstDirty;
+
+    if (!IsDamageTracked(Buffer, GuiData)) return;
+
+    if (ScrolledLines >= DirtyLines->SizeOfBitMap - GuiData->PendingScroll)
+    {
+        /* Everything has scrolled out, there is nothing to keep */
+        GuiInvalidateFramebuffer(GuiData);
+        return;
+    }
+
+    GuiData->PendingScroll += ScrolledLines;
+
+    /* Scroll the dirty lines along; the lines above the first dirty one stay clean */
+    FirstDirty = RtlFindSetBits(DirtyLines, 1, 0);
+    if (FirstDirty != MAXULONG)
+    {
+        Line = (FirstDirty > ScrolledLines ? FirstDirty - ScrolledLines : 0);
+        for (; Line + ScrolledLines < DirtyLines->SizeOfBitMap; Line++)
+        {
+            if (RtlCheckBit(DirtyLines, Line + ScrolledLines))
+                RtlSetBits(DirtyLines, Line, 1);
+            else
+                RtlClearBits(DirtyLines, Line, 1);
+        }
+    }
+
+    /* The lines scrolled in at the bottom */
+    RtlSetBits(DirtyLines, DirtyLines->SizeOfBitMap - ScrolledLines, ScrolledLines);
+}
+
+VOID
+GuiFlushTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
+                       PGUI_CONSOLE_DATA GuiData)
+{
+    PRTL_BITMAP DirtyLines = &GuiData->DirtyLines;
+    ULONG TopLine, BottomLine;
+    UINT ScrolledLines;
+    SMALL_RECT Region;
+    RECT rcRegion;
+
+    if (!IsDamageTracked(Buffer, GuiData))
+    {
+        InvalidateRect(GuiData->hWindow, NULL, FALSE);
+        return;
+    }
+
+    /* Scroll both the framebuffer and the screen at once */
+    ScrolledLines = ApplyPendingScroll(Buffer, GuiData);
+    if (ScrolledLines != 0)
+    {
+        ScrollWindowEx(GuiData->hWindow,
+                       0,
+                       -(INT)(ScrolledLines * GuiData->CharHeight),
+                       NULL,
+                       NULL,
+                       NULL,
+                       NULL,
+                       SW_INVALIDATE);
+    }
+
+    /* Repaint the visible dirty lines; the other ones get repainted when scrolled into view */
+    TopLine    = Buffer->ViewOrigin.Y;
+    BottomLine = min(TopLine + Buffer->ViewSize.Y, DirtyLines->SizeOfBitMap);
+
+    while (TopLine < BottomLine && !RtlCheckBit(DirtyLines, TopLine))
+        ++TopLine;
+    while (TopLine < BottomLine && !RtlCheckBit(DirtyLines, BottomLine - 1))
+        --BottomLine;
+    if (TopLine == BottomLine) return;
+
+    Region.Left   = Buffer->ViewOrigin.X;
+    Region.Top    = (SHORT)TopLine;
+    Region.Right  = Buffer->ViewOrigin.X + Buffer->ViewSize.X - 1;
+    Region.Bottom = (SHORT)(BottomLine - 1);
+
+    SmallRectToRect(GuiData, &rcRegion, &Region);
+    InvalidateRect(GuiData->hWindow, &rcRegion, FALSE);
+}
+
+static VOID
+SelectTextAttribute(PCONSRV_CONSOLE Console,
+                    PGUI_CONSOLE_DATA GuiData,
+                    WORD Attribute)
+{
+    SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(Attribute)));
+    SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(Attribute)));
+
+    /* We use the underscore flag as a underline flag */
+    SelectObject(GuiData->hMemDC,
+                 GuiData->Font[(Attribute & COMMON_LVB_UNDERSCORE) ? FONT_BOLD : FONT_NORMAL]);
+}
+
+static VOID
+GuiPaintTextLine(PTEXTMODE_SCREEN_BUFFER Buffer,
+                 PGUI_CONSOLE_DATA GuiData,
+                 ULONG Line,
+                 PWCHAR LineBuffer,
+                 CONST INT* Advances)
+{
+    PCONSRV_CONSOLE Console = (PCONSRV_CONSOLE)Buffer->Header.Console;
+    ULONG Width = Buffer->ScreenBufferSize.X;
+    ULONG Char, Start;
+    PCHAR_INFO From;
+    WORD Attribute;
+    RECT rcRun;
+
+    From = ConioCoordToPointer(Buffer, 0, Line);
+    rcRun.top    = Line * GuiData->CharHeight;
+    rcRun.bottom = rcRun.top + GuiData->CharHeight;
+
+    if (Console->IsCJK)
+    {
+        for (Char = 0; Char < Width; Char++, From++)
+        {
+            SelectTextAttribute(Console, GuiData, From->Attributes);
+
+            if (From->Attributes & COMMON_LVB_TRAILING_BYTE)
+                continue;
+
+            TextOutW(GuiData->hMemDC,
+                     Char * GuiData->CharWidth,
+                     rcRun.top,
+                     &From->Char.UnicodeChar, 1);
+        }
+        return;
+    }
+
+    /*
+     * Draw each run of characters sharing the same attribute in one call.
+     * The fixed advances keep the glyphs on the character grid, and the
+     * opaque rectangle paints the background of the whole run.
+     */
+    for (Start = 0; Start < Width; Start = Char)
+    {
+        Attribute = From->Attributes;
+        for (Char = Start; Char < Width && From->Attributes == Attribute; Char++, From++)
+            LineBuffer[Char] = From->Char.UnicodeChar;
+
+        SelectTextAttribute(Console, GuiData, Attribute);
+
+        rcRun.left  = Start * GuiData->CharWidth;
+        rcRun.right = Char  * GuiData->CharWidth;
+        ExtTextOutW(GuiData->hMemDC,
+                    rcRun.left,
+                    rcRun.top,
+                    ETO_OPAQUE,
+                    &rcRun,
+                    &LineBuffer[Start],
+                    Char - Start,
+                    Advances);
+    }
+}
+
 VOID
 GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
                        PGUI_CONSOLE_DATA GuiData,
@@ -436,13 +692,12 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
                        PRECT rcFramebuffer)
 {
     PCONSRV_CONSOLE Console = (PCONSRV_CONSOLE)Buffer->Header.Console;
-    ULONG TopLine, BottomLine, LeftColumn, RightColumn;
-    ULONG Line, Char, Start;
-    PCHAR_INFO From;
-    PWCHAR To;
-    WORD LastAttribute, Attribute;
-    HFONT OldFont, NewFont;
-    BOOLEAN IsUnderline;
+    ULONG TopLine, BottomLine, Line, Char;
+    ULONG Width = Buffer->ScreenBufferSize.X;
+    PINT Advances;
+    PWCHAR LineBuffer;
+    HFONT OldFont;
+    BOOLEAN Tracked, CaretLine = FALSE;
 
     // ASSERT(Console == GuiData->Console);
 
@@ -454,123 +709,69 @@ GuiPaintTextModeBuffer(PTEXTMODE_SCREEN_BUFFER Buffer,
     if (!ConDrvValidateConsoleUnsafe((PCONSOLE)Console, CONSOLE_RUNNING, TRUE))
         return;
 
+    Tracked = IsDamageTracked(Buffer, GuiData);
+    if (!Tracked)
+    {
+        Tracked = ResetDamageTracking(Buffer, GuiData);
+    }
+    else if (ApplyPendingScroll(Buffer, GuiData) != 0)
+    {
+        /*
+         * We got there before the frame: the framebuffer is scrolled now,
+         * but the screen is not, so all of it has to be repainted.
+         */
+        InvalidateRect(GuiData->hWindow, NULL, FALSE);
+    }
+
     ConioInitLongRect(rcFramebuffer,
                       Buffer->ViewOrigin.Y * GuiData->CharHeight + rcView->top,
                       Buffer->ViewOrigin.X * GuiData->CharWidth  + rcView->left,
                       Buffer->ViewOrigin.Y * GuiData->CharHeight + rcView->bottom,
                       Buffer->ViewOrigin.X * GuiData->CharWidth  + rcView->right);
 
-    LeftColumn  = rcFramebuffer->left  / GuiData->CharWidth;
-    RightColumn = rcFramebuffer->right / GuiData->CharWidth;
-    if (RightColumn >= (ULONG)Buffer->ScreenBufferSize.X)
-        RightColumn  = Buffer->ScreenBufferSize.X - 1;
-
     TopLine    = rcFramebuffer->top    / GuiData->CharHeight;
     BottomLine = rcFramebuffer->bottom / GuiData->CharHeight;
     if (BottomLine >= (ULONG)Buffer->ScreenBufferSize.Y)
         BottomLine  = Buffer->ScreenBufferSize.Y - 1;
 
-    LastAttribute = ConioCoordToPointer(Buffer, LeftColumn, TopLine)->Attributes;
+    Advances = ConsoleAllocHeap(0, Width * (sizeof(INT) + sizeof(WCHAR)));
+    if (Advances == NULL) goto Quit;
+    LineBuffer = (PWCHAR)(Advances + Width);
 
-    SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(LastAttribute)));
-    SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(LastAttribute)));
+    for (Char = 0; Char < Width; Char++)
+        Advances[Char] = GuiData->CharWidth;
 
-    /* We use the underscore flag as a underline flag */
-    IsUnderline = !!(LastAttribute & COMMON_LVB_UNDERSCORE);
-    /* Select the new font */
-    NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
-    OldFont = SelectObject(GuiData->hMemDC, NewFont);
+    OldFont = SelectObject(GuiData->hMemDC, GuiData->Font[FONT_NORMAL]);
 
-    if (Console->IsCJK)
+    /* Render the whole width of the dirty lines only, the other ones are up to date */
+    for (Line = TopLine; Line <= BottomLine; Line++)
     {
-        for (Line = TopLine; Line <= BottomLine; Line++)
+        if (Tracked)
         {
-            for (Char = LeftColumn; Char <= RightColumn; Char++)
-            {
-                From = ConioCoordToPointer(Buffer, Char, Line);
-                Attribute = From->Attributes;
-                SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(Attribute)));
-                SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(Attribute)));
-
-                /* Change underline state if needed */
-                if (!!(Attribute & COMMON_LVB_UNDERSCORE) != IsUnderline)
-                {
-                    IsUnderline = !!(Attribute & COMMON_LVB_UNDERSCORE);
-
-                    /* Select the new font */
-                    NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
-                    SelectObject(GuiData->hMemDC, NewFont);
-                }
-
-                if (Attribute & COMMON_LVB_TRAILING_BYTE)
-                    continue;
-
-                TextOutW(GuiData->hMemDC,
-                         Char * GuiData->CharWidth,
-                         Line * GuiData->CharHeight,
-                         &From->Char.UnicodeChar, 1);
-            }
+            if (!RtlCheckBit(&GuiData->DirtyLines, Line)) continue;
+            RtlClearBits(&GuiData->DirtyLines, Line, 1);
         }
-    }
-    else
-    {
-        for (Line = TopLine; Line <= BottomLine; Line++)
-        {
-            WCHAR LineBuffer[80];   // Buffer containing a part or all the line to be displayed
-            From  = ConioCoordToPointer(Buffer, LeftColumn, Line);  // Get the first code of the line
-            Start = LeftColumn;
-            To    = LineBuffer;
 
-            for (Char = LeftColumn; Char <= RightColumn; Char++)
-            {
-                /*
-                 * We flush the buffer if the new attribute is different
-                 * from the current one, or if the buffer is full.
-                 */
-                if (From->Attributes != LastAttribute || (Char - Start == sizeof(LineBuffer) / sizeof(WCHAR)))
-                {
-                    TextOutW(GuiData->hMemDC,
-                             Start * GuiData->CharWidth,
-                             Line  * GuiData->CharHeight,
-                             LineBuffer,
-                             Char - Start);
-                    Start = Char;
-                    To    = LineBuffer;
-                    Attribute = From->Attributes;
-                    if (Attribute != LastAttribute)
-                    {
-                        LastAttribute = Attribute;
-                        SetTextColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, TextAttribFromAttrib(LastAttribute)));
-                        SetBkColor(GuiData->hMemDC, PaletteRGBFromAttrib(Console, BkgdAttribFromAttrib(LastAttribute)));
-
-                        /* Change underline state if needed */
-                        if (!!(LastAttribute & COMMON_LVB_UNDERSCORE) != IsUnderline)
-                        {
-                            IsUnderline = !!(LastAttribute & COMMON_LVB_UNDERSCORE);
-                            /* Select the new font */
-                            NewFont = GuiData->Font[IsUnderline ? FONT_BOLD : FONT_NORMAL];
-                            SelectObject(GuiData->hMemDC, NewFont);
-                        }
-                    }
-                }
-
-                *(To++) = (From++)->Char.UnicodeChar;
-            }
+        GuiPaintTextLine(Buffer, GuiData, Line, LineBuffer, Advances);
 
-            TextOutW(GuiData->hMemDC,
-                     Start * GuiData->CharWidth,
-                     Line  * GuiData->CharHeight,
-                     LineBuffer,
-                     RightColumn - Start + 1);
-        }
+        if (Line == (ULONG)Buffer->CursorPosition.Y)
+            CaretLine = TRUE;
     }
 
     /* Restore the old font */
     SelectObject(GuiData->hMemDC, OldFont);
 
-    /* Draw the caret */
-    GuiPaintCaret(Buffer, GuiData, TopLine, BottomLine, LeftColumn, RightColumn);
+    ConsoleFreeHeap(Advances);
+
+    /* Draw the caret, if its line has just been rendered */
+    if (CaretLine)
+    {
+        GuiPaintCaret(Buffer, GuiData,
+                      Buffer->CursorPosition.Y, Buffer->CursorPosition.Y,
+                      0, Width - 1);
+    }
 
+Quit:
     LeaveCriticalSection(&Console->Lock);
 }
 
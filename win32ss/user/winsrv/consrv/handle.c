@@ -364,6 +364,10 @@ ConSrvGetObject(IN PCONSOLE_PROCESS_DATA ProcessData,
     {
         _InterlockedIncrement(&ObjectEntry->Console->ReferenceCount);
 
+        /* Write the pending output of all the attached processes first, so that it stays in order */
+        if (LockConsole)
+            ConSrvDrainOutputRings((PCONSRV_CONSOLE)ObjectEntry->Console);
+
         /* Return the objects to the caller */
         *Object = ObjectEntry;
         if (Entry) *Entry = HandleEntry;